@@ -64,6 +64,7 @@ upper case with no trailing underscores.
 #define pplygn PPLYGN
 #define ptrist PTRIST
 #define pmesh  PMESH
+#define pdmesh PDMESH
 #define pbezp  PBEZP
 #define ptext  PTEXT
 #define plight PLIGHT
@@ -73,11 +74,23 @@ upper case with no trailing underscores.
 #define paxis  PAXIS
 #define pbndbx PBNDBX
 #define pisosf PISOSF
+#define pisotp PISOTP
+#define pgrdcc PGRDCC
+#define pdecim PDECIM
+#define pzadpt PZADPT
 #define pzsurf PZSURF
+#define pzsfmk PZSFMK
 #define prnzsf PRNZSF
 #define prniso PRNISO
+#define prntcr PRNTCR
+#define prntis PRNTIS
+#define prntds PRNTDS
 #define pirzsf PIRZSF
 #define piriso PIRISO
+#define pirisc PIRISC
+#define pirisb PIRISB
+#define pirzsc PIRZSC
+#define pirzsb PIRZSB
 #define ptbmol PTBMOL
 
 /* Camera */
@@ -88,6 +101,9 @@ upper case with no trailing underscores.
 /* Snap */
 #define psnap PSNAP
 
+/* Loading saved scenes */
+#define pldp3d PLDP3D
+
 /* Color map */
 #define pstcmp PSTCMP
 #define psdcmp PSDCMP
@@ -35,8 +35,8 @@
 #define __(prototype) prototype
 #endif
 
-/* Characters in a text font cache */
-#define MAX_FONT_CHARS 128
+/* Strings in a text geometry cache */
+#define TEXT_CACHE_SIZE 64
 
 typedef struct P_Assist_struct {
 
@@ -106,14 +106,15 @@ typedef struct assist_data_struct {
   P_Void_ptr cyldata;    /* hook for predefined cylinder */
 
   /* Text emulation facility */
-  struct font_cache_struct { 
-    int ready;           /* non-zero if this character is loaded */
-    int length;          /* number of strokes in the character */
+  struct string_cache_struct { 
+    char *string;        /* cached string, or null if the slot is empty */
+    int font_id;         /* font the strokes were built from */
+    int length;          /* number of strokes in the string */
     P_Void_ptr *data;    /* array of renderer data, one per stroke */
-  } font_cache[ MAX_FONT_CHARS ];  /* text font cache */
+    long last_used;      /* text clock value at last use */
+  } text_cache[ TEXT_CACHE_SIZE ];  /* text geometry cache */
+  long text_clock;
   int text_symbols_ready;
-  float oldu[3];
-  float oldv[3];
   P_Symbol text_height_symbol;
   P_Symbol text_font_symbol;
   float text_height;
@@ -132,10 +133,9 @@ typedef struct assist_data_struct {
 #define ATTRHASH( self ) (ASTDATA(self)->attrhash)
 #define SPHEREDATA( self ) (ASTDATA(self)->spheredata)
 #define CYLDATA( self ) (ASTDATA(self)->cyldata)
-#define FONT_CACHE( self ) (ASTDATA(self)->font_cache)
+#define TEXT_CACHE( self ) (ASTDATA(self)->text_cache)
+#define TEXT_CLOCK( self ) (ASTDATA(self)->text_clock)
 #define TEXT_SYMBOLS_READY( self ) (ASTDATA(self)->text_symbols_ready)
-#define OLDU( self ) (ASTDATA(self)->oldu)
-#define OLDV( self ) (ASTDATA(self)->oldv)
 #define TEXT_HEIGHT_SYMBOL(self) (ASTDATA(self)->text_height_symbol)
 #define TEXT_FONT_SYMBOL(self) (ASTDATA(self)->text_font_symbol)
 #define TEXT_HEIGHT(self) (ASTDATA(self)->text_height)
@@ -25,8 +25,11 @@ assistance module to maintain its attribute state.
 */
 
 /* Notes-
-   -We could avoid clearing the cache so often if transformations were
-    used to change the height and the u and v of text.  
+   -Strokes are cached a whole string at a time, laid out in a frame in
+    which the string runs along x with unit height.  The text height and
+    the u and v of the text are applied as a transformation, so the same
+    cached strings serve at every height and orientation.  The cache
+    holds TEXT_CACHE_SIZE strings and discards the least recently used.
 */
 
 #include <math.h>
@@ -84,108 +87,148 @@ static void check_coord_buf( int size )
   }
 }
 
-/* This routine releases all cached characters */
+/* This routine releases one cached string, along with its renderer data */
+static void release_entry( P_Assist *self, struct string_cache_struct *entry )
+{
+  int strokeloop;
+
+  ger_debug("assist_text: release_entry: releasing <%s>", entry->string);
+
+  METHOD_RDY(RENDERER(self));
+  for (strokeloop=0; strokeloop<entry->length; strokeloop++)
+    (*(RENDERER(self)->destroy_polyline))(entry->data[strokeloop]);
+  if (entry->data) free( (P_Void_ptr)(entry->data) );
+  free( (P_Void_ptr)(entry->string) );
+  entry->string= (char *)0;
+  entry->data= (P_Void_ptr *)0;
+  entry->length= 0;
+}
+
+/* This routine releases all cached strings */
 static void release_cache(P_Assist *self)
 {
-  int ichar;
+  int i;
   
-  ger_debug("assist_text: release_cache: resetting character cache");
+  ger_debug("assist_text: release_cache: resetting string cache");
   
-  for (ichar=0; ichar<MAX_FONT_CHARS; ichar++)
-    if (FONT_CACHE(self)[ichar].ready) {
-      free( (P_Void_ptr)(FONT_CACHE(self)[ichar].data) );
-      FONT_CACHE(self)[ichar].data= (P_Void_ptr *)0;
-      FONT_CACHE(self)[ichar].ready= 0;
-    };
+  for (i=0; i<TEXT_CACHE_SIZE; i++)
+    if (TEXT_CACHE(self)[i].string) release_entry( self, TEXT_CACHE(self)+i );
 }
 
-/* 
-This routine checks for the presence of a character in the cache, and
-if it is not present adds it.
+/*
+This routine adds the strokes of one character to a string's stroke
+array, returning the number added.  The strokes are laid out in the
+string's own frame, in which the string runs along x with a height of 1;
+xoffset is the position of the character's center along that line.
 */
-static void setup_char( P_Assist *self, char txtchar, 
-		       float ux, float uy, float uz, 
-		       float vx, float vy, float vz )
+static int setup_char( P_Assist *self, char txtchar, float xoffset,
+		      P_Void_ptr *data )
 {
   int vcount, vloop, nstrokes, nrealstrokes, strokeloop;
-  float x, y, z;
   float *coord;
-  P_Void_ptr *data;
   P_Vlist *vlist;
   
-  /* If the character is not cached, cache it */
-  if (!FONT_CACHE(self)[txtchar].ready) {
-    ger_debug("assist_text: setup_char: caching '%c'",txtchar);
+  nstrokes= this_char( self,txtchar ).stroke_count;
+  nrealstrokes= 0;
+  for (strokeloop=0; strokeloop<nstrokes; strokeloop++) {
     
-    nstrokes= this_char( self,txtchar ).stroke_count;
-    if ( !(data= (P_Void_ptr *)malloc(nstrokes*sizeof(P_Void_ptr *))) )
-      ger_fatal("assist_text: setup_char: unable to allocate %d bytes!",
-		nstrokes*sizeof(P_Void_ptr *));
-
-    FONT_CACHE(self)[txtchar].data= data;
-    nrealstrokes= 0;
-    for (strokeloop=0; strokeloop<nstrokes; strokeloop++) {
-
-      vcount= this_stroke( self, txtchar, strokeloop ).count;
-
-      if (vcount>1) { /* watch out for zero length strokes */
-	nrealstrokes++;
-	check_coord_buf(vcount); /* make sure there's space in the buffer */
-	coord= coord_buf;
-
-	for (vloop=0; vloop<vcount; vloop++ ) {
-	  *coord++= FONT_SCALE * TEXT_HEIGHT(self) * 
-	    (this_vertex_x( self, txtchar, strokeloop, vloop ) * ux +
-	     this_vertex_y( self, txtchar, strokeloop, vloop ) * vx );
-	  *coord++= FONT_SCALE * TEXT_HEIGHT(self) * 
-	    (this_vertex_x( self, txtchar, strokeloop, vloop ) * uy +
-	     this_vertex_y( self, txtchar, strokeloop, vloop ) * vy );
-	  *coord++= FONT_SCALE * TEXT_HEIGHT(self) * 
-	    (this_vertex_x( self, txtchar, strokeloop, vloop ) * uz +
-	     this_vertex_y( self, txtchar, strokeloop, vloop ) * vz );
-	};
-
-	vlist= po_create_cvlist(P3D_CVTX, vcount, coord_buf);
-	METHOD_RDY(RENDERER(self));
-	*data++= (*(RENDERER(self)->def_polyline))("",vlist);
-	METHOD_RDY(vlist);
-	(*(vlist->destroy_self))();
-      }
-    };
-    FONT_CACHE(self)[txtchar].length= nrealstrokes;
-    FONT_CACHE(self)[txtchar].ready= 1;
-  }
-  else ger_debug("assist_text: setup_char: '%c' ready",txtchar);
-  
+    vcount= this_stroke( self, txtchar, strokeloop ).count;
+    
+    if (vcount>1) { /* watch out for zero length strokes */
+      nrealstrokes++;
+      check_coord_buf(vcount); /* make sure there's space in the buffer */
+      coord= coord_buf;
+      
+      for (vloop=0; vloop<vcount; vloop++ ) {
+	*coord++= xoffset + FONT_SCALE * 
+	  this_vertex_x( self, txtchar, strokeloop, vloop );
+	*coord++= FONT_SCALE * this_vertex_y( self, txtchar, strokeloop, vloop );
+	*coord++= 0.0;
+      };
+      
+      vlist= po_create_cvlist(P3D_CVTX, vcount, coord_buf);
+      METHOD_RDY(RENDERER(self));
+      *data++= (*(RENDERER(self)->def_polyline))("",vlist);
+      METHOD_RDY(vlist);
+      (*(vlist->destroy_self))();
+    }
+  };
+
+  return( nrealstrokes );
 }
 
-/* This function actually emits the character */
-static void do_char( P_Assist *self, char txtchar, 
-		    float ux, float uy, float uz, 
-		    float vx, float vy, float vz, 
-		    P_Transform *trans, P_Attrib_List *attr )
+/* 
+This routine checks for the presence of a string in the cache, and
+if it is not present adds it, evicting the least recently used string
+if the cache is full.
+*/
+static struct string_cache_struct *setup_string( P_Assist *self, char *string )
 {
-  P_Void_ptr *data;
-  int strokeloop;
-  
-  ger_debug("assist_text: do_char: '%c'", txtchar);
-  
-  /* If the character is not in the font table, substitute for it */
-  if ( this_char(self,txtchar).first_stroke == -1 ) txtchar= '?';
-  if ( this_char(self,txtchar).first_stroke == -1 ) return;
+  struct string_cache_struct *entry, *oldest;
+  int i, nstrokes;
+  char *txtchar;
+  float x0;
+
+  TEXT_CLOCK(self)++;
+
+  oldest= TEXT_CACHE(self);
+  for (i=0; i<TEXT_CACHE_SIZE; i++) {
+    entry= TEXT_CACHE(self)+i;
+    if (entry->string && entry->font_id == TEXT_FONT_ID(self)
+	&& !strcmp(entry->string, string)) {
+      ger_debug("assist_text: setup_string: <%s> ready", string);
+      entry->last_used= TEXT_CLOCK(self);
+      return( entry );
+    }
+    if (oldest->string 
+	&& (!entry->string || entry->last_used < oldest->last_used))
+      oldest= entry;
+  }
+
+  ger_debug("assist_text: setup_string: caching <%s>", string);
+  entry= oldest;
+  if (entry->string) release_entry( self, entry );
+
+  /* Count strokes, substituting for characters not in the font */
+  nstrokes= 0;
+  for (txtchar= string; *txtchar; txtchar++) {
+    if ( this_char(self,*txtchar).first_stroke != -1 )
+      nstrokes += this_char(self,*txtchar).stroke_count;
+    else if ( this_char(self,'?').first_stroke != -1 )
+      nstrokes += this_char(self,'?').stroke_count;
+  }
   
-  /* Make sure the character is in the cache */
-  setup_char( self, txtchar, ux, uy, uz, vx, vy, vz );
+  if ( !(entry->string= (char *)malloc( strlen(string)+1 )) )
+    ger_fatal("assist_text: setup_string: unable to allocate %d bytes!",
+	      strlen(string)+1);
+  (void)strcpy(entry->string, string);
+  if (nstrokes) {
+    if ( !(entry->data= (P_Void_ptr *)malloc(nstrokes*sizeof(P_Void_ptr))) )
+      ger_fatal("assist_text: setup_string: unable to allocate %d bytes!",
+		nstrokes*sizeof(P_Void_ptr));
+  }
+  else entry->data= (P_Void_ptr *)0;
+  entry->font_id= TEXT_FONT_ID(self);
+  entry->last_used= TEXT_CLOCK(self);
+
+  /* Lay the characters out along the line */
+  entry->length= 0;
+  x0= 0.0;
+  for (txtchar= string; *txtchar; txtchar++) {
+    if ( this_char(self,*txtchar).first_stroke != -1 )
+      entry->length += setup_char( self, *txtchar,
+				  x0 + FONT_SCALE *
+				  (float)this_char(self,*txtchar).xcenter,
+				  entry->data + entry->length );
+    else if ( this_char(self,'?').first_stroke != -1 )
+      entry->length += setup_char( self, '?',
+				  x0 + FONT_SCALE *
+				  (float)this_char(self,*txtchar).xcenter,
+				  entry->data + entry->length );
+    x0 += FONT_SCALE * (float)this_char(self,*txtchar).xshift;
+  }
 
-  /* Walk the array of renderer data associated with the character,
-   * drawing each polyline.
-   */
-  data= FONT_CACHE(self)[txtchar].data;
-  for (strokeloop=0; strokeloop<FONT_CACHE(self)[txtchar].length; 
-       strokeloop++) {
-    METHOD_RDY(RENDERER(self));
-    (*(RENDERER(self)->ren_polyline))(*data++, trans, attr);
-  };
+  return( entry );
 }
 
 /* 
@@ -227,7 +270,6 @@ attribute list.
 */
 static void check_textattr( P_Assist *self )
 {
-  int clear_now= 0;
   float new_height;
   char *new_font;
   
@@ -242,20 +284,14 @@ static void check_textattr( P_Assist *self )
   METHOD_RDY(self);
   new_height= (*(self->float_attribute))( TEXT_HEIGHT_SYMBOL(self) );
   ger_debug("           Text height= %f", new_height);
-  if ( new_height != TEXT_HEIGHT(self) ) {
-    TEXT_HEIGHT(self)= new_height;
-    clear_now= 1;
-  };
+  TEXT_HEIGHT(self)= new_height;
   
   new_font= (*(self->string_attribute))( TEXT_FONT_SYMBOL(self) );
   ger_debug("           Text font= <%f>", new_font);
   if ( strncmp(new_font,TEXT_FONT(self),FONT_NM_LENGTH) ) {
     strncpy(TEXT_FONT(self),new_font,FONT_NM_LENGTH);
     TEXT_FONT_ID(self)= font_lookup(TEXT_FONT(self));
-    clear_now= 1;
   };
-  
-  if (clear_now) release_cache(self);
 }
 
 static void ren_text( P_Void_ptr rendata, P_Transform *trans, 
@@ -263,20 +299,22 @@ static void ren_text( P_Void_ptr rendata, P_Transform *trans,
 {
   P_Assist *self= (P_Assist *)po_this;
   P_Text_Gob *text= (P_Text_Gob *)rendata;
-  char *txtstring;
-  float x0, y0, z0, ux, uy, uz, vx, vy, vz, unorm, vnorm;
-  P_Transform *shifttrans,*nettrans;
+  struct string_cache_struct *entry;
+  float ux, uy, uz, vx, vy, vz, wx, wy, wz, unorm, vnorm, wnorm, scale;
+  P_Transform *texttrans;
+  float *d;
+  int strokeloop;
   METHOD_IN
   
   ger_debug("assist_text: ren_text: rendering <%s>",text->string);
   
   /* Handle text attributes, if they are present. */
   check_textattr(self);
+
+  /* Find or build the string's strokes */
+  entry= setup_string( self, text->string );
   
-  /* 
-    Extract u and v vector components, and reset cache if they've
-    changed.
-    */
+  /* Extract u and v vector components, and find the third axis */
   ux= text->u.x; uy= text->u.y; uz= text->u.z; 
   vx= text->v.x; vy= text->v.y; vz= text->v.z; 
   /* Checked at definition time to make sure they weren't null */
@@ -284,54 +322,32 @@ static void ren_text( P_Void_ptr rendata, P_Transform *trans,
   vnorm= sqrt( vx*vx + vy*vy + vz*vz );
   ux= ux/unorm; uy= uy/unorm; uz= uz/unorm;
   vx= vx/vnorm; vy= vy/vnorm; vz= vz/vnorm;
+  wx= uy*vz - uz*vy;
+  wy= uz*vx - ux*vz;
+  wz= ux*vy - uy*vx;
+  wnorm= sqrt( wx*wx + wy*wy + wz*wz );
+  if (wnorm != 0.0) {
+    wx= wx/wnorm; wy= wy/wnorm; wz= wz/wnorm;
+  }
+
+  /* The string's frame is scaled by the text height, turned to lie
+   * along u and v, and moved to the text location.
+   */
+  scale= TEXT_HEIGHT(self);
+  texttrans= translate_trans( text->loc.x, text->loc.y, text->loc.z );
+  d= texttrans->d;
+  d[0]= scale*ux; d[1]= scale*vx; d[2]= scale*wx;
+  d[4]= scale*uy; d[5]= scale*vy; d[6]= scale*wy;
+  d[8]= scale*uz; d[9]= scale*vz; d[10]= scale*wz;
+  if (trans) (void)premult_trans( trans, texttrans );
   
-  if ( (ux != OLDU(self)[0]) || (uy != OLDU(self)[1]) 
-      || (uz != OLDU(self)[2])
-      || (vx != OLDV(self)[0]) || (vy != OLDV(self)[1]) 
-      || (vz != OLDV(self)[2]) ) {
-    release_cache(self);
-    OLDU(self)[0]= ux;
-    OLDU(self)[1]= uy;
-    OLDU(self)[2]= uz;
-    OLDV(self)[0]= vx;
-    OLDV(self)[1]= vy;
-    OLDV(self)[2]= vz;
-  };
-  
-  /* Extract text coordinates */
-  x0= text->loc.x;
-  y0= text->loc.y;
-  z0= text->loc.z;
-  
-  txtstring= text->string;
-  for (; *txtstring; txtstring++) {
-    /* Translate to the starting point */
-    shifttrans= 
-      translate_trans(x0 + FONT_SCALE * TEXT_HEIGHT(self) * 
-		      (float)( ux*this_char(self,*txtstring).xcenter ),
-		      y0 + FONT_SCALE * TEXT_HEIGHT(self) * 
-		      (float)( uy*this_char(self,*txtstring).xcenter ),
-		      z0 + FONT_SCALE * TEXT_HEIGHT(self) * 
-		      (float)( uz*this_char(self,*txtstring).xcenter )
-		      );
-    if (trans) nettrans= premult_trans(shifttrans,trans);
-    else nettrans= shifttrans;
-    
-    /* Draw the character */
-    do_char( self, *txtstring, ux, uy, uz, vx, vy, vz, nettrans, attr );
+  /* Draw each stroke */
+  METHOD_RDY(RENDERER(self));
+  for (strokeloop=0; strokeloop<entry->length; strokeloop++)
+    (*(RENDERER(self)->ren_polyline))(entry->data[strokeloop], 
+				      texttrans, attr);
 
-    /* clean up */
-    destroy_trans( shifttrans );
-    if (trans) destroy_trans( nettrans );
-    
-    /* advance point to next character starting position */
-    x0 += FONT_SCALE * TEXT_HEIGHT(self) *
-      (float)(ux * this_char(self,*txtstring).xshift);
-    y0 += FONT_SCALE * TEXT_HEIGHT(self) *
-      (float)(uy * this_char(self,*txtstring).xshift);
-    z0 += FONT_SCALE * TEXT_HEIGHT(self) *
-      (float)(uz * this_char(self,*txtstring).xshift);
-  };
+  destroy_trans( texttrans );
   METHOD_OUT
 }
 
@@ -415,6 +431,7 @@ void ast_text_destroy( void )
   METHOD_IN
 
   ger_debug("assist_text: ast_text_destroy");
+  release_cache(self);
   if (coord_buf) {
     free( (P_Void_ptr)coord_buf );
     coord_buf= (float *)0;
@@ -427,7 +444,7 @@ void ast_text_destroy( void )
 void ast_text_init( P_Assist *self )
 /* This initializes the attribute part of an assist object */
 {
-  int ichar= 0;
+  int i;
 
   ger_debug("assist_text: ast_text_init");
 
@@ -444,15 +461,18 @@ compiled with P3D_NAMELENGTH less than FONT_NM_LENGTH!");
 
   /* Initialize object data */
   TEXT_SYMBOLS_READY(self)= 0;
-  OLDU(self)[0]= OLDU(self)[1]= OLDU(self)[2]= 0.0;
-  OLDV(self)[0]= OLDV(self)[1]= OLDV(self)[2]= 0.0;
   TEXT_HEIGHT(self)= DEFAULT_HEIGHT;
   TEXT_FONT_ID(self)= DEFAULT_FONT_ID;
   TEXT_FONT(self)[0]= '\0';
 
-  /* Mark the font cache empty */
-  for (ichar=0; ichar<MAX_FONT_CHARS; ichar++)
-    FONT_CACHE(self)[ichar].ready= 0;
+  /* Mark the string cache empty */
+  for (i=0; i<TEXT_CACHE_SIZE; i++) {
+    TEXT_CACHE(self)[i].string= (char *)0;
+    TEXT_CACHE(self)[i].data= (P_Void_ptr *)0;
+    TEXT_CACHE(self)[i].length= 0;
+    TEXT_CACHE(self)[i].last_used= 0;
+  }
+  TEXT_CLOCK(self)= 0;
 
   /* Fill out the methods */
   self->def_text= def_text;
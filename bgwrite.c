@@ -0,0 +1,443 @@
+/****************************************************************************
+ * bgwrite.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module lets the file-based renderers hand their output to a
+writer thread.  bgw_fopen returns an ordinary stdio stream, so the
+renderers can fprintf to it as before, but what is written is
+collected into large chunks which are queued for a single writer
+thread.  The queue holds at most BGW_MAX_CHUNKS chunks;  a caller
+which gets that far ahead of the disk waits for the writer.
+
+Closing the stream queues its last chunk and a close for the writer,
+and returns without waiting, so the file is finished while the caller
+goes on to its next frame.  bgw_flush waits until everything written
+to a stream so far is on disk, and bgw_drain waits until all queued
+output has been written, so it should be called before the program
+exits.  If the stream was opened with sync set, the writer also fsyncs
+the file at each flush and before it is closed.
+
+The first error the writer meets on a stream is kept with the stream.
+Once there is one, later writes to the stream fail, and bgw_flush and
+fclose return EOF with errno set to it, as they would for an ordinary
+stream.  An error which turns up only after the stream was closed is
+reported by the next bgw_fopen, bgw_flush or bgw_drain, which fail
+with errno set to it.
+
+This needs USE_PTHREADS and the stdio fopencookie extension of the
+GNU C library;  otherwise bgw_fopen is just fopen and the output is
+written synchronously.
+*/
+
+#ifdef USE_PTHREADS
+#define _GNU_SOURCE /* for fopencookie */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#if ( defined(USE_PTHREADS) && defined(__GLIBC__) )
+#define BGW_THREADED
+#include <pthread.h>
+#endif
+#include "p3dgen.h"
+#include "ge_error.h"
+#include "bgwrite.h"
+
+/* Size of the chunks handed to the writer, and the most which may be
+ * queued at once.
+ */
+#define BGW_CHUNK_BYTES (4*1024*1024)
+#define BGW_MAX_CHUNKS 8
+
+#ifdef BGW_THREADED
+typedef struct bgw_stream_struct {
+  FILE *fp;             /* the stream the caller writes to */
+  FILE *file;           /* the real file;  only the writer touches it */
+  char *path;
+  int sync;
+  int error;            /* errno of the first failure, or 0 */
+  int reported;         /* the error was returned to the caller */
+  char *chunk;          /* chunk being filled by the caller */
+  size_t fill;
+  struct bgw_stream_struct *next;
+} Bgw_Stream;
+
+typedef struct bgw_item_struct {
+  Bgw_Stream *stream;
+  char *data;           /* may be null for a flush or close */
+  size_t size;
+  int flush;            /* flush the file after writing */
+  int close;            /* flush and close the file after writing */
+  struct bgw_item_struct *next;
+} Bgw_Item;
+
+static pthread_mutex_t bgw_lock= PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bgw_queued= PTHREAD_COND_INITIALIZER;
+static pthread_cond_t bgw_done= PTHREAD_COND_INITIALIZER;
+static pthread_t bgw_thread;
+static int bgw_started= 0;
+static Bgw_Item *queue_head= NULL, *queue_tail= NULL;
+static int queued_chunks= 0;
+static long items_queued= 0, items_written= 0;
+static Bgw_Stream *open_streams= NULL;
+static int deferred_error= 0;   /* first error found after a close */
+static char *deferred_path= NULL;
+
+static int write_item( Bgw_Item *item, int error )
+/* This routine does the real I/O for one queued item, returning the
+ * errno of any failure.  Once a stream has failed its data is dropped,
+ * but it is still closed.
+ */
+{
+  Bgw_Stream *stream= item->stream;
+
+  if (!error) {
+    if (item->size
+	&& fwrite(item->data,1,item->size,stream->file) != item->size) {
+      error= errno ? errno : EIO;
+      ger_debug("bgwrite: error writing <%s>", stream->path);
+    }
+    else if (item->flush || item->close) {
+      if (fflush(stream->file)
+	  || (stream->sync && fsync(fileno(stream->file)))) {
+	error= errno ? errno : EIO;
+	ger_debug("bgwrite: error writing <%s>", stream->path);
+      }
+    }
+  }
+  if (item->close) {
+    if (fclose(stream->file) == EOF && !error) {
+      error= errno ? errno : EIO;
+      ger_debug("bgwrite: error closing <%s>", stream->path);
+    }
+  }
+  if (item->data) free( (P_Void_ptr)item->data );
+  return(error);
+}
+
+static void *bgw_writer( void *unused )
+/* This is the writer thread, which runs until the program exits */
+{
+  Bgw_Item *item;
+  int error;
+
+  pthread_mutex_lock(&bgw_lock);
+  while (1) {
+    while (!queue_head) pthread_cond_wait(&bgw_queued, &bgw_lock);
+    item= queue_head;
+    error= item->stream->error;
+    pthread_mutex_unlock(&bgw_lock);
+
+    errno= 0;
+    error= write_item(item, error);
+
+    pthread_mutex_lock(&bgw_lock);
+    item->stream->error= error;
+    if (item->close) {
+      /* The caller is done with the stream, so it is ours to free */
+      if (error && !item->stream->reported && !deferred_error) {
+	deferred_error= error;
+	deferred_path= item->stream->path;
+      }
+      else free( (P_Void_ptr)item->stream->path );
+      free( (P_Void_ptr)item->stream );
+    }
+    queue_head= item->next;
+    if (!queue_head) queue_tail= NULL;
+    if (item->data) queued_chunks--;
+    items_written++;
+    free( (P_Void_ptr)item );
+    pthread_cond_broadcast(&bgw_done);
+  }
+  return( (void *)0 );
+}
+
+static long enqueue( Bgw_Stream *stream, char *data, size_t size, 
+		     int flush, int close )
+/* This routine queues an item for the writer, waiting for room if too
+ * many chunks are queued already, and returns its serial number.
+ */
+{
+  Bgw_Item *item;
+  long serial;
+
+  if ( !(item= (Bgw_Item *)malloc(sizeof(Bgw_Item))) )
+    ger_fatal("bgwrite: enqueue: unable to allocate %d bytes!",
+	      sizeof(Bgw_Item));
+  item->stream= stream;
+  item->data= data;
+  item->size= size;
+  item->flush= flush;
+  item->close= close;
+  item->next= NULL;
+
+  pthread_mutex_lock(&bgw_lock);
+  if (data)
+    while (queued_chunks >= BGW_MAX_CHUNKS)
+      pthread_cond_wait(&bgw_done, &bgw_lock);
+  if (queue_tail) queue_tail->next= item;
+  else queue_head= item;
+  queue_tail= item;
+  if (data) queued_chunks++;
+  serial= ++items_queued;
+  pthread_cond_signal(&bgw_queued);
+  pthread_mutex_unlock(&bgw_lock);
+  return(serial);
+}
+
+static void wait_for( long serial )
+/* This routine waits until the writer has finished the given item */
+{
+  pthread_mutex_lock(&bgw_lock);
+  while (items_written < serial) pthread_cond_wait(&bgw_done, &bgw_lock);
+  pthread_mutex_unlock(&bgw_lock);
+}
+
+static int stream_error( Bgw_Stream *stream )
+/* This routine returns the stream's error, as the writer left it */
+{
+  int error;
+
+  pthread_mutex_lock(&bgw_lock);
+  error= stream->error;
+  pthread_mutex_unlock(&bgw_lock);
+  return(error);
+}
+
+static int report_deferred( VOIDLIST )
+/* This routine reports any error found after its stream was closed,
+ * returning its errno or 0.
+ */
+{
+  char *path;
+  int error;
+
+  pthread_mutex_lock(&bgw_lock);
+  error= deferred_error;
+  path= deferred_path;
+  deferred_error= 0;
+  deferred_path= NULL;
+  pthread_mutex_unlock(&bgw_lock);
+
+  if (error) {
+    ger_error("bgwrite: error writing <%s>: %s", path, strerror(error));
+    free( (P_Void_ptr)path );
+  }
+  return(error);
+}
+
+static char *new_chunk( VOIDLIST )
+{
+  char *chunk;
+
+  if ( !(chunk= (char *)malloc(BGW_CHUNK_BYTES)) )
+    ger_fatal("bgwrite: unable to allocate %d bytes!", BGW_CHUNK_BYTES);
+  return(chunk);
+}
+
+static ssize_t bgw_write( void *cookie, const char *buf, size_t size )
+/* This is the stdio write hook;  it fills chunks and queues them */
+{
+  Bgw_Stream *stream= (Bgw_Stream *)cookie;
+  size_t left= size, n;
+  int error;
+
+  if ((error= stream_error(stream))) {
+    errno= error;
+    return(-1);
+  }
+
+  while (left) {
+    n= BGW_CHUNK_BYTES - stream->fill;
+    if (n>left) n= left;
+    memcpy(stream->chunk + stream->fill, buf, n);
+    stream->fill += n;
+    buf += n;
+    left -= n;
+    if (stream->fill == BGW_CHUNK_BYTES) {
+      enqueue(stream, stream->chunk, stream->fill, 0, 0);
+      stream->chunk= new_chunk();
+      stream->fill= 0;
+    }
+  }
+  return( (ssize_t)size );
+}
+
+static int bgw_close( void *cookie )
+/* This is the stdio close hook.  The writer does the real close and
+ * frees the stream, so only an error already known is returned here.
+ */
+{
+  Bgw_Stream *stream= (Bgw_Stream *)cookie;
+  Bgw_Stream **runner;
+  int error;
+
+  pthread_mutex_lock(&bgw_lock);
+  for (runner= &open_streams; *runner; runner= &((*runner)->next))
+    if (*runner==stream) {
+      *runner= stream->next;
+      break;
+    }
+  error= stream->error;
+  if (error) stream->reported= 1;
+  pthread_mutex_unlock(&bgw_lock);
+
+  if (stream->fill) enqueue(stream, stream->chunk, stream->fill, 1, 1);
+  else {
+    free( (P_Void_ptr)stream->chunk );
+    enqueue(stream, NULL, 0, 1, 1);
+  }
+
+  if (error) {
+    errno= error;
+    return(EOF);
+  }
+  return(0);
+}
+
+static void drain_at_exit( VOIDLIST )
+{
+  (void)bgw_drain();
+}
+#endif
+
+FILE *bgw_fopen( char *path, char *mode, int sync )
+/* This routine opens a file for writing through the writer thread.
+ * The stream it returns is closed with fclose.  If sync is true, the
+ * file is fsynced when flushed and when closed.  It fails with errno
+ * set if a file closed earlier could not be written.
+ */
+{
+#ifdef BGW_THREADED
+  cookie_io_functions_t hooks;
+  Bgw_Stream *stream;
+  FILE *fp;
+  int error;
+
+  if ((error= report_deferred())) {
+    errno= error;
+    return( (FILE *)0 );
+  }
+
+  if ( !(stream= (Bgw_Stream *)malloc(sizeof(Bgw_Stream))) )
+    ger_fatal("bgw_fopen: unable to allocate %d bytes!", sizeof(Bgw_Stream));
+  if ( !(stream->file= fopen(path,mode)) ) {
+    free( (P_Void_ptr)stream );
+    return( (FILE *)0 );
+  }
+  if ( !(stream->path= strdup(path)) )
+    ger_fatal("bgw_fopen: unable to allocate %d bytes!", strlen(path)+1);
+  stream->sync= sync;
+  stream->error= 0;
+  stream->reported= 0;
+  stream->chunk= new_chunk();
+  stream->fill= 0;
+
+  hooks.read= NULL;
+  hooks.write= bgw_write;
+  hooks.seek= NULL;
+  hooks.close= bgw_close;
+  if ( !(fp= fopencookie(stream, "w", hooks)) )
+    ger_fatal("bgw_fopen: unable to create a stream for <%s>", path);
+
+  stream->fp= fp;
+
+  pthread_mutex_lock(&bgw_lock);
+  if (!bgw_started) {
+    if (pthread_create(&bgw_thread, NULL, bgw_writer, NULL))
+      ger_fatal("bgw_fopen: unable to start the writer thread");
+    pthread_detach(bgw_thread);
+    bgw_started= 1;
+    atexit(drain_at_exit);
+  }
+  stream->next= open_streams;
+  open_streams= stream;
+  pthread_mutex_unlock(&bgw_lock);
+
+  ger_debug("bgw_fopen: <%s> opened for background writing", path);
+  return(fp);
+#else
+  return( fopen(path,mode) );
+#endif
+}
+
+int bgw_flush( FILE *fp )
+/* This routine waits until everything written to fp is on disk.  Like
+ * fflush, it returns EOF with errno set if the stream has failed, or
+ * if a file closed earlier could not be written.
+ */
+{
+#ifdef BGW_THREADED
+  Bgw_Stream *stream;
+  long serial;
+  int result, error;
+
+  if ((error= report_deferred())) {
+    errno= error;
+    return(EOF);
+  }
+
+  result= fflush(fp);
+  pthread_mutex_lock(&bgw_lock);
+  for (stream= open_streams; stream; stream= stream->next)
+    if (stream->fp==fp) break;
+  pthread_mutex_unlock(&bgw_lock);
+  if (!stream) return(result); /* not a background stream, eg. stdout */
+
+  if (stream->fill) {
+    serial= enqueue(stream, stream->chunk, stream->fill, 1, 0);
+    stream->chunk= new_chunk();
+    stream->fill= 0;
+  }
+  else serial= enqueue(stream, NULL, 0, 1, 0);
+  wait_for(serial);
+
+  pthread_mutex_lock(&bgw_lock);
+  if ((error= stream->error)) stream->reported= 1;
+  pthread_mutex_unlock(&bgw_lock);
+  if (error) {
+    errno= error;
+    return(EOF);
+  }
+  return(result);
+#else
+  return( fflush(fp) );
+#endif
+}
+
+int bgw_drain( VOIDLIST )
+/* This routine waits until all queued output has been written.  It
+ * returns EOF with errno set if a closed file could not be written.
+ */
+{
+#ifdef BGW_THREADED
+  long serial;
+  int error;
+
+  pthread_mutex_lock(&bgw_lock);
+  serial= items_queued;
+  pthread_mutex_unlock(&bgw_lock);
+  wait_for(serial);
+
+  if ((error= report_deferred())) {
+    errno= error;
+    return(EOF);
+  }
+#endif
+  return(0);
+}
@@ -0,0 +1,30 @@
+/****************************************************************************
+ * bgwrite.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the background file writer
+bgwrite.c, which the file-based renderers use so that output is
+written to disk while the caller gets on with its next frame.
+*/
+
+#ifndef INCL_BGWRITE_H
+#define INCL_BGWRITE_H
+
+extern FILE *bgw_fopen( char *path, char *mode, int sync );
+extern int bgw_flush( FILE *fp );
+extern int bgw_drain( void );
+
+#endif /* INCL_BGWRITE_H */
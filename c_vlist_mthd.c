@@ -633,5 +633,39 @@ P_Vlist *po_create_cvlist( int type, int length, float *data )
   thislist->print= printfun;
   thislist->destroy_self= c_destroy;
 
+  /* Each vertex is a record of coordinates followed by its other data */
+  po_clear_vlist_view(thislist);
+  switch (type) {
+  case P3D_CVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 3);
+    break;
+  case P3D_CCVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 7);
+    po_set_vlist_view(thislist, P3D_VR, 4, data+3, 7);
+    break;
+  case P3D_CCNVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 10);
+    po_set_vlist_view(thislist, P3D_VR, 4, data+3, 10);
+    po_set_vlist_view(thislist, P3D_VNX, 3, data+7, 10);
+    break;
+  case P3D_CNVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 6);
+    po_set_vlist_view(thislist, P3D_VNX, 3, data+3, 6);
+    break;
+  case P3D_CVVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 4);
+    po_set_vlist_view(thislist, P3D_VV, 1, data+3, 4);
+    break;
+  case P3D_CVNVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 7);
+    po_set_vlist_view(thislist, P3D_VV, 1, data+3, 7);
+    po_set_vlist_view(thislist, P3D_VNX, 3, data+4, 7);
+    break;
+  case P3D_CVVVTX:
+    po_set_vlist_view(thislist, P3D_VX, 3, data, 5);
+    po_set_vlist_view(thislist, P3D_VV, 2, data+3, 5);
+    break;
+  }
+
   return( thislist );
 }
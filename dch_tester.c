@@ -1,5 +1,7 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include "p3dgen.h"
 #include "ge_error.h"
 #include "dirichlet.h"
@@ -7,6 +9,8 @@
 #define DIM 3
 #define NPTS 1000
 
+static int npts= NPTS;
+
 #ifdef never
 static float center[DIM]= { 0.5, 0.5 };
 static float range[DIM]= {1.0, 1.0};
@@ -31,7 +35,7 @@ static void random_fill_data( float *data, float *center, float *range )
 {
   int i, j, coord_offset= 0;
 
-  for (i=0; i<NPTS; i++)
+  for (i=0; i<npts; i++)
     for (j=0; j<DIM; j++) {
       *data++= *(center+coord_offset) 
 	+ (frandom()-0.5) * *(range+coord_offset);
@@ -47,8 +51,8 @@ static void ordered_fill_data( float *data, float *center, float *range )
 
   if (DIM!=2) ger_fatal("ordered_fill_data only works with dimension 2");
 
-  imax= sqrt(NPTS);
-  jmax= NPTS/imax;
+  imax= sqrt(npts);
+  jmax= npts/imax;
   fprintf(stderr,"ordered_fill_data: imax= %d, jmax= %d\n",imax,jmax);
   xstep= range[0]/imax;
   ystep= range[1]/jmax;
@@ -77,11 +81,11 @@ static void ordered_3d_fill_data( float *data, float *center, float *range )
 
   if (DIM!=3) ger_fatal("ordered_3d_fill_data only works with dimension 3");
 
-  for (i=0; ((i*i*i)<NPTS); i++);
+  for (i=0; ((i*i*i)<npts); i++);
 
   imax= i;
-  jmax= NPTS/(imax*imax);
-  kmax= NPTS/(imax*jmax);
+  jmax= npts/(imax*imax);
+  kmax= npts/(imax*jmax);
   fprintf(stderr,"ordered_3d_fill_data: imax= %d, jmax= %d, kmax= %d\n",
 	  imax,jmax,kmax);
   xstep= range[0]/imax;
@@ -172,18 +176,42 @@ static void print_statistics( dch_Tess *tess )
   
 }
 
-main()
+static void print_throughput( dch_Tess *tess, double seconds )
+{
+  int steps;
+
+  fprintf(stderr,"Inserted %d points in %f seconds (%f points per second)\n",
+	  npts, seconds, (seconds>0.0) ? npts/seconds : 0.0);
+  steps= tess->grid_steps + tess->center_steps + tess->most_recent_steps;
+  fprintf(stderr,"       %f location steps per point (%s)\n",
+	  ((float)steps)/((float)npts),
+	  (tess->best_search_method==GRID_CELL) ? "grid" : "walk");
+}
+
+main( int argc, char *argv[] )
 {
   dch_Tess *tess;
-  static float data[NPTS*DIM];
+  float *data;
+  clock_t start;
+
+  if (argc>1) npts= atoi(argv[1]);
+  if (npts<1) {
+    fprintf(stderr,"usage: %s [npts]\n",argv[0]);
+    exit(-1);
+  }
+  if ( !(data= (float *)malloc(npts*DIM*sizeof(float))) )
+    ger_fatal("dch_tester: unable to allocate %d floats!",npts*DIM);
 
   srandom(1);
   random_fill_data(data,center,range);
 
-  tess= dch_create_dirichlet_tesselation(data, NPTS, DIM, access_coords);
+  start= clock();
+  tess= dch_create_dirichlet_tess(data, npts, DIM, access_coords);
+  print_throughput( tess, (double)(clock()-start)/CLOCKS_PER_SEC );
 
   print_statistics( tess );
 
   dch_destroy_tesselation(tess);
+  free( (P_Void_ptr)data );
 
 }
@@ -0,0 +1,753 @@
+/****************************************************************************
+ * decimate.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module simplifies triangle meshes by repeated edge collapse, using
+the quadric error metric of Garland and Heckbert ("Surface Simplification
+Using Quadric Error Metrics", Siggraph '97, and "Simplifying Surfaces
+with Color and Texture using Quadric Error Metrics", IEEE Visualization
+'98).  Every vertex carries a quadric which measures the summed squared
+distance to the planes of the original triangles around it;  the edge
+whose collapse adds the least error is always taken next.
+
+Quadrics are accumulated in a space which includes the per-vertex
+color or value data as well as position, so that color mapped surfaces
+keep their coloring where it varies.  Attribute coordinates are scaled
+so that their full range counts the same as the diagonal of the
+bounding box.  Collapsed vertices are placed at the point of least
+error along the collapsed edge, and all their data, including normals,
+is interpolated to that point.  Boundary edges are held in place by
+heavily weighted planes perpendicular to the surface.
+
+pg_decimated_mesh() simplifies any vertex list and facet list.  Other
+routines which generate surfaces call dec_mesh() instead of pg_mesh(),
+so that they are simplified whenever pg_decimation() has turned
+decimation on.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "ge_error.h"
+#include "decimate.h"
+
+/* Largest number of coordinates of quadric space;  position plus
+ * up to four color components.
+ */
+#define MAX_DIM 7
+#define QUAD_SIZE ((MAX_DIM*(MAX_DIM+1))/2)
+
+/* Weight of the planes which hold surface boundaries in place */
+#define BOUNDARY_WEIGHT 100.0
+
+/* Squared lengths below this are treated as zero */
+#define TINY 1.0e-20
+
+typedef struct quadric_struct {
+  double a[QUAD_SIZE]; /* upper triangle of the symmetric matrix */
+  double b[MAX_DIM];
+  double c;
+} Quadric;
+
+/* Candidate edge collapses, kept in a heap ordered by cost.  Entries
+ * go stale when either vertex changes, which the stamps detect.
+ */
+typedef struct collapse_struct {
+  double cost;
+  double t;
+  int v1, v2;
+  int stamp1, stamp2;
+} Collapse;
+
+/* Decimation settings for generated surfaces */
+static double dec_fraction= 1.0;
+static double dec_max_error= 0.0;
+
+/* Working storage for the current decimation */
+static int vtx_type;
+static int dim;          /* number of coordinates in quadric space */
+static int cell;         /* floats per vertex, in c vlist layout */
+static int normal_offset; /* offset of normals in a vertex, or -1 */
+static int nverts= 0, ntris= 0, live_tris= 0;
+static float *vrec= (float *)0;
+static double scale[MAX_DIM];
+static Quadric *quad= (Quadric *)0;
+static int *vstamp= (int *)0;   /* negative for collapsed vertices */
+static int **vfaces= (int **)0; /* triangles around each vertex */
+static int *vnfaces= (int *)0, *vfcap= (int *)0;
+static int *tri= (int *)0;      /* first index negative if collapsed */
+static int *mark= (int *)0;
+static int mark_val= 0;
+static Collapse *heap= (Collapse *)0;
+static int heap_n= 0, heap_cap= 0;
+
+static int qindex( int i, int j )
+/* This routine returns the offset of element (i,j) of a quadric
+ * matrix, for i<=j.
+ */
+{
+  return( (i*(2*MAX_DIM - i + 1))/2 + (j - i) );
+}
+
+static int layout( int type )
+/* This routine sets the vertex layout globals for a vertex type,
+ * returning zero if the type is unknown.
+ */
+{
+  vtx_type= type;
+  switch (type) {
+  case P3D_CVTX: dim= 3; cell= 3; normal_offset= -1; break;
+  case P3D_CCVTX: dim= 7; cell= 7; normal_offset= -1; break;
+  case P3D_CCNVTX: dim= 7; cell= 10; normal_offset= 7; break;
+  case P3D_CNVTX: dim= 3; cell= 6; normal_offset= 3; break;
+  case P3D_CVVTX: dim= 4; cell= 4; normal_offset= -1; break;
+  case P3D_CVNVTX: dim= 4; cell= 7; normal_offset= 4; break;
+  case P3D_CVVVTX: dim= 5; cell= 5; normal_offset= -1; break;
+  default: return 0;
+  }
+  return 1;
+}
+
+static void load_vertices( P_Vlist *vlist )
+/* This routine copies the vertex data into c vlist layout */
+{
+  if ( !(vrec= (float *)malloc( nverts*cell*sizeof(float) )) )
+    ger_fatal("decimate: load_vertices: cannot allocate %d bytes!",
+	      nverts*cell*sizeof(float));
+
+  po_vlist_copy(vlist, P3D_VX, 3, vrec, cell);
+  switch (vtx_type) {
+  case P3D_CCVTX:
+  case P3D_CCNVTX:
+    po_vlist_copy(vlist, P3D_VR, 4, vrec+3, cell);
+    break;
+  case P3D_CVVTX:
+  case P3D_CVNVTX:
+    po_vlist_copy(vlist, P3D_VV, 1, vrec+3, cell);
+    break;
+  case P3D_CVVVTX:
+    po_vlist_copy(vlist, P3D_VV, 2, vrec+3, cell);
+    break;
+  }
+  if (normal_offset>=0)
+    po_vlist_copy(vlist, P3D_VNX, 3, vrec+normal_offset, cell);
+}
+
+static void set_scales( VOIDLIST )
+/* This routine picks the scale factors for attribute coordinates */
+{
+  float lo[MAX_DIM], hi[MAX_DIM];
+  double diag;
+  int i, l;
+
+  for (l=0; l<dim; l++) lo[l]= hi[l]= vrec[l];
+  for (i=1; i<nverts; i++)
+    for (l=0; l<dim; l++) {
+      if (vrec[i*cell+l]<lo[l]) lo[l]= vrec[i*cell+l];
+      if (vrec[i*cell+l]>hi[l]) hi[l]= vrec[i*cell+l];
+    }
+  diag= sqrt( (hi[0]-lo[0])*(hi[0]-lo[0]) + (hi[1]-lo[1])*(hi[1]-lo[1])
+	     + (hi[2]-lo[2])*(hi[2]-lo[2]) );
+  for (l=0; l<3; l++) scale[l]= 1.0;
+  for (l=3; l<dim; l++) {
+    if ( (hi[l]>lo[l]) && (diag>0.0) ) scale[l]= diag/(hi[l]-lo[l]);
+    else scale[l]= 1.0;
+  }
+}
+
+static void get_point( int v, double *pt )
+/* This routine returns the position of a vertex in quadric space */
+{
+  int l;
+  for (l=0; l<dim; l++) pt[l]= scale[l]*vrec[v*cell+l];
+}
+
+static void add_face_quadric( Quadric *q, double *p0, double *p1, double *p2 )
+/* This routine adds the quadric for the plane through three points
+ * of quadric space.
+ */
+{
+  double e1[MAX_DIM], e2[MAX_DIM];
+  double len, dot, pe1, pe2, pp;
+  int i, j;
+
+  len= 0.0;
+  for (i=0; i<dim; i++) {
+    e1[i]= p1[i]-p0[i];
+    len += e1[i]*e1[i];
+  }
+  if (len<TINY) return;
+  len= sqrt(len);
+  for (i=0; i<dim; i++) e1[i] /= len;
+
+  dot= 0.0;
+  for (i=0; i<dim; i++) dot += e1[i]*(p2[i]-p0[i]);
+  len= 0.0;
+  for (i=0; i<dim; i++) {
+    e2[i]= p2[i] - p0[i] - dot*e1[i];
+    len += e2[i]*e2[i];
+  }
+  if (len<TINY) return;
+  len= sqrt(len);
+  for (i=0; i<dim; i++) e2[i] /= len;
+
+  pe1= pe2= pp= 0.0;
+  for (i=0; i<dim; i++) {
+    pe1 += p0[i]*e1[i];
+    pe2 += p0[i]*e2[i];
+    pp += p0[i]*p0[i];
+  }
+
+  for (i=0; i<dim; i++) {
+    for (j=i; j<dim; j++)
+      q->a[qindex(i,j)] += ((i==j) ? 1.0 : 0.0) - e1[i]*e1[j] - e2[i]*e2[j];
+    q->b[i] += pe1*e1[i] + pe2*e2[i] - p0[i];
+  }
+  q->c += pp - pe1*pe1 - pe2*pe2;
+}
+
+static void add_plane_quadric( Quadric *q, double *n, double d, double w )
+/* This routine adds the weighted quadric of the spatial plane n.x+d=0 */
+{
+  int i, j;
+
+  for (i=0; i<3; i++) {
+    for (j=i; j<3; j++) q->a[qindex(i,j)] += w*n[i]*n[j];
+    q->b[i] += w*d*n[i];
+  }
+  q->c += w*d*d;
+}
+
+static double eval_quadric( Quadric *q, double *pt )
+/* This routine evaluates a quadric at a point */
+{
+  double result= q->c;
+  int i, j;
+
+  for (i=0; i<dim; i++) {
+    result += q->a[qindex(i,i)]*pt[i]*pt[i] + 2.0*q->b[i]*pt[i];
+    for (j=i+1; j<dim; j++) result += 2.0*q->a[qindex(i,j)]*pt[i]*pt[j];
+  }
+  return result;
+}
+
+static void apply_quadric( Quadric *q, double *pt, double *result )
+/* This routine multiplies a point by the quadric matrix */
+{
+  int i, j;
+
+  for (i=0; i<dim; i++) {
+    result[i]= 0.0;
+    for (j=0; j<dim; j++)
+      result[i] += q->a[ (i<=j) ? qindex(i,j) : qindex(j,i) ]*pt[j];
+  }
+}
+
+static void add_vertex_face( int v, int f )
+/* This routine adds a triangle to the list around a vertex */
+{
+  if (vnfaces[v]==vfcap[v]) {
+    vfcap[v]= (vfcap[v]) ? 2*vfcap[v] : 8;
+    if ( !(vfaces[v]= (int *)realloc( (P_Void_ptr)vfaces[v],
+				     vfcap[v]*sizeof(int) )) )
+      ger_fatal("decimate: add_vertex_face: cannot allocate %d bytes!",
+		vfcap[v]*sizeof(int));
+  }
+  vfaces[v][vnfaces[v]++]= f;
+}
+
+static int has_vertex( int f, int v )
+/* This routine checks whether a triangle uses a vertex */
+{
+  return( (tri[3*f]==v) || (tri[3*f+1]==v) || (tri[3*f+2]==v) );
+}
+
+static int edge_face_count( int v1, int v2 )
+/* This routine counts the live triangles sharing an edge */
+{
+  int i, f, count= 0;
+
+  for (i=0; i<vnfaces[v1]; i++) {
+    f= vfaces[v1][i];
+    if ( (tri[3*f]>=0) && has_vertex(f,v2) ) count++;
+  }
+  return count;
+}
+
+static void face_normal( float *a, float *b, float *c, double *n )
+/* This routine calculates the unnormalized normal of a triangle */
+{
+  double u[3], v[3];
+  int l;
+
+  for (l=0; l<3; l++) {
+    u[l]= b[l]-a[l];
+    v[l]= c[l]-a[l];
+  }
+  n[0]= u[1]*v[2] - u[2]*v[1];
+  n[1]= u[2]*v[0] - u[0]*v[2];
+  n[2]= u[0]*v[1] - u[1]*v[0];
+}
+
+static void init_quadrics( VOIDLIST )
+/* This routine builds the starting quadric of every vertex */
+{
+  double p[3][MAX_DIM], n[3], m[3], len, d;
+  int f, l, e, v1, v2;
+
+  if ( !(quad= (Quadric *)calloc( nverts, sizeof(Quadric) )) )
+    ger_fatal("decimate: init_quadrics: cannot allocate %d bytes!",
+	      nverts*sizeof(Quadric));
+
+  for (f=0; f<ntris; f++) {
+    for (l=0; l<3; l++) get_point( tri[3*f+l], p[l] );
+    for (l=0; l<3; l++) add_face_quadric( quad+tri[3*f+l], p[0], p[1], p[2] );
+
+    /* Boundary edges get a plane perpendicular to the triangle */
+    face_normal( vrec+cell*tri[3*f], vrec+cell*tri[3*f+1],
+		vrec+cell*tri[3*f+2], n );
+    for (e=0; e<3; e++) {
+      v1= tri[3*f+e];
+      v2= tri[3*f+(e+1)%3];
+      if (edge_face_count(v1,v2) != 1) continue;
+      m[0]= (p[(e+1)%3][1]-p[e][1])*n[2] - (p[(e+1)%3][2]-p[e][2])*n[1];
+      m[1]= (p[(e+1)%3][2]-p[e][2])*n[0] - (p[(e+1)%3][0]-p[e][0])*n[2];
+      m[2]= (p[(e+1)%3][0]-p[e][0])*n[1] - (p[(e+1)%3][1]-p[e][1])*n[0];
+      len= sqrt( m[0]*m[0] + m[1]*m[1] + m[2]*m[2] );
+      if (len*len<TINY) continue;
+      for (l=0; l<3; l++) m[l] /= len;
+      d= -(m[0]*p[e][0] + m[1]*p[e][1] + m[2]*p[e][2]);
+      add_plane_quadric( quad+v1, m, d, BOUNDARY_WEIGHT );
+      add_plane_quadric( quad+v2, m, d, BOUNDARY_WEIGHT );
+    }
+  }
+}
+
+static void heap_push( Collapse *entry )
+/* This routine adds a candidate collapse to the heap */
+{
+  int i, parent;
+
+  if (heap_n==heap_cap) {
+    heap_cap= (heap_cap) ? 2*heap_cap : 1024;
+    if ( !(heap= (Collapse *)realloc( (P_Void_ptr)heap,
+				     heap_cap*sizeof(Collapse) )) )
+      ger_fatal("decimate: heap_push: cannot allocate %d bytes!",
+		heap_cap*sizeof(Collapse));
+  }
+  i= heap_n++;
+  while (i>0) {
+    parent= (i-1)/2;
+    if (heap[parent].cost <= entry->cost) break;
+    heap[i]= heap[parent];
+    i= parent;
+  }
+  heap[i]= *entry;
+}
+
+static void heap_pop( Collapse *entry )
+/* This routine removes the cheapest collapse from the heap */
+{
+  Collapse last;
+  int i, child;
+
+  *entry= heap[0];
+  last= heap[--heap_n];
+  i= 0;
+  while ((child= 2*i+1) < heap_n) {
+    if ( (child+1<heap_n) && (heap[child+1].cost<heap[child].cost) ) child++;
+    if (last.cost <= heap[child].cost) break;
+    heap[i]= heap[child];
+    i= child;
+  }
+  heap[i]= last;
+}
+
+static void push_collapse( int v1, int v2 )
+/* This routine finds the best place along an edge to collapse it to,
+ * and adds the collapse to the heap.
+ */
+{
+  Quadric q;
+  Collapse entry;
+  double x1[MAX_DIM], x2[MAX_DIM], d[MAX_DIM], ad[MAX_DIM], ax[MAX_DIM];
+  double dad, g, t;
+  int l;
+
+  for (l=0; l<QUAD_SIZE; l++) q.a[l]= quad[v1].a[l] + quad[v2].a[l];
+  for (l=0; l<MAX_DIM; l++) q.b[l]= quad[v1].b[l] + quad[v2].b[l];
+  q.c= quad[v1].c + quad[v2].c;
+
+  get_point( v1, x1 );
+  get_point( v2, x2 );
+  for (l=0; l<dim; l++) d[l]= x2[l]-x1[l];
+  apply_quadric( &q, d, ad );
+  apply_quadric( &q, x1, ax );
+  dad= g= 0.0;
+  for (l=0; l<dim; l++) {
+    dad += d[l]*ad[l];
+    g += d[l]*(ax[l] + q.b[l]);
+  }
+
+  /* The error along the edge is quadratic in t;  find its minimum */
+  if (dad>TINY) t= -g/dad;
+  else t= (g<0.0) ? 1.0 : 0.0;
+  if (t<0.0) t= 0.0;
+  if (t>1.0) t= 1.0;
+
+  entry.cost= eval_quadric( &q, x1 ) + 2.0*t*g + t*t*dad;
+  if (entry.cost<0.0) entry.cost= 0.0;
+  entry.t= t;
+  entry.v1= v1;
+  entry.v2= v2;
+  entry.stamp1= vstamp[v1];
+  entry.stamp2= vstamp[v2];
+  heap_push( &entry );
+}
+
+static int collapse_ok( int v1, int v2, float *newpos )
+/* This routine checks that collapsing an edge leaves the mesh
+ * manifold and flips no triangles.
+ */
+{
+  int i, l, f, w, shared= 0, common= 0;
+  int ends[2];
+  double n0[3], n1[3];
+  float *pos[3];
+
+  /* The link condition: the vertices adjacent to both ends must be
+   * exactly those of the triangles on the edge.
+   */
+  mark_val += 2;
+  for (i=0; i<vnfaces[v1]; i++) {
+    f= vfaces[v1][i];
+    if (tri[3*f]<0) continue;
+    for (l=0; l<3; l++) mark[tri[3*f+l]]= mark_val;
+  }
+  for (i=0; i<vnfaces[v2]; i++) {
+    f= vfaces[v2][i];
+    if (tri[3*f]<0) continue;
+    if (has_vertex(f,v1)) shared++;
+    for (l=0; l<3; l++) {
+      w= tri[3*f+l];
+      if ( (w!=v1) && (w!=v2) && (mark[w]==mark_val) ) {
+	common++;
+	mark[w]= mark_val+1;
+      }
+    }
+  }
+  if ( (shared==0) || (common!=shared) ) return 0;
+
+  /* No surviving triangle may turn over */
+  ends[0]= v1;
+  ends[1]= v2;
+  for (l=0; l<2; l++)
+    for (i=0; i<vnfaces[ends[l]]; i++) {
+      f= vfaces[ends[l]][i];
+      if ( (tri[3*f]<0) || (has_vertex(f,v1) && has_vertex(f,v2)) ) continue;
+      for (w=0; w<3; w++) pos[w]= vrec + cell*tri[3*f+w];
+      face_normal( pos[0], pos[1], pos[2], n0 );
+      for (w=0; w<3; w++) if (tri[3*f+w]==ends[l]) pos[w]= newpos;
+      face_normal( pos[0], pos[1], pos[2], n1 );
+      if ( n0[0]*n1[0] + n0[1]*n1[1] + n0[2]*n1[2] <= 0.0 ) return 0;
+    }
+
+  return 1;
+}
+
+static void do_collapse( Collapse *entry, float *newrec )
+/* This routine merges the second vertex of an edge into the first */
+{
+  int v1= entry->v1, v2= entry->v2;
+  int i, l, f, count;
+
+  for (l=0; l<cell; l++) vrec[cell*v1+l]= newrec[l];
+  for (l=0; l<QUAD_SIZE; l++) quad[v1].a[l] += quad[v2].a[l];
+  for (l=0; l<MAX_DIM; l++) quad[v1].b[l] += quad[v2].b[l];
+  quad[v1].c += quad[v2].c;
+
+  for (i=0; i<vnfaces[v2]; i++) {
+    f= vfaces[v2][i];
+    if (tri[3*f]<0) continue;
+    if (has_vertex(f,v1)) {
+      tri[3*f]= -1;
+      live_tris--;
+    }
+    else {
+      for (l=0; l<3; l++) if (tri[3*f+l]==v2) tri[3*f+l]= v1;
+      add_vertex_face( v1, f );
+    }
+  }
+  vstamp[v2]= -1;
+  vstamp[v1]++;
+  free( (P_Void_ptr)vfaces[v2] );
+  vfaces[v2]= (int *)0;
+  vnfaces[v2]= vfcap[v2]= 0;
+
+  /* Drop dead triangles from the survivor's list */
+  count= 0;
+  for (i=0; i<vnfaces[v1]; i++)
+    if (tri[3*vfaces[v1][i]]>=0) vfaces[v1][count++]= vfaces[v1][i];
+  vnfaces[v1]= count;
+
+  /* Every edge of the survivor has a new cost */
+  mark_val += 2;
+  mark[v1]= mark_val;
+  for (i=0; i<vnfaces[v1]; i++) {
+    f= vfaces[v1][i];
+    for (l=0; l<3; l++)
+      if (mark[tri[3*f+l]] != mark_val) {
+	mark[tri[3*f+l]]= mark_val;
+	push_collapse( v1, tri[3*f+l] );
+      }
+  }
+}
+
+static void simplify( int target, double max_error )
+/* This routine collapses edges until the target triangle count or
+ * the error bound is reached.
+ */
+{
+  Collapse entry;
+  float newrec[MAX_DIM+3], *r1, *r2;
+  double max_cost= max_error*max_error;
+  double len;
+  int f, l, v1, v2;
+
+  if ( !(mark= (int *)calloc( nverts, sizeof(int) )) )
+    ger_fatal("decimate: simplify: cannot allocate %d bytes!",
+	      nverts*sizeof(int));
+  mark_val= 0;
+
+  /* Queue every edge once */
+  for (f=0; f<ntris; f++)
+    for (l=0; l<3; l++) {
+      v1= tri[3*f+l];
+      v2= tri[3*f+(l+1)%3];
+      if ( (v1<v2) || (edge_face_count(v1,v2)==1) ) push_collapse( v1, v2 );
+    }
+
+  while (heap_n>0) {
+    if ( (target>0) && (live_tris<=target) ) break;
+    heap_pop( &entry );
+    if ( (vstamp[entry.v1] != entry.stamp1)
+	|| (vstamp[entry.v2] != entry.stamp2) ) continue;
+    if ( (max_error>0.0) && (entry.cost>max_cost) ) break;
+
+    r1= vrec + cell*entry.v1;
+    r2= vrec + cell*entry.v2;
+    for (l=0; l<cell; l++) newrec[l]= (1.0-entry.t)*r1[l] + entry.t*r2[l];
+    if (normal_offset>=0) {
+      len= 0.0;
+      for (l=normal_offset; l<normal_offset+3; l++) len += newrec[l]*newrec[l];
+      if (len>TINY) {
+	len= sqrt(len);
+	for (l=normal_offset; l<normal_offset+3; l++) newrec[l] /= len;
+      }
+      else {
+	for (l=normal_offset; l<normal_offset+3; l++)
+	  newrec[l]= (entry.t<0.5) ? r1[l] : r2[l];
+      }
+    }
+
+    if (collapse_ok( entry.v1, entry.v2, newrec )) do_collapse( &entry, newrec );
+  }
+
+  ger_debug("decimate: simplify: %d triangles reduced to %d",
+	    ntris, live_tris);
+}
+
+static int emit_mesh( VOIDLIST )
+/* This routine adds the simplified mesh to the currently open gob */
+{
+  int *remap, *indices, *lengths;
+  float *vdata;
+  int i, l, f, count, nout;
+  int retcode;
+  P_Vlist *vlist;
+
+  if ( !(remap= (int *)malloc( nverts*sizeof(int) ))
+      || !(vdata= (float *)malloc( nverts*cell*sizeof(float) ))
+      || !(indices= (int *)malloc( 3*live_tris*sizeof(int) ))
+      || !(lengths= (int *)malloc( live_tris*sizeof(int) )) )
+    ger_fatal("decimate: emit_mesh: cannot allocate %d bytes!",
+	      nverts*(sizeof(int)+cell*sizeof(float))
+	      + 4*live_tris*sizeof(int));
+
+  count= 0;
+  for (i=0; i<nverts; i++) {
+    if (vstamp[i]<0) continue;
+    remap[i]= count;
+    for (l=0; l<cell; l++) vdata[cell*count+l]= vrec[cell*i+l];
+    count++;
+  }
+  nout= 0;
+  for (f=0; f<ntris; f++) {
+    if (tri[3*f]<0) continue;
+    for (l=0; l<3; l++) indices[3*nout+l]= remap[tri[3*f+l]];
+    lengths[nout++]= 3;
+  }
+
+  vlist= po_create_cvlist( vtx_type, count, vdata );
+  retcode= pg_mesh( vlist, indices, lengths, nout );
+
+  free( (P_Void_ptr)remap );
+  free( (P_Void_ptr)vdata );
+  free( (P_Void_ptr)indices );
+  free( (P_Void_ptr)lengths );
+  return retcode;
+}
+
+static void cleanup( VOIDLIST )
+/* This routine frees the working storage */
+{
+  if (vrec) free( (P_Void_ptr)vrec );
+  if (quad) free( (P_Void_ptr)quad );
+  if (vstamp) free( (P_Void_ptr)vstamp );
+  if (vfaces) {
+    int i;
+    for (i=0; i<nverts; i++) if (vfaces[i]) free( (P_Void_ptr)vfaces[i] );
+    free( (P_Void_ptr)vfaces );
+  }
+  if (vnfaces) free( (P_Void_ptr)vnfaces );
+  if (vfcap) free( (P_Void_ptr)vfcap );
+  if (tri) free( (P_Void_ptr)tri );
+  if (mark) free( (P_Void_ptr)mark );
+  if (heap) free( (P_Void_ptr)heap );
+  vrec= (float *)0;
+  quad= (Quadric *)0;
+  vstamp= vnfaces= vfcap= tri= mark= (int *)0;
+  vfaces= (int **)0;
+  heap= (Collapse *)0;
+  heap_n= heap_cap= 0;
+}
+
+int pg_decimated_mesh( P_Vlist *vlist, int *vertices, int *facet_lengths,
+		       int nfacets, int target, double max_error )
+/* This routine simplifies a mesh until it has no more than target
+ * triangles, or until any further simplification would move the
+ * surface by more than about max_error.  Either limit may be turned
+ * off by passing zero.  The result is added to the currently open gob.
+ * Like pg_mesh, this routine takes over the vertex list.
+ */
+{
+  int f, l, count, *runner;
+
+  ger_debug("pg_decimated_mesh: %d facets, target %d, max error %f",
+	    nfacets, target, max_error);
+
+  count= 0;
+  for (f=0; f<nfacets; f++)
+    if (facet_lengths[f]>2) count += facet_lengths[f]-2;
+
+  if ( ((target<=0) || (target>=count)) && (max_error<=0.0) )
+    return( pg_mesh( vlist, vertices, facet_lengths, nfacets ) );
+
+  if (!layout(vlist->type)) {
+    ger_error("pg_decimated_mesh: unknown vertex type %d; call ignored.",
+	      vlist->type);
+    return( P3D_FAILURE );
+  }
+
+  nverts= vlist->length;
+  ntris= live_tris= count;
+  if ( !(tri= (int *)malloc( 3*ntris*sizeof(int) ))
+      || !(vstamp= (int *)calloc( nverts, sizeof(int) ))
+      || !(vnfaces= (int *)calloc( nverts, sizeof(int) ))
+      || !(vfcap= (int *)calloc( nverts, sizeof(int) ))
+      || !(vfaces= (int **)calloc( nverts, sizeof(int *) )) )
+    ger_fatal("pg_decimated_mesh: cannot allocate %d bytes!",
+	      3*ntris*sizeof(int) + nverts*(3*sizeof(int)+sizeof(int *)));
+
+  /* Facets with more than three vertices are split into fans */
+  runner= tri;
+  for (f=0; f<nfacets; f++) {
+    for (l=2; l<facet_lengths[f]; l++) {
+      *runner++= vertices[0];
+      *runner++= vertices[l-1];
+      *runner++= vertices[l];
+    }
+    vertices += facet_lengths[f];
+  }
+  for (f=0; f<ntris; f++)
+    for (l=0; l<3; l++) add_vertex_face( tri[3*f+l], f );
+
+  /* The new mesh will own a new vlist, so the old one goes now */
+  load_vertices( vlist );
+  METHOD_RDY(vlist);
+  (*(vlist->destroy_self))();
+
+  set_scales();
+  init_quadrics();
+  simplify( target, max_error );
+  count= emit_mesh();
+  cleanup();
+
+  return( count );
+}
+
+int pg_decimation( double fraction, double max_error )
+/* This routine sets the simplification applied to generated surfaces.
+ * Each surface is reduced to the given fraction of its triangles, or
+ * until further simplification would exceed the given error.  A
+ * fraction of 1.0 and error of 0.0 turn decimation off.
+ */
+{
+  ger_debug("pg_decimation: fraction %f, max error %f", fraction, max_error);
+
+  if ( (fraction<=0.0) || (fraction>1.0) ) {
+    ger_error("pg_decimation: fraction must be in (0.0, 1.0]; call ignored.");
+    return( P3D_FAILURE );
+  }
+  if (max_error<0.0) {
+    ger_error("pg_decimation: error bound is negative; call ignored.");
+    return( P3D_FAILURE );
+  }
+
+  dec_fraction= fraction;
+  dec_max_error= max_error;
+  return( P3D_SUCCESS );
+}
+
+int dec_enabled( VOIDLIST )
+/* This routine returns true if generated surfaces are to be simplified */
+{
+  return( (dec_fraction<1.0) || (dec_max_error>0.0) );
+}
+
+int dec_mesh( P_Vlist *vlist, int *vertices, int *facet_lengths, int nfacets )
+/* This routine is used in place of pg_mesh by the routines which
+ * generate surfaces, applying the current decimation settings.
+ */
+{
+  int f, count, target;
+
+  if (!dec_enabled())
+    return( pg_mesh( vlist, vertices, facet_lengths, nfacets ) );
+
+  target= 0;
+  if (dec_fraction<1.0) {
+    count= 0;
+    for (f=0; f<nfacets; f++)
+      if (facet_lengths[f]>2) count += facet_lengths[f]-2;
+    target= (int)(dec_fraction*count + 0.5);
+    if (target<1) target= 1;
+  }
+  return( pg_decimated_mesh( vlist, vertices, facet_lengths, nfacets,
+			     target, dec_max_error ) );
+}
@@ -0,0 +1,29 @@
+/****************************************************************************
+ * decimate.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the mesh decimation package
+decimate.c, which is used by the routines which generate surfaces.
+*/
+
+#ifndef INCL_DECIMATE_H
+#define INCL_DECIMATE_H
+
+extern int dec_enabled( void );
+extern int dec_mesh( P_Vlist *vlist, int *vertices, int *facet_lengths,
+		     int nfacets );
+
+#endif /* INCL_DECIMATE_H */
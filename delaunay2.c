@@ -0,0 +1,776 @@
+/****************************************************************************
+ * delaunay2.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module computes the Delaunay triangulation of a set of points in
+the plane.  It does the same job as dirichlet.c in two dimensions, but
+keeps only the triangles, which makes it much faster and smaller.
+
+Triangles are stored as half-edges, three per triangle, in two arrays.
+Half-edge e belongs to triangle e/3; vtx[e] is the vertex it starts
+from and twin[e] is the matching half-edge of the neighboring
+triangle.  All triangles are counterclockwise.  The outside of the
+convex hull is covered by 'ghost' triangles joining each hull edge to
+a vertex at infinity, so every half-edge has a twin and points outside
+the hull need no special treatment.
+
+Points are inserted in Biased Randomized Insertion Order (random
+rounds of doubling size, Hilbert sorted within each round), located
+by walking from the last triangle created, and added by splitting the
+triangle or edge they fall in and then flipping edges until the
+triangulation is Delaunay again.  The expected cost is O(n log n),
+mostly in the sort.
+
+The orientation and incircle tests are those of J. R. Shewchuk,
+"Adaptive Precision Floating-Point Arithmetic and Fast Robust
+Geometric Predicates", Discrete & Computational Geometry 18:305-363,
+1997.  Each test is first done in ordinary double precision with an
+error bound, and is redone exactly only when the bound shows the sign
+may be wrong.  This matters for gridded data, where many sets of four
+points are cocircular.  The exact arithmetic assumes IEEE double
+arithmetic without extended precision registers or fused multiply-add
+contraction.  gcc contracts a*b+c into a fused multiply-add by default
+on targets which have one, which would break the error bounds, so
+this file is compiled with EXACT_FP_CFLAGS (-ffp-contract=off, set in
+conf/Makefile.$ARCH).
+
+Duplicate points are dropped.  If all the points are collinear there
+are no triangles.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "p3dgen.h"
+#include "ge_error.h"
+#include "delaunay2.h"
+
+/* Marks the vertex at infinity */
+#define INFINITE_VTX -1
+
+/* Bits per coordinate for the Hilbert sort */
+#define HILBERT_BITS 16
+
+/* Longest expansion produced by multiplying two intermediate terms */
+#define EXPANSION_MAX 512
+
+/* 2^27 + 1, used to split doubles into halves for exact products */
+#define SPLITTER 134217729.0
+
+/* Relative error bounds for the filtered predicates;  see Shewchuk */
+#define EPSILON 1.1102230246251565e-16 /* 2^-53 */
+#define CCW_ERRBOUND ((3.0 + 16.0*EPSILON)*EPSILON)
+#define ICC_ERRBOUND ((10.0 + 96.0*EPSILON)*EPSILON)
+
+#define NEXT(e) (((e)%3==2) ? (e)-2 : (e)+1)
+#define PREV(e) (((e)%3==0) ? (e)+2 : (e)-1)
+
+typedef struct dl2_order_struct {
+  int round;
+  unsigned int key;
+  int index;
+} dl2_Order;
+
+static double *pts= (double *)0;
+static int *vtx= (int *)0;
+static int *twin= (int *)0;
+static int ntris= 0;
+static int last_tri= 0;
+static int *stack= (int *)0;
+static int stack_size= 0;
+static unsigned long walk_seed= 1;
+
+/*
+ * Exact arithmetic.  An expansion is an array of doubles, in order of
+ * increasing magnitude, whose exact sum is the value represented.
+ */
+
+static void two_sum( double a, double b, double *x, double *y )
+{
+  double bvirt, avirt, bround, around;
+
+  *x= a + b;
+  bvirt= *x - a;
+  avirt= *x - bvirt;
+  bround= b - bvirt;
+  around= a - avirt;
+  *y= around + bround;
+}
+
+static void two_diff( double a, double b, double *x, double *y )
+{
+  double bvirt, avirt, bround, around;
+
+  *x= a - b;
+  bvirt= a - *x;
+  avirt= *x + bvirt;
+  bround= bvirt - b;
+  around= a - avirt;
+  *y= around + bround;
+}
+
+static void fast_two_sum( double a, double b, double *x, double *y )
+/* Requires |a| >= |b| */
+{
+  *x= a + b;
+  *y= b - (*x - a);
+}
+
+static void split( double a, double *hi, double *lo )
+{
+  double c, abig;
+
+  c= SPLITTER * a;
+  abig= c - a;
+  *hi= c - abig;
+  *lo= a - *hi;
+}
+
+static void two_product( double a, double b, double *x, double *y )
+{
+  double ahi, alo, bhi, blo, err1, err2, err3;
+
+  *x= a * b;
+  split( a, &ahi, &alo );
+  split( b, &bhi, &blo );
+  err1= *x - (ahi * bhi);
+  err2= err1 - (alo * bhi);
+  err3= err2 - (ahi * blo);
+  *y= (alo * blo) - err3;
+}
+
+static int difference( double a, double b, double *h )
+/* This routine sets h to the expansion for a-b, returning its length */
+{
+  int len= 0;
+  double x, y;
+
+  two_diff( a, b, &x, &y );
+  if (y != 0.0) h[len++]= y;
+  if (x != 0.0) h[len++]= x;
+  return(len);
+}
+
+static int expansion_sum( int elen, double *e, int flen, double *f,
+			  double *h )
+/* This routine sets h to e+f, dropping zero components.  The two
+ * expansions are merged by magnitude and summed from the bottom up.
+ */
+{
+  double q, qnew, hh;
+  int ei= 0, fi= 0, hi= 0;
+
+  if (elen==0) {
+    for (fi=0; fi<flen; fi++) h[fi]= f[fi];
+    return(flen);
+  }
+  if (flen==0) {
+    for (ei=0; ei<elen; ei++) h[ei]= e[ei];
+    return(elen);
+  }
+
+  if ((f[0] > e[0]) == (f[0] > -e[0])) q= e[ei++];
+  else q= f[fi++];
+  while (ei<elen || fi<flen) {
+    double next;
+    if (fi>=flen || (ei<elen && ((f[fi] > e[ei]) == (f[fi] > -e[ei]))))
+      next= e[ei++];
+    else next= f[fi++];
+    two_sum( q, next, &qnew, &hh );
+    q= qnew;
+    if (hh != 0.0) h[hi++]= hh;
+  }
+  if (q != 0.0 || hi==0) h[hi++]= q;
+  return(hi);
+}
+
+static int scale_expansion( int elen, double *e, double b, double *h )
+/* This routine sets h to b*e, dropping zero components */
+{
+  double q, sum, hh, product1, product0;
+  int i, hi= 0;
+
+  if (elen==0) return(0);
+  two_product( e[0], b, &q, &hh );
+  if (hh != 0.0) h[hi++]= hh;
+  for (i=1; i<elen; i++) {
+    two_product( e[i], b, &product1, &product0 );
+    two_sum( q, product0, &sum, &hh );
+    if (hh != 0.0) h[hi++]= hh;
+    fast_two_sum( product1, sum, &q, &hh );
+    if (hh != 0.0) h[hi++]= hh;
+  }
+  if (q != 0.0 || hi==0) h[hi++]= q;
+  return(hi);
+}
+
+static int expansion_product( int elen, double *e, int flen, double *f,
+			      double *h )
+/* This routine sets h to e*f, which may hold up to 2*elen*flen terms */
+{
+  double term[EXPANSION_MAX], sum[EXPANSION_MAX];
+  int i, tlen, hlen= 0;
+
+  for (i=0; i<flen; i++) {
+    tlen= scale_expansion( elen, e, f[i], term );
+    hlen= expansion_sum( hlen, h, tlen, term, sum );
+    memcpy( h, sum, hlen*sizeof(double) );
+  }
+  return(hlen);
+}
+
+static int expansion_sign( int elen, double *e )
+{
+  if (elen==0 || e[elen-1]==0.0) return(0);
+  return( (e[elen-1] > 0.0) ? 1 : -1 );
+}
+
+static int exact_orient( double *a, double *b, double *c )
+{
+  double acx[2], acy[2], bcx[2], bcy[2], left[8], right[8], det[16];
+  int acxlen, acylen, bcxlen, bcylen, llen, rlen, i;
+
+  acxlen= difference( a[0], c[0], acx );
+  acylen= difference( a[1], c[1], acy );
+  bcxlen= difference( b[0], c[0], bcx );
+  bcylen= difference( b[1], c[1], bcy );
+  llen= expansion_product( acxlen, acx, bcylen, bcy, left );
+  rlen= expansion_product( acylen, acy, bcxlen, bcx, right );
+  for (i=0; i<rlen; i++) right[i]= -right[i];
+  return( expansion_sign( expansion_sum( llen, left, rlen, right, det ),
+			  det ) );
+}
+
+static int lift( double *dx, int dxlen, double *dy, int dylen, double *h )
+/* This routine sets h to dx*dx + dy*dy */
+{
+  double xx[8], yy[8];
+  int xxlen, yylen;
+
+  xxlen= expansion_product( dxlen, dx, dxlen, dx, xx );
+  yylen= expansion_product( dylen, dy, dylen, dy, yy );
+  return( expansion_sum( xxlen, xx, yylen, yy, h ) );
+}
+
+static int cross( double *ux, int uxlen, double *uy, int uylen,
+		  double *vx, int vxlen, double *vy, int vylen, double *h )
+/* This routine sets h to ux*vy - uy*vx */
+{
+  double left[8], right[8];
+  int llen, rlen, i;
+
+  llen= expansion_product( uxlen, ux, vylen, vy, left );
+  rlen= expansion_product( uylen, uy, vxlen, vx, right );
+  for (i=0; i<rlen; i++) right[i]= -right[i];
+  return( expansion_sum( llen, left, rlen, right, h ) );
+}
+
+static int exact_incircle( double *a, double *b, double *c, double *d )
+{
+  double adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+  double lifted[16], det2[16];
+  double aterm[EXPANSION_MAX], bterm[EXPANSION_MAX], cterm[EXPANSION_MAX];
+  double ab[2*EXPANSION_MAX], abc[3*EXPANSION_MAX];
+  int adxlen, adylen, bdxlen, bdylen, cdxlen, cdylen;
+  int liftlen, det2len, alen, blen, clen, ablen;
+
+  adxlen= difference( a[0], d[0], adx );
+  adylen= difference( a[1], d[1], ady );
+  bdxlen= difference( b[0], d[0], bdx );
+  bdylen= difference( b[1], d[1], bdy );
+  cdxlen= difference( c[0], d[0], cdx );
+  cdylen= difference( c[1], d[1], cdy );
+
+  liftlen= lift( adx, adxlen, ady, adylen, lifted );
+  det2len= cross( bdx, bdxlen, bdy, bdylen, cdx, cdxlen, cdy, cdylen, det2 );
+  alen= expansion_product( liftlen, lifted, det2len, det2, aterm );
+
+  liftlen= lift( bdx, bdxlen, bdy, bdylen, lifted );
+  det2len= cross( cdx, cdxlen, cdy, cdylen, adx, adxlen, ady, adylen, det2 );
+  blen= expansion_product( liftlen, lifted, det2len, det2, bterm );
+
+  liftlen= lift( cdx, cdxlen, cdy, cdylen, lifted );
+  det2len= cross( adx, adxlen, ady, adylen, bdx, bdxlen, bdy, bdylen, det2 );
+  clen= expansion_product( liftlen, lifted, det2len, det2, cterm );
+
+  ablen= expansion_sum( alen, aterm, blen, bterm, ab );
+  return( expansion_sign( expansion_sum( ablen, ab, clen, cterm, abc ),
+			  abc ) );
+}
+
+static int orient( int ia, int ib, int ic )
+/* This routine returns 1 if the given points are counterclockwise,
+ * -1 if they are clockwise, and 0 if they are collinear.
+ */
+{
+  double *a= pts+2*ia, *b= pts+2*ib, *c= pts+2*ic;
+  double detleft, detright, det, detsum;
+
+  detleft= (a[0] - c[0]) * (b[1] - c[1]);
+  detright= (a[1] - c[1]) * (b[0] - c[0]);
+  det= detleft - detright;
+
+  if (detleft > 0.0) {
+    if (detright <= 0.0) return( (det > 0.0) ? 1 : (det < 0.0) ? -1 : 0 );
+    detsum= detleft + detright;
+  }
+  else if (detleft < 0.0) {
+    if (detright >= 0.0) return( (det > 0.0) ? 1 : (det < 0.0) ? -1 : 0 );
+    detsum= -detleft - detright;
+  }
+  else return( (det > 0.0) ? 1 : (det < 0.0) ? -1 : 0 );
+
+  if (det >= CCW_ERRBOUND*detsum) return(1);
+  if (-det >= CCW_ERRBOUND*detsum) return(-1);
+  return( exact_orient( a, b, c ) );
+}
+
+static int incircle( int ia, int ib, int ic, int id )
+/* This routine returns 1 if point id is inside the circle through the
+ * counterclockwise triangle ia, ib, ic, -1 if it is outside, and 0 if
+ * it is on the circle.
+ */
+{
+  double *a= pts+2*ia, *b= pts+2*ib, *c= pts+2*ic, *d= pts+2*id;
+  double adx, bdx, cdx, ady, bdy, cdy;
+  double bdxcdy, cdxbdy, cdxady, adxcdy, adxbdy, bdxady;
+  double alift, blift, clift, det, permanent;
+
+  adx= a[0] - d[0];
+  bdx= b[0] - d[0];
+  cdx= c[0] - d[0];
+  ady= a[1] - d[1];
+  bdy= b[1] - d[1];
+  cdy= c[1] - d[1];
+
+  bdxcdy= bdx * cdy;
+  cdxbdy= cdx * bdy;
+  alift= adx * adx + ady * ady;
+  cdxady= cdx * ady;
+  adxcdy= adx * cdy;
+  blift= bdx * bdx + bdy * bdy;
+  adxbdy= adx * bdy;
+  bdxady= bdx * ady;
+  clift= cdx * cdx + cdy * cdy;
+
+  det= alift * (bdxcdy - cdxbdy)
+    + blift * (cdxady - adxcdy)
+    + clift * (adxbdy - bdxady);
+  permanent= (fabs(bdxcdy) + fabs(cdxbdy)) * alift
+    + (fabs(cdxady) + fabs(adxcdy)) * blift
+    + (fabs(adxbdy) + fabs(bdxady)) * clift;
+
+  if (det > ICC_ERRBOUND*permanent) return(1);
+  if (-det > ICC_ERRBOUND*permanent) return(-1);
+  return( exact_incircle( a, b, c, d ) );
+}
+
+/*
+ * Insertion order
+ */
+
+static unsigned int hilbert_key( unsigned int x, unsigned int y )
+/* This routine returns the position of a point along a Hilbert curve */
+{
+  unsigned int n= 1 << HILBERT_BITS, s, rx, ry, t;
+  unsigned int result= 0;
+
+  for (s=n/2; s>0; s >>= 1) {
+    rx= (x & s) != 0;
+    ry= (y & s) != 0;
+    result += s * s * ((3 * rx) ^ ry);
+    if (!ry) {
+      if (rx) {
+	x= n-1-x;
+	y= n-1-y;
+      }
+      t= x;
+      x= y;
+      y= t;
+    }
+  }
+
+  return(result);
+}
+
+static int compare_order( const void *p1, const void *p2 )
+{
+  dl2_Order *o1= (dl2_Order *)p1, *o2= (dl2_Order *)p2;
+
+  if (o1->round != o2->round) return( o1->round - o2->round );
+  if (o1->key != o2->key) return( (o1->key < o2->key) ? -1 : 1 );
+  return( o1->index - o2->index );
+}
+
+static int *insertion_order( int npts )
+/* This routine returns an array giving the order in which the points
+ * should be inserted.  Points are randomly assigned to rounds, each
+ * holding about half the points not in a later round, and are sorted
+ * along a Hilbert curve within rounds.
+ */
+{
+  dl2_Order *order;
+  int *result;
+  unsigned long seed= 1;
+  double lo[2], hi[2], scale[2];
+  int nrounds, i, j;
+
+  if ( !(order= (dl2_Order *)malloc( npts*sizeof(dl2_Order) )) )
+    ger_fatal("dl2_triangulate: unable to allocate %d bytes!",
+	      npts*sizeof(dl2_Order));
+  if ( !(result= (int *)malloc( npts*sizeof(int) )) )
+    ger_fatal("dl2_triangulate: unable to allocate %d bytes!",
+	      npts*sizeof(int));
+
+  for (j=0; j<2; j++) {
+    lo[j]= hi[j]= pts[j];
+    for (i=1; i<npts; i++) {
+      if (pts[2*i+j] < lo[j]) lo[j]= pts[2*i+j];
+      if (pts[2*i+j] > hi[j]) hi[j]= pts[2*i+j];
+    }
+    scale[j]= (hi[j] > lo[j]) ? ((1<<HILBERT_BITS)-1)/(hi[j]-lo[j]) : 0.0;
+  }
+
+  for (nrounds=1; (1<<nrounds) < npts; nrounds++);
+
+  for (i=0; i<npts; i++) {
+    /* Coin flips pick the round; the last round gets half the points */
+    order[i].round= nrounds;
+    while (order[i].round > 0) {
+      seed= (seed*1103515245 + 12345) & 0x7fffffff;
+      if ((seed >> 16) & 1) break;
+      order[i].round--;
+    }
+    order[i].key=
+      hilbert_key( (unsigned int)((pts[2*i] - lo[0])*scale[0]),
+		   (unsigned int)((pts[2*i+1] - lo[1])*scale[1]) );
+    order[i].index= i;
+  }
+
+  qsort( order, npts, sizeof(dl2_Order), compare_order );
+  for (i=0; i<npts; i++) result[i]= order[i].index;
+
+  free( (P_Void_ptr)order );
+  return(result);
+}
+
+/*
+ * Triangulation
+ */
+
+static int is_ghost( int t )
+{
+  return( vtx[3*t]==INFINITE_VTX || vtx[3*t+1]==INFINITE_VTX
+	 || vtx[3*t+2]==INFINITE_VTX );
+}
+
+static void link( int e1, int e2 )
+{
+  twin[e1]= e2;
+  twin[e2]= e1;
+}
+
+static void push_edge( int *depth, int e )
+{
+  if (*depth >= stack_size) {
+    stack_size= (stack_size>0) ? 2*stack_size : 64;
+    if ( !(stack= (int *)realloc( stack, stack_size*sizeof(int) )) )
+      ger_fatal("dl2_triangulate: unable to allocate %d bytes!",
+		stack_size*sizeof(int));
+  }
+  stack[(*depth)++]= e;
+}
+
+static int in_conflict( int e, int p )
+/* This routine returns true if point p lies inside the circumcircle of
+ * the triangle holding half-edge e.  For a ghost triangle the
+ * 'circumcircle' is the open half plane beyond its hull edge.
+ */
+{
+  int a= vtx[e], b= vtx[NEXT(e)], c= vtx[PREV(e)];
+
+  if (a==INFINITE_VTX) return( orient( b, c, p ) > 0 );
+  if (b==INFINITE_VTX) return( orient( c, a, p ) > 0 );
+  if (c==INFINITE_VTX) return( orient( a, b, p ) > 0 );
+  return( incircle( a, b, c, p ) > 0 );
+}
+
+static void legalize( int depth )
+/* This routine flips edges from the stack until the triangulation is
+ * Delaunay again.  Every edge on the stack is opposite the newly
+ * inserted point in its triangle.
+ */
+{
+  int e, n1, n2, f, m1, m2, a, b, p, q;
+  int o_n1, o_n2, o_m1, o_m2;
+
+  while (depth>0) {
+    e= stack[--depth];
+    n1= NEXT(e);
+    n2= PREV(e);
+    p= vtx[n2];
+    f= twin[e];
+    if (!in_conflict( f, p )) continue;
+
+    /* Triangles (a,b,p) and (b,a,q) become (q,p,a) and (p,q,b) */
+    m1= NEXT(f);
+    m2= PREV(f);
+    a= vtx[e];
+    b= vtx[f];
+    q= vtx[m2];
+    o_n1= twin[n1];
+    o_n2= twin[n2];
+    o_m1= twin[m1];
+    o_m2= twin[m2];
+    vtx[e]= q;
+    vtx[n1]= p;
+    vtx[n2]= a;
+    vtx[f]= p;
+    vtx[m1]= q;
+    vtx[m2]= b;
+    link( e, f );
+    link( n1, o_n2 );
+    link( n2, o_m1 );
+    link( m1, o_m2 );
+    link( m2, o_n1 );
+
+    push_edge( &depth, n2 );
+    push_edge( &depth, m1 );
+  }
+}
+
+static int locate( int p, int *on_edge )
+/* This routine walks from the last triangle made to the triangle
+ * holding point p, which is returned.  If p lies on an edge of a real
+ * triangle, *on_edge is set to that half-edge.  If p duplicates an
+ * existing point, -1 is returned.  Each step crosses an edge which has
+ * p strictly on its far side, trying the edges in random order;  the
+ * walk ends on reaching a ghost triangle, since p then lies beyond
+ * that hull edge.
+ */
+{
+  int t= last_tri, e, k, first, sign, zeros;
+
+  if (is_ghost(t)) {
+    for (k=0; k<3; k++)
+      if (vtx[3*t+k]!=INFINITE_VTX && vtx[NEXT(3*t+k)]!=INFINITE_VTX) break;
+    t= twin[3*t+k]/3;
+  }
+
+  while (1) {
+    walk_seed= (walk_seed*1103515245 + 12345) & 0x7fffffff;
+    first= (walk_seed >> 16) % 3;
+    zeros= 0;
+    *on_edge= -1;
+    for (k=0; k<3; k++) {
+      e= 3*t + (first+k)%3;
+      sign= orient( vtx[e], vtx[NEXT(e)], p );
+      if (sign<0) break;
+      if (sign==0) {
+	zeros++;
+	*on_edge= e;
+      }
+    }
+    if (k==3) break;
+    t= twin[e]/3;
+    if (is_ghost(t)) {
+      *on_edge= -1;
+      return(t);
+    }
+  }
+
+  if (zeros>1) return(-1);
+  return(t);
+}
+
+static void insert_in_triangle( int t, int p )
+/* This routine splits triangle t (a,b,c) into (a,b,p), (b,c,p), and
+ * (c,a,p).
+ */
+{
+  int h0= 3*t, h1= 3*t+1, h2= 3*t+2;
+  int g0= 3*ntris, g1= g0+1, g2= g0+2;
+  int k0= g0+3, k1= g0+4, k2= g0+5;
+  int a= vtx[h0], b= vtx[h1], c= vtx[h2];
+  int o_h1= twin[h1], o_h2= twin[h2];
+  int depth= 0;
+
+  vtx[h2]= p;
+  vtx[g0]= b;
+  vtx[g1]= c;
+  vtx[g2]= p;
+  vtx[k0]= c;
+  vtx[k1]= a;
+  vtx[k2]= p;
+  link( g0, o_h1 );
+  link( k0, o_h2 );
+  link( h1, g2 );
+  link( g1, k2 );
+  link( k1, h2 );
+  ntris += 2;
+
+  push_edge( &depth, h0 );
+  push_edge( &depth, g0 );
+  push_edge( &depth, k0 );
+  legalize( depth );
+}
+
+static void insert_on_edge( int e, int p )
+/* This routine splits the edge e (a,b) between triangles (a,b,c) and
+ * (b,a,d) at point p, making (a,p,c), (p,b,c), (b,p,d), and (p,a,d).
+ */
+{
+  int n1= NEXT(e), n2= PREV(e);
+  int f= twin[e], m1= NEXT(f), m2= PREV(f);
+  int x0= 3*ntris, x1= x0+1, x2= x0+2;
+  int y0= x0+3, y1= x0+4, y2= x0+5;
+  int a= vtx[e], b= vtx[n1], c= vtx[n2], d= vtx[m2];
+  int o_n1= twin[n1], o_m1= twin[m1];
+  int depth= 0;
+
+  vtx[n1]= p;
+  vtx[m1]= p;
+  vtx[x0]= p;
+  vtx[x1]= b;
+  vtx[x2]= c;
+  vtx[y0]= p;
+  vtx[y1]= a;
+  vtx[y2]= d;
+  link( e, y0 );
+  link( f, x0 );
+  link( n1, x2 );
+  link( m1, y2 );
+  link( x1, o_n1 );
+  link( y1, o_m1 );
+  ntris += 2;
+
+  push_edge( &depth, n2 );
+  push_edge( &depth, x1 );
+  push_edge( &depth, m2 );
+  push_edge( &depth, y1 );
+  legalize( depth );
+}
+
+static int first_triangle( int *order, int npts, int *used1, int *used2 )
+/* This routine makes the first real triangle from the earliest three
+ * points in the insertion order which are not collinear, surrounded
+ * by three ghost triangles.  The first point is order[0], and the
+ * places of the other two in the order are returned.  False is
+ * returned if there are no three such points.
+ */
+{
+  int i0= order[0], i1, i2, i, s;
+
+  for (i=1; i<npts; i++)
+    if (pts[2*order[i]]!=pts[2*i0] || pts[2*order[i]+1]!=pts[2*i0+1]) break;
+  if (i>=npts) return(0);
+  *used1= i;
+  i1= order[i];
+  for (i=i+1; i<npts; i++)
+    if ((s= orient( i0, i1, order[i] )) != 0) break;
+  if (i>=npts) return(0);
+  *used2= i;
+  i2= order[i];
+
+  if (s<0) {
+    i2= i1;
+    i1= order[i];
+  }
+  vtx[0]= i0;
+  vtx[1]= i1;
+  vtx[2]= i2;
+  vtx[3]= i1;
+  vtx[4]= i0;
+  vtx[5]= INFINITE_VTX;
+  vtx[6]= i2;
+  vtx[7]= i1;
+  vtx[8]= INFINITE_VTX;
+  vtx[9]= i0;
+  vtx[10]= i2;
+  vtx[11]= INFINITE_VTX;
+  link( 0, 3 );
+  link( 1, 6 );
+  link( 2, 9 );
+  link( 4, 11 );
+  link( 7, 5 );
+  link( 10, 8 );
+  ntris= 4;
+  last_tri= 0;
+  return(1);
+}
+
+int dl2_triangulate( double *coords, int npts, int **triangles )
+/* This routine triangulates the given points, stored as x,y pairs.
+ * The triangles are returned in a newly allocated array of point index
+ * triples, all counterclockwise, and the number of triangles is
+ * returned.  Nothing is allocated if there are no triangles.
+ */
+{
+  int *order, *result;
+  int i, t, e, used1, used2, count, skipped= 0;
+
+  ger_debug("dl2_triangulate: %d points", npts);
+
+  if (npts<3) return(0);
+
+  pts= coords;
+  if ( !(vtx= (int *)malloc( 3*(2*npts+2)*sizeof(int) ))
+       || !(twin= (int *)malloc( 3*(2*npts+2)*sizeof(int) )) )
+    ger_fatal("dl2_triangulate: unable to allocate %d bytes!",
+	      6*(2*npts+2)*sizeof(int));
+  order= insertion_order( npts );
+  walk_seed= 1;
+
+  count= 0;
+  if (first_triangle( order, npts, &used1, &used2 )) {
+    for (i=1; i<npts; i++) {
+      if (i==used1 || i==used2) continue;
+      t= locate( order[i], &e );
+      if (t<0) skipped++;
+      else if (e>=0) insert_on_edge( e, order[i] );
+      else insert_in_triangle( t, order[i] );
+      if (t>=0) last_tri= ntris-1;
+    }
+    for (t=0; t<ntris; t++) if (!is_ghost(t)) count++;
+  }
+  if (skipped) ger_debug("dl2_triangulate: %d duplicate points dropped",
+			 skipped);
+
+  if (count>0) {
+    if ( !(result= (int *)malloc( 3*count*sizeof(int) )) )
+      ger_fatal("dl2_triangulate: unable to allocate %d bytes!",
+		3*count*sizeof(int));
+    *triangles= result;
+    for (t=0; t<ntris; t++) if (!is_ghost(t)) {
+      *result++= vtx[3*t];
+      *result++= vtx[3*t+1];
+      *result++= vtx[3*t+2];
+    }
+  }
+
+  free( (P_Void_ptr)order );
+  free( (P_Void_ptr)vtx );
+  free( (P_Void_ptr)twin );
+  if (stack) free( (P_Void_ptr)stack );
+  stack= (int *)0;
+  stack_size= 0;
+  vtx= twin= (int *)0;
+  pts= (double *)0;
+
+  ger_debug("dl2_triangulate: %d triangles", count);
+  return(count);
+}
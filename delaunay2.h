@@ -0,0 +1,28 @@
+/****************************************************************************
+ * delaunay2.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the planar Delaunay triangulation
+package delaunay2.c, which is used in place of the general Dirichlet
+tesselation package when only two dimensions are needed.
+*/
+
+#ifndef INCL_DELAUNAY2_H
+#define INCL_DELAUNAY2_H
+
+extern int dl2_triangulate( double *coords, int npts, int **triangles );
+
+#endif /* INCL_DELAUNAY2_H */
@@ -98,12 +98,29 @@
  * by walking the lattice of already-existing points until the point
  * closest to the new point is found, and then searching the vertices of
  * that (existing) point to find a deleted vertex.  (Note that the vertex
- * closest to the new point is not necessarily deleted).  The starting
- * point for the walk is either the most recently added point or the
- * point closest to the center of the tesselation.  Which is used is
- * determined by trying both for the first few points ('few' being set
- * by the constant TRIAL_SEARCHES) and then using the method which works
- * best over that sample.
+ * closest to the new point is not necessarily deleted).  
+ *
+ * For all but very small data sets, the starting point for the walk
+ * comes from a uniform grid over the bounding box, each cell of which
+ * holds the last point inserted in that cell.  The cells are sized to
+ * hold about GRID_FILL points apiece once all points are in, so the walk
+ * is typically only a step or two long.  If the cell is still empty, the
+ * most recently added point is used.  For small data sets, the starting
+ * point is either the most recently added point or the point closest to
+ * the center of the tesselation.  Which is used is determined by trying
+ * both for the first few points ('few' being set by the constant
+ * TRIAL_SEARCHES) and then using the method which works best over that
+ * sample.
+ *
+ * Points are not inserted in input order.  Inserting in a random order
+ * keeps the number of vertices deleted per insertion small, while
+ * inserting in spatial order keeps successive points close together.
+ * The points are therefore inserted in Biased Randomized Insertion
+ * Order (Amenta, Choi, and Rote, "Incremental Constructions con BRIO",
+ * SoCG 2003):  they are randomly split into rounds of doubling size, and
+ * sorted along a Hilbert curve within each round.  The random choices
+ * are made with a private generator with a fixed seed, so the result
+ * is reproducible.  Point ids still follow input order.
  *
  * Some of the vertices (those with n bogus points as forming points,
  * where n is the dimensionality of space) are located at infinity.
@@ -128,11 +145,17 @@
  *   point pair cells: less than 50 (doesn't vary with n)
  *
  * The code provides for vertex pair cells, but doesn't use them.
+ *
+ * Points, vertices, coordinates, and list cells are carved out of large
+ * blocks of POOL_BLOCK_CELLS cells each, and are recycled through free
+ * lists as the tesselation changes.  The blocks are returned to the
+ * system when the last existing tesselation is destroyed.
  * 
  */
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "p3dgen.h"
 #include "ge_error.h"
 #include "dirichlet.h"
@@ -152,6 +175,25 @@
                                the closest point to a new point */
 #define PROXIMITY_TOLERANCE 0.000001 /* factor used to determine if points
                                         or vertices are too close together */
+#define GRID_MIN_PTS 64 /* smallest data set for which a grid is used */
+#define GRID_FILL 2 /* approximate number of points per grid cell */
+#define HILBERT_BITS 32 /* total bits in a Hilbert curve sort key */
+#define POOL_BLOCK_CELLS 1024 /* cells allocated at a time by memory pools */
+#define MAX_POOL_DIM 8 /* larger coordinate arrays are malloc'd singly */
+
+/* A memory pool, from which cells of a single size are allocated */
+typedef struct dch_pool_struct {
+  int cell_size;
+  P_Void_ptr free_cells; /* chained through the first word of each cell */
+  P_Void_ptr blocks;     /* chained through the first word of each block */
+} dch_Pool;
+
+/* Static initializer for an empty pool of cells of the given type */
+#define POOL_INIT( type ) { sizeof(type), (P_Void_ptr)0, (P_Void_ptr)0 }
+
+/* Block headers and cells are padded to this alignment */
+typedef union { double d; P_Void_ptr p; } dch_Align;
+#define POOL_ALIGN (sizeof(dch_Align))
 
 /* Dimensionality, and some globals to help memory management */
 static int current_dim= 0;
@@ -170,15 +212,21 @@ static int created_vtx_pair_highwater= 0;
 static int created_pt_pair_count= 0;
 static int created_pt_pair_highwater= 0;
 static int dataset_size;
+static int live_tess_count= 0;
 
 /* Space to perform Gaussian eliminations in */
 static float *gauss_matrix= (float *)0;
 
-/* Points from which to hang free cell lists */
-static dch_Vtx_list *free_vtx_list_cells= (dch_Vtx_list *)0;
-static dch_Pt_list *free_pt_list_cells= (dch_Pt_list *)0;
-static dch_Vtx *free_vtx_cells= (dch_Vtx *)0; /* connected via 
-						 'neighbors' slots */
+/* Memory pools for the various cell types.  Coordinate arrays get
+ * a pool for each dimensionality.
+ */
+static dch_Pool vtx_list_pool= POOL_INIT(dch_Vtx_list);
+static dch_Pool pt_list_pool= POOL_INIT(dch_Pt_list);
+static dch_Pool vtx_pool= POOL_INIT(dch_Vtx);
+static dch_Pool pt_pool= POOL_INIT(dch_Pt);
+static dch_Pool vtx_pair_pool= POOL_INIT(dch_Vtx_pair_list);
+static dch_Pool pt_pair_pool= POOL_INIT(dch_Pt_pair_list);
+static dch_Pool coord_pool[MAX_POOL_DIM+1];
 
 /* Some forward definitions */
 static void destroy_vtx_list( dch_Vtx_list * );
@@ -186,6 +234,92 @@ static void destroy_pt_list( dch_Pt_list * );
 static void destroy_vtx( dch_Vtx * );
 static void destroy_pt( dch_Pt * );
 
+static P_Void_ptr pool_get( dch_Pool *pool )
+/* This routine returns a cell from the given pool */
+{
+  P_Void_ptr cell;
+
+  if (!pool->free_cells) {
+    char *block;
+    int size, i;
+
+    /* Round the cell size up so that every cell is aligned */
+    size= POOL_ALIGN*((pool->cell_size + POOL_ALIGN - 1)/POOL_ALIGN);
+    if ( !(block= (char *)malloc( POOL_ALIGN + POOL_BLOCK_CELLS*size )) )
+      ger_fatal("pool_get: unable to allocate %d bytes!",
+		POOL_ALIGN + POOL_BLOCK_CELLS*size);
+    *(P_Void_ptr *)block= pool->blocks;
+    pool->blocks= (P_Void_ptr)block;
+    block += POOL_ALIGN;
+    for (i=POOL_BLOCK_CELLS-1; i>=0; i--) {
+      *(P_Void_ptr *)(block + i*size)= pool->free_cells;
+      pool->free_cells= (P_Void_ptr)(block + i*size);
+    }
+  }
+
+  cell= pool->free_cells;
+  pool->free_cells= *(P_Void_ptr *)cell;
+  return(cell);
+}
+
+static void pool_put( dch_Pool *pool, P_Void_ptr cell )
+/* This routine returns a cell to its pool */
+{
+  *(P_Void_ptr *)cell= pool->free_cells;
+  pool->free_cells= cell;
+}
+
+static void pool_release( dch_Pool *pool )
+/* This routine returns all of a pool's memory to the system.  Any cells
+ * still in use become invalid.
+ */
+{
+  P_Void_ptr block;
+
+  while (pool->blocks) {
+    block= pool->blocks;
+    pool->blocks= *(P_Void_ptr *)block;
+    free( block );
+  }
+  pool->free_cells= (P_Void_ptr)0;
+}
+
+static void release_all_pools( VOIDLIST )
+{
+  int i;
+
+  ger_debug("release_all_pools:");
+
+  pool_release( &vtx_list_pool );
+  pool_release( &pt_list_pool );
+  pool_release( &vtx_pool );
+  pool_release( &pt_pool );
+  pool_release( &vtx_pair_pool );
+  pool_release( &pt_pair_pool );
+  for (i=0; i<=MAX_POOL_DIM; i++) pool_release( coord_pool+i );
+}
+
+static float *create_coords( VOIDLIST )
+/* This routine returns space for one set of coordinates */
+{
+  float *result;
+
+  if (current_dim <= MAX_POOL_DIM) {
+    coord_pool[current_dim].cell_size= current_dim*sizeof(float);
+    result= (float *)pool_get( coord_pool+current_dim );
+  }
+  else if ( !(result= (float *)malloc(current_dim * sizeof(float))) )
+    ger_fatal("create_coords: unable to allocate %d floats!",current_dim);
+  return(result);
+}
+
+static void destroy_coords( float *coords )
+{
+  if (current_dim <= MAX_POOL_DIM) 
+    pool_put( coord_pool+current_dim, (P_Void_ptr)coords );
+  else free( (P_Void_ptr)coords );
+}
+
 static void mem_init(int npts, int dim)
 {
   ger_debug("mem_init: %d pts of dimension %d",npts,dim);
@@ -245,18 +379,10 @@ static dch_Vtx *create_vtx( float *coords )
   dch_Vtx *vtx;
   int i;
 
-  if (!free_vtx_cells) {
-    if ( !(vtx= (dch_Vtx *)malloc(sizeof(dch_Vtx))) )
-      ger_fatal("create_vtx: unable to allocate %d bytes!",sizeof(dch_Vtx));
-  }
-  else {
-    vtx= free_vtx_cells;
-    free_vtx_cells= (dch_Vtx *)vtx->neighbors;
-  }
+  vtx= (dch_Vtx *)pool_get( &vtx_pool );
 
   if (coords) { /* don't do this for vertices at infinity */
-    if ( !(vtx->coords= (float *)malloc(current_dim * sizeof(float))) )
-      ger_fatal("create_vtx: unable to allocate %d floats!",current_dim);
+    vtx->coords= create_coords();
     for (i=0; i<current_dim; i++) vtx->coords[i]= coords[i];
   }
   else vtx->coords= (float *)0;
@@ -280,16 +406,7 @@ static void add_list_vtx( dch_Vtx_list **vlist, dch_Vtx *vtx )
 {
   dch_Vtx_list *temp;
 
-  if ( !free_vtx_list_cells ) { /* need to create a cell */
-    if ( !(temp= (dch_Vtx_list *)malloc(sizeof(dch_Vtx_list))) )
-      ger_fatal("add_list_vtx: unable to allocate %d bytes!",
-		sizeof(dch_Vtx_list));
-  }
-  else {
-    temp= free_vtx_list_cells;
-    free_vtx_list_cells= temp->next;
-  }
-
+  temp= (dch_Vtx_list *)pool_get( &vtx_list_pool );
   temp->next= *vlist;
   temp->vtx= vtx;
   *vlist= temp;
@@ -304,9 +421,7 @@ static void add_pair_vtxs( dch_Vtx_pair_list **vplist,
 {
   dch_Vtx_pair_list *temp;
 
-  if ( !(temp= (dch_Vtx_pair_list *)malloc(sizeof(dch_Vtx_pair_list))) )
-    ger_fatal("add_pair_vtxs: unable to allocate %d bytes!",
-              sizeof(dch_Vtx_pair_list));
+  temp= (dch_Vtx_pair_list *)pool_get( &vtx_pair_pool );
 
   temp->next= *vplist;
   temp->vtx1= vtx1;
@@ -329,8 +444,7 @@ static void remove_list_vtx( dch_Vtx_list **vlist, dch_Vtx *vtx )
   while (current) {
     if (current->vtx == vtx) {
       holder= current->next;
-      current->next= free_vtx_list_cells;
-      free_vtx_list_cells= current;
+      pool_put( &vtx_list_pool, (P_Void_ptr)current );
       *set_addr= holder;
       created_vtx_list_count--;
       return;
@@ -351,8 +465,7 @@ static dch_Vtx *pop_vtx( dch_Vtx_list **vlist )
   tmp_vtx= (*vlist)->vtx;
   tmp_list= *vlist;
   *vlist= (*vlist)->next;
-  tmp_list->next= free_vtx_list_cells;
-  free_vtx_list_cells= tmp_list;
+  pool_put( &vtx_list_pool, (P_Void_ptr)tmp_list );
   created_vtx_list_count--;
   return( tmp_vtx );
 }
@@ -367,8 +480,7 @@ static void destroy_vtx_list( dch_Vtx_list *vlist )
   temp= vlist;
   while (temp) {
     temp2= temp->next;
-    temp->next= free_vtx_list_cells;
-    free_vtx_list_cells= temp;
+    pool_put( &vtx_list_pool, (P_Void_ptr)temp );
     temp= temp2;
     created_vtx_list_count--;
   }
@@ -384,7 +496,7 @@ static void destroy_vtx_pairs( dch_Vtx_pair_list *vplist )
   temp= vplist;
   while (temp) {
     temp2= temp->next;
-    free( (P_Void_ptr)temp );
+    pool_put( &vtx_pair_pool, (P_Void_ptr)temp );
     temp= temp2;
     created_vtx_pair_count--;
   }
@@ -397,9 +509,8 @@ static void destroy_vtx( dch_Vtx *vtx )
   destroy_pt_list( vtx->forming_pts );
   destroy_vtx_list( vtx->neighbors );
     
-  if (vtx->coords) free( (P_Void_ptr)vtx->coords );
-  vtx->neighbors= (dch_Vtx_list *)free_vtx_cells;
-  free_vtx_cells= vtx;
+  if (vtx->coords) destroy_coords( vtx->coords );
+  pool_put( &vtx_pool, (P_Void_ptr)vtx );
   created_vtx_count--;
 }
 
@@ -418,10 +529,8 @@ static dch_Pt *create_pt( float *coords )
   dch_Pt *pt;
   int i;
 
-  if ( !(pt= (dch_Pt *)malloc(sizeof(dch_Pt))) )
-    ger_fatal("create_pt: unable to allocate %d bytes!",sizeof(dch_Vtx));
-  if ( !(pt->coords= (float *)malloc(current_dim * sizeof(float))) )
-    ger_fatal("create_pt: unable to allocate %d floats!",current_dim);
+  pt= (dch_Pt *)pool_get( &pt_pool );
+  pt->coords= create_coords();
 
   for (i=0; i<current_dim; i++) pt->coords[i]= coords[i];
 
@@ -443,7 +552,8 @@ static void destroy_pt( dch_Pt *pt )
   destroy_pt_list( pt->neighbors );
   destroy_vtx_list( pt->verts );
 
-  free( (P_Void_ptr)pt );
+  destroy_coords( pt->coords );
+  pool_put( &pt_pool, (P_Void_ptr)pt );
   created_pt_count--;
 }
 
@@ -452,16 +562,7 @@ static void add_list_pt( dch_Pt_list **plist, dch_Pt *pt )
 {
   dch_Pt_list *temp;
 
-  if (!free_pt_list_cells) { /* need to allocate a new cell */
-    if ( !(temp= (dch_Pt_list *)malloc(sizeof(dch_Pt_list))) )
-      ger_fatal("add_list_pt: unable to allocate %d bytes!",
-		sizeof(dch_Pt_list));
-  }
-  else {
-    temp= free_pt_list_cells;
-    free_pt_list_cells= temp->next;
-  }
-
+  temp= (dch_Pt_list *)pool_get( &pt_list_pool );
   temp->next= *plist;
   temp->pt= pt;
   *plist= temp;
@@ -482,8 +583,7 @@ static void remove_list_pt( dch_Pt_list **plist, dch_Pt *pt )
   while (current) {
     if (current->pt == pt) {
       holder= current->next;
-      current->next= free_pt_list_cells;
-      free_pt_list_cells= current;
+      pool_put( &pt_list_pool, (P_Void_ptr)current );
       *set_addr= holder;
       created_pt_list_count--;
       return;
@@ -497,9 +597,7 @@ static void add_pair_pts( dch_Pt_pair_list **pplist, dch_Pt *pt1, dch_Pt *pt2 )
 {
   dch_Pt_pair_list *temp;
 
-  if ( !(temp= (dch_Pt_pair_list *)malloc(sizeof(dch_Pt_pair_list))) )
-    ger_fatal("add_pair_pts: unable to allocate %d bytes!",
-              sizeof(dch_Pt_pair_list));
+  temp= (dch_Pt_pair_list *)pool_get( &pt_pair_pool );
 
   temp->next= *pplist;
   temp->pt1= pt1;
@@ -522,8 +620,7 @@ static dch_Pt *pop_pt( dch_Pt_list **plist )
   tmp_pt= (*plist)->pt;
   tmp_list= *plist;
   *plist= (*plist)->next;
-  tmp_list->next= free_pt_list_cells;
-  free_pt_list_cells= tmp_list;
+  pool_put( &pt_list_pool, (P_Void_ptr)tmp_list );
   created_pt_list_count--;
   return( tmp_pt );
 }
@@ -538,8 +635,7 @@ static void destroy_pt_list( dch_Pt_list *plist )
   temp= plist;
   while (temp) {
     temp2= temp->next;
-    temp->next= free_pt_list_cells;
-    free_pt_list_cells= temp;
+    pool_put( &pt_list_pool, (P_Void_ptr)temp );
     temp= temp2;
     created_pt_list_count--;
   }
@@ -555,7 +651,7 @@ static void destroy_pt_pairs( dch_Pt_pair_list *pplist )
   temp= pplist;
   while (temp) {
     temp2= temp->next;
-    free( (P_Void_ptr)temp );
+    pool_put( &pt_pair_pool, (P_Void_ptr)temp );
     temp= temp2;
     created_pt_pair_count--;
   }
@@ -797,50 +893,46 @@ static void connect_neighboring_pts( dch_Pt_list *pts, dch_Vtx *vtx )
   }
 }
 
-static float calc_product_term( dch_Pt_list *thispt )
-/* This routine is used in find_central_vtx */
-{
-  float result= 0.0;
-  int i;
-
-  for (i=0; i<current_dim; i++) 
-    result += (thispt->pt->coords[i]*thispt->pt->coords[i])
-             -(thispt->next->pt->coords[i]*thispt->next->pt->coords[i]);
-  return( result/2.0 );
-}
-
 static dch_Vtx *find_central_vtx( dch_Pt_list *pts )
 /* This routine returns a vertex equidistant from all the given points. */
 {
   int i,j;
   dch_Pt_list *thispt;
+  dch_Pt *origin;
   float *coords;
+  float diff, sum;
   dch_Vtx *result;
 
   ger_debug("find_central_vtx:");
 
-  /* We want a point equidistant from the given points.  This can
-   * be found by solving the matrix equation (e.g. in 2D, with
-   * forming points A, B, and C and solution P):
+  /* We want a point equidistant from the given points.  Working
+   * relative to the first point A, this can be found by solving the
+   * matrix equation (e.g. in 2D, with forming points A, B, and C and
+   * solution P= A + U):
    *
-   *  / Ax-Bx    Ay-By \  /Px}\     / (A**2 - B**2)/2 \
-   * |                  ||     | = |                   |
-   *  \ Bx-Cx    By-Cy /  \Py}/     \ (B**2 - C**2)/2 /
+   *  / Bx-Ax    By-Ay \  /Ux}\     / (B-A)**2/2 \
+   * |                  ||     | = |              |
+   *  \ Cx-Ax    Cy-Ay /  \Uy}/     \ (C-A)**2/2 /
    *
-   * where A**2 and B**2 are the squared norms of A and B.  This
-   * is easy to prove by simply writing the requirement that A and
-   * B be equidistant from P, expanding the squares, and simplifying.
-   * The algorithm relies on the fact that there will be current_dim+1
-   * points in the input point list.
+   * where (B-A)**2 is the squared norm of B-A.  This is easy to prove
+   * by simply writing the requirement that A and B be equidistant from
+   * P, expanding the squares, and simplifying.  Working relative to A
+   * avoids the loss of precision which comes from subtracting the large,
+   * nearly equal squared norms of closely spaced points.  The algorithm
+   * relies on the fact that there will be current_dim+1 points in the
+   * input point list.
    */
 
-  thispt= pts;
+  origin= pts->pt;
+  thispt= pts->next;
   for (i=0; i<current_dim; i++) {
-    for (j=0; j<current_dim; j++)
-      *(gauss_matrix + i*(current_dim+1) + j)=
-        thispt->pt->coords[j] - thispt->next->pt->coords[j];
-    *(gauss_matrix + i*(current_dim+1) + current_dim)=
-      calc_product_term(thispt);
+    sum= 0.0;
+    for (j=0; j<current_dim; j++) {
+      diff= thispt->pt->coords[j] - origin->coords[j];
+      *(gauss_matrix + i*(current_dim+1) + j)= diff;
+      sum += diff*diff;
+    }
+    *(gauss_matrix + i*(current_dim+1) + current_dim)= 0.5*sum;
     thispt= thispt->next;
   }
 
@@ -849,6 +941,7 @@ static dch_Vtx *find_central_vtx( dch_Pt_list *pts )
    * it for deletion.
    */
   coords= dch_gauss_elim( gauss_matrix, current_dim );
+  if (coords) for (j=0; j<current_dim; j++) coords[j] += origin->coords[j];
   result= create_vtx( coords );
 
   result->forming_pts= pts;
@@ -910,11 +1003,13 @@ static void add_first_vtx_neighbors( dch_Vtx *vtx, dch_Tess *tess )
   free( (P_Void_ptr)point_array );
 }
 
-static dch_Tess *create_initial_tesselation( dch_Bndbx *bndbx )
+static dch_Tess *create_initial_tesselation( dch_Bndbx *bndbx, int npts )
 {
   dch_Tess *tess;
   dch_Pt_list *plist, *forming_pt_list= (dch_Pt_list *)0;
   dch_Vtx *new_vtx;
+  float edge_length= 0.0;
+  int i;
 
   ger_debug("create_initial_tesselation:");
 
@@ -967,11 +1062,22 @@ static dch_Tess *create_initial_tesselation( dch_Bndbx *bndbx )
   tess->searches_done= 0;
   tess->center_steps= 0;
   tess->most_recent_steps= 0;
+  tess->grid_steps= 0;
+  tess->grid_res= 0;
+  tess->grid= (dch_Pt **)0;
 
   /* The following data is used with PROXIMITY_TOLERANCE to determine 
    * when to drop points or vertices because they are too close together.
+   * It is the square of the typical spacing between points, so that
+   * dense data sets don't lose points which are merely close together.
    */
-  tess->characteristic_length= new_vtx->distance;
+  for (i=0; i<current_dim; i++)
+    if ( (bndbx->corner2[i] - bndbx->corner1[i]) > edge_length )
+      edge_length= bndbx->corner2[i] - bndbx->corner1[i];
+  if (edge_length > 0.0)
+    tess->characteristic_length= 
+      edge_length*edge_length*pow( (double)npts, -2.0/current_dim );
+  else tess->characteristic_length= new_vtx->distance;
 
   return(tess);
 }
@@ -983,7 +1089,11 @@ void dch_destroy_tesselation( dch_Tess *tess )
 
   ger_debug("destroy_tesselation:");
 
+  /* Coordinate pools depend on the dimensionality */
+  current_dim= tess->dimensionality;
+
   destroy_bndbx( tess->bndbx );
+  if (tess->grid) free( (P_Void_ptr)tess->grid );
 
   plist= tess->pt_list;
   while (plist) {
@@ -1003,6 +1113,9 @@ void dch_destroy_tesselation( dch_Tess *tess )
   destroy_vtx_list( tess->infinite_vtxs );
 
   free( (P_Void_ptr)tess );
+
+  /* If this was the last tesselation, give the memory back */
+  if (--live_tess_count == 0) release_all_pools();
 #ifdef never
   fprintf(stderr,"Final counts: %d %d %d %d %d %d %d %d %d %d %d %d\n",
 	  created_vtx_count,
@@ -1021,6 +1134,50 @@ void dch_destroy_tesselation( dch_Tess *tess )
 
 }
 
+static int grid_cell( dch_Tess *tess, float *coords )
+/* This routine returns the index of the grid cell holding the given
+ * coordinates.
+ */
+{
+  int i, cell, result= 0;
+  float extent;
+
+  for (i=0; i<current_dim; i++) {
+    extent= tess->bndbx->corner2[i] - tess->bndbx->corner1[i];
+    if (extent > 0.0) {
+      cell= (int)( tess->grid_res * (coords[i] - tess->bndbx->corner1[i])
+		  / extent );
+      if (cell<0) cell= 0;
+      if (cell>=tess->grid_res) cell= tess->grid_res-1;
+    }
+    else cell= 0;
+    result= result*tess->grid_res + cell;
+  }
+  return(result);
+}
+
+static void build_grid( dch_Tess *tess, int npts )
+/* This routine sets up an empty point location grid */
+{
+  int i, ncells;
+
+  tess->grid_res= (int)pow( (double)npts/GRID_FILL, 1.0/current_dim );
+  if (tess->grid_res < 2) {
+    tess->grid_res= 0;
+    return;
+  }
+  ncells= 1;
+  for (i=0; i<current_dim; i++) ncells *= tess->grid_res;
+
+  ger_debug("build_grid: %d cells per side", tess->grid_res);
+
+  if ( !(tess->grid= (dch_Pt **)malloc( ncells*sizeof(dch_Pt *) )) )
+    ger_fatal("build_grid: unable to allocate %d bytes!",
+	      ncells*sizeof(dch_Pt *));
+  for (i=0; i<ncells; i++) tess->grid[i]= (dch_Pt *)0;
+  tess->best_search_method= GRID_CELL;
+}
+
 static dch_Pt *find_closest_pt( dch_Pt *start, dch_Pt *target, int *steps )
 /* This routine walks the vertex list from the given starting point
  * in search of a vertex to be deleted.  steps is a counter, to be
@@ -1085,6 +1242,13 @@ static dch_Vtx *find_vtx_to_delete( dch_Tess *tess, dch_Pt *pt)
   case (int)CENTER_PT: 
     closest_pt= find_closest_pt( tess->center_pt, pt, &(tess->center_steps));
     break;
+  case (int)GRID_CELL:
+    {
+      dch_Pt *start= tess->grid[ grid_cell(tess, pt->coords) ];
+      if (!start) start= tess->most_recent_pt;
+      closest_pt= find_closest_pt( start, pt, &(tess->grid_steps) );
+    }
+    break;
   default: ger_fatal("find_vtx_to_delete: unknown method %d!\n");
   }
   tess->searches_done++;
@@ -1209,9 +1373,12 @@ static int shared_live_vtx( dch_Pt *pt1, dch_Pt *pt2 )
 
   ger_debug("shared_live_vtx: checking points %d and %d",pt1->id,pt2->id);
 
+  /* A vertex of pt1 is also a vertex of pt2 exactly when pt2 is one of
+   * its forming points, and the forming point list is much the shorter.
+   */
   verts= pt1->verts;
   while (verts) {
-    if ( !(verts->vtx->deleted) && vtx_in_list( pt2->verts, verts->vtx ) ) 
+    if ( !(verts->vtx->deleted) && pt_in_list( verts->vtx->forming_pts, pt2 ) )
       return(1);
     verts= verts->next;
   }
@@ -1602,6 +1769,7 @@ static void add_pt_to_tesselation( dch_Tess *tess, dch_Pt *pt )
    * center than the current center point.
    */
   tess->most_recent_pt= pt;
+  if (tess->grid) tess->grid[ grid_cell(tess, pt->coords) ]= pt;
   if ( dist_to_center(pt->coords,tess) 
       < dist_to_center(tess->center_pt->coords,tess) )
     tess->center_pt= pt;
@@ -1621,6 +1789,118 @@ static void add_pt_to_tesselation( dch_Tess *tess, dch_Pt *pt )
 
 }
 
+/* Used in sorting points into insertion order */
+typedef struct dch_order_struct {
+  int round;
+  unsigned int key;
+  int index;
+} dch_Order;
+
+static int compare_order( const void *p1, const void *p2 )
+{
+  dch_Order *o1= (dch_Order *)p1, *o2= (dch_Order *)p2;
+
+  if (o1->round != o2->round) return( o1->round - o2->round );
+  if (o1->key != o2->key) return( (o1->key < o2->key) ? -1 : 1 );
+  return( o1->index - o2->index );
+}
+
+static unsigned int hilbert_key( unsigned int *x, int bits )
+/* This routine returns the position along a Hilbert curve of the point
+ * with the given integer coordinates, each of the given number of bits.
+ * The coordinates are overwritten.  The method is that of J. Skilling,
+ * "Programming the Hilbert Curve", AIP Conf. Proc. 707 (2004), which
+ * works in any number of dimensions.
+ */
+{
+  unsigned int m= 1 << (bits-1), p, q, t;
+  unsigned int result= 0;
+  int i, b;
+
+  /* Inverse undo */
+  for (q=m; q>1; q >>= 1) {
+    p= q-1;
+    for (i=0; i<current_dim; i++) {
+      if (x[i] & q) x[0] ^= p; /* invert */
+      else { /* exchange */
+	t= (x[0]^x[i]) & p;
+	x[0] ^= t;
+	x[i] ^= t;
+      }
+    }
+  }
+
+  /* Gray encode */
+  for (i=1; i<current_dim; i++) x[i] ^= x[i-1];
+  t= 0;
+  for (q=m; q>1; q >>= 1) if (x[current_dim-1] & q) t ^= q-1;
+  for (i=0; i<current_dim; i++) x[i] ^= t;
+
+  /* Interleave the transposed bits to get the key */
+  for (b=bits-1; b>=0; b--)
+    for (i=0; i<current_dim; i++) result= (result << 1) | ((x[i] >> b) & 1);
+
+  return(result);
+}
+
+static int *insertion_order( dch_Pt **pts, int npts, dch_Bndbx *bndbx )
+/* This routine returns an array giving the order in which the points
+ * should be inserted.  Points are randomly assigned to rounds, each
+ * holding about half the points not in a later round, and are sorted
+ * along a Hilbert curve within rounds.
+ */
+{
+  dch_Order *order;
+  int *result;
+  unsigned int *x;
+  unsigned long seed= 1;
+  int bits, nrounds, i, j;
+
+  if ( !(order= (dch_Order *)malloc( npts*sizeof(dch_Order) )) )
+    ger_fatal("insertion_order: unable to allocate %d bytes!",
+	      npts*sizeof(dch_Order));
+  if ( !(result= (int *)malloc( npts*sizeof(int) )) )
+    ger_fatal("insertion_order: unable to allocate %d bytes!",
+	      npts*sizeof(int));
+  if ( !(x= (unsigned int *)malloc( current_dim*sizeof(unsigned int) )) )
+    ger_fatal("insertion_order: unable to allocate %d bytes!",
+	      current_dim*sizeof(unsigned int));
+
+  bits= HILBERT_BITS/current_dim;
+  for (nrounds=1; (1<<nrounds) < npts; nrounds++);
+
+  for (i=0; i<npts; i++) {
+    /* Coin flips pick the round; the last round gets half the points */
+    order[i].round= nrounds;
+    while (order[i].round > 0) {
+      seed= (seed*1103515245 + 12345) & 0x7fffffff;
+      if ((seed >> 16) & 1) break;
+      order[i].round--;
+    }
+
+    order[i].key= 0;
+    if (bits>0) {
+      for (j=0; j<current_dim; j++) {
+	float extent= bndbx->corner2[j] - bndbx->corner1[j];
+	if (extent > 0.0)
+	  x[j]= (unsigned int)( ((1<<bits)-1)
+			       * ((pts[i]->coords[j] - bndbx->corner1[j])
+				  / extent) );
+	else x[j]= 0;
+      }
+      order[i].key= hilbert_key( x, bits );
+    }
+    order[i].index= i;
+  }
+
+  qsort( order, npts, sizeof(dch_Order), compare_order );
+  for (i=0; i<npts; i++) result[i]= order[i].index;
+
+  free( (P_Void_ptr)x );
+  free( (P_Void_ptr)order );
+  return(result);
+}
+
 static dch_Pt *create_user_pt( float *coorddata, int i,
   float *(*coord_access_fun)( float *, int, P_Void_ptr *) )
 /* This function just invokes the user's coordinate access function */
@@ -1638,7 +1918,8 @@ dch_Tess *dch_create_dirichlet_tess
    float *(*coord_access_fun)(float *, int, P_Void_ptr *) )
 {
   int i;
-  dch_Pt_list *thispt, *input_pt_list= (dch_Pt_list *)0;
+  dch_Pt **input_pts;
+  int *order;
   dch_Bndbx *bndbx;
   dch_Tess *tess;
 
@@ -1652,37 +1933,35 @@ dch_Tess *dch_create_dirichlet_tess
 
   mem_init( npts, dimensionality );
 
-  /* Convert all the coordinate data to a point list. */
+  /* Convert all the coordinate data to an array of points. */
+  if ( !(input_pts= (dch_Pt **)malloc( npts*sizeof(dch_Pt *) )) )
+    ger_fatal("create_dirichlet_tesselation: unable to allocate %d bytes!",
+	      npts*sizeof(dch_Pt *));
   for (i=0; i<npts; i++)
-    add_list_pt( &input_pt_list, 
-		create_user_pt( coorddata, i, coord_access_fun ) );
+    input_pts[i]= create_user_pt( coorddata, i, coord_access_fun );
 
   /* Calculate the bounding box */
   bndbx= create_bndbx();
-  thispt= input_pt_list;
-  while (thispt) {
-    add_pt_to_bndbx( bndbx, thispt->pt );
-    thispt= thispt->next;
-  }
+  for (i=0; i<npts; i++) add_pt_to_bndbx( bndbx, input_pts[i] );
 
   /* Create the initial tesselation */
-  tess= create_initial_tesselation(bndbx);
+  tess= create_initial_tesselation(bndbx, npts);
+  live_tess_count++;
+  if (npts >= GRID_MIN_PTS) build_grid( tess, npts );
 
   /* Save the access function, for completeness' sake */
   tess->coord_access_fun= coord_access_fun;
 
   /* Add points, one at a time */
-  thispt= input_pt_list;
-  while (thispt) {
-    add_pt_to_tesselation( tess, thispt->pt );
-    thispt= thispt->next;
-  }
+  order= insertion_order( input_pts, npts, bndbx );
+  for (i=0; i<npts; i++) add_pt_to_tesselation( tess, input_pts[order[i]] );
 
   /* Accumulate the (non-infinite) vertices */
   tess->vtx_list= accumulate_vtxs( tess->pt_list );
 
   /* Clean up */
-  destroy_pt_list( input_pt_list );
+  free( (P_Void_ptr)order );
+  free( (P_Void_ptr)input_pts );
 
   return(tess);
 }
@@ -37,7 +37,7 @@
 #define __(prototype) prototype
 #endif
 
-enum dch_search_method { MOST_RECENT_PT, CENTER_PT, UNKNOWN };
+enum dch_search_method { MOST_RECENT_PT, CENTER_PT, UNKNOWN, GRID_CELL };
 
 struct dch_vtx_struct;
 struct dch_pt_struct;
@@ -102,6 +102,9 @@ typedef struct dch_tess_struct {
   int searches_done;
   int center_steps;
   int most_recent_steps;
+  int grid_steps;
+  int grid_res; /* cells per side of point location grid; 0 if none */
+  dch_Pt **grid;
   float characteristic_length;
   float *(*coord_access_fun) __((float *, int, P_Void_ptr *));
 } dch_Tess;
@@ -93,6 +93,8 @@ extern int dp_polyline ___(( int, int, float *, int ));
 extern int dp_polygon ___(( int, int, float *, int ));
 extern int dp_tristrip ___(( int, int, float *, int ));
 extern int dp_mesh ___(( int, int, float *, int, int *, int *, int ));
+extern int dp_decimated_mesh ___(( int, int, float *, int, int *, int *, int,
+				   int, double ));
 extern int dp_bezier ___(( int, int, float * ));
 extern int dp_text ___(( char *, P_Point *, P_Vector *, P_Vector * ));
 extern int dp_light ___(( P_Point *, P_Color * ));
@@ -106,11 +108,23 @@ extern int dp_isosurface ___(( int type, float *data, float *valdata,
 		  int nx, int ny, int nz, double value,
 		  P_Point *corner1, P_Point *corner2,
 		  int show_inside ));
+extern int dp_isosurface_typed ___(( int type, int datatype, P_Void_ptr data,
+		  float *valdata, int nx, int ny, int nz, double value,
+		  P_Point *corner1, P_Point *corner2,
+		  int show_inside ));
+extern int dp_gradient_cache ___(( int ));
+extern int dp_decimation ___(( double, double ));
+extern int dp_zsurf_adaptive ___(( double, double ));
 extern int dp_zsurface ___(( int, float *, float *, int, int, P_Point *, 
                   P_Point *, void (*) __(( int *, float *, int *, int * )) ));
+extern int dp_zsurface_masked ___(( int, float *, float *, int, int, 
+                  P_Point *, P_Point *, int * ));
 extern int dp_rand_zsurf ___(( int, int, float *, int,
 		  void (*) __(( int *, float *, float*, float *, int *  )) ));
 extern int dp_rand_isosurf ___(( int, int, float *, int, double, int ));
+extern int dp_rand_tess_create ___(( int, int, float *, int ));
+extern int dp_rand_isosurf_tess ___(( int, float *, double, int ));
+extern int dp_rand_tess_destroy ___(( int ));
 extern int dp_irreg_zsurf ___(( int, float *, float *, int, int,
 			       void (*) __((float *, float *, int *, int *)),
 			       void (*) __((int *, float *, int *, int *)) ));
@@ -119,6 +133,24 @@ extern int dp_irreg_isosurf ___(( int type, float *data, float *valdata,
 				 void (*coordfun)(float *, float *, float *,
 						  int *, int *, int *),
 				 int show_inside ));
+extern int dp_irreg_zsurf_coords ___(( int, float *, float *, int, int,
+				      int, float *, float *,
+				      void (*) __((int *, float *, int *, int *)) ));
+extern int dp_irreg_zsurf_batch ___(( int, float *, float *, int, int,
+		     void (*) __((float *, float *, int *, int *, int *)),
+		     void (*) __((int *, float *, int *, int *)) ));
+extern int dp_irreg_isosurf_coords ___(( int type, float *data, 
+					float *valdata, int nx_in, int ny_in,
+					int nz_in, double value, int coordtype,
+					float *xcoords, float *ycoords,
+					float *zcoords, int show_inside ));
+extern int dp_irreg_isosurf_batch ___(( int type, float *data, 
+				       float *valdata, int nx_in, int ny_in,
+				       int nz_in, double value,
+				       void (*batchfun)(float *, float *, 
+							float *, int *, int *,
+							int *, int *),
+				       int show_inside ));
 extern int dp_spline_tube ___(( int, int, float*, int, int*, int, int ));
 
 /* Camera routines */
@@ -130,6 +162,9 @@ extern int dp_camera_background ___(( char *, P_Color * ));
 /* Snap */
 extern int dp_snap ___(( char *, char *, char * ));
 
+/* Loading saved scenes */
+extern int dp_load_p3d ___(( char * ));
+
 /* Color map manipulation routines */
 extern int dp_set_cmap ___((double, double, 
 		void (*) __(( float *, float *, float *, float *, float * ))));
@@ -202,6 +202,30 @@ int dp_isosurface( int type, float *data, float *valdata,
 			corner1, corner2, show_inside, 0 ) );
 }
 
+int dp_isosurface_typed( int type, int datatype, P_Void_ptr data,
+			float *valdata, int nx, int ny, int nz, double value,
+			P_Point *corner1, P_Point *corner2,
+			int show_inside )
+{
+  return( pg_isosurface_typed( type, datatype, data, valdata, nx, ny, nz, 
+			      value, corner1, corner2, show_inside, 0 ) );
+}
+
+int dp_gradient_cache( int mode )
+{
+  return( pg_gradient_cache( mode ) );
+}
+
+int dp_decimation( double fraction, double max_error )
+{
+  return( pg_decimation( fraction, max_error ) );
+}
+
+int dp_zsurf_adaptive( double tolerance, double value_tolerance )
+{
+  return( pg_zsurf_adaptive( tolerance, value_tolerance ) );
+}
+
 int dp_zsurface( int vtxtype, float *zdata, float *valdata, 
                  int nx, int ny, P_Point *corner1, P_Point *corner2, 
                  void (*testfun)( int *, float *, int *, int * ) )
@@ -210,6 +234,14 @@ int dp_zsurface( int vtxtype, float *zdata, float *valdata,
                        corner1, corner2, testfun, 0 ) );
 }
 
+int dp_zsurface_masked( int vtxtype, float *zdata, float *valdata, 
+			int nx, int ny, P_Point *corner1, P_Point *corner2, 
+			int *mask )
+{
+  return( pg_zsurface_masked( vtxtype, zdata, valdata, nx, ny, 
+			      corner1, corner2, mask, 0 ) );
+}
+
 int dp_rand_zsurf( int vtxtype, int ctype, float *data, int npts,
 		  void (*testfun)( int *, float *, float*, float *, int * ))
 {
@@ -227,6 +259,27 @@ int dp_rand_isosurf( int vtxtype, int ctype, float *data, int npts,
   return( retval );  
 }
 
+int dp_rand_tess_create( int vtxtype, int ctype, float *data, int npts )
+{
+  int retval;
+  P_Vlist* vlist= po_create_cvlist( vtxtype, npts, data );
+  retval= pg_rand_tess_create( vlist );
+  METHOD_RDY(vlist);
+  (*(vlist->destroy_self))();
+  return( retval );  
+}
+
+int dp_rand_isosurf_tess( int tess, float *values, double ival, 
+			 int show_inside )
+{
+  return( pg_rand_isosurf_tess( tess, values, ival, show_inside ) );
+}
+
+int dp_rand_tess_destroy( int tess )
+{
+  return( pg_rand_tess_destroy( tess ) );
+}
+
 int dp_irreg_zsurf( int vtxtype, float *zdata, float *valdata,
 		   int nx, int ny,
 		   void (*xyfun) ( float *, float *, int *, int *),
@@ -246,6 +299,45 @@ int dp_irreg_isosurf( int type, float *data, float *valdata,
 			   coordfun, show_inside, 0 ) );
 }
 
+int dp_irreg_zsurf_coords( int vtxtype, float *zdata, float *valdata,
+			  int nx, int ny, int coordtype,
+			  float *xcoords, float *ycoords,
+			  void (*testfun)( int *, float *, int *, int *) )
+{
+  return( pg_irreg_zsurf_coords( vtxtype, zdata, valdata, nx, ny, 
+				coordtype, xcoords, ycoords, testfun, 0 ) );
+}
+
+int dp_irreg_zsurf_batch( int vtxtype, float *zdata, float *valdata,
+			 int nx, int ny,
+			 void (*batchfun)( float *, float *, 
+					  int *, int *, int * ),
+			 void (*testfun)( int *, float *, int *, int *) )
+{
+  return( pg_irreg_zsurf_batch( vtxtype, zdata, valdata, nx, ny, 
+			       batchfun, testfun, 0 ) );
+}
+
+int dp_irreg_isosurf_coords( int type, float *data, float *valdata, 
+			    int nx, int ny, int nz, double value,
+			    int coordtype, float *xcoords, float *ycoords,
+			    float *zcoords, int show_inside )
+{
+  return( pg_irreg_isosurf_coords( type, data, valdata, nx, ny, nz, value,
+				  coordtype, xcoords, ycoords, zcoords,
+				  show_inside, 0 ) );
+}
+
+int dp_irreg_isosurf_batch( int type, float *data, float *valdata, 
+			   int nx, int ny, int nz, double value,
+			   void (*batchfun)(float *, float *, float *,
+					    int *, int *, int *, int *),
+			   int show_inside )
+{
+  return( pg_irreg_isosurf_batch( type, data, valdata, nx, ny, nz, value,
+				 batchfun, show_inside, 0 ) );
+}
+
 int dp_spline_tube( int vtxtype, int ctype, float *data, int npts,
 		    int* which_cross, int bres, int cres )
 {
@@ -255,8 +347,7 @@ int dp_spline_tube( int vtxtype, int ctype, float *data, int npts,
   if (vtxtype==P3D_CCNVTX) vtxtype= P3D_CCVTX;
   if (vtxtype==P3D_CVNVTX) vtxtype= P3D_CVVTX;
   vlist= po_create_cvlist( vtxtype, npts, data );
-  retval= pg_spline_tube( po_create_cvlist( vtxtype, npts, data ),
-			  which_cross, bres, cres );
+  retval= pg_spline_tube( vlist, which_cross, bres, cres );
   METHOD_RDY(vlist);
   (*(vlist->destroy_self))();
   return( retval );
@@ -304,6 +395,15 @@ int dp_mesh( int vtxtype, int ctype, float *vdata, int npts,
 		   vertices, facet_lengths, nfacets ) );
 }
 
+int dp_decimated_mesh( int vtxtype, int ctype, float *vdata, int npts,
+		      int *vertices, int *facet_lengths, int nfacets,
+		      int target, double max_error )
+{
+  return( pg_decimated_mesh( po_create_cvlist( vtxtype, npts, vdata ),
+			     vertices, facet_lengths, nfacets,
+			     target, max_error ) );
+}
+
 int dp_bezier( int vtxtype, int ctype, float *data )
 {
   return( pg_bezier( po_create_cvlist( vtxtype, 16, data ) ) );
@@ -345,6 +445,11 @@ int dp_snap( char *gobname, char *lightname, char *cameraname )
   return( pg_snap( gobname, lightname, cameraname ) );
 }
 
+int dp_load_p3d( char *path )
+{
+  return( pg_load_p3d( path ) );
+}
+
 int dp_set_cmap(double min, double max, 
 		       void (*mapfun)( float *, float *, float *,
 				      float *, float * ) )
@@ -639,6 +639,51 @@ int *show_inside;
 			&corner1, &corner2, *show_inside, 1 ) );
 }
 
+int pisotp( type, datatype, data, valdata, nx, ny, nz, value, 
+	   corner1f, corner2f, show_inside )
+int *type; 
+int *datatype;
+P_Void_ptr data;
+float *valdata;
+int *nx, *ny, *nz; 
+float *value;
+float *corner1f, *corner2f;
+int *show_inside;
+{
+  P_Point corner1, corner2;
+  double dblval;
+  dblval= *value;
+  corner1.x= *corner1f++;
+  corner1.y= *corner1f++;
+  corner1.z= *corner1f;
+  corner2.x= *corner2f++;
+  corner2.y= *corner2f++;
+  corner2.z= *corner2f;
+  return( pg_isosurface_typed( *type, *datatype, data, valdata, 
+			      *nx, *ny, *nz, dblval,
+			      &corner1, &corner2, *show_inside, 1 ) );
+}
+
+int pgrdcc( mode )
+int *mode;
+{
+  return( pg_gradient_cache( *mode ) );
+}
+
+int pdecim( fraction, maxerr )
+float *fraction;
+float *maxerr;
+{
+  return( pg_decimation( (double)*fraction, (double)*maxerr ) );
+}
+
+int pzadpt( tol, valtol )
+float *tol;
+float *valtol;
+{
+  return( pg_zsurf_adaptive( (double)*tol, (double)*valtol ) );
+}
+
 int pzsurf( vtxtype, zdata, valdata, nx, ny, corner1f, corner2f, 
            null_tfun, testfun )
 int *vtxtype;
@@ -662,6 +707,29 @@ void (*testfun)();
 		      &corner2, testfun, 1 ) );
 }
 
+int pzsfmk( vtxtype, zdata, valdata, nx, ny, corner1f, corner2f, 
+	    null_mask, mask )
+int *vtxtype;
+float *zdata, *valdata;
+int *nx, *ny;
+float *corner1f, *corner2f;
+int *null_mask;
+int *mask;
+{
+  P_Point corner1, corner2;
+ 
+  corner1.x = *corner1f++;
+  corner1.y = *corner1f++;
+  corner1.z = *corner1f;
+  corner2.x = *corner2f++;
+  corner2.y = *corner2f++;
+  corner2.z = *corner2f;
+  if (*null_mask)
+    mask = 0;
+  return( pg_zsurface_masked( *vtxtype, zdata, valdata, *nx, *ny, &corner1, 
+			     &corner2, mask, 1 ) );
+}
+
 int prnzsf( vtxtype, ctype, npts, coords, colors, norms, null_tfun, testfun )
 int *vtxtype;
 int *ctype;
@@ -695,6 +763,39 @@ int *show_inside;
   return( retval );    
 }
 
+int prntcr( vtxtype, ctype, npts, coords, colors, norms )
+int *vtxtype;
+int *ctype;
+int *npts;
+float *coords, *colors, *norms;
+{
+  int retval;
+  P_Vlist* vlist= po_create_mvlist( *vtxtype, *npts, coords, colors, norms );
+  retval= pg_rand_tess_create( vlist );
+  METHOD_RDY(vlist);
+  (*(vlist->destroy_self))();
+  return( retval );    
+}
+
+int prntis( tess, null_vals, values, ival, show_inside )
+int *tess;
+int *null_vals;
+float *values;
+float *ival;
+int *show_inside;
+{
+  double dblval;
+  dblval= *ival;
+  if (*null_vals) values= (float *)0;
+  return( pg_rand_isosurf_tess( *tess, values, dblval, *show_inside ) );
+}
+
+int prntds( tess )
+int *tess;
+{
+  return( pg_rand_tess_destroy( *tess ) );
+}
+
 int pirzsf( vtxtype, zdata, valdata, nx, ny, xyfun, null_tfun, tstfun )
 int *vtxtype;
 float *zdata, *valdata;
@@ -725,6 +826,71 @@ int *show_inside;
 			   coordfun, *show_inside, 1 ) );
 }
 
+int pirzsc( vtxtype, zdata, valdata, nx, ny, coordtype, xcoords, ycoords,
+	   null_tfun, tstfun )
+int *vtxtype;
+float *zdata, *valdata;
+int *nx, *ny;
+int *coordtype;
+float *xcoords, *ycoords;
+int *null_tfun;
+void (*tstfun)();
+{
+  if (*null_tfun) tstfun = 0;
+  return( pg_irreg_zsurf_coords( *vtxtype, zdata, valdata, *nx, *ny, 
+				*coordtype, xcoords, ycoords, tstfun, 1 ) );
+}
+
+int pirzsb( vtxtype, zdata, valdata, nx, ny, batchfun, null_tfun, tstfun )
+int *vtxtype;
+float *zdata, *valdata;
+int *nx, *ny;
+void (*batchfun)();
+int *null_tfun;
+void (*tstfun)();
+{
+  if (*null_tfun) tstfun = 0;
+  return( pg_irreg_zsurf_batch( *vtxtype, zdata, valdata, *nx, *ny, 
+			       batchfun, tstfun, 1 ) );
+}
+
+int pirisc( type, data, valdata, nx, ny, nz, value, coordtype, 
+	   xcoords, ycoords, zcoords, show_inside )
+int *type;
+float *data;
+float *valdata;
+int *nx;
+int *ny;
+int *nz;
+float *value;
+int *coordtype;
+float *xcoords, *ycoords, *zcoords;
+int *show_inside;
+{
+  double dblval;
+  dblval= *value;
+  return( pg_irreg_isosurf_coords( *type, data, valdata, *nx, *ny, *nz, 
+				  dblval, *coordtype, xcoords, ycoords, 
+				  zcoords, *show_inside, 1 ) );
+}
+
+int pirisb( type, data, valdata, nx, ny, nz, value, batchfun, show_inside )
+int *type;
+float *data;
+float *valdata;
+int *nx;
+int *ny;
+int *nz;
+float *value;
+void (*batchfun)();
+int *show_inside;
+{
+  double dblval;
+  dblval= *value;
+  return( pg_irreg_isosurf_batch( *type, data, valdata, *nx, *ny, *nz, 
+				 dblval, batchfun, *show_inside, 1 ) );
+}
+
 int ptbmol( vtxtype, ctype, npts, coords, colors, cross, bres, cres )
 int *vtxtype;
 int *ctype;
@@ -829,6 +995,23 @@ int *vertices;
 		  vertices, facet_lengths, *nfacets) );
 }
 
+int pdmesh( vtxtype, ctype, npts, coords, colors, normals, nfacets,
+	  facet_lengths, vertices, target, maxerr )
+int *vtxtype;
+int *ctype;
+int *npts;
+float *coords, *colors, *normals;
+int *nfacets;
+int *facet_lengths;
+int *vertices;
+int *target;
+float *maxerr;
+{
+  return( pg_decimated_mesh( 
+	     po_create_mvlist(*vtxtype, *npts, coords, colors, normals),
+	     vertices, facet_lengths, *nfacets, *target, (double)*maxerr ) );
+}
+
 int pbezp( vtxtype, ctype, coords, colors, normals )
 int *vtxtype;
 int *ctype;
@@ -953,6 +1136,13 @@ DEFSTRINGLENGTH3
   return( pg_snap( modelstr, lightstr, camstr ) );
 }
 
+int pldp3d( path STRINGLENGTH )
+string_descriptor path;
+DEFSTRINGLENGTH
+{
+  return( pg_load_p3d( getstring(path STRINGLENGTH) ) );
+}
+
 int pstcmp(min, max, fun)
 float *min;
 float *max;
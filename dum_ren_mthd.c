@@ -54,16 +54,6 @@ Sorry, renderer type 'xpainter' not installed;  using 'p3d' instead.");
 }
 #endif
 
-#ifndef INCL_PVM
-P_Renderer *po_create_pvm_renderer( char *device, char *datastr )
-{
-  ger_debug("dum_ren_mthd: po_create_pvm_renderer:");
-  ger_error("dum_ren_mthd: po_create_pvm_renderer: \n\
-Sorry, renderer type 'pvm' not installed;  using 'p3d' instead.");
-  return( po_create_p3d_renderer( device, datastr ) );
-}
-#endif
-
 #ifndef INCL_IV
 P_Renderer *po_create_iv_renderer( char *device, char *datastr )
 {
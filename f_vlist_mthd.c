@@ -584,6 +584,21 @@ P_Vlist *po_create_fvlist( int type, int length,
   thislist->print= printfun;
   thislist->destroy_self= f_destroy;
 
+  /* Every component is its own array in the caller's memory */
+  po_clear_vlist_view(thislist);
+  po_set_vlist_view(thislist, P3D_VX, 1, thisdata->x, 1);
+  po_set_vlist_view(thislist, P3D_VY, 1, thisdata->y, 1);
+  po_set_vlist_view(thislist, P3D_VZ, 1, thisdata->z, 1);
+  po_set_vlist_view(thislist, P3D_VNX, 1, thisdata->nx, 1);
+  po_set_vlist_view(thislist, P3D_VNY, 1, thisdata->ny, 1);
+  po_set_vlist_view(thislist, P3D_VNZ, 1, thisdata->nz, 1);
+  po_set_vlist_view(thislist, P3D_VR, 1, thisdata->r, 1);
+  po_set_vlist_view(thislist, P3D_VG, 1, thisdata->g, 1);
+  po_set_vlist_view(thislist, P3D_VB, 1, thisdata->b, 1);
+  po_set_vlist_view(thislist, P3D_VA, 1, thisdata->a, 1);
+  po_set_vlist_view(thislist, P3D_VV, 1, thisdata->v, 1);
+  po_set_vlist_view(thislist, P3D_VV2, 1, thisdata->v2, 1);
+
   return( thislist );
 }
 
@@ -64,6 +64,7 @@ lower case and end in an underscore.
 #define pplygn pplygn_
 #define ptrist ptrist_
 #define pmesh  pmesh_
+#define pdmesh pdmesh_
 #define pbezp  pbezp_
 #define ptext  ptext_
 #define plight plight_
@@ -73,11 +74,23 @@ lower case and end in an underscore.
 #define paxis  paxis_
 #define pbndbx pbndbx_
 #define pisosf pisosf_
+#define pisotp pisotp_
+#define pgrdcc pgrdcc_
+#define pdecim pdecim_
+#define pzadpt pzadpt_
 #define pzsurf pzsurf_
+#define pzsfmk pzsfmk_
 #define prnzsf prnzsf_
 #define prniso prniso_
+#define prntcr prntcr_
+#define prntis prntis_
+#define prntds prntds_
 #define pirzsf pirzsf_
 #define piriso piriso_
+#define pirisc pirisc_
+#define pirisb pirisb_
+#define pirzsc pirzsc_
+#define pirzsb pirzsb_
 #define ptbmol ptbmol_
 
 /* Camera */
@@ -88,6 +101,9 @@ lower case and end in an underscore.
 /* Snap */
 #define psnap psnap_
 
+/* Loading saved scenes */
+#define pldp3d pldp3d_
+
 /* Color map */
 #define pstcmp pstcmp_
 #define psdcmp psdcmp_
@@ -0,0 +1,234 @@
+/****************************************************************************
+ * geomhash.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module provides a hash table of geometry which has been written
+to the current output file.  A renderer computes a content hash for
+each piece of cached geometry when it is defined, using gh_hash_bytes.
+When the geometry is rendered the renderer calls gh_find with that
+hash, a short key describing any renderer state (material, backface
+culling and so on) which affects how the geometry is written, and the
+geometry itself.  If an entry with the same key and the same contents
+is present its id is returned, and the renderer can write a reference
+to the copy already in the file.  Otherwise gh_add assigns a new id.
+
+Entries point at the caller's geometry rather than copying it, so the
+table must be cleared with gh_clear before any of that geometry might
+be freed, typically when the output file is closed.  The table never
+grows;  once it is three quarters full gh_add refuses new entries and
+returns -1, and the geometry is simply written out in full.
+
+The file-based renderers share their cached vertex list, mesh and torus
+types, so the hashing and comparison of those is done here too.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ge_error.h"
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "assist.h"
+#include "iv_ren_mthd.h"
+#include "geomhash.h"
+
+#define FNV_PRIME 16777619UL
+
+unsigned long gh_hash_bytes( unsigned long hash, void *data, long nbytes )
+/* This routine adds the given bytes to a 32 bit FNV-1a hash */
+{
+  unsigned char *here= (unsigned char *)data;
+  unsigned char *end= here + nbytes;
+
+  while (here<end) {
+    hash ^= *here++;
+    hash= (hash * FNV_PRIME) & 0xffffffffUL;
+  }
+  return hash;
+}
+
+Gh_Table *gh_create( int size )
+/* This routine creates a table with room for about 3/4 of size entries */
+{
+  Gh_Table *result;
+  int nslots= 16;
+  int i;
+
+  while (nslots<size) nslots *= 2;
+
+  if ( !(result= (Gh_Table *)malloc(sizeof(Gh_Table))) )
+    ger_fatal("gh_create: unable to allocate %d bytes!", sizeof(Gh_Table));
+  if ( !(result->entries= (Gh_Entry *)malloc(nslots*sizeof(Gh_Entry))) )
+    ger_fatal("gh_create: unable to allocate %d bytes!",
+	      nslots*sizeof(Gh_Entry));
+  result->size= nslots;
+  result->count= 0;
+  for (i=0; i<nslots; i++) result->entries[i].id= -1;
+
+  return result;
+}
+
+static Gh_Entry *probe( Gh_Table *table, unsigned long hash, void *key,
+			int keylen, void *data, int (*same)(void *, void *) )
+/* This routine returns the entry matching the given geometry, or the
+ * empty slot where it belongs.
+ */
+{
+  unsigned long mask= table->size - 1;
+  unsigned long slot= hash & mask;
+  Gh_Entry *entry;
+
+  while (1) {
+    entry= table->entries + slot;
+    if (entry->id<0) return entry;
+    if (entry->hash==hash && entry->keylen==keylen
+	&& !memcmp(entry->key, key, keylen)
+	&& (entry->data==data || (same && (*same)(entry->data, data))))
+      return entry;
+    slot= (slot+1) & mask;
+  }
+}
+
+int gh_find( Gh_Table *table, unsigned long hash, void *key,
+	     int keylen, void *data, int (*same)(void *, void *) )
+/* This routine returns the id of matching geometry, or -1 if there is
+ * none.  same() compares the contents of two pieces of geometry which
+ * have the same hash and key.
+ */
+{
+  if (keylen>GH_KEY_BYTES) {
+    ger_error("gh_find: key of %d bytes is too long", keylen);
+    return -1;
+  }
+  hash= gh_hash_bytes(hash, key, keylen);
+  return probe(table, hash, key, keylen, data, same)->id;
+}
+
+int gh_add( Gh_Table *table, unsigned long hash, void *key,
+	    int keylen, void *data )
+/* This routine enters geometry which gh_find did not find, returning
+ * its new id, or -1 if the table is full.
+ */
+{
+  Gh_Entry *entry;
+
+  if (keylen>GH_KEY_BYTES) {
+    ger_error("gh_add: key of %d bytes is too long", keylen);
+    return -1;
+  }
+  if (4*(table->count+1) > 3*table->size) return -1;
+
+  hash= gh_hash_bytes(hash, key, keylen);
+  entry= probe(table, hash, key, keylen, data, NULL);
+  if (entry->id<0) {
+    entry->hash= hash;
+    entry->id= table->count++;
+    entry->keylen= keylen;
+    memcpy(entry->key, key, keylen);
+    entry->data= data;
+  }
+  return entry->id;
+}
+
+void gh_clear( Gh_Table *table )
+/* This routine removes all entries, and starts ids over from 0 */
+{
+  int i;
+
+  if (table->count) {
+    for (i=0; i<table->size; i++) table->entries[i].id= -1;
+    table->count= 0;
+  }
+}
+
+void gh_destroy( Gh_Table *table )
+/* This routine frees the table */
+{
+  free( (void *)table->entries );
+  free( (void *)table );
+}
+
+void gh_hash_vlist( P_Cached_Vlist *vlist )
+/* This routine sets the content hash of a cached vertex list */
+{
+  int n= vlist->length;
+
+  vlist->hash= gh_hash_bytes(GH_HASH_SEED,&(vlist->type),sizeof(int));
+  vlist->hash= gh_hash_bytes(vlist->hash,vlist->coords,3*n*sizeof(float));
+  if (vlist->colors) {
+    vlist->hash= gh_hash_bytes(vlist->hash,vlist->colors,3*n*sizeof(float));
+    vlist->hash= gh_hash_bytes(vlist->hash,vlist->opacities,n*sizeof(float));
+  }
+  if (vlist->normals)
+    vlist->hash= gh_hash_bytes(vlist->hash,vlist->normals,3*n*sizeof(float));
+}
+
+void gh_hash_mesh( P_Cached_Mesh *mesh )
+/* This routine sets the content hash of a cached mesh, whose vertex
+ * list must already be hashed.
+ */
+{
+  mesh->hash= gh_hash_bytes(mesh->cached_vlist->hash,&(mesh->stripped),
+			    sizeof(int));
+  mesh->hash= gh_hash_bytes(mesh->hash,mesh->facet_lengths,
+			    mesh->nfacets*sizeof(int));
+  mesh->hash= gh_hash_bytes(mesh->hash,mesh->indices,
+			    mesh->nindices*sizeof(int));
+}
+
+unsigned long gh_hash_torus( P_Cached_Torus *torus )
+/* This routine returns the content hash of a cached torus */
+{
+  return gh_hash_bytes(GH_HASH_SEED,torus,sizeof(P_Cached_Torus));
+}
+
+int gh_same_vlist( void *data1, void *data2 )
+/* This routine compares the contents of two cached vertex lists */
+{
+  P_Cached_Vlist *v1= (P_Cached_Vlist *)data1, *v2= (P_Cached_Vlist *)data2;
+  int n= v1->length;
+
+  if (v1->type != v2->type || v1->length != v2->length) return 0;
+  if (memcmp(v1->coords,v2->coords,3*n*sizeof(float))) return 0;
+  if (v1->colors
+      && (memcmp(v1->colors,v2->colors,3*n*sizeof(float))
+	  || memcmp(v1->opacities,v2->opacities,n*sizeof(float))))
+    return 0;
+  if (v1->normals && memcmp(v1->normals,v2->normals,3*n*sizeof(float)))
+    return 0;
+  return 1;
+}
+
+int gh_same_mesh( void *data1, void *data2 )
+/* This routine compares the contents of two cached meshes */
+{
+  P_Cached_Mesh *m1= (P_Cached_Mesh *)data1, *m2= (P_Cached_Mesh *)data2;
+
+  if (m1->stripped != m2->stripped || m1->nfacets != m2->nfacets
+      || m1->nindices != m2->nindices) return 0;
+  if (memcmp(m1->facet_lengths,m2->facet_lengths,m1->nfacets*sizeof(int))
+      || memcmp(m1->indices,m2->indices,m1->nindices*sizeof(int)))
+    return 0;
+  return gh_same_vlist(m1->cached_vlist,m2->cached_vlist);
+}
+
+int gh_same_torus( void *data1, void *data2 )
+/* This routine compares two cached tori */
+{
+  P_Cached_Torus *t1= (P_Cached_Torus *)data1, *t2= (P_Cached_Torus *)data2;
+
+  return (t1->major == t2->major && t1->minor == t2->minor);
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+ * geomhash.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for geomhash.c, a bounded hash table
+which the file-based renderers use to find geometry they have already
+written to the current file, so that it can be referenced rather than
+written again.
+*/
+
+#ifndef INCL_GEOMHASH_H
+#define INCL_GEOMHASH_H
+
+/* Starting value for gh_hash_bytes */
+#define GH_HASH_SEED 2166136261UL
+
+/* Longest renderer state key which a table entry can hold */
+#define GH_KEY_BYTES 32
+
+typedef struct gh_entry_struct {
+  unsigned long hash;
+  int id;                       /* -1 if this slot is empty */
+  int keylen;
+  char key[GH_KEY_BYTES];       /* renderer state the output depends on */
+  void *data;                   /* the cached geometry itself */
+} Gh_Entry;
+
+typedef struct gh_table_struct {
+  int size;                     /* number of slots, a power of 2 */
+  int count;
+  Gh_Entry *entries;
+} Gh_Table;
+
+extern unsigned long gh_hash_bytes( unsigned long hash, void *data,
+				    long nbytes );
+extern Gh_Table *gh_create( int size );
+extern int gh_find( Gh_Table *table, unsigned long hash, void *key,
+		    int keylen, void *data, int (*same)(void *, void *) );
+extern int gh_add( Gh_Table *table, unsigned long hash, void *key,
+		   int keylen, void *data );
+extern void gh_clear( Gh_Table *table );
+extern void gh_destroy( Gh_Table *table );
+
+/* Hashing and comparison of the cached geometry of the VRML and Open
+ * Inventor renderers, whose types are in iv_ren_mthd.h.  The gh_same_
+ * routines are suitable for gh_find.
+ */
+struct vlist_cache_struct;
+struct mesh_cache_struct;
+struct torus_cache_struct;
+extern void gh_hash_vlist( struct vlist_cache_struct *vlist );
+extern void gh_hash_mesh( struct mesh_cache_struct *mesh );
+extern unsigned long gh_hash_torus( struct torus_cache_struct *torus );
+extern int gh_same_vlist( void *data1, void *data2 );
+extern int gh_same_mesh( void *data1, void *data2 );
+extern int gh_same_torus( void *data1, void *data2 );
+
+#endif /* INCL_GEOMHASH_H */
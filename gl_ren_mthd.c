@@ -28,6 +28,7 @@ This module provides renderer methods for the OpenGL/IRIS gl renderer
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <X11/Intrinsic.h>
 #include "X11/Xlib.h"
 #include "X11/Xutil.h"
@@ -37,6 +38,13 @@ This module provides renderer methods for the OpenGL/IRIS gl renderer
 #include <GL/glx.h>
 #include <X11/StringDefs.h>
 #include <X11/Shell.h>
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
 #else
 #include <gl/glws.h>
 #include <gl/gl.h>
@@ -55,26 +63,36 @@ This module provides renderer methods for the OpenGL/IRIS gl renderer
 
 #include "indent.h"
 #include "gl_strct.h"
+#include "stripify.h"
+#include "bgwrite.h"
 
 #ifdef WIREGL
 #include "wiregl_papi.h"
 #endif
 
 /*
- * Mesh stripping control.  If STRIP_MESHES is non-zero, an attempt will
- * be made to convert meshes consisting entirely of triangle strips to
- * meshes.  The search for strip "neighbors" will be STRIP_PATIENCE
- * triangles wide, and the stripped mesh will be used rather than
- * the original mesh if the number of strips (including length 1) is
- * STRIP_BENEFIT * (original triangle count) or less.
+ * Mesh stripping control.  If STRIP_MESHES is non-zero, meshes consisting
+ * entirely of triangles will be converted to triangle strips by
+ * strip_mesh(), which uses the stripped mesh only if the number of strips
+ * (including length 1) is STRIP_BENEFIT * (original triangle count) or less.
  *
- * Stripping is time consuming, but it can greatly improve rendering speed.
+ * Stripping costs some time at definition, but it can greatly improve
+ * rendering speed.
  */
 #ifndef STRIP_MESHES
 #define STRIP_MESHES 1
 #endif
-#define STRIP_PATIENCE 10000
-#define STRIP_BENEFIT 0.5
+
+/*
+ * Vertex buffer control.  If VBO_MESHES is non-zero and the GL supports
+ * vertex buffer objects (OpenGL 1.5, or GL_ARB_vertex_buffer_object),
+ * the cached vertex lists and mesh indices are copied into buffer
+ * objects, so that they do not cross the API again on every frame.
+ * Otherwise they are drawn from client-side vertex arrays.
+ */
+#ifndef VBO_MESHES
+#define VBO_MESHES 1
+#endif
 
 /* Used only with Chromium, but it's easier to define it generally */
 #define BARRIER_BASE 100
@@ -152,6 +170,52 @@ static void dummyBarrierExec( GLuint i )
 static void dummyBarrierDestroy( GLuint i )
 { ger_error("glBarrierDestroyCR is not loaded!\n"); }
 
+#ifdef USE_OPENGL
+/* The buffer object entry points are past OpenGL 1.1, so we load
+ * them at run time as well.  They serve both for vertex buffers and
+ * for the pixel buffers used in offscreen readback.
+ */
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER         0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW          0x88E4
+#define GL_READ_ONLY            0x88B8
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER    0x88EB
+#define GL_STREAM_READ          0x88E1
+#endif
+typedef void (*glGenBuffersProc)( GLsizei n, GLuint *buffers );
+typedef void (*glDeleteBuffersProc)( GLsizei n, const GLuint *buffers );
+typedef void (*glBindBufferProc)( GLenum target, GLuint buffer );
+typedef void (*glBufferDataProc)( GLenum target, ptrdiff_t size,
+				  const GLvoid *data, GLenum usage );
+typedef GLvoid* (*glMapBufferProc)( GLenum target, GLenum access );
+typedef GLboolean (*glUnmapBufferProc)( GLenum target );
+#define LOAD_VBO( x, suffix ) \
+  gl##x##VBO = (gl##x##Proc) gl_proc_address( "gl"#x suffix )
+static glGenBuffersProc    glGenBuffersVBO    = NULL;
+static glDeleteBuffersProc glDeleteBuffersVBO = NULL;
+static glBindBufferProc    glBindBufferVBO    = NULL;
+static glBufferDataProc    glBufferDataVBO    = NULL;
+static glMapBufferProc     glMapBufferVBO     = NULL;
+static glUnmapBufferProc   glUnmapBufferVBO   = NULL;
+
+typedef void (*glProc)( void );
+static glProc gl_proc_address( char *name )
+{
+  /* Offscreen contexts come from EGL, which has its own loader */
+#ifdef USE_EGL
+  if (eglGetCurrentContext() != EGL_NO_CONTEXT)
+    return (glProc)eglGetProcAddress(name);
+#endif
+  return (glProc)glXGetProcAddressARB((const GLubyte *)name);
+}
+
+/* Byte offset into the currently bound buffer object */
+#define VBO_OFFSET( n ) ((char *)NULL + (n))
+#endif
+
 #define GLPROF(x)
 
 #define BLACKPATTERN 0
@@ -304,8 +368,15 @@ static void init_chromium_hooks()
 #endif /* USE_OPENGL */
 }
 
-static int chromium_in_use()
+static int chromium_in_use( P_Renderer* self )
 {
+#ifdef USE_OPENGL
+  /* An offscreen renderer never draws through Chromium.  This matters
+   * because some GL libraries return a stub for any name at all from
+   * glXGetProcAddressARB.
+   */
+  if (OFFSCREEN(self)) return 0;
+#endif
   if (glBarrierCreateCR == NULL) /* not initialized */
     init_chromium_hooks();
   return (glCreateContextCR != NULL);
@@ -331,7 +402,12 @@ static void get_drawing_area( P_Renderer* self,
   unsigned int depth;
   Window root;
   Status s;
-  if (MANAGE(self) && !chromium_in_use()) {
+  if (OFFSCREEN(self)) {
+    *x_corner= *y_corner= 0;
+    *width= OFF_WIDTH(self);
+    *height= OFF_HEIGHT(self);
+  }
+  else if (MANAGE(self) && !chromium_in_use(self)) {
     s= XGetGeometry(XDISPLAY(self),XWINDOW(self),&root,x_corner,y_corner,
 		    width,height, &border_width, &depth);
     if (s != True) ger_fatal("Error: XGetGeometry failed!\n");
@@ -357,7 +433,14 @@ static void set_drawing_window( P_Renderer* self )
 #if defined(WIREGL)
   wireGLMakeCurrent();
 #else
-  if (chromium_in_use()) {
+  if (OFFSCREEN(self)) {
+#ifdef USE_EGL
+    if (eglMakeCurrent(EGLDISPLAY(self), EGLSURFACE(self), EGLSURFACE(self),
+		       EGLCONTEXT(self)) != EGL_TRUE)
+      ger_error("Error: set_drawing_window: unable to set EGL context!\n");
+#endif
+  }
+  else if (chromium_in_use(self)) {
     glMakeCurrentCR(XWINDOW(self), CRCONTEXT(self));
   }
   else {
@@ -394,7 +477,7 @@ static void attach_drawing_window( P_Renderer* self )
   wireGLMakeCurrent();
   if (NPROCS(self)>1) glBarrierCreate(BARRIER(self), NPROCS(self));
 #else
-  if (chromium_in_use()) {
+  if (chromium_in_use(self)) {
     /* We're in a Chromium universe */
     XWINDOW(self)= glXGetCurrentDrawable();
     
@@ -492,7 +575,7 @@ static void create_drawing_window( P_Renderer* self, char* size_info )
   GLXCONTEXT(self)= NULL;
   if (NPROCS(self)>1) glBarrierCreate(BARRIER(self), NPROCS(self));
 #else
-  if (chromium_in_use()) {
+  if (chromium_in_use(self)) {
     /* We're in a Chromium universe */
     
     CRCONTEXT(self) = 
@@ -595,6 +678,291 @@ static void create_drawing_window( P_Renderer* self, char* size_info )
 #endif
 }
 
+#ifdef USE_OPENGL
+#ifdef USE_EGL
+/* Offscreen renderers in one process all get the same EGL display, and
+ * eglTerminate would take every renderer's context with it, so the
+ * display is terminated only when the last of them is destroyed.
+ */
+static int egl_display_users= 0;
+#endif
+
+static void create_offscreen_context( P_Renderer* self, char* size_info )
+{
+  /* This renders into an EGL pbuffer, so no display is needed */
+  int x, y;
+  unsigned int width= 512;
+  unsigned int height= 512;
+#ifdef USE_EGL
+  static EGLint config_attrs[]= {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+    EGL_DEPTH_SIZE, 16,
+    EGL_NONE
+  };
+  EGLint surface_attrs[5];
+  EGLConfig config;
+  EGLint nconfigs;
+  EGLint major, minor;
+  const char* extensions;
+#endif
+
+  if (size_info) XParseGeometry(size_info, &x, &y, &width, &height);
+  OFF_WIDTH(self)= width;
+  OFF_HEIGHT(self)= height;
+  XDISPLAY(self)= NULL;
+  XWINDOW(self)= 0;
+  GLXCONTEXT(self)= NULL;
+
+#ifdef USE_EGL
+  /* Mesa's surfaceless platform needs neither a display nor a device */
+  EGLDISPLAY(self)= EGL_NO_DISPLAY;
+  extensions= eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (extensions && strstr(extensions,"EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display=
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+      eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display)
+      EGLDISPLAY(self)= (*get_platform_display)(EGL_PLATFORM_SURFACELESS_MESA,
+						EGL_DEFAULT_DISPLAY, NULL);
+  }
+  if (EGLDISPLAY(self) == EGL_NO_DISPLAY)
+    EGLDISPLAY(self)= eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (EGLDISPLAY(self) == EGL_NO_DISPLAY
+      || !eglInitialize(EGLDISPLAY(self), &major, &minor))
+    ger_fatal("create_offscreen_context: unable to initialize EGL!");
+  egl_display_users++;
+  ger_debug("create_offscreen_context: EGL version %d.%d", major, minor);
+
+  if (!eglChooseConfig(EGLDISPLAY(self), config_attrs, &config, 1, &nconfigs)
+      || nconfigs < 1)
+    ger_fatal("create_offscreen_context: unable to get a reasonable config!");
+  if (!eglBindAPI(EGL_OPENGL_API))
+    ger_fatal("create_offscreen_context: EGL does not support OpenGL!");
+
+  surface_attrs[0]= EGL_WIDTH;
+  surface_attrs[1]= width;
+  surface_attrs[2]= EGL_HEIGHT;
+  surface_attrs[3]= height;
+  surface_attrs[4]= EGL_NONE;
+  EGLSURFACE(self)= eglCreatePbufferSurface(EGLDISPLAY(self), config, 
+					    surface_attrs);
+  if (EGLSURFACE(self) == EGL_NO_SURFACE)
+    ger_fatal("create_offscreen_context: unable to make a %dx%d pbuffer!",
+	      width, height);
+  EGLCONTEXT(self)= eglCreateContext(EGLDISPLAY(self), config, 
+				     EGL_NO_CONTEXT, NULL);
+  if (EGLCONTEXT(self) == EGL_NO_CONTEXT)
+    ger_fatal("create_offscreen_context: unable to make a GL context!");
+#else
+  ger_fatal("create_offscreen_context: this GL renderer was built without EGL, so it cannot render offscreen!");
+#endif
+}
+
+static char* generate_fname(P_Renderer *self)
+{
+  /* This routine generates numbered fnames */
+
+  char* result;
+  int len;
+  int has_index_field= P3D_FALSE;
+  int index_field_start= 0;
+  int index_field_length= 0;
+  char* runner;
+
+  ger_debug("gl_ren_mthd: generate_fname");
+
+  len = strlen(OUTFILE(self));
+  if ( !(result= (char*)malloc(len+32)) )
+    ger_fatal("gl_ren_mthd: generate_fname: unable to allocate %d bytes!",
+	      len+32);
+
+  /* Scan for a field like "####" to put the image index in */
+  for (runner= OUTFILE(self); *runner; runner++) {
+    if (*runner=='#') {
+      if (!has_index_field) index_field_start= runner - OUTFILE(self);
+      has_index_field= P3D_TRUE;
+      index_field_length++;
+    }
+    else if (has_index_field) break;
+  }
+  if (index_field_length>10) index_field_length= 10;
+
+  if (has_index_field) {
+    char format[32];
+    if (index_field_start) strncpy(result,OUTFILE(self),index_field_start);
+    sprintf(format,"%%.%dd",index_field_length);
+    sprintf(result+index_field_start,format,FILENUM(self));
+    strcat(result+index_field_start+index_field_length,
+	   OUTFILE(self)+index_field_start+index_field_length);
+  }
+  else if (FILENUM(self)) {
+    /* Find the file extension */
+    int has_extension= P3D_FALSE;
+    int ext_offset= 0;
+    int ext_len= 0;
+
+    runner= OUTFILE(self)+len-1; /* end of string */
+    while ((runner > OUTFILE(self)) && (*runner != '/')) {
+      if (*runner=='.') {
+	has_extension= P3D_TRUE;
+	ext_offset= runner-OUTFILE(self);
+	ext_len= len - ext_offset;
+	break;
+      }
+      runner--;
+    }
+    if (has_extension) {
+      strncpy(result, OUTFILE(self), ext_offset+1);
+      sprintf(result+ext_offset+1,"%.4d",FILENUM(self));
+      strncat(result, OUTFILE(self)+ext_offset,ext_len);
+    }
+    else {
+      strcpy(result, OUTFILE(self));
+      sprintf(result+len,".%.4d",FILENUM(self));
+    }
+  }
+  else strcpy(result, OUTFILE(self));
+
+  return result;
+}
+
+static void write_image( P_Renderer* self, unsigned char* rgba )
+{
+  /* This writes one offscreen frame as a binary PPM.  GL rows run
+   * bottom to top, so they are written in reverse.
+   */
+  FILE* fp;
+  char* fname= NULL;
+  unsigned char* row;
+  unsigned char* in;
+  int width= OFF_WIDTH(self);
+  int height= OFF_HEIGHT(self);
+  int i, j;
+
+  if (!strcmp(OUTFILE(self),"-")) fp= stdout;
+  else {
+    fname= generate_fname(self);
+    if ( !(fp= bgw_fopen(fname,"wb",0)) ) {
+      perror("gl_ren_mthd");
+      ger_fatal("gl_ren_mthd: write_image: Error opening file <%s> for writing.",
+		fname);
+    }
+  }
+  if ( !(row= (unsigned char*)malloc(3*width)) )
+    ger_fatal("gl_ren_mthd: write_image: unable to allocate %d bytes!",
+	      3*width);
+
+  fprintf(fp,"P6\n%d %d\n255\n",width,height);
+  for (j=height-1; j>=0; j--) {
+    in= rgba + 4*width*j;
+    for (i=0; i<width; i++) {
+      row[3*i]= in[4*i];
+      row[3*i+1]= in[4*i+1];
+      row[3*i+2]= in[4*i+2];
+    }
+    if (fwrite(row, 3, width, fp) != (size_t)width) {
+      perror("gl_ren_mthd: write_image:");
+      ger_fatal("gl_ren_mthd: write_image: Error writing file <%s>.",
+		fname ? fname : "stdout");
+    }
+  }
+  free( (P_Void_ptr)row );
+
+  if (fp == stdout) {
+    if (fflush(fp) == EOF) {
+      perror("gl_ren_mthd: write_image:");
+      ger_fatal("gl_ren_mthd: write_image: Error writing file <stdout>.");
+    }
+  }
+  else {
+    if ( fclose(fp) == EOF ) {
+      perror("gl_ren_mthd: write_image:");
+      ger_fatal("gl_ren_mthd: write_image: Error closing file <%s>.",
+		fname);
+    }
+    free( (P_Void_ptr)fname );
+  }
+  FILENUM(self)++;
+}
+
+static void write_pending_frame( P_Renderer* self )
+{
+  /* This writes out the frame waiting in a pixel buffer, if any */
+  unsigned char* rgba;
+
+  if (!PENDING_PBO(self)) return;
+  glBindBufferVBO(GL_PIXEL_PACK_BUFFER, PBO(self)[PENDING_PBO(self)-1]);
+  if ((rgba= (unsigned char*)glMapBufferVBO(GL_PIXEL_PACK_BUFFER, 
+					    GL_READ_ONLY))) {
+    write_image(self, rgba);
+    glUnmapBufferVBO(GL_PIXEL_PACK_BUFFER);
+  }
+  else ger_error("gl_ren_mthd: write_pending_frame: unable to map pixel buffer!");
+  glBindBufferVBO(GL_PIXEL_PACK_BUFFER, 0);
+  PENDING_PBO(self)= 0;
+}
+
+static void read_back_frame( P_Renderer* self )
+{
+  /* This starts the readback of a finished offscreen frame.  With pixel
+   * buffer objects the read goes into one of a pair of buffers and
+   * returns at once, and it is the previous frame which gets written,
+   * so the transfer overlaps the drawing of the next frame.  Otherwise
+   * the frame is read and written immediately.
+   */
+  int nbytes= 4*OFF_WIDTH(self)*OFF_HEIGHT(self);
+  int next;
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  if (PBO_OK(self)) {
+    if (!PBO(self)[0]) {
+      glGenBuffersVBO(2, PBO(self));
+      for (next=0; next<2; next++) {
+	glBindBufferVBO(GL_PIXEL_PACK_BUFFER, PBO(self)[next]);
+	glBufferDataVBO(GL_PIXEL_PACK_BUFFER, nbytes, NULL, GL_STREAM_READ);
+      }
+    }
+    next= (PENDING_PBO(self) == 1) ? 1 : 0;
+    glBindBufferVBO(GL_PIXEL_PACK_BUFFER, PBO(self)[next]);
+    glReadPixels(0, 0, OFF_WIDTH(self), OFF_HEIGHT(self), 
+		 GL_RGBA, GL_UNSIGNED_BYTE, VBO_OFFSET(0));
+    glBindBufferVBO(GL_PIXEL_PACK_BUFFER, 0);
+    write_pending_frame(self);
+    PENDING_PBO(self)= next+1;
+  }
+  else {
+    if (!PIXELS(self) 
+	&& !(PIXELS(self)= (unsigned char*)malloc(nbytes)))
+      ger_fatal("gl_ren_mthd: read_back_frame: unable to allocate %d bytes!",
+		nbytes);
+    glReadPixels(0, 0, OFF_WIDTH(self), OFF_HEIGHT(self), 
+		 GL_RGBA, GL_UNSIGNED_BYTE, PIXELS(self));
+    write_image(self, PIXELS(self));
+  }
+}
+
+static void destroy_offscreen_context( P_Renderer* self )
+{
+  /* The last frame and the pixel buffers belong to this context, which
+   * need not be the current one if there are several renderers.
+   */
+  set_drawing_window(self);
+  write_pending_frame(self);
+  if (PBO(self)[0]) glDeleteBuffersVBO(2, PBO(self));
+  if (PIXELS(self)) free( (P_Void_ptr)PIXELS(self) );
+  bgw_drain();
+#ifdef USE_EGL
+  eglMakeCurrent(EGLDISPLAY(self), EGL_NO_SURFACE, EGL_NO_SURFACE, 
+		 EGL_NO_CONTEXT);
+  eglDestroyContext(EGLDISPLAY(self), EGLCONTEXT(self));
+  eglDestroySurface(EGLDISPLAY(self), EGLSURFACE(self));
+  if (--egl_display_users == 0) eglTerminate(EGLDISPLAY(self));
+#endif
+}
+#endif
+
 static void screen_door_transp( int flag )
 {
 #ifdef USE_OPENGL
@@ -770,59 +1138,56 @@ static P_Cached_Vlist* cache_vlist( P_Renderer *self, P_Vlist *vlist )
     if (result->normals) result->type= P3D_CNVTX;
     else result->type= P3D_CVTX;
   }
+#ifdef USE_OPENGL
+  result->vbo= 0;
+#endif
 
-  for (i=0; i<result->length; i++) {
-    result->coords[3*i]= (*(vlist->x))(i);
-    result->coords[3*i+1]= (*(vlist->y))(i);
-    result->coords[3*i+2]= (*(vlist->z))(i);
-    switch (vlist->type) {
-    case P3D_CVTX:
-      break;
-    case P3D_CNVTX:
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CCVTX:
-      result->colors[4*i]= (*(vlist->r))(i);
-      result->colors[4*i+1]= (*(vlist->g))(i);
-      result->colors[4*i+2]= (*(vlist->b))(i);
-      result->colors[4*i+3]= (*(vlist->a))(i);
-      break;
-    case P3D_CCNVTX:
-      result->colors[4*i]= (*(vlist->r))(i);
-      result->colors[4*i+1]= (*(vlist->g))(i);
-      result->colors[4*i+2]= (*(vlist->b))(i);
-      result->colors[4*i+3]= (*(vlist->a))(i);
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CVVTX:
-    case P3D_CVVVTX:
-      get_rgb_color( self, result->colors+4*i, (*(vlist->v))(i) );
-      break;
-    case P3D_CVNVTX:
-      get_rgb_color( self, result->colors+4*i, (*(vlist->v))(i) );
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-      /* We've already checked that it is a known case */
-    }
+  po_vlist_copy(vlist, P3D_VX, 3, result->coords, 3);
+  switch (vlist->type) {
+  case P3D_CVTX:
+    break;
+  case P3D_CNVTX:
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CCVTX:
+    po_vlist_copy(vlist, P3D_VR, 4, result->colors, 4);
+    break;
+  case P3D_CCNVTX:
+    po_vlist_copy(vlist, P3D_VR, 4, result->colors, 4);
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CVVTX:
+  case P3D_CVVVTX:
+  case P3D_CVNVTX:
+    /* Values go where their colors will be, and are mapped in place */
+    po_vlist_copy(vlist, P3D_VV, 1, result->colors, 4);
+    for (i=0; i<result->length; i++)
+      get_rgb_color( self, result->colors+4*i, result->colors[4*i] );
+    if (vlist->type==P3D_CVNVTX)
+      po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+    /* We've already checked that it is a known case */
   }
 
   return( result );
 }
 
-static void free_cached_vlist( P_Cached_Vlist* cache )
+static void free_cached_vlist( P_Renderer *self, P_Cached_Vlist* cache )
 {
+#ifdef USE_OPENGL
+  if (cache->vbo) {
+    set_drawing_window(self);
+    glDeleteBuffersVBO(1, &(cache->vbo));
+  }
+  if (cache == BOUND_VLIST(self)) BOUND_VLIST(self)= NULL;
+#endif
   if (cache->normals) free( (P_Void_ptr)(cache->normals) );
   if (cache->colors) free( (P_Void_ptr)(cache->colors) );
   free( (P_Void_ptr)cache->coords );
   free( (P_Void_ptr)cache );
 }
 
+#ifndef USE_OPENGL
 static void send_cached_vlist( P_Cached_Vlist* cvlist )
 {
   int i;
@@ -832,51 +1197,31 @@ static void send_cached_vlist( P_Cached_Vlist* cvlist )
   switch(cvlist->type) {
   case P3D_CVTX:
     for (i=0; i<cvlist->length; i++) {
-#ifdef USE_OPENGL
-      glVertex3fv(crd_runner);
-#else
       v3f(crd_runner);
-#endif
       crd_runner += 3;
     }
     break;
   case P3D_CCVTX:
     for (i=0; i<cvlist->length; i++) {
-#ifdef  USE_OPENGL
-      glColor4fv(clr_runner);
-      glVertex3fv(crd_runner);
-#else
       c4f(clr_runner);
       v3f(crd_runner);
-#endif
       clr_runner += 4;
       crd_runner += 3;
     }
     break;
   case P3D_CNVTX:
     for (i=0; i<cvlist->length; i++) {
-#ifdef USE_OPENGL
-      glNormal3fv(nrm_runner);
-      glVertex3fv(crd_runner);
-#else
       n3f(nrm_runner);
       v3f(crd_runner);
-#endif
       nrm_runner += 3;
       crd_runner += 3;
     }
     break;
   case P3D_CCNVTX:
     for (i=0; i<cvlist->length; i++) {
-#ifdef USE_OPENGL
-      glNormal3fv(nrm_runner);
-      glColor4fv(clr_runner);
-      glVertex3fv(crd_runner);
-#else
       n3f(nrm_runner);
       c4f(clr_runner);
       v3f(crd_runner);
-#endif
       nrm_runner += 3;
       clr_runner += 4;
       crd_runner += 3;
@@ -886,6 +1231,380 @@ static void send_cached_vlist( P_Cached_Vlist* cvlist )
     ger_error("gl_ren_mthd: send_cached_vlist: unknown vertex type!");
   }
 }
+#endif
+
+#ifdef USE_OPENGL
+static int gl_has( int major, int minor, char *extension )
+/* This routine returns non-zero if the current GL context is at least
+ * the given version or has the given extension.
+ */
+{
+  const char* version= (const char*)glGetString(GL_VERSION);
+  const char* extensions= (const char*)glGetString(GL_EXTENSIONS);
+  int this_major= 0;
+  int this_minor= 0;
+
+  if (version && sscanf(version,"%d.%d",&this_major,&this_minor) == 2
+      && (this_major > major 
+	  || (this_major == major && this_minor >= minor)))
+    return 1;
+  return( extension && extensions && strstr(extensions,extension) );
+}
+
+static int load_buffer_procs()
+/* This routine returns non-zero if the current GL context supports
+ * buffer objects, loading the entry points if need be.
+ */
+{
+  if (!glGetString(GL_VERSION)) return 0;
+
+  if (gl_has(1, 5, NULL)) {
+    if (!glGenBuffersVBO) LOAD_VBO( GenBuffers, "" );
+    if (!glDeleteBuffersVBO) LOAD_VBO( DeleteBuffers, "" );
+    if (!glBindBufferVBO) LOAD_VBO( BindBuffer, "" );
+    if (!glBufferDataVBO) LOAD_VBO( BufferData, "" );
+    if (!glMapBufferVBO) LOAD_VBO( MapBuffer, "" );
+    if (!glUnmapBufferVBO) LOAD_VBO( UnmapBuffer, "" );
+  }
+  else if (gl_has(1, 5, "GL_ARB_vertex_buffer_object")) {
+    if (!glGenBuffersVBO) LOAD_VBO( GenBuffers, "ARB" );
+    if (!glDeleteBuffersVBO) LOAD_VBO( DeleteBuffers, "ARB" );
+    if (!glBindBufferVBO) LOAD_VBO( BindBuffer, "ARB" );
+    if (!glBufferDataVBO) LOAD_VBO( BufferData, "ARB" );
+    if (!glMapBufferVBO) LOAD_VBO( MapBuffer, "ARB" );
+    if (!glUnmapBufferVBO) LOAD_VBO( UnmapBuffer, "ARB" );
+  }
+  else return 0;
+
+  return( glGenBuffersVBO && glDeleteBuffersVBO && glBindBufferVBO 
+	  && glBufferDataVBO && glMapBufferVBO && glUnmapBufferVBO );
+}
+
+static void load_cached_vlist( P_Renderer *self, P_Cached_Vlist* cvlist )
+/* This routine copies a cached vlist into a buffer object, coords
+ * first, then colors and normals if present.
+ */
+{
+  ptrdiff_t ncoords= 3*cvlist->length*sizeof(float);
+  ptrdiff_t ncolors= (cvlist->colors ? 4*cvlist->length*sizeof(float) : 0);
+  ptrdiff_t nnormals= (cvlist->normals ? 3*cvlist->length*sizeof(float) : 0);
+  char* buf;
+
+  if (cvlist->vbo || !VBO_OK(self)) return;
+
+  if ( !(buf= (char*)malloc(ncoords+ncolors+nnormals)) )
+    ger_fatal("gl_ren_mthd: load_cached_vlist: unable to allocate %d bytes!",
+	      ncoords+ncolors+nnormals);
+  memcpy(buf, cvlist->coords, ncoords);
+  if (ncolors) memcpy(buf+ncoords, cvlist->colors, ncolors);
+  if (nnormals) memcpy(buf+ncoords+ncolors, cvlist->normals, nnormals);
+
+  glGenBuffersVBO(1, &(cvlist->vbo));
+  glBindBufferVBO(GL_ARRAY_BUFFER, cvlist->vbo);
+  glBufferDataVBO(GL_ARRAY_BUFFER, ncoords+ncolors+nnormals, buf,
+		  GL_STATIC_DRAW);
+  glBindBufferVBO(GL_ARRAY_BUFFER, 0);
+  BOUND_VLIST(self)= NULL;
+  free( (P_Void_ptr)buf );
+}
+
+static void load_mesh_indices( P_Renderer *self, gl_gob* it )
+/* This routine copies a mesh's indices into a buffer object */
+{
+  if (it->obj_info.mesh_obj.ibo || !VBO_OK(self)) return;
+
+  glGenBuffersVBO(1, &(it->obj_info.mesh_obj.ibo));
+  glBindBufferVBO(GL_ELEMENT_ARRAY_BUFFER, it->obj_info.mesh_obj.ibo);
+  glBufferDataVBO(GL_ELEMENT_ARRAY_BUFFER, 
+		  it->obj_info.mesh_obj.nindices*sizeof(int),
+		  it->obj_info.mesh_obj.indices, GL_STATIC_DRAW);
+  glBindBufferVBO(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static void load_buffers( P_Renderer *self, gl_gob* it, int is_mesh )
+/* This routine creates the buffer objects for a newly defined gob.
+ * If the GL has not been initialized yet, the first render will
+ * create them instead.
+ */
+{
+  if (!VBO_OK(self)) return;
+  set_drawing_window(self);
+  if (it->cvlist) load_cached_vlist(self, it->cvlist);
+  if (is_mesh) load_mesh_indices(self, it);
+}
+
+static void bind_cached_vlist( P_Renderer *self, P_Cached_Vlist* cvlist )
+/* This routine points the GL vertex arrays at a cached vlist.  A run
+ * of draws from the same vlist, for example the shared sphere, binds
+ * it only once.
+ */
+{
+  char* coords;
+  char* colors;
+  char* normals;
+
+  if (cvlist == BOUND_VLIST(self)) return;
+
+  if (VBO_OK(self) && !cvlist->vbo) load_cached_vlist(self, cvlist);
+  if (cvlist->vbo) {
+    glBindBufferVBO(GL_ARRAY_BUFFER, cvlist->vbo);
+    coords= VBO_OFFSET(0);
+    colors= VBO_OFFSET(3*cvlist->length*sizeof(float));
+    normals= colors + (cvlist->colors ? 4*cvlist->length*sizeof(float) : 0);
+  }
+  else {
+    coords= (char*)cvlist->coords;
+    colors= (char*)cvlist->colors;
+    normals= (char*)cvlist->normals;
+  }
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, coords);
+  if (cvlist->colors) {
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_FLOAT, 0, colors);
+  }
+  else glDisableClientState(GL_COLOR_ARRAY);
+  if (cvlist->normals) {
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, 0, normals);
+  }
+  else glDisableClientState(GL_NORMAL_ARRAY);
+
+  BOUND_VLIST(self)= cvlist;
+}
+
+static void release_vertex_arrays( P_Renderer *self )
+/* This routine restores the default vertex array state at the end of
+ * a frame, in case someone else draws in our context.
+ */
+{
+  if (VBO_OK(self)) {
+    glBindBufferVBO(GL_ARRAY_BUFFER, 0);
+    glBindBufferVBO(GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  BOUND_VLIST(self)= NULL;
+}
+
+static void draw_cached_vlist( P_Renderer *self, P_Cached_Vlist* cvlist, 
+			       GLenum mode )
+{
+  bind_cached_vlist(self, cvlist);
+  glDrawArrays(mode, 0, cvlist->length);
+}
+
+static void draw_mesh( P_Renderer *self, gl_gob* it )
+{
+  int* facet_lengths= it->obj_info.mesh_obj.facet_lengths;
+  int nfacets= it->obj_info.mesh_obj.nfacets;
+  char* indices;
+  int loope;
+
+  bind_cached_vlist(self, it->cvlist);
+  if (VBO_OK(self) && !it->obj_info.mesh_obj.ibo) load_mesh_indices(self, it);
+  if (it->obj_info.mesh_obj.ibo) {
+    glBindBufferVBO(GL_ELEMENT_ARRAY_BUFFER, it->obj_info.mesh_obj.ibo);
+    indices= VBO_OFFSET(0);
+  }
+  else {
+    if (VBO_OK(self)) glBindBufferVBO(GL_ELEMENT_ARRAY_BUFFER, 0);
+    indices= (char*)it->obj_info.mesh_obj.indices;
+  }
+
+  switch (it->obj_info.mesh_obj.type) {
+  case MESH_MIXED:
+    for (loope=0; loope < nfacets; loope++) {
+      glDrawElements(GL_POLYGON, facet_lengths[loope], GL_UNSIGNED_INT, 
+		     indices);
+      indices += facet_lengths[loope]*sizeof(int);
+    }
+    break;
+  case MESH_TRI:
+    glDrawElements(GL_TRIANGLES, 3*nfacets, GL_UNSIGNED_INT, indices);
+    break;
+  case MESH_QUAD:
+    glDrawElements(GL_QUADS, 4*nfacets, GL_UNSIGNED_INT, indices);
+    break;
+  case MESH_STRIP:
+    for (loope=0; loope < nfacets; loope++) {
+      int run;
+      if (facet_lengths[loope]==3) {
+	/* Try to gather up tris */
+	run= 1;
+	while (loope+run<nfacets) {
+	  if (facet_lengths[loope+run]!=3) break;
+	  run++;
+	}
+	glDrawElements(GL_TRIANGLES, 3*run, GL_UNSIGNED_INT, indices);
+	indices += 3*run*sizeof(int);
+	loope+= run-1;
+      }
+      else {
+	/* A real strip */
+	glDrawElements(GL_TRIANGLE_STRIP, facet_lengths[loope], 
+		       GL_UNSIGNED_INT, indices);
+	indices += facet_lengths[loope]*sizeof(int);
+      }
+    }
+    break;
+  }
+}
+
+static gl_gob* build_unit_mesh( P_Renderer *self, float* coords, 
+				float* normals, int nverts, 
+				int* indices, int ntris )
+/* This routine wraps a triangle mesh with normals, as built by
+ * unit_sphere and unit_cylinder, in a gob.  It takes ownership of
+ * the arrays.
+ */
+{
+  gl_gob* it;
+  P_Cached_Vlist* cvlist;
+  int i;
+
+  if ( !(it= (gl_gob *)malloc(sizeof(gl_gob))) )
+    ger_fatal("gl_ren_mthd: build_unit_mesh: unable to allocate %d bytes!",
+	      sizeof(gl_gob));
+  if ( !(cvlist= (P_Cached_Vlist *)malloc(sizeof(P_Cached_Vlist))) )
+    ger_fatal("gl_ren_mthd: build_unit_mesh: unable to allocate %d bytes!",
+	      sizeof(P_Cached_Vlist));
+  if ( !(it->obj_info.mesh_obj.facet_lengths= 
+	 (int*)malloc(ntris*sizeof(int))) )
+    ger_fatal("gl_ren_mthd: build_unit_mesh: unable to allocate %d bytes!",
+	      ntris*sizeof(int));
+
+  cvlist->type= P3D_CNVTX;
+  cvlist->length= nverts;
+  cvlist->coords= coords;
+  cvlist->colors= NULL;
+  cvlist->normals= normals;
+  cvlist->vbo= 0;
+
+  for (i=0; i<ntris; i++) it->obj_info.mesh_obj.facet_lengths[i]= 3;
+  it->obj_info.mesh_obj.indices= indices;
+  it->obj_info.mesh_obj.nfacets= ntris;
+  it->obj_info.mesh_obj.nindices= 3*ntris;
+  it->obj_info.mesh_obj.ibo= 0;
+  it->obj_info.mesh_obj.type= MESH_TRI;
+  it->cvlist= cvlist;
+  it->color_mode= 1;
+
+  load_buffers(self, it, 1);
+  return it;
+}
+
+static gl_gob* unit_sphere( P_Renderer *self )
+/* This routine tessellates the unit sphere shared by all spheres */
+{
+  int nverts= (SPHERE_STACKS+1)*(SPHERE_SLICES+1);
+  int ntris= 2*SPHERE_SLICES*(SPHERE_STACKS-1);
+  float *coords, *normals, *crd, *nrm;
+  int *indices, *idx;
+  int i, j;
+
+  if ( !(coords= (float*)malloc(3*nverts*sizeof(float)))
+       || !(normals= (float*)malloc(3*nverts*sizeof(float)))
+       || !(indices= (int*)malloc(3*ntris*sizeof(int))) )
+    ger_fatal("gl_ren_mthd: unit_sphere: unable to allocate %d bytes!",
+	      3*nverts*sizeof(float));
+
+  crd= coords;
+  nrm= normals;
+  for (i=0; i<=SPHERE_STACKS; i++) {
+    double phi= (PI*i)/SPHERE_STACKS;
+    for (j=0; j<=SPHERE_SLICES; j++) {
+      double theta= (2.0*PI*j)/SPHERE_SLICES;
+      *crd++= *nrm++= sin(phi)*cos(theta);
+      *crd++= *nrm++= sin(phi)*sin(theta);
+      *crd++= *nrm++= cos(phi);
+    }
+  }
+
+  /* The bands at the poles have one triangle per slice */
+  idx= indices;
+  for (i=0; i<SPHERE_STACKS; i++) 
+    for (j=0; j<SPHERE_SLICES; j++) {
+      int a= i*(SPHERE_SLICES+1) + j;
+      int b= a + SPHERE_SLICES + 1;
+      if (i != SPHERE_STACKS-1) {
+	*idx++= a; *idx++= b; *idx++= b+1;
+      }
+      if (i != 0) {
+	*idx++= a; *idx++= b+1; *idx++= a+1;
+      }
+    }
+
+  return build_unit_mesh(self, coords, normals, nverts, indices, ntris);
+}
+
+static gl_gob* unit_cylinder( P_Renderer *self )
+/* This routine tessellates the unit cylinder shared by all cylinders,
+ * running from z=0 to z=1 with both ends capped.
+ */
+{
+  int nside= (CYLINDER_STACKS+1)*(CYLINDER_SLICES+1);
+  int nverts= nside + 2*(CYLINDER_SLICES+2);
+  int ntris= 2*CYLINDER_SLICES*CYLINDER_STACKS + 2*CYLINDER_SLICES;
+  float *coords, *normals, *crd, *nrm;
+  int *indices, *idx;
+  int i, j, end;
+
+  if ( !(coords= (float*)malloc(3*nverts*sizeof(float)))
+       || !(normals= (float*)malloc(3*nverts*sizeof(float)))
+       || !(indices= (int*)malloc(3*ntris*sizeof(int))) )
+    ger_fatal("gl_ren_mthd: unit_cylinder: unable to allocate %d bytes!",
+	      3*nverts*sizeof(float));
+
+  crd= coords;
+  nrm= normals;
+  for (i=0; i<=CYLINDER_STACKS; i++)
+    for (j=0; j<=CYLINDER_SLICES; j++) {
+      double theta= (2.0*PI*j)/CYLINDER_SLICES;
+      *crd++= *nrm++= cos(theta);
+      *crd++= *nrm++= sin(theta);
+      *crd++= ((float)i)/CYLINDER_STACKS;
+      *nrm++= 0.0;
+    }
+  for (end=0; end<2; end++) {
+    /* center, then the rim */
+    for (j=-1; j<=CYLINDER_SLICES; j++) {
+      double theta= (2.0*PI*j)/CYLINDER_SLICES;
+      *crd++= (j<0) ? 0.0 : cos(theta);
+      *crd++= (j<0) ? 0.0 : sin(theta);
+      *crd++= end;
+      *nrm++= 0.0;
+      *nrm++= 0.0;
+      *nrm++= (end ? 1.0 : -1.0);
+    }
+  }
+
+  idx= indices;
+  for (i=0; i<CYLINDER_STACKS; i++)
+    for (j=0; j<CYLINDER_SLICES; j++) {
+      int a= i*(CYLINDER_SLICES+1) + j;
+      int d= a + CYLINDER_SLICES + 1;
+      *idx++= a; *idx++= a+1; *idx++= d+1;
+      *idx++= a; *idx++= d+1; *idx++= d;
+    }
+  for (end=0; end<2; end++) {
+    int center= nside + end*(CYLINDER_SLICES+2);
+    for (j=0; j<CYLINDER_SLICES; j++) {
+      *idx++= center;
+      if (end) {
+	*idx++= center+1+j; *idx++= center+2+j;
+      }
+      else {
+	*idx++= center+2+j; *idx++= center+1+j;
+      }
+    }
+  }
+
+  return build_unit_mesh(self, coords, normals, nverts, indices, ntris);
+}
+#endif
 
 static void destroy_object(P_Void_ptr the_thing) {
     
@@ -906,12 +1625,28 @@ static void destroy_object(P_Void_ptr the_thing) {
       delobj(it->obj_info.obj);	
     }
 #endif
-    if (it->cvlist) free_cached_vlist( it->cvlist );
+    if (it->cvlist) free_cached_vlist( self, it->cvlist );
     free((void *)it);
   }
   METHOD_OUT
 }
 
+#ifdef USE_OPENGL
+static void free_mesh( P_Renderer *self, gl_gob* it )
+{
+  if (it->obj_info.mesh_obj.ibo) {
+    set_drawing_window(self);
+    glDeleteBuffersVBO(1, &(it->obj_info.mesh_obj.ibo));
+  }
+  if (it->obj_info.mesh_obj.indices) 
+    free((void*)it->obj_info.mesh_obj.indices);
+  if (it->obj_info.mesh_obj.facet_lengths) 
+    free((void*)it->obj_info.mesh_obj.facet_lengths);
+  if (it->cvlist) free_cached_vlist( self, it->cvlist );
+  free((void *)it);
+}
+#endif
+
 static void destroy_mesh(P_Void_ptr the_thing) {
     
   gl_gob *it = (gl_gob *)the_thing;
@@ -924,12 +1659,7 @@ static void destroy_mesh(P_Void_ptr the_thing) {
 #ifdef USE_GL_OBJ
   destroy_obj(the_thing);
 #else
-  if (it->obj_info.mesh_obj.indices) 
-    free((void*)it->obj_info.mesh_obj.indices);
-  if (it->obj_info.mesh_obj.facet_lengths) 
-    free((void*)it->obj_info.mesh_obj.facet_lengths);
-  if (it->cvlist) free_cached_vlist( it->cvlist );
-  free((void *)it);
+  free_mesh( self, it );
 #endif
 
   METHOD_OUT
@@ -964,12 +1694,12 @@ static void destroy_sphere(P_Void_ptr the_thing) {
 
   if (it) {
 #ifdef USE_OPENGL
-    if (it->obj_info.quad_obj) gluDeleteQuadric(it->obj_info.quad_obj);
+    free_mesh( self, it );
 #else
     if (it->obj_info.obj && isobj(it->obj_info.obj)) 
       delobj(it->obj_info.obj);	
-#endif
     free((void *)it);
+#endif
   }
 #endif
   METHOD_OUT
@@ -1004,13 +1734,12 @@ static void destroy_cylinder(P_Void_ptr the_thing) {
 
   if (it) {
 #ifdef USE_OPENGL
-    if (it->obj_info.quad_obj) gluDeleteQuadric(it->obj_info.quad_obj);
+    free_mesh( self, it );
 #else
     if (it->obj_info.obj && isobj(it->obj_info.obj)) delobj(it->obj_info.obj);	
-#endif
-    if (it->cvlist) free_cached_vlist( it->cvlist );
+    if (it->cvlist) free_cached_vlist( self, it->cvlist );
     free((void *)it);
-
+#endif
   }
 #endif
 
@@ -1039,7 +1768,7 @@ static void destroy_torus(P_Void_ptr the_thing) {
     free((P_Void_ptr)(it->obj_info.nurbs_obj));
 #endif
   }
-  if (it->cvlist) free_cached_vlist( it->cvlist );
+  if (it->cvlist) free_cached_vlist( self, it->cvlist );
   free((void *)it);
 
 #endif
@@ -1071,7 +1800,7 @@ static void destroy_bezier(P_Void_ptr the_thing) {
     }
 #endif
   }
-  if (it->cvlist) free_cached_vlist( it->cvlist );
+  if (it->cvlist) free_cached_vlist( self, it->cvlist );
   free((void *)it);
 
 #endif
@@ -1405,6 +2134,7 @@ static void ren_mesh(P_Void_ptr the_thing, P_Transform *transform,
   P_Color *pcolor;
   P_Material *mat;
   int screendoor_set= 0;
+#ifndef USE_OPENGL
   int *facet_lengths;
   int *indices;
   int nfacets;
@@ -1413,6 +2143,7 @@ static void ren_mesh(P_Void_ptr the_thing, P_Transform *transform,
   float* normals;
   int lupe;
   int loope;
+#endif
   METHOD_IN
 	
   gl_gob *it = (gl_gob *)the_thing;
@@ -1435,6 +2166,10 @@ static void ren_mesh(P_Void_ptr the_thing, P_Transform *transform,
 	&& it->obj_info.mesh_obj.indices 
 	&& it->obj_info.mesh_obj.facet_lengths) {
 
+#ifdef USE_OPENGL
+      draw_mesh(self, it);
+#else
+
       facet_lengths= it->obj_info.mesh_obj.facet_lengths;
       indices= it->obj_info.mesh_obj.indices;
       nfacets= it->obj_info.mesh_obj.nfacets;
@@ -1442,82 +2177,6 @@ static void ren_mesh(P_Void_ptr the_thing, P_Transform *transform,
       colors= it->cvlist->colors;
       normals= it->cvlist->normals;
 
-#ifdef USE_OPENGL
-      switch (it->cvlist->type) {
-      case P3D_CVTX:
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(3, GL_FLOAT, 0, coords);
-	glDisableClientState(GL_COLOR_ARRAY);
-	glDisableClientState(GL_NORMAL_ARRAY);
-	break;
-      case P3D_CCVTX:
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(3, GL_FLOAT, 0, coords);
-	glEnableClientState(GL_COLOR_ARRAY);
-	glColorPointer(4, GL_FLOAT, 0, colors);
-	glDisableClientState(GL_NORMAL_ARRAY);
-	break;
-	glEnableClientState(GL_COLOR_ARRAY);
-      case P3D_CCNVTX:
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(3, GL_FLOAT, 0, coords);
-	glEnableClientState(GL_COLOR_ARRAY);
-	glColorPointer(4, GL_FLOAT, 0, colors);
-	glEnableClientState(GL_NORMAL_ARRAY);
-	glNormalPointer(GL_FLOAT, 0, normals);
-	break;
-      case P3D_CNVTX:
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(3, GL_FLOAT, 0, coords);
-	glDisableClientState(GL_COLOR_ARRAY);
-	glEnableClientState(GL_NORMAL_ARRAY);
-	glNormalPointer(GL_FLOAT, 0, normals);
-	break;
-      default:
-	ger_error("Error: ren_mesh: unsupported vertex type %d!\n", it->cvlist->type);
-      }
-      switch (it->obj_info.mesh_obj.type) {
-      case MESH_MIXED:
-	for (loope=0; loope < nfacets; loope++) {
-	  glDrawElements(GL_POLYGON, facet_lengths[loope], GL_UNSIGNED_INT, indices);
-	  indices += facet_lengths[loope];
-	}
-	break;
-      case MESH_TRI:
-	glDrawElements(GL_TRIANGLES, 3*nfacets, GL_UNSIGNED_INT, indices);
-	break;
-      case MESH_QUAD:
-	glDrawElements(GL_QUADS, 4*nfacets, GL_UNSIGNED_INT, indices);
-	break;
-      case MESH_STRIP:
-	for (loope=0; loope < nfacets; loope++) {
-	  int run;
-	  if (facet_lengths[loope]==3) {
-	    /* Try to gather up tris */
-	    run= 1;
-	    while (loope+run<nfacets) {
-	      if (facet_lengths[loope+run]!=3) break;
-	      run++;
-	    }
-	    glDrawElements(GL_TRIANGLES, 3*run, GL_UNSIGNED_INT, indices);
-	    indices += 3*run;
-	    loope+= run-1;
-	  }
-	  else {
-	    /* A real strip */
-	    glDrawElements(GL_TRIANGLE_STRIP, facet_lengths[loope], 
-			   GL_UNSIGNED_INT, indices);
-	    indices += facet_lengths[loope];
-	  }
-	}
-	break;
-      }
-	
-      /* Ideally I'd return to the original state, but I can't tell what it
-       *  was. 
-       */
-#else
-
       for (loope=0; loope < nfacets; loope++) {
 	bgnpolygon();
 	for (lupe=0;lupe < facet_lengths[loope]; lupe++, indices++)
@@ -1561,8 +2220,7 @@ static void ren_sphere(P_Void_ptr the_thing, P_Transform *transform,
     screendoor_set= ren_prim_setup( self, it, transform, attrs );
 
 #ifdef USE_OPENGL
-    if (it->obj_info.quad_obj) 
-      gluSphere(it->obj_info.quad_obj, 1.0, SPHERE_SLICES, SPHERE_STACKS);
+    if (it->cvlist) draw_mesh(self, it);
 #else
     if (it->obj_info.obj) callobj(it->obj_info.obj);
 #endif
@@ -1598,15 +2256,7 @@ static void ren_cylinder(P_Void_ptr the_thing, P_Transform *transform,
     screendoor_set= ren_prim_setup( self, it, transform, attrs );
 
 #ifdef USE_OPENGL
-    if (it->obj_info.quad_obj) {
-      gluCylinder(it->obj_info.quad_obj, 1.0, 1.0, 1.0, 
-		  CYLINDER_SLICES, CYLINDER_STACKS);
-      gluQuadricOrientation(it->obj_info.quad_obj, GLU_INSIDE);
-      gluDisk( it->obj_info.quad_obj, 0.0, 1.0, CYLINDER_SLICES, 1 );
-      glTranslatef(0.0,0.0,1.0);
-      gluQuadricOrientation(it->obj_info.quad_obj, GLU_OUTSIDE);
-      gluDisk( it->obj_info.quad_obj, 0.0, 1.0, CYLINDER_SLICES, 1 );
-    }
+    if (it->cvlist) draw_mesh(self, it);
 #else
     if (it->obj_info.obj) callobj(it->obj_info.obj);
 #endif
@@ -1744,16 +2394,10 @@ static void ren_polyline(P_Void_ptr the_thing, P_Transform *transform,
     screendoor_set= ren_prim_setup( self, it, transform, attrs );
     if (it->cvlist) {
 #ifdef USE_OPENGL
-      glBegin(GL_LINE_STRIP);
+      draw_cached_vlist( self, it->cvlist, GL_LINE_STRIP );
 #else
       bgnline();
-#endif
-
       send_cached_vlist( it->cvlist );
-
-#ifdef USE_OPENGL
-      glEnd();
-#else
       endline();
 #endif
     }
@@ -1782,14 +2426,10 @@ static void ren_polygon(P_Void_ptr the_thing, P_Transform *transform,
 
     if (it->cvlist) {
 #ifdef USE_OPENGL
-      glBegin(GL_POLYGON);
-#else      
+      draw_cached_vlist( self, it->cvlist, GL_POLYGON );
+#else
       bgnpolygon();
-#endif
       send_cached_vlist( it->cvlist );
-#ifdef USE_OPENGL
-      glEnd();
-#else
       endpolygon();
 #endif
     }
@@ -1817,14 +2457,10 @@ static void ren_polymarker(P_Void_ptr the_thing, P_Transform *transform,
     screendoor_set= ren_prim_setup( self, it, transform, attrs );
     if (it->cvlist) {
 #ifdef USE_OPENGL
-      glBegin(GL_POINTS);
+      draw_cached_vlist( self, it->cvlist, GL_POINTS );
 #else
       bgnpoint();
-#endif
       send_cached_vlist( it->cvlist );
-#ifdef USE_OPENGL
-      glEnd();
-#else
       endpoint();
 #endif
     }
@@ -1852,14 +2488,10 @@ static void ren_tristrip(P_Void_ptr the_thing, P_Transform *transform,
     screendoor_set= ren_prim_setup( self, it, transform, attrs );
     if (it->cvlist) {
 #ifdef USE_OPENGL
-      glBegin(GL_TRIANGLE_STRIP);
+      draw_cached_vlist( self, it->cvlist, GL_TRIANGLE_STRIP );
 #else
       bgntmesh();
-#endif
       send_cached_vlist( it->cvlist );
-#ifdef USE_OPENGL
-      glEnd();
-#else
       endtmesh();
 #endif
     }
@@ -1904,22 +2536,20 @@ static P_Void_ptr def_sphere(char *name) {
     return( (P_Void_ptr)result );
 #else
 
-    if (! (it = (gl_gob *)malloc(sizeof(gl_gob))))
-      ger_fatal("def_sphere: unable to allocate %d bytes!", sizeof(gl_gob));
-
 #ifdef USE_OPENGL
-    it->obj_info.quad_obj= gluNewQuadric();
-    it->color_mode= 1;
+    it= unit_sphere(self);
     SPHERE(self)= it;
     SPHERE_DEFINED(self)= 1;
 #else
 
+    if (! (it = (gl_gob *)malloc(sizeof(gl_gob))))
+      ger_fatal("def_sphere: unable to allocate %d bytes!", sizeof(gl_gob));
     sphobj( it->obj_info.obj= genobj() );
     it->color_mode = LMC_AD;
+    it->cvlist= NULL;
 
 #endif
 
-    it->cvlist= NULL;
     METHOD_OUT
     return((P_Void_ptr)it);
 
@@ -2010,16 +2640,13 @@ static P_Void_ptr def_cylinder(char *name)
     return( (P_Void_ptr)result );
 #else
     
-    if (! (it = (gl_gob *)malloc(sizeof(gl_gob))))
-      ger_fatal("def_cylinder: unable to allocate %d bytes!", sizeof(gl_gob));
-    
 #ifdef USE_OPENGL
-    it->obj_info.quad_obj= gluNewQuadric();
-    it->color_mode= 1;
-    it->cvlist= NULL;
+    it= unit_cylinder(self);
     CYLINDER(self)= it;
     CYLINDER_DEFINED(self)= 1;
 #else
+    if (! (it = (gl_gob *)malloc(sizeof(gl_gob))))
+      ger_fatal("def_cylinder: unable to allocate %d bytes!", sizeof(gl_gob));
     {
       double surfknotsx[CYL_NUMKNOTSX] = { -1., -1., 1., 1. };
     
@@ -2191,7 +2818,8 @@ static void ren_gob(P_Void_ptr primdata, P_Transform *thistrans,
 
 #ifdef USE_OPENGL
 #if !defined(WIREGL)
-	if (MANAGE(self) && !AUTO(self) && !chromium_in_use()) {
+	if (MANAGE(self) && !AUTO(self) && !OFFSCREEN(self) 
+	    && !chromium_in_use(self)) {
 	  /* We have to run a little event loop, because no one else is. */
 	  int event_pending= 1;
 	  long event_mask= 
@@ -2229,7 +2857,7 @@ static void ren_gob(P_Void_ptr primdata, P_Transform *thistrans,
 #if defined(WIREGL)
 	if (NPROCS(self)>1) glBarrierExec(BARRIER(self));
 #else
-	if (chromium_in_use()) {
+	if (chromium_in_use(self)) {
 	  glBarrierExecCR( BARRIER(self) );
 	}
 #endif
@@ -2293,6 +2921,7 @@ static void ren_gob(P_Void_ptr primdata, P_Transform *thistrans,
       if (top_level_call) {
 #ifdef USE_OPENGL
 	glPopMatrix();
+	release_vertex_arrays(self);
 
 #if defined(WIREGL)
 	if (NPROCS(self)>1) glBarrierExec(BARRIER(self));
@@ -2305,11 +2934,14 @@ static void ren_gob(P_Void_ptr primdata, P_Transform *thistrans,
 #endif
 
 #else
-	if (chromium_in_use()) {
+	if (chromium_in_use(self)) {
 	  glBarrierExecCR( BARRIER(self) );
 	  if (RANK(self)==0) glSwapBuffersCR(0, 0);
 	  else glSwapBuffersCR(0, CR_SUPPRESS_SWAP_BIT);
 	}
+	else if (OFFSCREEN(self)) {
+	  read_back_frame(self);
+	}
 	else {
 	  if (MANAGE(self)) {
 	    glXSwapBuffers(XDISPLAY(self),XWINDOW(self));
@@ -2318,7 +2950,7 @@ static void ren_gob(P_Void_ptr primdata, P_Transform *thistrans,
 
 #ifdef never
 	if (MANAGE(self)) {
-	  if (chromium_in_use()) {
+	  if (chromium_in_use(self)) {
 	    /* The crserver only executes the SwapBuffers() for the 0th client.
 	     * No need to test for rank==0 as we used to do.
 	     */
@@ -2502,6 +3134,9 @@ static P_Void_ptr def_polyline(char *name, P_Vlist *vertices) {
   it->obj_info.obj= NULL;
 #endif
   it->cvlist= cache_vlist(self, vertices);
+#ifdef USE_OPENGL
+  load_buffers(self, it, 0);
+#endif
 
   METHOD_OUT
   return((P_Void_ptr)it);
@@ -2530,6 +3165,9 @@ static P_Void_ptr def_polygon(char *name, P_Vlist *vertices) {
   it->obj_info.obj= NULL;
 #endif
   it->cvlist= cache_vlist(self, vertices);
+#ifdef USE_OPENGL
+  load_buffers(self, it, 0);
+#endif
 
   METHOD_OUT
   return((P_Void_ptr)it);
@@ -2558,6 +3196,9 @@ static P_Void_ptr def_polymarker(char *name, P_Vlist *vertices) {
   it->obj_info.obj= NULL;
 #endif
   it->cvlist= cache_vlist(self, vertices);
+#ifdef USE_OPENGL
+  load_buffers(self, it, 0);
+#endif
 
   METHOD_OUT
   return((P_Void_ptr)it);
@@ -2586,6 +3227,9 @@ static P_Void_ptr def_tristrip(char *name, P_Vlist *vertices) {
   it->obj_info.obj= NULL;
 #endif
   it->cvlist= cache_vlist(self, vertices);
+#ifdef USE_OPENGL
+  load_buffers(self, it, 0);
+#endif
   METHOD_OUT
   return((P_Void_ptr)it);
 }
@@ -3043,105 +3687,12 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vertices, int *indices,
 #if (STRIP_MESHES != 0)
   if (mesh_type==MESH_TRI) {
     int* newIndex= NULL;
-    int* mark= NULL;
     int* newLength= NULL;
-    int* here;
-    int odd;
-    int length;
-    int firstFree= 0;
-    int nFree= nfacets;
-    int count= 0;
-
-    if (!(newIndex= (int*)malloc(3*nfacets*sizeof(int)))) 
-      ger_fatal("def_mesh: unable to allocate %d bytes!\n",
-		3*nfacets*sizeof(int));
-    if (!(newLength= (int*)malloc(nfacets*sizeof(int)))) 
-      ger_fatal("def_mesh: unable to allocate %d bytes!\n",
-		nfacets*sizeof(int));
-    if (!(mark= (int*)malloc(nfacets*sizeof(int)))) 
-      ger_fatal("def_mesh: unable to allocate %d bytes!\n",
-		nfacets*sizeof(int));
-    for (i=0; i<nfacets; i++) mark[i]= 0;
-
-    here= newIndex;
-
-    *here++= indices[3*firstFree];
-    *here++= indices[3*firstFree+1];
-    *here++= indices[3*firstFree+2];
-    mark[firstFree]= 1;
-    nFree--;
-    firstFree += 1;
-    odd= 1;
-    length= 3;
-
-    while (nFree) {
-      /* Start a new strip on firstFree */
-
-      /* Run from here to the end, looking for a good next cell */
-
-      int limit= firstFree+STRIP_PATIENCE;
-      if (limit>nfacets) limit= nfacets;
-      for (i=firstFree; i<limit; i++) {
-	if (!mark[i]) {
-	  if (odd) {
-	    if (indices[3*i]==*(here-2)&&indices[3*i+2]==*(here-1)) {
-	      *here++= indices[3*i+1];
-	      break;
-	    }
-	    else if (indices[3*i+1]==*(here-2)&&indices[3*i]==*(here-1)) {
-	      *here++= indices[3*i+2];
-	      break;
-	    }
-	    else if (indices[3*i+2]==*(here-2)&&indices[3*i+1]==*(here-1)) {
-	      *here++= indices[3*i];
-	      break;
-	    }
-	  }
-	  else { /* even case */
-	    if (indices[3*i+2]==*(here-2)&&indices[3*i]==*(here-1)) {
-	      *here++= indices[3*i+1];
-	      break;
-	    }
-	    else if (indices[3*i]==*(here-2)&&indices[3*i+1]==*(here-1)) {
-	      *here++= indices[3*i+2];
-	      break;
-	    }
-	    else if (indices[3*i+1]==*(here-2)&&indices[3*i+2]==*(here-1)) {
-	      *here++= indices[3*i];
-	      break;
-	    }
-	  }
-	}
-      }
-      if (i!=limit) {
-	/* matched */
-	mark[i]= 1;
-	nFree--;
-	odd= !odd;
-	length++;
-      }
-      else {
-	/* start a new strip */
-	newLength[count]= length;
-	count += 1;
-	while (firstFree<nfacets && mark[firstFree]) firstFree++;
-	if (firstFree==nfacets) break;
-	*here++= indices[3*firstFree];
-	*here++= indices[3*firstFree+1];
-	*here++= indices[3*firstFree+2];
-	nFree--;
-	mark[firstFree]= 1;
-	while (firstFree<nfacets && mark[firstFree]) firstFree++;
-	odd= 1;
-	length= 3;
-	if (firstFree==nfacets) break;
-      }
-    }
-    newLength[count]= length;
-    count += 1;
-    if (count<STRIP_BENEFIT*nfacets) {
+    int count;
+
+    if ((count= strip_mesh(indices, facet_lengths, nfacets,
+			   &newIndex, &newLength)) != 0) {
       /* OK, let's use the stripped mesh */
-      free(mark);
       it->obj_info.mesh_obj.indices= newIndex;
       it->obj_info.mesh_obj.facet_lengths= newLength;
       it->obj_info.mesh_obj.nfacets= count;
@@ -3149,10 +3700,6 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vertices, int *indices,
     }
     else {
       /* It's not worth it; cache the original info */
-      free(newIndex);
-      free(newLength);
-      free(mark);
-
       if (!(it->obj_info.mesh_obj.indices= 
 	    (int*)malloc(total_indices*sizeof(int))))
 	ger_fatal("def_mesh: unable to allocate %d bytes!",
@@ -3212,6 +3759,15 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vertices, int *indices,
   it->cvlist= cache_vlist(self, vertices);
 
 #endif /* STRIP_MESHES != 0 */
+
+#ifdef USE_OPENGL
+  it->obj_info.mesh_obj.nindices= 0;
+  for (i=0; i<it->obj_info.mesh_obj.nfacets; i++)
+    it->obj_info.mesh_obj.nindices += it->obj_info.mesh_obj.facet_lengths[i];
+  it->obj_info.mesh_obj.ibo= 0;
+  load_buffers(self, it, 1);
+#endif
+
 #endif /* USE_GL_OBJ */
     
   METHOD_OUT
@@ -3720,11 +4276,21 @@ static void ren_destroy() {
 
   glFinish(); /* in case any geometry is still in the pipe */
 
+  /* The assist object may hold primitives, so it goes while the
+   * context is still current.
+   */
+  METHOD_RDY(ASSIST(self));
+  (*(ASSIST(self)->destroy_self))();
+
 #ifdef USE_OPENGL
+#ifndef AVOID_NURBS
+  if (SPHERE_DEFINED(self)) free_mesh( self, (gl_gob*)SPHERE(self) );
+  if (CYLINDER_DEFINED(self)) free_mesh( self, CYLINDER(self) );
+#endif
 #ifdef WIREGL
   if (NPROCS(self)>1) glBarrierDestroy(BARRIER(self));
 #else
-  if (chromium_in_use()) {
+  if (chromium_in_use(self)) {
     glBarrierExecCR( BARRIER(self) );
     glBarrierDestroyCR( BARRIER(self) );
     if (MANAGE(self)){
@@ -3733,6 +4299,9 @@ static void ren_destroy() {
       XWINDOW(self)= 0;
     }
   }
+  else if (OFFSCREEN(self)) {
+    destroy_offscreen_context(self);
+  }
   else {
     if (MANAGE(self)) {
       glXDestroyContext(XDISPLAY(self),GLXCONTEXT(self));
@@ -3746,10 +4315,11 @@ static void ren_destroy() {
   winclose(WINDOW(self));
   free( (P_Void_ptr)LM(self) );
 #endif
-  METHOD_RDY(ASSIST(self));
-  (*(ASSIST(self)->destroy_self))();
     
   free( (P_Void_ptr)NAME(self) );
+#ifdef USE_OPENGL
+  if (OUTFILE(self)) free( (P_Void_ptr)OUTFILE(self) );
+#endif
   free( (P_Void_ptr)BACKGROUND(self) );
   free( (P_Void_ptr)AMBIENTCOLOR(self) );
   free ((P_Void_ptr)self);
@@ -3889,6 +4459,24 @@ P_Renderer *po_create_gl_renderer( char *device, char *datastr )
     AUTO(self) = 1;
   }
   else AUTO(self)= 0;
+#ifdef USE_OPENGL
+  if (strstr (device, "offscreen") != NULL) {
+    char *here= strstr (device, "offscreen=");
+    OFFSCREEN(self)= 1;
+    MANAGE(self)= 1;
+    AUTO(self)= 0;
+    if (here) {
+      char *dup= strdup(here);
+      OUTFILE(self)= strdup(getTrimmedValue(dup));
+      free(dup);
+    }
+    else OUTFILE(self)= strdup("DrawP3D.ppm");
+  }
+  else {
+    OFFSCREEN(self)= 0;
+    OUTFILE(self)= NULL;
+  }
+#endif
 
   /*parse the datastr string*/
   name= strdup("p3d-gl");
@@ -3963,13 +4551,18 @@ P_Renderer *po_create_gl_renderer( char *device, char *datastr )
 #endif
       attach_drawing_window(self);
     }
+#ifdef USE_OPENGL
+    else if (OFFSCREEN(self)) {
+      create_offscreen_context(self, size);
+    }
+#endif
     else {
       create_drawing_window(self, size);
     }
     set_drawing_window(self);
   }
 
-  if (chromium_in_use()) {
+  if (chromium_in_use(self)) {
     /* If current context has not been initialized, MANAGE(self) is 0 
      * and the calling application has generated a context.  We need
      * to grab that context.
@@ -4009,9 +4602,16 @@ static void init_gl_structure (P_Renderer *self)
   SPHERE_DEFINED(self)= 0;
   CYLINDER(self)= NULL;
   CYLINDER_DEFINED(self)= 0;
+  VBO_OK(self)= 0;
+  BOUND_VLIST(self)= NULL;
+  FILENUM(self)= 0;
+  PBO_OK(self)= 0;
+  PBO(self)[0]= PBO(self)[1]= 0;
+  PENDING_PBO(self)= 0;
+  PIXELS(self)= NULL;
   for (lupe=0; lupe<MY_GL_MAX_LIGHTS; lupe++)
     LIGHT_IN_USE(self)[lupe]= 0;
-  if (chromium_in_use()) {
+  if (chromium_in_use(self)) {
     BARRIER(self)= BARRIER_BASE+ren_seq_num;
   }
   else {
@@ -4131,7 +4731,7 @@ static void init_gl_gl (P_Renderer *self)
     wireGLInstrumentNextFrame();
 #endif
 #else
-  if (chromium_in_use()) {
+  if (chromium_in_use(self)) {
     glBarrierExecCR( BARRIER(self) );
   }
   else {
@@ -4147,6 +4747,13 @@ static void init_gl_gl (P_Renderer *self)
   glEnable(GL_AUTO_NORMAL);
   glEnable(GL_NORMALIZE);
 
+  VBO_OK(self)= (VBO_MESHES && load_buffer_procs());
+  BOUND_VLIST(self)= NULL;
+  ger_debug("gl_ren_mthd: init_gl_gl: %s vertex buffer objects",
+	    (VBO_OK(self) ? "using" : "not using"));
+  PBO_OK(self)= (OFFSCREEN(self) && load_buffer_procs()
+		 && gl_has(2, 1, "GL_ARB_pixel_buffer_object"));
+
   hastransparent= 0;
 
 #else
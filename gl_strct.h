@@ -61,6 +61,9 @@ typedef struct vlist_cache_struct {
   float *coords;
   float *colors;
   float *normals;
+#ifdef USE_OPENGL
+  GLuint vbo;     /* buffer holding coords, then colors, then normals */
+#endif
 } P_Cached_Vlist;
 
 typedef enum { MESH_MIXED, MESH_TRI, MESH_QUAD, MESH_STRIP } gl_mesh_type;
@@ -79,6 +82,8 @@ typedef struct gl_gob_struct {
 	int* indices;
 	int* facet_lengths;
 	int nfacets;
+	int nindices;
+	GLuint ibo;
 	gl_mesh_type type;
       } mesh_obj;
     } obj_info;
@@ -120,6 +125,21 @@ typedef struct renderer_data_struct {
   int cylinder_defined;
   int light_in_use[MY_GL_MAX_LIGHTS];
   GLuint barrier; /* used in parallel geometry stream management */
+  int vbo_ok;     /* vertex buffer objects are supported */
+  P_Cached_Vlist* bound_vlist; /* vertex arrays currently point here */
+  int offscreen;  /* rendering into an EGL pbuffer rather than a window */
+  int width;      /* size of the offscreen image */
+  int height;
+  int filenum;    /* number of offscreen images written */
+  int pbo_ok;     /* pixel buffer objects are supported */
+  GLuint pbo[2];  /* alternate frames are read back into these */
+  int pending_pbo; /* 1 + index of the pbo holding an unwritten frame */
+  unsigned char *pixels; /* readback space when there are no pbos */
+#ifdef USE_EGL
+  EGLDisplay egl_dpy;
+  EGLSurface egl_surf;
+  EGLContext egl_ctx;
+#endif
 #endif
 
   int open;
@@ -164,6 +184,21 @@ typedef struct renderer_data_struct {
 #define CYLINDER_DEFINED(self) (RENDATA(self)->cylinder_defined)
 #define LIGHT_IN_USE(self) (RENDATA(self)->light_in_use)
 #define BARRIER(self) (RENDATA(self)->barrier)
+#define VBO_OK(self) (RENDATA(self)->vbo_ok)
+#define BOUND_VLIST(self) (RENDATA(self)->bound_vlist)
+#define OFFSCREEN(self) (RENDATA(self)->offscreen)
+#define OFF_WIDTH(self) (RENDATA(self)->width)
+#define OFF_HEIGHT(self) (RENDATA(self)->height)
+#define FILENUM(self) (RENDATA(self)->filenum)
+#define PBO_OK(self) (RENDATA(self)->pbo_ok)
+#define PBO(self) (RENDATA(self)->pbo)
+#define PENDING_PBO(self) (RENDATA(self)->pending_pbo)
+#define PIXELS(self) (RENDATA(self)->pixels)
+#ifdef USE_EGL
+#define EGLDISPLAY(self) (RENDATA(self)->egl_dpy)
+#define EGLSURFACE(self) (RENDATA(self)->egl_surf)
+#define EGLCONTEXT(self) (RENDATA(self)->egl_ctx)
+#endif
 #endif
 #define RENDATA( self ) ((P_Renderer_data *)(self->object_data))
 #define OUTFILE( self ) (RENDATA(self)->outfile)
@@ -0,0 +1,2071 @@
+/****************************************************************************
+ * gltf_ren_mthd.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module implements the glTF renderer, which writes each snap as a
+binary glTF 2.0 (GLB) file.
+
+Geometry is converted once, when it is defined, into the arrays glTF
+wants: float positions, unit normals and RGBA colors, and 16 or 32
+bit triangle indices.  At snap time the gob tree becomes a tree of nodes
+carrying the gob transforms, and the binary chunk of the file is written
+directly from those arrays.  Each primitive is written only once per
+file however many times it is instanced, and all spheres and cylinders
+share a single mesh.  A primitive drawn in more than one material gets
+a mesh for each, all using the same vertex data.
+
+Lights become KHR_lights_punctual point lights.  glTF has no text or
+ambient light, so text strings are written as empty nodes with the
+string in their extras, and the ambient color and background color are
+written as extras of the scene.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "assist.h"
+#include "ge_error.h"
+#include "bgwrite.h"
+#include "numfmt.h"
+
+#define MAXSYMBOLLENGTH P3D_NAMELENGTH
+
+/* glTF constants */
+#define GLTF_POINTS 0
+#define GLTF_LINE_STRIP 3
+#define GLTF_TRIANGLES 4
+#define GLTF_TRIANGLE_STRIP 5
+#define GLTF_FLOAT 5126
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_ARRAY_BUFFER 34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+#define GLB_MAGIC 0x46546C67    /* "glTF" */
+#define GLB_JSON 0x4E4F534A     /* "JSON" */
+#define GLB_BIN 0x004E4942      /* "BIN\0" */
+
+/* Tesselation of the standard primitives */
+#define SPHERE_LATITUDES 16
+#define SPHERE_LONGITUDES 32
+#define CYLINDER_DIVISIONS 32
+#define TORUS_MAJOR_DIVISIONS 32
+#define TORUS_MINOR_DIVISIONS 16
+
+/* Accessor slots within a geometry */
+#define ACC_POSITION 0
+#define ACC_NORMAL 1
+#define ACC_COLOR 2
+#define ACC_INDEX 3
+#define ACC_SLOTS 4
+
+/* Struct to hold info for a color map */
+typedef struct renderer_cmap_struct {
+  char name[MAXSYMBOLLENGTH];
+  double min;
+  double max;
+  void (*mapfun)( float *, float *, float *, float *, float * );
+} P_Renderer_Cmap;
+
+/* Growing string, used to build up each array of the JSON chunk */
+typedef struct json_buf_struct {
+  char *text;
+  int length;
+  int space;
+  int count;                    /* number of array items so far */
+} Json_Buf;
+
+/* Mesh written for a geometry in the current file, one per material */
+typedef struct gltf_mesh_ref_struct {
+  int material;
+  int mesh;
+  struct gltf_mesh_ref_struct *next;
+} Gltf_Mesh_Ref;
+
+/* Geometry in the form in which it is written */
+typedef struct gltf_geom_struct {
+  int mode;                     /* glTF primitive mode */
+  int nverts;
+  float *coords;                /* xyz */
+  float *normals;               /* unit xyz, or null */
+  float *colors;                /* rgba, or null */
+  int translucent;              /* some vertex has alpha below 1 */
+  int nindices;
+  unsigned int *indices;        /* null if the vertices are used in order */
+  int index_type;               /* GLTF_UNSIGNED_SHORT once packed */
+  float min[3], max[3];         /* bounds of coords */
+  int file_serial;              /* file to which the accessors belong */
+  int accessors[ACC_SLOTS];
+  Gltf_Mesh_Ref *meshes;
+} Gltf_Geom;
+
+typedef struct gltf_text_struct {
+  char *tstring;
+  float coords[9];              /* location, u, v */
+} Gltf_Text;
+
+typedef struct gltf_light_struct {
+  float location[3];
+  float color[3];
+} Gltf_Light;
+
+/* Material as used in the current file */
+typedef struct gltf_material_struct {
+  float rgba[4];
+  int type;
+  int double_sided;
+  int blend;
+} Gltf_Material;
+
+/* Piece of the binary chunk, which is written straight from the cache */
+typedef struct gltf_segment_struct {
+  void *data;
+  int nbytes;
+  int word_size;                /* for byte swapping */
+} Gltf_Segment;
+
+/* Attributes in force during the gob traversal */
+typedef struct gltf_state_struct {
+  P_Color color;
+  int material;
+  int backcull;
+  float text_height;
+} Gltf_State;
+
+/* Struct for object data, and access functions for it */
+typedef struct renderer_data_struct {
+  char *name;
+  FILE *outfile;
+  int file_num;
+  int open;
+  int initialized;
+  int sync;
+  P_Renderer_Cmap *current_cmap;
+  P_Camera *current_camera;
+  P_Symbol backcull_symbol;
+  P_Symbol text_height_symbol;
+  P_Symbol color_symbol;
+  P_Symbol material_symbol;
+  P_Assist *assist;
+  Gltf_Geom *sphere;
+  Gltf_Geom *cylinder;
+  /* What follows is the state of the file being built */
+  int file_serial;
+  Json_Buf nodes, meshes, materials, accessors, views, cameras, lights;
+  Gltf_Material *mtls;
+  int mtl_space;
+  Gltf_Segment *segs;
+  int nsegs, seg_space;
+  int bin_length;
+  int *kids;                    /* node stack;  the bottom holds the roots */
+  int nkids, kid_space;
+  Gltf_State state;
+  float ambient[3];
+  int has_ambient;
+  float background[4];
+} P_Renderer_data;
+
+#define RENDATA( self ) ((P_Renderer_data *)(self->object_data))
+#define OUTFILE( self ) (RENDATA(self)->outfile)
+#define FILENUM( self ) (RENDATA(self)->file_num)
+#define SYNC( self ) (RENDATA(self)->sync)
+#define NAME( self ) (RENDATA(self)->name)
+#define CUR_MAP( self ) (RENDATA(self)->current_cmap)
+#define MAP_MIN( self ) (CUR_MAP(self)->min)
+#define MAP_MAX( self ) (CUR_MAP(self)->max)
+#define MAP_FUN( self ) (CUR_MAP(self)->mapfun)
+#define CURRENT_CAMERA(self) (RENDATA(self)->current_camera)
+#define BACKCULLSYMBOL(self) (RENDATA(self)->backcull_symbol)
+#define TEXTHEIGHTSYMBOL(self) (RENDATA(self)->text_height_symbol)
+#define COLORSYMBOL(self) (RENDATA(self)->color_symbol)
+#define MATERIALSYMBOL(self) (RENDATA(self)->material_symbol)
+#define ASSIST(self) (RENDATA(self)->assist)
+#define STATE(self) (RENDATA(self)->state)
+
+static void walk_gob(P_Renderer *self, P_Gob *gob, P_Attrib_List *attr,
+		     int lighting);
+static void write_file(P_Renderer *self);
+
+/* Space for default color map */
+static P_Renderer_Cmap default_map;
+
+/* Default color map function */
+static void default_mapfun(float *val, float *r, float *g, float *b, float *a)
+/* This routine provides a simple map from values to colors within the
+ * range 0.0 to 1.0.
+ */
+{
+  /* No debugging; called too often */
+  *r= *g= *b= *a= *val;
+}
+
+static void jb_grow(Json_Buf *jb, int nchars)
+/* This routine makes room for nchars more characters and a null */
+{
+  if (jb->length + nchars + 1 > jb->space) {
+    int space= jb->space ? 2*jb->space : 4096;
+    while (space < jb->length + nchars + 1) space *= 2;
+    if ( !(jb->text= (char *)realloc(jb->text, space)) )
+      ger_fatal("gltf_ren_mthd: jb_grow: unable to allocate %d bytes!",
+		space);
+    jb->space= space;
+  }
+}
+
+static void jb_printf(Json_Buf *jb, char *format, ...)
+/* This routine appends formatted text;  it is used only for short items */
+{
+  va_list args;
+  jb_grow(jb, 256);
+  va_start(args, format);
+  jb->length += vsprintf(jb->text + jb->length, format, args);
+  va_end(args);
+}
+
+static void jb_float(Json_Buf *jb, double val)
+/* This routine appends a number in its shortest form.  JSON has no
+ * infinities or NaNs, so those are written as 0.
+ */
+{
+  jb_grow(jb, NF_MAXCHARS);
+  if (!isfinite(val)) {
+    ger_error("gltf_ren_mthd: jb_float: non-finite value written as 0");
+    val= 0.0;
+  }
+  jb->length += nf_format_float(jb->text + jb->length, val);
+}
+
+static void jb_floats(Json_Buf *jb, float *vals, int n)
+/* This routine appends an array of numbers */
+{
+  int i;
+  jb_printf(jb, "[");
+  for (i=0; i<n; i++) {
+    if (i) jb_printf(jb, ",");
+    jb_float(jb, vals[i]);
+  }
+  jb_printf(jb, "]");
+}
+
+static void jb_string(Json_Buf *jb, char *string)
+/* This routine appends a quoted string */
+{
+  jb_grow(jb, 6*strlen(string) + 2);
+  jb->text[jb->length++]= '"';
+  for ( ; *string; string++) {
+    if (*string=='"' || *string=='\\') {
+      jb->text[jb->length++]= '\\';
+      jb->text[jb->length++]= *string;
+    }
+    else if ((unsigned char)*string < 0x20)
+      jb->length += sprintf(jb->text + jb->length, "\\u%04x", *string);
+    else jb->text[jb->length++]= *string;
+  }
+  jb->text[jb->length++]= '"';
+  jb->text[jb->length]= '\0';
+}
+
+static int jb_item(Json_Buf *jb)
+/* This routine starts a new array item and returns its index */
+{
+  if (jb->count) jb_printf(jb, ",");
+  return( jb->count++ );
+}
+
+static void jb_clear(Json_Buf *jb)
+{
+  jb->length= 0;
+  jb->count= 0;
+  if (jb->text) jb->text[0]= '\0';
+}
+
+static void jb_free(Json_Buf *jb)
+{
+  if (jb->text) free( (P_Void_ptr)jb->text );
+  jb->text= NULL;
+  jb->length= jb->space= jb->count= 0;
+}
+
+static void jb_section(Json_Buf *out, char *name, Json_Buf *items)
+/* This routine appends a named array, if it has any items */
+{
+  if (items->count) {
+    jb_printf(out, ",\"%s\":[", name);
+    jb_grow(out, items->length);
+    memcpy(out->text + out->length, items->text, items->length);
+    out->length += items->length;
+    jb_printf(out, "]");
+  }
+}
+
+static Gltf_Geom *new_geom(int mode, int nverts, int has_normals,
+			   int has_colors, int nindices)
+/* This routine allocates a geometry with room for its vertex data */
+{
+  Gltf_Geom *result;
+
+  if ( !(result= (Gltf_Geom *)malloc(sizeof(Gltf_Geom))) )
+    ger_fatal("gltf_ren_mthd: new_geom: unable to allocate %d bytes!",
+	      sizeof(Gltf_Geom));
+  result->mode= mode;
+  result->nverts= nverts;
+  result->nindices= nindices;
+  result->translucent= 0;
+  result->index_type= GLTF_UNSIGNED_INT;
+  result->file_serial= -1;
+  result->meshes= NULL;
+  if ( !(result->coords= (float *)malloc((3*nverts+1)*sizeof(float))) )
+    ger_fatal("gltf_ren_mthd: new_geom: unable to allocate %d floats!",
+	      3*nverts+1);
+  if (has_normals) {
+    if ( !(result->normals= (float *)malloc((3*nverts+1)*sizeof(float))) )
+      ger_fatal("gltf_ren_mthd: new_geom: unable to allocate %d floats!",
+		3*nverts+1);
+  }
+  else result->normals= NULL;
+  if (has_colors) {
+    if ( !(result->colors= (float *)malloc((4*nverts+1)*sizeof(float))) )
+      ger_fatal("gltf_ren_mthd: new_geom: unable to allocate %d floats!",
+		4*nverts+1);
+  }
+  else result->colors= NULL;
+  if (nindices) {
+    if ( !(result->indices=
+	   (unsigned int *)malloc(nindices*sizeof(unsigned int))) )
+      ger_fatal("gltf_ren_mthd: new_geom: unable to allocate %d ints!",
+		nindices);
+  }
+  else result->indices= NULL;
+  return( result );
+}
+
+static void free_mesh_refs(Gltf_Geom *geom)
+{
+  Gltf_Mesh_Ref *ref;
+  while ((ref= geom->meshes) != NULL) {
+    geom->meshes= ref->next;
+    free( (P_Void_ptr)ref );
+  }
+}
+
+static void free_geom(Gltf_Geom *geom)
+{
+  free_mesh_refs(geom);
+  free( (P_Void_ptr)geom->coords );
+  if (geom->normals) free( (P_Void_ptr)geom->normals );
+  if (geom->colors) free( (P_Void_ptr)geom->colors );
+  if (geom->indices) free( (P_Void_ptr)geom->indices );
+  free( (P_Void_ptr)geom );
+}
+
+static void finish_geom(Gltf_Geom *geom)
+/* This routine normalizes the normals, replacing null ones with +z,
+ * and finds the bounds, which glTF requires of positions.  Indices are
+ * packed into shorts where they fit;  the largest value is reserved by
+ * glTF.  The indices must be filled in before this is called.
+ */
+{
+  int i, j;
+  float len;
+
+  if (geom->indices && geom->nverts < 65535) {
+    unsigned short *packed= (unsigned short *)geom->indices;
+    for (i=0; i<geom->nindices; i++) packed[i]= geom->indices[i];
+    if (geom->nindices % 2) packed[geom->nindices]= 0;
+    geom->index_type= GLTF_UNSIGNED_SHORT;
+  }
+
+  for (j=0; j<3; j++) geom->min[j]= geom->max[j]= 0.0;
+  for (i=0; i<geom->nverts; i++) {
+    for (j=0; j<3; j++) {
+      float val= geom->coords[3*i+j];
+      if (i==0 || val<geom->min[j]) geom->min[j]= val;
+      if (i==0 || val>geom->max[j]) geom->max[j]= val;
+    }
+    if (geom->normals) {
+      float *n= geom->normals + 3*i;
+      len= sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+      if (!(len > 0.0)) {
+	/* glTF requires unit normals, so a null one gets a stand-in */
+	n[0]= 0.0; n[1]= 0.0; n[2]= 1.0;
+      }
+      else if (len != 1.0) {
+	n[0] /= len; n[1] /= len; n[2] /= len;
+      }
+    }
+    if (geom->colors && geom->colors[4*i+3] < 1.0) geom->translucent= 1;
+  }
+}
+
+static void map_color( P_Renderer *self, float val,
+		      float *r, float *g, float *b, float *a )
+/* This routine invokes the color map. */
+{
+  /* no debugging; called too often */
+
+  /* Scale, clip, and map. */
+  val= ( val-MAP_MIN(self) )/( MAP_MAX(self)-MAP_MIN(self) );
+  if ( val > 1.0 ) val= 1.0;
+  if ( val < 0.0 ) val= 0.0;
+  (*MAP_FUN(self))( &val, r, g, b, a );
+}
+
+static int facet_vertex( int *facet, int i )
+{
+  return( facet ? facet[i] : i );
+}
+
+static unsigned int *triangulate( float *coords, int *facet, int n,
+				  unsigned int *index )
+/* This routine splits a facet of n vertices into n-2 triangles, writing
+ * their indices at index and returning the next free slot.  A null
+ * facet means the vertices in order.  Convex facets become a fan from
+ * the first vertex.  Others are projected onto the coordinate plane
+ * most nearly parallel to them and split by clipping ears, so concave
+ * facets are drawn correctly.  If no ear can be found, as happens for
+ * self-intersecting facets, the remainder is drawn as a fan.
+ */
+{
+  float normal[3], *p, *q, *r;
+  float *u, *v, cross;
+  int *ring;
+  int uaxis, vaxis, i, j, k, m, prev, next, guard, convex;
+
+  if (n<3) return( index );
+
+  /* Newell's method gives the facet normal */
+  normal[0]= normal[1]= normal[2]= 0.0;
+  for (i=0; i<n; i++) {
+    p= coords + 3*facet_vertex(facet, i);
+    q= coords + 3*facet_vertex(facet, (i+1)%n);
+    normal[0] += (p[1]-q[1])*(p[2]+q[2]);
+    normal[1] += (p[2]-q[2])*(p[0]+q[0]);
+    normal[2] += (p[0]-q[0])*(p[1]+q[1]);
+  }
+  if (fabs(normal[0])>=fabs(normal[1]) && fabs(normal[0])>=fabs(normal[2])) {
+    uaxis= 1; vaxis= 2; k= 0;
+  }
+  else if (fabs(normal[1])>=fabs(normal[2])) {
+    uaxis= 2; vaxis= 0; k= 1;
+  }
+  else {
+    uaxis= 0; vaxis= 1; k= 2;
+  }
+  /* Swapping the axes makes the facet run counterclockwise in (u,v) */
+  if (normal[k]<0.0) {
+    i= uaxis; uaxis= vaxis; vaxis= i;
+  }
+
+  /* Triangles and degenerate facets need no more work */
+  convex= (n==3 || normal[k]==0.0);
+  if (!convex) {
+    convex= 1;
+    for (i=0; i<n && convex; i++) {
+      p= coords + 3*facet_vertex(facet, i);
+      q= coords + 3*facet_vertex(facet, (i+1)%n);
+      r= coords + 3*facet_vertex(facet, (i+2)%n);
+      cross= (q[uaxis]-p[uaxis])*(r[vaxis]-q[vaxis])
+	- (q[vaxis]-p[vaxis])*(r[uaxis]-q[uaxis]);
+      if (cross<0.0) convex= 0;
+    }
+  }
+  if (convex) {
+    for (i=1; i<n-1; i++) {
+      *index++= facet_vertex(facet, 0);
+      *index++= facet_vertex(facet, i);
+      *index++= facet_vertex(facet, i+1);
+    }
+    return( index );
+  }
+
+  if ( !(ring= (int *)malloc(n*sizeof(int)))
+      || !(u= (float *)malloc(2*n*sizeof(float))) )
+    ger_fatal("gltf_ren_mthd: triangulate: unable to allocate %d bytes!",
+	      n*(sizeof(int)+2*sizeof(float)));
+  v= u + n;
+  for (i=0; i<n; i++) {
+    p= coords + 3*facet_vertex(facet, i);
+    ring[i]= i;
+    u[i]= p[uaxis];
+    v[i]= p[vaxis];
+  }
+
+  /* Clip ears until a triangle is left */
+  m= n;
+  i= 0;
+  guard= 0;
+  while (m>3 && guard<m) {
+    prev= ring[(i+m-1)%m];
+    next= ring[(i+1)%m];
+    cross= (u[ring[i]]-u[prev])*(v[next]-v[ring[i]])
+      - (v[ring[i]]-v[prev])*(u[next]-u[ring[i]]);
+    if (cross>0.0) {
+      /* It is an ear if no other vertex lies within it */
+      for (j=0; j<m; j++) {
+	int c= ring[j];
+	if (c==prev || c==ring[i] || c==next) continue;
+	if ((u[ring[i]]-u[prev])*(v[c]-v[prev])
+	    - (v[ring[i]]-v[prev])*(u[c]-u[prev]) >= 0.0
+	    && (u[next]-u[ring[i]])*(v[c]-v[ring[i]])
+	    - (v[next]-v[ring[i]])*(u[c]-u[ring[i]]) >= 0.0
+	    && (u[prev]-u[next])*(v[c]-v[next])
+	    - (v[prev]-v[next])*(u[c]-u[next]) >= 0.0) break;
+      }
+      if (j==m) {
+	*index++= facet_vertex(facet, prev);
+	*index++= facet_vertex(facet, ring[i]);
+	*index++= facet_vertex(facet, next);
+	for (j=i; j<m-1; j++) ring[j]= ring[j+1];
+	m--;
+	if (i==m) i= 0;
+	guard= 0;
+	continue;
+      }
+    }
+    i= (i+1)%m;
+    guard++;
+  }
+  for (j=1; j<m-1; j++) {
+    *index++= facet_vertex(facet, ring[0]);
+    *index++= facet_vertex(facet, ring[j]);
+    *index++= facet_vertex(facet, ring[j+1]);
+  }
+
+  free( (P_Void_ptr)u );
+  free( (P_Void_ptr)ring );
+  return( index );
+}
+
+static Gltf_Geom *cache_vlist( P_Renderer *self, P_Vlist *vlist, int mode,
+			       int *facets, int *facet_lengths, int nfacets )
+/* This routine converts a vertex list to a geometry.  If nfacets is
+ * not zero the facets are split into triangles;  facets may be null if
+ * there is a single facet using the vertices in order.
+ */
+{
+  Gltf_Geom *result;
+  unsigned int *index;
+  int has_colors, has_normals, nindices= 0, i;
+
+  ger_debug("gltf_ren_mthd: cache_vlist");
+
+  METHOD_RDY(vlist)
+  switch (vlist->type) {
+  case P3D_CVTX: has_colors= 0; has_normals= 0; break;
+  case P3D_CNVTX: has_colors= 0; has_normals= 1; break;
+  case P3D_CCVTX:
+  case P3D_CVVTX:
+  case P3D_CVVVTX: has_colors= 1; has_normals= 0; break;
+  case P3D_CCNVTX:
+  case P3D_CVNVTX: has_colors= 1; has_normals= 1; break;
+  default:
+    ger_error("gltf_ren_mthd: cache_vlist: got unknown vertex type %d!",
+	      vlist->type);
+    has_colors= 0; has_normals= 0;
+  }
+  for (i=0; i<nfacets; i++)
+    if (facet_lengths[i] > 2) nindices += 3*(facet_lengths[i]-2);
+  result= new_geom(mode, vlist->length, has_normals, has_colors, nindices);
+
+  po_vlist_copy(vlist, P3D_VX, 3, result->coords, 3);
+  if (has_normals) po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+  if (has_colors) {
+    if (vlist->type==P3D_CCVTX || vlist->type==P3D_CCNVTX)
+      po_vlist_copy(vlist, P3D_VR, 4, result->colors, 4);
+    else {
+      /* Map the values in place */
+      po_vlist_copy(vlist, P3D_VV, 1, result->colors, 4);
+      for (i=0; i<vlist->length; i++) {
+	float *c= result->colors + 4*i;
+	map_color( self, c[0], c, c+1, c+2, c+3 );
+      }
+    }
+  }
+
+  index= result->indices;
+  for (i=0; i<nfacets; i++) {
+    index= triangulate(result->coords, facets, facet_lengths[i], index);
+    if (facets) facets += facet_lengths[i];
+  }
+
+  finish_geom(result);
+  return( result );
+}
+
+static Gltf_Geom *make_sphere(void)
+/* This routine tesselates the unit sphere */
+{
+  int nlon= SPHERE_LONGITUDES+1;
+  Gltf_Geom *result= new_geom(GLTF_TRIANGLES,
+			      (SPHERE_LATITUDES+1)*nlon, 1, 0,
+			      6*SPHERE_LATITUDES*SPHERE_LONGITUDES);
+  unsigned int *index= result->indices;
+  int i, j, v;
+
+  for (i=0; i<=SPHERE_LATITUDES; i++) {
+    double theta= M_PI*i/SPHERE_LATITUDES;
+    for (j=0; j<nlon; j++) {
+      double phi= 2.0*M_PI*j/SPHERE_LONGITUDES;
+      v= 3*(i*nlon+j);
+      result->coords[v]= result->normals[v]= sin(theta)*cos(phi);
+      result->coords[v+1]= result->normals[v+1]= sin(theta)*sin(phi);
+      result->coords[v+2]= result->normals[v+2]= cos(theta);
+    }
+  }
+  for (i=0; i<SPHERE_LATITUDES; i++)
+    for (j=0; j<SPHERE_LONGITUDES; j++) {
+      v= i*nlon+j;
+      *index++= v; *index++= v+nlon; *index++= v+nlon+1;
+      *index++= v; *index++= v+nlon+1; *index++= v+1;
+    }
+
+  finish_geom(result);
+  return( result );
+}
+
+static Gltf_Geom *make_cylinder(void)
+/* This routine tesselates the unit cylinder, which runs from the origin
+ * to (0,0,1), with its end caps.
+ */
+{
+  int n= CYLINDER_DIVISIONS+1;
+  Gltf_Geom *result= new_geom(GLTF_TRIANGLES, 4*n+2, 1, 0,
+			      12*CYLINDER_DIVISIONS);
+  float *c= result->coords, *nrm= result->normals;
+  unsigned int *index= result->indices;
+  int bottom= 2*n, top= 3*n, center= 4*n;
+  int j, v;
+
+  /* The side vertices alternate between the bottom and top edges;  the
+   * rims of the end caps follow, and then the centers of the caps.
+   */
+  for (j=0; j<n; j++) {
+    double phi= 2.0*M_PI*j/CYLINDER_DIVISIONS;
+    float x= cos(phi), y= sin(phi);
+    v= 6*j;
+    c[v]= c[v+3]= nrm[v]= nrm[v+3]= x;
+    c[v+1]= c[v+4]= nrm[v+1]= nrm[v+4]= y;
+    c[v+2]= nrm[v+2]= nrm[v+5]= 0.0;
+    c[v+5]= 1.0;
+    v= 3*(bottom+j);
+    c[v]= x; c[v+1]= y; c[v+2]= 0.0;
+    nrm[v]= nrm[v+1]= 0.0; nrm[v+2]= -1.0;
+    v= 3*(top+j);
+    c[v]= x; c[v+1]= y; c[v+2]= 1.0;
+    nrm[v]= nrm[v+1]= 0.0; nrm[v+2]= 1.0;
+  }
+  v= 3*center;
+  c[v]= c[v+1]= c[v+2]= c[v+3]= c[v+4]= 0.0;
+  c[v+5]= 1.0;
+  nrm[v]= nrm[v+1]= nrm[v+3]= nrm[v+4]= 0.0;
+  nrm[v+2]= -1.0;
+  nrm[v+5]= 1.0;
+
+  for (j=0; j<CYLINDER_DIVISIONS; j++) {
+    int b0= 2*j, t0= 2*j+1, b1= 2*j+2, t1= 2*j+3;
+    *index++= b0; *index++= b1; *index++= t1;
+    *index++= b0; *index++= t1; *index++= t0;
+    *index++= center; *index++= bottom+j+1; *index++= bottom+j;
+    *index++= center+1; *index++= top+j; *index++= top+j+1;
+  }
+
+  finish_geom(result);
+  return( result );
+}
+
+static Gltf_Geom *make_torus(float major, float minor)
+/* This routine tesselates a torus about the z axis */
+{
+  int nminor= TORUS_MINOR_DIVISIONS+1;
+  Gltf_Geom *result= new_geom(GLTF_TRIANGLES,
+			      (TORUS_MAJOR_DIVISIONS+1)*nminor, 1, 0,
+			      6*TORUS_MAJOR_DIVISIONS*TORUS_MINOR_DIVISIONS);
+  unsigned int *index= result->indices;
+  int i, j, v;
+
+  for (i=0; i<=TORUS_MAJOR_DIVISIONS; i++) {
+    double phi= 2.0*M_PI*i/TORUS_MAJOR_DIVISIONS;
+    for (j=0; j<nminor; j++) {
+      double theta= 2.0*M_PI*j/TORUS_MINOR_DIVISIONS;
+      v= 3*(i*nminor+j);
+      result->coords[v]= (major + minor*cos(theta))*cos(phi);
+      result->coords[v+1]= (major + minor*cos(theta))*sin(phi);
+      result->coords[v+2]= minor*sin(theta);
+      result->normals[v]= cos(theta)*cos(phi);
+      result->normals[v+1]= cos(theta)*sin(phi);
+      result->normals[v+2]= sin(theta);
+    }
+  }
+  for (i=0; i<TORUS_MAJOR_DIVISIONS; i++)
+    for (j=0; j<TORUS_MINOR_DIVISIONS; j++) {
+      v= i*nminor+j;
+      *index++= v+nminor; *index++= v+nminor+1; *index++= v+1;
+      *index++= v+nminor; *index++= v+1; *index++= v;
+    }
+
+  finish_geom(result);
+  return( result );
+}
+
+static int add_segment(P_Renderer *self, void *data, int nbytes,
+		       int word_size)
+/* This routine appends data to the binary chunk, returning its offset.
+ * Every segment is padded to a multiple of 4 bytes.
+ */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+  int offset= rdata->bin_length;
+
+  if (rdata->nsegs >= rdata->seg_space) {
+    rdata->seg_space= rdata->seg_space ? 2*rdata->seg_space : 64;
+    if ( !(rdata->segs= (Gltf_Segment *)realloc(rdata->segs,
+			     rdata->seg_space*sizeof(Gltf_Segment))) )
+      ger_fatal("gltf_ren_mthd: add_segment: unable to allocate %d bytes!",
+		rdata->seg_space*sizeof(Gltf_Segment));
+  }
+  rdata->segs[rdata->nsegs].data= data;
+  rdata->segs[rdata->nsegs].nbytes= (nbytes+3) & ~3;
+  rdata->segs[rdata->nsegs].word_size= word_size;
+  rdata->bin_length += rdata->segs[rdata->nsegs].nbytes;
+  rdata->nsegs++;
+  return( offset );
+}
+
+static int add_accessor(P_Renderer *self, void *data, int count,
+			int ncomponents, int component_type, int target,
+			float *min, float *max)
+/* This routine writes a buffer view and an accessor for an array */
+{
+  static char *types[]= { "", "SCALAR", "VEC2", "VEC3", "VEC4" };
+  P_Renderer_data *rdata= RENDATA(self);
+  int word_size= (component_type == GLTF_UNSIGNED_SHORT) ? 2 : 4;
+  int nbytes= word_size*count*ncomponents;
+  int view;
+
+  view= jb_item(&(rdata->views));
+  jb_printf(&(rdata->views),
+	    "{\"buffer\":0,\"byteOffset\":%d,\"byteLength\":%d,\"target\":%d}",
+	    add_segment(self, data, nbytes, word_size), nbytes, target);
+
+  jb_item(&(rdata->accessors));
+  jb_printf(&(rdata->accessors),
+	    "{\"bufferView\":%d,\"componentType\":%d,\"count\":%d,\"type\":\"%s\"",
+	    view, component_type, count, types[ncomponents]);
+  if (min) {
+    jb_printf(&(rdata->accessors), ",\"min\":");
+    jb_floats(&(rdata->accessors), min, 3);
+    jb_printf(&(rdata->accessors), ",\"max\":");
+    jb_floats(&(rdata->accessors), max, 3);
+  }
+  jb_printf(&(rdata->accessors), "}");
+  return( rdata->accessors.count - 1 );
+}
+
+static int get_material(P_Renderer *self, Gltf_Geom *geom)
+/* This routine returns the material for a geometry drawn with the
+ * current attributes, adding it to the file if need be.  Vertex colors
+ * multiply the base color, so colored geometry gets a white base.
+ */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+  Gltf_State *state= &(rdata->state);
+  Gltf_Material mtl;
+  Json_Buf *jb= &(rdata->materials);
+  float metallic, roughness;
+  int i;
+
+  if (geom->colors) mtl.rgba[0]= mtl.rgba[1]= mtl.rgba[2]= mtl.rgba[3]= 1.0;
+  else {
+    mtl.rgba[0]= state->color.r;
+    mtl.rgba[1]= state->color.g;
+    mtl.rgba[2]= state->color.b;
+    mtl.rgba[3]= state->color.a;
+  }
+  mtl.type= state->material;
+  mtl.double_sided= !(state->backcull);
+  mtl.blend= (geom->translucent || mtl.rgba[3] < 1.0);
+
+  for (i=0; i<jb->count; i++) {
+    Gltf_Material *m= rdata->mtls + i;
+    if (m->rgba[0]==mtl.rgba[0] && m->rgba[1]==mtl.rgba[1]
+	&& m->rgba[2]==mtl.rgba[2] && m->rgba[3]==mtl.rgba[3]
+	&& m->type==mtl.type && m->double_sided==mtl.double_sided
+	&& m->blend==mtl.blend) return( i );
+  }
+
+  if (jb->count >= rdata->mtl_space) {
+    rdata->mtl_space= rdata->mtl_space ? 2*rdata->mtl_space : 16;
+    if ( !(rdata->mtls= (Gltf_Material *)realloc(rdata->mtls,
+			     rdata->mtl_space*sizeof(Gltf_Material))) )
+      ger_fatal("gltf_ren_mthd: get_material: unable to allocate %d bytes!",
+		rdata->mtl_space*sizeof(Gltf_Material));
+  }
+  rdata->mtls[jb->count]= mtl;
+
+  switch (mtl.type) {
+  case P3D_DULL_MATERIAL: metallic= 0.0; roughness= 0.9; break;
+  case P3D_SHINY_MATERIAL: metallic= 0.0; roughness= 0.3; break;
+  case P3D_METALLIC_MATERIAL: metallic= 1.0; roughness= 0.4; break;
+  case P3D_MATTE_MATERIAL: metallic= 0.0; roughness= 1.0; break;
+  case P3D_ALUMINUM_MATERIAL: metallic= 1.0; roughness= 0.5; break;
+  default: metallic= 0.0; roughness= 0.6; break;
+  }
+
+  jb_item(jb);
+  jb_printf(jb, "{\"pbrMetallicRoughness\":{\"baseColorFactor\":");
+  jb_floats(jb, mtl.rgba, 4);
+  jb_printf(jb, ",\"metallicFactor\":");
+  jb_float(jb, metallic);
+  jb_printf(jb, ",\"roughnessFactor\":");
+  jb_float(jb, roughness);
+  jb_printf(jb, "}");
+  if (mtl.double_sided) jb_printf(jb, ",\"doubleSided\":true");
+  if (mtl.blend) jb_printf(jb, ",\"alphaMode\":\"BLEND\"");
+  jb_printf(jb, "}");
+  return( jb->count - 1 );
+}
+
+static int get_mesh(P_Renderer *self, Gltf_Geom *geom)
+/* This routine returns the mesh for a geometry drawn with the current
+ * attributes.  The vertex data goes into the file the first time the
+ * geometry is used in it, and is shared by all its meshes.
+ */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+  Json_Buf *jb= &(rdata->meshes);
+  Gltf_Mesh_Ref *ref;
+  int material= get_material(self, geom);
+
+  if (geom->file_serial != rdata->file_serial) {
+    free_mesh_refs(geom);
+    geom->file_serial= rdata->file_serial;
+    geom->accessors[ACC_POSITION]=
+      add_accessor(self, geom->coords, geom->nverts, 3, GLTF_FLOAT,
+		   GLTF_ARRAY_BUFFER, geom->min, geom->max);
+    geom->accessors[ACC_NORMAL]= geom->normals ?
+      add_accessor(self, geom->normals, geom->nverts, 3, GLTF_FLOAT,
+		   GLTF_ARRAY_BUFFER, NULL, NULL) : -1;
+    geom->accessors[ACC_COLOR]= geom->colors ?
+      add_accessor(self, geom->colors, geom->nverts, 4, GLTF_FLOAT,
+		   GLTF_ARRAY_BUFFER, NULL, NULL) : -1;
+    geom->accessors[ACC_INDEX]= geom->indices ?
+      add_accessor(self, geom->indices, geom->nindices, 1,
+		   geom->index_type, GLTF_ELEMENT_ARRAY_BUFFER,
+		   NULL, NULL) : -1;
+  }
+
+  for (ref= geom->meshes; ref; ref= ref->next)
+    if (ref->material == material) return( ref->mesh );
+
+  if ( !(ref= (Gltf_Mesh_Ref *)malloc(sizeof(Gltf_Mesh_Ref))) )
+    ger_fatal("gltf_ren_mthd: get_mesh: unable to allocate %d bytes!",
+	      sizeof(Gltf_Mesh_Ref));
+  ref->material= material;
+  ref->mesh= jb_item(jb);
+  ref->next= geom->meshes;
+  geom->meshes= ref;
+
+  jb_printf(jb, "{\"primitives\":[{\"attributes\":{\"POSITION\":%d",
+	    geom->accessors[ACC_POSITION]);
+  if (geom->normals)
+    jb_printf(jb, ",\"NORMAL\":%d", geom->accessors[ACC_NORMAL]);
+  if (geom->colors)
+    jb_printf(jb, ",\"COLOR_0\":%d", geom->accessors[ACC_COLOR]);
+  jb_printf(jb, "}");
+  if (geom->indices)
+    jb_printf(jb, ",\"indices\":%d", geom->accessors[ACC_INDEX]);
+  jb_printf(jb, ",\"mode\":%d,\"material\":%d}]}", geom->mode, material);
+  return( ref->mesh );
+}
+
+static void push_kid(P_Renderer *self, int node)
+/* This routine adds a node to the children of the gob being walked */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+
+  if (rdata->nkids >= rdata->kid_space) {
+    rdata->kid_space= rdata->kid_space ? 2*rdata->kid_space : 256;
+    if ( !(rdata->kids= (int *)realloc(rdata->kids,
+				       rdata->kid_space*sizeof(int))) )
+      ger_fatal("gltf_ren_mthd: push_kid: unable to allocate %d ints!",
+		rdata->kid_space);
+  }
+  rdata->kids[rdata->nkids++]= node;
+}
+
+static void add_geom_node(P_Renderer *self, Gltf_Geom *geom)
+/* This routine adds a node instancing the given geometry */
+{
+  Json_Buf *jb= &(RENDATA(self)->nodes);
+  int mesh;
+
+  if (!geom || geom->nverts==0 || (geom->indices && geom->nindices==0))
+    return;
+  mesh= get_mesh(self, geom);
+  push_kid(self, jb_item(jb));
+  jb_printf(jb, "{\"mesh\":%d}", mesh);
+}
+
+static void jb_matrix(Json_Buf *jb, float *d)
+/* This routine appends a P3D transform, which is stored by rows, as a
+ * glTF matrix, which is stored by columns.
+ */
+{
+  float m[16];
+  int i, j;
+  for (i=0; i<4; i++)
+    for (j=0; j<4; j++) m[4*j+i]= d[4*i+j];
+  jb_floats(jb, m, 16);
+}
+
+static void start_file(P_Renderer *self)
+/* This routine clears the state left from the last file */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+
+  ger_debug("gltf_ren_mthd: start_file: file #%d",FILENUM(self));
+
+  rdata->file_serial++;
+  jb_clear(&(rdata->nodes));
+  jb_clear(&(rdata->meshes));
+  jb_clear(&(rdata->materials));
+  jb_clear(&(rdata->accessors));
+  jb_clear(&(rdata->views));
+  jb_clear(&(rdata->cameras));
+  jb_clear(&(rdata->lights));
+  rdata->nsegs= 0;
+  rdata->bin_length= 0;
+  rdata->nkids= 0;
+  rdata->has_ambient= 0;
+}
+
+static P_Void_ptr def_cmap( char *name, double min, double max,
+		  void (*mapfun)(float *, float *, float *, float *, float *) )
+/* This function stores a color map definition */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Renderer_Cmap *thismap;
+  METHOD_IN
+
+  ger_debug("gltf_ren_mthd: def_cmap");
+
+  if (max == min) {
+    ger_error("gltf_ren_mthd: def_cmap: max equals min (val is %f)", max );
+    METHOD_OUT;
+    return( (P_Void_ptr)0 );
+  }
+
+  if ( RENDATA(self)->open ) {
+    if ( !(thismap= (P_Renderer_Cmap *)malloc(sizeof(P_Renderer_Cmap))) )
+      ger_fatal( "gltf_ren_mthd: def_cmap: unable to allocate %d bytes!",
+		sizeof(P_Renderer_Cmap) );
+
+    strncpy(thismap->name, name, MAXSYMBOLLENGTH-1);
+    (thismap->name)[MAXSYMBOLLENGTH-1]= '\0';
+    thismap->min= min;
+    thismap->max= max;
+    thismap->mapfun= mapfun;
+    METHOD_OUT
+    return( (P_Void_ptr)thismap );
+  }
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void install_cmap( P_Void_ptr mapdata )
+/* This method causes the given color map to become the 'current' map. */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  ger_debug("gltf_ren_mthd: install_cmap");
+  if ( RENDATA(self)->open ) {
+    if (mapdata) CUR_MAP(self)= (P_Renderer_Cmap *)mapdata;
+    else ger_error("gltf_ren_mthd: install_cmap: got null color map data.");
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_cmap( P_Void_ptr mapdata )
+/* This method causes renderer data associated with the given color map
+ * to be freed.  It must not refer to "self", because the renderer which
+ * created the data may already have been destroyed.
+ */
+{
+  ger_debug("gltf_ren_mthd: destroy_cmap");
+  if ( mapdata ) free( mapdata );
+}
+
+static P_Void_ptr def_camera( P_Camera *cam )
+/* This method defines the given camera */
+{
+  METHOD_IN
+
+  ger_debug("gltf_ren_mthd: def_camera");
+
+  METHOD_OUT
+  return( (P_Void_ptr)cam );
+}
+
+static void set_camera( P_Void_ptr primdata )
+/* This makes the given camera the current camera.  It starts a new
+ * file, whose first node holds the camera.
+ */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Renderer_data *rdata;
+  P_Camera *cam;
+  Json_Buf *jb;
+  float f[3], up[3], r[3], u[3], d[16], len, znear, zfar;
+  int i;
+  METHOD_IN
+
+  ger_debug("gltf_ren_mthd: set_camera");
+  CURRENT_CAMERA(self)= cam= (P_Camera *)primdata;
+  rdata= RENDATA(self);
+
+  start_file(self);
+  rdata->background[0]= cam->background.r;
+  rdata->background[1]= cam->background.g;
+  rdata->background[2]= cam->background.b;
+  rdata->background[3]= cam->background.a;
+
+  /* glTF cameras look down -z with y up */
+  f[0]= cam->lookat.x - cam->lookfrom.x;
+  f[1]= cam->lookat.y - cam->lookfrom.y;
+  f[2]= cam->lookat.z - cam->lookfrom.z;
+  up[0]= cam->up.x; up[1]= cam->up.y; up[2]= cam->up.z;
+  r[0]= f[1]*up[2] - f[2]*up[1];
+  r[1]= f[2]*up[0] - f[0]*up[2];
+  r[2]= f[0]*up[1] - f[1]*up[0];
+  u[0]= r[1]*f[2] - r[2]*f[1];
+  u[1]= r[2]*f[0] - r[0]*f[2];
+  u[2]= r[0]*f[1] - r[1]*f[0];
+  for (i=0; i<16; i++) d[i]= 0.0;
+  if ((len= sqrt(r[0]*r[0]+r[1]*r[1]+r[2]*r[2])) > 0.0)
+    for (i=0; i<3; i++) d[4*i]= r[i]/len;
+  if ((len= sqrt(u[0]*u[0]+u[1]*u[1]+u[2]*u[2])) > 0.0)
+    for (i=0; i<3; i++) d[4*i+1]= u[i]/len;
+  if ((len= sqrt(f[0]*f[0]+f[1]*f[1]+f[2]*f[2])) > 0.0)
+    for (i=0; i<3; i++) d[4*i+2]= -f[i]/len;
+  d[3]= cam->lookfrom.x;
+  d[7]= cam->lookfrom.y;
+  d[11]= cam->lookfrom.z;
+  d[15]= 1.0;
+
+  /* Hither and yon are given as (negative) z coordinates */
+  znear= -cam->hither;
+  zfar= -cam->yon;
+  if (znear <= 0.0) znear= 0.001*len;
+  if (znear <= 0.0) znear= 0.001;
+
+  jb= &(rdata->cameras);
+  jb_item(jb);
+  jb_printf(jb, "{\"type\":\"perspective\",\"perspective\":{\"yfov\":");
+  jb_float(jb, DegtoRad*cam->fovea);
+  jb_printf(jb, ",\"znear\":");
+  jb_float(jb, znear);
+  if (zfar > znear) {
+    jb_printf(jb, ",\"zfar\":");
+    jb_float(jb, zfar);
+  }
+  jb_printf(jb, "}}");
+
+  jb= &(rdata->nodes);
+  push_kid(self, jb_item(jb));
+  jb_printf(jb, "{\"name\":");
+  jb_string(jb, cam->name);
+  jb_printf(jb, ",\"camera\":0,\"matrix\":");
+  jb_matrix(jb, d);
+  jb_printf(jb, "}");
+
+  METHOD_OUT
+}
+
+static void destroy_camera( P_Void_ptr primdata )
+{
+  /* This method must not refer to "self", because the renderer for which
+   * the camera was defined may already have been destroyed.
+   */
+  ger_debug("gltf_ren_mthd: destroy_camera");
+}
+
+static void ren_print( VOIDLIST )
+/* This is the print method for the renderer */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  ger_debug("gltf_ren_mthd: ren_print");
+  if ( RENDATA(self)->open )
+    printf("RENDERER: glTF renderer '%s', open", self->name);
+  else printf("RENDERER: glTF renderer '%s', closed", self->name);
+  METHOD_OUT
+}
+
+static void ren_open( VOIDLIST )
+/* This is the open method for the renderer */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+  ger_debug("gltf_ren_mthd: ren_open");
+  RENDATA(self)->open= 1;
+  METHOD_OUT
+}
+
+static void ren_close( VOIDLIST )
+/* This is the close method for the renderer */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+  ger_debug("gltf_ren_mthd: ren_close");
+  RENDATA(self)->open= 0;
+  bgw_drain();
+  METHOD_OUT
+}
+
+static P_Void_ptr def_sphere(char *name)
+/* This routine defines a sphere;  all spheres share one geometry */
+{
+  METHOD_IN
+  ger_debug("gltf_ren_mthd: def_sphere");
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void ren_sphere(P_Void_ptr object_data, P_Transform *transform,
+		       P_Attrib_List *attrs)
+{
+  /* This is a primitive, so transform and attrs are guaranteed null.
+   */
+  P_Renderer *self= (P_Renderer*)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: ren_sphere");
+    add_geom_node(self, RENDATA(self)->sphere);
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_sphere( P_Void_ptr object_data )
+{
+  ger_debug("gltf_ren_mthd: destroy_sphere");
+  /* Nothing to destroy */
+}
+
+static P_Void_ptr def_cylinder(char *name)
+/* This routine defines a cylinder;  all cylinders share one geometry */
+{
+  METHOD_IN
+  ger_debug("gltf_ren_mthd: def_cylinder");
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void ren_cylinder(P_Void_ptr object_data, P_Transform *transform,
+			 P_Attrib_List *attrs)
+{
+  /* This is a primitive, so transform and attrs are guaranteed null.
+   */
+  P_Renderer *self= (P_Renderer*)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: ren_cylinder");
+    add_geom_node(self, RENDATA(self)->cylinder);
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_cylinder( P_Void_ptr object_data )
+{
+  ger_debug("gltf_ren_mthd: destroy_cylinder");
+  /* Nothing to destroy */
+}
+
+static P_Void_ptr def_torus(char *name, double major, double minor)
+/* This routine defines a torus */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    P_Void_ptr result;
+    ger_debug("gltf_ren_mthd: def_torus");
+    result= (P_Void_ptr)make_torus(major, minor);
+    METHOD_OUT
+    return( result );
+  }
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void ren_geom(P_Void_ptr object_data, P_Transform *transform,
+		     P_Attrib_List *attrs)
+{
+  /* This renders any primitive cached as a geometry.  This is a
+   * primitive, so transform and attrs are guaranteed null.
+   */
+  P_Renderer *self= (P_Renderer*)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: ren_geom");
+    add_geom_node(self, (Gltf_Geom *)object_data);
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_geom( P_Void_ptr object_data )
+{
+  ger_debug("gltf_ren_mthd: destroy_geom");
+  if (object_data) free_geom( (Gltf_Geom *)object_data );
+}
+
+static P_Void_ptr def_polymarker(char *name, P_Vlist *vlist)
+/* This routine defines a polymarker */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Void_ptr result= (P_Void_ptr)0;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_polymarker");
+    result= (P_Void_ptr)cache_vlist(self, vlist, GLTF_POINTS, NULL, NULL, 0);
+  }
+  METHOD_OUT
+  return( result );
+}
+
+static P_Void_ptr def_polyline(char *name, P_Vlist *vlist)
+/* This routine defines a polyline */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Void_ptr result= (P_Void_ptr)0;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_polyline");
+    result= (P_Void_ptr)cache_vlist(self, vlist, GLTF_LINE_STRIP,
+				    NULL, NULL, 0);
+  }
+  METHOD_OUT
+  return( result );
+}
+
+static P_Void_ptr def_polygon(char *name, P_Vlist *vlist)
+/* This routine defines a polygon, which is split into triangles */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Void_ptr result= (P_Void_ptr)0;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_polygon");
+    result= (P_Void_ptr)cache_vlist(self, vlist, GLTF_TRIANGLES,
+				    NULL, &(vlist->length), 1);
+  }
+  METHOD_OUT
+  return( result );
+}
+
+static P_Void_ptr def_tristrip(char *name, P_Vlist *vlist)
+/* This routine defines a triangle strip */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Void_ptr result= (P_Void_ptr)0;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_tristrip");
+    result= (P_Void_ptr)cache_vlist(self, vlist, GLTF_TRIANGLE_STRIP,
+				    NULL, NULL, 0);
+  }
+  METHOD_OUT
+  return( result );
+}
+
+static P_Void_ptr def_bezier(char *name, P_Vlist *vlist)
+/* This routine defines a bezier patch, which the assist object turns
+ * into a mesh.
+ */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Void_ptr result= (P_Void_ptr)0;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_bezier");
+    METHOD_RDY(ASSIST(self))
+    result= (*(ASSIST(self)->def_bezier))(vlist);
+  }
+  METHOD_OUT
+  return( result );
+}
+
+static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
+                           int *facet_lengths, int nfacets)
+/* This routine defines a general mesh, splitting each facet into
+ * triangles.
+ */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Void_ptr result= (P_Void_ptr)0;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_mesh");
+    result= (P_Void_ptr)cache_vlist(self, vlist, GLTF_TRIANGLES,
+				    indices, facet_lengths, nfacets);
+  }
+  METHOD_OUT
+  return( result );
+}
+
+static P_Void_ptr def_text( char *name, char *tstring, P_Point *location,
+                           P_Vector *u, P_Vector *v )
+/* This method defines a text string */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    Gltf_Text *result;
+    ger_debug("gltf_ren_mthd: def_text");
+
+    if ( !(result= (Gltf_Text *)malloc(sizeof(Gltf_Text))) )
+      ger_fatal("gltf_ren_mthd: def_text: unable to allocate %d bytes!",
+		sizeof(Gltf_Text));
+    if ( !(result->tstring= (char *)malloc(strlen(tstring)+1)) )
+      ger_fatal("gltf_ren_mthd: def_text: unable to allocate %d bytes!",
+		strlen(tstring)+1);
+    strcpy(result->tstring, tstring);
+    result->coords[0]= location->x;
+    result->coords[1]= location->y;
+    result->coords[2]= location->z;
+    result->coords[3]= u->x;
+    result->coords[4]= u->y;
+    result->coords[5]= u->z;
+    result->coords[6]= v->x;
+    result->coords[7]= v->y;
+    result->coords[8]= v->z;
+
+    METHOD_OUT
+    return( (P_Void_ptr)result );
+  }
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void ren_text(P_Void_ptr object_data, P_Transform *transform,
+		     P_Attrib_List *attrs)
+{
+  /* Text becomes a node whose x and y axes are the text's u and v
+   * directions, scaled by the text height.  This is a primitive, so
+   * transform and attrs are guaranteed null.
+   */
+  P_Renderer *self= (P_Renderer*)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open && object_data) {
+    Gltf_Text *data= (Gltf_Text *)object_data;
+    Json_Buf *jb= &(RENDATA(self)->nodes);
+    float *c= data->coords, h= STATE(self).text_height;
+    float u[3], v[3], d[16], len;
+    int i;
+
+    ger_debug("gltf_ren_mthd: ren_text");
+
+    /* v is made perpendicular to u, since glTF forbids shear */
+    for (i=0; i<16; i++) d[i]= 0.0;
+    for (i=0; i<3; i++) {
+      u[i]= c[3+i];
+      v[i]= c[6+i];
+    }
+    if ((len= sqrt(u[0]*u[0]+u[1]*u[1]+u[2]*u[2])) > 0.0)
+      for (i=0; i<3; i++) u[i] /= len;
+    len= u[0]*v[0] + u[1]*v[1] + u[2]*v[2];
+    for (i=0; i<3; i++) v[i] -= len*u[i];
+    if ((len= sqrt(v[0]*v[0]+v[1]*v[1]+v[2]*v[2])) > 0.0)
+      for (i=0; i<3; i++) v[i] /= len;
+    for (i=0; i<3; i++) {
+      d[4*i]= h*u[i];
+      d[4*i+1]= h*v[i];
+    }
+    d[2]= h*(u[1]*v[2] - u[2]*v[1]);
+    d[6]= h*(u[2]*v[0] - u[0]*v[2]);
+    d[10]= h*(u[0]*v[1] - u[1]*v[0]);
+    d[3]= c[0]; d[7]= c[1]; d[11]= c[2]; d[15]= 1.0;
+
+    push_kid(self, jb_item(jb));
+    jb_printf(jb, "{\"matrix\":");
+    jb_matrix(jb, d);
+    jb_printf(jb, ",\"extras\":{\"text\":");
+    jb_string(jb, data->tstring);
+    jb_printf(jb, ",\"color\":");
+    jb_floats(jb, &(STATE(self).color.r), 4);
+    jb_printf(jb, "}}");
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_text( P_Void_ptr object_data )
+{
+  Gltf_Text *data= (Gltf_Text *)object_data;
+
+  ger_debug("gltf_ren_mthd: destroy_text");
+  if (data) {
+    free( (P_Void_ptr)data->tstring );
+    free( (P_Void_ptr)data );
+  }
+}
+
+static P_Void_ptr def_light( char *name, P_Point *location, P_Color *color )
+/* This method defines a positional light source */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    Gltf_Light *result;
+    ger_debug("gltf_ren_mthd: def_light");
+    rgbify_color(color);
+    if ( !(result= (Gltf_Light *)malloc(sizeof(Gltf_Light))) )
+      ger_fatal("gltf_ren_mthd: def_light: unable to allocate %d bytes!",
+		sizeof(Gltf_Light));
+    result->location[0]= location->x;
+    result->location[1]= location->y;
+    result->location[2]= location->z;
+    result->color[0]= color->r;
+    result->color[1]= color->g;
+    result->color[2]= color->b;
+    METHOD_OUT
+    return( (P_Void_ptr)result );
+  }
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void ren_light(P_Void_ptr object_data, P_Transform *transform,
+		      P_Attrib_List *attrs)
+{
+  /* Lights are only drawn in the lighting traversal */
+  ger_debug("gltf_ren_mthd: ren_light");
+}
+
+static void traverse_light(P_Void_ptr object_data, P_Transform *transform,
+			   P_Attrib_List *attrs)
+{
+  /* This is a primitive, so transform and attrs are guaranteed null.
+   */
+  P_Renderer *self= (P_Renderer*)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open && object_data) {
+    Gltf_Light *data= (Gltf_Light *)object_data;
+    Json_Buf *jb;
+    int light;
+
+    ger_debug("gltf_ren_mthd: traverse_light");
+
+    jb= &(RENDATA(self)->lights);
+    light= jb_item(jb);
+    jb_printf(jb, "{\"type\":\"point\",\"color\":");
+    jb_floats(jb, data->color, 3);
+    jb_printf(jb, "}");
+
+    jb= &(RENDATA(self)->nodes);
+    push_kid(self, jb_item(jb));
+    jb_printf(jb, "{\"translation\":");
+    jb_floats(jb, data->location, 3);
+    jb_printf(jb, ",\"extensions\":{\"KHR_lights_punctual\":{\"light\":%d}}}",
+	      light);
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_light( P_Void_ptr object_data )
+{
+  ger_debug("gltf_ren_mthd: destroy_light");
+  if (object_data) free( object_data );
+}
+
+static P_Void_ptr def_ambient( char *name, P_Color *color )
+/* This method defines an ambient light source */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    float *result;
+    ger_debug("gltf_ren_mthd: def_ambient");
+    rgbify_color(color);
+    if ( !(result= (float *)malloc(3*sizeof(float))) )
+      ger_fatal("gltf_ren_mthd: def_ambient: unable to allocate 3 floats!");
+    result[0]= color->r;
+    result[1]= color->g;
+    result[2]= color->b;
+    METHOD_OUT
+    return( (P_Void_ptr)result );
+  }
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void ren_ambient(P_Void_ptr object_data, P_Transform *transform,
+			P_Attrib_List *attrs)
+{
+  /* Lights are only drawn in the lighting traversal */
+  ger_debug("gltf_ren_mthd: ren_ambient");
+}
+
+static void traverse_ambient(P_Void_ptr object_data, P_Transform *transform,
+			     P_Attrib_List *attrs)
+{
+  /* glTF has no ambient light, so the color is saved as scene extras.
+   * This is a primitive, so transform and attrs are guaranteed null.
+   */
+  P_Renderer *self= (P_Renderer*)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open && object_data) {
+    ger_debug("gltf_ren_mthd: traverse_ambient");
+    memcpy(RENDATA(self)->ambient, object_data, 3*sizeof(float));
+    RENDATA(self)->has_ambient= 1;
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_ambient( P_Void_ptr object_data )
+{
+  ger_debug("gltf_ren_mthd: destroy_ambient");
+  if (object_data) free( object_data );
+}
+
+static P_Void_ptr def_gob( char *name, P_Gob *gob )
+/* This method defines a gob */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: def_gob");
+    METHOD_OUT
+    return( (P_Void_ptr)gob ); /* Stash the gob where we can get it later */
+  }
+  METHOD_OUT
+  return( (P_Void_ptr)0 );
+}
+
+static void set_attrs(P_Renderer *self, P_Attrib_List *attr)
+/* This routine updates the traversal state from an attribute list */
+{
+  Gltf_State *state= &(STATE(self));
+
+  for ( ; attr; attr= attr->next) {
+    if (attr->attribute == COLORSYMBOL(self) && attr->type == P3D_COLOR) {
+      state->color= *(P_Color *)attr->value;
+      rgbify_color(&(state->color));
+    }
+    else if (attr->attribute == MATERIALSYMBOL(self)
+	     && attr->type == P3D_MATERIAL)
+      state->material= ((P_Material *)attr->value)->type;
+    else if (attr->attribute == BACKCULLSYMBOL(self)
+	     && attr->type == P3D_BOOLEAN)
+      state->backcull= *(int *)attr->value;
+    else if (attr->attribute == TEXTHEIGHTSYMBOL(self)
+	     && attr->type == P3D_FLOAT)
+      state->text_height= *(float *)attr->value;
+  }
+}
+
+static void walk_gob(P_Renderer *self, P_Gob *gob, P_Attrib_List *attr,
+		     int lighting)
+/* This routine turns a gob into a node.  The children are walked first,
+ * leaving their nodes on the node stack, so that the gob's node can
+ * list them.
+ */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+  Gltf_State saved= rdata->state;
+  P_Gob_List *kidlist;
+  Json_Buf *jb;
+  int first= rdata->nkids;
+  char *sep= "";
+  int i;
+
+  set_attrs(self, attr);
+  set_attrs(self, gob->attr);
+
+  /* The children list is kept in reverse order */
+  kidlist= gob->children;
+  if (kidlist) while (kidlist->next) kidlist= kidlist->next;
+  for ( ; kidlist; kidlist= kidlist->prev) {
+    METHOD_RDY(kidlist->gob);
+    if (lighting)
+      (*(kidlist->gob->traverselights_to_ren))(self, (P_Transform *)0,
+					       (P_Attrib_List *)0);
+    else
+      (*(kidlist->gob->render_to_ren))(self, (P_Transform *)0,
+				       (P_Attrib_List *)0);
+  }
+
+  jb= &(rdata->nodes);
+  jb_item(jb);
+  jb_printf(jb, "{");
+  if (gob->name[0]) {
+    jb_printf(jb, "\"name\":");
+    jb_string(jb, gob->name);
+    sep= ",";
+  }
+  if (gob->has_transform) {
+    jb_printf(jb, "%s\"matrix\":", sep);
+    jb_matrix(jb, gob->trans.d);
+    sep= ",";
+  }
+  if (rdata->nkids > first) {
+    jb_printf(jb, "%s\"children\":[", sep);
+    for (i=first; i<rdata->nkids; i++)
+      jb_printf(jb, (i>first) ? ",%d" : "%d", rdata->kids[i]);
+    jb_printf(jb, "]");
+  }
+  jb_printf(jb, "}");
+
+  rdata->nkids= first;
+  push_kid(self, jb->count-1);
+  rdata->state= saved;
+}
+
+static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
+		    P_Attrib_List *attr )
+/* This routine adds a gob to the file;  top level gobs (those with a
+ * transform) end the file.
+ */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: ren_gob");
+    walk_gob(self, (P_Gob *)primdata, trans ? attr : (P_Attrib_List *)0, 0);
+    if (trans) write_file(self);
+  }
+
+  METHOD_OUT
+}
+
+static void traverse_gob( P_Void_ptr primdata, P_Transform *trans,
+			  P_Attrib_List *attr )
+/* This routine adds the lights in a gob to the file */
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  METHOD_IN
+
+  if (RENDATA(self)->open) {
+    ger_debug("gltf_ren_mthd: traverse_gob");
+    walk_gob(self, (P_Gob *)primdata, trans ? attr : (P_Attrib_List *)0, 1);
+  }
+
+  METHOD_OUT
+}
+
+static void destroy_gob( P_Void_ptr primdata )
+{
+  ger_debug("gltf_ren_mthd: destroy_gob");
+  /* Nothing to destroy */
+}
+
+static void hold_gob( P_Void_ptr primdata )
+{
+  ger_debug("gltf_ren_mthd: hold_gob");
+  /* Nothing to do */
+}
+
+static void unhold_gob( P_Void_ptr primdata )
+{
+  ger_debug("gltf_ren_mthd: unhold_gob");
+  /* Nothing to do */
+}
+
+static char* generate_fname(P_Renderer *self)
+{
+  /* This routine generates numbered fnames */
+
+  char* result;
+  int len;
+  int has_index_field= P3D_FALSE;
+  int index_field_start= 0;
+  int index_field_length= 0;
+  char* runner;
+
+  ger_debug("gltf_ren_mthd: generate_fname");
+
+  len = strlen(NAME(self));
+  if ( !(result= (char*)malloc(len+32)) )
+    ger_fatal("gltf_ren_mthd: generate_fname: unable to allocate %d bytes!",
+	      len+32);
+
+  /* Scan for a field like "####" to put the model index in */
+  for (runner= NAME(self); *runner; runner++) {
+    if (*runner=='#') {
+      if (!has_index_field) index_field_start= runner - NAME(self);
+      has_index_field= P3D_TRUE;
+      index_field_length++;
+    }
+    else if (has_index_field) break;
+  }
+  if (index_field_length>10) index_field_length= 10;
+
+  if (has_index_field) {
+    char format[32];
+    if (index_field_start) strncpy(result,NAME(self),index_field_start);
+    sprintf(format,"%%.%dd",index_field_length);
+    sprintf(result+index_field_start,format,FILENUM(self));
+    strcat(result+index_field_start+index_field_length,
+	   NAME(self)+index_field_start+index_field_length);
+  }
+  else if (FILENUM(self)) {
+    /* Find the file extension */
+    int has_extension= P3D_FALSE;
+    int ext_offset= 0;
+    int ext_len= 0;
+
+    runner= NAME(self)+len-1; /* end of string */
+    while ((runner > NAME(self)) && (*runner != '/')) {
+      if (*runner=='.') {
+	has_extension= P3D_TRUE;
+	ext_offset= runner-NAME(self);
+	ext_len= len - ext_offset;
+	break;
+      }
+      runner--;
+    }
+    if (has_extension) {
+      strncpy(result, NAME(self), ext_offset+1);
+      sprintf(result+ext_offset+1,"%.4d",FILENUM(self));
+      strncat(result, NAME(self)+ext_offset,ext_len);
+    }
+    else {
+      strcpy(result, NAME(self));
+      sprintf(result+len,".%.4d",FILENUM(self));
+    }
+  }
+  else strcpy(result, NAME(self));
+
+  return result;
+}
+
+static void put_words(FILE *fp, void *data, int nbytes, int word_size)
+/* This routine writes 2 or 4 byte words in little-endian order */
+{
+  static const union { unsigned int word; unsigned char bytes[4]; }
+    probe= { 1 };
+  unsigned char buf[4096], *in= (unsigned char *)data;
+  int i, j, n;
+
+  if (probe.bytes[0]) {
+    fwrite(data, 1, nbytes, fp);
+    return;
+  }
+  while (nbytes > 0) {
+    n= (nbytes > sizeof(buf)) ? sizeof(buf) : nbytes;
+    for (i=0; i<n; i+=word_size)
+      for (j=0; j<word_size; j++) buf[i+j]= in[i+word_size-1-j];
+    fwrite(buf, 1, n, fp);
+    in += n;
+    nbytes -= n;
+  }
+}
+
+static void write_file(P_Renderer *self)
+/* This routine assembles the JSON chunk and writes the finished file */
+{
+  P_Renderer_data *rdata= RENDATA(self);
+  Json_Buf json;
+  unsigned int header[5];
+  char *fname= NULL;
+  FILE *fp;
+  int i;
+
+  ger_debug("gltf_ren_mthd: write_file");
+
+  json.text= NULL;
+  json.length= json.space= json.count= 0;
+  jb_printf(&json,
+	    "{\"asset\":{\"version\":\"2.0\",\"generator\":\"DrawP3D\"}");
+  if (rdata->lights.count)
+    jb_printf(&json, ",\"extensionsUsed\":[\"KHR_lights_punctual\"]");
+  jb_printf(&json, ",\"scene\":0,\"scenes\":[{\"nodes\":[");
+  for (i=0; i<rdata->nkids; i++)
+    jb_printf(&json, i ? ",%d" : "%d", rdata->kids[i]);
+  jb_printf(&json, "],\"extras\":{\"background\":");
+  jb_floats(&json, rdata->background, 4);
+  if (rdata->has_ambient) {
+    jb_printf(&json, ",\"ambient\":");
+    jb_floats(&json, rdata->ambient, 3);
+  }
+  jb_printf(&json, "}}]");
+  jb_section(&json, "nodes", &(rdata->nodes));
+  jb_section(&json, "cameras", &(rdata->cameras));
+  jb_section(&json, "meshes", &(rdata->meshes));
+  jb_section(&json, "materials", &(rdata->materials));
+  jb_section(&json, "accessors", &(rdata->accessors));
+  jb_section(&json, "bufferViews", &(rdata->views));
+  if (rdata->bin_length)
+    jb_printf(&json, ",\"buffers\":[{\"byteLength\":%d}]", rdata->bin_length);
+  if (rdata->lights.count) {
+    jb_printf(&json, ",\"extensions\":{\"KHR_lights_punctual\":{\"lights\":[");
+    jb_grow(&json, rdata->lights.length);
+    memcpy(json.text + json.length, rdata->lights.text, rdata->lights.length);
+    json.length += rdata->lights.length;
+    jb_printf(&json, "]}}");
+  }
+  jb_printf(&json, "}");
+  while (json.length % 4) jb_printf(&json, " ");
+
+  if (OUTFILE(self) == stdout) fp= stdout;
+  else {
+    fname= generate_fname(self);
+    if ( !(fp= bgw_fopen(fname,"wb",SYNC(self))) ) {
+      perror("gltf_ren_mthd");
+      ger_fatal("gltf_ren_mthd: write_file: Error opening <%s> for writing.",
+		fname);
+    }
+    FILENUM(self)++;
+  }
+
+  /* GLB header and JSON chunk header */
+  header[0]= GLB_MAGIC;
+  header[1]= 2;
+  header[2]= 12 + 8 + json.length
+    + (rdata->bin_length ? 8+rdata->bin_length : 0);
+  header[3]= json.length;
+  header[4]= GLB_JSON;
+  put_words(fp, header, 20, 4);
+  fwrite(json.text, 1, json.length, fp);
+  if (rdata->bin_length) {
+    header[0]= rdata->bin_length;
+    header[1]= GLB_BIN;
+    put_words(fp, header, 8, 4);
+    for (i=0; i<rdata->nsegs; i++)
+      put_words(fp, rdata->segs[i].data, rdata->segs[i].nbytes,
+		rdata->segs[i].word_size);
+  }
+
+  if (fp == stdout) fflush(fp);
+  else {
+    if ( fclose(fp) == EOF ) {
+      perror("gltf_ren_mthd: write_file:");
+      ger_fatal("gltf_ren_mthd: write_file: Error closing file <%s>.",
+		fname);
+    }
+    free( (P_Void_ptr)fname );
+  }
+
+  ger_debug("gltf_ren_mthd: write_file: wrote %d bytes of JSON, %d of data",
+	    json.length, rdata->bin_length);
+  jb_free(&json);
+}
+
+static void ren_destroy( VOIDLIST )
+{
+  P_Renderer *self= (P_Renderer *)po_this;
+  P_Renderer_data *rdata;
+
+  ger_debug("gltf_ren_mthd: ren_destroy");
+  if (RENDATA(self)->open) ren_close();
+  bgw_drain();
+  rdata= RENDATA(self);
+  rdata->initialized= 0;
+
+  METHOD_RDY(ASSIST(self));
+  (*(ASSIST(self)->destroy_self))();
+
+  free_geom(rdata->sphere);
+  free_geom(rdata->cylinder);
+  jb_free(&(rdata->nodes));
+  jb_free(&(rdata->meshes));
+  jb_free(&(rdata->materials));
+  jb_free(&(rdata->accessors));
+  jb_free(&(rdata->views));
+  jb_free(&(rdata->cameras));
+  jb_free(&(rdata->lights));
+  if (rdata->mtls) free( (P_Void_ptr)rdata->mtls );
+  if (rdata->segs) free( (P_Void_ptr)rdata->segs );
+  if (rdata->kids) free( (P_Void_ptr)rdata->kids );
+  free( (P_Void_ptr)NAME(self) );
+  free( (P_Void_ptr)rdata );
+  free( (P_Void_ptr)self );
+
+  METHOD_DESTROYED
+}
+
+P_Renderer *po_create_gltf_renderer( char *device, char *datastr )
+/* This routine creates a glTF renderer object */
+{
+  P_Renderer *self;
+  P_Renderer_data *rdata;
+  static int sequence_number = 0;
+
+  ger_debug("po_create_gltf_renderer: device= <%s>, datastr= <%s>",
+	    device, datastr);
+
+  /* Create memory for the renderer */
+  if ( !(self= (P_Renderer *)malloc(sizeof(P_Renderer))) )
+    ger_fatal("po_create_gltf_renderer: unable to allocate %d bytes!",
+              sizeof(P_Renderer) );
+
+  /* Create memory for object data;  zeroing it empties all the buffers */
+  if ( !(rdata= (P_Renderer_data *)calloc(1,sizeof(P_Renderer_data))) )
+    ger_fatal("po_create_gltf_renderer: unable to allocate %d bytes!",
+              sizeof(P_Renderer_data) );
+  self->object_data= (P_Void_ptr)rdata;
+
+  /* Fill out default color map */
+  strcpy(default_map.name,"default-map");
+  default_map.min= 0.0;
+  default_map.max= 1.0;
+  default_map.mapfun= default_mapfun;
+
+  /* Fill out public and private object data */
+  sprintf(self->name,"gltf%d",sequence_number++);
+  rdata->open= 0;  /* renderer created in closed state */
+
+  CUR_MAP(self)= &default_map;
+
+  if (strlen(device)) {
+    if ( !(NAME(self)= (char*)malloc(strlen(device)+1)) ) {
+      ger_fatal("po_create_gltf_renderer: unable to allocate %d chars!",
+		strlen(device)+1);
+    }
+    strcpy(NAME(self),device);
+  }
+  else {
+    if ( !(NAME(self)= (char*)malloc(32)) ) {
+      ger_fatal("po_create_gltf_renderer: unable to allocate 32 chars!");
+    }
+    strcpy(NAME(self),"DrawP3D.glb");
+  }
+
+  if ( !strcmp(device,"-") ) OUTFILE(self)= stdout;
+  else OUTFILE(self)= NULL;
+  FILENUM(self)= 0;
+  SYNC(self)= (strstr(datastr,"fsync") != NULL);
+
+  ASSIST(self)= po_create_assist(self);
+
+  CURRENT_CAMERA(self)= 0;
+
+  BACKCULLSYMBOL(self)= create_symbol("backcull");
+  TEXTHEIGHTSYMBOL(self)= create_symbol("text-height");
+  COLORSYMBOL(self)= create_symbol("color");
+  MATERIALSYMBOL(self)= create_symbol("material");
+
+  rdata->sphere= make_sphere();
+  rdata->cylinder= make_cylinder();
+  STATE(self).color.ctype= P3D_RGB;
+  STATE(self).color.r= STATE(self).color.g= STATE(self).color.b= 1.0;
+  STATE(self).color.a= 1.0;
+  STATE(self).material= P3D_DEFAULT_MATERIAL;
+  STATE(self).backcull= P3D_FALSE;
+  STATE(self).text_height= 1.0;
+
+  /* Fill in all the methods */
+  self->def_sphere= def_sphere;
+  self->ren_sphere= ren_sphere;
+  self->destroy_sphere= destroy_sphere;
+
+  self->def_cylinder= def_cylinder;
+  self->ren_cylinder= ren_cylinder;
+  self->destroy_cylinder= destroy_cylinder;
+
+  self->def_torus= def_torus;
+  self->ren_torus= ren_geom;
+  self->destroy_torus= destroy_geom;
+
+  self->def_polymarker= def_polymarker;
+  self->ren_polymarker= ren_geom;
+  self->destroy_polymarker= destroy_geom;
+
+  self->def_polyline= def_polyline;
+  self->ren_polyline= ren_geom;
+  self->destroy_polyline= destroy_geom;
+
+  self->def_polygon= def_polygon;
+  self->ren_polygon= ren_geom;
+  self->destroy_polygon= destroy_geom;
+
+  self->def_tristrip= def_tristrip;
+  self->ren_tristrip= ren_geom;
+  self->destroy_tristrip= destroy_geom;
+
+  self->def_bezier= def_bezier;
+  self->ren_bezier= ren_geom;
+  self->destroy_bezier= destroy_geom;
+
+  self->def_mesh= def_mesh;
+  self->ren_mesh= ren_geom;
+  self->destroy_mesh= destroy_geom;
+
+  self->def_text= def_text;
+  self->ren_text= ren_text;
+  self->destroy_text= destroy_text;
+
+  self->def_light= def_light;
+  self->ren_light= ren_light;
+  self->light_traverse_light= traverse_light;
+  self->destroy_light= destroy_light;
+
+  self->def_ambient= def_ambient;
+  self->ren_ambient= ren_ambient;
+  self->light_traverse_ambient= traverse_ambient;
+  self->destroy_ambient= destroy_ambient;
+
+  self->def_gob= def_gob;
+  self->ren_gob= ren_gob;
+  self->light_traverse_gob= traverse_gob;
+  self->hold_gob= hold_gob;
+  self->unhold_gob= unhold_gob;
+  self->destroy_gob= destroy_gob;
+
+  self->print= ren_print;
+  self->open= ren_open;
+  self->close= ren_close;
+  self->destroy_self= ren_destroy;
+
+  self->def_camera= def_camera;
+  self->set_camera= set_camera;
+  self->destroy_camera= destroy_camera;
+
+  self->def_cmap= def_cmap;
+  self->install_cmap= install_cmap;
+  self->destroy_cmap= destroy_cmap;
+
+  RENDATA(self)->initialized= 1;
+
+  return( self );
+}
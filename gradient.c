@@ -0,0 +1,401 @@
+/****************************************************************************
+ * gradient.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module maintains a precomputed gradient field for a volume of
+gridded data.  The isosurface routines need the gradient at both ends
+of every intersected cube edge in order to generate vertex normals.
+Each grid point is shared by up to 12 edges, and the same volume is
+often contoured at several values, so computing the field once and
+looking it up saves a great deal of redundant differencing.
+
+The cache holds gradients in index space, that is with unit grid
+spacing;  the caller scales them by the physical spacing.  It is keyed
+by the data pointer, type, dimensions, and array ordering, like the
+grid indexing in isosurf.c.  Because the key does not include the data
+values, pg_gradient_cache() must be called again to discard the cache
+if the contents of a volume change in place.
+
+Two storage formats are available.  P3D_GRADIENT_FLOAT stores three
+floats per grid point and uses the same differencing scheme as the
+on-the-fly calculation.  P3D_GRADIENT_OCT16 stores only the gradient direction as a
+pair of 16 bit octahedral coordinates, a third of the memory, at the
+cost of losing the gradient magnitude when normals are interpolated
+along an edge.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "p3dgen.h"
+#include "ge_error.h"
+#include "parallel.h"
+#include "gradient.h"
+
+/* Smallest number of planes worth handing to a separate thread */
+#define MIN_PLANES_PER_THREAD 4
+
+/* The cache itself */
+static int cache_mode= P3D_GRADIENT_NONE;
+static int cache_valid= 0;
+static int cache_datatype, cache_nx, cache_ny, cache_nz, cache_ftn_order;
+static P_Void_ptr cache_data= (P_Void_ptr)0;
+static float *float_cache= (float *)0;
+static short *oct_cache= (short *)0;
+static int stride_i, stride_j, stride_k;
+
+/* Half precision to float conversion table */
+static float *half_table= (float *)0;
+
+/* Parameters for a gradient pass, shared with the worker threads.
+ * Axis 0 is the slowest varying in memory and axis 2 the fastest;
+ * comp[] maps each memory axis to the i, j, or k gradient component.
+ */
+typedef struct grad_pass_struct {
+  int datatype;
+  P_Void_ptr data;
+  int n[3];
+  int stride[3];
+  int comp[3];
+} Grad_Pass;
+
+static float half_to_float( unsigned short h )
+/* This routine converts an IEEE 754 half precision value to float */
+{
+  int sign= (h>>15) & 0x1;
+  int exponent= (h>>10) & 0x1f;
+  int mantissa= h & 0x3ff;
+  float result;
+
+  if (exponent==0) result= ldexp( (double)mantissa, -24 );
+  else if (exponent==31) result= (mantissa ? sqrt(-1.0) : HUGE_VAL);
+  else result= ldexp( (double)(mantissa | 0x400), exponent-25 );
+
+  return( sign ? -result : result );
+}
+
+float *grad_half_table( VOIDLIST )
+/* This routine returns the half to float conversion table, building
+ * it on first use.
+ */
+{
+  int i;
+
+  if (!half_table) {
+    ger_debug("gradient: grad_half_table: building table");
+    if ( !(half_table= (float *)malloc(65536*sizeof(float))) )
+      ger_fatal("gradient: grad_half_table: unable to allocate %d bytes!",
+		65536*sizeof(float));
+    for (i=0; i<65536; i++) half_table[i]= half_to_float((unsigned short)i);
+  }
+  return( half_table );
+}
+
+float grad_sample( int datatype, P_Void_ptr data, int offset )
+/* This routine returns one sample of a typed volume as a float */
+{
+  switch (datatype) {
+  case P3D_UINT8_DATA: return( (float)((unsigned char *)data)[offset] );
+  case P3D_UINT16_DATA: return( (float)((unsigned short *)data)[offset] );
+  case P3D_INT16_DATA: return( (float)((short *)data)[offset] );
+  case P3D_HALF_DATA: 
+    return( half_table[ ((unsigned short *)data)[offset] ] );
+  default: return( ((float *)data)[offset] );
+  }
+}
+
+static void convert_row( int datatype, P_Void_ptr data, int offset, 
+			int n, float *out )
+/* This routine converts n consecutive samples to float */
+{
+  int i;
+
+  switch (datatype) {
+  case P3D_UINT8_DATA: {
+    unsigned char *p= (unsigned char *)data + offset;
+    for (i=0; i<n; i++) out[i]= (float)p[i];
+  }
+    break;
+  case P3D_UINT16_DATA: {
+    unsigned short *p= (unsigned short *)data + offset;
+    for (i=0; i<n; i++) out[i]= (float)p[i];
+  }
+    break;
+  case P3D_INT16_DATA: {
+    short *p= (short *)data + offset;
+    for (i=0; i<n; i++) out[i]= (float)p[i];
+  }
+    break;
+  case P3D_HALF_DATA: {
+    unsigned short *p= (unsigned short *)data + offset;
+    for (i=0; i<n; i++) out[i]= half_table[p[i]];
+  }
+    break;
+  default: {
+    float *p= (float *)data + offset;
+    for (i=0; i<n; i++) out[i]= p[i];
+  }
+    break;
+  }
+}
+
+static void set_weights( int idx, int n, int stride, 
+			int *offA, int *offB, float *w )
+/* This routine picks the neighbor offsets and weights for a second
+ * order derivative along one axis.  The derivative is
+ * w[0]*v(0) + w[1]*v(offA) + w[2]*v(offB), using forward differences
+ * at the ends of the axis and centered differences elsewhere.
+ */
+{
+  if (idx==0) {
+    *offA= stride; *offB= 2*stride;
+    w[0]= -1.5; w[1]= 2.0; w[2]= -0.5;
+  }
+  else if (idx==n-1) {
+    *offA= -stride; *offB= -2*stride;
+    w[0]= 1.5; w[1]= -2.0; w[2]= 0.5;
+  }
+  else {
+    *offA= stride; *offB= -stride;
+    w[0]= 0.0; w[1]= 0.5; w[2]= -0.5;
+  }
+}
+
+static void oct_encode( float x, float y, float z, short *out )
+/* This routine packs the direction of (x,y,z) into two 16 bit 
+ * octahedral coordinates.
+ */
+{
+  float norm= fabs(x) + fabs(y) + fabs(z);
+  float u, v, tmp;
+
+  if (norm==0.0) {
+    out[0]= out[1]= 0;
+    return;
+  }
+  u= x/norm;
+  v= y/norm;
+  if (z<0.0) {
+    tmp= u;
+    u= (1.0 - fabs(v)) * (tmp>=0.0 ? 1.0 : -1.0);
+    v= (1.0 - fabs(tmp)) * (v>=0.0 ? 1.0 : -1.0);
+  }
+  out[0]= (short)floor( u*32767.0 + 0.5 );
+  out[1]= (short)floor( v*32767.0 + 0.5 );
+}
+
+static void oct_decode( short *in, float *x, float *y, float *z )
+/* This routine unpacks an octahedral direction to a unit vector */
+{
+  float u= in[0]/32767.0, v= in[1]/32767.0;
+  float w= 1.0 - fabs(u) - fabs(v);
+  float tmp, norm;
+
+  if (w<0.0) {
+    tmp= u;
+    u= (1.0 - fabs(v)) * (tmp>=0.0 ? 1.0 : -1.0);
+    v= (1.0 - fabs(tmp)) * (v>=0.0 ? 1.0 : -1.0);
+  }
+  norm= sqrt( u*u + v*v + w*w );
+  *x= u/norm;
+  *y= v/norm;
+  *z= w/norm;
+}
+
+static void gradient_planes( int start, int end, int worker, 
+			    P_Void_ptr arg )
+/* This routine computes the gradient for planes start through end-1
+ * along the slowest varying axis.  Each row along the fastest axis is
+ * converted to float along with the rows it needs from the other two
+ * axes, so that the inner loops are branch free.
+ */
+{
+  Grad_Pass *pass= (Grad_Pass *)arg;
+  int n0= pass->n[0], n1= pass->n[1], n2= pass->n[2];
+  int s0= pass->stride[0], s1= pass->stride[1];
+  float *scratch, *row, *rowA0, *rowB0, *rowA1, *rowB1;
+  float *g0, *g1, *g2, *gout[3];
+  float w0[3], w1[3];
+  int a, b, c, offA0, offB0, offA1, offB1, base;
+
+  if ( !(scratch= (float *)malloc(8*n2*sizeof(float))) )
+    ger_fatal("gradient: gradient_planes: unable to allocate %d bytes!",
+	      8*n2*sizeof(float));
+  row= scratch;
+  rowA0= scratch + n2;
+  rowB0= scratch + 2*n2;
+  rowA1= scratch + 3*n2;
+  rowB1= scratch + 4*n2;
+  g0= scratch + 5*n2;
+  g1= scratch + 6*n2;
+  g2= scratch + 7*n2;
+  gout[ pass->comp[0] ]= g0;
+  gout[ pass->comp[1] ]= g1;
+  gout[ pass->comp[2] ]= g2;
+
+  for (a=start; a<end; a++) {
+    set_weights( a, n0, s0, &offA0, &offB0, w0 );
+    for (b=0; b<n1; b++) {
+      set_weights( b, n1, s1, &offA1, &offB1, w1 );
+      base= a*s0 + b*s1;
+      convert_row( pass->datatype, pass->data, base, n2, row );
+      convert_row( pass->datatype, pass->data, base+offA0, n2, rowA0 );
+      convert_row( pass->datatype, pass->data, base+offB0, n2, rowB0 );
+      convert_row( pass->datatype, pass->data, base+offA1, n2, rowA1 );
+      convert_row( pass->datatype, pass->data, base+offB1, n2, rowB1 );
+
+      for (c=0; c<n2; c++) {
+	g0[c]= w0[0]*row[c] + w0[1]*rowA0[c] + w0[2]*rowB0[c];
+	g1[c]= w1[0]*row[c] + w1[1]*rowA1[c] + w1[2]*rowB1[c];
+      }
+      g2[0]= -1.5*row[0] + 2.0*row[1] - 0.5*row[2];
+      for (c=1; c<n2-1; c++) g2[c]= 0.5*(row[c+1] - row[c-1]);
+      g2[n2-1]= 1.5*row[n2-1] - 2.0*row[n2-2] + 0.5*row[n2-3];
+
+      if (float_cache) {
+	float *out= float_cache + 3*base;
+	for (c=0; c<n2; c++) {
+	  *out++= gout[0][c];
+	  *out++= gout[1][c];
+	  *out++= gout[2][c];
+	}
+      }
+      else {
+	short *out= oct_cache + 2*base;
+	for (c=0; c<n2; c++) {
+	  oct_encode( gout[0][c], gout[1][c], gout[2][c], out );
+	  out += 2;
+	}
+      }
+    }
+  }
+
+  free( (P_Void_ptr)scratch );
+}
+
+static void cache_release( VOIDLIST )
+/* This routine frees any cached gradient data */
+{
+  if (float_cache) free( (P_Void_ptr)float_cache );
+  if (oct_cache) free( (P_Void_ptr)oct_cache );
+  float_cache= (float *)0;
+  oct_cache= (short *)0;
+  cache_valid= 0;
+  cache_data= (P_Void_ptr)0;
+}
+
+int grad_cache_prepare( int datatype, P_Void_ptr data, 
+		       int nx, int ny, int nz, int ftn_order )
+/* This routine makes sure the cache holds the gradient of the given
+ * volume, computing it if necessary.  It returns false if gradient
+ * caching is turned off, in which case the caller should difference
+ * the data itself.  All dimensions must be at least 3.
+ */
+{
+  Grad_Pass pass;
+  int npts;
+
+  if (cache_mode==P3D_GRADIENT_NONE) return( 0 );
+
+  if ( cache_valid && (cache_data==data) && (cache_datatype==datatype)
+      && (cache_nx==nx) && (cache_ny==ny) && (cache_nz==nz)
+      && (cache_ftn_order==ftn_order) ) return( 1 );
+
+  ger_debug("gradient: grad_cache_prepare: computing %d by %d by %d field",
+	    nx, ny, nz);
+
+  cache_release();
+  npts= nx*ny*nz;
+  if (cache_mode==P3D_GRADIENT_OCT16) {
+    if ( !(oct_cache= (short *)malloc(2*npts*sizeof(short))) ) {
+      ger_error("gradient: grad_cache_prepare: unable to allocate %d bytes!",
+		2*npts*sizeof(short));
+      return( 0 );
+    }
+  }
+  else {
+    if ( !(float_cache= (float *)malloc(3*npts*sizeof(float))) ) {
+      ger_error("gradient: grad_cache_prepare: unable to allocate %d bytes!",
+		3*npts*sizeof(float));
+      return( 0 );
+    }
+  }
+  if (datatype==P3D_HALF_DATA) (void)grad_half_table();
+
+  if (ftn_order) {
+    stride_i= 1; stride_j= nx; stride_k= nx*ny;
+    pass.n[0]= nz; pass.n[1]= ny; pass.n[2]= nx;
+    pass.comp[0]= 2; pass.comp[1]= 1; pass.comp[2]= 0;
+  }
+  else {
+    stride_i= ny*nz; stride_j= nz; stride_k= 1;
+    pass.n[0]= nx; pass.n[1]= ny; pass.n[2]= nz;
+    pass.comp[0]= 0; pass.comp[1]= 1; pass.comp[2]= 2;
+  }
+  pass.stride[0]= pass.n[1]*pass.n[2];
+  pass.stride[1]= pass.n[2];
+  pass.stride[2]= 1;
+  pass.datatype= datatype;
+  pass.data= data;
+
+  par_for( pass.n[0], MIN_PLANES_PER_THREAD, gradient_planes, 
+	  (P_Void_ptr)&pass );
+
+  cache_valid= 1;
+  cache_data= data;
+  cache_datatype= datatype;
+  cache_nx= nx;
+  cache_ny= ny;
+  cache_nz= nz;
+  cache_ftn_order= ftn_order;
+  return( 1 );
+}
+
+void grad_cache_fetch( int i, int j, int k, float *gi, float *gj, float *gk )
+/* This routine returns the cached index space gradient at a grid point.
+ * In P3D_GRADIENT_OCT16 mode only the direction is meaningful.
+ */
+{
+  int offset= i*stride_i + j*stride_j + k*stride_k;
+
+  if (float_cache) {
+    float *p= float_cache + 3*offset;
+    *gi= p[0];
+    *gj= p[1];
+    *gk= p[2];
+  }
+  else oct_decode( oct_cache + 2*offset, gi, gj, gk );
+}
+
+int pg_gradient_cache( int mode )
+/* This routine selects the gradient cache storage format, or turns
+ * caching off with P3D_GRADIENT_NONE.  Any existing cache is discarded,
+ * so this also serves to flush the cache after volume data has been
+ * modified in place.
+ */
+{
+  ger_debug("pg_gradient_cache: mode %d", mode);
+
+  if ( (mode!=P3D_GRADIENT_NONE) && (mode!=P3D_GRADIENT_FLOAT)
+      && (mode!=P3D_GRADIENT_OCT16) ) {
+    ger_error("pg_gradient_cache: unknown mode %d; call ignored.", mode);
+    return( P3D_FAILURE );
+  }
+
+  cache_release();
+  cache_mode= mode;
+  return( P3D_SUCCESS );
+}
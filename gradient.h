@@ -0,0 +1,33 @@
+/****************************************************************************
+ * gradient.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the gradient cache package
+gradient.c, which is shared by the regular and irregular isosurface
+routines.
+*/
+
+#ifndef INCL_GRADIENT_H
+#define INCL_GRADIENT_H
+
+extern float *grad_half_table( void );
+extern float grad_sample( int datatype, P_Void_ptr data, int offset );
+extern int grad_cache_prepare( int datatype, P_Void_ptr data, 
+			       int nx, int ny, int nz, int ftn_order );
+extern void grad_cache_fetch( int i, int j, int k, 
+			      float *gi, float *gj, float *gk );
+
+#endif /* INCL_GRADIENT_H */
@@ -26,7 +26,8 @@ their cases 3, 6, and 7.  The isosurface is generated essentially by
 treating each cell as a rectangular prism to extract any isosurface
 crossings of the cell, and then mapping the resulting polygons back
 to the real coordinate system of the grid using a user-supplied
-coordinate conversion function.
+coordinate conversion function, batched coordinate conversion function,
+or arrays of precomputed grid coordinates.
 */
 
 /*
@@ -101,9 +102,12 @@ coordinate conversion function.
 */
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include "p3dgen.h"
 #include "ge_error.h"
+#include "gradient.h"
+#include "decimate.h"
 
 /* Structure from which to build list of vertices */
 typedef struct P_Vertex_struct {
@@ -112,6 +116,7 @@ typedef struct P_Vertex_struct {
   float y;
   float z;
   float value;
+  float normal[3];
   struct P_Vertex_struct *next;
   int index;
 } P_Vertex;
@@ -136,15 +141,42 @@ static float contour_value;
 static int flip_normals= 0;
 static int nx, ny, nz;
 static int ftn_order_flag= 0; /* true if left array index increments fastest */
+static int use_grad_cache= 0; /* true if normals are being generated */
 
 /* Macros which access data and test for inside-ness */
 #define ACCESS( grid, i, j, k ) \
   (ftn_order_flag ? grid[k][j][i] : grid[i][j][k])
 #define IN_CHECK( i, j, k ) (ACCESS( grid, i, j, k ) >= contour_value)
 
-/* Coordinate transfer function */
+/* Sources of grid point coordinates */
+#define COORD_SRC_FUN 0
+#define COORD_SRC_BATCH 1
+#define COORD_SRC_RECT 2
+#define COORD_SRC_CURV 3
+static int coord_source= COORD_SRC_FUN;
+
+/* Coordinate transfer function, batched coordinate transfer function, 
+ * and precomputed coordinate arrays.  Only the ones matching the
+ * coordinate source are valid.
+ */
 static void (*coord_trans_fun)(float *, float *, float *, 
 			       int *, int *, int *);
+static void (*coord_batch_fun)(float *, float *, float *, 
+			       int *, int *, int *, int *);
+static float *xcoords= (float *)0, *ycoords= (float *)0, *zcoords= (float *)0;
+
+/* Coordinates from the transfer functions are cached a plane at a time.
+ * Normal calculation looks as far as two planes either side of the
+ * pair being worked on, so a ring of 8 planes never discards a
+ * plane that is still in use.  Each plane holds all the x values,
+ * then the y's, then the z's, so that a batch function can fill it
+ * directly.
+ */
+#define COORD_PLANES 8
+static float *coord_plane[COORD_PLANES];
+static unsigned char *coord_known[COORD_PLANES];
+static int coord_plane_k[COORD_PLANES];
+static int *batch_i= (int *)0, *batch_j= (int *)0, *batch_k= (int *)0;
 
 /* handles for the data structures for the data grid and the
  * areas in which data from previous calculations are saved
@@ -336,6 +368,147 @@ static void cleanup( VOIDLIST )
   triangle_count= 0;
 }
 
+static void fill_coord_plane( int slot, int k )
+/* This routine evaluates all the coordinates of plane k with a single
+ * call to the batched coordinate transfer function.
+ */
+{
+  int plane_size= nx*ny;
+  int i, j, offset= ftn_order_flag ? 1 : 0;
+  float *plane= coord_plane[slot];
+
+  for (j=0; j<ny; j++)
+    for (i=0; i<nx; i++) {
+      batch_i[j*nx+i]= i + offset;
+      batch_j[j*nx+i]= j + offset;
+      batch_k[j*nx+i]= k + offset;
+    }
+  (*coord_batch_fun)( plane, plane+plane_size, plane+2*plane_size,
+		      batch_i, batch_j, batch_k, &plane_size );
+}
+
+static void grid_coords( int i, int j, int k, float *x, float *y, float *z )
+/* This routine maps a grid point to world coordinates, allowing for
+ * the 1-based indexing expected by Fortran coordinate functions.
+ * Values from coordinate functions are cached, so each grid point is
+ * evaluated only once.
+ */
+{
+  int slot, offset;
+  float *plane;
+
+  switch (coord_source) {
+  case COORD_SRC_RECT:
+    *x= xcoords[i];
+    *y= ycoords[j];
+    *z= zcoords[k];
+    return;
+  case COORD_SRC_CURV:
+    if (ftn_order_flag) offset= (k*ny + j)*nx + i;
+    else offset= (i*ny + j)*nz + k;
+    *x= xcoords[offset];
+    *y= ycoords[offset];
+    *z= zcoords[offset];
+    return;
+  }
+
+  slot= k % COORD_PLANES;
+  plane= coord_plane[slot];
+  if (coord_plane_k[slot] != k) {
+    coord_plane_k[slot]= k;
+    if (coord_source==COORD_SRC_BATCH) fill_coord_plane( slot, k );
+    else memset( coord_known[slot], 0, nx*ny );
+  }
+
+  offset= j*nx + i;
+  if (coord_source==COORD_SRC_FUN && !coord_known[slot][offset]) {
+    if (ftn_order_flag) {
+      int i_t= i + 1;
+      int j_t= j + 1;
+      int k_t= k + 1;
+      (*coord_trans_fun)( plane+offset, plane+nx*ny+offset, 
+			 plane+2*nx*ny+offset, &i_t, &j_t, &k_t );
+    }
+    else (*coord_trans_fun)( plane+offset, plane+nx*ny+offset, 
+			    plane+2*nx*ny+offset, &i, &j, &k );
+    coord_known[slot][offset]= 1;
+  }
+  *x= plane[offset];
+  *y= plane[nx*ny+offset];
+  *z= plane[2*nx*ny+offset];
+}
+
+static void coord_deriv( int i, int j, int k, int di, int dj, int dk, 
+			int n, int idx, float *d )
+/* This routine differentiates the world coordinates along the grid 
+ * direction (di,dj,dk), using the same second order scheme as the 
+ * data gradient.  idx is the position along that direction and n the
+ * number of grid points in it.
+ */
+{
+  float x0, y0, z0, x1, y1, z1, x2, y2, z2;
+
+  if (idx==0) {
+    grid_coords( i, j, k, &x0, &y0, &z0 );
+    grid_coords( i+di, j+dj, k+dk, &x1, &y1, &z1 );
+    grid_coords( i+2*di, j+2*dj, k+2*dk, &x2, &y2, &z2 );
+    d[0]= -1.5*x0 + 2.0*x1 - 0.5*x2;
+    d[1]= -1.5*y0 + 2.0*y1 - 0.5*y2;
+    d[2]= -1.5*z0 + 2.0*z1 - 0.5*z2;
+  }
+  else if (idx==n-1) {
+    grid_coords( i, j, k, &x0, &y0, &z0 );
+    grid_coords( i-di, j-dj, k-dk, &x1, &y1, &z1 );
+    grid_coords( i-2*di, j-2*dj, k-2*dk, &x2, &y2, &z2 );
+    d[0]= 1.5*x0 - 2.0*x1 + 0.5*x2;
+    d[1]= 1.5*y0 - 2.0*y1 + 0.5*y2;
+    d[2]= 1.5*z0 - 2.0*z1 + 0.5*z2;
+  }
+  else {
+    grid_coords( i+di, j+dj, k+dk, &x1, &y1, &z1 );
+    grid_coords( i-di, j-dj, k-dk, &x2, &y2, &z2 );
+    d[0]= 0.5*(x1 - x2);
+    d[1]= 0.5*(y1 - y2);
+    d[2]= 0.5*(z1 - z2);
+  }
+}
+
+static void calc_world_gradient( int i, int j, int k, float *grad )
+/* This routine returns the gradient of the data in world coordinates
+ * at a grid point.  The cached index space gradient g is transformed
+ * by the inverse transpose of the Jacobian J of the coordinate mapping,
+ * which for columns Ji, Jj, Jk is
+ * (gi*(Jj x Jk) + gj*(Jk x Ji) + gk*(Ji x Jj))/det(J).
+ */
+{
+  float gi, gj, gk, Ji[3], Jj[3], Jk[3], cjk[3], cki[3], cij[3], det;
+
+  grad_cache_fetch( i, j, k, &gi, &gj, &gk );
+  coord_deriv( i, j, k, 1, 0, 0, nx, i, Ji );
+  coord_deriv( i, j, k, 0, 1, 0, ny, j, Jj );
+  coord_deriv( i, j, k, 0, 0, 1, nz, k, Jk );
+
+  cjk[0]= Jj[1]*Jk[2] - Jj[2]*Jk[1];
+  cjk[1]= Jj[2]*Jk[0] - Jj[0]*Jk[2];
+  cjk[2]= Jj[0]*Jk[1] - Jj[1]*Jk[0];
+  cki[0]= Jk[1]*Ji[2] - Jk[2]*Ji[1];
+  cki[1]= Jk[2]*Ji[0] - Jk[0]*Ji[2];
+  cki[2]= Jk[0]*Ji[1] - Jk[1]*Ji[0];
+  cij[0]= Ji[1]*Jj[2] - Ji[2]*Jj[1];
+  cij[1]= Ji[2]*Jj[0] - Ji[0]*Jj[2];
+  cij[2]= Ji[0]*Jj[1] - Ji[1]*Jj[0];
+  det= Ji[0]*cjk[0] + Ji[1]*cjk[1] + Ji[2]*cjk[2];
+
+  if (det==0.0) {
+    /* Degenerate cell; no useful gradient */
+    grad[0]= grad[1]= grad[2]= 0.0;
+    return;
+  }
+  grad[0]= (gi*cjk[0] + gj*cki[0] + gk*cij[0])/det;
+  grad[1]= (gi*cjk[1] + gj*cki[1] + gk*cij[1])/det;
+  grad[2]= (gi*cjk[2] + gj*cki[2] + gk*cij[2])/det;
+}
+
 static P_Vertex *interp_vertex(int i1, int j1, int k1, int i2, int j2, int k2)
 /* This routine generates a vertex by interpolation. */
 {
@@ -350,20 +523,8 @@ static P_Vertex *interp_vertex(int i1, int j1, int k1, int i2, int j2, int k2)
     (ACCESS(grid,i2,j2,k2)-ACCESS(grid,i1,j1,k1));
 
   /* Calculate vertex coordinates */
-  if (ftn_order_flag) {
-    int i1_t= i1 + 1;
-    int j1_t= j1 + 1;
-    int k1_t= k1 + 1;
-    int i2_t= i2 + 1;
-    int j2_t= j2 + 1;
-    int k2_t= k2 + 1;
-    (*coord_trans_fun)( &x1, &y1, &z1, &i1_t, &j1_t, &k1_t );
-    (*coord_trans_fun)( &x2, &y2, &z2, &i2_t, &j2_t, &k2_t );
-  }
-  else {
-    (*coord_trans_fun)( &x1, &y1, &z1, &i1, &j1, &k1 );
-    (*coord_trans_fun)( &x2, &y2, &z2, &i2, &j2, &k2 );
-  }
+  grid_coords( i1, j1, k1, &x1, &y1, &z1 );
+  grid_coords( i2, j2, k2, &x2, &y2, &z2 );
   vtx->x= fraction*x1 + (1.0-fraction)*x2;
   vtx->y= fraction*y1 + (1.0-fraction)*y2;
   vtx->z= fraction*z1 + (1.0-fraction)*z2;
@@ -373,6 +534,30 @@ static P_Vertex *interp_vertex(int i1, int j1, int k1, int i2, int j2, int k2)
     vtx->value= fraction*ACCESS(valgrid,i1,j1,k1) 
       + (1.0-fraction)*ACCESS(valgrid,i2,j2,k2);
 
+  /* Calculate normal components if necessary */
+  if (use_grad_cache) {
+    float grad1[3], grad2[3], grad[3], normsqr, norm;
+    int l;
+
+    calc_world_gradient( i1, j1, k1, grad1 );
+    calc_world_gradient( i2, j2, k2, grad2 );
+    for (l=0; l<3; l++) grad[l]= fraction*grad1[l] + (1.0-fraction)*grad2[l];
+
+    /* normalize the normal; we actually want -grad for outward normals */
+    normsqr= grad[0]*grad[0] + grad[1]*grad[1] + grad[2]*grad[2];
+    if (normsqr>0.0) {
+      norm= sqrt( normsqr );
+      if (!flip_normals) norm= -norm;
+      for (l=0; l<3; l++) vtx->normal[l]= grad[l]/norm;
+    }
+    else {
+      /* Gradient is really, really small.  The best we can hope
+       * for is to get out of this with components in the neighborhood of 1.0.
+       */
+      vtx->normal[0]= vtx->normal[1]= vtx->normal[2]= 1.0/sqrt(3.0);
+    }
+  }
+
   return vtx;
 }
 
@@ -1815,10 +2000,10 @@ static void init_storage( float *data, float *valdata )
   if ( nx_last != nx ) {
     if (old_row_saver) free( (P_Void_ptr)old_row_saver );
     if ( !(old_row_saver= (P_Vertex **)malloc( nx*sizeof(P_Vertex *))) )
-      ger_fatal("isosurf: init_storage: cannot allocate %d pointers!", nx);
+      ger_fatal("irreg_isosf: init_storage: cannot allocate %d pointers!", nx);
     if (new_row_saver) free( (P_Void_ptr)new_row_saver );
     if ( !(new_row_saver= (P_Vertex **)malloc( nx*sizeof(P_Vertex *))) )
-      ger_fatal("isosurf: init_storage: cannot allocate %d pointers!", nx);
+      ger_fatal("irreg_isosf: init_storage: cannot allocate %d pointers!", nx);
   }
 
   if ( (nx_last != nx) || (ny_last != ny) ) {
@@ -1859,6 +2044,41 @@ static void init_storage( float *data, float *valdata )
       valdata_last= valdata;
     }
 
+  /* Coordinate functions are evaluated into a ring of cached planes.
+   * The cache is invalidated on every call, since the function may
+   * have changed.
+   */
+  if ( (coord_source==COORD_SRC_FUN) || (coord_source==COORD_SRC_BATCH) ) {
+    if ( (nx_last != nx) || (ny_last != ny) || !coord_plane[0] ) {
+      int plane;
+      for (plane=0; plane<COORD_PLANES; plane++) {
+	if (coord_plane[plane]) free( (P_Void_ptr)coord_plane[plane] );
+	if (coord_known[plane]) free( (P_Void_ptr)coord_known[plane] );
+	if ( !(coord_plane[plane]= (float *)malloc(3*nx*ny*sizeof(float)))
+	    || !(coord_known[plane]= (unsigned char *)malloc(nx*ny)) )
+	  ger_fatal("irreg_isosf: init_storage: cannot allocate %d bytes!",
+		    3*nx*ny*sizeof(float) + nx*ny);
+      }
+      if (batch_i) {
+	free( (P_Void_ptr)batch_i );
+	free( (P_Void_ptr)batch_j );
+	free( (P_Void_ptr)batch_k );
+	batch_i= (int *)0;
+      }
+    }
+    if ( (coord_source==COORD_SRC_BATCH) && !batch_i ) {
+      if ( !(batch_i= (int *)malloc(nx*ny*sizeof(int)))
+	  || !(batch_j= (int *)malloc(nx*ny*sizeof(int)))
+	  || !(batch_k= (int *)malloc(nx*ny*sizeof(int))) )
+	ger_fatal("irreg_isosf: init_storage: cannot allocate %d bytes!",
+		  3*nx*ny*sizeof(int));
+    }
+    {
+      int plane;
+      for (plane=0; plane<COORD_PLANES; plane++) coord_plane_k[plane]= -1;
+    }
+  }
+
   nx_last= nx;
   ny_last= ny;
   nz_last= nz;
@@ -1913,8 +2133,13 @@ static int convert_to_p3d(VOIDLIST)
     *runner++= thisvtx->x;
     *runner++= thisvtx->y;
     *runner++= thisvtx->z;
-    if (current_type==P3D_CVVTX)
+    if ( (current_type==P3D_CVVTX) || (current_type==P3D_CVNVTX) )
       *runner++= thisvtx->value;
+    if ( (current_type==P3D_CNVTX) || (current_type==P3D_CVNVTX) ) {
+      *runner++= thisvtx->normal[0];
+      *runner++= thisvtx->normal[1];
+      *runner++= thisvtx->normal[2];
+    }
     thisvtx->index= i++;
     thisvtx= thisvtx->next;
   }
@@ -1935,7 +2160,7 @@ static int convert_to_p3d(VOIDLIST)
 
   /* Generate the P3DGen mesh */
   if (triangle_count>0)
-    retcode= pg_mesh( po_create_cvlist(current_type, vertex_count, vtxdata),
+    retcode= dec_mesh( po_create_cvlist(current_type, vertex_count, vtxdata),
 		      indices, facet_lengths, triangle_count );
 
   /* Free buffers */
@@ -1946,18 +2171,17 @@ static int convert_to_p3d(VOIDLIST)
   return(retcode);
 }
 
-int pg_irreg_isosurf( int type, float *data, float *valdata, 
-		     int nx_in, int ny_in, int nz_in, 
-		     double value, 
-		     void (*coordfun)(float *, float *, float *, 
-				      int *, int *, int *),
-		     int show_inside, int ftn_order )
+static int irreg_isosurf( int type, float *data, float *valdata, 
+			 int nx_in, int ny_in, int nz_in, double value,
+			 int show_inside, int ftn_order )
+/* This routine does the work for all the irregular isosurface entry
+ * points, once they have set up the source of grid coordinates.
+ */
 {
   int retcode;
 
   ger_debug("pg_irreg_isosf: nx= %d, ny= %d, nz= %d", nx_in, ny_in, nz_in);
 
-  current_type= type;
   contour_value= value;
   nx= nx_in;
   ny= ny_in;
@@ -1985,12 +2209,15 @@ int pg_irreg_isosurf( int type, float *data, float *valdata,
     return(P3D_FAILURE);
   }
 
-  if (!coordfun) {
- ger_error("pg_irreg_isosf: no coordinate conversion function; call ignored.");
-    return(P3D_FAILURE);
+  /* Normals can only be generated from a cached gradient field */
+  if ( (type==P3D_CNVTX) || (type==P3D_CVNVTX) ) {
+    use_grad_cache= ( (nx>=3) && (ny>=3) && (nz>=3)
+		     && grad_cache_prepare( P3D_FLOAT_DATA, (P_Void_ptr)data,
+					   nx, ny, nz, ftn_order_flag ) );
   }
+  else use_grad_cache= 0;
 
-  if (type==P3D_CNVTX) {
+  if ( (type==P3D_CNVTX) && !use_grad_cache ) {
     ger_error("pg_irreg_isosf: CNVTX type invalid; using CVTX");
     type= P3D_CVTX;
   }
@@ -2005,7 +2232,7 @@ int pg_irreg_isosurf( int type, float *data, float *valdata,
     type= P3D_CVTX;
   }
 
-  if (type==P3D_CVNVTX) {
+  if ( (type==P3D_CVNVTX) && !use_grad_cache ) {
     ger_error("pg_irreg_isosf: CVNVTX type invalid; using CVVTX");
     type= P3D_CVVTX;
   }
@@ -2015,8 +2242,8 @@ int pg_irreg_isosurf( int type, float *data, float *valdata,
     type= P3D_CVVTX;
   }
 
-  /* Make global copy of coordinate transformation function */
-  coord_trans_fun= coordfun;
+  /* Make global copy of vertex type */
+  current_type= type;
 
   /* Flip normals if requested */
   if (show_inside) flip_normals= 1;
@@ -2040,3 +2267,65 @@ int pg_irreg_isosurf( int type, float *data, float *valdata,
 
   return( retcode );
 }
+
+int pg_irreg_isosurf( int type, float *data, float *valdata, 
+		     int nx_in, int ny_in, int nz_in, 
+		     double value, 
+		     void (*coordfun)(float *, float *, float *, 
+				      int *, int *, int *),
+		     int show_inside, int ftn_order )
+{
+  if (!coordfun) {
+ ger_error("pg_irreg_isosf: no coordinate conversion function; call ignored.");
+    return(P3D_FAILURE);
+  }
+
+  coord_source= COORD_SRC_FUN;
+  coord_trans_fun= coordfun;
+  return( irreg_isosurf( type, data, valdata, nx_in, ny_in, nz_in, value,
+			 show_inside, ftn_order ) );
+}
+
+int pg_irreg_isosurf_batch( int type, float *data, float *valdata, 
+			   int nx_in, int ny_in, int nz_in, 
+			   double value, 
+			   void (*batchfun)(float *, float *, float *, 
+					    int *, int *, int *, int *),
+			   int show_inside, int ftn_order )
+{
+  if (!batchfun) {
+ ger_error("pg_irreg_isosf: no coordinate conversion function; call ignored.");
+    return(P3D_FAILURE);
+  }
+
+  coord_source= COORD_SRC_BATCH;
+  coord_batch_fun= batchfun;
+  return( irreg_isosurf( type, data, valdata, nx_in, ny_in, nz_in, value,
+			 show_inside, ftn_order ) );
+}
+
+int pg_irreg_isosurf_coords( int type, float *data, float *valdata, 
+			    int nx_in, int ny_in, int nz_in, 
+			    double value, int coordtype,
+			    float *xcoords_in, float *ycoords_in,
+			    float *zcoords_in, int show_inside, int ftn_order )
+{
+  if (!xcoords_in || !ycoords_in || !zcoords_in) {
+    ger_error("pg_irreg_isosf: missing coordinate array; call ignored.");
+    return(P3D_FAILURE);
+  }
+
+  switch (coordtype) {
+  case P3D_COORD_RECTILINEAR: coord_source= COORD_SRC_RECT; break;
+  case P3D_COORD_CURVILINEAR: coord_source= COORD_SRC_CURV; break;
+  default:
+    ger_error("pg_irreg_isosf: unknown coordinate type %d; call ignored.",
+	      coordtype);
+    return(P3D_FAILURE);
+  }
+  xcoords= xcoords_in;
+  ycoords= ycoords_in;
+  zcoords= zcoords_in;
+  return( irreg_isosurf( type, data, valdata, nx_in, ny_in, nz_in, value,
+			 show_inside, ftn_order ) );
+}
@@ -20,6 +20,8 @@
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "ge_error.h"
+#include "decimate.h"
+#include "zadapt.h"
 
 #define FACET_VTX_SZ 3
 
@@ -31,6 +33,17 @@
 #define CVTX_SZ    3
 #define CVVTX_SZ   4
 
+/* Sources of grid point coordinates */
+#define COORD_SRC_FUN 0
+#define COORD_SRC_BATCH 1
+#define COORD_SRC_RECT 2
+#define COORD_SRC_CURV 3
+
+static int coord_source;
+static void (*xy_fun)( float *, float *, int *, int * );
+static void (*xy_batch_fun)( float *, float *, int *, int *, int * );
+static float *xcoords, *ycoords;
+
 
 /*
 Adds three vertices to the facet_array
@@ -82,33 +95,98 @@ static int size_per_vertex ( int *vtxtype )
   }
 }
 
+/*
+Fills in the x and y coordinates of the points, from whichever
+coordinate source is in use.  The batched function is called once 
+per row of the grid.
+*/
+
+static void get_xy( float *pt_array, int float_per_vtx, int nx, int ny,
+		   int fort )
+{
+  int i, j, tempi, tempj, offset;
+  int cy = 1, fx = 1;
+  int *ibuf, *jbuf;
+  float *xbuf, *ybuf;
+
+  if (fort)
+    fx = nx;
+  else 
+    cy = ny;
+
+  if (coord_source == COORD_SRC_BATCH) {
+    ibuf = (int *) malloc(2*nx*sizeof(int));
+    xbuf = (float *) malloc(2*nx*sizeof(float));
+    if (!ibuf || !xbuf)
+      ger_fatal("p3dgen: pg_irreg_zsurface: cannot allocate %d bytes!",
+		2*nx*(sizeof(int)+sizeof(float)));
+    jbuf = ibuf + nx;
+    ybuf = xbuf + nx;
+    for (j=0; j<ny; j++) {
+      for (i=0; i<nx; i++) {
+	ibuf[i] = fort ? i + 1 : i;
+	jbuf[i] = fort ? j + 1 : j;
+      }
+      (*xy_batch_fun) ( xbuf, ybuf, ibuf, jbuf, &nx );
+      for (i=0; i<nx; i++) {
+	*(pt_array+X+float_per_vtx*(i*ny+j)) = xbuf[i];
+	*(pt_array+Y+float_per_vtx*(i*ny+j)) = ybuf[i];
+      }
+    }
+    free(ibuf);
+    free(xbuf);
+    return;
+  }
+
+  for (j=0; j<ny; j++) {
+    for (i=0; i<nx; i++) {
+      switch (coord_source) {
+      case COORD_SRC_RECT:
+	*(pt_array+X+float_per_vtx*(i*ny+j)) = xcoords[i];
+	*(pt_array+Y+float_per_vtx*(i*ny+j)) = ycoords[j];
+	break;
+      case COORD_SRC_CURV:
+	offset = j*fx+i*cy;
+	*(pt_array+X+float_per_vtx*(i*ny+j)) = xcoords[offset];
+	*(pt_array+Y+float_per_vtx*(i*ny+j)) = ycoords[offset];
+	break;
+      default:
+	if ( fort ) {
+	  tempi = i + 1;
+	  tempj = j + 1;
+	}
+	else {
+	  tempi = i;
+	  tempj = j;
+	}
+	(*xy_fun) ( pt_array+X+float_per_vtx*(i*ny+j), 
+		    pt_array+Y+float_per_vtx*(i*ny+j),
+		    &tempi, &tempj ); 
+      }
+    }
+  }
+}
+
 /* 
-Main pg routine.  Creates a zsurface.
+Does the work for all the irregular zsurface entry points, once 
+they have set up the source of grid coordinates.
 */
 
-int pg_irreg_zsurf    ( int vtxtype, float *zdata, float *valdata, 
-                int nx, int ny,
-		void (*xyfun) ( float *, float *, int *, int *),
-		void (*testfun)( int *, float *, int *, int * ), 
-		int fort)
+static int irreg_zsurf( int vtxtype, float *zdata, float *valdata, 
+		       int nx, int ny,
+		       void (*testfun)( int *, float *, int *, int * ), 
+		       int fort)
 {
   P_Vlist *vlist;
   float *pt_array;
   int *facet_array, *facet_len_array;
   int nfacets=0, float_per_vtx, i, j;
-  int tempi, tempj;
   int a_0, a_1, a_nx, a_nx_1;
   int a_0_exclude, a_1_exclude, a_nx_exclude, a_nx_1_exclude;
   int cy = 1, fx = 1, zsurf_flag=0;
 
   if (pg_gob_open() == P3D_SUCCESS) {
   
-    if ( ! xyfun )
-       {
-       ger_error("p3dgen: pg_irreg_zsurface: must have a xy function");
-       return( P3D_FAILURE );
-       }
-
     ger_debug( "p3dgen: pg_irreg_zsurface: adding irregular zsurface" );
 
     /* calculates the necessary size for each vertex type */
@@ -116,36 +194,56 @@ int pg_irreg_zsurf    ( int vtxtype, float *zdata, float *valdata,
 
     pt_array = (float *) 
                malloc(float_per_vtx*ny*nx*sizeof(float));
-    facet_array = (int *) 
-               malloc(FACET_VTX_SZ*2*(nx-1)*(ny-1)*sizeof(int));
-    facet_len_array = (int *) 
-               malloc(2*(nx-1)*(ny-1)*sizeof(int));
-
 
     if (fort)   /* if the data was from fortran, get z in row order*/
       fx = nx;
     else 
       cy = ny;
 
+    get_xy( pt_array, float_per_vtx, nx, ny, fort );
+
     for (j=0; j<ny; j++) {          /* get the pts */
       for (i=0; i<nx; i++) {
-	  if ( fort ) {
-	    tempi = i + 1;
-	    tempj = j + 1;
-	  }
-	  else {
-	    tempi = i;
-	    tempj = j;
-	  }
-	   (*xyfun) (  pt_array+X+float_per_vtx*(i*ny+j), 
-	              pt_array+Y+float_per_vtx*(i*ny+j),
-		      &tempi, &tempj ); 
 	   *(pt_array+Z+float_per_vtx*(i*ny+j)) = *(zdata+j*fx+i*cy);
 	if (valdata)
 	  *(pt_array+CMAP+float_per_vtx*(i*ny+j) ) = *(valdata+j*fx+i*cy);
       }
     }
 
+/*
+If adaptive meshing is on, only as many triangles as are needed to
+follow the surface are generated.
+*/
+    if (za_enabled()) {
+      unsigned char *excluded= (unsigned char *)0;
+      if (testfun) {
+	int tempi, tempj, exclude;
+	if ( !(excluded= (unsigned char *)malloc(nx*ny)) )
+	  ger_fatal("p3dgen: pg_irreg_zsurface: unable to allocate %d bytes!",
+		    nx*ny);
+	for (i=0; i<nx; i++)
+	  for (j=0; j<ny; j++) {
+	    tempi= fort ? i+1 : i;
+	    tempj= fort ? j+1 : j;
+	    (*testfun)( &exclude, pt_array+(i*ny+j)*float_per_vtx+Z, 
+		       &tempi, &tempj );
+	    excluded[i*ny+j]= ( exclude != 0 );
+	  }
+      }
+      pg_open("");
+      zsurf_flag = za_mesh( vtxtype, pt_array, float_per_vtx, nx, ny,
+			    excluded );
+      dp_close();
+      if (excluded) free(excluded);
+      free(pt_array);
+      return( zsurf_flag );
+    }
+
+    facet_array = (int *) 
+               malloc(FACET_VTX_SZ*2*(nx-1)*(ny-1)*sizeof(int));
+    facet_len_array = (int *) 
+               malloc(2*(nx-1)*(ny-1)*sizeof(int));
+
 /*
 creates array of facet legths.  All facets will have 3 vertices 
 */
@@ -218,7 +316,7 @@ it tries to create a facet with an opposite orientation.
     pg_open("");
     if (nfacets>0) {
       vlist = po_create_cvlist( vtxtype, nx*ny, pt_array );
-      zsurf_flag = pg_mesh( vlist, facet_array, facet_len_array, nfacets );
+      zsurf_flag = dec_mesh( vlist, facet_array, facet_len_array, nfacets );
     }
     dp_close();
 
@@ -233,3 +331,64 @@ it tries to create a facet with an opposite orientation.
     return( P3D_FAILURE );
   }
 }
+
+/* 
+Main pg routines.  Create a zsurface, using a function, a batched 
+function, or arrays to find the coordinates of the grid points.
+*/
+
+int pg_irreg_zsurf    ( int vtxtype, float *zdata, float *valdata, 
+                int nx, int ny,
+		void (*xyfun) ( float *, float *, int *, int *),
+		void (*testfun)( int *, float *, int *, int * ), 
+		int fort)
+{
+  if ( ! xyfun )
+    {
+      ger_error("p3dgen: pg_irreg_zsurface: must have a xy function");
+      return( P3D_FAILURE );
+    }
+  coord_source = COORD_SRC_FUN;
+  xy_fun = xyfun;
+  return( irreg_zsurf( vtxtype, zdata, valdata, nx, ny, testfun, fort ) );
+}
+
+int pg_irreg_zsurf_batch ( int vtxtype, float *zdata, float *valdata, 
+                int nx, int ny,
+		void (*batchfun) ( float *, float *, int *, int *, int * ),
+		void (*testfun)( int *, float *, int *, int * ), 
+		int fort)
+{
+  if ( ! batchfun )
+    {
+      ger_error("p3dgen: pg_irreg_zsurface: must have a xy function");
+      return( P3D_FAILURE );
+    }
+  coord_source = COORD_SRC_BATCH;
+  xy_batch_fun = batchfun;
+  return( irreg_zsurf( vtxtype, zdata, valdata, nx, ny, testfun, fort ) );
+}
+
+int pg_irreg_zsurf_coords ( int vtxtype, float *zdata, float *valdata, 
+                int nx, int ny, int coordtype, 
+		float *xcoords_in, float *ycoords_in,
+		void (*testfun)( int *, float *, int *, int * ), 
+		int fort)
+{
+  if ( !xcoords_in || !ycoords_in )
+    {
+      ger_error("p3dgen: pg_irreg_zsurface: missing coordinate array");
+      return( P3D_FAILURE );
+    }
+  switch (coordtype) {
+  case P3D_COORD_RECTILINEAR: coord_source = COORD_SRC_RECT; break;
+  case P3D_COORD_CURVILINEAR: coord_source = COORD_SRC_CURV; break;
+  default:
+    ger_error("p3dgen: pg_irreg_zsurface: unknown coordinate type %d",
+	      coordtype);
+    return( P3D_FAILURE );
+  }
+  xcoords = xcoords_in;
+  ycoords = ycoords_in;
+  return( irreg_zsurf( vtxtype, zdata, valdata, nx, ny, testfun, fort ) );
+}
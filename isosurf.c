@@ -96,6 +96,8 @@ proceedings;  corrections are needed to the complements of their cases 3,
 #include <math.h>
 #include "p3dgen.h"
 #include "ge_error.h"
+#include "gradient.h"
+#include "decimate.h"
 
 /* Structure from which to build list of vertices */
 typedef struct P_Vertex_struct {
@@ -138,16 +140,27 @@ static int flip_normals= 0, left_handed_coords= 0;
 static int nx, ny, nz;
 static int ftn_order_flag= 0; /* true if left array index increments fastest */
 
-/* Macros which access data and test for inside-ness */
+static int data_type= P3D_FLOAT_DATA; /* sample type of the data grid */
+
+/* Macros which access data.  The data grid may hold any of the
+ * supported sample types, so it is indexed down to the row level only;
+ * TYPED_ACCESS supplies the element type.  ACCESS is used for the
+ * value grid, which is always float.
+ */
 #define ACCESS( grid, i, j, k ) \
   (ftn_order_flag ? grid[k][j][i] : grid[i][j][k])
-#define IN_CHECK( i, j, k ) (ACCESS( grid, i, j, k ) >= contour_value)
+#define TYPED_ACCESS( ctype, grid, i, j, k ) \
+  (ftn_order_flag ? ((ctype *)grid[k][j])[i] : ((ctype *)grid[i][j])[k])
 
 /* handles for the data structures for the data grid and the
  * areas in which data from previous calculations are saved
  */
-static float ***grid= (float ***)0;
+static P_Void_ptr **grid= (P_Void_ptr **)0;
 static float ***valgrid= (float ***)0;
+static unsigned char **old_inside= (unsigned char **)0;
+static unsigned char **new_inside= (unsigned char **)0;
+static float *half_table= (float *)0;
+static int use_grad_cache= 0; /* true if normals come from gradient.c */
 static cell_data **old_plane_saver= (cell_data **)0;
 static cell_data **new_plane_saver= (cell_data **)0;
 static P_Vertex **old_row_saver= (P_Vertex **)0;
@@ -392,6 +405,86 @@ static void cleanup( VOIDLIST )
   triangle_count= 0;
 }
 
+static float grid_value( int i, int j, int k )
+/* This routine returns the data value at the given grid point as a float */
+{
+  switch (data_type) {
+  case P3D_UINT8_DATA: 
+    return( (float)TYPED_ACCESS( unsigned char, grid, i, j, k ) );
+  case P3D_UINT16_DATA: 
+    return( (float)TYPED_ACCESS( unsigned short, grid, i, j, k ) );
+  case P3D_INT16_DATA: 
+    return( (float)TYPED_ACCESS( short, grid, i, j, k ) );
+  case P3D_HALF_DATA: 
+    return( half_table[ TYPED_ACCESS( unsigned short, grid, i, j, k ) ] );
+  default:
+    return( TYPED_ACCESS( float, grid, i, j, k ) );
+  }
+}
+
+static long int_threshold( long min, long max )
+/* This routine returns the smallest integer sample value which counts
+ * as inside the isosurface, clipped to the range min to max+1.
+ */
+{
+  double thresh= ceil( (double)contour_value );
+
+  if (thresh<min) return( min );
+  if (thresh>max) return( max+1 );
+  return( (long)thresh );
+}
+
+/* This loop fills the inside flags for plane k with a type-specific
+ * comparison.  Fortran order data is contiguous in i, C order data is
+ * contiguous in k, so the loops are arranged for the two cases.
+ */
+#define CLASSIFY_LOOP( ctype, test ) \
+  if (ftn_order_flag) { \
+    for (j=0; j<ny; j++) { \
+      ctype *row= (ctype *)grid[k][j]; \
+      for (i=0; i<nx; i++) { ctype v= row[i]; flags[i][j]= (test); } \
+    } \
+  } \
+  else { \
+    for (i=0; i<nx; i++) \
+      for (j=0; j<ny; j++) { \
+        ctype v= ((ctype *)grid[i][j])[k]; flags[i][j]= (test); \
+      } \
+  }
+
+static void classify_plane( int k, unsigned char **flags )
+/* This routine sets flags[i][j] true for every grid point in plane k
+ * at or above the contour value.  Integer types are compared against
+ * an integer threshold so that no conversions happen in the loop.
+ */
+{
+  int i, j;
+  long thresh;
+
+  switch (data_type) {
+  case P3D_UINT8_DATA:
+    thresh= int_threshold( 0, 255 );
+    CLASSIFY_LOOP( unsigned char, (v >= thresh) );
+    break;
+  case P3D_UINT16_DATA:
+    thresh= int_threshold( 0, 65535 );
+    CLASSIFY_LOOP( unsigned short, (v >= thresh) );
+    break;
+  case P3D_INT16_DATA:
+    thresh= int_threshold( -32768, 32767 );
+    CLASSIFY_LOOP( short, (v >= thresh) );
+    break;
+  case P3D_HALF_DATA:
+    CLASSIFY_LOOP( unsigned short, (half_table[v] >= contour_value) );
+    break;
+  default:
+    CLASSIFY_LOOP( float, (v >= contour_value) );
+    break;
+  }
+}
+
+#undef CLASSIFY_LOOP
+
 static float deriv_forwards( float v1, float v2, float v3, float step )
 /* This routine takes a first derivative to second order accuracy by
  * forward differencing.
@@ -415,31 +508,31 @@ static void calc_gradient( float *gradx, float *grady, float *gradz,
  */
 {
     if (i==0) *gradx= 
-      deriv_forwards( ACCESS(grid,0,j,k), ACCESS(grid,1,j,k), 
-		     ACCESS(grid,2,j,k), deltax );
+      deriv_forwards( grid_value(0,j,k), grid_value(1,j,k), 
+		     grid_value(2,j,k), deltax );
     else if (i==nx-1) *gradx=
-      deriv_forwards( ACCESS(grid,nx-1,j,k), ACCESS(grid,nx-2,j,k), 
-		     ACCESS(grid,nx-3,j,k), -deltax );
+      deriv_forwards( grid_value(nx-1,j,k), grid_value(nx-2,j,k), 
+		     grid_value(nx-3,j,k), -deltax );
     else *gradx=
-      deriv_centered( ACCESS(grid,i-1,j,k), ACCESS(grid,i+1,j,k), deltax );
+      deriv_centered( grid_value(i-1,j,k), grid_value(i+1,j,k), deltax );
 
     if (j==0) *grady= 
-      deriv_forwards( ACCESS(grid,i,0,k), ACCESS(grid,i,1,k), 
-		     ACCESS(grid,i,2,k), deltay );
+      deriv_forwards( grid_value(i,0,k), grid_value(i,1,k), 
+		     grid_value(i,2,k), deltay );
     else if (j==ny-1) *grady=
-      deriv_forwards( ACCESS(grid,i,ny-1,k), ACCESS(grid,i,ny-2,k), 
-		     ACCESS(grid,i,ny-3,k), -deltay );
+      deriv_forwards( grid_value(i,ny-1,k), grid_value(i,ny-2,k), 
+		     grid_value(i,ny-3,k), -deltay );
     else *grady=
-      deriv_centered( ACCESS(grid,i,j-1,k), ACCESS(grid,i,j+1,k), deltay );
+      deriv_centered( grid_value(i,j-1,k), grid_value(i,j+1,k), deltay );
 
     if (k==0) *gradz= 
-      deriv_forwards( ACCESS(grid,i,j,0), ACCESS(grid,i,j,1), 
-		     ACCESS(grid,i,j,2), deltaz );
+      deriv_forwards( grid_value(i,j,0), grid_value(i,j,1), 
+		     grid_value(i,j,2), deltaz );
     else if (k==nz-1) *gradz=
-      deriv_forwards( ACCESS(grid,i,j,nz-1), ACCESS(grid,i,j,nz-2), 
-		     ACCESS(grid,i,j,nz-3), -deltaz );
+      deriv_forwards( grid_value(i,j,nz-1), grid_value(i,j,nz-2), 
+		     grid_value(i,j,nz-3), -deltaz );
     else *gradz=
-      deriv_centered( ACCESS(grid,i,j,k-1), ACCESS(grid,i,j,k+1), deltaz );
+      deriv_centered( grid_value(i,j,k-1), grid_value(i,j,k+1), deltaz );
 }
 
 static P_Vertex *interp_vertex(int i1, int j1, int k1, int i2, int j2, int k2)
@@ -451,8 +544,8 @@ static P_Vertex *interp_vertex(int i1, int j1, int k1, int i2, int j2, int k2)
   vtx= new_vertex( current_type );
 
   /* Calculate interpolation factor */
-  fraction= (ACCESS(grid,i2,j2,k2) - contour_value) /
-    (ACCESS(grid,i2,j2,k2)-ACCESS(grid,i1,j1,k1));
+  fraction= (grid_value(i2,j2,k2) - contour_value) /
+    (grid_value(i2,j2,k2)-grid_value(i1,j1,k1));
 
   /* Calculate vertex coordinates */
   vtx->x= corner1_save->x + i1*deltax + (1.0-fraction)*(i2-i1)*deltax;
@@ -472,8 +565,16 @@ static P_Vertex *interp_vertex(int i1, int j1, int k1, int i2, int j2, int k2)
     vtx->normal= new_vector();
 
     /* Calculate normals at the endpoints */
-    calc_gradient( &grad1x, &grad1y, &grad1z, i1, j1, k1 );
-    calc_gradient( &grad2x, &grad2y, &grad2z, i2, j2, k2 );
+    if (use_grad_cache) {
+      grad_cache_fetch( i1, j1, k1, &grad1x, &grad1y, &grad1z );
+      grad_cache_fetch( i2, j2, k2, &grad2x, &grad2y, &grad2z );
+      grad1x /= deltax; grad1y /= deltay; grad1z /= deltaz;
+      grad2x /= deltax; grad2y /= deltay; grad2z /= deltaz;
+    }
+    else {
+      calc_gradient( &grad1x, &grad1y, &grad1z, i1, j1, k1 );
+      calc_gradient( &grad2x, &grad2y, &grad2z, i2, j2, k2 );
+    }
 
     /* Interpolate the normal */
     gradx= fraction*grad1x + (1.0-fraction)*grad2x;
@@ -1793,17 +1894,17 @@ static void do_general_plane( int k )
 
     for (i=0; i<nx-1; i++) {
       new_plane_saver[i][j].halfcase= 
-	(( IN_CHECK( i,j,k+1 ) ? 1 : 0 ) << 3)
-	  | (( IN_CHECK( i+1,j,k+1 ) ? 1 : 0 ) << 2)
-	    | (( IN_CHECK( i+1,j+1,k+1 ) ? 1 : 0 ) << 1)
-	      | ( IN_CHECK( i,j+1,k+1 ) ? 1 : 0 );
+	( new_inside[i][j] << 3 )
+	  | ( new_inside[i+1][j] << 2 )
+	    | ( new_inside[i+1][j+1] << 1 )
+	      | new_inside[i][j+1];
 
       if (k==0) {
 	old_plane_saver[i][j].halfcase= 
-	  (( IN_CHECK( i,j,k ) ? 1 : 0 ) << 3)
-	    | (( IN_CHECK( i+1,j,k ) ? 1 : 0 ) << 2)
-	      | (( IN_CHECK( i+1,j+1,k ) ? 1 : 0 ) << 1)
-		| ( IN_CHECK( i,j+1,k ) ? 1 : 0 );
+	  ( old_inside[i][j] << 3 )
+	    | ( old_inside[i+1][j] << 2 )
+	      | ( old_inside[i+1][j+1] << 1 )
+		| old_inside[i][j+1];
       }
 
       whichcase= (new_plane_saver[i][j].halfcase << 4) 
@@ -1836,18 +1937,24 @@ static void do_general_plane( int k )
 static void calc_isosurface(VOIDLIST)
 {
   cell_data **holder;
+  unsigned char **flag_holder;
   int k;
 
   ger_debug("isosurf: calc_isosurface:");
 
+  classify_plane( 0, old_inside );
   for (k=0; k<nz-1; k++) {
     /* do a plane */
+    classify_plane( k+1, new_inside );
     do_general_plane(k);
 
     /* swap grid plane data spaces */
     holder= new_plane_saver;
     new_plane_saver= old_plane_saver;
     old_plane_saver= holder;
+    flag_holder= new_inside;
+    new_inside= old_inside;
+    old_inside= flag_holder;
   }
 }
 
@@ -1935,13 +2042,27 @@ static P_Void_ptr **index_3d_array( P_Void_ptr data, int nx, int ny, int nz,
   return result;
 }
 
-static void init_storage( float *data, float *valdata )
+static int data_cellsize( int type )
+/* This routine returns the size in bytes of one sample of the given type */
+{
+  switch (type) {
+  case P3D_UINT8_DATA: return( sizeof(unsigned char) );
+  case P3D_UINT16_DATA: return( sizeof(unsigned short) );
+  case P3D_INT16_DATA: return( sizeof(short) );
+  case P3D_HALF_DATA: return( sizeof(unsigned short) );
+  default: return( sizeof(float) );
+  }
+}
+
+static void init_storage( P_Void_ptr data, float *valdata )
 /* This routine makes sure that the proper static global data structures
  * exist.  It is smart enough to recreate them only when necessary.
  */
 {
   static int nx_last= 0, ny_last= 0, nz_last= 0;
-  static float *data_last= 0, *valdata_last= 0;
+  static int data_type_last= P3D_FLOAT_DATA, ftn_order_last= 0;
+  static P_Void_ptr data_last= 0;
+  static float *valdata_last= 0;
 
   if ( nx_last != nx ) {
     if (old_row_saver) free( (P_Void_ptr)old_row_saver );
@@ -1965,21 +2086,35 @@ static void init_storage( float *data, float *valdata )
     }
     new_plane_saver= 
       (cell_data **)create_indexed_2d_array( nx, ny, sizeof(cell_data) );
+    if (old_inside) {
+      free( (P_Void_ptr)(old_inside[0]) );
+      free( (P_Void_ptr)old_inside );
+    }
+    old_inside= 
+      (unsigned char **)create_indexed_2d_array( nx, ny, 1 );
+    if (new_inside) {
+      free( (P_Void_ptr)(new_inside[0]) );
+      free( (P_Void_ptr)new_inside );
+    }
+    new_inside= 
+      (unsigned char **)create_indexed_2d_array( nx, ny, 1 );
   }
 
+  if (data_type==P3D_HALF_DATA) half_table= grad_half_table();
+
   /* Allocate data structures if previously allocated ones won't do */
-  if ( (data_last != data) 
+  if ( (data_last != data) || (data_type_last != data_type)
+      || (ftn_order_last != ftn_order_flag)
       || (nx_last != nx) || (ny_last != ny) || (nz_last != nz) ) {
     if (grid) {
       free( (P_Void_ptr)grid[0] );
       free( (P_Void_ptr)grid );
     }
-    grid= (float ***)index_3d_array( (P_Void_ptr)data, nx, ny, nz, 
-				    (int)sizeof(float) );
+    grid= index_3d_array( data, nx, ny, nz, data_cellsize(data_type) );
 
   }
   if ( (current_type==P3D_CVVTX) || (current_type==P3D_CVNVTX) )
-    if ( (valdata_last != valdata) 
+    if ( (valdata_last != valdata) || (ftn_order_last != ftn_order_flag)
 	|| (nx_last != nx) || (ny_last != ny) || (nz_last != nz) ) {
       if (valgrid) {
 	free( (P_Void_ptr)valgrid[0] );
@@ -1994,6 +2129,8 @@ static void init_storage( float *data, float *valdata )
   ny_last= ny;
   nz_last= nz;
   data_last= data;
+  data_type_last= data_type;
+  ftn_order_last= ftn_order_flag;
 }
 
 static int convert_to_p3d(VOIDLIST)
@@ -2071,7 +2208,7 @@ static int convert_to_p3d(VOIDLIST)
 
   /* Generate the P3DGen mesh */
   if (triangle_count>0)
-    retcode= pg_mesh( po_create_cvlist(current_type, vertex_count, vtxdata),
+    retcode= dec_mesh( po_create_cvlist(current_type, vertex_count, vtxdata),
 		      indices, facet_lengths, triangle_count );
 
   /* Free buffers */
@@ -2086,11 +2223,37 @@ int pg_isosurface( int type, float *data, float *valdata,
 		  int nx_in, int ny_in, int nz_in, 
 		  double value, P_Point *corner1, P_Point *corner2, 
 		  int show_inside, int ftn_order )
+{
+  return( pg_isosurface_typed( type, P3D_FLOAT_DATA, (P_Void_ptr)data, 
+			      valdata, nx_in, ny_in, nz_in, value, 
+			      corner1, corner2, show_inside, ftn_order ) );
+}
+
+int pg_isosurface_typed( int type, int datatype, P_Void_ptr data, 
+			float *valdata, int nx_in, int ny_in, int nz_in, 
+			double value, P_Point *corner1, P_Point *corner2, 
+			int show_inside, int ftn_order )
+/* This routine extracts an isosurface from a grid of samples of the
+ * given data type (P3D_FLOAT_DATA, P3D_UINT8_DATA, P3D_UINT16_DATA,
+ * P3D_INT16_DATA, or P3D_HALF_DATA).  The samples are classified and
+ * interpolated in place, so compact volumes need not be expanded to
+ * float first.  The valdata grid is always float.
+ */
 {
   int retcode;
 
-  ger_debug("pg_isosurface: nx= %d, ny= %d, nz= %d", nx_in, ny_in, nz_in);
+  ger_debug("pg_isosurface_typed: datatype= %d, nx= %d, ny= %d, nz= %d", 
+	    datatype, nx_in, ny_in, nz_in);
+
+  if ( (datatype!=P3D_FLOAT_DATA) && (datatype!=P3D_UINT8_DATA)
+      && (datatype!=P3D_UINT16_DATA) && (datatype!=P3D_INT16_DATA)
+      && (datatype!=P3D_HALF_DATA) ) {
+    ger_error("pg_isosurface: unknown data type %d; call ignored.",
+	      datatype);
+    return(P3D_FAILURE);
+  }
 
+  data_type= datatype;
   current_type= type;
   contour_value= value;
   nx= nx_in;
@@ -2174,6 +2337,10 @@ int pg_isosurface( int type, float *data, float *valdata,
 
   init_storage( data, valdata );
   vertex_space_setup();
+  if (type==P3D_CNVTX || type==P3D_CVNVTX)
+    use_grad_cache= grad_cache_prepare( data_type, data, nx, ny, nz, 
+				       ftn_order_flag );
+  else use_grad_cache= 0;
 
   /* Generate the isosurface.  The vertex and facet lists are stored on
    * static global pointers.
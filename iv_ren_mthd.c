@@ -17,13 +17,18 @@
 /* This module implements the Open Inventor renderer */
 
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
 #include <math.h>
 #include "ge_error.h"
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "assist.h"
+#include "bgwrite.h"
+#include "numfmt.h"
+#include "geomhash.h"
 #include "iv_ren_mthd.h"
+#include "stripify.h"
 
 /* Notes-
  * -File opening shouldn't really happen in camera setting routine
@@ -42,6 +47,26 @@ static const int torus_major_divisions=32;
 static const int torus_minor_divisions= 16;
 static P_Color default_clr = {P3D_RGB,1,1,1,1};
 
+/* Geometry already written to the current file is found in geom_table
+ * and written again as a USE of its first copy.  The key records the
+ * kind of node and the material values which a per-vertex color
+ * Material node picks up.
+ */
+#define GEOM_TABLE_SIZE 8192
+#define GEOM_POLYMARKER 0
+#define GEOM_POLYLINE 1
+#define GEOM_POLYGON 2
+#define GEOM_TRISTRIP 3
+#define GEOM_MESH 4
+#define GEOM_TORUS 5
+typedef struct geom_key_struct {
+  int kind;
+  float ambi, spec, shin;
+} Geom_Key;
+static char *geom_names[]= { "PM", "PL", "PG", "TRI", "MESH", "TOR" };
+static Gh_Table *geom_table= NULL;
+static int live_renderers= 0; /* the last one to go frees geom_table */
+
 static void output_torus_indices(P_Renderer *self);
 static void output_torus_mesh(P_Renderer *self, float major, float minor);
 static char* generate_fname();
@@ -49,12 +74,16 @@ static void set_indent(int change);
 static char* remove_spaces_from_string( char* string );
 static char* check_def(P_Gob *thisgob, FILE *outfile); /* returns use name */
 static void del_def_list(void);
+static int def_geometry(P_Renderer *self, int kind, unsigned long hash,
+			P_Void_ptr data, int (*same)(void *, void *),
+			int colored);
 static void swap_gob_type(void);
 static void renfile_startup(void);
 static void output_trans(FILE *outfile,P_Transform *trans);
 static void change_curr_mat(int type);
 static void output_attrs(P_Renderer *self, P_Attrib_List *attr);
 static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist);
+static void output_triples(P_Renderer *self,float *vals,int n);
 static P_Transform *get_oriented(P_Vector *up,P_Vector *view,P_Vector *start);
 
 
@@ -229,6 +258,7 @@ static void ren_close( VOIDLIST )
   METHOD_IN
   ger_debug("iv_ren_mthd: ren_close");
   RENDATA(self)->open= 0;
+  bgw_drain();
   METHOD_OUT
 }
 
@@ -382,7 +412,7 @@ static void output_torus_indices(P_Renderer *self)
 static void output_torus_mesh(P_Renderer *self, float major, float minor)
 {
   /* This routine calculates and outputs the coordinates and normals 
-   * to create a mesh in the shape of a torus. */
+   * to create a mesh in the shape of a torus, as a Separator node. */
 
   int torus_vertices= (torus_major_divisions+1) * (torus_minor_divisions+1);
   float theta= 0.0;
@@ -413,7 +443,7 @@ static void output_torus_mesh(P_Renderer *self, float major, float minor)
     phi += dp;
   }
   
-  fprintf(OUTFILE(self),"%sSeparator {\n",tab_buf);
+  fprintf(OUTFILE(self),"Separator {\n");
   set_indent(INCREASE);
   fprintf(OUTFILE(self),"%sNormal { vector [\n",tab_buf);
   for(i=0;i < torus_vertices;i++) {
@@ -450,9 +480,11 @@ static void ren_torus(P_Void_ptr object_data, P_Transform *transform,
 
   if (RENDATA(self)->open) {
     ger_debug("iv_ren_mthd: ren_torus");
-      
 
-    output_torus_mesh(self,torus->major,torus->minor);
+    if (def_geometry(self,GEOM_TORUS,
+		     gh_hash_torus(torus),
+		     object_data,gh_same_torus,0))
+      output_torus_mesh(self,torus->major,torus->minor);
 
   }
 
@@ -461,15 +493,8 @@ static void ren_torus(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_torus( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    ger_debug("iv_ren_mthd: destroy_torus");
-    free( object_data );
-  }
-
-  METHOD_OUT;
+  ger_debug("iv_ren_mthd: destroy_torus");
+  free( object_data );
 }
 
 static void map_color( P_Renderer *self, float val, 
@@ -568,55 +593,42 @@ static P_Cached_Vlist* cache_vlist( P_Renderer *self, P_Vlist *vlist )
 
   result->info_word= ((result->length) << 8) | (result->type & 255);
 
-  for (i=0; i<result->length; i++) {
-    result->coords[3*i]= (*(vlist->x))(i);
-    result->coords[3*i+1]= (*(vlist->y))(i);
-    result->coords[3*i+2]= (*(vlist->z))(i);
-    switch (vlist->type) {
-    case P3D_CVTX:
-      break;
-    case P3D_CNVTX:
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CCVTX:
-      result->colors[3*i]= (*(vlist->r))(i);
-      result->colors[3*i+1]= (*(vlist->g))(i);
-      result->colors[3*i+2]= (*(vlist->b))(i);
-      result->opacities[i]= (*(vlist->a))(i);
-      break;
-    case P3D_CCNVTX:
-      result->colors[3*i]= (*(vlist->r))(i);
-      result->colors[3*i+1]= (*(vlist->g))(i);
-      result->colors[3*i+2]= (*(vlist->b))(i);
-      result->opacities[i]= (*(vlist->a))(i);
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CVVTX:
-    case P3D_CVVVTX:
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
-      result->colors[3*i]= r;
-      result->colors[3*i+1]= g;
-      result->colors[3*i+2]= b;
-      result->opacities[i]= a;
-      break;
-    case P3D_CVNVTX:
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
+  po_vlist_copy(vlist, P3D_VX, 3, result->coords, 3);
+  switch (vlist->type) {
+  case P3D_CVTX:
+    break;
+  case P3D_CNVTX:
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CCVTX:
+    po_vlist_copy(vlist, P3D_VR, 3, result->colors, 3);
+    po_vlist_copy(vlist, P3D_VA, 1, result->opacities, 1);
+    break;
+  case P3D_CCNVTX:
+    po_vlist_copy(vlist, P3D_VR, 3, result->colors, 3);
+    po_vlist_copy(vlist, P3D_VA, 1, result->opacities, 1);
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CVVTX:
+  case P3D_CVVVTX:
+  case P3D_CVNVTX:
+    /* The values are mapped in place in the opacities */
+    po_vlist_copy(vlist, P3D_VV, 1, result->opacities, 1);
+    for (i=0; i<result->length; i++) {
+      map_color( self, result->opacities[i], &r, &g, &b, &a );
       result->colors[3*i]= r;
       result->colors[3*i+1]= g;
       result->colors[3*i+2]= b;
       result->opacities[i]= a;
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-      /* We've already checked that it is a known case */
     }
+    if (vlist->type==P3D_CVNVTX)
+      po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+    /* We've already checked that it is a known case */
   }
 
+  gh_hash_vlist(result);
+
   return( result );
 }
 
@@ -668,16 +680,14 @@ static P_Void_ptr def_bezier(char *name, P_Vlist *vlist)
 }
 
 static void destroy_polything( P_Void_ptr object_data )
+/* This routine frees a cached vertex list.  Like the other destroy
+ * methods it does so even if the renderer is closed, since dp_close_ren
+ * may come before the gobs holding the primitive, or the assist's
+ * cached text, are destroyed.
+ */
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    ger_debug("iv_ren_mthd: destroy_polything");
-    free_cached_vlist( (P_Cached_Vlist*)object_data );
-  }
-
-  METHOD_OUT;
+  ger_debug("iv_ren_mthd: destroy_polything");
+  free_cached_vlist( (P_Cached_Vlist*)object_data );
 }
 
 static void ren_polymarker(P_Void_ptr object_data, P_Transform *transform,
@@ -694,14 +704,17 @@ static void ren_polymarker(P_Void_ptr object_data, P_Transform *transform,
   if (RENDATA(self)->open) {
     ger_debug("iv_ren_mthd: ren_polymarker");
 
-    fprintf(OUTFILE(self),"%sSeparator {\n",tab_buf);
-    set_indent(INCREASE);
-    shape_type = NON_INDEXED;
-    output_vlist(self,vlist);
-    fprintf(OUTFILE(self),"%sPointSet { numPoints %d }\n",tab_buf,
-	    vlist->length);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
+    if (def_geometry(self,GEOM_POLYMARKER,vlist->hash,object_data,
+		     gh_same_vlist,vlist->colors != NULL)) {
+      fprintf(OUTFILE(self),"Separator {\n");
+      set_indent(INCREASE);
+      shape_type = NON_INDEXED;
+      output_vlist(self,vlist);
+      fprintf(OUTFILE(self),"%sPointSet { numPoints %d }\n",tab_buf,
+	      vlist->length);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
+    }
 
   }
 
@@ -723,18 +736,21 @@ static void ren_polyline(P_Void_ptr object_data, P_Transform *transform,
   if (RENDATA(self)->open) {
     ger_debug("iv_ren_mthd: ren_polyline");
 
-    fprintf(OUTFILE(self),"%sSeparator {\n",tab_buf);
-    set_indent(INCREASE);
-    shape_type = INDEXED;
-    output_vlist(self,vlist);
-    fprintf(OUTFILE(self),"%sIndexedLineSet { coordIndex[\n%s   ",
-	    tab_buf,tab_buf);
-    for(i=0;i<vlist->length;i++) {
-      fprintf(OUTFILE(self),"%d,",i);
+    if (def_geometry(self,GEOM_POLYLINE,vlist->hash,object_data,
+		     gh_same_vlist,vlist->colors != NULL)) {
+      fprintf(OUTFILE(self),"Separator {\n");
+      set_indent(INCREASE);
+      shape_type = INDEXED;
+      output_vlist(self,vlist);
+      fprintf(OUTFILE(self),"%sIndexedLineSet { coordIndex[\n%s   ",
+	      tab_buf,tab_buf);
+      for(i=0;i<vlist->length;i++) {
+	fprintf(OUTFILE(self),"%d,",i);
+      }
+      fprintf(OUTFILE(self),"-1,\n%s]}\n",tab_buf);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    fprintf(OUTFILE(self),"-1,\n%s]}\n",tab_buf);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
 
   }
   METHOD_OUT;
@@ -755,18 +771,21 @@ static void ren_polygon(P_Void_ptr object_data, P_Transform *transform,
   if (RENDATA(self)->open) {
     ger_debug("iv_ren_mthd: ren_polygon");     
 
-    fprintf(OUTFILE(self),"%sSeparator {\n",tab_buf);
-    set_indent(INCREASE);
-    shape_type = INDEXED;
-    output_vlist(self,vlist);
-    fprintf(OUTFILE(self),"%sIndexedFaceSet { coordIndex[\n%s   ",
-	    tab_buf,tab_buf);
-    for(i=0;i<vlist->length;i++) {
-      fprintf(OUTFILE(self),"%d,",i);
+    if (def_geometry(self,GEOM_POLYGON,vlist->hash,object_data,
+		     gh_same_vlist,vlist->colors != NULL)) {
+      fprintf(OUTFILE(self),"Separator {\n");
+      set_indent(INCREASE);
+      shape_type = INDEXED;
+      output_vlist(self,vlist);
+      fprintf(OUTFILE(self),"%sIndexedFaceSet { coordIndex[\n%s   ",
+	      tab_buf,tab_buf);
+      for(i=0;i<vlist->length;i++) {
+	fprintf(OUTFILE(self),"%d,",i);
+      }
+      fprintf(OUTFILE(self),"-1,\n%s]}\n",tab_buf);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    fprintf(OUTFILE(self),"-1,\n%s]}\n",tab_buf);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
 
   }
 
@@ -787,21 +806,23 @@ static void ren_tristrip(P_Void_ptr object_data, P_Transform *transform,
 
   if (RENDATA(self)->open) {
     ger_debug("iv_ren_mthd: ren_tristrip");
-     
 
-    fprintf(OUTFILE(self),"%sSeparator {\n",tab_buf);
-    set_indent(INCREASE);
-    shape_type = INDEXED;
-    output_vlist(self,vlist);
-    fprintf(OUTFILE(self),"%sIndexedFaceSet { coordIndex[\n",tab_buf);
-    for(i=0;i< vlist->length-2;i++) {
-      if(i % 2 == 0) {
-	fprintf(OUTFILE(self),"%s   %d,%d,%d,-1,\n",tab_buf,i,i+1,i+2);
-      } else fprintf(OUTFILE(self),"%s   %d,%d,%d,-1,\n",tab_buf,i,i+2,i+1);
+    if (def_geometry(self,GEOM_TRISTRIP,vlist->hash,object_data,
+		     gh_same_vlist,vlist->colors != NULL)) {
+      fprintf(OUTFILE(self),"Separator {\n");
+      set_indent(INCREASE);
+      shape_type = INDEXED;
+      output_vlist(self,vlist);
+      fprintf(OUTFILE(self),"%sIndexedFaceSet { coordIndex[\n",tab_buf);
+      for(i=0;i< vlist->length-2;i++) {
+	if(i % 2 == 0) {
+	  fprintf(OUTFILE(self),"%s   %d,%d,%d,-1,\n",tab_buf,i,i+1,i+2);
+	} else fprintf(OUTFILE(self),"%s   %d,%d,%d,-1,\n",tab_buf,i,i+2,i+1);
+      }
+      fprintf(OUTFILE(self),"%s]}\n",tab_buf);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    fprintf(OUTFILE(self),"%s]}\n",tab_buf);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
 
   }
 
@@ -826,6 +847,23 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
 	      sizeof(P_Cached_Mesh));
       exit(-1);
     }
+
+    /* Send triangle strips rather than triangles if we can */
+    if ((result->nfacets= strip_mesh(indices, facet_lengths, nfacets,
+				     &(result->indices),
+				     &(result->facet_lengths))) != 0) {
+      result->stripped= 1;
+      result->nindices= 0;
+      for (ifacet=0; ifacet<result->nfacets; ifacet++)
+	result->nindices += result->facet_lengths[ifacet];
+      METHOD_RDY(vlist)
+      result->cached_vlist= cache_vlist(self,vlist);
+      gh_hash_mesh(result);
+      METHOD_OUT
+      return( (P_Void_ptr)result );
+    }
+    result->stripped= 0;
+
     if ( !(result->facet_lengths=(int*)malloc(nfacets*sizeof(int))) ) {
       fprintf(stderr,"iv_ren_mthd: def_mesh: unable to allocate %d bytes!\n",
 	      nfacets*sizeof(int));
@@ -850,6 +888,7 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
 
     METHOD_RDY(vlist)
     result->cached_vlist= cache_vlist(self,vlist);
+    gh_hash_mesh(result);
 
     METHOD_OUT
     return( (P_Void_ptr)result );
@@ -871,26 +910,37 @@ static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
 
     P_Cached_Vlist *vlist = data->cached_vlist;
     int i,j,k=0;
+    Nf_Buffer nf;
 
     ger_debug("iv_ren_mthd: ren_mesh");
-     
 
-    fprintf(OUTFILE(self),"%sSeparator {\n",tab_buf);
-    set_indent(INCREASE);
-    shape_type = INDEXED;
-    output_vlist(self,vlist);
-    fprintf(OUTFILE(self),"%sIndexedFaceSet { coordIndex [\n",tab_buf);
-    for(i=0;i < data->nfacets && k < data->nindices;i++) {
-      fprintf(OUTFILE(self),"%s   ",tab_buf);
-      for(j=0;j < data->facet_lengths[i];j++) {
-	fprintf(OUTFILE(self),"%d, ",data->indices[k]);   
-	k++;
+    if (def_geometry(self,GEOM_MESH,data->hash,object_data,
+		     gh_same_mesh,vlist->colors != NULL)) {
+      fprintf(OUTFILE(self),"Separator {\n");
+      set_indent(INCREASE);
+      shape_type = INDEXED;
+      output_vlist(self,vlist);
+      if (data->stripped)
+	fprintf(OUTFILE(self),"%sIndexedTriangleStripSet { coordIndex [\n",
+		tab_buf);
+      else
+	fprintf(OUTFILE(self),"%sIndexedFaceSet { coordIndex [\n",tab_buf);
+      nf_start(&nf,OUTFILE(self));
+      for(i=0;i < data->nfacets && k < data->nindices;i++) {
+	nf_string(&nf,tab_buf);
+	nf_string(&nf,"   ");
+	for(j=0;j < data->facet_lengths[i];j++) {
+	  nf_int(&nf,data->indices[k]);
+	  nf_string(&nf,", ");
+	  k++;
+	}
+	nf_string(&nf,"-1,\n");
       }
-      fprintf(OUTFILE(self),"-1,\n");
+      nf_flush(&nf);
+      fprintf(OUTFILE(self),"%s]}\n",tab_buf);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    fprintf(OUTFILE(self),"%s]}\n",tab_buf);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
 
   }
   METHOD_OUT;
@@ -898,19 +948,12 @@ static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_mesh( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    P_Cached_Mesh* data= (P_Cached_Mesh*)object_data;
-    ger_debug("iv_ren_mthd: destroy_mesh");
-    free( (P_Void_ptr)(data->facet_lengths) );
-    free( (P_Void_ptr)(data->indices) );
-    free_cached_vlist( (P_Cached_Vlist*)(data->cached_vlist) );
-    free( (P_Void_ptr)data );
-  }
-
-  METHOD_OUT;
+  P_Cached_Mesh* data= (P_Cached_Mesh*)object_data;
+  ger_debug("iv_ren_mthd: destroy_mesh");
+  free( (P_Void_ptr)(data->facet_lengths) );
+  free( (P_Void_ptr)(data->indices) );
+  free_cached_vlist( (P_Cached_Vlist*)(data->cached_vlist) );
+  free( (P_Void_ptr)data );
 }
 
 static P_Void_ptr def_text( char *name, char *tstring, P_Point *location, 
@@ -993,17 +1036,10 @@ static void ren_text(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_text( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    P_Cached_Text* data= (P_Cached_Text*)object_data;
-    ger_debug("iv_ren_mthd: destroy_text");
-    free( (P_Void_ptr)(data->tstring) );
-    free( (P_Void_ptr)data );
-  }
-
-  METHOD_OUT;
+  P_Cached_Text* data= (P_Cached_Text*)object_data;
+  ger_debug("iv_ren_mthd: destroy_text");
+  free( (P_Void_ptr)(data->tstring) );
+  free( (P_Void_ptr)data );
 }
 
 static P_Void_ptr def_light( char *name, P_Point *location, P_Color *color )
@@ -1084,14 +1120,8 @@ static void traverse_light(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_light( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    ger_debug("iv_ren_mthd: destroy_light");
-    free( object_data );
-  }
-  METHOD_OUT;
+  ger_debug("iv_ren_mthd: destroy_light");
+  free( object_data );
 }
 
 static P_Void_ptr def_ambient( char *name, P_Color *color )
@@ -1321,11 +1351,18 @@ static void ren_destroy( VOIDLIST )
   METHOD_IN
 
   ger_debug("iv_ren_mthd: ren_destroy");
-  if (RENDATA(self)->open) ren_close();
-  RENDATA(self)->initialized= 0;
 
   METHOD_RDY(ASSIST(self));
   (*(ASSIST(self)->destroy_self))();
+  METHOD_RDY(self);
+
+  if (RENDATA(self)->open) ren_close();
+  bgw_drain();
+  RENDATA(self)->initialized= 0;
+  if (--live_renderers == 0 && geom_table) {
+    gh_destroy(geom_table);
+    geom_table= NULL;
+  }
 
   free( (P_Void_ptr)NAME(self) );
   free( (P_Void_ptr)RENDATA(self) );
@@ -1384,6 +1421,7 @@ P_Renderer *po_create_iv_renderer( char *device, char *datastr )
   if ( !strcmp(device,"-") ) OUTFILE(self)= stdout;
   else OUTFILE(self)= NULL;
   FILENUM(self) = 0;
+  SYNC(self)= ( datastr && strstr(datastr,"fsync") ) ? 1 : 0;
  
   ASSIST(self)= po_create_assist(self);
 
@@ -1466,6 +1504,7 @@ P_Renderer *po_create_iv_renderer( char *device, char *datastr )
   self->destroy_cmap= destroy_cmap;
 
   RENDATA(self)->initialized= 1;
+  live_renderers++;
   material_type[0] = P3D_DEFAULT_MATERIAL;
 
   return( self );
@@ -1545,6 +1584,41 @@ static void del_def_list(void)
     free(d_list);
     d_list = temp_list;
   }
+
+  if (geom_table) gh_clear(geom_table);
+}
+
+static int def_geometry(P_Renderer *self, int kind, unsigned long hash,
+			P_Void_ptr data, int (*same)(void *, void *),
+			int colored)
+{
+  /* This routine starts a shape's Separator.  If the same geometry has
+   * already been written to this file, it writes a USE of that copy
+   * and returns 0.  Otherwise it writes a DEF if there is room in the
+   * table to remember it, and returns 1;  the caller must then write
+   * the Separator on the same line.  'colored' geometry writes its
+   * own Material, which depends on the current material type. */
+
+  Geom_Key key;
+  int id;
+
+  memset(&key,0,sizeof(key));
+  key.kind= kind;
+  if (colored) {
+    key.ambi= ambi;
+    key.spec= spec;
+    key.shin= shin;
+  }
+
+  if ((id= gh_find(geom_table,hash,&key,sizeof(key),data,same)) >= 0) {
+    fprintf(OUTFILE(self),"%sUSE %s%d\n",tab_buf,geom_names[kind],id);
+    return 0;
+  }
+
+  if ((id= gh_add(geom_table,hash,&key,sizeof(key),data)) >= 0)
+    fprintf(OUTFILE(self),"%sDEF %s%d ",tab_buf,geom_names[kind],id);
+  else fprintf(OUTFILE(self),"%s",tab_buf);
+  return 1;
 }
 
 static void swap_gob_type(void)
@@ -1632,7 +1706,7 @@ static void renfile_startup(void)
   if(OUTFILE(self) != stdout) {
     char* fname;
     fname= generate_fname();
-    if ( !(OUTFILE(self)= fopen(fname,"w")) ) {
+    if ( !(OUTFILE(self)= bgw_fopen(fname,"w",SYNC(self))) ) {
       perror("set_camera");
       ger_fatal("set_camera: Error opening file <%s> for writing.",
 		fname);
@@ -1641,6 +1715,9 @@ static void renfile_startup(void)
     FILENUM(self)++;
   }
 
+  if (geom_table) gh_clear(geom_table);
+  else geom_table= gh_create(GEOM_TABLE_SIZE);
+
   fprintf(OUTFILE(self),"#Inventor V2.0 ascii\n\n\n");
   fprintf(OUTFILE(self),"ShapeHints {\n");
   fprintf(OUTFILE(self),"   vertexOrdering COUNTERCLOCKWISE\n");
@@ -1779,17 +1856,13 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
   /* This routine outputs all the information stored in a cached
    * vertex list. */
 
-  int do_color = 0,do_normal = 0,i = 0;
+  int do_color = 0,do_normal = 0;
 
   ger_debug("iv_ren_mthd: output_vlist");
 
   fprintf(OUTFILE(self),"%sCoordinate3 {\n",tab_buf);
   fprintf(OUTFILE(self),"%s   point [ \n",tab_buf);
-  for(i=0;i < vlist->length;i++) {
-    fprintf(OUTFILE(self),"%s   %g %g %g,\n",tab_buf,
-	    vlist->coords[i*3],vlist->coords[(i*3)+1],
-	    vlist->coords[(i*3)+2]);
-  }
+  output_triples(self,vlist->coords,vlist->length);
   fprintf(OUTFILE(self),"%s]} \n",tab_buf);
 
   switch(vlist->type) {
@@ -1822,11 +1895,7 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
     fprintf(OUTFILE(self),"%sambientColor %g %g %g\n",tab_buf,
 	    ambi,ambi,ambi);
     fprintf(OUTFILE(self),"%sdiffuseColor [\n",tab_buf);
-    
-    for(i=0;i < vlist->length;i++) {
-    fprintf(OUTFILE(self),"%s   %g %g %g,\n",tab_buf,
-	    vlist->colors[i*3],vlist->colors[(i*3)+1],vlist->colors[(i*3)+2]);
-    }
+    output_triples(self,vlist->colors,vlist->length);
     fprintf(OUTFILE(self),"%s   ]\n",tab_buf);
     fprintf(OUTFILE(self),"%sspecularColor %g %g %g\n",tab_buf,
 	    spec,spec,spec);
@@ -1846,15 +1915,32 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
     }
     
     fprintf(OUTFILE(self),"%sNormal { vector [\n",tab_buf);
-    for(i=0;i < vlist->length;i++) {
-      fprintf(OUTFILE(self),"%s   %g %g %g,\n",tab_buf,
-	      vlist->normals[3*i],vlist->normals[3*i+1],
-	      vlist->normals[3*i+2]);
-    }
+    output_triples(self,vlist->normals,vlist->length);
     fprintf(OUTFILE(self),"%s]}\n",tab_buf);
   }
 }
 
+static void output_triples(P_Renderer *self,float *vals,int n)
+{
+  /* This routine outputs n triples of floats, one per line */
+
+  Nf_Buffer nf;
+  int i;
+
+  nf_start(&nf,OUTFILE(self));
+  for(i=0;i < n;i++) {
+    nf_string(&nf,tab_buf);
+    nf_string(&nf,"   ");
+    nf_float(&nf,vals[3*i]);
+    nf_char(&nf,' ');
+    nf_float(&nf,vals[3*i+1]);
+    nf_char(&nf,' ');
+    nf_float(&nf,vals[3*i+2]);
+    nf_string(&nf,",\n");
+  }
+  nf_flush(&nf);
+}
+
 static P_Transform *get_oriented(P_Vector *up,P_Vector *view,P_Vector *start)
 {
   /* This routine returns the transformation necessary to go from
@@ -61,6 +61,7 @@ typedef struct vlist_cache_struct {
   float *colors;
   float *opacities;
   float *normals;
+  unsigned long hash;  /* content hash, for finding repeated geometry */
 } P_Cached_Vlist;
 
 typedef struct mesh_cache_struct {
@@ -68,7 +69,9 @@ typedef struct mesh_cache_struct {
   int nindices;
   int *facet_lengths;
   int *indices;
+  int stripped; /* non-zero if facets are triangle strips */
   P_Cached_Vlist* cached_vlist;
+  unsigned long hash;  /* content hash, including the vertex list */
 } P_Cached_Mesh;
 
 typedef struct text_cache_struct {
@@ -91,6 +94,7 @@ typedef struct renderer_data_struct {
   int file_num;
   int open;
   int initialized;
+  int sync;                     /* fsync each file as it is closed */
   P_Renderer_Cmap *current_cmap;
   int attrs_set;
   P_Camera *current_camera;
@@ -104,6 +108,7 @@ typedef struct renderer_data_struct {
 #define RENDATA( self ) ((P_Renderer_data *)(self->object_data))
 #define OUTFILE( self ) (RENDATA(self)->outfile)
 #define FILENUM( self ) (RENDATA(self)->file_num)
+#define SYNC( self ) (RENDATA(self)->sync)
 #define NAME( self ) (RENDATA(self)->name)
 #define CUR_MAP( self ) (RENDATA(self)->current_cmap)
 #define MAP_NAME( self ) (CUR_MAP(self)->map_name)
@@ -473,7 +473,12 @@ P_Vlist *po_create_mvlist( int type, int length,
   thislist->object_data= (P_Void_ptr)thisdata;
   thisdata->coords= coord;
   switch (type) {
-  case P3D_CVTX: break;
+  case P3D_CVTX:
+    thisdata->normals= (float *)0;
+    thisdata->colors= (float *)0;
+    thisdata->values= (float *)0;
+    thisdata->value_stride= 1;
+    break;
   case P3D_CCVTX:
     thisdata->normals= (float *)0;
     thisdata->colors= color;
@@ -527,6 +532,14 @@ P_Vlist *po_create_mvlist( int type, int length,
   thislist->print= printfun;
   thislist->destroy_self= m_destroy;
 
+  /* The caller's arrays are used in place, Fortran column order */
+  po_clear_vlist_view(thislist);
+  po_set_vlist_view(thislist, P3D_VX, 3, thisdata->coords, 3);
+  po_set_vlist_view(thislist, P3D_VNX, 3, thisdata->normals, 3);
+  po_set_vlist_view(thislist, P3D_VR, 4, thisdata->colors, 4);
+  po_set_vlist_view(thislist, P3D_VV, thisdata->value_stride, 
+		    thisdata->values, thisdata->value_stride);
+
   return( thislist );
 }
 
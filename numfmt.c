@@ -0,0 +1,357 @@
+/****************************************************************************
+ * numfmt.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module formats numbers for the text-writing renderers.  Floats
+are written with the fewest significant digits which read back as the
+same single precision value, using the Ryu algorithm of Ulf Adams
+("Ryu: Fast Float-to-String Conversion", PLDI 2018).  The output
+looks like that of printf "%g", but with as many digits as the value
+needs rather than always 6:  exponential notation is used for values
+below 0.0001, and for those of a million or more which would otherwise
+end in padding zeros.  Unlike printf, the result does not depend on
+the locale.
+
+Text can be collected in an Nf_Buffer, which is written out in large
+pieces, so that long vertex and index lists are not written one
+fprintf at a time.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "numfmt.h"
+
+#define FLOAT_MANTISSA_BITS 23
+#define FLOAT_EXPONENT_BITS 8
+#define FLOAT_BIAS 127
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT 61
+
+/* FLOAT_POW5_INV_SPLIT[i] is 2^(pow5bits(i)-1+59)/5^i, rounded up, and
+ * FLOAT_POW5_SPLIT[i] is 5^i scaled to 61 significant bits.
+ */
+static const uint64_t FLOAT_POW5_INV_SPLIT[31]= {
+  576460752303423489u, 461168601842738791u, 368934881474191033u,
+  295147905179352826u, 472236648286964522u, 377789318629571618u,
+  302231454903657294u, 483570327845851670u, 386856262276681336u,
+  309485009821345069u, 495176015714152110u, 396140812571321688u,
+  316912650057057351u, 507060240091291761u, 405648192073033409u,
+  324518553658426727u, 519229685853482763u, 415383748682786211u,
+  332306998946228969u, 531691198313966350u, 425352958651173080u,
+  340282366920938464u, 544451787073501542u, 435561429658801234u,
+  348449143727040987u, 557518629963265579u, 446014903970612463u,
+  356811923176489971u, 570899077082383953u, 456719261665907162u,
+  365375409332725730u
+};
+
+static const uint64_t FLOAT_POW5_SPLIT[47]= {
+  1152921504606846976u, 1441151880758558720u, 1801439850948198400u,
+  2251799813685248000u, 1407374883553280000u, 1759218604441600000u,
+  2199023255552000000u, 1374389534720000000u, 1717986918400000000u,
+  2147483648000000000u, 1342177280000000000u, 1677721600000000000u,
+  2097152000000000000u, 1310720000000000000u, 1638400000000000000u,
+  2048000000000000000u, 1280000000000000000u, 1600000000000000000u,
+  2000000000000000000u, 1250000000000000000u, 1562500000000000000u,
+  1953125000000000000u, 1220703125000000000u, 1525878906250000000u,
+  1907348632812500000u, 1192092895507812500u, 1490116119384765625u,
+  1862645149230957031u, 1164153218269348144u, 1455191522836685180u,
+  1818989403545856475u, 2273736754432320594u, 1421085471520200371u,
+  1776356839400250464u, 2220446049250313080u, 1387778780781445675u,
+  1734723475976807094u, 2168404344971008868u, 1355252715606880542u,
+  1694065894508600678u, 2117582368135750847u, 1323488980084844279u,
+  1654361225106055349u, 2067951531382569187u, 1292469707114105741u,
+  1615587133892632177u, 2019483917365790221u
+};
+
+static int pow5bits( int e )
+/* This routine returns ceil(log2(5^e)), or 1 for e==0 */
+{
+  return( (int)(((uint32_t)e * 1217359) >> 19) + 1 );
+}
+
+static uint32_t log10_pow2( int e )
+/* floor(log10(2^e)) */
+{
+  return( ((uint32_t)e * 78913) >> 18 );
+}
+
+static uint32_t log10_pow5( int e )
+/* floor(log10(5^e)) */
+{
+  return( ((uint32_t)e * 732923) >> 20 );
+}
+
+static int multiple_of_pow5( uint32_t value, uint32_t p )
+{
+  uint32_t count= 0;
+
+  while (value % 5 == 0) {
+    value /= 5;
+    count++;
+  }
+  return( count >= p );
+}
+
+static int multiple_of_pow2( uint32_t value, uint32_t p )
+{
+  return( (value & ((1u << p) - 1)) == 0 );
+}
+
+static uint32_t mul_shift( uint32_t m, uint64_t factor, int shift )
+/* This routine returns (m*factor) >> shift, for shift > 32 */
+{
+  uint64_t bits0= (uint64_t)m * (uint32_t)factor;
+  uint64_t bits1= (uint64_t)m * (uint32_t)(factor >> 32);
+  uint64_t sum= (bits0 >> 32) + bits1;
+
+  return( (uint32_t)(sum >> (shift - 32)) );
+}
+
+static uint32_t shortest( uint32_t ieee_mantissa, uint32_t ieee_exponent,
+			  int *exponent )
+/* This routine finds the shortest decimal which rounds to the given
+ * finite, nonzero float, returning its digits and setting the power of
+ * ten by which they are to be multiplied.
+ */
+{
+  int e2, e10, removed= 0, accept_bounds;
+  uint32_t m2, mv, mp, mm, mm_shift, vr, vp, vm, q, output;
+  int vm_trailing_zeros= 0, vr_trailing_zeros= 0;
+  uint32_t last_removed_digit= 0;
+
+  if (ieee_exponent == 0) {
+    e2= 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2= ieee_mantissa;
+  }
+  else {
+    e2= (int)ieee_exponent - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2= (1u << FLOAT_MANTISSA_BITS) | ieee_mantissa;
+  }
+  accept_bounds= ((m2 & 1) == 0);
+
+  /* The value and the halfway points to its neighbors, times 4 */
+  mv= 4 * m2;
+  mp= 4 * m2 + 2;
+  mm_shift= (ieee_mantissa != 0 || ieee_exponent <= 1);
+  mm= 4 * m2 - 1 - mm_shift;
+
+  if (e2 >= 0) {
+    int k, i;
+    q= log10_pow2(e2);
+    e10= (int)q;
+    k= FLOAT_POW5_INV_BITCOUNT + pow5bits((int)q) - 1;
+    i= -e2 + (int)q + k;
+    vr= mul_shift(mv, FLOAT_POW5_INV_SPLIT[q], i);
+    vp= mul_shift(mp, FLOAT_POW5_INV_SPLIT[q], i);
+    vm= mul_shift(mm, FLOAT_POW5_INV_SPLIT[q], i);
+    if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+      int l= FLOAT_POW5_INV_BITCOUNT + pow5bits((int)(q - 1)) - 1;
+      last_removed_digit= 
+	mul_shift(mv, FLOAT_POW5_INV_SPLIT[q - 1], -e2 + (int)q - 1 + l) % 10;
+    }
+    if (q <= 9) {
+      if (mv % 5 == 0) vr_trailing_zeros= multiple_of_pow5(mv, q);
+      else if (accept_bounds) vm_trailing_zeros= multiple_of_pow5(mm, q);
+      else vp -= multiple_of_pow5(mp, q);
+    }
+  }
+  else {
+    int i, k, j;
+    q= log10_pow5(-e2);
+    e10= (int)q + e2;
+    i= -e2 - (int)q;
+    k= pow5bits(i) - FLOAT_POW5_BITCOUNT;
+    j= (int)q - k;
+    vr= mul_shift(mv, FLOAT_POW5_SPLIT[i], j);
+    vp= mul_shift(mp, FLOAT_POW5_SPLIT[i], j);
+    vm= mul_shift(mm, FLOAT_POW5_SPLIT[i], j);
+    if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+      j= (int)q - 1 - (pow5bits(i + 1) - FLOAT_POW5_BITCOUNT);
+      last_removed_digit= mul_shift(mv, FLOAT_POW5_SPLIT[i + 1], j) % 10;
+    }
+    if (q <= 1) {
+      vr_trailing_zeros= 1;
+      if (accept_bounds) vm_trailing_zeros= (mm_shift == 1);
+      else vp--;
+    }
+    else if (q < 31) vr_trailing_zeros= multiple_of_pow2(mv, q - 1);
+  }
+
+  /* Remove digits while the interval still holds a shorter decimal */
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    while (vp / 10 > vm / 10) {
+      vm_trailing_zeros &= (vm % 10 == 0);
+      vr_trailing_zeros &= (last_removed_digit == 0);
+      last_removed_digit= vr % 10;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    if (vm_trailing_zeros) 
+      while (vm % 10 == 0) {
+	vr_trailing_zeros &= (last_removed_digit == 0);
+	last_removed_digit= vr % 10;
+	vr /= 10;
+	vp /= 10;
+	vm /= 10;
+	removed++;
+      }
+    if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+      last_removed_digit= 4; /* round half to even */
+    output= vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros))
+		  || last_removed_digit >= 5);
+  }
+  else {
+    while (vp / 10 > vm / 10) {
+      last_removed_digit= vr % 10;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    output= vr + (vr == vm || last_removed_digit >= 5);
+  }
+
+  *exponent= e10 + removed;
+  return( output );
+}
+
+int nf_format_float( char *buf, double val )
+/* This routine writes the shortest form of val as a float into buf,
+ * which must hold NF_MAXCHARS characters, and returns its length.
+ */
+{
+  union { float f; uint32_t u; } bits;
+  uint32_t ieee_mantissa, ieee_exponent, digits;
+  char digit_buf[12];
+  char *out= buf;
+  int ndigits, exponent, point, i;
+
+  bits.f= (float)val;
+  ieee_mantissa= bits.u & ((1u << FLOAT_MANTISSA_BITS) - 1);
+  ieee_exponent= (bits.u >> FLOAT_MANTISSA_BITS) & ((1u << FLOAT_EXPONENT_BITS) - 1);
+  if (bits.u >> 31) *out++= '-';
+
+  if (ieee_exponent == ((1u << FLOAT_EXPONENT_BITS) - 1)) {
+    strcpy(out, ieee_mantissa ? "nan" : "inf");
+    return( (int)(out - buf) + 3 );
+  }
+  if (ieee_exponent == 0 && ieee_mantissa == 0) {
+    *out++= '0';
+    *out= '\0';
+    return( (int)(out - buf) );
+  }
+
+  digits= shortest(ieee_mantissa, ieee_exponent, &exponent);
+  ndigits= 0;
+  while (digits) {
+    digit_buf[ndigits++]= '0' + digits % 10;
+    digits /= 10;
+  }
+
+  /* point is the power of ten of the leading digit */
+  point= exponent + ndigits - 1;
+  if (point < -4 || (point >= 6 && point >= ndigits)) {
+    *out++= digit_buf[ndigits-1];
+    if (ndigits > 1) {
+      *out++= '.';
+      for (i=ndigits-2; i>=0; i--) *out++= digit_buf[i];
+    }
+    *out++= 'e';
+    if (point < 0) {
+      *out++= '-';
+      point= -point;
+    }
+    else *out++= '+';
+    if (point >= 10) *out++= '0' + point / 10;
+    else *out++= '0';
+    *out++= '0' + point % 10;
+  }
+  else if (point < 0) {
+    *out++= '0';
+    *out++= '.';
+    for (i= -1; i>point; i--) *out++= '0';
+    for (i=ndigits-1; i>=0; i--) *out++= digit_buf[i];
+  }
+  else {
+    for (i=ndigits-1; i>=0; i--) {
+      *out++= digit_buf[i];
+      if (i && ndigits-1-i == point) *out++= '.';
+    }
+    for (i=ndigits-1; i<point; i++) *out++= '0';
+  }
+  *out= '\0';
+  return( (int)(out - buf) );
+}
+
+int nf_format_int( char *buf, int val )
+/* This routine writes val in decimal into buf, returning its length */
+{
+  char digit_buf[12];
+  char *out= buf;
+  unsigned int u= (unsigned int)val;
+  int ndigits= 0;
+
+  if (val < 0) {
+    *out++= '-';
+    u= 0u - u;
+  }
+  do {
+    digit_buf[ndigits++]= '0' + u % 10;
+    u /= 10;
+  } while (u);
+  while (ndigits) *out++= digit_buf[--ndigits];
+  *out= '\0';
+  return( (int)(out - buf) );
+}
+
+void nf_start( Nf_Buffer *nf, FILE *file )
+/* This routine prepares a buffer for output to the given file */
+{
+  nf->file= file;
+  nf->fill= 0;
+}
+
+void nf_flush( Nf_Buffer *nf )
+/* This routine writes out any text held in a buffer */
+{
+  if (nf->fill) {
+    fwrite(nf->data, 1, nf->fill, nf->file);
+    nf->fill= 0;
+  }
+}
+
+void nf_float( Nf_Buffer *nf, double val )
+/* This routine appends a float to a buffer */
+{
+  if (nf->fill > NF_BUFSIZE - NF_MAXCHARS) nf_flush(nf);
+  nf->fill += nf_format_float(nf->data + nf->fill, val);
+}
+
+void nf_int( Nf_Buffer *nf, int val )
+/* This routine appends an integer to a buffer */
+{
+  if (nf->fill > NF_BUFSIZE - NF_MAXCHARS) nf_flush(nf);
+  nf->fill += nf_format_int(nf->data + nf->fill, val);
+}
+
+void nf_string( Nf_Buffer *nf, char *string )
+/* This routine appends a string to a buffer */
+{
+  while (*string) nf_char(nf, *string++);
+}
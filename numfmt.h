@@ -0,0 +1,52 @@
+/****************************************************************************
+ * numfmt.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the number formatting package
+numfmt.c, which the text-writing renderers use in place of printf for
+bulk coordinate and index output.
+*/
+
+#ifndef INCL_NUMFMT_H
+#define INCL_NUMFMT_H
+
+/* Longest string nf_float or nf_int can produce, with the final \0 */
+#define NF_MAXCHARS 24
+
+/* Output buffer;  text is appended and written out with fwrite as the
+ * buffer fills.  Call nf_flush before writing to the file any other way.
+ */
+#define NF_BUFSIZE 8192
+typedef struct nf_buffer_struct {
+  FILE *file;
+  int fill;
+  char data[NF_BUFSIZE];
+} Nf_Buffer;
+
+extern int nf_format_float( char *buf, double val );
+extern int nf_format_int( char *buf, int val );
+extern void nf_start( Nf_Buffer *nf, FILE *file );
+extern void nf_float( Nf_Buffer *nf, double val );
+extern void nf_int( Nf_Buffer *nf, int val );
+extern void nf_string( Nf_Buffer *nf, char *string );
+extern void nf_flush( Nf_Buffer *nf );
+
+/* Append a single character */
+#define nf_char( nf, c ) \
+  do { if ((nf)->fill >= NF_BUFSIZE) nf_flush(nf); \
+       (nf)->data[(nf)->fill++]= (c); } while (0)
+
+#endif /* INCL_NUMFMT_H */
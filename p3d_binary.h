@@ -0,0 +1,119 @@
+/****************************************************************************
+ * p3d_binary.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This include file describes the binary P3D format, which is written by
+the P3D renderer when its data string contains "binary" and read back
+by pg_load_p3d().
+
+All numbers are little-endian.  Integers are 32 bit two's complement,
+floats are 32 bit IEEE, and sizes are 64 bit unsigned.  Nothing is
+padded.  A string is an int32 byte count followed by that many bytes,
+without a terminating null.
+
+The file begins with a 16 byte header:
+
+  char   magic[4]     "P3DB"
+  int32  version      P3DB_VERSION
+  int32  flags        0
+  int32  reserved     0
+
+This is followed by any number of records, each of which begins:
+
+  char   tag[4]       one of the P3DB_TAG_ values below
+  int32  id           symbol number; N stands for the text symbol sN
+  uint64 nbytes       length of the payload which follows
+
+A reader should skip the payload of any tag it does not recognize.
+Record ids play the role of the symbols of the text format;  an id of
+P3DB_DEFAULT_ID names the default lights or default camera.
+
+Vertex blocks hold the coordinates in structure-of-arrays order, so
+that each component is a contiguous run of floats:
+
+  int32  nvertices
+  int32  vflags       P3DB_VTX_COLOR | P3DB_VTX_NORMAL
+  float  x[n], y[n], z[n]
+  float  r[n], g[n], b[n], a[n]       if vflags & P3DB_VTX_COLOR
+  float  nx[n], ny[n], nz[n]          if vflags & P3DB_VTX_NORMAL
+
+Value data has already been mapped through the current color map, as
+in the text format.  Facet blocks are:
+
+  int32  nfacets
+  int32  nindices
+  int32  facet_lengths[nfacets]
+  int32  indices[nindices]
+
+Record payloads are:
+
+  CAMR  lookfrom[3] lookat[3] up[3] background rgba[4] fovea hither yon,
+        all floats
+  SPHR  empty
+  CYLN  empty
+  TORS  float major, float minor
+  PMRK, PLIN, PGON, TSTR, BEZR  vertex block
+  MESH  vertex block, facet block
+  TEXT  float location[3], u[3], v[3], string
+  LITE  float location[3], rgb[3]
+  AMBL  float rgb[3]
+  GOB_  int32 nchildren, int32 child ids[nchildren],
+        int32 has_transform, float transform[16] if has_transform,
+        int32 nattributes, then for each attribute a string name, an
+        int32 P3D_ type code, and a value:  int32 for P3D_INT,
+        P3D_BOOLEAN and P3D_MATERIAL (the material type), float for
+        P3D_FLOAT, string for P3D_STRING, rgba[4] for P3D_COLOR, xyz[3]
+        for P3D_POINT and P3D_VECTOR, float[16] for P3D_TRANSFORM, and
+        nothing for P3D_OTHER
+  SNAP  id is the model;  int32 lights id, int32 camera id
+  FREE  empty;  id is the gob to free
+  HOLD  empty
+  UNHL  empty
+*/
+
+#ifndef INCL_P3D_BINARY_H
+#define INCL_P3D_BINARY_H
+
+#define P3DB_MAGIC "P3DB"
+#define P3DB_VERSION 1
+#define P3DB_HEADER_BYTES 16
+#define P3DB_RECORD_BYTES 16
+
+#define P3DB_DEFAULT_ID -1
+
+#define P3DB_VTX_COLOR 1
+#define P3DB_VTX_NORMAL 2
+
+#define P3DB_TAG_CAMERA "CAMR"
+#define P3DB_TAG_SPHERE "SPHR"
+#define P3DB_TAG_CYLINDER "CYLN"
+#define P3DB_TAG_TORUS "TORS"
+#define P3DB_TAG_POLYMARKER "PMRK"
+#define P3DB_TAG_POLYLINE "PLIN"
+#define P3DB_TAG_POLYGON "PGON"
+#define P3DB_TAG_TRISTRIP "TSTR"
+#define P3DB_TAG_BEZIER "BEZR"
+#define P3DB_TAG_MESH "MESH"
+#define P3DB_TAG_TEXT "TEXT"
+#define P3DB_TAG_LIGHT "LITE"
+#define P3DB_TAG_AMBIENT "AMBL"
+#define P3DB_TAG_GOB "GOB_"
+#define P3DB_TAG_SNAP "SNAP"
+#define P3DB_TAG_FREE "FREE"
+#define P3DB_TAG_HOLD "HOLD"
+#define P3DB_TAG_UNHOLD "UNHL"
+
+#endif /* INCL_P3D_BINARY_H */
@@ -0,0 +1,1438 @@
+/****************************************************************************
+ * p3d_load.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module reads files written by the P3D renderer and replays them
+through the pg_ routines, so that a saved scene can be drawn by any
+renderer.  The layout of binary files is described in p3d_binary.h.
+
+Text files are read by a tokenizer working from a fixed size input
+buffer, and a parser which knows the forms the P3D renderer writes.
+The forms have a fixed nesting depth, so the parser needs no
+recursion;  forms it does not know, like the function definitions of
+the preamble, are skipped by counting parentheses.  Only the vertex
+and facet data of the primitive being read is held in memory at once.
+
+Each symbol sN of the file becomes a named GOB or camera called "sN".
+Primitives are wrapped in a GOB of their own, since only GOBs can be
+named.  The default lights and camera of the P3D preamble are created
+as "default-lights" and "default-camera" if the file refers to them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "ge_error.h"
+#include "p3d_binary.h"
+
+/* Record payload buffer, and the read position within it */
+static unsigned char *payload= (unsigned char *)0;
+static size_t payload_space= 0;
+static unsigned char *here, *end;
+static int overrun;
+
+/* Set once the default lights and camera have been defined */
+static int have_default_lights, have_default_camera;
+
+static unsigned int get_word( VOIDLIST )
+/* This routine reads 4 little-endian bytes from the payload */
+{
+  unsigned int word;
+
+  /* No debugging; called too often */
+  if (end-here < 4) {
+    overrun= 1;
+    return(0);
+  }
+  word= here[0] | (here[1]<<8) | (here[2]<<16) | ((unsigned int)here[3]<<24);
+  here += 4;
+  return(word);
+}
+
+static int get_int( VOIDLIST )
+{
+  return( (int)get_word() );
+}
+
+static float get_float( VOIDLIST )
+{
+  union { float f; unsigned int i; } u;
+  u.i= get_word();
+  return(u.f);
+}
+
+static int get_count( int size )
+/* This routine reads a count of items of the given size, checking that
+ * that many items remain in the payload.
+ */
+{
+  int count= get_int();
+  if (count<0 || (double)count*size > (double)(end-here)) {
+    overrun= 1;
+    return(0);
+  }
+  return(count);
+}
+
+static char *get_string( VOIDLIST )
+/* This routine reads a counted string, returning it in newly allocated
+ * memory.
+ */
+{
+  int length= get_count(1);
+  char *result;
+
+  if ( !(result= (char *)malloc(length+1)) )
+    ger_fatal("p3d_load: get_string: unable to allocate %d bytes!",length+1);
+  memcpy( result, here, length );
+  result[length]= '\0';
+  here += length;
+  return(result);
+}
+
+static char *id_name( int id, char *buf )
+/* This routine returns the symbol name for a record id */
+{
+  if (id==P3DB_DEFAULT_ID) buf[0]= '\0';
+  else sprintf(buf,"s%d",id);
+  return(buf);
+}
+
+static char *lights_name( int id, char *buf )
+/* This routine returns the name of a lighting GOB, defining the default
+ * lights if need be.
+ */
+{
+  static P_Point loc= { 0.0, 1.0, 20.0 };
+  static P_Color lcolor= { P3D_RGB, 0.8, 0.8, 0.8, 1.0 };
+  static P_Color acolor= { P3D_RGB, 0.3, 0.3, 0.3, 1.0 };
+
+  if (id!=P3DB_DEFAULT_ID) return( id_name(id,buf) );
+  if (!have_default_lights) {
+    pg_open("default-lights");
+    pg_light(&loc, &lcolor);
+    pg_ambient(&acolor);
+    pg_close();
+    have_default_lights= 1;
+  }
+  return("default-lights");
+}
+
+static char *camera_name( int id, char *buf )
+/* This routine returns the name of a camera, defining the default
+ * camera if need be.
+ */
+{
+  static P_Point lookfrom= { 0.0, 0.0, 20.0 };
+  static P_Point lookat= { 0.0, 0.0, 0.0 };
+  static P_Vector up= { 0.0, 1.0, 0.0 };
+
+  if (id!=P3DB_DEFAULT_ID) return( id_name(id,buf) );
+  if (!have_default_camera) {
+    pg_camera("default-camera", &lookfrom, &lookat, &up, 45.0, -1.0, -50.0);
+    have_default_camera= 1;
+  }
+  return("default-camera");
+}
+
+static int vtx_layout( int flags, int *fpv )
+/* This routine returns the vertex type matching the given vertex block
+ * flags, and the number of floats per vertex of that type.
+ */
+{
+  switch (flags) {
+  case 0: *fpv= 3; return(P3D_CVTX);
+  case P3DB_VTX_COLOR: *fpv= 7; return(P3D_CCVTX);
+  case P3DB_VTX_NORMAL: *fpv= 6; return(P3D_CNVTX);
+  case P3DB_VTX_COLOR | P3DB_VTX_NORMAL: *fpv= 10; return(P3D_CCNVTX);
+  }
+  *fpv= 0;
+  return(-1);
+}
+
+static P_Vlist *get_vlist( float **data )
+/* This routine reads a binary vertex block, returning a vertex list for
+ * it.  The interleaved vertex data is returned in *data, and must be
+ * freed after the vertex list has been used.
+ */
+{
+  int n, flags, vtxtype, fpv, coff, noff, i;
+  float *vdata;
+
+  n= get_int();
+  flags= get_int();
+  if ((vtxtype= vtx_layout(flags, &fpv)) < 0) {
+    ger_error("p3d_load: get_vlist: invalid vertex flags %d",flags);
+    overrun= 1;
+    return( (P_Vlist *)0 );
+  }
+  if (n<0 || (double)n*fpv*4 > (double)(end-here)) {
+    overrun= 1;
+    return( (P_Vlist *)0 );
+  }
+
+  if ( !(vdata= (float *)malloc((n ? n : 1)*fpv*sizeof(float))) )
+    ger_fatal("p3d_load: get_vlist: unable to allocate %d bytes!",
+	      n*fpv*sizeof(float));
+  coff= 3;
+  noff= (flags & P3DB_VTX_COLOR) ? 7 : 3;
+  for (i=0; i<n; i++) vdata[fpv*i]= get_float();
+  for (i=0; i<n; i++) vdata[fpv*i+1]= get_float();
+  for (i=0; i<n; i++) vdata[fpv*i+2]= get_float();
+  if (flags & P3DB_VTX_COLOR) {
+    for (i=0; i<n; i++) vdata[fpv*i+coff]= get_float();
+    for (i=0; i<n; i++) vdata[fpv*i+coff+1]= get_float();
+    for (i=0; i<n; i++) vdata[fpv*i+coff+2]= get_float();
+    for (i=0; i<n; i++) vdata[fpv*i+coff+3]= get_float();
+  }
+  if (flags & P3DB_VTX_NORMAL) {
+    for (i=0; i<n; i++) vdata[fpv*i+noff]= get_float();
+    for (i=0; i<n; i++) vdata[fpv*i+noff+1]= get_float();
+    for (i=0; i<n; i++) vdata[fpv*i+noff+2]= get_float();
+  }
+
+  *data= vdata;
+  return( po_create_cvlist( vtxtype, n, vdata ) );
+}
+
+static int *get_ints( int n )
+/* This routine reads n ints into newly allocated memory */
+{
+  int *result;
+  int i;
+
+  if ( !(result= (int *)malloc((n ? n : 1)*sizeof(int))) )
+    ger_fatal("p3d_load: get_ints: unable to allocate %d bytes!",
+	      n*sizeof(int));
+  for (i=0; i<n; i++) result[i]= get_int();
+  return(result);
+}
+
+static void define_vlist_prim( char *tag, char *name, P_Vlist *vlist )
+/* This routine defines a GOB holding the primitive for the given tag */
+{
+  pg_open(name);
+  if (!strncmp(tag,P3DB_TAG_POLYMARKER,4)) pg_polymarker(vlist);
+  else if (!strncmp(tag,P3DB_TAG_POLYLINE,4)) pg_polyline(vlist);
+  else if (!strncmp(tag,P3DB_TAG_POLYGON,4)) pg_polygon(vlist);
+  else if (!strncmp(tag,P3DB_TAG_TRISTRIP,4)) pg_tristrip(vlist);
+  else pg_bezier(vlist);
+  pg_close();
+}
+
+static void load_vlist_prim( char *tag, char *name )
+/* This routine handles records holding a single vertex list */
+{
+  P_Vlist *vlist;
+  float *vdata;
+
+  if ( !(vlist= get_vlist( &vdata )) ) return;
+  define_vlist_prim(tag, name, vlist);
+  free( (P_Void_ptr)vdata );
+}
+
+static void load_mesh( char *name )
+/* This routine handles a mesh record */
+{
+  P_Vlist *vlist;
+  float *vdata;
+  int *lengths, *indices;
+  int nfacets, nindices, i, total= 0;
+
+  if ( !(vlist= get_vlist( &vdata )) ) return;
+  nfacets= get_count(4);
+  nindices= get_count(4);
+  if ((double)nfacets+nindices > (double)(end-here)/4) overrun= 1;
+  if (overrun) {
+    METHOD_RDY(vlist);
+    (*(vlist->destroy_self))();
+    free( (P_Void_ptr)vdata );
+    return;
+  }
+  lengths= get_ints(nfacets);
+  indices= get_ints(nindices);
+  for (i=0; i<nfacets; i++) total += lengths[i];
+  for (i=0; i<nindices; i++)
+    if (indices[i]<0 || indices[i]>=vlist->length) break;
+  if (total != nindices || i<nindices) {
+    ger_error("p3d_load: load_mesh: inconsistent facet data for <%s>",name);
+    overrun= 1;
+    METHOD_RDY(vlist);
+    (*(vlist->destroy_self))();
+  }
+  else {
+    pg_open(name);
+    pg_mesh(vlist, indices, lengths, nfacets);
+    pg_close();
+  }
+  free( (P_Void_ptr)vdata );
+  free( (P_Void_ptr)lengths );
+  free( (P_Void_ptr)indices );
+}
+
+static void load_trans( P_Transform *trans )
+/* This routine reads a transform matrix */
+{
+  int i;
+
+  for (i=0; i<16; i++) trans->d[i]= get_float();
+  trans->type_front= (P_Transform_type *)0;
+}
+
+static void add_transform( P_Transform *trans )
+/* This routine adds a general transform to the open GOB */
+{
+  trans->type_front= allocate_trans_type();
+  trans->type_front->type= P3D_TRANSFORMATION;
+  trans->type_front->trans= (P_Void_ptr)duplicate_trans(trans);
+  trans->type_front->generators[0]= 0;
+  trans->type_front->generators[1]= 0;
+  trans->type_front->generators[2]= 0;
+  trans->type_front->generators[3]= 0;
+  trans->type_front->next= NULL;
+  pg_transform(trans);
+  destroy_trans_type(trans->type_front);
+}
+
+static void load_attr( VOIDLIST )
+/* This routine reads one attribute and adds it to the open GOB */
+{
+  char *attribute, *string;
+  int type, ival;
+  P_Color color;
+  P_Point point;
+  P_Vector vector;
+  P_Transform trans;
+  P_Material *mat;
+
+  attribute= get_string();
+  type= get_int();
+  switch (type) {
+  case P3D_INT: pg_int_attr(attribute, get_int()); break;
+  case P3D_BOOLEAN: pg_bool_attr(attribute, get_int()); break;
+  case P3D_FLOAT: pg_float_attr(attribute, get_float()); break;
+  case P3D_STRING:
+    string= get_string();
+    pg_string_attr(attribute, string);
+    free( (P_Void_ptr)string );
+    break;
+  case P3D_COLOR:
+    color.ctype= P3D_RGB;
+    color.r= get_float();
+    color.g= get_float();
+    color.b= get_float();
+    color.a= get_float();
+    pg_color_attr(attribute, &color);
+    break;
+  case P3D_POINT:
+    point.x= get_float();
+    point.y= get_float();
+    point.z= get_float();
+    pg_point_attr(attribute, &point);
+    break;
+  case P3D_VECTOR:
+    vector.x= get_float();
+    vector.y= get_float();
+    vector.z= get_float();
+    pg_vector_attr(attribute, &vector);
+    break;
+  case P3D_TRANSFORM:
+    load_trans(&trans);
+    pg_trans_attr(attribute, &trans);
+    break;
+  case P3D_MATERIAL:
+    ival= get_int();
+    switch (ival) {
+    case P3D_DULL_MATERIAL: mat= p3d_dull_material; break;
+    case P3D_SHINY_MATERIAL: mat= p3d_shiny_material; break;
+    case P3D_METALLIC_MATERIAL: mat= p3d_metallic_material; break;
+    case P3D_MATTE_MATERIAL: mat= p3d_matte_material; break;
+    case P3D_ALUMINUM_MATERIAL: mat= p3d_aluminum_material; break;
+    default: mat= p3d_default_material;
+    }
+    pg_material_attr(attribute, mat);
+    break;
+  case P3D_OTHER:
+    break; /* The value could not be saved */
+  default:
+    ger_error("p3d_load: load_attr: attribute <%s> has unknown type %d",
+	      attribute, type);
+    overrun= 1;
+  }
+  free( (P_Void_ptr)attribute );
+}
+
+static void skip_attr( VOIDLIST )
+/* This routine steps over one attribute */
+{
+  int skip;
+
+  here += get_count(1);
+  switch (get_int()) {
+  case P3D_STRING: skip= get_count(1); break;
+  case P3D_COLOR: skip= 4*4; break;
+  case P3D_POINT:
+  case P3D_VECTOR: skip= 3*4; break;
+  case P3D_TRANSFORM: skip= 16*4; break;
+  case P3D_OTHER: skip= 0; break;
+  default: skip= 4;
+  }
+  if (end-here < skip) overrun= 1;
+  else here += skip;
+}
+
+static void load_gob( char *name )
+/* This routine handles a GOB record */
+{
+  int *kids;
+  int nkids, nattr, i;
+  char kidname[P3D_NAMELENGTH];
+  P_Transform trans;
+  unsigned char **starts, *after;
+
+  nkids= get_count(4);
+  kids= get_ints(nkids);
+  pg_open(name);
+  /* Children are listed in the reverse of the order they were added */
+  for (i=nkids-1; i>=0; i--) pg_child( id_name(kids[i],kidname) );
+  free( (P_Void_ptr)kids );
+  if (get_int()) {
+    load_trans(&trans);
+    if (!overrun) add_transform(&trans);
+  }
+
+  /* Attributes are added in reverse, since each goes on the front of
+   * the GOB's attribute list.
+   */
+  nattr= get_count(4);
+  if ( !(starts= (unsigned char **)malloc((nattr ? nattr : 1)
+					  *sizeof(unsigned char *))) )
+    ger_fatal("p3d_load: load_gob: unable to allocate %d bytes!",
+	      nattr*sizeof(unsigned char *));
+  for (i=0; i<nattr && !overrun; i++) {
+    starts[i]= here;
+    skip_attr();
+  }
+  after= here;
+  for (i=nattr-1; i>=0 && !overrun; i--) {
+    here= starts[i];
+    load_attr();
+  }
+  here= after;
+  free( (P_Void_ptr)starts );
+  pg_close();
+}
+
+static void load_camera( char *name )
+/* This routine handles a camera record */
+{
+  P_Point lookfrom, lookat;
+  P_Vector up;
+  P_Color background;
+  float fovea, hither, yon;
+
+  lookfrom.x= get_float();
+  lookfrom.y= get_float();
+  lookfrom.z= get_float();
+  lookat.x= get_float();
+  lookat.y= get_float();
+  lookat.z= get_float();
+  up.x= get_float();
+  up.y= get_float();
+  up.z= get_float();
+  background.ctype= P3D_RGB;
+  background.r= get_float();
+  background.g= get_float();
+  background.b= get_float();
+  background.a= get_float();
+  fovea= get_float();
+  hither= get_float();
+  yon= get_float();
+  if (overrun) return;
+  pg_camera(name, &lookfrom, &lookat, &up, fovea, hither, yon);
+  pg_camera_background(name, &background);
+}
+
+static void load_record( char *tag, int id )
+/* This routine replays one binary record, which has been read into the
+ * payload buffer.
+ */
+{
+  char name[P3D_NAMELENGTH], name2[P3D_NAMELENGTH], name3[P3D_NAMELENGTH];
+  P_Point point;
+  P_Vector u, v;
+  P_Color color;
+  char *string;
+  float major, minor;
+
+  ger_debug("p3d_load: load_record: %.4s %d", tag, id);
+
+  id_name(id,name);
+  if (!strncmp(tag,P3DB_TAG_SPHERE,4)) {
+    pg_open(name);
+    pg_sphere();
+    pg_close();
+  }
+  else if (!strncmp(tag,P3DB_TAG_CYLINDER,4)) {
+    pg_open(name);
+    pg_cylinder();
+    pg_close();
+  }
+  else if (!strncmp(tag,P3DB_TAG_TORUS,4)) {
+    major= get_float();
+    minor= get_float();
+    if (overrun) return;
+    pg_open(name);
+    pg_torus(major, minor);
+    pg_close();
+  }
+  else if (!strncmp(tag,P3DB_TAG_POLYMARKER,4)
+	   || !strncmp(tag,P3DB_TAG_POLYLINE,4)
+	   || !strncmp(tag,P3DB_TAG_POLYGON,4)
+	   || !strncmp(tag,P3DB_TAG_TRISTRIP,4)
+	   || !strncmp(tag,P3DB_TAG_BEZIER,4))
+    load_vlist_prim(tag, name);
+  else if (!strncmp(tag,P3DB_TAG_MESH,4)) load_mesh(name);
+  else if (!strncmp(tag,P3DB_TAG_TEXT,4)) {
+    point.x= get_float();
+    point.y= get_float();
+    point.z= get_float();
+    u.x= get_float();
+    u.y= get_float();
+    u.z= get_float();
+    v.x= get_float();
+    v.y= get_float();
+    v.z= get_float();
+    string= get_string();
+    if (!overrun) {
+      pg_open(name);
+      pg_text(string, &point, &u, &v);
+      pg_close();
+    }
+    free( (P_Void_ptr)string );
+  }
+  else if (!strncmp(tag,P3DB_TAG_LIGHT,4)) {
+    point.x= get_float();
+    point.y= get_float();
+    point.z= get_float();
+    color.ctype= P3D_RGB;
+    color.r= get_float();
+    color.g= get_float();
+    color.b= get_float();
+    color.a= 1.0;
+    if (overrun) return;
+    pg_open(name);
+    pg_light(&point, &color);
+    pg_close();
+  }
+  else if (!strncmp(tag,P3DB_TAG_AMBIENT,4)) {
+    color.ctype= P3D_RGB;
+    color.r= get_float();
+    color.g= get_float();
+    color.b= get_float();
+    color.a= 1.0;
+    if (overrun) return;
+    pg_open(name);
+    pg_ambient(&color);
+    pg_close();
+  }
+  else if (!strncmp(tag,P3DB_TAG_GOB,4)) load_gob(name);
+  else if (!strncmp(tag,P3DB_TAG_CAMERA,4)) load_camera(name);
+  else if (!strncmp(tag,P3DB_TAG_SNAP,4)) {
+    int lights= get_int();
+    int camera= get_int();
+    if (overrun) return;
+    pg_snap(name, lights_name(lights,name2), camera_name(camera,name3));
+  }
+  else if (!strncmp(tag,P3DB_TAG_FREE,4)) pg_free(name);
+  else if (!strncmp(tag,P3DB_TAG_HOLD,4)
+	   || !strncmp(tag,P3DB_TAG_UNHOLD,4)) {
+    /* Loaded GOBs are named, and so are held until they are freed */
+  }
+  else ger_debug("p3d_load: load_record: skipping unknown record %.4s",tag);
+}
+
+static int load_binary( FILE *infile, char *path )
+/* This routine replays the records of a binary P3D file */
+{
+  unsigned char head[P3DB_RECORD_BYTES];
+  char tag[4];
+  double nbytes;
+  int id;
+
+  while (fread(head,1,P3DB_RECORD_BYTES,infile) == P3DB_RECORD_BYTES) {
+    memcpy(tag, head, 4);
+    here= head+4;
+    end= head+P3DB_RECORD_BYTES;
+    overrun= 0;
+    id= get_int();
+    nbytes= get_word();
+    nbytes += 4294967296.0*get_word();
+    if (nbytes > (double)((size_t)-1)/2) {
+      ger_error("p3d_load: record in <%s> is too large to load", path);
+      return(P3D_FAILURE);
+    }
+
+    if (nbytes > payload_space) {
+      if (payload) free( (P_Void_ptr)payload );
+      payload_space= (size_t)nbytes;
+      if ( !(payload= (unsigned char *)malloc(payload_space)) )
+	ger_fatal("p3d_load: unable to allocate %.0f bytes!",nbytes);
+    }
+    if (fread(payload,1,(size_t)nbytes,infile) != (size_t)nbytes) {
+      ger_error("p3d_load: file <%s> is truncated", path);
+      return(P3D_FAILURE);
+    }
+
+    here= payload;
+    end= payload + (size_t)nbytes;
+    load_record(tag, id);
+    if (overrun) {
+      ger_error("p3d_load: bad %.4s record in file <%s>", tag, path);
+      return(P3D_FAILURE);
+    }
+  }
+
+  if (!feof(infile)) {
+    ger_error("p3d_load: error reading file <%s>", path);
+    return(P3D_FAILURE);
+  }
+  return(P3D_SUCCESS);
+}
+
+/* Text tokenizer state */
+#define TEXTBUFSIZE 65536
+#define MAXATOM 256
+
+#define TK_EOF 0
+#define TK_OPEN 1
+#define TK_CLOSE 2
+#define TK_QUOTE 3
+#define TK_STRING 4
+#define TK_ATOM 5
+
+static FILE *textfile;
+static unsigned char *textbuf= (unsigned char *)0;
+static int textpos, textlen, textline;
+static char atom[MAXATOM];
+static char *tstring= (char *)0;
+static int tstring_space= 0;
+static int pushed;   /* token pushed back by unget_token, or -1 */
+static int bad;      /* set on a parse error */
+
+/* Vertex, facet, and attribute data for the form being read */
+static float *vbuf= (float *)0;
+static int vbuf_space= 0;
+static int *ibuf= (int *)0, *lbuf= (int *)0;
+static int ibuf_space= 0, lbuf_space= 0;
+
+typedef struct text_attr_struct {
+  char name[MAXATOM];
+  int type;
+  int ival;
+  float f[16];
+  char *string;
+  P_Material *mat;
+} Text_Attr;
+static Text_Attr *abuf= (Text_Attr *)0;
+static int abuf_space= 0;
+static char *kbuf= (char *)0;
+static int kbuf_space= 0;
+
+/* Powers of ten which are exactly representable as floats */
+static float exact_pow10[]= {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10
+};
+
+/* Vertex list and mesh forms, with the primitives they make */
+static struct text_form_struct {
+  char *name;
+  char *tag;
+  int flags;
+} text_forms[]= {
+  { "pm", P3DB_TAG_POLYMARKER, 0 },
+  { "pmc", P3DB_TAG_POLYMARKER, P3DB_VTX_COLOR },
+  { "pmcn", P3DB_TAG_POLYMARKER, P3DB_VTX_COLOR | P3DB_VTX_NORMAL },
+  { "pmn", P3DB_TAG_POLYMARKER, P3DB_VTX_NORMAL },
+  { "pl", P3DB_TAG_POLYLINE, 0 },
+  { "plc", P3DB_TAG_POLYLINE, P3DB_VTX_COLOR },
+  { "plcn", P3DB_TAG_POLYLINE, P3DB_VTX_COLOR | P3DB_VTX_NORMAL },
+  { "pln", P3DB_TAG_POLYLINE, P3DB_VTX_NORMAL },
+  { "pg", P3DB_TAG_POLYGON, 0 },
+  { "pgc", P3DB_TAG_POLYGON, P3DB_VTX_COLOR },
+  { "pgcn", P3DB_TAG_POLYGON, P3DB_VTX_COLOR | P3DB_VTX_NORMAL },
+  { "pgn", P3DB_TAG_POLYGON, P3DB_VTX_NORMAL },
+  { "tri", P3DB_TAG_TRISTRIP, 0 },
+  { "tric", P3DB_TAG_TRISTRIP, P3DB_VTX_COLOR },
+  { "tricn", P3DB_TAG_TRISTRIP, P3DB_VTX_COLOR | P3DB_VTX_NORMAL },
+  { "trin", P3DB_TAG_TRISTRIP, P3DB_VTX_NORMAL },
+  { "bp", P3DB_TAG_BEZIER, 0 },
+  { "bpc", P3DB_TAG_BEZIER, P3DB_VTX_COLOR },
+  { "bpcn", P3DB_TAG_BEZIER, P3DB_VTX_COLOR | P3DB_VTX_NORMAL },
+  { "bpn", P3DB_TAG_BEZIER, P3DB_VTX_NORMAL },
+  { "msh", P3DB_TAG_MESH, 0 },
+  { "mshc", P3DB_TAG_MESH, P3DB_VTX_COLOR },
+  { "mshcn", P3DB_TAG_MESH, P3DB_VTX_COLOR | P3DB_VTX_NORMAL },
+  { "mshn", P3DB_TAG_MESH, P3DB_VTX_NORMAL },
+  { (char *)0, (char *)0, 0 }
+};
+
+static P_Void_ptr grow( P_Void_ptr buf, int *space, int needed, int size )
+/* This routine makes sure buf has room for needed items of the given
+ * size, doubling it if not.
+ */
+{
+  if (needed > *space) {
+    int newspace= (*space) ? 2*(*space) : 1024;
+    while (newspace < needed) newspace *= 2;
+    if ( !(buf= (P_Void_ptr)realloc(buf, newspace*size)) )
+      ger_fatal("p3d_load: grow: unable to allocate %d bytes!",
+		newspace*size);
+    *space= newspace;
+  }
+  return(buf);
+}
+
+static int refill( VOIDLIST )
+/* This routine refills the text input buffer, returning its first
+ * character or EOF.
+ */
+{
+  textlen= fread(textbuf, 1, TEXTBUFSIZE, textfile);
+  textpos= 0;
+  if (textlen<=0) {
+    textlen= 0;
+    return(EOF);
+  }
+  return( textbuf[textpos++] );
+}
+
+#define NEXT_CHAR() ( (textpos<textlen) ? textbuf[textpos++] : refill() )
+
+static int next_token( VOIDLIST )
+/* This routine returns the type of the next token.  The text of atoms
+ * is left in atom, and that of strings in tstring.
+ */
+{
+  int c, n;
+
+  if (pushed>=0) {
+    c= pushed;
+    pushed= -1;
+    return(c);
+  }
+
+  while (1) {
+    c= NEXT_CHAR();
+    switch (c) {
+    case EOF: return(TK_EOF);
+    case '\n': textline++; break;
+    case ' ': case '\t': case '\r': case '\f': break;
+    case ';':
+      while ((c= NEXT_CHAR()) != EOF && c != '\n');
+      if (c==EOF) return(TK_EOF);
+      textline++;
+      break;
+    case '(': return(TK_OPEN);
+    case ')': return(TK_CLOSE);
+    case '\'': return(TK_QUOTE);
+    case '"':
+      n= 0;
+      while ((c= NEXT_CHAR()) != EOF && c != '"') {
+	if (c=='\\' && (c= NEXT_CHAR()) == EOF) break;
+	if (c=='\n') textline++;
+	tstring= (char *)grow(tstring, &tstring_space, n+2, 1);
+	tstring[n++]= c;
+      }
+      tstring= (char *)grow(tstring, &tstring_space, n+1, 1);
+      tstring[n]= '\0';
+      return(TK_STRING);
+    default:
+      n= 0;
+      do {
+	if (n<MAXATOM-1) atom[n++]= c;
+	c= NEXT_CHAR();
+      } while (c!=EOF && c!=' ' && c!='\n' && c!='\t' && c!='\r'
+	       && c!='(' && c!=')' && c!=';' && c!='"' && c!='\'');
+      if (c!=EOF) textpos--;
+      atom[n]= '\0';
+      return(TK_ATOM);
+    }
+  }
+}
+
+static void unget_token( int token )
+{
+  pushed= token;
+}
+
+static void parse_error( char *expected )
+/* This routine reports the first parse error in a file */
+{
+  if (!bad) ger_error("pg_load_p3d: line %d: expected %s", textline, expected);
+  bad= 1;
+}
+
+static int expect( int token, char *expected )
+/* This routine reads a token, which must be of the given type */
+{
+  if (next_token() != token) {
+    parse_error(expected);
+    return(0);
+  }
+  return(1);
+}
+
+static int expect_atom( char *name )
+/* This routine reads a token, which must be the given atom */
+{
+  if (next_token() != TK_ATOM || strcmp(atom,name)) {
+    parse_error(name);
+    return(0);
+  }
+  return(1);
+}
+
+static int parse_float( char *s, float *result )
+/* This routine converts a number to a float.  Numbers of up to 7
+ * significant digits with small exponents have a mantissa and a power
+ * of ten which are exact floats, so a single float multiply or divide
+ * rounds them correctly;  others are passed to strtof.  Going through
+ * a double would round twice.  The inf and nan written by nf_float are
+ * accepted.  Zero is returned if s is not a number.
+ */
+{
+  char *start= s;
+  double mant= 0.0;
+  int digits= 0, scale= 0, exponent= 0, any= 0, neg= 0, eneg= 0;
+
+  if (*s=='-') { neg= 1; s++; }
+  else if (*s=='+') s++;
+  if (!strcmp(s,"inf") || !strcmp(s,"nan")) {
+    *result= strtof(start, (char **)0);
+    return(1);
+  }
+  for (; *s>='0' && *s<='9'; s++) {
+    mant= 10.0*mant + (*s-'0');
+    if (mant>0.0) digits++;
+    any= 1;
+  }
+  if (*s=='.') 
+    for (s++; *s>='0' && *s<='9'; s++) {
+      mant= 10.0*mant + (*s-'0');
+      if (mant>0.0) digits++;
+      scale--;
+      any= 1;
+    }
+  if (!any) return(0);
+  if (*s=='e' || *s=='E') {
+    s++;
+    if (*s=='-') { eneg= 1; s++; }
+    else if (*s=='+') s++;
+    if (*s<'0' || *s>'9') return(0);
+    for (; *s>='0' && *s<='9'; s++)
+      if (exponent<10000) exponent= 10*exponent + (*s-'0');
+  }
+  if (*s) return(0);
+
+  exponent= (eneg ? -exponent : exponent) + scale;
+  if (digits<=7 && exponent>=-10 && exponent<=10) {
+    float fmant= (float)mant;
+    if (exponent<0) fmant /= exact_pow10[-exponent];
+    else fmant *= exact_pow10[exponent];
+    *result= neg ? -fmant : fmant;
+  }
+  else *result= strtof(start, (char **)0);
+  return(1);
+}
+
+static float get_number( VOIDLIST )
+{
+  float val= 0.0;
+
+  if (next_token() != TK_ATOM || !parse_float(atom, &val))
+    parse_error("a number");
+  return( val );
+}
+
+static int get_integer( VOIDLIST )
+{
+  char *tail;
+  long val= 0;
+
+  if (next_token() != TK_ATOM
+      || (val= strtol(atom, &tail, 10), *tail) ) parse_error("an integer");
+  return( (int)val );
+}
+
+static void get_numbers( float *vals, int n )
+/* This routine reads a parenthesized list of n numbers */
+{
+  int i;
+
+  if (!expect(TK_OPEN,"(")) return;
+  for (i=0; i<n; i++) vals[i]= get_number();
+  expect(TK_CLOSE,")");
+}
+
+static void skip_form( int depth )
+/* This routine skips tokens until depth open parentheses are closed */
+{
+  int token;
+
+  while (depth>0) {
+    token= next_token();
+    if (token==TK_OPEN) depth++;
+    else if (token==TK_CLOSE) depth--;
+    else if (token==TK_EOF) {
+      parse_error(")");
+      return;
+    }
+  }
+}
+
+static int text_vertices( int flags )
+/* This routine reads the quoted vertex list of a primitive into vbuf,
+ * returning the number of vertices.
+ */
+{
+  int n= 0, fpv, noff, token;
+  float *vtx, dummy[4];
+
+  vtx_layout(flags, &fpv);
+  noff= (flags & P3DB_VTX_COLOR) ? 7 : 3;
+  if (!expect(TK_QUOTE,"'") || !expect(TK_OPEN,"(")) return(0);
+  while (!bad && (token= next_token()) == TK_OPEN) {
+    vbuf= (float *)grow(vbuf, &vbuf_space, fpv*(n+1), sizeof(float));
+    vtx= vbuf + fpv*n;
+    vtx[0]= get_number();
+    vtx[1]= get_number();
+    vtx[2]= get_number();
+    if (flags & P3DB_VTX_COLOR) get_numbers(vtx+3, 4);
+    else if (flags & P3DB_VTX_NORMAL) get_numbers(dummy, 0); /* the () */
+    if (flags & P3DB_VTX_NORMAL) get_numbers(vtx+noff, 3);
+    expect(TK_CLOSE,")");
+    n++;
+  }
+  if (!bad && token!=TK_CLOSE) parse_error("a vertex");
+  return(n);
+}
+
+static void text_vlist_prim( struct text_form_struct *form, char *name )
+/* This routine reads a primitive defined by a vertex list, or a mesh */
+{
+  P_Vlist *vlist;
+  int n, nfacets= 0, nindices= 0, fpv, vtxtype, token;
+
+  if (!strcmp(form->tag,P3DB_TAG_MESH)) get_integer(); /* vertex count */
+  n= text_vertices(form->flags);
+  if (!strcmp(form->tag,P3DB_TAG_MESH) && !bad) {
+    if (!expect(TK_QUOTE,"'") || !expect(TK_OPEN,"(")) return;
+    while (!bad && (token= next_token()) == TK_OPEN) {
+      lbuf= (int *)grow(lbuf, &lbuf_space, nfacets+1, sizeof(int));
+      lbuf[nfacets]= 0;
+      while (!bad && (token= next_token()) == TK_ATOM) {
+	unget_token(token);
+	ibuf= (int *)grow(ibuf, &ibuf_space, nindices+1, sizeof(int));
+	if ((ibuf[nindices++]= get_integer()) >= n || ibuf[nindices-1] < 0)
+	  parse_error("a vertex index");
+	lbuf[nfacets]++;
+      }
+      if (!bad && token!=TK_CLOSE) parse_error(")");
+      nfacets++;
+    }
+    if (!bad && token!=TK_CLOSE) parse_error("a facet");
+  }
+  expect(TK_CLOSE,")");
+  if (bad) return;
+
+  vtxtype= vtx_layout(form->flags, &fpv);
+  vlist= po_create_cvlist(vtxtype, n, vbuf);
+  if (!strcmp(form->tag,P3DB_TAG_MESH)) {
+    pg_open(name);
+    pg_mesh(vlist, ibuf, lbuf, nfacets);
+    pg_close();
+  }
+  else define_vlist_prim(form->tag, name, vlist);
+}
+
+static void text_trans( P_Transform *trans )
+/* This routine reads the rest of a (trns '((a b c d) ...)) form */
+{
+  int i;
+
+  trans->type_front= (P_Transform_type *)0;
+  if (!expect(TK_QUOTE,"'") || !expect(TK_OPEN,"(")) return;
+  for (i=0; i<4; i++) get_numbers(trans->d+4*i, 4);
+  expect(TK_CLOSE,")");
+  expect(TK_CLOSE,")");
+}
+
+static void text_attr( Text_Attr *attr )
+/* This routine reads the rest of a (cons 'name value) form */
+{
+  float val;
+  long ival;
+  char *tail;
+  int token;
+
+  attr->string= (char *)0;
+  if (!expect(TK_QUOTE,"'") || !expect(TK_ATOM,"an attribute name")) return;
+  strcpy(attr->name, atom);
+
+  token= next_token();
+  if (token==TK_STRING) {
+    attr->type= P3D_STRING;
+    if ( !(attr->string= (char *)malloc(strlen(tstring)+1)) )
+      ger_fatal("p3d_load: text_attr: unable to allocate %d bytes!",
+		strlen(tstring)+1);
+    strcpy(attr->string, tstring);
+  }
+  else if (token==TK_ATOM) {
+    attr->mat= (P_Material *)0;
+    if (!strcmp(atom,"T") || !strcmp(atom,"nil")) {
+      attr->type= P3D_BOOLEAN;
+      attr->ival= !strcmp(atom,"T");
+    }
+    else if (!strcmp(atom,"default-material")) attr->mat= p3d_default_material;
+    else if (!strcmp(atom,"dull-material")) attr->mat= p3d_dull_material;
+    else if (!strcmp(atom,"shiny-material")) attr->mat= p3d_shiny_material;
+    else if (!strcmp(atom,"metallic-material"))
+      attr->mat= p3d_metallic_material;
+    else if (!strcmp(atom,"matte-material")) attr->mat= p3d_matte_material;
+    else if (!strcmp(atom,"aluminum-material"))
+      attr->mat= p3d_aluminum_material;
+    else if (strpbrk(atom,".eE")) {
+      if (!parse_float(atom, &val)) parse_error("an attribute value");
+      attr->type= P3D_FLOAT;
+      attr->f[0]= val;
+    }
+    else {
+      ival= strtol(atom, &tail, 10);
+      if (*tail || tail==atom) parse_error("an attribute value");
+      attr->type= P3D_INT;
+      attr->ival= (int)ival;
+    }
+    if (attr->mat) attr->type= P3D_MATERIAL;
+  }
+  else if (token==TK_OPEN && next_token()==TK_ATOM) {
+    if (!strcmp(atom,"clr")) {
+      attr->type= P3D_COLOR;
+      attr->f[0]= get_number();
+      attr->f[1]= get_number();
+      attr->f[2]= get_number();
+      attr->f[3]= get_number();
+      expect(TK_CLOSE,")");
+    }
+    else if (!strcmp(atom,"pt") || !strcmp(atom,"vec")) {
+      attr->type= (atom[0]=='p') ? P3D_POINT : P3D_VECTOR;
+      attr->f[0]= get_number();
+      attr->f[1]= get_number();
+      attr->f[2]= get_number();
+      expect(TK_CLOSE,")");
+    }
+    else if (!strcmp(atom,"trns")) {
+      P_Transform trans;
+      attr->type= P3D_TRANSFORM;
+      text_trans(&trans);
+      memcpy(attr->f, trans.d, 16*sizeof(float));
+    }
+    else parse_error("an attribute value");
+  }
+  else parse_error("an attribute value");
+  expect(TK_CLOSE,")");
+}
+
+static void add_text_attr( Text_Attr *attr )
+/* This routine adds an attribute read from text to the open GOB */
+{
+  P_Color color;
+  P_Point point;
+  P_Vector vector;
+  P_Transform trans;
+
+  switch (attr->type) {
+  case P3D_INT: pg_int_attr(attr->name, attr->ival); break;
+  case P3D_BOOLEAN: pg_bool_attr(attr->name, attr->ival); break;
+  case P3D_FLOAT: pg_float_attr(attr->name, attr->f[0]); break;
+  case P3D_STRING: pg_string_attr(attr->name, attr->string); break;
+  case P3D_COLOR:
+    color.ctype= P3D_RGB;
+    color.r= attr->f[0];
+    color.g= attr->f[1];
+    color.b= attr->f[2];
+    color.a= attr->f[3];
+    pg_color_attr(attr->name, &color);
+    break;
+  case P3D_POINT:
+    point.x= attr->f[0];
+    point.y= attr->f[1];
+    point.z= attr->f[2];
+    pg_point_attr(attr->name, &point);
+    break;
+  case P3D_VECTOR:
+    vector.x= attr->f[0];
+    vector.y= attr->f[1];
+    vector.z= attr->f[2];
+    pg_vector_attr(attr->name, &vector);
+    break;
+  case P3D_TRANSFORM:
+    memcpy(trans.d, attr->f, 16*sizeof(float));
+    trans.type_front= (P_Transform_type *)0;
+    pg_trans_attr(attr->name, &trans);
+    break;
+  case P3D_MATERIAL: pg_material_attr(attr->name, attr->mat); break;
+  }
+}
+
+static void text_gob( char *name )
+/* This routine reads the rest of a def-gob form */
+{
+  P_Transform trans;
+  int token, nkids= 0, nattr= 0, i, len;
+
+  if (!expect_atom(":children") || !expect(TK_OPEN,"(")
+      || !expect_atom("list")) return;
+  while ((token= next_token()) == TK_ATOM) {
+    kbuf= (char *)grow(kbuf, &kbuf_space, (nkids+1)*P3D_NAMELENGTH, 1);
+    if ((len= strlen(atom)) > P3D_NAMELENGTH-1) len= P3D_NAMELENGTH-1;
+    memcpy(kbuf+nkids*P3D_NAMELENGTH, atom, len);
+    kbuf[nkids*P3D_NAMELENGTH+len]= '\0';
+    nkids++;
+  }
+  if (token!=TK_CLOSE) parse_error("a child name");
+
+  /* As with attributes below, children are listed in reverse order */
+  pg_open(name);
+  for (i=nkids-1; i>=0; i--) pg_child(kbuf+i*P3D_NAMELENGTH);
+
+  token= next_token();
+  if (!bad && token==TK_ATOM && !strcmp(atom,":transform")) {
+    if (expect(TK_OPEN,"(") && expect_atom("trns")) text_trans(&trans);
+    if (!bad) add_transform(&trans);
+    token= next_token();
+  }
+  if (!bad && token==TK_ATOM && !strcmp(atom,":attr")) {
+    if (expect(TK_OPEN,"(") && expect_atom("list"))
+      while (!bad && (token= next_token()) == TK_OPEN) {
+	abuf= (Text_Attr *)grow(abuf, &abuf_space, nattr+1, sizeof(Text_Attr));
+	if (expect_atom("cons")) text_attr(abuf+nattr);
+	nattr++;
+      }
+    if (!bad && token!=TK_CLOSE) parse_error("an attribute");
+    token= next_token();
+  }
+  if (!bad && token!=TK_CLOSE) parse_error(")");
+
+  /* Attributes are added in reverse, since each goes on the front of
+   * the GOB's attribute list.
+   */
+  for (i=nattr-1; i>=0; i--) {
+    if (!bad) add_text_attr(abuf+i);
+    if (abuf[i].string) free( (P_Void_ptr)abuf[i].string );
+  }
+  pg_close();
+}
+
+static void text_camera( char *name )
+/* This routine reads the rest of a make-camera form */
+{
+  P_Point lookfrom, lookat;
+  P_Vector up;
+  P_Color background;
+  float fovea= 45.0, hither= -1.0, yon= -50.0;
+  float vals[4];
+  char key[MAXATOM];
+  int token;
+
+  lookfrom.x= lookfrom.y= 0.0; lookfrom.z= 20.0;
+  lookat.x= lookat.y= lookat.z= 0.0;
+  up.x= up.z= 0.0; up.y= 1.0;
+  background.ctype= P3D_RGB;
+  background.r= background.g= background.b= 0.0;
+  background.a= 1.0;
+
+  while (!bad && (token= next_token()) == TK_ATOM) {
+    strcpy(key, atom);
+    if (!strcmp(key,":fovea")) fovea= get_number();
+    else if (!strcmp(key,":hither")) hither= get_number();
+    else if (!strcmp(key,":yon")) yon= get_number();
+    else {
+      /* (make-point :x 1 :y 2 :z 3) or (make-color :r 1 :g 2 :b 3 :a 4) */
+      vals[0]= vals[1]= vals[2]= 0.0;
+      vals[3]= 1.0;
+      if (!expect(TK_OPEN,"(") || !expect(TK_ATOM,"make-point")) break;
+      while (!bad && (token= next_token()) == TK_ATOM) 
+	switch (atom[1]) {
+	case 'x': case 'r': vals[0]= get_number(); break;
+	case 'y': case 'g': vals[1]= get_number(); break;
+	case 'z': case 'b': vals[2]= get_number(); break;
+	case 'a': vals[3]= get_number(); break;
+	default: parse_error("a coordinate");
+	}
+      if (!bad && token!=TK_CLOSE) parse_error(")");
+      if (!strcmp(key,":lookfrom")) {
+	lookfrom.x= vals[0]; lookfrom.y= vals[1]; lookfrom.z= vals[2];
+      }
+      else if (!strcmp(key,":lookat")) {
+	lookat.x= vals[0]; lookat.y= vals[1]; lookat.z= vals[2];
+      }
+      else if (!strcmp(key,":up")) {
+	up.x= vals[0]; up.y= vals[1]; up.z= vals[2];
+      }
+      else if (!strcmp(key,":background")) {
+	background.r= vals[0]; background.g= vals[1];
+	background.b= vals[2]; background.a= vals[3];
+      }
+    }
+  }
+  if (bad) return;
+  if (token!=TK_CLOSE) {
+    parse_error(")");
+    return;
+  }
+  pg_camera(name, &lookfrom, &lookat, &up, fovea, hither, yon);
+  pg_camera_background(name, &background);
+}
+
+static char *text_lights( char *name, char *buf )
+{
+  if (!strcmp(name,"default-lights")) return(lights_name(P3DB_DEFAULT_ID,buf));
+  return(name);
+}
+
+static char *text_camera_name( char *name, char *buf )
+{
+  if (!strcmp(name,"default-camera")) return(camera_name(P3DB_DEFAULT_ID,buf));
+  return(name);
+}
+
+static void text_setq( VOIDLIST )
+/* This routine reads the rest of a setq form */
+{
+  char name[P3D_NAMELENGTH];
+  struct text_form_struct *form;
+  P_Point point;
+  P_Vector u, v;
+  P_Color color;
+  float vals[3];
+  int token;
+
+  if (!expect(TK_ATOM,"a symbol")) return;
+  if (atom[0]!='s' || atom[1]<'0' || atom[1]>'9') {
+    /* Not a symbol written for a definition; the preamble uses these */
+    skip_form(1);
+    return;
+  }
+  strncpy(name, atom, P3D_NAMELENGTH-1);
+  name[P3D_NAMELENGTH-1]= '\0';
+
+  token= next_token();
+  if (token==TK_ATOM) { /* (setq sN nil) after a free */
+    expect(TK_CLOSE,")");
+    return;
+  }
+  if (token!=TK_OPEN || !expect(TK_ATOM,"a definition")) {
+    parse_error("a definition");
+    return;
+  }
+
+  if (!strcmp(atom,"sphere") || !strcmp(atom,"cylinder")) {
+    int sphere= (atom[0]=='s');
+    if (!expect(TK_CLOSE,")")) return;
+    pg_open(name);
+    if (sphere) pg_sphere();
+    else pg_cylinder();
+    pg_close();
+  }
+  else if (!strcmp(atom,"torus")) {
+    vals[0]= get_number();
+    vals[1]= get_number();
+    if (!expect(TK_CLOSE,")")) return;
+    pg_open(name);
+    pg_torus(vals[0], vals[1]);
+    pg_close();
+  }
+  else if (!strcmp(atom,"tx")) {
+    if (!expect(TK_STRING,"a string")) return;
+    if (!expect(TK_QUOTE,"'")) return;
+    get_numbers(vals,3);
+    point.x= vals[0]; point.y= vals[1]; point.z= vals[2];
+    if (!expect(TK_QUOTE,"'")) return;
+    get_numbers(vals,3);
+    u.x= vals[0]; u.y= vals[1]; u.z= vals[2];
+    if (!expect(TK_QUOTE,"'")) return;
+    get_numbers(vals,3);
+    v.x= vals[0]; v.y= vals[1]; v.z= vals[2];
+    if (!expect(TK_CLOSE,")")) return;
+    pg_open(name);
+    pg_text(tstring, &point, &u, &v);
+    pg_close();
+  }
+  else if (!strcmp(atom,"lt") || !strcmp(atom,"amb")) {
+    int light= (atom[0]=='l');
+    if (light) {
+      if (!expect(TK_QUOTE,"'")) return;
+      get_numbers(vals,3);
+      point.x= vals[0]; point.y= vals[1]; point.z= vals[2];
+    }
+    if (!expect(TK_QUOTE,"'")) return;
+    get_numbers(vals,3);
+    if (!expect(TK_CLOSE,")")) return;
+    color.ctype= P3D_RGB;
+    color.r= vals[0]; color.g= vals[1]; color.b= vals[2];
+    color.a= 1.0;
+    pg_open(name);
+    if (light) pg_light(&point, &color);
+    else pg_ambient(&color);
+    pg_close();
+  }
+  else if (!strcmp(atom,"def-gob")) text_gob(name);
+  else if (!strcmp(atom,"make-camera")) text_camera(name);
+  else {
+    for (form= text_forms; form->name; form++)
+      if (!strcmp(atom,form->name)) break;
+    if (form->name) text_vlist_prim(form, name);
+    else {
+      ger_debug("pg_load_p3d: line %d: skipping <%s>", textline, atom);
+      skip_form(1);
+    }
+  }
+  if (!bad) expect(TK_CLOSE,")");
+}
+
+static int load_text( FILE *infile, char *path )
+/* This routine replays the forms of a P3D text file */
+{
+  char model[P3D_NAMELENGTH], lights[P3D_NAMELENGTH], camera[P3D_NAMELENGTH];
+  char buf1[P3D_NAMELENGTH], buf2[P3D_NAMELENGTH];
+  int token;
+
+  if ( !(textbuf= (unsigned char *)malloc(TEXTBUFSIZE)) )
+    ger_fatal("p3d_load: load_text: unable to allocate %d bytes!",
+	      TEXTBUFSIZE);
+  textfile= infile;
+  textpos= textlen= 0;
+  textline= 1;
+  pushed= -1;
+  bad= 0;
+
+  while (!bad && (token= next_token()) != TK_EOF) {
+    if (token!=TK_OPEN || !expect(TK_ATOM,"a form")) {
+      parse_error("(");
+      break;
+    }
+    if (!strcmp(atom,"setq")) text_setq();
+    else if (!strcmp(atom,"snap")) {
+      if (!expect(TK_ATOM,"a model")) break;
+      strncpy(model, atom, P3D_NAMELENGTH-1);
+      model[P3D_NAMELENGTH-1]= '\0';
+      if (!expect(TK_ATOM,"a lighting gob")) break;
+      strncpy(lights, atom, P3D_NAMELENGTH-1);
+      lights[P3D_NAMELENGTH-1]= '\0';
+      if (!expect(TK_ATOM,"a camera")) break;
+      strncpy(camera, atom, P3D_NAMELENGTH-1);
+      camera[P3D_NAMELENGTH-1]= '\0';
+      if (!expect(TK_CLOSE,")")) break;
+      pg_snap(model, text_lights(lights,buf1), text_camera_name(camera,buf2));
+    }
+    else if (!strcmp(atom,"free-gob")) {
+      if (!expect(TK_ATOM,"a gob")) break;
+      strncpy(model, atom, P3D_NAMELENGTH-1);
+      model[P3D_NAMELENGTH-1]= '\0';
+      if (!expect(TK_CLOSE,")")) break;
+      pg_free(model);
+    }
+    else skip_form(1); /* hold-gob, unhold-gob, and preamble definitions */
+  }
+
+  free( (P_Void_ptr)textbuf );
+  textbuf= (unsigned char *)0;
+  if (bad) {
+    ger_error("pg_load_p3d: error reading <%s>", path);
+    return(P3D_FAILURE);
+  }
+  return(P3D_SUCCESS);
+}
+
+int pg_load_p3d( char *path )
+/* This routine reads a file written by the P3D renderer, and recreates
+ * the GOBs and cameras it defines, redoing any snaps, on all open
+ * renderers.
+ */
+{
+  FILE *infile;
+  unsigned char head[P3DB_HEADER_BYTES];
+  int version, retval;
+  struct timespec start, finish;
+  double seconds, megabytes;
+
+  ger_debug("pg_load_p3d: loading <%s>", path);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if ( !(infile= fopen(path,"rb")) ) {
+    ger_error("pg_load_p3d: unable to open <%s> for reading", path);
+    return(P3D_FAILURE);
+  }
+
+  have_default_lights= have_default_camera= 0;
+  if (fread(head,1,P3DB_HEADER_BYTES,infile) == P3DB_HEADER_BYTES
+      && !strncmp((char *)head,P3DB_MAGIC,4)) {
+    here= head+4;
+    end= head+P3DB_HEADER_BYTES;
+    overrun= 0;
+    if ((version= get_int()) > P3DB_VERSION) {
+      ger_error("pg_load_p3d: <%s> is binary P3D version %d; can't read it",
+		path, version);
+      retval= P3D_FAILURE;
+    }
+    else retval= load_binary(infile, path);
+  }
+  else {
+    rewind(infile);
+    retval= load_text(infile, path);
+  }
+
+  megabytes= ftell(infile)/(1024.0*1024.0);
+  clock_gettime(CLOCK_MONOTONIC, &finish);
+  seconds= (finish.tv_sec - start.tv_sec) 
+    + 1e-9*(finish.tv_nsec - start.tv_nsec);
+  ger_debug("pg_load_p3d: read %f MB in %f seconds (%f MB/s)",
+	    megabytes, seconds, (seconds>0.0) ? megabytes/seconds : 0.0);
+
+  fclose(infile);
+  if (payload) {
+    free( (P_Void_ptr)payload );
+    payload= (unsigned char *)0;
+    payload_space= 0;
+  }
+  if (vbuf) free( (P_Void_ptr)vbuf );
+  if (ibuf) free( (P_Void_ptr)ibuf );
+  if (lbuf) free( (P_Void_ptr)lbuf );
+  if (abuf) free( (P_Void_ptr)abuf );
+  if (tstring) free( (P_Void_ptr)tstring );
+  if (kbuf) free( (P_Void_ptr)kbuf );
+  vbuf= (float *)0;
+  ibuf= lbuf= (int *)0;
+  abuf= (Text_Attr *)0;
+  tstring= kbuf= (char *)0;
+  vbuf_space= ibuf_space= lbuf_space= abuf_space= tstring_space= 0;
+  kbuf_space= 0;
+  return(retval);
+}
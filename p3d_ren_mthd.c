@@ -19,20 +19,31 @@ This module provides renderer methods.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "indent.h"
 #include "ge_error.h"
+#include "bgwrite.h"
+#include "numfmt.h"
 
 /* Include file containing P3D preamble text */
 #include "p3d_preamble.h"
 
+/* Include file describing the binary P3D format */
+#include "p3d_binary.h"
+
 /* Maximum length of file names and generated symbols (actually includes
  * the final \0).
  */
 #define MAXFILENAME 128
 #define MAXSYMBOLLENGTH P3D_NAMELENGTH
 
+/* Size of the output buffer used for binary P3D */
+#define BINBUFSIZE (1024*1024)
+
 /* Struct to hold info for a color map */
 typedef struct renderer_cmap_struct {
   char name[MAXSYMBOLLENGTH];
@@ -58,6 +69,10 @@ typedef struct renderer_data_struct {
   P_Renderer_Cmap *current_cmap;
   int name_root;
   P_Renderer_Sym_List *free_symbol_list;
+  int binary;
+  unsigned char *binbuf;
+  int binfill;
+  int sync;
 } P_Renderer_data;
 
 #define RENDATA( self ) ((P_Renderer_data *)(self->object_data))
@@ -72,6 +87,9 @@ typedef struct renderer_data_struct {
 #define MAP_MAX( self ) (CUR_MAP(self)->max)
 #define MAP_FUN( self ) (CUR_MAP(self)->mapfun)
 #define FREE_SYMBOL_LIST( self ) (RENDATA(self)->free_symbol_list)
+#define BINARY( self ) (RENDATA(self)->binary)
+#define BINBUF( self ) (RENDATA(self)->binbuf)
+#define BINFILL( self ) (RENDATA(self)->binfill)
 
 /* Space for default color map */
 static P_Renderer_Cmap default_map;
@@ -124,6 +142,96 @@ static void unget_name(P_Renderer *self, char *name)
   FREE_SYMBOL_LIST(self)= cell;
 }
 
+static int name_id( char *name )
+/* This routine returns the binary record id for a symbol name;  sN
+ * becomes N, and the default lights and camera become P3DB_DEFAULT_ID.
+ */
+{
+  if (name[0]=='s' && isdigit((unsigned char)name[1])) return(atoi(name+1));
+  else return(P3DB_DEFAULT_ID);
+}
+
+static void bin_flush( P_Renderer *self )
+/* This routine writes out the binary output buffer */
+{
+  if (BINFILL(self)) {
+    if (fwrite(BINBUF(self),1,BINFILL(self),OFILE(self))
+	!= (size_t)BINFILL(self)) {
+      perror("p3d_ren_mthd: bin_flush:");
+      ger_fatal("p3d_ren_mthd: bin_flush: Error writing file <%s>.",
+		FILENAME(self));
+    }
+    BINFILL(self)= 0;
+  }
+}
+
+static void bin_word( P_Renderer *self, unsigned int word )
+/* This routine buffers 4 bytes in little-endian order */
+{
+  unsigned char *here;
+
+  /* No debugging; called too often */
+  if (BINFILL(self)+4 > BINBUFSIZE) bin_flush(self);
+  here= BINBUF(self) + BINFILL(self);
+  here[0]= word & 0xff;
+  here[1]= (word>>8) & 0xff;
+  here[2]= (word>>16) & 0xff;
+  here[3]= (word>>24) & 0xff;
+  BINFILL(self) += 4;
+}
+
+static void bin_int( P_Renderer *self, int val )
+{
+  bin_word( self, (unsigned int)val );
+}
+
+static void bin_float( P_Renderer *self, double val )
+{
+  union { float f; unsigned int i; } u;
+  u.f= val;
+  bin_word( self, u.i );
+}
+
+static void bin_ints( P_Renderer *self, int *vals, int n )
+{
+  int i;
+  for (i=0; i<n; i++) bin_word( self, (unsigned int)vals[i] );
+}
+
+static void bin_string( P_Renderer *self, char *string )
+/* This routine buffers a counted string */
+{
+  int length= strlen(string);
+
+  bin_int( self, length );
+  while (length>0) {
+    int chunk;
+    if (BINFILL(self) == BINBUFSIZE) bin_flush(self);
+    chunk= BINBUFSIZE - BINFILL(self);
+    if (chunk > length) chunk= length;
+    memcpy( BINBUF(self)+BINFILL(self), string, chunk );
+    BINFILL(self) += chunk;
+    string += chunk;
+    length -= chunk;
+  }
+}
+
+static void bin_record( P_Renderer *self, char *tag, char *name,
+		       double nbytes )
+/* This routine starts a binary record.  The payload size is passed as
+ * a double so that it can exceed the range of an int.
+ */
+{
+  double high= (double)(unsigned long)(nbytes/4294967296.0);
+
+  if (BINFILL(self)+P3DB_RECORD_BYTES > BINBUFSIZE) bin_flush(self);
+  memcpy( BINBUF(self)+BINFILL(self), tag, 4 );
+  BINFILL(self) += 4;
+  bin_int( self, name ? name_id(name) : P3DB_DEFAULT_ID );
+  bin_word( self, (unsigned int)(nbytes - high*4294967296.0) );
+  bin_word( self, (unsigned int)high );
+}
+
 static P_Void_ptr def_cmap( char *name, double min, double max,
 		  void (*mapfun)(float *, float *, float *, float *, float *) )
 /* This function stores a color map definition */
@@ -192,6 +300,28 @@ static P_Void_ptr def_camera( P_Camera *cam )
   if ( RENDATA(self)->open ) {
     lclname= get_name(self,cam->name);
 
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_CAMERA, lclname, 16*4);
+      bin_float(self, cam->lookfrom.x);
+      bin_float(self, cam->lookfrom.y);
+      bin_float(self, cam->lookfrom.z);
+      bin_float(self, cam->lookat.x);
+      bin_float(self, cam->lookat.y);
+      bin_float(self, cam->lookat.z);
+      bin_float(self, cam->up.x);
+      bin_float(self, cam->up.y);
+      bin_float(self, cam->up.z);
+      bin_float(self, cam->background.r);
+      bin_float(self, cam->background.g);
+      bin_float(self, cam->background.b);
+      bin_float(self, cam->background.a);
+      bin_float(self, cam->fovea);
+      bin_float(self, cam->hither);
+      bin_float(self, cam->yon);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
+
     /* Define the camera */
     fprintf(OFILE(self),"(setq %s (make-camera ; camera %s\n",lclname,
 	    cam->name ? cam->name : "none");
@@ -273,6 +403,14 @@ static void ren_open( VOIDLIST )
   METHOD_IN
   ger_debug("p3d_ren_mthd: ren_open");
   RENDATA(self)->open= 1;
+  if ( !RENDATA(self)->initialized && BINARY(self) ) {
+    memcpy( BINBUF(self), P3DB_MAGIC, 4 );
+    BINFILL(self)= 4;
+    bin_int( self, P3DB_VERSION );
+    bin_int( self, 0 );
+    bin_int( self, 0 );
+    RENDATA(self)->initialized= 1;
+  }
   if ( !RENDATA(self)->initialized ) {
     fprintf( OFILE(self), preamble1 );
     fprintf( OFILE(self), preamble2 );
@@ -294,6 +432,13 @@ static void ren_close( VOIDLIST )
   METHOD_IN
   ger_debug("p3d_ren_mthd: ren_close");
   RENDATA(self)->open= 0;
+  /* Wait until everything so far is in the file */
+  if (BINARY(self)) bin_flush(self);
+  if ( bgw_flush(OFILE(self)) == EOF ) {
+    perror("p3d_ren_mthd: ren_close:");
+    ger_fatal("p3d_ren_mthd: ren_close: Error writing file <%s>.",
+	      FILENAME(self));
+  }
   METHOD_OUT
 }
 
@@ -304,11 +449,16 @@ static void ren_destroy( VOIDLIST )
   METHOD_IN
   ger_debug("p3d_ren_mthd: ren_destroy");
   if (RENDATA(self)->open) ren_close();
+  if (BINARY(self)) {
+    bin_flush(self);
+    free( (P_Void_ptr)BINBUF(self) );
+  }
   if ( fclose(RENDATA(self)->outfile) == EOF ) {
     perror("p3d_ren_mthd: ren_destroy:");
     ger_fatal("p3d_ren_mthd: ren_destroy: Error closing file <%s>.",
 	      RENDATA(self)->filename);
   }
+  bgw_drain();
   RENDATA(self)->initialized= 0;
   while (FREE_SYMBOL_LIST(self)) {
     P_Renderer_Sym_List* cell= FREE_SYMBOL_LIST(self);
@@ -330,7 +480,12 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
 
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: ren_gob");
-    if (primdata) 
+    if (primdata && BINARY(self)) {
+      bin_record(self, P3DB_TAG_SNAP, (char *)primdata, 2*4);
+      bin_int(self, name_id(CUR_LIGHTS(self)));
+      bin_int(self, name_id(CUR_CAMERA(self)));
+    }
+    else if (primdata) 
       fprintf(OFILE(self),"(snap %s %s %s)\n", 
               (char *)primdata, CUR_LIGHTS(self), CUR_CAMERA(self)); 
     else ger_error("p3d_ren_mthd: ren_gob: got a null data pointer.");
@@ -365,8 +520,10 @@ static void destroy_gob( P_Void_ptr primdata )
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: destroy_gob");
     if (primdata) {
-      fprintf(OFILE(self),"(free-gob %s)(setq %s nil)\n", 
-	      (char *)primdata,(char *)primdata);
+      if (BINARY(self)) 
+	bin_record(self, P3DB_TAG_FREE, (char *)primdata, 0);
+      else fprintf(OFILE(self),"(free-gob %s)(setq %s nil)\n", 
+		   (char *)primdata,(char *)primdata);
       unget_name( self, (char*)primdata );
     }
     else ger_error("p3d_ren_mthd: destroy_gob: got a null data pointer.");
@@ -384,7 +541,8 @@ static P_Void_ptr def_sphere(char *name)
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: def_sphere");
     lclname= get_name(self,name);
-    fprintf(OFILE(self), "(setq %s (sphere))\n", lclname);
+    if (BINARY(self)) bin_record(self, P3DB_TAG_SPHERE, lclname, 0);
+    else fprintf(OFILE(self), "(setq %s (sphere))\n", lclname);
     METHOD_OUT
     return( (P_Void_ptr)lclname );
   }  
@@ -402,7 +560,8 @@ static P_Void_ptr def_cylinder(char *name)
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: def_cylinder");
     lclname= get_name(self,name);
-    fprintf(OFILE(self), "(setq %s (cylinder))\n", lclname);
+    if (BINARY(self)) bin_record(self, P3DB_TAG_CYLINDER, lclname, 0);
+    else fprintf(OFILE(self), "(setq %s (cylinder))\n", lclname);
     METHOD_OUT
     return( (P_Void_ptr)lclname );
   }  
@@ -420,8 +579,13 @@ static P_Void_ptr def_torus(char *name, double major, double minor)
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: def_torus");
     lclname= get_name(self,name);
-    fprintf(OFILE(self), "(setq %s (torus %f %f))\n", 
-            lclname, major, minor);
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_TORUS, lclname, 2*4);
+      bin_float(self, major);
+      bin_float(self, minor);
+    }
+    else fprintf(OFILE(self), "(setq %s (torus %f %f))\n", 
+		 lclname, major, minor);
     METHOD_OUT
     return( (P_Void_ptr)lclname );
   }  
@@ -445,7 +609,8 @@ static void map_color( P_Renderer *self, float val,
 static void emit_vlist( P_Renderer *self, P_Vlist *vlist )
 /* This routine outputs a vertex list */
 {
-  int i, vcount, type;
+  Nf_Buffer nf;
+  int i, vcount, type, color= 0, normal= 0, mapped= 0;
   float r, g, b, a;
 
   ger_debug("p3d_ren_mthd: emit_vlist");
@@ -453,49 +618,133 @@ static void emit_vlist( P_Renderer *self, P_Vlist *vlist )
   vcount= vlist->length;
   type= vlist->type;
 
-  for (i=0; i<vcount; i++) 
-    switch (type) {
-    case P3D_CVTX:   
-      fprintf(OFILE(self), "(%g %g %g)\n",
-          (*(vlist->x))(i), (*(vlist->y))(i), (*(vlist->z))(i)
-          ); 
-      break;
-    case P3D_CCVTX:  
-      fprintf(OFILE(self), "(%g %g %g (%g %g %g %g))\n",
-          (*(vlist->x))(i),(*(vlist->y))(i),(*(vlist->z))(i),
-          (*(vlist->r))(i),(*(vlist->g))(i),(*(vlist->b))(i),(*(vlist->a))(i)
-          ); 
-      break;
-    case P3D_CCNVTX: 
-      fprintf(OFILE(self), "(%g %g %g (%g %g %g %g) (%g %g %g))\n",
-          (*(vlist->x))(i),(*(vlist->y))(i),(*(vlist->z))(i),
-          (*(vlist->r))(i),(*(vlist->g))(i),(*(vlist->b))(i),(*(vlist->a))(i),
-          (*(vlist->nx))(i),(*(vlist->ny))(i),(*(vlist->nz))(i)
-          ); 
-      break;
-    case P3D_CNVTX:
-      fprintf(OFILE(self), "(%g %g %g () (%g %g %g))\n",
-          (*(vlist->x))(i),(*(vlist->y))(i),(*(vlist->z))(i),
-          (*(vlist->nx))(i),(*(vlist->ny))(i),(*(vlist->nz))(i)
-          );
-      break;
-    case P3D_CVVTX:
-    case P3D_CVVVTX: /* ignore second value */
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
-      fprintf(OFILE(self), "(%g %g %g (%g %g %g %g))\n",
-	  (*(vlist->x))(i),(*(vlist->y))(i),(*(vlist->z))(i),
-	  r, g, b, a
-          ); 
-      break;
-    case P3D_CVNVTX: 
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
-      fprintf(OFILE(self), "(%g %g %g (%g %g %g %g) (%g %g %g))\n",
-	  (*(vlist->x))(i),(*(vlist->y))(i),(*(vlist->z))(i),
-	  r, g, b, a,
-          (*(vlist->nx))(i),(*(vlist->ny))(i),(*(vlist->nz))(i)
-          ); 
-      break;
+  switch (type) {
+  case P3D_CVTX: break;
+  case P3D_CCVTX: color= 1; break;
+  case P3D_CCNVTX: color= normal= 1; break;
+  case P3D_CNVTX: normal= 1; break;
+  case P3D_CVVTX:
+  case P3D_CVVVTX: /* ignore second value */
+    color= mapped= 1;
+    break;
+  case P3D_CVNVTX: color= mapped= normal= 1; break;
+  }
+
+  /* Lines look like "(x y z (r g b a) (nx ny nz))", with "()" in place
+   * of the color if there are normals but no colors.
+   */
+  nf_start(&nf, OFILE(self));
+  for (i=0; i<vcount; i++) {
+    nf_char(&nf,'(');
+    nf_float(&nf,(*(vlist->x))(i));
+    nf_char(&nf,' ');
+    nf_float(&nf,(*(vlist->y))(i));
+    nf_char(&nf,' ');
+    nf_float(&nf,(*(vlist->z))(i));
+    if (color) {
+      if (mapped) map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
+      else {
+	r= (*(vlist->r))(i);
+	g= (*(vlist->g))(i);
+	b= (*(vlist->b))(i);
+	a= (*(vlist->a))(i);
+      }
+      nf_string(&nf," (");
+      nf_float(&nf,r);
+      nf_char(&nf,' ');
+      nf_float(&nf,g);
+      nf_char(&nf,' ');
+      nf_float(&nf,b);
+      nf_char(&nf,' ');
+      nf_float(&nf,a);
+      nf_char(&nf,')');
+    }
+    else if (normal) nf_string(&nf," ()");
+    if (normal) {
+      nf_string(&nf," (");
+      nf_float(&nf,(*(vlist->nx))(i));
+      nf_char(&nf,' ');
+      nf_float(&nf,(*(vlist->ny))(i));
+      nf_char(&nf,' ');
+      nf_float(&nf,(*(vlist->nz))(i));
+      nf_char(&nf,')');
     }
+    nf_string(&nf,")\n");
+  }
+  nf_flush(&nf);
+}
+
+static int bin_vlist_flags( P_Vlist *vlist )
+/* This routine returns the binary vertex block flags for a vertex list */
+{
+  switch (vlist->type) {
+  case P3D_CVTX: return(0);
+  case P3D_CCVTX:
+  case P3D_CVVTX:
+  case P3D_CVVVTX: return(P3DB_VTX_COLOR);
+  case P3D_CNVTX: return(P3DB_VTX_NORMAL);
+  case P3D_CCNVTX:
+  case P3D_CVNVTX: return(P3DB_VTX_COLOR | P3DB_VTX_NORMAL);
+  }
+  return(0);
+}
+
+static double bin_vlist_bytes( P_Vlist *vlist )
+/* This routine returns the size of the binary vertex block for a list */
+{
+  int flags= bin_vlist_flags(vlist);
+  int ncomp= 3;
+
+  if (flags & P3DB_VTX_COLOR) ncomp += 4;
+  if (flags & P3DB_VTX_NORMAL) ncomp += 3;
+  return( 8 + 4.0*ncomp*vlist->length );
+}
+
+static void bin_vlist( P_Renderer *self, P_Vlist *vlist )
+/* This routine outputs a vertex list as a binary vertex block */
+{
+  int i, vcount, flags;
+  float *rgba= (float *)0;
+
+  ger_debug("p3d_ren_mthd: bin_vlist");
+  METHOD_RDY(vlist)
+  vcount= vlist->length;
+  flags= bin_vlist_flags(vlist);
+
+  bin_int(self, vcount);
+  bin_int(self, flags);
+  for (i=0; i<vcount; i++) bin_float(self, (*(vlist->x))(i));
+  for (i=0; i<vcount; i++) bin_float(self, (*(vlist->y))(i));
+  for (i=0; i<vcount; i++) bin_float(self, (*(vlist->z))(i));
+
+  switch (vlist->type) {
+  case P3D_CCVTX:
+  case P3D_CCNVTX:
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->r))(i));
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->g))(i));
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->b))(i));
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->a))(i));
+    break;
+  case P3D_CVVTX:
+  case P3D_CVVVTX: /* ignore second value */
+  case P3D_CVNVTX:
+    /* Map all the values once, then write the color components */
+    if ( !(rgba= (float *)malloc(4*vcount*sizeof(float))) )
+      ger_fatal("p3d_ren_mthd: bin_vlist: unable to allocate %d bytes!",
+		4*vcount*sizeof(float));
+    for (i=0; i<vcount; i++)
+      map_color( self, (*(vlist->v))(i), rgba+i, rgba+vcount+i,
+		 rgba+2*vcount+i, rgba+3*vcount+i );
+    for (i=0; i<4*vcount; i++) bin_float(self, rgba[i]);
+    free( (P_Void_ptr)rgba );
+    break;
+  }
+
+  if (flags & P3DB_VTX_NORMAL) {
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->nx))(i));
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->ny))(i));
+    for (i=0; i<vcount; i++) bin_float(self, (*(vlist->nz))(i));
+  }
 }
 
 static P_Void_ptr def_polymarker(char *name, P_Vlist *vlist)
@@ -509,6 +758,12 @@ static P_Void_ptr def_polymarker(char *name, P_Vlist *vlist)
     ger_debug("p3d_ren_mthd: def_polymarker");
     METHOD_RDY(vlist)
     lclname= get_name(self,name);
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_POLYMARKER, lclname, bin_vlist_bytes(vlist));
+      bin_vlist(self, vlist);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
     switch (vlist->type) {
     case P3D_CVTX:   fprintf(OFILE(self),"(setq %s (pm '(\n", lclname); 
       break;
@@ -545,6 +800,12 @@ static P_Void_ptr def_polyline(char *name, P_Vlist *vlist)
     ger_debug("p3d_ren_mthd: def_polyline");
     METHOD_RDY(vlist)
     lclname= get_name(self,name);
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_POLYLINE, lclname, bin_vlist_bytes(vlist));
+      bin_vlist(self, vlist);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
     switch (vlist->type) {
     case P3D_CVTX:   fprintf(OFILE(self),"(setq %s (pl '(\n", lclname); 
       break;
@@ -581,6 +842,12 @@ static P_Void_ptr def_polygon(char *name, P_Vlist *vlist)
     ger_debug("p3d_ren_mthd: def_polygon");
     METHOD_RDY(vlist)
     lclname= get_name(self,name);
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_POLYGON, lclname, bin_vlist_bytes(vlist));
+      bin_vlist(self, vlist);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
     switch (vlist->type) {
     case P3D_CVTX:   fprintf(OFILE(self),"(setq %s (pg '(\n", lclname); 
       break;
@@ -617,6 +884,12 @@ static P_Void_ptr def_tristrip(char *name, P_Vlist *vlist)
     ger_debug("p3d_ren_mthd: def_tristrip");
     METHOD_RDY(vlist)
     lclname= get_name(self,name);
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_TRISTRIP, lclname, bin_vlist_bytes(vlist));
+      bin_vlist(self, vlist);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
     switch (vlist->type) {
     case P3D_CVTX:   fprintf(OFILE(self),"(setq %s (tri '(\n", lclname); 
       break;
@@ -660,6 +933,12 @@ static P_Void_ptr def_bezier(char *name, P_Vlist *vlist)
       return((P_Void_ptr)0);
     }
     lclname= get_name(self,name);
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_BEZIER, lclname, bin_vlist_bytes(vlist));
+      bin_vlist(self, vlist);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
     switch (vlist->type) {
     case P3D_CVTX:   fprintf(OFILE(self),"(setq %s (bp '(\n", lclname); 
       break;
@@ -692,6 +971,7 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
   P_Renderer *self= (P_Renderer *)po_this;
   char *lclname;
   int ifacet, iindex;
+  Nf_Buffer nf;
   METHOD_IN
 
   if (RENDATA(self)->open) {
@@ -699,6 +979,21 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
     METHOD_RDY(vlist)
     lclname= get_name(self,name);
 
+    if (BINARY(self)) {
+      int nindices= 0;
+      for (ifacet=0; ifacet<nfacets; ifacet++)
+	nindices += facet_lengths[ifacet];
+      bin_record(self, P3DB_TAG_MESH, lclname,
+		 bin_vlist_bytes(vlist) + 8 + 4.0*(nfacets+nindices));
+      bin_vlist(self, vlist);
+      bin_int(self, nfacets);
+      bin_int(self, nindices);
+      bin_ints(self, facet_lengths, nfacets);
+      bin_ints(self, indices, nindices);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
+
     /* Begin definition and emit vertex list */
     switch (vlist->type) {
     case P3D_CVTX:   fprintf(OFILE(self),"(setq %s (msh %d '(\n", 
@@ -725,13 +1020,17 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
     emit_vlist(self, vlist);
 
     /* Close vertex list and emit facet index sublists */
-    fprintf(OFILE(self), ") '( \n");
+    nf_start(&nf, OFILE(self));
+    nf_string(&nf, ") '( \n");
     for (ifacet=0; ifacet<nfacets; ifacet++) {
-      fprintf(OFILE(self), "( \n");
-      for (iindex=0; iindex<facet_lengths[ifacet]; iindex++)
-        fprintf(OFILE(self), "%d\n", *indices++);
-      fprintf(OFILE(self), ") ");
+      nf_string(&nf, "( \n");
+      for (iindex=0; iindex<facet_lengths[ifacet]; iindex++) {
+        nf_int(&nf, *indices++);
+	nf_char(&nf, '\n');
+      }
+      nf_string(&nf, ") ");
     }
+    nf_flush(&nf);
 
     /* Close the whole thing */
     fprintf(OFILE(self), ")))\n");
@@ -754,7 +1053,20 @@ static P_Void_ptr def_text( char *name, char *tstring, P_Point *location,
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: def_text");
     lclname= get_name(self,name);
-    fprintf(OFILE(self),
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_TEXT, lclname, 9*4 + 4 + strlen(tstring));
+      bin_float(self, location->x);
+      bin_float(self, location->y);
+      bin_float(self, location->z);
+      bin_float(self, u->x);
+      bin_float(self, u->y);
+      bin_float(self, u->z);
+      bin_float(self, v->x);
+      bin_float(self, v->y);
+      bin_float(self, v->z);
+      bin_string(self, tstring);
+    }
+    else fprintf(OFILE(self),
             "(setq %s (tx \"%s\" '(%g %g %g)\n '(%g %g %g) '(%g %g %g)))\n",
             lclname, tstring, location->x, location->y, location->z,        
             u->x, u->y, u->z, v->x, v->y, v->z);
@@ -776,7 +1088,16 @@ static P_Void_ptr def_light( char *name, P_Point *location, P_Color *color )
     ger_debug("p3d_ren_mthd: def_light");
     lclname= get_name(self,name);
     rgbify_color(color);
-    fprintf(OFILE(self),
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_LIGHT, lclname, 6*4);
+      bin_float(self, location->x);
+      bin_float(self, location->y);
+      bin_float(self, location->z);
+      bin_float(self, color->r);
+      bin_float(self, color->g);
+      bin_float(self, color->b);
+    }
+    else fprintf(OFILE(self),
             "(setq %s (lt '(%g %g %g) '(%g %g %g)))\n",
             lclname, location->x, location->y, location->z,
             color->r, color->g, color->b);
@@ -798,7 +1119,13 @@ static P_Void_ptr def_ambient( char *name, P_Color *color )
     ger_debug("p3d_ren_mthd: def_ambient");
     lclname= get_name(self,name);
     rgbify_color(color);
-    fprintf(OFILE(self),
+    if (BINARY(self)) {
+      bin_record(self, P3DB_TAG_AMBIENT, lclname, 3*4);
+      bin_float(self, color->r);
+      bin_float(self, color->g);
+      bin_float(self, color->b);
+    }
+    else fprintf(OFILE(self),
             "(setq %s (amb '(%g %g %g)))\n",
             lclname, color->r, color->g, color->b);
     METHOD_OUT
@@ -813,17 +1140,21 @@ static void def_trans(FILE *ofile, P_Transform *trans)
 {
   int i;
   float *val;
+  Nf_Buffer nf;
 
   ger_debug("p3d_ren_mthd: def_trans");
 
-  fprintf(ofile,"(trns '(\n");
+  nf_start(&nf, ofile);
+  nf_string(&nf,"(trns '(\n");
   val= trans->d;
   for (i=0; i<16; i++) {
-    if ( !( i%4 ) ) fprintf(ofile,"(");
-    fprintf(ofile,"%f ",*val++);
-    if ( !( (i+1) % 4 ) ) fprintf(ofile,")\n");
+    if ( !( i%4 ) ) nf_char(&nf,'(');
+    nf_float(&nf,*val++);
+    nf_char(&nf,' ');
+    if ( !( (i+1) % 4 ) ) nf_string(&nf,")\n");
   }
-  fprintf(ofile,"))");
+  nf_string(&nf,"))");
+  nf_flush(&nf);
 }
 
 static void def_attr( FILE *ofile, P_Attrib_List *attr )
@@ -899,6 +1230,115 @@ static void def_attr( FILE *ofile, P_Attrib_List *attr )
   fprintf(ofile,")\n");
 }
 
+static double bin_attr_bytes( P_Attrib_List *attr )
+/* This routine returns the size of the binary form of an attribute list */
+{
+  double nbytes= 4;
+
+  while (attr) {
+    nbytes += 4 + strlen(attr->attribute) + 4;
+    switch (attr->type) {
+    case P3D_INT:
+    case P3D_BOOLEAN:
+    case P3D_FLOAT:
+    case P3D_MATERIAL: nbytes += 4; break;
+    case P3D_STRING: nbytes += 4 + strlen((char *)(attr->value)); break;
+    case P3D_COLOR: nbytes += 4*4; break;
+    case P3D_POINT:
+    case P3D_VECTOR: nbytes += 3*4; break;
+    case P3D_TRANSFORM: nbytes += 16*4; break;
+    case P3D_OTHER: break;
+    }
+    attr= attr->next;
+  }
+  return(nbytes);
+}
+
+static void bin_attr( P_Renderer *self, P_Attrib_List *attr )
+/* This routine emits the binary form of an attribute list */
+{
+  P_Attrib_List *thisattr;
+  P_Color *clr;
+  P_Point *pt;
+  P_Vector *vec;
+  int i, count= 0;
+
+  ger_debug("p3d_ren_mthd: bin_attr");
+
+  for (thisattr= attr; thisattr; thisattr= thisattr->next) count++;
+  bin_int(self, count);
+  while (attr) {
+    bin_string(self, attr->attribute);
+    bin_int(self, attr->type);
+    switch (attr->type) {
+    case P3D_INT:
+    case P3D_BOOLEAN: bin_int(self, *(int *)attr->value); break;
+    case P3D_FLOAT: bin_float(self, *(float *)attr->value); break;
+    case P3D_STRING: bin_string(self, (char *)(attr->value)); break;
+    case P3D_COLOR:
+      clr= (P_Color *)attr->value;
+      rgbify_color(clr);
+      bin_float(self, clr->r);
+      bin_float(self, clr->g);
+      bin_float(self, clr->b);
+      bin_float(self, clr->a);
+      break;
+    case P3D_POINT:
+      pt= (P_Point *)attr->value;
+      bin_float(self, pt->x);
+      bin_float(self, pt->y);
+      bin_float(self, pt->z);
+      break;
+    case P3D_VECTOR:
+      vec= (P_Vector *)attr->value;
+      bin_float(self, vec->x);
+      bin_float(self, vec->y);
+      bin_float(self, vec->z);
+      break;
+    case P3D_TRANSFORM:
+      for (i=0; i<16; i++)
+	bin_float(self, ((P_Transform *)attr->value)->d[i]);
+      break;
+    case P3D_MATERIAL:
+      bin_int(self, ((P_Material *)attr->value)->type);
+      break;
+    case P3D_OTHER:
+      break;
+    }
+    attr= attr->next;
+  }
+}
+
+static void bin_gob( P_Renderer *self, char *lclname, P_Gob *gob )
+/* This routine emits the binary form of a gob definition */
+{
+  P_Gob_List *kids;
+  char *kidname;
+  int i, nkids= 0;
+
+  ger_debug("p3d_ren_mthd: bin_gob");
+
+  /* Children not defined for this renderer are left out */
+  for (kids= gob->children; kids; kids= kids->next) {
+    METHOD_RDY(kids->gob);
+    if ((*(kids->gob->get_ren_data))(self)) nkids++;
+  }
+
+  bin_record(self, P3DB_TAG_GOB, lclname,
+	     4 + 4.0*nkids + 4 + (gob->has_transform ? 16*4 : 0)
+	     + bin_attr_bytes(gob->attr));
+  bin_int(self, nkids);
+  for (kids= gob->children; kids; kids= kids->next) {
+    METHOD_RDY(kids->gob);
+    kidname= (char *)((*(kids->gob->get_ren_data))(self));
+    if (kidname) bin_int(self, name_id(kidname));
+  }
+  bin_int(self, gob->has_transform ? 1 : 0);
+  if (gob->has_transform)
+    for (i=0; i<16; i++) bin_float(self, gob->trans.d[i]);
+  bin_attr(self, gob->attr);
+}
+
 static P_Void_ptr def_gob( char *name, P_Gob *gob )
 /* This method defines a gob */
 {
@@ -910,6 +1350,11 @@ static P_Void_ptr def_gob( char *name, P_Gob *gob )
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: def_gob");
     lclname= get_name(self,name);
+    if (BINARY(self)) {
+      bin_gob(self, lclname, gob);
+      METHOD_OUT
+      return( (P_Void_ptr)lclname );
+    }
     fprintf(OFILE(self),
             "(setq %s (def-gob :children (list ; gob %s\n",lclname,
 	    name ? name : "none");
@@ -947,7 +1392,9 @@ static void hold_gob( P_Void_ptr primdata )
 
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: hold_gob");
-    if (primdata) 
+    if (primdata && BINARY(self))
+      bin_record(self, P3DB_TAG_HOLD, (char *)primdata, 0);
+    else if (primdata) 
       fprintf(OFILE(self),"(hold-gob %s)\n", (char *)primdata);
     else ger_error("p3d_ren_mthd: hold_gob: got a null data pointer.");
   }
@@ -962,7 +1409,9 @@ static void unhold_gob( P_Void_ptr primdata )
 
   if (RENDATA(self)->open) {
     ger_debug("p3d_ren_mthd: unhold_gob");
-    if (primdata) 
+    if (primdata && BINARY(self))
+      bin_record(self, P3DB_TAG_UNHOLD, (char *)primdata, 0);
+    else if (primdata) 
       fprintf(OFILE(self),"(unhold-gob %s)\n", (char *)primdata);
     else ger_error("p3d_ren_mthd: unhold_gob: got a null data pointer.");
   }
@@ -991,9 +1440,39 @@ P_Renderer *po_create_p3d_renderer( char *device, char *datastr )
               sizeof(P_Renderer_data) );
   thisrenderer->object_data= (P_Void_ptr)rdata;
 
+  /* Parse the data string;  "binary" selects the binary format, and
+   * "fsync" makes closing and flushing the file wait for the disk.
+   * Anything else is ignored, as it always has been.
+   */
+  rdata->binary= 0;
+  rdata->sync= 0;
+  rdata->binbuf= (unsigned char *)0;
+  rdata->binfill= 0;
+  if (datastr) {
+    char* thisTok;
+    char* where;
+    char* dupDatastr= strdup(datastr);
+    int firstPass= 1;
+    while ((thisTok= strtok_r( (firstPass ? dupDatastr : NULL)," ,",&where ))) {
+      if (!strcasecmp(thisTok,"binary")
+	  || !strcasecmp(thisTok,"format=binary")) rdata->binary= 1;
+      else if (!strcasecmp(thisTok,"text")
+	       || !strcasecmp(thisTok,"format=text")) rdata->binary= 0;
+      else if (!strcasecmp(thisTok,"fsync")) rdata->sync= 1;
+      else ger_debug("po_create_p3d_renderer: ignoring data string element <%s>",thisTok);
+      firstPass= 0;
+    }
+    free(dupDatastr);
+  }
+  if (rdata->binary
+      && !(rdata->binbuf= (unsigned char *)malloc(BINBUFSIZE)))
+    ger_fatal("po_create_p3d_renderer: unable to allocate %d bytes!",
+	      BINBUFSIZE);
+
   /* output file handling */
   if ( !strcmp(device,"-") ) rdata->outfile= stdout;
-  else if ( !(rdata->outfile= fopen(device,"w")) ) {
+  else if ( !(rdata->outfile= bgw_fopen(device,rdata->binary ? "wb" : "w",
+					rdata->sync)) ) {
     perror("po_create_p3d_renderer");
     ger_fatal("po_create_p3d_renderer: Error opening file <%s> for writing.",
 	      device);
@@ -53,6 +53,7 @@ static ren_table_cell renderer_table[]= {
   {"iv", po_create_iv_renderer},
   {"vrml", po_create_vrml_renderer},
   {"lvr", po_create_lvr_renderer},
+  {"gltf", po_create_gltf_renderer},
   {(char *)0, NULL}         /* add new renderers before this line */
 };
 
@@ -81,6 +81,37 @@ typedef char *P_Void_ptr;
 #define P3D_CVNVTX 5
 #define P3D_CVVVTX 6
 
+/* Vertex components, as indices into the view of a vlist */
+#define P3D_VX 0
+#define P3D_VY 1
+#define P3D_VZ 2
+#define P3D_VNX 3
+#define P3D_VNY 4
+#define P3D_VNZ 5
+#define P3D_VR 6
+#define P3D_VG 7
+#define P3D_VB 8
+#define P3D_VA 9
+#define P3D_VV 10
+#define P3D_VV2 11
+#define P3D_VCOMPONENTS 12
+
+/* Sample types for volume data */
+#define P3D_FLOAT_DATA 0
+#define P3D_UINT8_DATA 1
+#define P3D_UINT16_DATA 2
+#define P3D_INT16_DATA 3
+#define P3D_HALF_DATA 4
+
+/* Gradient cache modes for isosurface normals */
+#define P3D_GRADIENT_NONE 0
+#define P3D_GRADIENT_FLOAT 1
+#define P3D_GRADIENT_OCT16 2
+
+/* Layouts for precomputed irregular grid coordinates */
+#define P3D_COORD_RECTILINEAR 0
+#define P3D_COORD_CURVILINEAR 1
+
 /* Color specification types */
 #define P3D_RGB 0
 
@@ -151,6 +182,9 @@ typedef struct P_Vlist_struct {
   void (*print) ____(( void )); /* print method */
   void (*destroy_self) ____((void)); /* destroy method */
   P_Void_ptr object_data;     /* object data */
+  float *view[P3D_VCOMPONENTS]; /* if non-null, component c of vertex i is
+				   view[c][i*view_stride[c]] */
+  int view_stride[P3D_VCOMPONENTS];
 } P_Vlist;
 
 #ifdef __cplusplus
@@ -211,6 +245,7 @@ extern "C" int pg_polyline( P_Vlist * );
 extern "C" int pg_polygon( P_Vlist * );
 extern "C" int pg_tristrip( P_Vlist * );
 extern "C" int pg_mesh( P_Vlist *, int *, int *, int );
+extern "C" int pg_decimated_mesh( P_Vlist *, int *, int *, int, int, double );
 extern "C" int pg_bezier( P_Vlist * ); /* always 16 */
 extern "C" int pg_text( char *, P_Point *, P_Vector *, P_Vector * );
 extern "C" int pg_light( P_Point *, P_Color * );
@@ -224,12 +259,25 @@ extern "C" int pg_isosurface( int type, float *data, float *valdata,
 		  int nx, int ny, int nz, double value,
 		  P_Point *corner1, P_Point *corner2,
 		  int show_inside, int ftn_order );
+extern "C" int pg_isosurface_typed( int type, int datatype, void *data,
+		  float *valdata, int nx, int ny, int nz, double value,
+		  P_Point *corner1, P_Point *corner2,
+		  int show_inside, int ftn_order );
+extern "C" int pg_gradient_cache( int mode );
+extern "C" int pg_decimation( double fraction, double max_error );
+extern "C" int pg_zsurf_adaptive( double tolerance, double value_tolerance );
 extern "C" int pg_zsurface( int, float *, float *, 
                   int, int, P_Point *, P_Point *, 
                   void (*)(int *, float *, int *, int *), int );
+extern "C" int pg_zsurface_masked( int, float *, float *, 
+                  int, int, P_Point *, P_Point *, int *, int );
 extern "C" int pg_rand_zsurf(P_Vlist *vlist, 
 			   void (*)(int *, float *, float *, float *, int *));
 extern "C" int pg_rand_isosurf(P_Vlist *vlist, double value, int show_inside);
+extern "C" int pg_rand_tess_create( P_Vlist *vlist );
+extern "C" int pg_rand_isosurf_tess( int tess, float *values, double value,
+				    int show_inside );
+extern "C" int pg_rand_tess_destroy( int tess );
 extern "C" int pg_irreg_zsurf( int, float *, float *, int, int,
 			      void (*)(float *, float *, int *, int *),
 			      void (*)(int *, float *, int *, int *),
@@ -239,6 +287,28 @@ extern "C" int pg_irreg_isosurf( int type, float *data, float *valdata,
 				void (*coordfun)(float *, float *, float *,
 						 int *, int *, int *),
 				int show_inside, int ftn_order );
+extern "C" int pg_irreg_zsurf_coords( int, float *, float *, int, int,
+				     int, float *, float *,
+				     void (*)(int *, float *, int *, int *),
+				     int );
+extern "C" int pg_irreg_zsurf_batch( int, float *, float *, int, int,
+				    void (*)(float *, float *, 
+					     int *, int *, int *),
+				    void (*)(int *, float *, int *, int *),
+				    int );
+extern "C" int pg_irreg_isosurf_coords( int type, float *data, 
+				       float *valdata, int nx_in, int ny_in,
+				       int nz_in, double value, int coordtype,
+				       float *xcoords, float *ycoords,
+				       float *zcoords, int show_inside, 
+				       int ftn_order );
+extern "C" int pg_irreg_isosurf_batch( int type, float *data, float *valdata,
+				      int nx_in, int ny_in, int nz_in, 
+				      double value,
+				      void (*batchfun)(float *, float *, 
+						       float *, int *, int *,
+						       int *, int *),
+				      int show_inside, int ftn_order );
 extern "C" int pg_spline_tube( P_Vlist *vlist, int *which_cross, 
 			       int bres, int cres );
 
@@ -251,6 +321,9 @@ extern "C" int pg_camera_background( char *, P_Color * );
 /* Snap */
 extern "C" int pg_snap( char *, char *, char * );
 
+/* Loading saved scenes */
+extern "C" int pg_load_p3d( char * );
+
 /* Color map */
 extern "C" int pg_set_cmap(double, double, void (*)( float *,
 						    float *, float *,
@@ -318,6 +391,7 @@ extern int pg_polyline ___(( P_Vlist * ));
 extern int pg_polygon ___(( P_Vlist * ));
 extern int pg_tristrip ___(( P_Vlist * ));
 extern int pg_mesh ___(( P_Vlist *, int *, int *, int ));
+extern int pg_decimated_mesh ___(( P_Vlist *, int *, int *, int, int, double ));
 extern int pg_bezier ___(( P_Vlist * )); /* always 16 */
 extern int pg_text ___(( char *, P_Point *, P_Vector *, P_Vector * ));
 extern int pg_light ___(( P_Point *, P_Color * ));
@@ -331,13 +405,26 @@ extern int pg_isosurface ___(( int type, float *data, float *valdata,
 		  int nx, int ny, int nz, double value,
 		  P_Point *corner1, P_Point *corner2,
 		  int show_inside, int ftn_order ));
+extern int pg_isosurface_typed ___(( int type, int datatype, P_Void_ptr data,
+		  float *valdata, int nx, int ny, int nz, double value,
+		  P_Point *corner1, P_Point *corner2,
+		  int show_inside, int ftn_order ));
+extern int pg_gradient_cache ___(( int mode ));
+extern int pg_decimation ___(( double fraction, double max_error ));
+extern int pg_zsurf_adaptive ___(( double tolerance, double value_tolerance ));
 extern int pg_zsurface ___(( int, float *, float *, 
                   int, int, P_Point *, P_Point *, 
                   void (*)(int *, float *, int *, int * ), int ));
+extern int pg_zsurface_masked ___(( int, float *, float *, 
+                  int, int, P_Point *, P_Point *, int *, int ));
 extern int pg_rand_zsurf ___(( P_Vlist *vlist, 
 			 void (*)(int *, float *, float *, float *, int *) ));
 extern int pg_rand_isosurf ___((P_Vlist *vlist, double value, 
 				int show_inside));
+extern int pg_rand_tess_create ___(( P_Vlist *vlist ));
+extern int pg_rand_isosurf_tess ___(( int tess, float *values, double value,
+				     int show_inside ));
+extern int pg_rand_tess_destroy ___(( int tess ));
 extern int pg_irreg_zsurf ___(( int, float *, float *, int, int,
 			       void (*)(float *, float *, int *, int *),
 			       void (*)(int *, float *, int *, int *),
@@ -347,6 +434,28 @@ extern int pg_irreg_isosurf ___(( int type, float *data, float *valdata,
 				 void (*coordfun)(float *, float *, float *,
 						  int *, int *, int *),
 				 int show_inside, int ftn_order ));
+extern int pg_irreg_zsurf_coords ___(( int, float *, float *, int, int,
+				      int, float *, float *,
+				      void (*)(int *, float *, int *, int *),
+				      int ));
+extern int pg_irreg_zsurf_batch ___(( int, float *, float *, int, int,
+				     void (*)(float *, float *, 
+					      int *, int *, int *),
+				     void (*)(int *, float *, int *, int *),
+				     int ));
+extern int pg_irreg_isosurf_coords ___(( int type, float *data, 
+					float *valdata, int nx_in, int ny_in,
+					int nz_in, double value, int coordtype,
+					float *xcoords, float *ycoords,
+					float *zcoords, int show_inside, 
+					int ftn_order ));
+extern int pg_irreg_isosurf_batch ___(( int type, float *data, 
+				       float *valdata, int nx_in, int ny_in,
+				       int nz_in, double value,
+				       void (*batchfun)(float *, float *, 
+							float *, int *, int *,
+							int *, int *),
+				       int show_inside, int ftn_order ));
 extern int pg_spline_tube ___(( P_Vlist *vlist, int *which_cross, 
 			       int bres, int cres ));
 
@@ -359,6 +468,9 @@ extern int pg_camera_background ___(( char *, P_Color * ));
 /* Snap */
 extern int pg_snap ___(( char *, char *, char * ));
 
+/* Loading saved scenes */
+extern int pg_load_p3d ___(( char * ));
+
 /* Color map */
 extern int pg_set_cmap ___((double, double, void (*)( float *,
 						float *, float *,
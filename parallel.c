@@ -0,0 +1,136 @@
+/****************************************************************************
+ * parallel.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module provides a minimal fork-join facility for splitting loops
+across processors.  par_for divides a range of items into contiguous
+chunks, one per worker thread, and returns when all the chunks have
+been handled.  The number of workers is taken from the P3D_THREADS
+environment variable if it is set, and otherwise from the number of
+online processors.  Without USE_PTHREADS everything runs serially.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "p3dgen.h"
+#include "ge_error.h"
+#include "parallel.h"
+
+/* Upper limit on the number of worker threads */
+#define MAX_THREADS 64
+
+static int thread_count= 0;
+
+#ifdef USE_PTHREADS
+typedef struct par_job_struct {
+  Par_Range_Fun fun;
+  P_Void_ptr arg;
+  int start;
+  int end;
+  int worker;
+} Par_Job;
+
+static void *par_worker( void *job_ptr )
+/* This is the thread start routine */
+{
+  Par_Job *job= (Par_Job *)job_ptr;
+
+  (*(job->fun))( job->start, job->end, job->worker, job->arg );
+  return( (void *)0 );
+}
+#endif
+
+int par_thread_count( VOIDLIST )
+/* This routine returns the number of workers par_for will use */
+{
+  if (!thread_count) {
+#ifdef USE_PTHREADS
+    char *envstr= getenv("P3D_THREADS");
+    if (envstr) thread_count= atoi(envstr);
+    if (thread_count<1) thread_count= (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_count<1) thread_count= 1;
+    if (thread_count>MAX_THREADS) thread_count= MAX_THREADS;
+#else
+    thread_count= 1;
+#endif
+    ger_debug("parallel: using %d worker threads", thread_count);
+  }
+  return( thread_count );
+}
+
+void par_set_thread_count( int count )
+/* This routine overrides the worker count;  0 restores the default */
+{
+#ifdef USE_PTHREADS
+  if (count>MAX_THREADS) count= MAX_THREADS;
+  thread_count= (count>0) ? count : 0;
+#else
+  thread_count= 1;
+#endif
+}
+
+void par_for( int n, int min_chunk, Par_Range_Fun fun, P_Void_ptr arg )
+/* This routine calls fun on contiguous subranges covering [0,n), in
+ * parallel if threads are available.  No chunk is smaller than 
+ * min_chunk items, so small loops are not split at all.
+ */
+{
+#ifdef USE_PTHREADS
+  pthread_t threads[MAX_THREADS];
+  Par_Job jobs[MAX_THREADS];
+  int started[MAX_THREADS];
+  int nworkers, chunk, i;
+
+  if (n<=0) return;
+  if (min_chunk<1) min_chunk= 1;
+
+  nworkers= par_thread_count();
+  if (nworkers > n/min_chunk) nworkers= n/min_chunk;
+  if (nworkers<=1) {
+    (*fun)( 0, n, 0, arg );
+    return;
+  }
+
+  chunk= (n + nworkers - 1)/nworkers;
+  for (i=0; i<nworkers; i++) {
+    jobs[i].fun= fun;
+    jobs[i].arg= arg;
+    jobs[i].worker= i;
+    jobs[i].start= i*chunk;
+    jobs[i].end= (i+1)*chunk;
+    if (jobs[i].end>n) jobs[i].end= n;
+  }
+
+  /* Worker 0 runs in the calling thread */
+  for (i=1; i<nworkers; i++) {
+    started[i]= !pthread_create( &threads[i], (pthread_attr_t *)0, 
+				 par_worker, (void *)&jobs[i] );
+    if (!started[i]) {
+      ger_error("parallel: par_for: thread creation failed; running serially");
+      par_worker( (void *)&jobs[i] );
+    }
+  }
+  par_worker( (void *)&jobs[0] );
+  for (i=1; i<nworkers; i++)
+    if (started[i]) pthread_join( threads[i], (void **)0 );
+#else
+  if (n>0) (*fun)( 0, n, 0, arg );
+#endif
+}
@@ -0,0 +1,38 @@
+/****************************************************************************
+ * parallel.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the simple thread pool package
+parallel.c .  If USE_PTHREADS is not defined at compile time, all the
+work is done serially in the calling thread.
+*/
+
+#ifndef INCL_PARALLEL_H
+#define INCL_PARALLEL_H
+
+/* A range function handles the items in [start,end).  The worker index
+ * is in [0,par_thread_count()) and can be used to select per-thread
+ * scratch space.
+ */
+typedef void (*Par_Range_Fun)( int start, int end, int worker, 
+			       P_Void_ptr arg );
+
+extern int par_thread_count( void );
+extern void par_set_thread_count( int count );
+extern void par_for( int n, int min_chunk, Par_Range_Fun fun, 
+		     P_Void_ptr arg );
+
+#endif /* INCL_PARALLEL_H */
@@ -191,6 +191,17 @@ extern P_Transform *flip_vec ___(( P_Vector * ));
 extern P_Transform *make_aligning_rotation ___(( P_Vector *, P_Vector * ));
 #endif /* __cplusplus */
 
+/* Vlist view functions, for bulk access to vertex data */
+#ifdef __cplusplus
+extern "C" void po_clear_vlist_view( P_Vlist * );
+extern "C" void po_set_vlist_view( P_Vlist *, int, int, float *, int );
+extern "C" void po_vlist_copy( P_Vlist *, int, int, float *, int );
+#else /* __cplusplus not defined */
+extern void po_clear_vlist_view ___(( P_Vlist * ));
+extern void po_set_vlist_view ___(( P_Vlist *, int, int, float *, int ));
+extern void po_vlist_copy ___(( P_Vlist *, int, int, float *, int ));
+#endif /* __cplusplus */
+
 /* Symbol manipulation functions and macros */
 #ifdef __cplusplus
 extern "C" P_Symbol create_symbol( char * );
@@ -331,6 +342,7 @@ extern "C" P_Renderer *po_create_pvm_renderer( char *, char * );
 extern "C" P_Renderer *po_create_iv_renderer( char *, char * );
 extern "C" P_Renderer *po_create_vrml_renderer( char *, char * );
 extern "C" P_Renderer *po_create_lvr_renderer( char *, char * );
+extern "C" P_Renderer *po_create_gltf_renderer( char *, char * );
 #else
 extern P_Renderer *po_create_p3d_renderer ___(( char *, char * ));
 extern P_Renderer *po_create_painter_renderer ___(( char *, char * ));
@@ -340,6 +352,7 @@ extern P_Renderer *po_create_pvm_renderer ___(( char *, char * ));
 extern P_Renderer *po_create_iv_renderer ___(( char *, char * ));
 extern P_Renderer *po_create_vrml_renderer ___(( char *, char * ));
 extern P_Renderer *po_create_lvr_renderer ___(( char *, char * ));
+extern P_Renderer *po_create_gltf_renderer ___(( char *, char * ));
 #endif /* __cplusplus */
 
 /* List of renderers, and how to walk it */
@@ -396,7 +409,6 @@ typedef struct P_Gob_struct {
   struct P_Gob_List_struct *children;      /* children (possibly null) */
   P_Attrib_List *attr;                     /* attribute list (possibly null) */
   int has_transform;                       /* flag for transform */
-  int geomIndex;                           /* used in vrml renderer  */
   P_Transform trans;                       /* transformation (possibly null) */
   void (*define) ____((P_Renderer *));     /* define self to given renderer */
   void (*render) ____(( P_Transform *, P_Attrib_List * ));  /* render method */
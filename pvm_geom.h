@@ -38,6 +38,38 @@
  *     (with the 12 values giving the first 12 transform matrix elements;
  *      rest are (0,0,0,1)
  *
+ * Compression:  a client may set PVM3D_QUANTIZED in the vertex type of
+ * a type_length_word, in which case the vertex_list_record is instead
+ *
+ * quantized_vlist:    { type_length_word, float x0, float y0, float z0,
+ *                       float dx, float dy, float dz, { int word }* }
+ *     (with one word per vertex of colors if the type has them, each
+ *      r + g<<8 + b<<16 + a<<24 scaled to 0-255;  then if the type has
+ *      normals one 16 bit octahedral normal u + v<<8 per vertex, two to
+ *      a word;  then the coordinates as 16 bit q giving x0+q*dx etc.,
+ *      two to a word.  The low half of each word comes first, and a
+ *      short last word is padded with zero.)
+ *
+ * It may also set PVM3D_COMPRESSED in the type of a mesh record,
+ * replacing the facet lengths and indices by
+ *
+ * coded_indices:      { int word_count, { int word }* }
+ *     (with each vertex_count and then each index coded as a varint
+ *      of 7 bits per byte, low bits first, the indices as the zigzag
+ *      coded difference from the previous index.  Bytes are packed
+ *      four to a word, low byte first.)
+ *
+ * Words are built arithmetically, so they survive byte swapping.
+ *
+ * Geometry caching:  a client may send a vertex list or mesh primitive
+ * once, in a PVM3D_GEOMETRY message, as a PVM3D_GEOM_DEFINE record
+ * giving an id and the untransformed primitive record.  The server
+ * keeps it until it gets a PVM3D_GEOM_FREE record for that id, or the
+ * client disconnects.  Frames then draw it with PVM3D_GEOM_USE records
+ * giving the id and the transform to apply.  Ids are never reused by a
+ * client, and a freed id may still be used by the frame sent before
+ * the free.
+ *
  */
 
 typedef enum {
@@ -47,6 +79,9 @@ typedef enum {
   PVM3D_DISCONNECT, /* message is { int tid, string_record instance } */
   PVM3D_DRAW_AND_RESET, /* message is { string_record instance } */
   PVM3D_DEMO_HACK,  /* demo hacks; to give quick update msgs safe id space */
+  PVM3D_GEOMETRY,   /* message is { string_record instance, */
+                    /*      { pvm3d_submsgtype, submsg }* }, with only */
+                    /*      GEOM_DEFINE, GEOM_FREE and ENDFRAME records */
   PVM3D_LAST } pvm3d_msgtype;
 
 typedef enum {
@@ -76,5 +111,15 @@ typedef enum {
                     /*                 float bg_r, float bg_g, float bg_b,   */
                     /*                 float bg_a } */
   PVM3D_ENDFRAME,   /* msg record is {} */
+  PVM3D_STRIP_MESH, /* msg record is { mesh_record }, with each vertex */
+                    /*   count giving the length of a triangle strip */
+  PVM3D_GEOM_DEFINE,/* msg record is { int geom_id, pvm3d_submsgtype, */
+                    /*   submsg }, the submsg being a vertex list or */
+                    /*   mesh primitive */
+  PVM3D_GEOM_USE,   /* msg record is { int geom_id, transform_record } */
+  PVM3D_GEOM_FREE,  /* msg record is { int geom_id } */
   PVM3D_SM_LAST } pvm3d_submsgtype;
 
+#define PVM3D_QUANTIZED 0x80   /* or'ed into a vertex type */
+#define PVM3D_COMPRESSED 0x100 /* or'ed into a mesh record type */
+
@@ -17,46 +17,55 @@
 /* This module implements the PVM-mediated distributed renderer */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include <math.h>
-#include <pvm3.h>
-#ifdef CRAY
-#include <time.h>
-#endif
 #include "ge_error.h"
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "assist.h"
+#include "xport.h"
 #include "pvm_ren_mthd.h"
+#include "stripify.h"
 #include "pvm_geom.h"
 
 /* Notes:
-   -We never actually quit PVM, on the assumption that the calling 
-    program will do so.
+   -Messages go to the render server through the transport named by
+    the data string, "pvm", "shm" or "socket", optionally followed by
+    '=' and an address;  see xport.h.  The pvm_geom.h record protocol
+    is the same whichever transport carries it.
+   -With geometry caching, each vertex list or mesh goes to the server
+    once, in a PVM3D_GEOMETRY message sent just before the first frame
+    which draws it;  frames then carry only its id and transform.  The
+    data string option ",cache" or ",nocache" turns this on or off.
+   -The option ",quantize" sends vertex lists quantized to 16 bit
+    coordinates, 16 bit normals and 8 bit colors, and mesh indices as
+    varints.  ",tolerance=t" also quantizes, but sends any vertex list
+    whose quantized coordinates could be more than t off as floats.
+   -The option ",strip" sends meshes which strip_mesh() can rebuild as
+    triangle strips as PVM3D_STRIP_MESH records.  Servers older than
+    that record type do not understand it, so it is off by default.
  */
 
 /* Instance counter */
 static int instance_count= 0;
 
-/* Space for transformation buffer */
-static float* transform_buf= NULL;
-
 /* Space for default color map */
 static P_Renderer_Cmap default_map;
 
+/* Scratch space for compressing vertex lists and indices */
+static float *quant_buf= NULL;
+static int quant_buf_floats= 0;
+static unsigned int *code_buf= NULL;
+static int code_buf_words= 0;
+
 /* Most recent instance of this renderer to call ren_gob at top level 
  * while open
  */
 static P_Renderer* most_recent_self= NULL;
 
-/* Most recently sent outgoing PVM message info, for debugging use */
-static int most_recent_send_buf= 0;
-int pg_pvm_most_recent_renserver_tid= 0;
-
 void pg_pvm_ren_retransmit(); /* backdoor useful in debugging */
-#ifdef CRAY
-long pg_pvm_sync_clocks= 0; /* counter for total time spent in sync wait */
-#endif
 
 
 /* default color map function */
@@ -162,8 +171,7 @@ static void pack_camera( P_Renderer* self )
 
     ger_debug("pvm_ren_mthd: pack_camera");
     
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: pack_camera: error in pvm_pkint");
+    PACK_INT(self, msgbuf, 1);
     
     buf[0]= CURRENT_CAMERA(self)->lookfrom.x;
     buf[1]= CURRENT_CAMERA(self)->lookfrom.y;
@@ -184,8 +192,7 @@ static void pack_camera( P_Renderer* self )
     buf[14]= bkg.b;
     buf[15]= bkg.a;
       
-    if (pvm_pkfloat(buf, 16, 1)<0)
-      pvm_perror("pvm_ren_mthd: pack_camera: error in pvm_pkfloat");
+    PACK_FLOAT(self, buf, 16);
   }
 }
 
@@ -265,8 +272,7 @@ static void check_attrs( P_Renderer* self )
   if (do_backcull) {
     static int msgbuf[2]= { PVM3D_BACKCULL, 0 };
     msgbuf[1]= CURRENT_BACKCULL(self)= backcull_val;
-    if (pvm_pkint(msgbuf,2,1) < 0)
-      pvm_perror("pvm_ren_mthd: check_attrs: error in pvm_pkint 1");
+    PACK_INT(self, msgbuf, 2);
   }
 	       
   if (do_color) {
@@ -276,17 +282,14 @@ static void check_attrs( P_Renderer* self )
     fbuf[1]= CURRENT_COLOR(self).g= color_val->g;
     fbuf[2]= CURRENT_COLOR(self).b= color_val->b;
     fbuf[3]= CURRENT_COLOR(self).a= color_val->a;
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: check_attrs: error in pvm_pkint 1");
-    if (pvm_pkfloat(fbuf,4,1) < 0)
-      pvm_perror("pvm_ren_mthd: check_attrs: error in pvm_pkfloat 1");
+    PACK_INT(self, msgbuf, 1);
+    PACK_FLOAT(self, fbuf, 4);
   }
 	       
   if (do_material) {
     static int msgbuf[2]= { PVM3D_MATERIAL, 0 };
     msgbuf[1]= CURRENT_MATERIAL(self).type= mat_val.type;
-    if (pvm_pkint(msgbuf,2,1) < 0)
-      pvm_perror("pvm_ren_mthd: check_attrs: error in pvm_pkint 2");
+    PACK_INT(self, msgbuf, 2);
   }
 	       
   if (do_text_height) {
@@ -294,10 +297,8 @@ static void check_attrs( P_Renderer* self )
     static float fbuf[1];
     msgbuf[0]= PVM3D_TEXT_HEIGHT;
     fbuf[0]= CURRENT_TEXT_HEIGHT(self)= txt_ht_val;
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: check_attrs: error in pvm_pkint 3");
-    if (pvm_pkfloat(fbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: check_attrs: error in pvm_pkfloat 2");
+    PACK_INT(self, msgbuf, 1);
+    PACK_FLOAT(self, fbuf, 1);
   }
 	       
   ATTRS_SET(self)= 1;
@@ -327,17 +328,15 @@ static void ren_sphere(P_Void_ptr object_data, P_Transform *transform,
   P_Renderer *self= (P_Renderer*)po_this;
   METHOD_IN;
 
-  if (RENDATA(self)->open) {
+  if (RENDATA(self)->open && !DEFINING(self)) {
     static int msgbuf[1]= {PVM3D_SPHERE};
     P_Transform* current_trans;
     ger_debug("pvm_ren_mthd: ren_sphere");
     check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_sphere: error in pvm_pkint");
+    PACK_INT(self, msgbuf, 1);
     METHOD_RDY(ASSIST(self));
     current_trans= (*(ASSIST(self)->get_trans))();
-    if (pvm_pkfloat(current_trans->d, 12, 1)<0)
-      pvm_perror("pvm_ren_mthd: ren_sphere: error in pvm_pkfloat");
+    PACK_FLOAT(self, current_trans->d, 12);
   }
 
   METHOD_OUT;
@@ -380,17 +379,15 @@ static void ren_cylinder(P_Void_ptr object_data, P_Transform *transform,
   P_Renderer *self= (P_Renderer*)po_this;
   METHOD_IN;
 
-  if (RENDATA(self)->open) {
+  if (RENDATA(self)->open && !DEFINING(self)) {
     static int msgbuf[1]= {PVM3D_CYLINDER};
     P_Transform* current_trans;
     ger_debug("pvm_ren_mthd: ren_cylinder");
     check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_sphere: error in pvm_pkint");
+    PACK_INT(self, msgbuf, 1);
     METHOD_RDY(ASSIST(self));
     current_trans= (*(ASSIST(self)->get_trans))();
-    if (pvm_pkfloat(current_trans->d, 12, 1)<0)
-      pvm_perror("pvm_ren_mthd: ren_cylinder: error in pvm_pkfloat");
+    PACK_FLOAT(self, current_trans->d, 12);
   }
 
   METHOD_OUT;
@@ -440,19 +437,16 @@ static void ren_torus(P_Void_ptr object_data, P_Transform *transform,
   P_Renderer *self= (P_Renderer*)po_this;
   METHOD_IN;
 
-  if (RENDATA(self)->open) {
+  if (RENDATA(self)->open && !DEFINING(self)) {
     static int msgbuf[1]= {PVM3D_TORUS};
     P_Transform* current_trans;
     ger_debug("pvm_ren_mthd: ren_torus");
     check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_torus: error in pvm_pkint");
-    if (pvm_pkfloat((float*)object_data,2,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_torus: error in pvm_pkfloat");
+    PACK_INT(self, msgbuf, 1);
+    PACK_FLOAT(self, (float*)object_data, 2);
     METHOD_RDY(ASSIST(self));
     current_trans= (*(ASSIST(self)->get_trans))();
-    if (pvm_pkfloat(current_trans->d, 12, 1)<0)
-      pvm_perror("pvm_ren_mthd: ren_torus: error in pvm_pkfloat");
+    PACK_FLOAT(self, current_trans->d, 12);
   }
 
   METHOD_OUT;
@@ -484,6 +478,17 @@ static void map_color( P_Renderer *self, float val,
   (*MAP_FUN(self))( &val, r, g, b, a );
 }
 
+static void count_undefined( P_Renderer *self, P_Cached_Vlist *cache )
+/* This routine counts geometry the server has not cached, so that the
+ * next definition pass sends it;  each is counted once per pass.
+ */
+{
+  if (GEOM_CACHE(self) && cache->counted_pass != DEFINE_PASS(self)) {
+    cache->counted_pass= DEFINE_PASS(self);
+    UNDEFINED_GEOMS(self)++;
+  }
+}
+
 static P_Cached_Vlist* cache_vlist( P_Renderer *self, P_Vlist *vlist )
 /* This routine outputs a vertex list */
 {
@@ -567,99 +572,240 @@ static P_Cached_Vlist* cache_vlist( P_Renderer *self, P_Vlist *vlist )
 
   result->info_word= ((result->length) << 8) | (result->type & 255);
 
-  for (i=0; i<result->length; i++) {
-    result->coords[3*i]= (*(vlist->x))(i);
-    result->coords[3*i+1]= (*(vlist->y))(i);
-    result->coords[3*i+2]= (*(vlist->z))(i);
-    switch (vlist->type) {
-    case P3D_CVTX:
-      break;
-    case P3D_CNVTX:
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CCVTX:
-      result->colors[3*i]= (*(vlist->r))(i);
-      result->colors[3*i+1]= (*(vlist->g))(i);
-      result->colors[3*i+2]= (*(vlist->b))(i);
-      result->opacities[i]= (*(vlist->a))(i);
-      break;
-    case P3D_CCNVTX:
-      result->colors[3*i]= (*(vlist->r))(i);
-      result->colors[3*i+1]= (*(vlist->g))(i);
-      result->colors[3*i+2]= (*(vlist->b))(i);
-      result->opacities[i]= (*(vlist->a))(i);
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CVVTX:
-    case P3D_CVVVTX:
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
-      result->colors[3*i]= r;
-      result->colors[3*i+1]= g;
-      result->colors[3*i+2]= b;
-      result->opacities[i]= a;
-      break;
-    case P3D_CVNVTX:
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
+  result->geom_id= NEXT_GEOM_ID(self)++;
+  result->defined= 0;
+  result->counted_pass= -1;
+  count_undefined(self, result);
+
+  po_vlist_copy(vlist, P3D_VX, 3, result->coords, 3);
+  switch (vlist->type) {
+  case P3D_CVTX:
+    break;
+  case P3D_CNVTX:
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CCVTX:
+    po_vlist_copy(vlist, P3D_VR, 3, result->colors, 3);
+    po_vlist_copy(vlist, P3D_VA, 1, result->opacities, 1);
+    break;
+  case P3D_CCNVTX:
+    po_vlist_copy(vlist, P3D_VR, 3, result->colors, 3);
+    po_vlist_copy(vlist, P3D_VA, 1, result->opacities, 1);
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CVVTX:
+  case P3D_CVVVTX:
+  case P3D_CVNVTX:
+    /* The values are mapped in place in the opacities */
+    po_vlist_copy(vlist, P3D_VV, 1, result->opacities, 1);
+    for (i=0; i<result->length; i++) {
+      map_color( self, result->opacities[i], &r, &g, &b, &a );
       result->colors[3*i]= r;
       result->colors[3*i+1]= g;
       result->colors[3*i+2]= b;
       result->opacities[i]= a;
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-      /* We've already checked that it is a known case */
     }
+    if (vlist->type==P3D_CVNVTX)
+      po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+    /* We've already checked that it is a known case */
   }
 
   return( result );
 }
 
-static void pack_cached_vlist( P_Renderer* self, P_Cached_Vlist* cache )
+static int identity_trans( P_Transform* trans )
+{
+  int i;
+
+  for (i=0; i<16; i++)
+    if (trans->d[i] != Identity_trans->d[i]) return 0;
+  return 1;
+}
+
+static float *quant_space( int nfloats )
+{
+  if (nfloats > quant_buf_floats) {
+    quant_buf_floats= nfloats;
+    if ( !(quant_buf= (float*)realloc(quant_buf, nfloats*sizeof(float))) )
+      ger_fatal("pvm_ren_mthd: unable to allocate %d floats!", nfloats);
+  }
+  return quant_buf;
+}
+
+static unsigned int *code_space( int nwords )
+/* This routine returns nwords of scratch space, cleared */
+{
+  if (nwords > code_buf_words) {
+    code_buf_words= nwords;
+    if ( !(code_buf= (unsigned int*)realloc(code_buf, 
+					     nwords*sizeof(unsigned int))) )
+      ger_fatal("pvm_ren_mthd: unable to allocate %d words!", nwords);
+  }
+  memset(code_buf, 0, nwords*sizeof(unsigned int));
+  return code_buf;
+}
+
+static unsigned int quantize( float val, float lo, float hi, int max )
+/* This routine maps val from the range lo to hi onto 0 to max */
+{
+  if (hi <= lo) return 0;
+  val= (val-lo)/(hi-lo);
+  if (val <= 0.0) return 0;
+  if (val >= 1.0) return max;
+  return (unsigned int)(val*max + 0.5);
+}
+
+static unsigned int oct_normal( float *n )
+/* This routine packs a normal into 16 bits as an octahedral map */
+{
+  float x= n[0], y= n[1], z= n[2];
+  float l1= fabs(x) + fabs(y) + fabs(z);
+  float tx;
+
+  if (l1 == 0.0) return quantize(0.0,-1.0,1.0,255) 
+		   | (quantize(0.0,-1.0,1.0,255) << 8);
+  x /= l1;
+  y /= l1;
+  z /= l1;
+  if (z < 0.0) {
+    tx= (1.0 - fabs(y)) * ((x >= 0.0) ? 1.0 : -1.0);
+    y= (1.0 - fabs(x)) * ((y >= 0.0) ? 1.0 : -1.0);
+    x= tx;
+  }
+  return quantize(x,-1.0,1.0,255) | (quantize(y,-1.0,1.0,255) << 8);
+}
+
+static int pack_quantized_vlist( P_Renderer* self, P_Cached_Vlist* cache,
+				 P_Transform* trans )
+/* This routine packs a quantized_vlist record, returning 0 without
+ * packing anything if the quantized coordinates could be further than
+ * the tolerance from the true ones.
+ */
+{
+  int n= cache->length;
+  float *coords= cache->coords;
+  float *normals= cache->normals;
+  float *d= trans->d;
+  float frame[6];
+  float lo[3], hi[3];
+  unsigned int *words, *runner;
+  int nwords, info, i, j;
+
+  /* Transform first, since the bounding box is of the result */
+  if (!identity_trans(trans)) {
+    coords= quant_space( normals ? 6*n : 3*n );
+    for (i=0; i<n; i++) {
+      float *c= cache->coords + 3*i;
+      for (j=0; j<3; j++)
+	coords[3*i+j]= d[4*j]*c[0] + d[4*j+1]*c[1] + d[4*j+2]*c[2] + d[4*j+3];
+    }
+    if (normals) {
+      normals= coords + 3*n;
+      for (i=0; i<n; i++) {
+	float *c= cache->normals + 3*i;
+	for (j=0; j<3; j++)
+	  normals[3*i+j]= d[j]*c[0] + d[j+4]*c[1] + d[j+8]*c[2];
+      }
+    }
+  }
+
+  for (j=0; j<3; j++) lo[j]= hi[j]= (n ? coords[j] : 0.0);
+  for (i=1; i<n; i++)
+    for (j=0; j<3; j++) {
+      if (coords[3*i+j] < lo[j]) lo[j]= coords[3*i+j];
+      if (coords[3*i+j] > hi[j]) hi[j]= coords[3*i+j];
+    }
+  for (j=0; j<3; j++) {
+    frame[j]= lo[j];
+    frame[j+3]= (hi[j]-lo[j])/65535.0;
+    if (TOLERANCE(self) > 0.0 && 0.5*frame[j+3] > TOLERANCE(self)) return 0;
+  }
+
+  nwords= (cache->colors ? n : 0) + (normals ? (n+1)/2 : 0) + (3*n+1)/2;
+  runner= words= code_space(nwords);
+  if (cache->colors) {
+    for (i=0; i<n; i++)
+      *runner++= quantize(cache->colors[3*i], 0.0, 1.0, 255)
+	| (quantize(cache->colors[3*i+1], 0.0, 1.0, 255) << 8)
+	| (quantize(cache->colors[3*i+2], 0.0, 1.0, 255) << 16)
+	| (quantize(cache->opacities[i], 0.0, 1.0, 255) << 24);
+  }
+  if (normals) {
+    for (i=0; i<n; i++) runner[i>>1] |= oct_normal(normals+3*i) << 16*(i&1);
+    runner += (n+1)/2;
+  }
+  for (i=0; i<3*n; i++)
+    runner[i>>1] |= quantize(coords[i], lo[i%3], hi[i%3], 65535) << 16*(i&1);
+
+  info= (n << 8) | ((cache->type | PVM3D_QUANTIZED) & 255);
+  PACK_INT(self, &info, 1);
+  PACK_FLOAT(self, frame, 6);
+  PACK_INT(self, (int*)words, nwords);
+  return 1;
+}
+
+static void pack_coded_indices( P_Renderer* self, int *lengths, int nfacets,
+				int *indices, int nindices )
+/* This routine packs a coded_indices record */
+{
+  unsigned int *words= code_space( (5*(nfacets+nindices) + 3)/4 + 1 );
+  unsigned int val;
+  int nbytes= 0;
+  int i, prev= 0;
+  int nwords;
+
+  for (i=0; i<nfacets+nindices; i++) {
+    if (i<nfacets) val= lengths[i];
+    else {
+      val= indices[i-nfacets] - prev;
+      val= (val << 1) ^ ((indices[i-nfacets] < prev) ? ~0U : 0U); /* zigzag */
+      prev= indices[i-nfacets];
+    }
+    do {
+      words[nbytes>>2] |= ((val & 127) | ((val > 127) ? 128 : 0)) 
+	<< 8*(nbytes&3);
+      nbytes++;
+      val >>= 7;
+    } while (val);
+  }
+
+  nwords= (nbytes+3)/4;
+  PACK_INT(self, &nwords, 1);
+  PACK_INT(self, (int*)words, nwords);
+}
+
+static void pack_cached_vlist( P_Renderer* self, P_Cached_Vlist* cache,
+			       P_Transform* current_trans )
 {
   int coords_sent, coords_this_block;
-  P_Transform* current_trans;
   int identity_trans_flag;
-  float i;
+  int i;
   float *runner;
   float *trunner;
 
-  current_trans= (*(ASSIST(self)->get_trans))();
+  if (QUANTIZE(self) && pack_quantized_vlist(self, cache, current_trans))
+    return;
 
-  if (pvm_pkint(&(cache->info_word),1,1) < 0)
-    pvm_perror("pvm_ren_mthd: pack_cached_vlist: error in pvm_pkint");
+  PACK_INT(self, &(cache->info_word), 1);
 
   /* Send colors, then normals, then coords, for convenience of display
    * server.
    */
   if (cache->colors) {
-    if (pvm_pkfloat( cache->colors, 3*cache->length, 1) < 0)
-      pvm_perror("pvm_ren_mthd: pack_cached_vlist: error in pvm_pkfloat 1");
-    if (pvm_pkfloat( cache->opacities, cache->length, 1) < 0)
-      pvm_perror("pvm_ren_mthd: pack_cached_vlist: error in pvm_pkfloat 2");
-  }
-
-  identity_trans_flag= 1;
-  runner= current_trans->d;
-  trunner= Identity_trans->d;
-  for (i=0; i<16; i++) 
-    if (*runner++ != *trunner++) {
-      identity_trans_flag= 0;
-      break;
-    }
+    PACK_FLOAT(self, cache->colors, 3*cache->length);
+    PACK_FLOAT(self, cache->opacities, cache->length);
+  }
+
+  identity_trans_flag= identity_trans(current_trans);
   if (identity_trans_flag) {
     if (cache->normals) {
-      if (pvm_pkfloat( cache->normals, 3*cache->length, 1) < 0)
-      pvm_perror("pvm_ren_mthd: pack_cached_vlist: error in pvm_pkfloat 3");
+      PACK_FLOAT(self, cache->normals, 3*cache->length);
     }
-    if (pvm_pkfloat( cache->coords, 3*cache->length, 1) < 0)
-      pvm_perror("pvm_ren_mthd: pack_cached_vlist: error in pvm_pkfloat 4");
+    PACK_FLOAT(self, cache->coords, 3*cache->length);
   }
   else {
+    /* Transform in blocks, straight into space the transport reserves */
     if (cache->normals) {
       coords_sent= 0;
       runner= cache->normals;
@@ -667,7 +813,7 @@ static void pack_cached_vlist( P_Renderer* self, P_Cached_Vlist* cache )
 	coords_this_block= 
 	  (TRANSFORM_BUF_TRIPLES > (cache->length - coords_sent)) ?
 	  cache->length - coords_sent : TRANSFORM_BUF_TRIPLES;
-	trunner= transform_buf;
+	trunner= (*(XPORT(self)->reserve))(XPORT(self), 3*coords_this_block);
 	for (i=0; i<coords_this_block; i++) {
 	  *trunner++= 
 	    (current_trans->d[0] * *runner) + (current_trans->d[4] * 
@@ -683,9 +829,7 @@ static void pack_cached_vlist( P_Renderer* self, P_Cached_Vlist* cache )
 	    + (current_trans->d[10] * *(runner+2));  
 	  runner += 3;
 	}
-	if (pvm_pkfloat( transform_buf, 3*coords_this_block, 1) < 0)
-	  pvm_perror(
-		 "pvm_ren_mthd: pack_cached_vlist: error in pvm_pkfloat 5");
+	(*(XPORT(self)->commit))(XPORT(self), 3*coords_this_block);
 	coords_sent += coords_this_block;
       }
     }
@@ -696,7 +840,7 @@ static void pack_cached_vlist( P_Renderer* self, P_Cached_Vlist* cache )
       coords_this_block= 
 	(TRANSFORM_BUF_TRIPLES > (cache->length - coords_sent)) ?
 	cache->length - coords_sent : TRANSFORM_BUF_TRIPLES;
-      trunner= transform_buf;
+      trunner= (*(XPORT(self)->reserve))(XPORT(self), 3*coords_this_block);
       for (i=0; i<coords_this_block; i++) {
 	*trunner++= 
 	  (current_trans->d[0] * *runner) + (current_trans->d[1] * *(runner+1))
@@ -709,13 +853,75 @@ static void pack_cached_vlist( P_Renderer* self, P_Cached_Vlist* cache )
 	  + (current_trans->d[10] * *(runner+2)) + (current_trans->d[11]);  
 	runner += 3;
       }
-      if (pvm_pkfloat( transform_buf, 3*coords_this_block, 1) < 0)
-	pvm_perror("pvm_ren_mthd: pack_cached_vlist: error in pvm_pkfloat 6");
+      (*(XPORT(self)->commit))(XPORT(self), 3*coords_this_block);
       coords_sent += coords_this_block;
     }
   }
 }
 
+static void open_geometry_msg( P_Renderer* self )
+/* This routine begins a PVM3D_GEOMETRY message, if one is not begun */
+{
+  int strlenbuf;
+
+  if (!GEOM_MSG_OPEN(self)) {
+    (*(XPORT(self)->begin))(XPORT(self), PVM3D_GEOMETRY);
+    strlenbuf= strlen(NAME(self));
+    PACK_INT(self, &strlenbuf, 1);
+    PACK_STR(self, NAME(self));
+    GEOM_MSG_OPEN(self)= 1;
+  }
+}
+
+static void pack_geom_define( P_Renderer* self, P_Cached_Vlist* cache,
+			      int type )
+/* This routine starts the definition of some geometry, which the
+ * caller then packs untransformed.
+ */
+{
+  int msgbuf[3];
+
+  open_geometry_msg(self);
+  msgbuf[0]= PVM3D_GEOM_DEFINE;
+  msgbuf[1]= cache->geom_id;
+  msgbuf[2]= type;
+  PACK_INT(self, msgbuf, 3);
+  cache->defined= 1;
+  if (cache->counted_pass == DEFINE_PASS(self)) UNDEFINED_GEOMS(self)--;
+}
+
+static void pack_geom_use( P_Renderer* self, P_Cached_Vlist* cache )
+/* This routine draws cached geometry with the current transform */
+{
+  int msgbuf[2];
+
+  msgbuf[0]= PVM3D_GEOM_USE;
+  msgbuf[1]= cache->geom_id;
+  PACK_INT(self, msgbuf, 2);
+  METHOD_RDY(ASSIST(self));
+  PACK_FLOAT(self, (*(ASSIST(self)->get_trans))()->d, 12);
+}
+
+static void forget_geometry( P_Renderer* self, P_Cached_Vlist* cache )
+/* This routine notes that geometry is being destroyed, so that the
+ * server can be told to drop its copy.
+ */
+{
+  if (cache->defined) {
+    if (N_FREED_GEOMS(self) == FREED_GEOMS_SPACE(self)) {
+      FREED_GEOMS_SPACE(self)= 2*FREED_GEOMS_SPACE(self) + 16;
+      if ( !(FREED_GEOMS(self)= 
+	     (int*)realloc(FREED_GEOMS(self), 
+			   FREED_GEOMS_SPACE(self)*sizeof(int))) )
+	ger_fatal("pvm_ren_mthd: forget_geometry: unable to allocate %d ints!",
+		  FREED_GEOMS_SPACE(self));
+    }
+    FREED_GEOMS(self)[N_FREED_GEOMS(self)++]= cache->geom_id;
+  }
+  else if (GEOM_CACHE(self) && cache->counted_pass == DEFINE_PASS(self))
+    UNDEFINED_GEOMS(self)--;
+}
+
 static void free_cached_vlist( P_Cached_Vlist* cache )
 {
   if (cache->normals) free( (P_Void_ptr)(cache->normals) );
@@ -750,13 +956,38 @@ static void destroy_polything( P_Void_ptr object_data )
 
   if (RENDATA(self)->open) {
     ger_debug("pvm_ren_mthd: destroy_polything");
+    forget_geometry( self, (P_Cached_Vlist*)object_data );
     free_cached_vlist( (P_Cached_Vlist*)object_data );
-    free( object_data );
   }
 
   METHOD_OUT;
 }
 
+static void ren_polything( P_Renderer* self, int type, 
+			   P_Cached_Vlist* cache )
+/* This routine does the work for all the vertex list primitives */
+{
+  static int msgbuf[1];
+
+  if (DEFINING(self)) {
+    if (GEOM_CACHE(self) && !cache->defined) {
+      pack_geom_define(self, cache, type);
+      pack_cached_vlist(self, cache, Identity_trans);
+    }
+    return;
+  }
+
+  check_attrs(self);
+  if (cache->defined) pack_geom_use(self, cache);
+  else {
+    count_undefined(self, cache);
+    msgbuf[0]= type;
+    PACK_INT(self, msgbuf, 1);
+    METHOD_RDY(ASSIST(self));
+    pack_cached_vlist(self, cache, (*(ASSIST(self)->get_trans))());
+  }
+}
+
 static void ren_polymarker(P_Void_ptr object_data, P_Transform *transform,
 			   P_Attrib_List *attrs)
 {
@@ -767,12 +998,8 @@ static void ren_polymarker(P_Void_ptr object_data, P_Transform *transform,
   METHOD_IN;
 
   if (RENDATA(self)->open) {
-    static int msgbuf[1]= {PVM3D_POLYMARKER};
     ger_debug("pvm_ren_mthd: ren_polymarker");
-    check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_polymarker: error in pvm_pkint");
-    pack_cached_vlist( self, (P_Cached_Vlist*)object_data );
+    ren_polything( self, PVM3D_POLYMARKER, (P_Cached_Vlist*)object_data );
   }
 
   METHOD_OUT;
@@ -788,12 +1015,8 @@ static void ren_polyline(P_Void_ptr object_data, P_Transform *transform,
   METHOD_IN;
 
   if (RENDATA(self)->open) {
-    static int msgbuf[1]= {PVM3D_POLYLINE};
     ger_debug("pvm_ren_mthd: ren_polyline");
-    check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_polyline: error in pvm_pkint");
-    pack_cached_vlist( self, (P_Cached_Vlist*)object_data );
+    ren_polything( self, PVM3D_POLYLINE, (P_Cached_Vlist*)object_data );
   }
 
   METHOD_OUT;
@@ -809,12 +1032,8 @@ static void ren_polygon(P_Void_ptr object_data, P_Transform *transform,
   METHOD_IN;
 
   if (RENDATA(self)->open) {
-    static int msgbuf[1]= {PVM3D_POLYGON};
     ger_debug("pvm_ren_mthd: ren_polygon");
-    check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_polygon: error in pvm_pkint");
-    pack_cached_vlist( self, (P_Cached_Vlist*)object_data );
+    ren_polything( self, PVM3D_POLYGON, (P_Cached_Vlist*)object_data );
   }
 
   METHOD_OUT;
@@ -830,12 +1049,8 @@ static void ren_tristrip(P_Void_ptr object_data, P_Transform *transform,
   METHOD_IN;
 
   if (RENDATA(self)->open) {
-    static int msgbuf[1]= {PVM3D_TRISTRIP};
     ger_debug("pvm_ren_mthd: ren_tristrip");
-    check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_tristrip: error in pvm_pkint");
-    pack_cached_vlist( self, (P_Cached_Vlist*)object_data );
+    ren_polything( self, PVM3D_TRISTRIP, (P_Cached_Vlist*)object_data );
   }
 
   METHOD_OUT;
@@ -851,12 +1066,8 @@ static void ren_bezier(P_Void_ptr object_data, P_Transform *transform,
   METHOD_IN;
 
   if (RENDATA(self)->open) {
-    static int msgbuf[1]= {PVM3D_BEZIER};
     ger_debug("pvm_ren_mthd: ren_bezier");
-    check_attrs(self);
-    if (pvm_pkint(msgbuf,1,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_bezier: error in pvm_pkint");
-    pack_cached_vlist( self, (P_Cached_Vlist*)object_data );
+    ren_polything( self, PVM3D_BEZIER, (P_Cached_Vlist*)object_data );
   }
 
   METHOD_OUT;
@@ -880,6 +1091,23 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
 	      sizeof(P_Cached_Mesh));
       exit(-1);
     }
+
+    /* Send triangle strips rather than triangles if we can */
+    if (STRIP(self)
+	&& (result->nfacets= strip_mesh(indices, facet_lengths, nfacets,
+					&(result->indices),
+					&(result->facet_lengths))) != 0) {
+      result->stripped= 1;
+      result->nindices= 0;
+      for (ifacet=0; ifacet<result->nfacets; ifacet++)
+	result->nindices += result->facet_lengths[ifacet];
+      METHOD_RDY(vlist)
+      result->cached_vlist= cache_vlist(self,vlist);
+      METHOD_OUT
+      return( (P_Void_ptr)result );
+    }
+    result->stripped= 0;
+
     if ( !(result->facet_lengths=(int*)malloc(nfacets*sizeof(int))) ) {
       fprintf(stderr,"pvm_ren_mthd: def_mesh: unable to allocate %d bytes!\n",
 	      nfacets*sizeof(int));
@@ -912,6 +1140,32 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
   return((P_Void_ptr)0);
 }
 
+static int mesh_type( P_Renderer* self, P_Cached_Mesh* data )
+/* This routine returns the record type for a mesh */
+{
+  return( ((data->stripped) ? PVM3D_STRIP_MESH : PVM3D_MESH)
+	  | ((QUANTIZE(self)) ? PVM3D_COMPRESSED : 0) );
+}
+
+static void pack_cached_mesh( P_Renderer* self, P_Cached_Mesh* data,
+			      P_Transform* current_trans )
+/* This routine packs a mesh_record */
+{
+  int msgbuf[2];
+
+  msgbuf[0]= data->nfacets;
+  msgbuf[1]= data->nindices;
+  PACK_INT(self, msgbuf, 2);
+  if (QUANTIZE(self))
+    pack_coded_indices(self, data->facet_lengths, data->nfacets,
+		       data->indices, data->nindices);
+  else {
+    PACK_INT(self, data->facet_lengths, data->nfacets);
+    PACK_INT(self, data->indices, data->nindices);
+  }
+  pack_cached_vlist( self, data->cached_vlist, current_trans );
+}
+
 static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
 		       P_Attrib_List *attrs)
 {
@@ -923,18 +1177,26 @@ static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
 
   if (RENDATA(self)->open) {
     P_Cached_Mesh* data= (P_Cached_Mesh*)object_data;
-    static int msgbuf[3]= {PVM3D_MESH, 0, 0};
+    static int msgbuf[1];
     ger_debug("pvm_ren_mthd: ren_mesh");
-    check_attrs(self);
-    msgbuf[1]= data->nfacets;
-    msgbuf[2]= data->nindices;
-    if (pvm_pkint(msgbuf,3,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_mesh: error in pvm_pkint");
-    if (pvm_pkint(data->facet_lengths, data->nfacets, 1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_mesh: error in pvm_pkint");
-    if (pvm_pkint(data->indices, data->nindices, 1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_mesh: error in pvm_pkint");
-    pack_cached_vlist( self, data->cached_vlist );
+    if (DEFINING(self)) {
+      if (GEOM_CACHE(self) && !data->cached_vlist->defined) {
+	pack_geom_define(self, data->cached_vlist, mesh_type(self, data));
+	pack_cached_mesh(self, data, Identity_trans);
+      }
+    }
+    else {
+      check_attrs(self);
+      if (data->cached_vlist->defined) 
+	pack_geom_use(self, data->cached_vlist);
+      else {
+	count_undefined(self, data->cached_vlist);
+	msgbuf[0]= mesh_type(self, data);
+	PACK_INT(self, msgbuf, 1);
+	METHOD_RDY(ASSIST(self));
+	pack_cached_mesh(self, data, (*(ASSIST(self)->get_trans))());
+      }
+    }
   }
 
   METHOD_OUT;
@@ -948,6 +1210,7 @@ static void destroy_mesh( P_Void_ptr object_data )
   if (RENDATA(self)->open) {
     P_Cached_Mesh* data= (P_Cached_Mesh*)object_data;
     ger_debug("pvm_ren_mthd: destroy_mesh");
+    forget_geometry( self, data->cached_vlist );
     free( (P_Void_ptr)(data->facet_lengths) );
     free( (P_Void_ptr)(data->indices) );
     free_cached_vlist( (P_Void_ptr)(data->cached_vlist) );
@@ -1007,22 +1270,18 @@ static void ren_text(P_Void_ptr object_data, P_Transform *transform,
   P_Renderer *self= (P_Renderer*)po_this;
   METHOD_IN;
 
-  if (RENDATA(self)->open) {
+  if (RENDATA(self)->open && !DEFINING(self)) {
     P_Cached_Text* data= (P_Cached_Text*)object_data;
     P_Transform* current_trans;
     static int msgbuf[2]= {PVM3D_TEXT, 0};
     ger_debug("pvm_ren_mthd: ren_text");
     check_attrs(self);
     msgbuf[1]= strlen( data->tstring );
-    if (pvm_pkint(msgbuf,2,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_text: error in pvm_pkint");
-    if (pvm_pkstr(data->tstring) < 0)
-      pvm_perror("pvm_ren_mthd: ren_text: error in pvm_pkstr");
-    if (pvm_pkfloat(data->coords,9,1) < 0)
-      pvm_perror("pvm_ren_mthd: ren_text: error in pvm_pkfloat");
+    PACK_INT(self, msgbuf, 2);
+    PACK_STR(self, data->tstring);
+    PACK_FLOAT(self, data->coords, 9);
     current_trans= (*(ASSIST(self)->get_trans))();
-    if (pvm_pkfloat(current_trans->d, 12, 1)<0)
-      pvm_perror("pvm_ren_mthd: ren_cylinder: error in pvm_pkfloat");
+    PACK_FLOAT(self, current_trans->d, 12);
   }
 
   METHOD_OUT;
@@ -1069,7 +1328,7 @@ static void ren_light(P_Void_ptr object_data, P_Transform *transform,
   P_Renderer *self= (P_Renderer*)po_this;
   METHOD_IN;
 
-  if (RENDATA(self)->open) {
+  if (RENDATA(self)->open && !DEFINING(self)) {
     ger_debug("pvm_ren_mthd: ren_light");
     check_attrs(self);
     /* do something */
@@ -1134,7 +1393,7 @@ static void ren_ambient(P_Void_ptr object_data, P_Transform *transform,
   P_Renderer *self= (P_Renderer*)po_this;
   METHOD_IN;
 
-  if (RENDATA(self)->open) {
+  if (RENDATA(self)->open && !DEFINING(self)) {
     ger_debug("pvm_ren_mthd: ren_ambient");
     check_attrs(self);
     /* do something */
@@ -1192,55 +1451,79 @@ static P_Void_ptr def_gob( char *name, P_Gob *gob )
 
 void pg_pvm_ren_retransmit() /* backdoor useful in debugging */
 {
-  int oldbuf;
-  
-  /* Resend the most recent PVM message */
-  if (!most_recent_send_buf) {
+  /* Resend the most recent message */
+  if (!most_recent_self) {
     fprintf(stderr,"pg_pvm_ren_retransmit: no most recent buffer!\n");
     return;
   }
+  if (!XPORT(most_recent_self)->resend) {
+    fprintf(stderr,"pg_pvm_ren_retransmit: not supported by transport %s\n",
+	    XPORT(most_recent_self)->kind);
+    return;
+  }
   
   /* get synched if necessary */
-  if (!INSTANCE(most_recent_self) && FRAME_NUMBER(most_recent_self)) {
-    int old_rbuf;
-    int sync_rbuf;
-#ifdef CRAY
-    long wc_sync_start;
-#endif
-    if ((old_rbuf= pvm_setrbuf(0))<0)
-      pvm_perror("pg_pvm_ren_retransmit: error in pvm_setrbuf 1");
-#ifdef CRAY
-    wc_sync_start= rtclock();
-#endif
-    if (pvm_recv(-1, CLIENT_SYNC_MSG)<0)
-      pvm_perror("pg_pvm_ren_retransmit: error in pvm_recv");
-#ifdef CRAY
-    pg_pvm_sync_clocks += (rtclock() - wc_sync_start);
-#endif
-    if ((sync_rbuf= pvm_setrbuf(old_rbuf))<0)
-      pvm_perror("pg_pvm_ren_retransmit: error in pvm_setrbuf 2");
-    if (pvm_freebuf(sync_rbuf)<0)
-      pvm_perror("pg_pvm_ren_retransmit: error in pvm_freebuf");
-  }
+  if (!INSTANCE(most_recent_self) && FRAME_NUMBER(most_recent_self))
+    (*(XPORT(most_recent_self)->wait_sync))(XPORT(most_recent_self));
   
   /* resend last message */
-  if ((oldbuf= pvm_setsbuf(most_recent_send_buf)) < 0) {
-    pvm_perror("pg_pvm_ren_retransmit: error in pvm_setsbuf");
-    return;
-  }
-  if ( pvm_send(RENSERVER_TID(most_recent_self), PVM3D_DRAW) < 0 )
-    pvm_perror("pg_pvm_ren_retransmit: error on send");
-  if (pvm_setsbuf(oldbuf) < 0)
-    pvm_perror("pg_pvm_ren_retransmit: error resetting in pvm_setsbuf");
+  (*(XPORT(most_recent_self)->resend))(XPORT(most_recent_self));
   
   FRAME_NUMBER(most_recent_self)++;
 }
 
+static void define_geometry( P_Renderer *self, P_Gob *gob )
+/* This routine sends the server any geometry under the gob which it
+ * has not yet cached, and tells it which cached geometry has been
+ * destroyed.  The primitive methods see DEFINING set and pack
+ * definitions rather than drawing.
+ */
+{
+  P_Gob_List *kidlist;
+  int msgbuf[2];
+  int i;
+
+  ger_debug("pvm_ren_mthd: define_geometry: %d new, %d freed",
+	    UNDEFINED_GEOMS(self), N_FREED_GEOMS(self));
+
+  if (N_FREED_GEOMS(self)) {
+    open_geometry_msg(self);
+    msgbuf[0]= PVM3D_GEOM_FREE;
+    for (i=0; i<N_FREED_GEOMS(self); i++) {
+      msgbuf[1]= FREED_GEOMS(self)[i];
+      PACK_INT(self, msgbuf, 2);
+    }
+    N_FREED_GEOMS(self)= 0;
+  }
+
+  if (UNDEFINED_GEOMS(self)) {
+    DEFINING(self)= 1;
+    for (kidlist= gob->children; kidlist; kidlist= kidlist->next) {
+      METHOD_RDY(kidlist->gob);
+      (*(kidlist->gob->render_to_ren))(self, (P_Transform *)0,
+				       (P_Attrib_List *)0 );
+    }
+    DEFINING(self)= 0;
+
+    /* Geometry the pass did not reach is not being drawn, so it stops
+     * counting;  it is counted again if a later frame draws it.
+     */
+    DEFINE_PASS(self)++;
+    UNDEFINED_GEOMS(self)= 0;
+  }
+
+  if (GEOM_MSG_OPEN(self)) {
+    static int endfmbuf= PVM3D_ENDFRAME;
+    PACK_INT(self, &endfmbuf, 1);
+    (*(XPORT(self)->send))(XPORT(self));
+    GEOM_MSG_OPEN(self)= 0;
+  }
+}
+
 static void ren_gob( P_Void_ptr primdata, P_Transform *trans, 
 		    P_Attrib_List *attr )
 {
   P_Renderer *self= (P_Renderer *)po_this;
-  int newbuf, oldbuf;
   METHOD_IN
 
   if (RENDATA(self)->open) {
@@ -1248,6 +1531,17 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
     P_Gob_List* kidlist;
     ger_debug("pvm_ren_mthd: ren_gob:");
 
+    /* During the definition pass, just find the primitives */
+    if (DEFINING(self)) {
+      for (kidlist= thisgob->children; kidlist; kidlist= kidlist->next) {
+	METHOD_RDY(kidlist->gob);
+	(*(kidlist->gob->render_to_ren))(self, (P_Transform *)0,
+					 (P_Attrib_List *)0 );
+      }
+      METHOD_OUT
+      return;
+    }
+
     /* if transform is non-null, this is a top-level call and we have
      * to do transform and attribute management.
      */
@@ -1257,24 +1551,15 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
       static int fmnumbuf;
 
       most_recent_self= self;
-      if (most_recent_send_buf && (pvm_freebuf(most_recent_send_buf) < 0))
-	pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_freebuf");
-      if ((newbuf=pvm_mkbuf(PvmDataDefault)) < 0)
-	pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_mkbuf");
-      if ((oldbuf= pvm_setsbuf(newbuf)) < 0)
-	pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_setsbuf");
-      most_recent_send_buf= newbuf; /* global, for debugging use */
+      if (GEOM_CACHE(self) && (UNDEFINED_GEOMS(self) || N_FREED_GEOMS(self)))
+	define_geometry(self, thisgob);
+      (*(XPORT(self)->begin))(XPORT(self), PVM3D_DRAW);
 
       strlenbuf= strlen(NAME(self));
-      if (pvm_pkint(&strlenbuf,1,1) < 0)
-	pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_pkint");
-      if (pvm_pkstr(NAME(self)) < 0) {
-	pvm_perror("pvm_ren_renderer: error in pvm_pkstr");
-	exit(-1);
-      }
+      PACK_INT(self, &strlenbuf, 1);
+      PACK_STR(self, NAME(self));
       fmnumbuf= FRAME_NUMBER(self);
-      if (pvm_pkint(&fmnumbuf,1,1) < 0)
-	pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_pkint 2");
+      PACK_INT(self, &fmnumbuf, 1);
 
       /* Send the camera, if there is one */
       if (CURRENT_CAMERA(self)) pack_camera(self);
@@ -1318,36 +1603,11 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
     if (trans) {
       static int endfmbuf= PVM3D_ENDFRAME;
 
-      if (!INSTANCE(self) && FRAME_NUMBER(self)) {
-#ifdef CRAY
-	long wc_sync_start;
-#endif
-	/* Get synchronized */
-	int old_rbuf;
-	int sync_rbuf;
-	if ((old_rbuf= pvm_setrbuf(0))<0)
-	  pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_setrbuf 1");
-#ifdef CRAY
-	wc_sync_start= rtclock();
-#endif
-	if (pvm_recv(-1, CLIENT_SYNC_MSG)<0)
-	  pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_recv");
-#ifdef CRAY
-	pg_pvm_sync_clocks += (rtclock() - wc_sync_start);
-#endif
-	if ((sync_rbuf= pvm_setrbuf(old_rbuf))<0)
-	  pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_setrbuf 2");
-	if (pvm_freebuf(sync_rbuf)<0)
-	  pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_freebuf");
-      }
+      if (!INSTANCE(self) && FRAME_NUMBER(self))
+	(*(XPORT(self)->wait_sync))(XPORT(self));
 
-      if (pvm_pkint(&endfmbuf,1,1) < 0)
-	pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_pkint");
-      if ( pvm_send(RENSERVER_TID(self), PVM3D_DRAW) < 0 )
-	pvm_perror("pvm_ren_mthd: ren_gob: error on send");
-      pg_pvm_most_recent_renserver_tid= RENSERVER_TID(self);
-      if (pvm_setsbuf(oldbuf) < 0)
-	pvm_perror("pvm_ren_mthd: ren_gob: error resetting in pvm_setsbuf");
+      PACK_INT(self, &endfmbuf, 1);
+      (*(XPORT(self)->send))(XPORT(self));
 
       METHOD_RDY( ASSIST(self) );
       (*(ASSIST(self)->pop_attributes))( attr );
@@ -1414,80 +1674,20 @@ static void unhold_gob( P_Void_ptr primdata )
 
 static void pvm_init_renderer(P_Renderer *self)
 {
-  int newbuf, oldbuf;
-  int old_route_policy;
   int databuf[2];
   
-  TID(self)= pvm_mytid();
-  
-  /* get tid of rendering server, looping and sleeping if necessary */
-  while ((RENSERVER_TID(self)=pvm_gettid(SERVER_GROUP_NAME,0)) <= 0) {
-    if (RENSERVER_TID(self)==PvmNoGroup) {
-      fprintf(stderr,"pvm_init_renderer: awaiting server startup.\n");
-      (void)sleep(10);
-    }
-    else {
-      pvm_perror("pvm_init_renderer: pvm_gettid error");
-      exit(-1);
-    }
-  }
-
-  /* Join the client group, if we are the first instance in this process */
-  if (!INSTANCE(self)) {
-    if (pvm_joingroup(CLIENT_GROUP_NAME) < 0) {
-      pvm_perror("pvm_init_renderer: error in pvm_joingroup");
-      exit(-1);
-    }
-  }
-  
-  /* send rendering server message, connecting up.  Want to do it
-   * using direct routing, and then reset all values to those expected
-   * by host program */
-  if ((newbuf=pvm_mkbuf( PvmDataDefault )) < 0) {
-    pvm_perror("pvm_init_renderer: error in pvm_mkbuf");
-    exit(-1);
-  }
-  if ((oldbuf= pvm_setsbuf(newbuf)) < 0) {
-    pvm_perror("pvm_init_renderer: error in pvm_setsbuf");
-    exit(-1);
-  }
-  if ((old_route_policy= pvm_getopt( PvmRoute )) < 0) 
-    pvm_perror("pvm_init_renderer: error in pvm_getopt");
-  if ( pvm_setopt(PvmRoute, PvmRouteDirect) < 0 ) 
-    pvm_perror("pvm_init_renderer: error in pvm_setopt");
-  
+  /* send rendering server message, connecting up. */
+  (*(XPORT(self)->begin))(XPORT(self), PVM3D_CONNECT);
   databuf[0]= TID(self);
   databuf[1]= strlen(NAME(self));
-  if (pvm_pkint( databuf,2,1 ) < 0) {
-    pvm_perror("pvm_init_renderer: error in pvm_pkint");
-    exit(-1);
-  }
-  if (pvm_pkstr(NAME(self)) < 0) {
-    pvm_perror("pvm_init_renderer: error in pvm_pkstr");
-    exit(-1);
-  }
-  
-  if (pvm_send(RENSERVER_TID(self),PVM3D_CONNECT) < 0) {
-    pvm_perror("pvm_init_renderer: error in pvm_send");
-    exit(-1);
-  }
-  
-  if ( pvm_setopt(PvmRoute, old_route_policy) < 0 )
-    pvm_perror("pvm_init_renderer: error resetting in pvm_getopt");
-  if (pvm_setsbuf(oldbuf) < 0) {
-    pvm_perror("pvm_init_renderer: error resetting in pvm_setsbuf");
-    exit(-1);
-  }
-  if (pvm_freebuf(newbuf) < 0) {
-    pvm_perror("pvm_init_renderer: error in pvm_freebuf");
-    exit(-1);
-  }
+  PACK_INT(self, databuf, 2);
+  PACK_STR(self, NAME(self));
+  (*(XPORT(self)->send))(XPORT(self));
 }
 
 static void ren_destroy( VOIDLIST )
 {
   P_Renderer *self= (P_Renderer *)po_this;
-  int newbuf, oldbuf;
   int databuf[2];
   METHOD_IN
 
@@ -1495,54 +1695,26 @@ static void ren_destroy( VOIDLIST )
   if (RENDATA(self)->open) ren_close();
 
   /* send rendering server message, disconnecting. */
-  if ((newbuf=pvm_mkbuf( PvmDataDefault )) < 0)
-    pvm_perror("pvm_ren_mthd: ren_destroy: error in pvm_mkbuf");
-  if ((oldbuf= pvm_setsbuf(newbuf)) < 0)
-    pvm_perror("pvm_ren_mthd: ren_destroy: error in pvm_setsbuf");
-
+  (*(XPORT(self)->begin))(XPORT(self), PVM3D_DISCONNECT);
   databuf[0]= TID(self);
   databuf[1]= strlen(NAME(self));
-  if (pvm_pkint( databuf,2,1 ) < 0)
-    pvm_perror("pvm_ren_mthd: ren_destroy: error in pvm_pkint");
-  if (pvm_pkstr(NAME(self)) < 0) {
-    pvm_perror("pvm_ren_mthd: ren_destroy: error in pvm_pkstr");
-    exit(-1);
-  }
+  PACK_INT(self, databuf, 2);
+  PACK_STR(self, NAME(self));
 
   /* Get synchronized if necessary */
-  if (!INSTANCE(self) && FRAME_NUMBER(self)) {
-    int old_rbuf;
-    int sync_rbuf;
-    if ((old_rbuf= pvm_setrbuf(0))<0)
-      pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_setrbuf 1");
-    if (pvm_recv(-1, CLIENT_SYNC_MSG)<0)
-      pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_recv");
-    if ((sync_rbuf= pvm_setrbuf(old_rbuf))<0)
-      pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_setrbuf 2");
-    if (pvm_freebuf(sync_rbuf)<0)
-      pvm_perror("pvm_ren_mthd: ren_gob: error in pvm_freebuf");
-  }
-
-  if (pvm_send(RENSERVER_TID(self),PVM3D_DISCONNECT) < 0)
-    pvm_perror("pvm_ren_mthd: ren_destroy: error in pvm_send to server");
-
-  if (pvm_setsbuf(oldbuf) < 0)
-    pvm_perror("pvm_ren_mthd: ren_destroy: error resetting in pvm_setsbuf");
-
-  if (pvm_freebuf(newbuf) < 0)
-    pvm_perror("pvm_ren_mthd: ren_destroy: error in pvm_freebuf");
-
-  /* Leave the client group, if we are the first instance in this process */
-  if (!INSTANCE(self)) {
-    if (pvm_lvgroup(CLIENT_GROUP_NAME) < 0) {
-      pvm_perror("pvm_init_renderer: error in pvm_joingroup");
-      exit(-1);
-    }
-  }
+  if (!INSTANCE(self) && FRAME_NUMBER(self))
+    (*(XPORT(self)->wait_sync))(XPORT(self));
+
+  (*(XPORT(self)->send))(XPORT(self));
+
+  (*(XPORT(self)->destroy))(XPORT(self));
+  if (most_recent_self==self) most_recent_self= NULL;
   
   RENDATA(self)->initialized= 0;
   instance_count--;
 
+  if (FREED_GEOMS(self)) free( (P_Void_ptr)FREED_GEOMS(self) );
+  free( (P_Void_ptr)NAME(self) );
   free( (P_Void_ptr)RENDATA(self) );
   free( (P_Void_ptr)self );
 
@@ -1554,11 +1726,51 @@ P_Renderer *po_create_pvm_renderer( char *device, char *datastr )
 {
   P_Renderer *self;
   P_Renderer_data *rdata;
+  Xp_Transport *transport;
+  char spec[256];
+  char *address, *options, *opt;
+  int geom_cache;
+  int quantize= 0;
+  float tolerance= 0.0;
+  int strip= 0;
   static int sequence_number = 0;
 
   ger_debug("po_create_pvm_renderer: device= <%s>, datastr= <%s>",
 	    device, datastr);
 
+  /* The data string names the transport and its address, followed
+   * by any options.
+   */
+  if (!datastr || !*datastr || *datastr==',') {
+    strcpy(spec, DEFAULT_TRANSPORT);
+    strncat(spec, datastr ? datastr : "", sizeof(spec)-strlen(spec)-1);
+  }
+  else {
+    strncpy(spec, datastr, sizeof(spec)-1);
+    spec[sizeof(spec)-1]= '\0';
+  }
+  if ((options= strchr(spec, ','))) *options++= '\0';
+  if ((address= strchr(spec, '='))) *address++= '\0';
+  else address= "";
+  geom_cache= strcmp(spec, "pvm");
+  for (opt= options ? strtok(options, ",") : NULL; opt; 
+       opt= strtok(NULL, ",")) {
+    if (!strcmp(opt, "cache")) geom_cache= 1;
+    else if (!strcmp(opt, "nocache")) geom_cache= 0;
+    else if (!strcmp(opt, "quantize")) quantize= 1;
+    else if (!strcmp(opt, "strip")) strip= 1;
+    else if (!strncmp(opt, "tolerance=", 10)) {
+      quantize= 1;
+      tolerance= atof(opt+10);
+    }
+    else ger_error("po_create_pvm_renderer: unknown option <%s> ignored",
+		   opt);
+  }
+  if ( !(transport= xp_create(spec, address, instance_count)) ) {
+    ger_error("po_create_pvm_renderer: cannot reach a render server");
+    return((P_Renderer *)0);
+  }
+
   /* Create memory for the renderer */
   if ( !(self= (P_Renderer *)malloc(sizeof(P_Renderer))) )
     ger_fatal("po_create_pvm_renderer: unable to allocate %d bytes!",
@@ -1570,13 +1782,6 @@ P_Renderer *po_create_pvm_renderer( char *device, char *datastr )
               sizeof(P_Renderer_data) );
   self->object_data= (P_Void_ptr)rdata;
 
-  /* Build the transformation buffer (need only 1) */
-  if (!transform_buf) {
-    if (!(transform_buf=(float*)malloc(3*TRANSFORM_BUF_TRIPLES*sizeof(float))))
-      ger_fatal("po_create_pvm_renderer: unable to allocate %d floats!",
-		3*TRANSFORM_BUF_TRIPLES);
-  }
-
   /* Fill out default color map */
   strcpy(default_map.name,"default-map");
   default_map.min= 0.0;
@@ -1590,6 +1795,19 @@ P_Renderer *po_create_pvm_renderer( char *device, char *datastr )
 
   INSTANCE(self)= instance_count++;
   FRAME_NUMBER(self)= 0;
+  XPORT(self)= transport;
+  GEOM_CACHE(self)= geom_cache;
+  DEFINING(self)= 0;
+  GEOM_MSG_OPEN(self)= 0;
+  NEXT_GEOM_ID(self)= 0;
+  UNDEFINED_GEOMS(self)= 0;
+  DEFINE_PASS(self)= 0;
+  FREED_GEOMS(self)= NULL;
+  N_FREED_GEOMS(self)= 0;
+  FREED_GEOMS_SPACE(self)= 0;
+  QUANTIZE(self)= quantize;
+  TOLERANCE(self)= tolerance;
+  STRIP(self)= strip;
   if (strlen(device)) {
     if ( !(NAME(self)= (char*)malloc(strlen(device)+1)) ) {
       ger_fatal("po_create_pvm_renderer: unable to allocate %d chars!",
@@ -1685,7 +1903,7 @@ P_Renderer *po_create_pvm_renderer( char *device, char *datastr )
   self->install_cmap= install_cmap;
   self->destroy_cmap= destroy_cmap;
 
-  /* do pvm stuff */
+  /* connect to the render server */
   pvm_init_renderer(self);
   
   RENDATA(self)->initialized= 1;
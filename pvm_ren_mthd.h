@@ -18,7 +18,18 @@
 
 #define MAXSYMBOLLENGTH P3D_NAMELENGTH
 
-#define TRANSFORM_BUF_TRIPLES 1000
+/* Transport used if the data string does not name one.  Geometry
+ * caching is on by default except over PVM, where older servers may
+ * not understand it.
+ */
+#ifdef INCL_PVM
+#define DEFAULT_TRANSPORT "pvm"
+#else
+#define DEFAULT_TRANSPORT "socket"
+#endif
+
+/* Vertices transformed per block when packing a vertex list */
+#define TRANSFORM_BUF_TRIPLES (XP_RESERVE_FLOATS/3)
 
 /* Struct to hold info for a cached vertex list */
 typedef struct vlist_cache_struct {
@@ -29,6 +40,9 @@ typedef struct vlist_cache_struct {
   float *colors;
   float *opacities;
   float *normals;
+  int geom_id;  /* id for the server's geometry cache */
+  int defined;  /* non-zero once the server has cached it */
+  int counted_pass; /* definition pass it is counted undefined for */
 } P_Cached_Vlist;
 
 typedef struct mesh_cache_struct {
@@ -36,7 +50,8 @@ typedef struct mesh_cache_struct {
   int nindices;
   int *facet_lengths;
   int *indices;
-  P_Cached_Vlist* cached_vlist;
+  int stripped; /* non-zero if facets are triangle strips */
+  P_Cached_Vlist* cached_vlist; /* its geom_id serves for the mesh */
 } P_Cached_Mesh;
 
 typedef struct text_cache_struct {
@@ -58,9 +73,20 @@ typedef struct renderer_data_struct {
   int open;
   int initialized;
   int instance;
-  int tid;
   int frame_number;
-  int renserver_tid;
+  Xp_Transport *transport;
+  int geom_cache;               /* non-zero to cache geometry on server */
+  int defining;                 /* sending geometry definitions */
+  int geom_msg_open;            /* a PVM3D_GEOMETRY message is begun */
+  int next_geom_id;
+  int undefined_geoms;          /* cached geometry not yet sent */
+  int define_pass;              /* definition passes made */
+  int *freed_geoms;             /* sent geometry since destroyed */
+  int n_freed_geoms;
+  int freed_geoms_space;
+  int quantize;                 /* non-zero to compress vertex lists */
+  float tolerance;              /* most position error quantizing may add */
+  int strip;                    /* non-zero to send meshes as strips */
   P_Renderer_Cmap *current_cmap;
   int attrs_set;
   int current_backcull;
@@ -77,9 +103,21 @@ typedef struct renderer_data_struct {
 
 #define RENDATA( self ) ((P_Renderer_data *)(self->object_data))
 #define INSTANCE( self ) (RENDATA(self)->instance)
-#define TID( self ) (RENDATA(self)->tid)
 #define FRAME_NUMBER( self ) (RENDATA(self)->frame_number)
-#define RENSERVER_TID( self ) (RENDATA(self)->renserver_tid)
+#define XPORT( self ) (RENDATA(self)->transport)
+#define TID( self ) (XPORT(self)->tid)
+#define GEOM_CACHE( self ) (RENDATA(self)->geom_cache)
+#define DEFINING( self ) (RENDATA(self)->defining)
+#define GEOM_MSG_OPEN( self ) (RENDATA(self)->geom_msg_open)
+#define NEXT_GEOM_ID( self ) (RENDATA(self)->next_geom_id)
+#define UNDEFINED_GEOMS( self ) (RENDATA(self)->undefined_geoms)
+#define DEFINE_PASS( self ) (RENDATA(self)->define_pass)
+#define FREED_GEOMS( self ) (RENDATA(self)->freed_geoms)
+#define N_FREED_GEOMS( self ) (RENDATA(self)->n_freed_geoms)
+#define FREED_GEOMS_SPACE( self ) (RENDATA(self)->freed_geoms_space)
+#define QUANTIZE( self ) (RENDATA(self)->quantize)
+#define TOLERANCE( self ) (RENDATA(self)->tolerance)
+#define STRIP( self ) (RENDATA(self)->strip)
 #define NAME( self ) (RENDATA(self)->name)
 #define CUR_MAP( self ) (RENDATA(self)->current_cmap)
 #define MAP_NAME( self ) (CUR_MAP(self)->map_name)
@@ -97,3 +135,11 @@ typedef struct renderer_data_struct {
 #define COLORSYMBOL(self) (RENDATA(self)->color_symbol)
 #define MATERIALSYMBOL(self) (RENDATA(self)->material_symbol)
 #define ASSIST(self) (RENDATA(self)->assist)
+
+/* Message packing through the transport */
+#define PACK_INT( self, vals, n ) \
+  (*(XPORT(self)->pack_int))( XPORT(self), (vals), (n) )
+#define PACK_FLOAT( self, vals, n ) \
+  (*(XPORT(self)->pack_float))( XPORT(self), (vals), (n) )
+#define PACK_STR( self, str ) \
+  (*(XPORT(self)->pack_str))( XPORT(self), (str) )
@@ -19,15 +19,21 @@ This module provides the ability to generate isosurfaces from randomly
 distributed data.
 */
 #include <stdio.h>
+#include <stdlib.h>
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "ge_error.h"
 #include "dirichlet.h"
+#include "parallel.h"
+#include "decimate.h"
 
 /* Notes-
    -does ival want to be a double, to please ornery C compilers?
-   -I don't think we need to distinguish between cut_links and cuts,
-    though it may be a good idea for future flexibility.
+   -The Dirichlet tesselation is reduced to tables of tetrahedra and
+    their edges as soon as it is built, and those tables are kept under
+    a handle so that many isosurfaces can be pulled from one point set.
+    Extracting a surface is then just a pass over the edges and one over
+    the tetrahedra, both of which are split across threads.
 */
 
 #define CVTX_SZ    3
@@ -37,469 +43,380 @@ distributed data.
 #define CVVTX_SZ   4
 #define CVNVTX_SZ  7
 
-/* A cell to hold information about a triangle, and a counter for them */
+/* Smallest numbers of edges and tetrahedra worth handing to a thread */
+#define MIN_EDGES_PER_THREAD 16384
+#define MIN_TETS_PER_THREAD 8192
+
+/* Initial number of slots in the table of tesselation handles */
+#define INITIAL_TESS_SLOTS 8
+
+/* A cell to hold information about a triangle */
 typedef struct triangle_struct {
   int i1, i2, i3;
-  dch_Pt *outside_pt;
-  dch_Pt *inside_pt;
-  struct triangle_struct *next;
+  int inside_pt;
+  int outside_pt;
 } Triangle;
-static int live_triangles= 0;
-
-/* A cell to hold information about a cut, and a counter for them */
-typedef struct cut_struct {
-  dch_Pt *p1;
-  dch_Pt *p2;
-  int id;
-  struct cut_struct *next;
-} Cut;
-static int live_cuts= 0;
-
-/* A cell to hang on a dch_Pt, holding cut information, and a hook to
- * connect all of them to.
+
+/* One edge of one tetrahedron, used while building the edge table */
+typedef struct tet_edge_struct {
+  int lo, hi;
+  int slot;  /* 6*tet + local edge number */
+} Tet_edge;
+
+/* The reduced tesselation of one point set */
+typedef struct rand_tess_struct {
+  int in_vtxtype, out_vtxtype, float_per_vtx;
+  int npts;
+  float *coords;    /* 3 per point */
+  float *values;    /* the values from the vertex list */
+  float *extras;    /* normals or second values, or null */
+  int nedges;
+  int *edges;       /* 2 point indices per edge */
+  int ntets;
+  int *tets;        /* 4 point indices per tetrahedron */
+  int *tet_edges;   /* 6 edge numbers per tetrahedron */
+  int *edge_cuts;   /* cut vertex for each edge, or -1 */
+} Rand_tess;
+
+/* Work shared by the threads extracting one isosurface */
+typedef struct iso_pass_struct {
+  Rand_tess *rt;
+  float *values;
+  float ival;
+  int show_inside;
+  float *cuts;
+  int *counts;          /* per worker cut offsets or triangle counts */
+  Triangle **triangles; /* per worker triangle arrays */
+} Iso_pass;
+
+/* The table of live handles;  handle n is in slot n-1 */
+static Rand_tess **tess_table= (Rand_tess **)0;
+static int tess_slots= 0;
+
+/* Local edge number of each pair of tetrahedron corners */
+static int pair_edge[4][4]= {
+  { -1, 0, 1, 2 },
+  { 0, -1, 3, 4 },
+  { 1, 3, -1, 5 },
+  { 2, 4, 5, -1 }
+};
+
+/* The triangles to generate for each of the 16 cases of corners at or
+ * above the isosurface value.  Each triangle is given by a corner
+ * inside the surface, a corner outside it, and the three cut edges
+ * as corner pairs.  The inside and outside corners are used only to
+ * decide which way the triangle faces.
  */
-typedef struct cut_link_struct {
-  Cut *cut;
-  struct cut_link_struct *next;
-  struct cut_link_struct *all_links_next;
-} Cut_link;
-static Cut_link *cut_link_list= (Cut_link *)0;
-
-/* A structure to connect to the user_hook field of the dch_Pt's in
- * the Dirichlet tesselation, and a hook for the global array of them.
+static int tet_cases[16][2][8]= {
+  { { -1 }, { -1 } },
+  { { 0, 1,  0, 1,  0, 2,  0, 3 }, { -1 } },
+  { { 1, 0,  1, 0,  1, 3,  1, 2 }, { -1 } },
+  { { 0, 3,  0, 3,  1, 3,  0, 2 }, { 1, 2,  1, 2,  0, 2,  1, 3 } },
+  { { 2, 0,  2, 0,  2, 1,  2, 3 }, { -1 } },
+  { { 0, 1,  0, 1,  2, 1,  0, 3 }, { 2, 3,  2, 3,  0, 3,  2, 1 } },
+  { { 1, 3,  1, 3,  2, 3,  1, 0 }, { 2, 0,  2, 0,  1, 0,  2, 3 } },
+  { { 1, 3,  1, 3,  2, 3,  0, 3 }, { -1 } },
+  { { 3, 0,  3, 0,  3, 2,  3, 1 }, { -1 } },
+  { { 0, 2,  0, 2,  3, 2,  0, 1 }, { 3, 1,  3, 1,  0, 1,  3, 2 } },
+  { { 1, 0,  1, 0,  3, 0,  1, 2 }, { 3, 2,  3, 2,  1, 2,  3, 0 } },
+  { { 1, 2,  0, 2,  3, 2,  1, 2 }, { -1 } },
+  { { 2, 1,  2, 1,  3, 1,  2, 0 }, { 3, 0,  3, 0,  2, 0,  3, 1 } },
+  { { 0, 1,  0, 1,  3, 1,  2, 1 }, { -1 } },
+  { { 1, 0,  2, 0,  1, 0,  3, 0 }, { -1 } },
+  { { -1 }, { -1 } }
+};
+
+/* Hook on which to hang the vertex list being tesselated, and the
+ * point indices to be hung on the tesselation's points.
  */
-typedef struct hook_data_struct {
-  int index; 
-  float value;
-  Cut_link *cut_links;
-} Hook_data;
-static Hook_data *hook_array;
-
-/* Macros to aid point data access */
-#define PT_VALUE( pt ) (((Hook_data *)((pt)->user_hook))->value)
-#define PT_INDEX( pt ) (((Hook_data *)((pt)->user_hook))->index)
-#define PT_CUTS( pt ) (((Hook_data *)((pt)->user_hook))->cut_links)
-
-/* Hook on which to hang the vertex list being tesselated */
 static P_Vlist *current_vlist= (P_Vlist *)0;
+static int *index_array= (int *)0;
 
-static void add_triangle( Triangle **list, dch_Pt *in_pt, dch_Pt *out_pt,
-			 int i1, int i2, int i3 )
-/* This routine adds a triangle to the given list */
+static float *coord_access( float *dummy, int i, P_Void_ptr *user_hook )
+/* This routine is called by the Dirichlet tesselation package to get
+ * coordinate data.  Note that the coordinate data is recopied, so we
+ * can use static storage for it.
+ */
 {
-  Triangle *newcell;
-
-  if ( !(newcell= (Triangle *)malloc( sizeof(Triangle) )) )
-    ger_fatal("rand_isosurf: add_triangle: unable to allocate %d bytes!",
-	      sizeof(Triangle));
-
-  newcell->outside_pt= out_pt;
-  newcell->inside_pt= in_pt;
-  newcell->i1= i1;
-  newcell->i2= i2;
-  newcell->i3= i3;
-  newcell->next= *list;
-  *list= newcell;
-  live_triangles++;
+  static float coords[3];
+
+  METHOD_RDY( current_vlist );
+  coords[0]= (*(current_vlist->x))(i);
+  coords[1]= (*(current_vlist->y))(i);
+  coords[2]= (*(current_vlist->z))(i);
+
+  /* The bogus points are recognized by their null hooks */
+  index_array[i]= i;
+  *user_hook= (P_Void_ptr)&index_array[i];
+
+  return(coords);
 }
 
-static void destroy_triangle_list( Triangle *list )
-/* This routine destroys the given triangle list */
+static void copy_point_data( Rand_tess *rt, P_Vlist *vlist )
+/* This routine copies the coordinates, values, and any normals or
+ * second values out of the vertex list.
+ */
 {
-  Triangle *victim, *next_victim;
-
-  victim= list;
-  while (victim) {
-    next_victim= victim->next;
-    free( (P_Void_ptr)victim );
-    live_triangles--;
-    victim= next_victim;
+  int i, nextra;
+
+  nextra= 0;
+  if (rt->in_vtxtype==P3D_CVNVTX) nextra= 3;
+  if (rt->in_vtxtype==P3D_CVVVTX) nextra= 1;
+
+  if ( !(rt->coords= (float *)malloc( 3*rt->npts*sizeof(float) ))
+       || !(rt->values= (float *)malloc( rt->npts*sizeof(float) )) )
+    ger_fatal("rand_isosurf: copy_point_data: unable to allocate %d bytes!",
+	      4*rt->npts*sizeof(float));
+  rt->extras= (float *)0;
+  if (nextra
+      && !(rt->extras= (float *)malloc( nextra*rt->npts*sizeof(float) )))
+    ger_fatal("rand_isosurf: copy_point_data: unable to allocate %d bytes!",
+	      nextra*rt->npts*sizeof(float));
+
+  METHOD_RDY( vlist );
+  for (i=0; i<rt->npts; i++) {
+    rt->coords[3*i]= (*(vlist->x))(i);
+    rt->coords[3*i+1]= (*(vlist->y))(i);
+    rt->coords[3*i+2]= (*(vlist->z))(i);
+    rt->values[i]= (*(vlist->v))(i);
+    if (nextra==3) {
+      rt->extras[3*i]= (*(vlist->nx))(i);
+      rt->extras[3*i+1]= (*(vlist->ny))(i);
+      rt->extras[3*i+2]= (*(vlist->nz))(i);
+    }
+    else if (nextra==1) rt->extras[i]= (*(vlist->v2))(i);
   }
 }
 
-static Cut *create_and_list_cut( Cut **list, 
-				dch_Pt *p1, dch_Pt *p2 )
-/* This routine creates a cut and adds it to the given list */
+static int compare_tet_edges( const void *p1, const void *p2 )
+/* This routine orders tetrahedron edges by their end points */
 {
-  Cut *newcell;
-
-  if ( !(newcell= (Cut *)malloc( sizeof(Cut) )) )
-    ger_fatal("rand_isosurf: create_and_list_cut: can't allocate %d bytes!",
-	      sizeof(Cut));
-  live_cuts++;
-
-  newcell->p1= p1;
-  newcell->p2= p2;
-  newcell->id= 0;
-  newcell->next= *list;
-  *list= newcell;
-  return( newcell );
+  Tet_edge *e1= (Tet_edge *)p1, *e2= (Tet_edge *)p2;
+
+  if (e1->lo != e2->lo) return( (e1->lo < e2->lo) ? -1 : 1 );
+  if (e1->hi != e2->hi) return( (e1->hi < e2->hi) ? -1 : 1 );
+  return( e1->slot - e2->slot );
 }
 
-static void destroy_cut_list( Cut *list )
-/* This routine destroys all the cuts in the list */
+static void reduce_tesselation( Rand_tess *rt, dch_Tess *tess )
+/* This routine copies the tetrahedra of the tesselation which lie
+ * inside the convex hull into the handle's tables, and builds the
+ * table of their edges.  Tetrahedra are the Delaunay simplices,
+ * corresponding to tesselation vertices;  those with a 'bogus' forming
+ * point lie outside the hull.
+ */
 {
-  Cut *next;
-
-  while (list) {
-    next= list->next;
-    free( (P_Void_ptr)list );
-    live_cuts--;
-    list= next;
+  dch_Vtx_list *vlist;
+  dch_Pt_list *fplist;
+  Tet_edge *tedges;
+  int *tet, i, j, k, t;
+
+  ger_debug("rand_isosurf: reduce_tesselation:");
+
+  rt->ntets= 0;
+  for (vlist= tess->vtx_list; vlist; vlist= vlist->next)
+    rt->ntets++;
+  if ( !(rt->tets= (int *)malloc( (4*rt->ntets+1)*sizeof(int) )) )
+    ger_fatal("rand_isosurf: reduce_tesselation: unable to allocate %d bytes!",
+	      4*rt->ntets*sizeof(int));
+
+  tet= rt->tets;
+  for (vlist= tess->vtx_list; vlist; vlist= vlist->next) {
+    if ( vlist->vtx->degenerate || vlist->vtx->deleted
+	|| !vlist->vtx->coords ) continue;
+    fplist= vlist->vtx->forming_pts;
+    for (i=0; i<4; i++) { /* guaranteed four forming points in 3D */
+      if (!fplist->pt->user_hook) break; /* a 'bogus point' */
+      tet[i]= *(int *)(fplist->pt->user_hook);
+      fplist= fplist->next;
+    }
+    if (i==4) tet += 4;
+  }
+  rt->ntets= (tet - rt->tets)/4;
+
+  /* Sort the edges of all the tetrahedra to find the distinct ones */
+  if ( !(tedges= (Tet_edge *)malloc( (6*rt->ntets+1)*sizeof(Tet_edge) )) )
+    ger_fatal("rand_isosurf: reduce_tesselation: unable to allocate %d bytes!",
+	      6*rt->ntets*sizeof(Tet_edge));
+  for (t=0; t<rt->ntets; t++) {
+    tet= rt->tets + 4*t;
+    for (i=0; i<4; i++) for (j=i+1; j<4; j++) {
+      Tet_edge *te= tedges + 6*t + pair_edge[i][j];
+      te->lo= (tet[i]<tet[j]) ? tet[i] : tet[j];
+      te->hi= (tet[i]<tet[j]) ? tet[j] : tet[i];
+      te->slot= 6*t + pair_edge[i][j];
+    }
   }
+  qsort( tedges, 6*rt->ntets, sizeof(Tet_edge), compare_tet_edges );
+
+  rt->nedges= 0;
+  for (k=0; k<6*rt->ntets; k++)
+    if (k==0 || tedges[k].lo!=tedges[k-1].lo || tedges[k].hi!=tedges[k-1].hi)
+      rt->nedges++;
+  if ( !(rt->edges= (int *)malloc( (2*rt->nedges+1)*sizeof(int) ))
+       || !(rt->edge_cuts= (int *)malloc( (rt->nedges+1)*sizeof(int) ))
+       || !(rt->tet_edges= (int *)malloc( (6*rt->ntets+1)*sizeof(int) )) )
+    ger_fatal("rand_isosurf: reduce_tesselation: unable to allocate %d bytes!",
+	      (3*rt->nedges+6*rt->ntets)*sizeof(int));
+
+  j= -1;
+  for (k=0; k<6*rt->ntets; k++) {
+    if (k==0 || tedges[k].lo!=tedges[k-1].lo || tedges[k].hi!=tedges[k-1].hi) {
+      j++;
+      rt->edges[2*j]= tedges[k].lo;
+      rt->edges[2*j+1]= tedges[k].hi;
+    }
+    rt->tet_edges[tedges[k].slot]= j;
+  }
+
+  free( (P_Void_ptr)tedges );
+
+  ger_debug("rand_isosurf: reduce_tesselation: %d tets, %d edges",
+	    rt->ntets, rt->nedges);
 }
 
-static void destroy_cut_link_list( Cut_link *list )
-/* This routine destroys all the cut links in the list (traversing
- * the all_links_next connections). 
- */
+static void destroy_rand_tess( Rand_tess *rt )
+/* This routine frees a reduced tesselation */
 {
-  Cut_link *next;
-  
-  while (list) {
-    next= list->all_links_next;
-    free( (P_Void_ptr)list );
-    list= next;
-  }
+  free( (P_Void_ptr)rt->coords );
+  free( (P_Void_ptr)rt->values );
+  if (rt->extras) free( (P_Void_ptr)rt->extras );
+  free( (P_Void_ptr)rt->tets );
+  free( (P_Void_ptr)rt->tet_edges );
+  free( (P_Void_ptr)rt->edges );
+  free( (P_Void_ptr)rt->edge_cuts );
+  free( (P_Void_ptr)rt );
 }
 
-static Cut *find_cut_edges( dch_Tess *tess, float ival )
-/* This routine walks the tesselation, looking for edges which are cut by
- * the new isosurface.
+static Rand_tess *create_rand_tess( P_Vlist *vlist )
+/* This routine builds the reduced tesselation of the points of the
+ * given vertex list.  A null pointer is returned if the vertex list
+ * has no values to contour.
  */
 {
-  Cut *cut_list= (Cut *)0;
-  dch_Pt_list *plist, *neighbors;
-  float val1, val2;
+  Rand_tess *rt;
+  dch_Tess *tess;
 
-  ger_debug("rand_isosurf: find_cut_edges: finding cuts at %f", ival);
-
-  /* Walk the point list, looking for cuts */
-  plist= tess->pt_list;
-  while (plist) {
-    if (plist->pt->user_hook) { /* not a 'bogus point' */
-      val1= PT_VALUE( plist->pt );
-      neighbors= plist->pt->neighbors;
-      while (neighbors) {
-	if ( neighbors->pt->user_hook   /* not a 'bogus point' */
-	    && (plist->pt->id < neighbors->pt->id) /* avoid double-counting */
-	    ) { 
-	  val2= PT_VALUE( neighbors->pt );
-	  if ( ((val1 >= ival) && (val2 < ival)) 
-	      || ((val2 >= ival) && (val1 < ival)) ) /* cut this edge */
-	    (void)create_and_list_cut( &cut_list, plist->pt, neighbors->pt );
-	}
-	neighbors= neighbors->next;
-      }
-    }
-    plist= plist->next;
+  if ( !(rt= (Rand_tess *)malloc( sizeof(Rand_tess) )) )
+    ger_fatal("rand_isosurf: create_rand_tess: unable to allocate %d bytes!",
+	      sizeof(Rand_tess));
+
+  rt->in_vtxtype= vlist->type;
+  /* calculates the necessary size for each vertex type */
+  switch( rt->in_vtxtype ) {
+  case P3D_CVVTX:
+    rt->out_vtxtype= P3D_CVTX;
+    rt->float_per_vtx = CVTX_SZ;
+    break;
+  case P3D_CVNVTX:
+    rt->out_vtxtype= P3D_CNVTX;
+    rt->float_per_vtx = CNVTX_SZ;
+    break;
+  case P3D_CVVVTX:
+    rt->out_vtxtype= P3D_CVVTX;
+    rt->float_per_vtx= CVVTX_SZ;
+    break;
+  default:
+    ger_error(
+       "rand_isosurf: vertex type %d has no value to contour; call ignored.",
+	      (int)rt->in_vtxtype);
+    free( (P_Void_ptr)rt );
+    return( (Rand_tess *)0 );
+    break;
   }
 
-  return( cut_list );
+  rt->npts= vlist->length;
+  copy_point_data( rt, vlist );
+
+  /* Calculate the Dirichlet tesselation, and keep the simplices which
+   * lie inside the convex hull.
+   */
+  if ( !(index_array= (int *)malloc( (vlist->length+1)*sizeof(int) )) )
+    ger_fatal("rand_isosurf: create_rand_tess: unable to allocate %d bytes!",
+	      vlist->length*sizeof(int));
+  current_vlist= vlist;
+  tess= dch_create_dirichlet_tess( (float *)0, vlist->length, 3, 
+					 coord_access );
+  reduce_tesselation( rt, tess );
+  dch_destroy_tesselation(tess);
+  free( (P_Void_ptr)index_array );
+  index_array= (int *)0;
+  current_vlist= (P_Vlist *)0;
+
+  return( rt );
 }
 
-static void interpolate_data( dch_Pt *p1, dch_Pt *p2, float ival, 
-			     float *data, int vtxtype )
+static void interpolate_data( Rand_tess *rt, float *values, int p1, int p2,
+			     float ival, float *data )
 /* This routine fills the given data slot with appropriate data based
  * an interpolation of vertex data of the given type.
  */
 {
   float v1, v2, fraction;
-  int v1_index, v2_index;
+  float *c1, *c2;
 
-  v1= PT_VALUE( p1 );
-  v2= PT_VALUE( p2 );
+  v1= values[p1];
+  v2= values[p2];
   fraction= (ival-v1) / (v2-v1);
   if ( fraction<0.0 || fraction>1.0 )
     ger_fatal("rand_isosurf: interpolate_data: algorithm error; fraction= %f!",
 	      fraction);
 
   /* Get the interpolated point coordinates */
-  *data++= (1.0-fraction) * p1->coords[0] + fraction * p2->coords[0];
-  *data++= (1.0-fraction) * p1->coords[1] + fraction * p2->coords[1];
-  *data++= (1.0-fraction) * p1->coords[2] + fraction * p2->coords[2];
-
-  if (vtxtype==P3D_CVVTX) return; /* no need to do any more */
-
-  /* Recover reference data left in hooks by coord_access, and ready the
-   * vertex list object
-   */
-  v1_index= PT_INDEX(p1);
-  v2_index= PT_INDEX(p2); 
-  METHOD_RDY( current_vlist );
+  c1= rt->coords + 3*p1;
+  c2= rt->coords + 3*p2;
+  *data++= (1.0-fraction) * c1[0] + fraction * c2[0];
+  *data++= (1.0-fraction) * c1[1] + fraction * c2[1];
+  *data++= (1.0-fraction) * c1[2] + fraction * c2[2];
 
   /* Get the interpolated point values if necessary */
-  if (vtxtype==P3D_CVVVTX) {
-    *data++= (1.0-fraction) * (*(current_vlist->v2))(v1_index)
-      + fraction * (*(current_vlist->v2))(v2_index);
+  if (rt->in_vtxtype==P3D_CVVVTX) {
+    *data++= (1.0-fraction) * rt->extras[p1] + fraction * rt->extras[p2];
   }
 
   /* Get the interpolated point normals if necessary */
-  if (vtxtype==P3D_CVNVTX) {
-    *data++= (1.0-fraction) * (*(current_vlist->nx))(v1_index)
-      + fraction * (*(current_vlist->nx))(v2_index);
-    *data++= (1.0-fraction) * (*(current_vlist->ny))(v1_index)
-      + fraction * (*(current_vlist->ny))(v2_index);
-    *data++= (1.0-fraction) * (*(current_vlist->nz))(v1_index)
-      + fraction * (*(current_vlist->nz))(v2_index);
-  }
-}
-
-static void attach_cut_point( dch_Pt *p1, dch_Pt *p2, Cut *cut )
-/* This routine attaches the given cut to the given point pair within
- * the tesselation data structure.  We attach the cut pointer to the
- * Hook_data field of the point with the higher id, where it joins
- * a potentially growing list.
- */
-{
-  Cut_link *link;
-  dch_Pt *target;
-
-  /* Allocate the link */
-  if ( !(link= (Cut_link *)malloc(sizeof(Cut_link))) )
-    ger_fatal("rand_isosurf: attach_cut_point: unable to allocate %d bytes!",
-	      sizeof(Cut_link));
-  link->all_links_next= cut_link_list;
-  cut_link_list= link;
-
-  /* Establish the connection to the cut */
-  link->cut= cut;
-
-  /* Connect it to the proper point */
-  if (p1->id == p2->id)
-    ger_fatal("rand_isosurf: attach_cut_point: algorithm error!");
-  if (p1->id > p2->id) target= p1;
-  else target= p2;
-  link->next= PT_CUTS(target);
-  PT_CUTS(target)= link;
-}
-
-static int get_cut_id( dch_Pt *p1, dch_Pt *p2 )
-/* This routine recovers the id of the cut associated with the given point
- * pair within the tesselation data structure.  The information is stored
- * in a list of cut links attached to the point with the highest id.
- */
-{
-  Cut_link *link;
-  dch_Pt *target;
-
-  /* Find the point to search, and its list of cuts */
-  if (p1->id == p2->id)
-    ger_fatal("rand_isosurf: get_cut_id: algorithm error; points match!");
-  if (p1->id > p2->id) target= p1;
-  else target= p2;
-  link= PT_CUTS(target);
-
-  /* Run down the list until we find the right match */
-  while (link) {
-    if ( ((link->cut->p1 == p1) && (link->cut->p2 == p2))
-	|| ((link->cut->p1 == p2) && (link->cut->p2 == p1)) )
-      return( link->cut->id );
-    link= link->next;
-  }
-
-  /* Getting to here means we failed to find the link */
-  ger_fatal("rand_isosurf: get_cut_id: algorithm error; \
-link between points %d and %d not found!",
-	    p1->id, p2->id);
-
-  return(0); /* to satisfy lint */
-}
-
-static void generate_cut_edges( Cut *cut_list, float *cuts, int table_step,
-			      float ival, int vtxtype )
-/* This routine walks the cut list, generating cut point data needed
- * for the isosurface.
- */
-{
-  Cut *runner;
-  int id= 0;
-
-  ger_debug("rand_isosurf: generate_cut_edges: generating cuts at %f", ival);
-
-  /* Walk the cut list, generating vertex information of the correct type */
-  runner= cut_list;
-  while (runner) {
-    interpolate_data( runner->p1, runner->p2, ival, cuts, vtxtype );
-    runner->id= id++;
-    cuts += table_step;
-    runner= runner->next;
-  }
-
-  /* Now patch the cut information into the tesselation structure.  We
-   * wait until the end to do this, as the storage method makes old
-   * point data inaccessible.
-   */
-  runner= cut_list;
-  while (runner) {
-    attach_cut_point( runner->p1, runner->p2, runner );
-    runner= runner->next;
+  if (rt->in_vtxtype==P3D_CVNVTX) {
+    c1= rt->extras + 3*p1;
+    c2= rt->extras + 3*p2;
+    *data++= (1.0-fraction) * c1[0] + fraction * c2[0];
+    *data++= (1.0-fraction) * c1[1] + fraction * c2[1];
+    *data++= (1.0-fraction) * c1[2] + fraction * c2[2];
   }
 }
 
-static void handle_one_tet( dch_Vtx *vtx, Triangle **list, float ival )
-{
-  int vtx_case=0, pow2 = 1;
-  dch_Pt_list *fplist;
-  dch_Pt *pts[4];
-  int i;
-
-  /* Drop uninteresting (degenerate, deleted, or infinite) tets immediately */
-  if ( vtx->degenerate || vtx->deleted || !vtx->coords ) return;
-
-  fplist= vtx->forming_pts;
-  for (i=0; i<4; i++) { /* guaranteed four forming points in 3D */
-    if ( PT_VALUE(fplist->pt) >= ival ) vtx_case += pow2;
-    pow2 *= 2;
-    pts[i]= fplist->pt;
-    fplist= fplist->next;
-  }
-
-  /* Always build triangles with a vertex which is greater than the
-   * isosurface value first, so check_polarity can know the proper
-   * orientation.
-   */
-  switch (vtx_case) {
-  case 0: break;
-  case 1: 
-    add_triangle( list, pts[0], pts[1],
-		 get_cut_id( pts[0], pts[1] ),
-		 get_cut_id( pts[0], pts[2] ),
-		 get_cut_id( pts[0], pts[3] ) );
-    break;
-  case 2: 
-    add_triangle( list, pts[1], pts[0],
-		 get_cut_id( pts[1], pts[0] ),
-		 get_cut_id( pts[1], pts[3] ),
-		 get_cut_id( pts[1], pts[2] ) );
-    break;
-  case 3: 
-    add_triangle( list, pts[0], pts[3],
-		 get_cut_id( pts[0], pts[3] ),
-		 get_cut_id( pts[1], pts[3] ),
-		 get_cut_id( pts[0], pts[2] ) );
-    add_triangle( list, pts[1], pts[2],
-		 get_cut_id( pts[1], pts[2] ),
-		 get_cut_id( pts[0], pts[2] ),
-		 get_cut_id( pts[1], pts[3] ) );
-    break;
-  case 4: 
-    add_triangle( list, pts[2], pts[0],
-		 get_cut_id( pts[2], pts[0] ),
-		 get_cut_id( pts[2], pts[1] ),
-		 get_cut_id( pts[2], pts[3] ) );
-    break;
-  case 5: 
-    add_triangle( list, pts[0], pts[1],
-		 get_cut_id( pts[0], pts[1] ),
-		 get_cut_id( pts[2], pts[1] ),
-		 get_cut_id( pts[0], pts[3] ) );
-    add_triangle( list, pts[2], pts[3],
-		 get_cut_id( pts[2], pts[3] ),
-		 get_cut_id( pts[0], pts[3] ),
-		 get_cut_id( pts[2], pts[1] ) );
-    break;
-  case 6: 
-    add_triangle( list, pts[1], pts[3],
-		 get_cut_id( pts[1], pts[3] ),
-		 get_cut_id( pts[2], pts[3] ),
-		 get_cut_id( pts[1], pts[0] ) );
-    add_triangle( list, pts[2], pts[0],
-		 get_cut_id( pts[2], pts[0] ),
-		 get_cut_id( pts[1], pts[0] ),
-		 get_cut_id( pts[2], pts[3] ) );
-    break;
-  case 7: 
-    add_triangle( list, pts[1], pts[3],
-		 get_cut_id( pts[1], pts[3] ),
-		 get_cut_id( pts[2], pts[3] ),
-		 get_cut_id( pts[0], pts[3] ) );
-    break;
-  case 8: 
-    add_triangle( list, pts[3], pts[0],
-		 get_cut_id( pts[3], pts[0] ),
-		 get_cut_id( pts[3], pts[2] ),
-		 get_cut_id( pts[3], pts[1] ) );
-    break;
-  case 9: 
-    add_triangle( list, pts[0], pts[2],
-		 get_cut_id( pts[0], pts[2] ),
-		 get_cut_id( pts[3], pts[2] ),
-		 get_cut_id( pts[0], pts[1] ) );
-    add_triangle( list, pts[3], pts[1],
-		 get_cut_id( pts[3], pts[1] ),
-		 get_cut_id( pts[0], pts[1] ),
-		 get_cut_id( pts[3], pts[2] ) );
-    break;
-  case 10: 
-    add_triangle( list, pts[1], pts[0],
-		 get_cut_id( pts[1], pts[0] ),
-		 get_cut_id( pts[3], pts[0] ),
-		 get_cut_id( pts[1], pts[2] ) );
-    add_triangle( list, pts[3], pts[2],
-		 get_cut_id( pts[3], pts[2] ),
-		 get_cut_id( pts[1], pts[2] ),
-		 get_cut_id( pts[3], pts[0] ) );
-    break;
-  case 11: 
-    add_triangle( list, pts[1], pts[2],
-		 get_cut_id( pts[0], pts[2] ),
-		 get_cut_id( pts[3], pts[2] ),
-		 get_cut_id( pts[1], pts[2] ) );
-    break;
-  case 12: 
-    add_triangle( list, pts[2], pts[1],
-		 get_cut_id( pts[2], pts[1] ),
-		 get_cut_id( pts[3], pts[1] ),
-		 get_cut_id( pts[2], pts[0] ) );
-    add_triangle( list, pts[3], pts[0],
-		 get_cut_id( pts[3], pts[0] ),
-		 get_cut_id( pts[2], pts[0] ),
-		 get_cut_id( pts[3], pts[1] ) );
-    break;
-  case 13: 
-    add_triangle( list, pts[0], pts[1],
-		 get_cut_id( pts[0], pts[1] ),
-		 get_cut_id( pts[3], pts[1] ),
-		 get_cut_id( pts[2], pts[1] ) );
-    break;
-  case 14: 
-    add_triangle( list, pts[1], pts[0],
-		 get_cut_id( pts[2], pts[0] ),
-		 get_cut_id( pts[1], pts[0] ),
-		 get_cut_id( pts[3], pts[0] ) );
-    break;
-  case 15: break;
-  }
-
-}
-
-static void check_orientation( Triangle *tri, float *cuts, int step, 
+static void check_orientation( Rand_tess *rt, Triangle *tri, float *cuts,
 			      int show_inside )
 /* This routine flips the orientation of the triangle if its back
  * face is pointing the wrong way.
  */
 {
   float gx, gy, gz, e1x, e1y, e1z, e2x, e2y, e2z, cx, cy, cz, dot;
+  float *inside, *outside, *v1, *v2, *v3;
+  int step= rt->float_per_vtx;
   int temp;
 
   /* From the inside and outside points of the triangle, generate
    * a vector pointing up the gradient (i.e. toward the inside of
    * the isosurface).
    */
-  gx= tri->inside_pt->coords[0] - tri->outside_pt->coords[0];
-  gy= tri->inside_pt->coords[1] - tri->outside_pt->coords[1];
-  gz= tri->inside_pt->coords[2] - tri->outside_pt->coords[2];
+  inside= rt->coords + 3*tri->inside_pt;
+  outside= rt->coords + 3*tri->outside_pt;
+  gx= inside[0] - outside[0];
+  gy= inside[1] - outside[1];
+  gz= inside[2] - outside[2];
 
   /* Generate the right-hand-rule normal of the triangle by taking
    * the cross product of the edges.
    */
-  e1x= *( cuts + step * tri->i2 ) - *( cuts + step * tri->i1 );
-  e1y= *( cuts + step * tri->i2 + 1 ) - *( cuts + step * tri->i1 + 1 );
-  e1z= *( cuts + step * tri->i2 + 2 ) - *( cuts + step * tri->i1 + 2 );
-  e2x= *( cuts + step * tri->i3 ) - *( cuts + step * tri->i2 );
-  e2y= *( cuts + step * tri->i3 + 1 ) - *( cuts + step * tri->i2 + 1 );
-  e2z= *( cuts + step * tri->i3 + 2 ) - *( cuts + step * tri->i2 + 2 );
+  v1= cuts + step * tri->i1;
+  v2= cuts + step * tri->i2;
+  v3= cuts + step * tri->i3;
+  e1x= v2[0] - v1[0];
+  e1y= v2[1] - v1[1];
+  e1z= v2[2] - v1[2];
+  e2x= v3[0] - v2[0];
+  e2y= v3[1] - v2[1];
+  e2z= v3[2] - v2[2];
   cx= e1y*e2z - e1z*e2y;
   cy= e1z*e2x - e1x*e2z;
   cz= e1x*e2y - e1y*e2x;
@@ -515,102 +432,136 @@ static void check_orientation( Triangle *tri, float *cuts, int step,
   }
 }
 
-static Triangle *march_tets( dch_Tess *tess, float *cuts, int step,
-			    float ival, int show_inside )
-/* This routine actually implements the marching tets algorithm */
+static void count_cuts( int start, int end, int worker, P_Void_ptr arg )
+/* This routine marks the edges in [start,end) which are cut by the
+ * isosurface, counting them.
+ */
 {
-  Triangle *triangle_list= (Triangle *)0, *runner;
-  dch_Vtx_list *vlist;
-
-  ger_debug("rand_isosurf: march_tets: generating isosurface at value %f",
-	    ival);
-
-  vlist= tess->vtx_list;
-  while (vlist) {
-    handle_one_tet( vlist->vtx, &triangle_list, ival );
-    vlist= vlist->next;
+  Iso_pass *pass= (Iso_pass *)arg;
+  Rand_tess *rt= pass->rt;
+  float *values= pass->values;
+  float val1, val2;
+  int e, ncuts= 0;
+
+  for (e=start; e<end; e++) {
+    val1= values[rt->edges[2*e]];
+    val2= values[rt->edges[2*e+1]];
+    if ( ((val1 >= pass->ival) && (val2 < pass->ival)) 
+	|| ((val2 >= pass->ival) && (val1 < pass->ival)) ) { /* cut this edge */
+      rt->edge_cuts[e]= 0;
+      ncuts++;
+    }
+    else rt->edge_cuts[e]= -1;
   }
 
-  runner= triangle_list;
-  while (runner) {
-    check_orientation( runner, cuts, step, show_inside );
-    runner= runner->next;
-  }
-  return( triangle_list );
+  pass->counts[worker]= ncuts;
 }
 
-static float get_value( P_Vlist *vlist, int i )
-/* This function returns the value associated with the given point */
+static void generate_cuts( int start, int end, int worker, P_Void_ptr arg )
+/* This routine numbers the cut edges in [start,end), starting from the
+ * worker's offset, and generates the cut point data for them.
+ */
 {
-  METHOD_RDY( vlist );
-  switch( current_vlist->type ) {
-  case P3D_CVVTX:
-  case P3D_CVNVTX:
-  case P3D_CVVVTX:
-    return( (*(vlist->v))( i ) );
-    break;
-  default:
-    ger_fatal(
-       "rand_isosurf: get_value: vertex type %d has no value to contour!",
-	      vlist->type);
-    break;
-  }
-  return(0.0); /* to please lint */
+  Iso_pass *pass= (Iso_pass *)arg;
+  Rand_tess *rt= pass->rt;
+  int e, id= pass->counts[worker];
+
+  for (e=start; e<end; e++)
+    if (rt->edge_cuts[e]>=0) {
+      rt->edge_cuts[e]= id;
+      interpolate_data( rt, pass->values, rt->edges[2*e], rt->edges[2*e+1],
+		       pass->ival, pass->cuts + rt->float_per_vtx*id );
+      id++;
+    }
 }
 
-static float *coord_access( float *dummy, int i, P_Void_ptr *user_hook )
-/* This routine is called by the Dirichlet tesselation package to get
- * coordinate data.  Note that the coordinate data is recopied, so we
- * can use static storage for it.
+static void march_tets( int start, int end, int worker, P_Void_ptr arg )
+/* This routine actually implements the marching tets algorithm, for
+ * the tetrahedra in [start,end).  The triangles are collected in a
+ * newly allocated array for the worker.
  */
 {
-  static float coords[3];
-
-  METHOD_RDY( current_vlist );
-  coords[0]= (*(current_vlist->x))(i);
-  coords[1]= (*(current_vlist->y))(i);
-  coords[2]= (*(current_vlist->z))(i);
+  Iso_pass *pass= (Iso_pass *)arg;
+  Rand_tess *rt= pass->rt;
+  float *values= pass->values;
+  Triangle *triangles= (Triangle *)0, *tri;
+  int *tet, *edges, *entry;
+  int t, i, tet_case, ntris= 0, max_tris= 0;
+
+  for (t=start; t<end; t++) {
+    tet= rt->tets + 4*t;
+    tet_case= 0;
+    for (i=0; i<4; i++)
+      if ( values[tet[i]] >= pass->ival ) tet_case |= (1<<i);
+
+    edges= rt->tet_edges + 6*t;
+    for (i=0; i<2; i++) {
+      entry= tet_cases[tet_case][i];
+      if (entry[0]<0) break;
+      if (ntris>=max_tris) {
+	max_tris= (max_tris>0) ? 2*max_tris : 1024;
+	if ( !(triangles= (Triangle *)realloc( triangles,
+					      max_tris*sizeof(Triangle) )) )
+	  ger_fatal("rand_isosurf: march_tets: unable to allocate %d bytes!",
+		    max_tris*sizeof(Triangle));
+      }
+      tri= triangles + ntris++;
+      tri->inside_pt= tet[entry[0]];
+      tri->outside_pt= tet[entry[1]];
+      tri->i1= rt->edge_cuts[ edges[ pair_edge[entry[2]][entry[3]] ] ];
+      tri->i2= rt->edge_cuts[ edges[ pair_edge[entry[4]][entry[5]] ] ];
+      tri->i3= rt->edge_cuts[ edges[ pair_edge[entry[6]][entry[7]] ] ];
+      if (tri->i1<0 || tri->i2<0 || tri->i3<0)
+	ger_fatal("rand_isosurf: march_tets: algorithm error; cut not found!");
+    }
+  }
 
-  /* Connect and fill out the hook data cell */
-  *user_hook= (P_Void_ptr)&hook_array[i];
-  hook_array[i].index= i;
-  hook_array[i].value= get_value( current_vlist, i );
-  hook_array[i].cut_links= (Cut_link *)0;
+  for (i=0; i<ntris; i++)
+    check_orientation( rt, triangles+i, pass->cuts, pass->show_inside );
 
-  return(coords);
+  pass->triangles[worker]= triangles;
+  pass->counts[worker]= ntris;
 }
 
-static int do_mesh( int vtxtype, float *cuts, Triangle *triangle_list )
-/* This routine actually emits the isosurface mesh */
+static int do_mesh( int vtxtype, float *cuts, int ncuts, Iso_pass *pass,
+		   int nworkers )
+/* This routine actually emits the isosurface mesh, joining the
+ * triangles found by all the workers in order.
+ */
 {
-  int retval;
-  int *vertices, *facet_lengths, *vptr, *flptr;
+  int retval= P3D_SUCCESS;
+  int *vertices, *facet_lengths, *vptr;
+  Triangle *tri;
+  int ntris= 0, worker, i;
 
   ger_debug("do_mesh:");
 
+  for (worker=0; worker<nworkers; worker++) ntris += pass->counts[worker];
+  if (ntris==0) return( retval );
+
   /* Allocate space for the vertex and facet length tables */
-  if ( !(facet_lengths= (int *)malloc( live_triangles*sizeof(int) )) )
+  if ( !(facet_lengths= (int *)malloc( ntris*sizeof(int) )) )
     ger_fatal("rand_isosurf: do_mesh: unable to allocate %d ints for lengths!",
-	      live_triangles);
-  if ( !(vertices= (int *)malloc( 3*live_triangles*sizeof(int) )) )
+	      ntris);
+  if ( !(vertices= (int *)malloc( 3*ntris*sizeof(int) )) )
     ger_fatal("rand_isosurf: do_mesh: unable to allocate %d ints for indices!",
-	      3*live_triangles);
+	      3*ntris);
 
   /* Transcribe the facet information */
   vptr= vertices;
-  flptr= facet_lengths;
-  while (triangle_list) {
-    *flptr++= 3;
-    *vptr++= triangle_list->i1;
-    *vptr++= triangle_list->i2;
-    *vptr++= triangle_list->i3;
-    triangle_list= triangle_list->next;
+  for (worker=0; worker<nworkers; worker++) {
+    tri= pass->triangles[worker];
+    for (i=0; i<pass->counts[worker]; i++) {
+      *vptr++= tri[i].i1;
+      *vptr++= tri[i].i2;
+      *vptr++= tri[i].i3;
+    }
   }
+  for (i=0; i<ntris; i++) facet_lengths[i]= 3;
 
-  /* Generate the mesh */
-  if (live_triangles>0)
-    retval= dp_mesh( vtxtype, P3D_RGB, cuts, live_cuts,
-		     vertices, facet_lengths, live_triangles );
+  /* Generate the mesh, decimating it if that has been requested */
+  retval= dec_mesh( po_create_cvlist( vtxtype, ncuts, cuts ),
+		    vertices, facet_lengths, ntris );
 
   /* Clean up */
   free( (P_Void_ptr)facet_lengths );
@@ -619,39 +570,83 @@ static int do_mesh( int vtxtype, float *cuts, Triangle *triangle_list )
   return( retval );
 }
 
-static void mark_outside_vtxs( dch_Tess *tess )
-/* This routine marks all tesselation vertices with at least one 'bogus'
- * point as deleted.  This amounts to marking all the Delaunay simplices
- * outside the convex hull, so they can be skipped as we accumulate
- * triangles.
+static int extract_isosurf( Rand_tess *rt, float *values, double ival,
+			   int show_inside )
+/* This routine generates the isosurface at the given value.  The edges
+ * and then the tetrahedra are split among the worker threads.  Since
+ * par_for splits a range the same way every time, each worker numbers
+ * the cuts in its share of the edges starting from the total found by
+ * the workers before it, and the workers' triangles are joined in
+ * order, the result is the same for any number of threads.
  */
 {
-  dch_Pt_list *plist;
-  dch_Vtx_list *vlist;
+  Iso_pass pass;
+  int nworkers, worker, ncuts, count;
+  int r_isosurf_flag;
+
+  ger_debug("rand_isosurf: extract_isosurf: generating isosurface at %f",
+	    ival);
+
+  nworkers= par_thread_count();
+  if ( !(pass.counts= (int *)malloc( nworkers*sizeof(int) ))
+       || !(pass.triangles= 
+	    (Triangle **)malloc( nworkers*sizeof(Triangle *) )) )
+    ger_fatal("rand_isosurf: extract_isosurf: unable to allocate %d bytes!",
+	      nworkers*(sizeof(int)+sizeof(Triangle *)));
+  pass.rt= rt;
+  pass.values= values;
+  pass.ival= ival;
+  pass.show_inside= show_inside;
+
+  /* Find the cut edges, and turn the counts into starting offsets */
+  for (worker=0; worker<nworkers; worker++) pass.counts[worker]= 0;
+  par_for( rt->nedges, MIN_EDGES_PER_THREAD, count_cuts, (P_Void_ptr)&pass );
+  ncuts= 0;
+  for (worker=0; worker<nworkers; worker++) {
+    count= pass.counts[worker];
+    pass.counts[worker]= ncuts;
+    ncuts += count;
+  }
 
-  ger_debug("rand_isosurf: mark_outside_vtxs:");
+  /* Allocate space for the table of cut vertices, and fill it out */
+  if ( !(pass.cuts = 
+	 ( float * ) malloc( (ncuts+1)*rt->float_per_vtx*sizeof( float ) ) ) )
+    ger_fatal("p3dgen: rand_isosurf: unable to allocate %d floats!",
+	      ncuts*rt->float_per_vtx);
+  par_for( rt->nedges, MIN_EDGES_PER_THREAD, generate_cuts,
+	  (P_Void_ptr)&pass );
 
-  plist= tess->bogus_pts; /* the list of outside forming points */
-  while (plist) {
-    vlist= plist->pt->verts; /* the vertices this point helps form */
-    while (vlist) {
-      vlist->vtx->deleted= 1;
-      vlist= vlist->next;
-    }
-    plist= plist->next;
+  /* Uncomment this to put a marker at every interpolated vertex */
+  /*
+    dp_polymarker( rt->out_vtxtype, P3D_RGB, pass.cuts, ncuts );
+  */
+
+  /* Run the marching tets algorithm, using the known cuts */
+  for (worker=0; worker<nworkers; worker++) {
+    pass.counts[worker]= 0;
+    pass.triangles[worker]= (Triangle *)0;
   }
+  par_for( rt->ntets, MIN_TETS_PER_THREAD, march_tets, (P_Void_ptr)&pass );
+
+  /* Generate the isosurface mesh */
+  r_isosurf_flag= do_mesh( rt->out_vtxtype, pass.cuts, ncuts, &pass,
+			  nworkers );
+
+  /* Clean up */
+  for (worker=0; worker<nworkers; worker++)
+    if (pass.triangles[worker]) free( (P_Void_ptr)pass.triangles[worker] );
+  free( (P_Void_ptr)pass.triangles );
+  free( (P_Void_ptr)pass.counts );
+  free( (P_Void_ptr)pass.cuts );
+
+  return( r_isosurf_flag );
 }
 
 int pg_rand_isosurf( P_Vlist *vlist, double ival, int show_inside )
 /* Creates a random isosurface from the points in data. */
 {
-  dch_Tess *tess;
-  Cut *cut_list;
-  float *cuts;
-  Triangle *triangle_list;
-  int in_vtxtype, out_vtxtype;
+  Rand_tess *rt;
   int r_isosurf_flag;
-  int float_per_vtx;
 
   ger_debug(
        "p3dgen: pg_rand_isosurf: \
@@ -664,79 +659,92 @@ adding random isosurface at %f from %d vertices",
     return(P3D_FAILURE);
   }
 
-  in_vtxtype= vlist->type;
-  /* calculates the necessary size for each vertex type */
-  switch( in_vtxtype ) {
-  case P3D_CVVTX:
-    out_vtxtype= P3D_CVTX;
-    float_per_vtx = CVTX_SZ;
-    break;
-  case P3D_CVNVTX:
-    out_vtxtype= P3D_CNVTX;
-    float_per_vtx = CNVTX_SZ;
-    break;
-  case P3D_CVVVTX:
-    out_vtxtype= P3D_CVVTX;
-    float_per_vtx= CVVTX_SZ;
-    break;
-  default:
-    ger_error(
-       "rand_isosurf: vertex type %d has no value to contour; call ignored.",
-	      (int)in_vtxtype);
-    return(P3D_FAILURE);
-    break;
+  if ( !(rt= create_rand_tess( vlist )) ) return(P3D_FAILURE);
+  r_isosurf_flag= extract_isosurf( rt, rt->values, ival, show_inside );
+  destroy_rand_tess( rt );
+
+  return( r_isosurf_flag );
+}
+
+int pg_rand_tess_create( P_Vlist *vlist )
+/* This routine tesselates the points of the given vertex list for use
+ * by pg_rand_isosurf_tess, returning a handle for the tesselation.  The
+ * coordinates, values, and any normals or second values are copied,
+ * so the vertex list need not be kept.  Zero is returned on failure.
+ */
+{
+  Rand_tess *rt;
+  int slot;
+
+  ger_debug("p3dgen: pg_rand_tess_create: tesselating %d vertices",
+	    vlist->length);
+
+  if ( !(rt= create_rand_tess( vlist )) ) return(0);
+
+  for (slot=0; slot<tess_slots; slot++) if (!tess_table[slot]) break;
+  if (slot==tess_slots) {
+    int i;
+    tess_slots= (tess_slots>0) ? 2*tess_slots : INITIAL_TESS_SLOTS;
+    if ( !(tess_table= (Rand_tess **)realloc( tess_table,
+					     tess_slots*sizeof(Rand_tess *) )) )
+      ger_fatal("pg_rand_tess_create: unable to allocate %d bytes!",
+		tess_slots*sizeof(Rand_tess *));
+    for (i=slot; i<tess_slots; i++) tess_table[i]= (Rand_tess *)0;
   }
+  tess_table[slot]= rt;
 
-  /* Allocate cells to be hung from the user_hook fields of the
-   * Dirichlet tesselation, one per data point.
-   */
-  if ( !(hook_array= (Hook_data *)malloc( vlist->length*sizeof(Hook_data) )) )
-    ger_fatal("p3dgen:pg_rand_isosurf: unable to allocate %d hook data cells!",
-	      vlist->length);
+  return( slot+1 );
+}
 
-  /* Calculate the Dirichlet tesselation, and mark all vertices outside
-   * the convex hull as deleted.
-   */
-  current_vlist= vlist;
-  tess= dch_create_dirichlet_tess( (float *)0, vlist->length, 3, 
-					 coord_access );
-  mark_outside_vtxs( tess );
+static Rand_tess *lookup_rand_tess( int tess, char *caller )
+/* This routine returns the tesselation with the given handle, or null
+ * after reporting an error if the handle is invalid.
+ */
+{
+  if (tess<1 || tess>tess_slots || !tess_table[tess-1]) {
+    ger_error("%s: invalid tesselation handle %d; call ignored.",
+	      caller, tess);
+    return( (Rand_tess *)0 );
+  }
+  return( tess_table[tess-1] );
+}
 
-  /* Generate the cut list */
-  cut_list= find_cut_edges( tess, ival );
+int pg_rand_isosurf_tess( int tess, float *values, double ival, 
+			 int show_inside )
+/* This routine creates a random isosurface from a tesselation made by
+ * pg_rand_tess_create.  If values is non-null it supplies a new value
+ * for each point, replacing those from the original vertex list.
+ */
+{
+  Rand_tess *rt;
 
-  /* Allocate space for the table of cut vertices */
-  if ( !(cuts = 
-	 ( float * ) malloc( live_cuts*float_per_vtx*sizeof( float ) ) ) )
-    ger_fatal("p3dgen: rand_zsurf: unable to allocate %d floats!",
-	      float_per_vtx-1);
+  ger_debug("p3dgen: pg_rand_isosurf_tess: isosurface at %f from handle %d",
+	    ival, tess);
 
-  /* Fill out the cut table, and in the process edit cut information
-   * into the tesselation data structure.
-   */
-  generate_cut_edges( cut_list, cuts, float_per_vtx, ival, in_vtxtype );
+  /* Quit if no gob is open */
+  if (!pg_gob_open()) {
+    ger_error("pg_rand_isosurf_tess: No gob is currently open; call ignored.");
+    return(P3D_FAILURE);
+  }
 
-  /* Uncomment this to put a marker at every interpolated vertex */
-  /*
-    dp_polymarker( out_vtxtype, P3D_RGB, cuts, live_cuts );
-  */
+  if ( !(rt= lookup_rand_tess( tess, "pg_rand_isosurf_tess" )) )
+    return(P3D_FAILURE);
 
-  /* Run the marching tets algorithm, using the known cuts (pointers
-   * to which have been plugged into tess)
-   */
-  triangle_list= march_tets( tess, cuts, float_per_vtx, ival, show_inside );
+  return( extract_isosurf( rt, values ? values : rt->values, ival,
+			  show_inside ) );
+}
 
-  /* Generate the isosurface mesh */
-  r_isosurf_flag= do_mesh( out_vtxtype, cuts, triangle_list );
+int pg_rand_tess_destroy( int tess )
+/* This routine frees a tesselation made by pg_rand_tess_create */
+{
+  Rand_tess *rt;
 
-  /* Clean up */
-  dch_destroy_tesselation(tess);
-  free( (P_Void_ptr)cuts );
-  free( (P_Void_ptr)hook_array );
-  destroy_cut_list( cut_list );
-  destroy_triangle_list( triangle_list );
-  destroy_cut_link_list( cut_link_list );
-  cut_link_list= (Cut_link *)0;
+  ger_debug("p3dgen: pg_rand_tess_destroy: destroying handle %d", tess);
 
-  return( r_isosurf_flag );
+  if ( !(rt= lookup_rand_tess( tess, "pg_rand_tess_destroy" )) )
+    return(P3D_FAILURE);
+  destroy_rand_tess( rt );
+  tess_table[tess-1]= (Rand_tess *)0;
+
+  return(P3D_SUCCESS);
 }
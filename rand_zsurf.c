@@ -15,7 +15,8 @@
  * implied warranty.
  *****************************************************************************/
 /*
-  This module creates a random zsurface using a dirichlet tesselation
+  This module creates a random zsurface using a Delaunay triangulation
+  of the (x,y) coordinates of the points.
 */
 
 #include <stdio.h>
@@ -24,111 +25,72 @@
 #endif
 #include "p3dgen.h"
 #include "pgen_objects.h" /* because we must access vertex list methods */
-#include "dirichlet.h"
+#include "delaunay2.h"
 #include "ge_error.h"
+#include "decimate.h"
 
 /* Notes-
+   The general Dirichlet tesselation package in dirichlet.c was once used
+   here, but it is much slower than the specialized planar triangulator.
 */
 
-static P_Vlist *current_vlist;
-
-static float *coord_access( float *dummy, int i, P_Void_ptr *usr_hook )
-/* This routine is called by the Dirichlet tesselation package to get
- * coordinate data.  Note that the coordinate data is recopied, so we
- * can use static storage for it.
- */
-{
-  static float coords[2];
-
-  METHOD_RDY( current_vlist );
-  coords[0]= (*(current_vlist->x))(i);
-  coords[1]= (*(current_vlist->y))(i);
-  *usr_hook= (P_Void_ptr)i; /* unethically but functionally stick an
-			       integer in the pointer slot */
-
-  return(coords);
-}
-
-static void mark_outside_vtxs( dch_Tess *tess )
-/* This routine marks all tesselation vertices with at least one 'bogus'
- * point as deleted.  This amounts to marking all the Delaunay simplices
- * outside the convex hull, so they can be skipped as we accumulate
- * vertices.
- */
+static double *get_coords( P_Vlist *vlist )
+/* This routine copies the x,y coordinates out of the vertex list */
 {
-  dch_Pt_list *plist;
-  dch_Vtx_list *vlist;
+  double *coords;
+  int i;
 
-  ger_debug("rand_zsurf: mark_outside_vtxs:");
+  if ( !(coords= (double *)malloc( 2*vlist->length*sizeof(double) )) )
+    ger_fatal("rand_zsurf: could not malloc %d doubles for coordinates!",
+	      2*vlist->length);
 
-  plist= tess->bogus_pts; /* the list of outside forming points */
-  while (plist) {
-    vlist= plist->pt->verts; /* the vertices this point helps form */
-    while (vlist) {
-      vlist->vtx->deleted= 1;
-      vlist= vlist->next;
-    }
-    plist= plist->next;
+  METHOD_RDY( vlist );
+  for (i=0; i<vlist->length; i++) {
+    coords[2*i]= (*(vlist->x))(i);
+    coords[2*i+1]= (*(vlist->y))(i);
   }
+
+  return(coords);
 }
 
-static int get_facets( int *facet_array, dch_Tess *tess, P_Vlist *vlist,
+static int get_facets( int *facet_array, int facet_cnt, P_Vlist *vlist,
 		       void (*testfun)(int *flag, float *x, float *y, 
 				       float *z, int *index) )
-/* This routine extracts the facet information from the tesselation */
+/* This routine applies the user test function to the triangles,
+ * packing the ones to be kept at the start of the array.  The number
+ * kept is returned.
+ */
 {
-  dch_Vtx_list *facets;
-  dch_Pt_list *corners;
+  int *facets= facet_array;
   int real_count= 0;
-  int test_flag, index;
+  int test_flag, index, i, j;
   float x, y, z;
   
   ger_debug("rand_zsurf: get_facets:");
-  
-  facets= tess->vtx_list;
-
-  if (testfun) while (facets) { 
-    if ( !facets->vtx->degenerate && !facets->vtx->deleted ) {
-
-      /* call the user test function for all three corners */
-      test_flag= 0;
-      corners= facets->vtx->forming_pts;
-      while (corners) {
-	index= (int)(corners->pt->user_hook); /* recover index */
-	x= corners->pt->coords[0];
-	y= corners->pt->coords[1];
-	METHOD_RDY( vlist );
-	z= (*(vlist->z))(index);
-	(*testfun)(&test_flag, &x, &y, &z, &index);
-	if (test_flag) break;
-	corners= corners->next;
-      }
-
-      /* we extract the facet if none of the tests said not to. */
-      if (!test_flag) {
-	real_count++;
-	corners= facets->vtx->forming_pts;
-	while (corners) { /* Guaranteed to be three corners per facet */
-	  *facet_array++= (int)(corners->pt->user_hook); /* recover index */
-	  corners= corners->next;
-	}
-      }
 
+  /* null test function case- don't exclude any facets */
+  if (!testfun) return(facet_cnt);
+
+  METHOD_RDY( vlist );
+  for (i=0; i<facet_cnt; i++) {
+
+    /* call the user test function for all three corners */
+    test_flag= 0;
+    for (j=0; j<3; j++) {
+      index= facets[j];
+      x= (*(vlist->x))(index);
+      y= (*(vlist->y))(index);
+      z= (*(vlist->z))(index);
+      (*testfun)(&test_flag, &x, &y, &z, &index);
+      if (test_flag) break;
     }
-    facets= facets->next;
-  }
 
-  /* null test function case- don't exclude any facets */
-  else while (facets) {
-    if ( !facets->vtx->degenerate && !facets->vtx->deleted ) {
+    /* we extract the facet if none of the tests said not to. */
+    if (!test_flag) {
+      for (j=0; j<3; j++) *facet_array++= facets[j];
       real_count++;
-      corners= facets->vtx->forming_pts;
-      while (corners) { /* Guaranteed to be three corners per facet */
-	*facet_array++= (int)(corners->pt->user_hook); /* recover index */
-	corners= corners->next;
-      }
     }
-    facets= facets->next;
+    facets += 3;
   }
 
   return( real_count );
@@ -165,11 +127,9 @@ int pg_rand_zsurf( P_Vlist *vlist,
 		  void (*testfun)(int *flag, float *x, float *y, float *z, 
 				  int *index) )
 {
-  int facet_cnt= 0, vtx_cnt= 0, i;
-  int *facet_array, *facet_len_array;
-  dch_Tess *tess;
-  dch_Vtx_list *facet_list;
-  dch_Pt_list *facet_pt_list;
+  int facet_cnt, i;
+  int *facet_array= (int *)0, *facet_len_array;
+  double *coords;
   int r_zsurf_flag= 0;
 
   ger_debug("p3dgen: pg_rand_zsurf: adding random zsurface of %d vertices",
@@ -181,45 +141,23 @@ int pg_rand_zsurf( P_Vlist *vlist,
     return(P3D_FAILURE);
   }
 
-  /* Create the tesselation */
-  current_vlist= vlist;
-  tess= dch_create_dirichlet_tess( (float *)0, vlist->length, 2,
-					 coord_access );
+  /* Triangulate the points.  There is one facet for each triangle. */
+  coords= get_coords( vlist );
+  facet_cnt= dl2_triangulate( coords, vlist->length, &facet_array );
+  free( (P_Void_ptr)coords );
 
-  /* Mark vertices outside the convex hull deleted, and count the 
-   * facets (one for each non-degenerate Delaunay simplex) 
+  /* Get the vertex index data.  The test function may cause some
+   * facets to be omitted.
    */
-  mark_outside_vtxs( tess );
-  facet_list= tess->vtx_list;
-  while (facet_list) {
-    if ( !facet_list->vtx->degenerate && !facet_list->vtx->deleted ) 
-      facet_cnt++;
-    facet_list= facet_list->next;
-  }
-  
-  /* Each facet is a triangle having 3 vertices */
-  vtx_cnt= 3*facet_cnt;
+  if (facet_cnt>0)
+    facet_cnt= get_facets( facet_array, facet_cnt, vlist, testfun );
 
-  /* Get memory */
-  if ( !(facet_array = (int *) malloc( vtx_cnt*sizeof( int ) ) ) )
-    ger_fatal("rand_zsurf: could not malloc %d ints for facet array!",vtx_cnt);
-  if ( !(facet_len_array = (int *) malloc( facet_cnt*sizeof( int ) )) )
+  /* Each facet is a triangle having 3 vertices */
+  if ( !(facet_len_array = (int *) malloc( (facet_cnt+1)*sizeof( int ) )) )
     ger_fatal("rand_zsurf: could not malloc %d ints for facet length array!",
 	      facet_cnt);
-
-  /* Each facet has three vertices */
   for (i=0; i<facet_cnt; i++) facet_len_array[i]= 3;
 
-  /* Get the vertex index data.  The test function may cause some
-   * facets to be omitted, but since they are all the same length
-   * and there can be no more than memory has been allocated for
-   * that is no problem.
-   */
-  facet_cnt= get_facets( facet_array, tess, vlist, testfun );
-
-  /* Clean up the tesselation */
-  dch_destroy_tesselation( tess );
-
   /* Make sure all the facets point upward */
   for (i=0; i<facet_cnt; i++)
     check_facet_orientation( vlist, facet_array+3*i );
@@ -227,11 +165,11 @@ int pg_rand_zsurf( P_Vlist *vlist,
   /* Create the primitive */
   pg_open("");
   if (facet_cnt>0)
-    r_zsurf_flag = pg_mesh( vlist, facet_array, facet_len_array, facet_cnt );
+    r_zsurf_flag = dec_mesh( vlist, facet_array, facet_len_array, facet_cnt );
   pg_close();
   
   /* Clean up local storage */
-  free( facet_array );
+  if (facet_array) free( facet_array );
   free( facet_len_array );
 
   return( r_zsurf_flag );
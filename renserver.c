@@ -0,0 +1,889 @@
+/****************************************************************************
+ * renserver.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This is a reference render server for the PVM renderer.  It accepts
+connections over the shm or socket transport, decodes the pvm_geom.h
+records each client sends, and replays them through the pg_ routines
+into an ordinary DrawP3D renderer, by default the painter.
+
+Each client's most recent frame is kept.  Once every connected client
+has sent a frame since the last one was drawn, the frames of all the
+clients are drawn together as one scene and every client is sent a
+frame sync.  The camera is the first one found among the clients'
+frames, and the scene is lit by a light at the camera position, since
+the protocol carries no lights.
+
+Geometry a client asks to have cached becomes a named GOB, which each
+frame's PVM3D_GEOM_USE records then add as a child under a transform.
+Frees are held until the client's next frame arrives, since the frame
+being replaced may still use the geometry.
+
+Usage:  renserver [-t transport] [-a address] [-r renderer]
+	          [-d device] [-o datastr] [-n frames] [-s] [-v]
+
+-t gives the transport, "socket" by default, and -a its address.  -r,
+-d and -o are passed to dp_init_ren.  The server exits after drawing
+-n frames if that is given, or with -s once the last client leaves.
+-v turns on debugging output.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "ge_error.h"
+#include "xport.h"
+#include "pvm_geom.h"
+
+#define SCENE_GOB "renserver-scene"
+#define LIGHT_GOB "renserver-lights"
+#define CAMERA_NAME "renserver-camera"
+
+typedef struct client_struct {
+  int connected;
+  char name[P3D_NAMELENGTH];
+  char *frame;          /* records of the most recent frame */
+  int nbytes;
+  int size;
+  int fresh;            /* a frame has come since the last draw */
+  int *geoms;           /* ids of cached geometry */
+  int ngeoms;
+  int geom_space;
+  int *doomed;          /* ids freed by the client, to go at next frame */
+  int ndoomed;
+  int doomed_space;
+} Client;
+
+static Client clients[XP_MAX_CLIENTS];
+
+/* Read position within the records being decoded */
+static char *here, *end;
+static int overrun;
+
+/* Attribute state of the records being decoded */
+static int backcull, have_backcull;
+static P_Color color;
+static int have_color;
+static int material, have_material;
+static float text_height;
+static int have_text_height;
+static int group_open;
+
+/* Camera of the frame being drawn */
+static int have_camera;
+static P_Point lookfrom;
+
+/* Scratch space for vertex colors and mesh triangles */
+static float *rgba= (float *)0;
+static int rgba_space= 0;
+static float *quant= (float *)0;
+static int quant_space= 0;
+static int *codes= (int *)0;
+static int code_space= 0;
+static int *tri_indices= (int *)0, *tri_lengths= (int *)0;
+static int tri_space= 0;
+
+static P_Color light_color= { P3D_RGB, 0.8, 0.8, 0.8, 1.0 };
+static P_Color ambient_color= { P3D_RGB, 0.3, 0.3, 0.3, 1.0 };
+
+static char *geom_name( Client *client, int id )
+/* This routine returns the name of the GOB holding cached geometry */
+{
+  static char name[P3D_NAMELENGTH];
+
+  sprintf(name, "renserver-geom-%d-%d", (int)(client-clients), id);
+  return name;
+}
+
+static void add_id( int **list, int *n, int *space, int id )
+{
+  if (*n == *space) {
+    *space= 2*(*space) + 64;
+    if ( !(*list= (int *)realloc(*list, (*space)*sizeof(int))) )
+      ger_fatal("renserver: unable to allocate %d ints!", *space);
+  }
+  (*list)[(*n)++]= id;
+}
+
+static void free_doomed_geometry( Client *client )
+/* This routine drops cached geometry which the client has freed */
+{
+  int i, j;
+
+  for (i=0; i<client->ndoomed; i++) {
+    for (j=0; j<client->ngeoms; j++)
+      if (client->geoms[j]==client->doomed[i]) {
+	pg_free(geom_name(client, client->doomed[i]));
+	client->geoms[j]= client->geoms[--client->ngeoms];
+	break;
+      }
+  }
+  client->ndoomed= 0;
+}
+
+static void free_all_geometry( Client *client )
+{
+  int i;
+
+  for (i=0; i<client->ngeoms; i++)
+    pg_free(geom_name(client, client->geoms[i]));
+  client->ngeoms= client->ndoomed= 0;
+}
+
+static void *get_bytes( int nbytes )
+/* This routine returns the next nbytes of the records */
+{
+  void *result= (void *)here;
+
+  if (nbytes<0 || end-here < nbytes) {
+    overrun= 1;
+    return (void *)0;
+  }
+  here += nbytes;
+  return result;
+}
+
+static int get_int( VOIDLIST )
+{
+  int *val= (int *)get_bytes(sizeof(int));
+  return ( val ? *val : 0 );
+}
+
+static int *get_ints( int n )
+{
+  return (int *)get_bytes(n*sizeof(int));
+}
+
+static float *get_floats( int n )
+{
+  return (float *)get_bytes(n*sizeof(float));
+}
+
+static char *get_str( VOIDLIST )
+/* This routine returns the next packed string */
+{
+  char *runner;
+
+  for (runner= here; runner<end; runner++)
+    if (!*runner) return (char *)get_bytes(xp_str_bytes(here));
+  overrun= 1;
+  return (char *)0;
+}
+
+static void add_transform( float *vals )
+/* This routine adds a transform_record to the open GOB */
+{
+  P_Transform trans;
+  int i;
+
+  for (i=0; i<12; i++) trans.d[i]= vals[i];
+  trans.d[12]= trans.d[13]= trans.d[14]= 0.0;
+  trans.d[15]= 1.0;
+  trans.type_front= allocate_trans_type();
+  trans.type_front->type= P3D_TRANSFORMATION;
+  trans.type_front->trans= (P_Void_ptr)duplicate_trans(&trans);
+  trans.type_front->generators[0]= 0;
+  trans.type_front->generators[1]= 0;
+  trans.type_front->generators[2]= 0;
+  trans.type_front->generators[3]= 0;
+  trans.type_front->next= NULL;
+  pg_transform(&trans);
+  destroy_trans_type(trans.type_front);
+}
+
+static P_Material *material_of_type( int type )
+{
+  switch (type) {
+  case P3D_DULL_MATERIAL: return p3d_dull_material;
+  case P3D_SHINY_MATERIAL: return p3d_shiny_material;
+  case P3D_METALLIC_MATERIAL: return p3d_metallic_material;
+  case P3D_MATTE_MATERIAL: return p3d_matte_material;
+  case P3D_ALUMINUM_MATERIAL: return p3d_aluminum_material;
+  default: return p3d_default_material;
+  }
+}
+
+static void close_group( VOIDLIST )
+/* This routine closes the GOB holding primitives which share the
+ * current attributes, before the attributes change.
+ */
+{
+  if (group_open) {
+    pg_close();
+    group_open= 0;
+  }
+}
+
+static void open_group( VOIDLIST )
+/* This routine opens a GOB carrying the current attributes, if one is
+ * not already open.
+ */
+{
+  if (!group_open) {
+    pg_open("");
+    if (have_backcull) pg_backcull(backcull);
+    if (have_color) pg_gobcolor(&color);
+    if (have_material) pg_gobmaterial(material_of_type(material));
+    if (have_text_height) pg_textheight(text_height);
+    group_open= 1;
+  }
+}
+
+static float *rgba_scratch( int length )
+{
+  if (4*length > rgba_space) {
+    rgba_space= 4*length;
+    if ( !(rgba= (float *)realloc(rgba, rgba_space*sizeof(float))) )
+      ger_fatal("renserver: unable to allocate %d floats!", rgba_space);
+  }
+  return rgba;
+}
+
+static P_Vlist *get_quantized_vlist( int length, int type )
+/* This routine decodes a quantized_vlist record.  The loops are kept
+ * simple, one vertex per pass, so that the compiler can vectorize them.
+ */
+{
+  float *frame= get_floats(6);
+  unsigned int *cwords= (unsigned int *)0, *nwords= (unsigned int *)0;
+  unsigned int *qwords;
+  float *coords, *normals= (float *)0;
+  int i;
+
+  if (type==P3D_CCVTX || type==P3D_CCNVTX)
+    cwords= (unsigned int *)get_ints(length);
+  if (type==P3D_CNVTX || type==P3D_CCNVTX)
+    nwords= (unsigned int *)get_ints((length+1)/2);
+  qwords= (unsigned int *)get_ints((3*length+1)/2);
+  if (overrun) return (P_Vlist *)0;
+
+  if (6*length > quant_space) {
+    quant_space= 6*length;
+    if ( !(quant= (float *)realloc(quant, quant_space*sizeof(float))) )
+      ger_fatal("renserver: unable to allocate %d floats!", quant_space);
+  }
+  coords= quant;
+
+  for (i=0; i<3*length; i++)
+    coords[i]= (float)((qwords[i>>1] >> 16*(i&1)) & 0xffff);
+  for (i=0; i<length; i++) {
+    coords[3*i]= frame[0] + coords[3*i]*frame[3];
+    coords[3*i+1]= frame[1] + coords[3*i+1]*frame[4];
+    coords[3*i+2]= frame[2] + coords[3*i+2]*frame[5];
+  }
+
+  if (nwords) {
+    normals= quant + 3*length;
+    for (i=0; i<length; i++) {
+      unsigned int oct= nwords[i>>1] >> 16*(i&1);
+      float x= (oct & 255)*(2.0/255.0) - 1.0;
+      float y= ((oct>>8) & 255)*(2.0/255.0) - 1.0;
+      float z= 1.0 - fabs(x) - fabs(y);
+      float norm;
+      if (z < 0.0) {
+	float tx= (1.0 - fabs(y)) * ((x >= 0.0) ? 1.0 : -1.0);
+	y= (1.0 - fabs(x)) * ((y >= 0.0) ? 1.0 : -1.0);
+	x= tx;
+      }
+      norm= 1.0/sqrt(x*x + y*y + z*z);
+      normals[3*i]= x*norm;
+      normals[3*i+1]= y*norm;
+      normals[3*i+2]= z*norm;
+    }
+  }
+
+  if (cwords) {
+    rgba_scratch(length);
+    for (i=0; i<4*length; i++)
+      rgba[i]= ((cwords[i>>2] >> 8*(i&3)) & 255)*(1.0/255.0);
+  }
+
+  return po_create_mvlist(type, length, coords, cwords ? rgba : (float *)0,
+			  normals);
+}
+
+static int get_indices( int nfacets, int nindices, int compressed,
+			int **lengths, int **indices )
+/* This routine finds the facet lengths and indices of a mesh_record,
+ * decoding them if they are compressed.
+ */
+{
+  unsigned int *words;
+  unsigned int val;
+  int nwords, nbytes, byte, shift, i, prev;
+
+  if (!compressed) {
+    *lengths= get_ints(nfacets);
+    *indices= get_ints(nindices);
+    return !overrun;
+  }
+
+  nwords= get_int();
+  words= (unsigned int *)get_ints(nwords);
+  if (overrun || nfacets<0 || nindices<0) return 0;
+  if (nfacets+nindices > code_space) {
+    code_space= nfacets+nindices;
+    if ( !(codes= (int *)realloc(codes, code_space*sizeof(int))) )
+      ger_fatal("renserver: unable to allocate %d ints!", code_space);
+  }
+
+  nbytes= 0;
+  prev= 0;
+  for (i=0; i<nfacets+nindices; i++) {
+    val= 0;
+    shift= 0;
+    do {
+      if (nbytes >= 4*nwords || shift > 28) {
+	overrun= 1;
+	return 0;
+      }
+      byte= (words[nbytes>>2] >> 8*(nbytes&3)) & 255;
+      nbytes++;
+      val |= (unsigned int)(byte & 127) << shift;
+      shift += 7;
+    } while (byte & 128);
+    if (i<nfacets) codes[i]= val;
+    else codes[i]= prev= prev + (int)((val >> 1) ^ (0U - (val & 1)));
+  }
+
+  *lengths= codes;
+  *indices= codes + nfacets;
+  return 1;
+}
+
+static P_Vlist *get_vlist( VOIDLIST )
+/* This routine decodes a vertex_list_record */
+{
+  int info= get_int();
+  int length= info>>8;
+  int type= info & 255;
+  float *rgb= (float *)0, *alpha= (float *)0, *normals= (float *)0;
+  float *coords;
+  int quantized= 0;
+  int i;
+
+  if (overrun) return (P_Vlist *)0;
+  if (type & PVM3D_QUANTIZED) {
+    type &= ~PVM3D_QUANTIZED;
+    quantized= 1;
+  }
+  if (type!=P3D_CVTX && type!=P3D_CCVTX && type!=P3D_CNVTX
+      && type!=P3D_CCNVTX) {
+    ger_error("renserver: got unknown vertex type %d", type);
+    overrun= 1;
+    return (P_Vlist *)0;
+  }
+  if (quantized) return get_quantized_vlist(length, type);
+
+  if (type==P3D_CCVTX || type==P3D_CCNVTX) {
+    rgb= get_floats(3*length);
+    alpha= get_floats(length);
+  }
+  if (type==P3D_CNVTX || type==P3D_CCNVTX) normals= get_floats(3*length);
+  coords= get_floats(3*length);
+  if (overrun) return (P_Vlist *)0;
+
+  if (rgb) {
+    rgba_scratch(length);
+    for (i=0; i<length; i++) {
+      rgba[4*i]= rgb[3*i];
+      rgba[4*i+1]= rgb[3*i+1];
+      rgba[4*i+2]= rgb[3*i+2];
+      rgba[4*i+3]= alpha[i];
+    }
+  }
+
+  return po_create_mvlist(type, length, coords, rgb ? rgba : (float *)0,
+			  normals);
+}
+
+static void strip_mesh_record( int compressed )
+/* This routine decodes a stripped mesh_record, splitting the strips
+ * back into triangles.
+ */
+{
+  int nstrips= get_int();
+  int nindices= get_int();
+  int *lengths, *indices;
+  P_Vlist *vlist;
+  int istrip, i, ntri= 0;
+  int *strip;
+
+  if (!get_indices(nstrips, nindices, compressed, &lengths, &indices)) 
+    return;
+  vlist= get_vlist();
+  if (overrun) return;
+  if (nindices > tri_space) {
+    tri_space= nindices;
+    if ( !(tri_indices= (int *)realloc(tri_indices, 3*tri_space*sizeof(int)))
+	 || !(tri_lengths= (int *)realloc(tri_lengths,tri_space*sizeof(int))) )
+      ger_fatal("renserver: unable to allocate %d ints!", 4*tri_space);
+  }
+
+  strip= indices;
+  for (istrip=0; istrip<nstrips; istrip++) {
+    for (i=0; i+2<lengths[istrip]; i++) {
+      if (strip[i]==strip[i+1] || strip[i+1]==strip[i+2]
+	  || strip[i]==strip[i+2]) continue;
+      tri_indices[3*ntri]= strip[(i%2) ? i+1 : i];
+      tri_indices[3*ntri+1]= strip[(i%2) ? i : i+1];
+      tri_indices[3*ntri+2]= strip[i+2];
+      tri_lengths[ntri++]= 3;
+    }
+    strip += lengths[istrip];
+  }
+
+  open_group();
+  pg_mesh(vlist, tri_indices, tri_lengths, ntri);
+}
+
+static void camera_record( VOIDLIST )
+{
+  float *vals= get_floats(16);
+  P_Point at;
+  P_Vector up;
+  P_Color bg;
+
+  if (overrun || have_camera) return;
+  lookfrom.x= vals[0];
+  lookfrom.y= vals[1];
+  lookfrom.z= vals[2];
+  at.x= vals[3];
+  at.y= vals[4];
+  at.z= vals[5];
+  up.x= vals[6];
+  up.y= vals[7];
+  up.z= vals[8];
+  pg_camera(CAMERA_NAME, &lookfrom, &at, &up, vals[9], vals[10], vals[11]);
+  bg.ctype= P3D_RGB;
+  bg.r= vals[12];
+  bg.g= vals[13];
+  bg.b= vals[14];
+  bg.a= vals[15];
+  pg_camera_background(CAMERA_NAME, &bg);
+  have_camera= 1;
+}
+
+static void decode_record( Client *client, int type )
+/* This routine replays one record into the open GOB */
+{
+  float *vals, *trans;
+  P_Vlist *vlist;
+  char *tstring;
+  int id;
+
+  switch (type) {
+  case PVM3D_BACKCULL:
+    close_group();
+    backcull= get_int();
+    have_backcull= 1;
+    break;
+  case PVM3D_COLOR:
+    if ((vals= get_floats(4))) {
+      close_group();
+      color.ctype= P3D_RGB;
+      color.r= vals[0];
+      color.g= vals[1];
+      color.b= vals[2];
+      color.a= vals[3];
+      have_color= 1;
+    }
+    break;
+  case PVM3D_MATERIAL:
+    close_group();
+    material= get_int();
+    have_material= 1;
+    break;
+  case PVM3D_TEXT_HEIGHT:
+    if ((vals= get_floats(1))) {
+      close_group();
+      text_height= vals[0];
+      have_text_height= 1;
+    }
+    break;
+  case PVM3D_SPHERE:
+  case PVM3D_CYLINDER:
+    if ((trans= get_floats(12))) {
+      open_group();
+      pg_open("");
+      add_transform(trans);
+      if (type==PVM3D_SPHERE) pg_sphere();
+      else pg_cylinder();
+      pg_close();
+    }
+    break;
+  case PVM3D_TORUS:
+    vals= get_floats(2);
+    if ((trans= get_floats(12))) {
+      open_group();
+      pg_open("");
+      add_transform(trans);
+      pg_torus(vals[0], vals[1]);
+      pg_close();
+    }
+    break;
+  case PVM3D_POLYMARKER:
+  case PVM3D_POLYLINE:
+  case PVM3D_POLYGON:
+  case PVM3D_TRISTRIP:
+  case PVM3D_BEZIER:
+    if ((vlist= get_vlist())) {
+      open_group();
+      switch (type) {
+      case PVM3D_POLYMARKER: pg_polymarker(vlist); break;
+      case PVM3D_POLYLINE: pg_polyline(vlist); break;
+      case PVM3D_POLYGON: pg_polygon(vlist); break;
+      case PVM3D_TRISTRIP: pg_tristrip(vlist); break;
+      case PVM3D_BEZIER: pg_bezier(vlist); break;
+      }
+    }
+    break;
+  case PVM3D_MESH:
+  case PVM3D_MESH | PVM3D_COMPRESSED:
+    {
+      int nfacets= get_int();
+      int nindices= get_int();
+      int *lengths, *indices;
+      if (get_indices(nfacets, nindices, type & PVM3D_COMPRESSED, 
+		      &lengths, &indices)
+	  && (vlist= get_vlist())) {
+	open_group();
+	pg_mesh(vlist, indices, lengths, nfacets);
+      }
+    }
+    break;
+  case PVM3D_STRIP_MESH:
+  case PVM3D_STRIP_MESH | PVM3D_COMPRESSED:
+    strip_mesh_record(type & PVM3D_COMPRESSED);
+    break;
+  case PVM3D_TEXT:
+    (void)get_int(); /* length, which get_str doesn't need */
+    tstring= get_str();
+    vals= get_floats(9);
+    if ((trans= get_floats(12))) {
+      P_Point loc;
+      P_Vector u, v;
+      loc.x= vals[0];
+      loc.y= vals[1];
+      loc.z= vals[2];
+      u.x= vals[3];
+      u.y= vals[4];
+      u.z= vals[5];
+      v.x= vals[6];
+      v.y= vals[7];
+      v.z= vals[8];
+      open_group();
+      pg_open("");
+      add_transform(trans);
+      pg_text(tstring, &loc, &u, &v);
+      pg_close();
+    }
+    break;
+  case PVM3D_CAMERA:
+    camera_record();
+    break;
+  case PVM3D_GEOM_USE:
+    id= get_int();
+    if ((trans= get_floats(12))) {
+      open_group();
+      pg_open("");
+      add_transform(trans);
+      pg_child(geom_name(client, id));
+      pg_close();
+    }
+    break;
+  default:
+    ger_error("renserver: client <%s> sent unknown record type %d",
+      	client->name, type);
+    overrun= 1;
+  }
+}
+
+static void decode_frame( Client *client )
+/* This routine replays the records of a client's frame into the
+ * open GOB.
+ */
+{
+  int type;
+
+  here= client->frame;
+  end= client->frame + client->nbytes;
+  overrun= 0;
+  have_backcull= have_color= have_material= have_text_height= 0;
+  group_open= 0;
+
+  while (here<end && !overrun) {
+    type= get_int();
+    if (type==PVM3D_ENDFRAME) {
+      close_group();
+      return;
+    }
+    decode_record(client, type);
+  }
+
+  close_group();
+  if (overrun)
+    ger_error("renserver: frame from client <%s> is truncated", client->name);
+}
+
+static void draw_scene( Xp_Server *server )
+/* This routine draws the latest frames of all the clients, and sends
+ * each client a frame sync.
+ */
+{
+  int i;
+
+  have_camera= 0;
+  pg_open(SCENE_GOB);
+  for (i=0; i<XP_MAX_CLIENTS; i++)
+    if (clients[i].connected && clients[i].nbytes)
+      decode_frame(clients+i);
+  pg_close();
+
+  if (have_camera) {
+    pg_open(LIGHT_GOB);
+    pg_light(&lookfrom, &light_color);
+    pg_ambient(&ambient_color);
+    pg_close();
+    pg_snap(SCENE_GOB, LIGHT_GOB, CAMERA_NAME);
+  }
+  else ger_error("renserver: no client has sent a camera; frame not drawn");
+
+  for (i=0; i<XP_MAX_CLIENTS; i++)
+    if (clients[i].connected) {
+      clients[i].fresh= 0;
+      (*(server->sync))(server, i);
+    }
+}
+
+static int scene_ready( VOIDLIST )
+/* This routine checks whether every client has sent a new frame */
+{
+  int i, nclients= 0;
+
+  for (i=0; i<XP_MAX_CLIENTS; i++)
+    if (clients[i].connected) {
+      if (!clients[i].fresh) return 0;
+      nclients++;
+    }
+  return ( nclients>0 );
+}
+
+static int nconnected( VOIDLIST )
+{
+  int i, n= 0;
+
+  for (i=0; i<XP_MAX_CLIENTS; i++) if (clients[i].connected) n++;
+  return n;
+}
+
+static void connect_client( Client *client, char *data, int nbytes )
+{
+  char *name;
+
+  here= data;
+  end= data + nbytes;
+  overrun= 0;
+  (void)get_int(); /* tid */
+  (void)get_int(); /* name length */
+  name= get_str();
+  if (overrun) name= "?";
+  strncpy(client->name, name, P3D_NAMELENGTH-1);
+  client->name[P3D_NAMELENGTH-1]= '\0';
+  free_all_geometry(client);
+  client->connected= 1;
+  client->nbytes= 0;
+  client->fresh= 0;
+  ger_debug("renserver: client <%s> connected", client->name);
+}
+
+static void disconnect_client( Client *client )
+{
+  if (client->connected)
+    ger_debug("renserver: client <%s> disconnected", client->name);
+  free_all_geometry(client);
+  client->connected= 0;
+  client->nbytes= 0;
+  client->fresh= 0;
+}
+
+static void store_geometry( Client *client, char *data, int nbytes )
+/* This routine handles a PVM3D_GEOMETRY message, defining the new
+ * geometry and noting what is freed.
+ */
+{
+  int type, id;
+
+  ger_debug("renserver: geometry from client <%s>, %d bytes", client->name,
+	    nbytes);
+  here= data;
+  end= data + nbytes;
+  overrun= 0;
+  (void)get_int(); /* name length */
+  (void)get_str();
+
+  while (here<end && !overrun) {
+    switch (get_int()) {
+    case PVM3D_GEOM_DEFINE:
+      id= get_int();
+      type= get_int();
+      if (overrun) break;
+      if ((type<PVM3D_POLYMARKER || type>PVM3D_MESH) 
+	  && (type & ~PVM3D_COMPRESSED)!=PVM3D_MESH
+	  && (type & ~PVM3D_COMPRESSED)!=PVM3D_STRIP_MESH) {
+	ger_error("renserver: client <%s> cannot cache record type %d",
+		  client->name, type);
+	return;
+      }
+      pg_open(geom_name(client, id));
+      /* The geometry's own GOB stands in for the attribute group */
+      have_backcull= have_color= have_material= have_text_height= 0;
+      group_open= 1;
+      decode_record(client, type);
+      group_open= 0;
+      pg_close();
+      add_id(&(client->geoms), &(client->ngeoms), &(client->geom_space), id);
+      break;
+    case PVM3D_GEOM_FREE:
+      id= get_int();
+      add_id(&(client->doomed), &(client->ndoomed), &(client->doomed_space),
+	     id);
+      break;
+    case PVM3D_ENDFRAME:
+      return;
+    default:
+      ger_error("renserver: bad GEOMETRY message from client <%s>",
+		client->name);
+      return;
+    }
+  }
+  if (overrun)
+    ger_error("renserver: GEOMETRY message from client <%s> is truncated",
+	      client->name);
+}
+
+static void store_frame( Client *client, char *data, int nbytes )
+/* This routine keeps the records of a DRAW message */
+{
+  int framenumber;
+
+  here= data;
+  end= data + nbytes;
+  overrun= 0;
+  (void)get_int(); /* name length */
+  (void)get_str();
+  framenumber= get_int();
+  if (overrun) {
+    ger_error("renserver: bad DRAW message from client <%s>", client->name);
+    return;
+  }
+  ger_debug("renserver: frame %d from client <%s>, %d bytes", framenumber,
+	    client->name, nbytes);
+
+  /* The frame being replaced was the last that could use these */
+  free_doomed_geometry(client);
+
+  nbytes= end - here;
+  if (nbytes > client->size) {
+    if ( !(client->frame= (char *)realloc(client->frame, nbytes)) )
+      ger_fatal("renserver: unable to allocate %d bytes!", nbytes);
+    client->size= nbytes;
+  }
+  memcpy(client->frame, here, nbytes);
+  client->nbytes= nbytes;
+  client->fresh= 1;
+}
+
+int main( int argc, char *argv[] )
+{
+  char *kind= "socket", *address= "";
+  char *renderer= "painter", *device= "", *datastr= "";
+  int max_frames= 0, single_session= 0;
+  int nframes= 0, seen_client= 0;
+  Xp_Server *server;
+  int client, msgtype, nbytes, c, i;
+  char *data;
+
+  while ((c= getopt(argc, argv, "t:a:r:d:o:n:sv")) != -1) {
+    switch (c) {
+    case 't': kind= optarg; break;
+    case 'a': address= optarg; break;
+    case 'r': renderer= optarg; break;
+    case 'd': device= optarg; break;
+    case 'o': datastr= optarg; break;
+    case 'n': max_frames= atoi(optarg); break;
+    case 's': single_session= 1; break;
+    case 'v': ger_toggledebug(); break;
+    default:
+      fprintf(stderr,
+"usage: %s [-t transport] [-a address] [-r renderer] [-d device]\n\
+       [-o datastr] [-n frames] [-s] [-v]\n", argv[0]);
+      exit(2);
+    }
+  }
+
+  for (i=0; i<XP_MAX_CLIENTS; i++) {
+    clients[i].connected= 0;
+    clients[i].frame= (char *)0;
+    clients[i].nbytes= clients[i].size= 0;
+    clients[i].fresh= 0;
+    clients[i].geoms= clients[i].doomed= (int *)0;
+    clients[i].ngeoms= clients[i].geom_space= 0;
+    clients[i].ndoomed= clients[i].doomed_space= 0;
+  }
+
+  if (pg_init_ren("renserver", renderer, device, datastr) != P3D_SUCCESS)
+    ger_fatal("renserver: cannot start the <%s> renderer", renderer);
+  if ( !(server= xp_create_server(kind, address)) )
+    ger_fatal("renserver: cannot start the <%s> transport", kind);
+
+  while (xp_recv(server, &client, &msgtype, &data, &nbytes)) {
+    switch (msgtype) {
+    case PVM3D_CONNECT:
+      connect_client(clients+client, data, nbytes);
+      seen_client= 1;
+      break;
+    case PVM3D_DRAW:
+      store_frame(clients+client, data, nbytes);
+      break;
+    case PVM3D_GEOMETRY:
+      store_geometry(clients+client, data, nbytes);
+      break;
+    case PVM3D_DISCONNECT:
+    case XP_HANGUP:
+      disconnect_client(clients+client);
+      break;
+    default:
+      ger_error("renserver: ignoring message of type %d from client <%s>",
+		msgtype, clients[client].name);
+    }
+
+    if (scene_ready()) {
+      draw_scene(server);
+      nframes++;
+      if (max_frames && nframes>=max_frames) break;
+    }
+    if (single_session && seen_client && !nconnected()) break;
+  }
+
+  (*(server->destroy))(server);
+  pg_shutdown();
+  return 0;
+}
@@ -0,0 +1,269 @@
+/****************************************************************************
+ * stripify.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module converts triangle meshes to triangle strips.  The
+triangles sharing each edge are found once by sorting the edges, so
+the cost is proportional to the size of the mesh.  Strips are grown
+greedily, always starting from the free triangle with the fewest free
+neighbors, which keeps the strips from stranding isolated triangles.
+Each candidate start is tried with all three of its edges leading, and
+the longest of the three strips is kept.
+
+Strips use the usual convention that triangle n of a strip is
+(v[n], v[n+1], v[n+2]) for even n and (v[n+1], v[n], v[n+2]) for odd
+n, so the orientation of every triangle is preserved.  Triangles which
+can't be joined to any others are returned as strips of length 3.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "p3dgen.h"
+#include "ge_error.h"
+#include "stripify.h"
+
+/* Record for one edge of one triangle */
+typedef struct edge_struct {
+  int lo, hi;  /* vertex indices, sorted */
+  int face;    /* owning triangle */
+  int side;    /* edge number within the triangle; 0, 1, or 2 */
+} Edge;
+
+static int *tris= (int *)0;
+static int ntris= 0;
+static int *neighbor= (int *)0;  /* 3 per triangle, -1 if none */
+static int *degree= (int *)0;    /* free neighbors of each triangle */
+static int *stamp= (int *)0;     /* -1 once triangle is in a strip */
+static int *next= (int *)0, *prev= (int *)0;
+static int bucket[4];
+static int *run= (int *)0;       /* triangles of the current strip */
+
+static int compare_edges( const void *p1, const void *p2 )
+/* This routine orders edges by their vertex indices */
+{
+  Edge *e1= (Edge *)p1, *e2= (Edge *)p2;
+
+  if (e1->lo != e2->lo) return( (e1->lo < e2->lo) ? -1 : 1 );
+  if (e1->hi != e2->hi) return( (e1->hi < e2->hi) ? -1 : 1 );
+  return( e1->face - e2->face );
+}
+
+static void find_neighbors( VOIDLIST )
+/* This routine links triangles which share an edge.  Only edges shared
+ * by exactly two consistently oriented triangles are linked.
+ */
+{
+  Edge *edges;
+  int nedges= 0;
+  int t, side, i, j;
+
+  if ( !(edges= (Edge *)malloc(3*ntris*sizeof(Edge))) )
+    ger_fatal("stripify: find_neighbors: unable to allocate %d bytes!",
+	      3*ntris*sizeof(Edge));
+
+  for (t=0; t<ntris; t++) {
+    int *v= tris + 3*t;
+    neighbor[3*t]= neighbor[3*t+1]= neighbor[3*t+2]= -1;
+    if (v[0]==v[1] || v[1]==v[2] || v[2]==v[0]) continue; /* degenerate */
+    for (side=0; side<3; side++) {
+      int a= v[side], b= v[(side+1)%3];
+      edges[nedges].lo= (a<b) ? a : b;
+      edges[nedges].hi= (a<b) ? b : a;
+      edges[nedges].face= t;
+      edges[nedges].side= side;
+      nedges++;
+    }
+  }
+
+  qsort( edges, nedges, sizeof(Edge), compare_edges );
+
+  for (i=0; i<nedges; i=j) {
+    for (j=i+1; j<nedges; j++)
+      if (edges[j].lo != edges[i].lo || edges[j].hi != edges[i].hi) break;
+    if (j-i == 2) {
+      Edge *e1= edges+i, *e2= edges+i+1;
+      if (tris[3*e1->face+e1->side] != tris[3*e2->face+e2->side]) {
+	neighbor[3*e1->face+e1->side]= e2->face;
+	neighbor[3*e2->face+e2->side]= e1->face;
+      }
+    }
+  }
+
+  free( (P_Void_ptr)edges );
+}
+
+static void bucket_insert( int t )
+{
+  int d= degree[t];
+  prev[t]= -1;
+  next[t]= bucket[d];
+  if (bucket[d]>=0) prev[bucket[d]]= t;
+  bucket[d]= t;
+}
+
+static void bucket_remove( int t )
+{
+  if (prev[t]>=0) next[prev[t]]= next[t];
+  else bucket[degree[t]]= next[t];
+  if (next[t]>=0) prev[next[t]]= prev[t];
+}
+
+static void use_triangle( int t )
+/* This routine removes a triangle from further consideration */
+{
+  int side;
+
+  bucket_remove(t);
+  stamp[t]= -1;
+  for (side=0; side<3; side++) {
+    int n= neighbor[3*t+side];
+    if (n>=0 && stamp[n]>=0) {
+      bucket_remove(n);
+      degree[n]--;
+      bucket_insert(n);
+    }
+  }
+}
+
+static int walk( int t, int lead, int trial, int *out )
+/* This routine grows a strip from triangle t, with edge 'lead' of t
+ * opposite the first vertex of the strip.  Triangles visited are
+ * stamped with 'trial' and listed in 'run';  if out is non-null the
+ * strip vertices are written there.  The number of triangles in the
+ * strip is returned.
+ */
+{
+  int p, q, count= 0;
+
+  p= tris[3*t+(lead+1)%3];
+  q= tris[3*t+(lead+2)%3];
+  if (out) {
+    *out++= tris[3*t+lead];
+    *out++= p;
+    *out++= q;
+  }
+  while (1) {
+    int side, n, r;
+    int *v= tris + 3*t;
+
+    stamp[t]= trial;
+    run[count++]= t;
+
+    /* The next triangle lies across edge (p,q) */
+    for (side=0; side<3; side++)
+      if ((v[side]==p && v[(side+1)%3]==q)
+	  || (v[side]==q && v[(side+1)%3]==p)) break;
+    n= neighbor[3*t+side];
+    if (n<0 || stamp[n]<0 || stamp[n]==trial) break;
+    v= tris + 3*n;
+    if (v[0]!=p && v[0]!=q) r= v[0];
+    else if (v[1]!=p && v[1]!=q) r= v[1];
+    else r= v[2];
+    if (out) *out++= r;
+    p= q;
+    q= r;
+    t= n;
+  }
+
+  return( count );
+}
+
+int strip_mesh( int *indices, int *facet_lengths, int nfacets,
+		int **strip_indices, int **strip_lengths )
+/* This routine converts a mesh of triangles to triangle strips.  The
+ * strips are returned in newly allocated arrays, with the vertex
+ * indices of all strips packed together in *strip_indices.  The return
+ * value is the number of strips.  Zero is returned and nothing is
+ * allocated if the mesh contains facets other than triangles, or if
+ * stripping is not worthwhile.
+ */
+{
+  int *out_index, *out_length, *here;
+  int nstrips= 0;
+  int trial= 0;
+  int i, t, side;
+
+  if (nfacets<2) return(0);
+  for (i=0; i<nfacets; i++) if (facet_lengths[i] != 3) return(0);
+
+  ger_debug("strip_mesh: %d triangles", nfacets);
+
+  tris= indices;
+  ntris= nfacets;
+  if ( !(neighbor= (int *)malloc(3*ntris*sizeof(int)))
+       || !(degree= (int *)malloc(ntris*sizeof(int)))
+       || !(stamp= (int *)malloc(ntris*sizeof(int)))
+       || !(next= (int *)malloc(ntris*sizeof(int)))
+       || !(prev= (int *)malloc(ntris*sizeof(int)))
+       || !(run= (int *)malloc(ntris*sizeof(int))) )
+    ger_fatal("strip_mesh: unable to allocate %d bytes!",
+	      8*ntris*sizeof(int));
+  if ( !(out_index= (int *)malloc(3*ntris*sizeof(int)))
+       || !(out_length= (int *)malloc(ntris*sizeof(int))) )
+    ger_fatal("strip_mesh: unable to allocate %d bytes!",
+	      4*ntris*sizeof(int));
+
+  find_neighbors();
+
+  for (i=0; i<4; i++) bucket[i]= -1;
+  for (t=ntris-1; t>=0; t--) {
+    degree[t]= 0;
+    for (side=0; side<3; side++) if (neighbor[3*t+side]>=0) degree[t]++;
+    stamp[t]= 0;
+    bucket_insert(t);
+  }
+
+  here= out_index;
+  while (1) {
+    int best_lead= 0, best_count= 0, count, lead;
+
+    /* Start from a free triangle with the fewest free neighbors */
+    for (i=0; i<4; i++) if (bucket[i]>=0) break;
+    if (i==4) break;
+    t= bucket[i];
+
+    for (lead=0; lead<3; lead++) {
+      count= walk( t, lead, ++trial, (int *)0 );
+      if (count>best_count) {
+	best_count= count;
+	best_lead= lead;
+      }
+    }
+    count= walk( t, best_lead, ++trial, here );
+    for (i=0; i<count; i++) use_triangle( run[i] );
+    out_length[nstrips++]= count+2;
+    here += count+2;
+  }
+
+  free( (P_Void_ptr)neighbor );
+  free( (P_Void_ptr)degree );
+  free( (P_Void_ptr)stamp );
+  free( (P_Void_ptr)next );
+  free( (P_Void_ptr)prev );
+  free( (P_Void_ptr)run );
+
+  ger_debug("strip_mesh: %d strips, %d indices", nstrips, here-out_index);
+
+  if (nstrips > STRIP_BENEFIT*nfacets) {
+    free( (P_Void_ptr)out_index );
+    free( (P_Void_ptr)out_length );
+    return(0);
+  }
+
+  *strip_indices= out_index;
+  *strip_lengths= out_length;
+  return(nstrips);
+}
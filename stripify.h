@@ -0,0 +1,33 @@
+/****************************************************************************
+ * stripify.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the triangle strip package
+stripify.c, which is used by renderers which can draw triangle strips.
+*/
+
+#ifndef INCL_STRIPIFY_H
+#define INCL_STRIPIFY_H
+
+/* Stripped meshes are used only if the number of strips (counting
+ * isolated triangles) is at most STRIP_BENEFIT times the triangle count.
+ */
+#define STRIP_BENEFIT 0.5
+
+extern int strip_mesh( int *indices, int *facet_lengths, int nfacets,
+		       int **strip_indices, int **strip_lengths );
+
+#endif /* INCL_STRIPIFY_H */
@@ -28,6 +28,7 @@
 #include "pgen_objects.h" /* because we must access vertex list methods */
 #include "ge_error.h"
 #include "spline.h"
+#include "decimate.h"
 
 /* Notes-
    -get rid of cast of norm_buf and mesh_buf types by unrolling inner loop
@@ -135,6 +136,73 @@ static void matrix_transform_affine(P_Transform* m,
   p_out->z= result[2];
 }
 
+static int emit_tube_mesh(int first, int last, int loop_length) {
+  /* Emit the tube segments from skeleton row first through last as a 
+   * single mesh, with the same triangles as the equivalent tristrips,
+   * so that the mesh can be decimated.
+   */
+  int nrows= last-first+2;
+  int nsegs= last-first+1;
+  int ntris= nsegs*(2*loop_length-2);
+  float* vdata;
+  int* indices;
+  int* lengths;
+  int* irunner;
+  int i, j, k, s0, s1, s2;
+  int retval;
+
+  if (!(vdata= (float*)malloc(6*nrows*loop_length*sizeof(float))))
+    ger_fatal("p3dgen: pg_spline_tube: unable to allocate %d floats!",
+	      6*nrows*loop_length);
+  if (!(indices= (int*)malloc(3*ntris*sizeof(int))))
+    ger_fatal("p3dgen: pg_spline_tube: unable to allocate %d ints!",
+	      3*ntris);
+  if (!(lengths= (int*)malloc(ntris*sizeof(int))))
+    ger_fatal("p3dgen: pg_spline_tube: unable to allocate %d ints!",
+	      ntris);
+
+  for (i=0; i<nrows*loop_length; i++) {
+    vdata[6*i]= mesh_buf[first*loop_length+i].x;
+    vdata[6*i+1]= mesh_buf[first*loop_length+i].y;
+    vdata[6*i+2]= mesh_buf[first*loop_length+i].z;
+    vdata[6*i+3]= norm_buf[first*loop_length+i].x;
+    vdata[6*i+4]= norm_buf[first*loop_length+i].y;
+    vdata[6*i+5]= norm_buf[first*loop_length+i].z;
+  }
+
+  /* Strip vertex k of segment i is on row i+1 for even k, row i for odd */
+  irunner= indices;
+  for (i=0; i<nsegs; i++)
+    for (k=0; k<2*loop_length-2; k++) {
+      j= k/2;
+      if (k%2) {
+	s0= i*loop_length + j;
+	s1= (i+1)*loop_length + j + 1;
+	s2= i*loop_length + j + 1;
+	*irunner++= s1;
+	*irunner++= s0;
+	*irunner++= s2;
+      }
+      else {
+	s0= (i+1)*loop_length + j;
+	s1= i*loop_length + j;
+	s2= (i+1)*loop_length + j + 1;
+	*irunner++= s0;
+	*irunner++= s1;
+	*irunner++= s2;
+      }
+    }
+  for (i=0; i<ntris; i++) lengths[i]= 3;
+
+  retval= dec_mesh(po_create_cvlist(P3D_CNVTX, nrows*loop_length, vdata),
+		   indices, lengths, ntris);
+
+  free(vdata);
+  free(indices);
+  free(lengths);
+  return retval;
+}
+
 static int emit_geom(int loop_length, int skel_length, P_Vlist* vlist) {
   int i, j;
   float* buf;
@@ -146,6 +214,8 @@ static int emit_geom(int loop_length, int skel_length, P_Vlist* vlist) {
   float* norm_runner;
   float capnorm[3];
   float* endcap_buf= NULL;
+  int decimate= dec_enabled();
+  int run_start= 0;
   
   if (pg_gob_open() == P3D_SUCCESS) {
     
@@ -245,6 +315,20 @@ static int emit_geom(int loop_length, int skel_length, P_Vlist* vlist) {
 	  }
 	}
 	
+	if (decimate) {
+	  /* Segments are gathered into one mesh per color */
+	  if (new_clr) {
+	    if (i>run_start) 
+	      prim_flag= emit_tube_mesh(run_start, i-1, loop_length);
+	    run_start= i;
+	    dp_close();
+	    dp_open("");
+	    dp_gobcolor(&current_clr);
+	  }
+	  if (prim_flag != P3D_SUCCESS) break;
+	  continue;
+	}
+
 	runner= buf;
 	for (j=0; j<loop_length; j++) {	
 	  norm_runner= (float*)(norm_buf+((i+1)*loop_length+j));
@@ -266,6 +350,9 @@ static int emit_geom(int loop_length, int skel_length, P_Vlist* vlist) {
 	if (prim_flag != P3D_SUCCESS) break;
       }
     
+    if (decimate && prim_flag==P3D_SUCCESS && skel_length>1)
+      prim_flag= emit_tube_mesh(run_start, skel_length-2, loop_length);
+
     if (prim_flag==P3D_SUCCESS) {
       /* emit final endcap */
       mesh_runner= (float*)(mesh_buf+(skel_length-1)*loop_length);
@@ -0,0 +1,132 @@
+/****************************************************************************
+ * vlist_view.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module provides bulk access to vertex list data.  The vlist
+generators record where each vertex component lives in the calling
+program's memory and how far apart successive vertices are;  this is
+the vlist's view.  po_vlist_copy uses the view to copy whole groups of
+components at once, reading the caller's arrays a vertex at a time in
+a single pass, and falls back on the accessor methods for components
+which have no view.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "ge_error.h"
+
+void po_clear_vlist_view( P_Vlist *vlist )
+/* This routine marks every component of a vlist as lacking a view */
+{
+  int c;
+
+  for (c=0; c<P3D_VCOMPONENTS; c++) {
+    vlist->view[c]= (float *)0;
+    vlist->view_stride[c]= 0;
+  }
+}
+
+void po_set_vlist_view( P_Vlist *vlist, int first, int count,
+		       float *base, int stride )
+/* This routine records that components first through first+count-1
+ * are found one after another at base, stride floats per vertex.
+ * A null base leaves the components without a view.
+ */
+{
+  int c;
+
+  for (c=0; c<count; c++) {
+    vlist->view[first+c]= ( base ? base+c : (float *)0 );
+    vlist->view_stride[first+c]= stride;
+  }
+}
+
+void po_vlist_copy( P_Vlist *vlist, int first, int count,
+		   float *out, int ostride )
+/* This routine copies components first through first+count-1 of every
+ * vertex of vlist into out, with successive vertices ostride floats
+ * apart.  count may be at most 4.
+ */
+{
+  float *src[4];
+  int stride[4];
+  int direct= 1;
+  int i, c;
+
+  if (count<1 || count>4 || first<0 || first+count>P3D_VCOMPONENTS) {
+    ger_error("po_vlist_copy: bad component range %d, %d", first, count);
+    return;
+  }
+
+  for (c=0; c<count; c++) {
+    src[c]= vlist->view[first+c];
+    stride[c]= vlist->view_stride[first+c];
+    if (!src[c]) direct= 0;
+  }
+
+  if (direct) {
+    /* The caller's layout may already be the one wanted */
+    int same= (count==ostride);
+    for (c=0; c<count; c++)
+      if (src[c] != src[0]+c || stride[c] != ostride) same= 0;
+    if (same) {
+      memcpy( out, src[0], vlist->length*count*sizeof(float) );
+      return;
+    }
+
+    switch (count) {
+    case 1:
+      for (i=0; i<vlist->length; i++) out[i*ostride]= src[0][i*stride[0]];
+      break;
+    case 3:
+      for (i=0; i<vlist->length; i++) {
+	out[0]= src[0][i*stride[0]];
+	out[1]= src[1][i*stride[1]];
+	out[2]= src[2][i*stride[2]];
+	out += ostride;
+      }
+      break;
+    default:
+      for (i=0; i<vlist->length; i++) {
+	for (c=0; c<count; c++) out[c]= src[c][i*stride[c]];
+	out += ostride;
+      }
+    }
+  }
+  else {
+    double (*fun[P3D_VCOMPONENTS])( int );
+    fun[P3D_VX]= vlist->x;
+    fun[P3D_VY]= vlist->y;
+    fun[P3D_VZ]= vlist->z;
+    fun[P3D_VNX]= vlist->nx;
+    fun[P3D_VNY]= vlist->ny;
+    fun[P3D_VNZ]= vlist->nz;
+    fun[P3D_VR]= vlist->r;
+    fun[P3D_VG]= vlist->g;
+    fun[P3D_VB]= vlist->b;
+    fun[P3D_VA]= vlist->a;
+    fun[P3D_VV]= vlist->v;
+    fun[P3D_VV2]= vlist->v2;
+    METHOD_RDY(vlist);
+    for (i=0; i<vlist->length; i++) {
+      for (c=0; c<count; c++) out[c]= (*(fun[first+c]))(i);
+      out += ostride;
+    }
+  }
+}
@@ -16,13 +16,28 @@
  *****************************************************************************/
 /* This module implements the VRML renderer */
 
+#ifdef USE_ZLIB
+#define _GNU_SOURCE /* for fopencookie */
+#endif
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <ctype.h>
 #include <math.h>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+#endif
 #include "ge_error.h"
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "assist.h"
+#include "bgwrite.h"
+#include "numfmt.h"
+#include "geomhash.h"
 #include "iv_ren_mthd.h"
 
 /* Notes-
@@ -31,11 +46,11 @@
 
 static char tab_buf[(MAX_TABS*TABSPACE)+1], i_string[40], *fname,
   viewer[30]="\"EXAMINE\" \"WALK\" \"FLY\" \"NONE\"",
-  *nogzip="nogzip", *walk="walk", *fly="fly", *none="none";
-static int gzip=P3D_TRUE, gob_type=LIGHTS, isFace=P3D_FALSE,
+  *nogzip="nogzip", *walk="walk", *fly="fly", *none="none",
+  *gzlevel="gzlevel=", *gzthread="gzthread";
+static int gzip=P3D_TRUE, gz_level= -1, gz_thread=P3D_FALSE, gob_type=LIGHTS, isFace=P3D_FALSE,
   useEmissive=P3D_FALSE, depth=0, newGob=P3D_TRUE, last_material=0,
-  curr_material[MAX_DEPTH], backcull[MAX_DEPTH], transforms[MAX_DEPTH],
-  geomIndex[MAX_DEPTH];
+  curr_material[MAX_DEPTH], backcull[MAX_DEPTH], transforms[MAX_DEPTH];
 static float text_height[MAX_DEPTH];
 static double ambi, spec, shin;
 static P_Vector y_axis = {0.0, 1.0, 0.0};
@@ -44,6 +59,54 @@ static P_Color default_clr = {P3D_RGB,1,1,1,1}, *last_color,
 static Def_list *d_list;
 static P_Transform_type *combo;
 
+/* Geometry already written to the current file is found in geom_table
+ * and written again as a USE of its first copy.  The key records the
+ * kind of node and any state which changes how it is written.
+ */
+#define GEOM_TABLE_SIZE 8192
+#define GEOM_POLYMARKER 0
+#define GEOM_POLYLINE 1
+#define GEOM_POLYGON 2
+#define GEOM_TRISTRIP 3
+#define GEOM_MESH 4
+#define GEOM_TORUS 5
+#define GEOM_TEXT 6
+typedef struct geom_key_struct {
+  int kind;
+  int backcull;
+  float text_height;
+} Geom_Key;
+static char *geom_names[]= { "PM", "PL", "PG", "TRI", "MESH", "TOR", "TEXT" };
+static Gh_Table *geom_table= NULL;
+static int live_renderers= 0; /* the last one to go frees geom_table */
+
+#ifdef USE_ZLIB
+/* When compressing, each frame is written to a stream whose write hook
+ * deflates it a chunk at a time, the compressed bytes going on to the
+ * file through bgw_fopen.  With gzthread, each chunk is deflated by a
+ * worker thread while the next one is being written.
+ */
+#define GZ_CHUNK_BYTES (1024*1024)
+typedef struct gz_stream_struct {
+  FILE *file;                   /* where the compressed bytes go */
+  char *fname;
+  z_stream zs;
+  char *chunk;                  /* chunk being filled */
+  size_t fill;
+  char *busy_chunk;             /* chunk being deflated */
+  size_t busy_size;
+  int busy_finish;              /* the busy chunk is the last one */
+  int error;
+  int threaded;
+#ifdef USE_PTHREADS
+  int busy;                     /* the worker has the busy chunk */
+  pthread_t worker;
+#endif
+  unsigned char out[GZ_CHUNK_BYTES/4];
+} Gz_Stream;
+static FILE *gz_fopen(char *path, int sync);
+#endif
+
 static const int torus_major_divisions=32;
 static const int torus_minor_divisions= 16;
 
@@ -59,11 +122,15 @@ static void set_index_string(int i);
 static char* remove_spaces_from_string( char* string );
 static Def_list *check_def(P_Gob *thisgob);
 static void del_def_list(void);
+static int def_geometry(P_Renderer *self, int kind, unsigned long hash,
+			P_Void_ptr data, int (*same)(void *, void *));
+static int same_text(void *data1, void *data2);
 static void change_curr_mat(int type);
 static void output_curr_appear(P_Renderer *self);
 static void output_curr_attrs(P_Renderer *self);
 static void set_curr_attrs(P_Renderer *self,P_Attrib_List *attr);
 static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist);
+static void output_triples(P_Renderer *self,float *vals,int n);
 static void get_oriented(P_Vector *up,P_Vector *view,P_Vector *start);
 static void print_matrix(float d[]);
 static P_Transform_type *get_translation(float d[],P_Transform_type *t_list);
@@ -252,6 +319,7 @@ static void ren_close( VOIDLIST )
   METHOD_IN
   ger_debug("vrml_ren_mthd: ren_close");
   RENDATA(self)->open= 0;
+  bgw_drain();
   METHOD_OUT
 }
 
@@ -284,17 +352,7 @@ static void ren_sphere(P_Void_ptr object_data, P_Transform *transform,
     fprintf(OUTFILE(self),"%sShape{#SPHERE\n",tab_buf);
     set_indent(INCREASE);
     fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
-
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE SPH%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF SPH%d Sphere{}\n",tab_buf,
-	      geomIndex[depth]);
-    }
-
-    geomIndex[depth]++;
+    fprintf(OUTFILE(self),"%sgeometry Sphere{}\n",tab_buf);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}\n",tab_buf);
   }
@@ -348,17 +406,7 @@ static void ren_cylinder(P_Void_ptr object_data, P_Transform *transform,
     fprintf(OUTFILE(self),"%schildren [Shape{\n",tab_buf);
     set_indent(INCREASE);
     fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
-
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE CYL%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF CYL%d Cylinder{height 1}\n",
-	      tab_buf,geomIndex[depth]);
-    }
-
-    geomIndex[depth]++;
+    fprintf(OUTFILE(self),"%sgeometry Cylinder{height 1}\n",tab_buf);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}]\n",tab_buf);
     set_indent(DECREASE);
@@ -434,7 +482,7 @@ static void output_torus_indices(P_Renderer *self)
 static void output_torus_mesh(P_Renderer *self, float major, float minor)
 {
   /* This routine calculates and outputs the coordinates and normals 
-   * to create a mesh in the shape of a torus. */
+   * to create a mesh in the shape of a torus, as an IndexedFaceSet node. */
 
   int torus_vertices= (torus_major_divisions+1) * (torus_minor_divisions+1);
   float theta= 0.0;
@@ -465,20 +513,7 @@ static void output_torus_mesh(P_Renderer *self, float major, float minor)
     phi += dp;
   }
   
-  fprintf(OUTFILE(self),"%sShape{#TORUS\n",tab_buf);
-  set_indent(INCREASE);
-  fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
-
-  if(geomIndex[depth] < geomIndex[depth-1]) {
-    fprintf(OUTFILE(self),"%sgeometry USE TOR%d\n",tab_buf,
-	    geomIndex[depth]);
-    
-  } else {
-    fprintf(OUTFILE(self),"%sgeometry DEF TOR%d IndexedFaceSet{\n",
-	    tab_buf,geomIndex[depth]);
-  }
-  
-  geomIndex[depth]++;
+  fprintf(OUTFILE(self),"IndexedFaceSet{\n");
   set_indent(INCREASE);
   fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
   fprintf(OUTFILE(self),"%scoordIndex[\n",tab_buf);
@@ -510,8 +545,6 @@ static void output_torus_mesh(P_Renderer *self, float major, float minor)
   fprintf(OUTFILE(self),"%s]}\n",tab_buf);
   set_indent(DECREASE);
   fprintf(OUTFILE(self),"%s}\n",tab_buf);
-  set_indent(DECREASE);
-  fprintf(OUTFILE(self),"%s}\n",tab_buf);
 }
 
 static void ren_torus(P_Void_ptr object_data, P_Transform *transform,
@@ -527,10 +560,16 @@ static void ren_torus(P_Void_ptr object_data, P_Transform *transform,
 
   if (RENDATA(self)->open) {
     ger_debug("vrml_ren_mthd: ren_torus");
-      
-
-    output_torus_mesh(self,torus->major,torus->minor);
 
+    fprintf(OUTFILE(self),"%sShape{#TORUS\n",tab_buf);
+    set_indent(INCREASE);
+    fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
+    if (def_geometry(self,GEOM_TORUS,
+		     gh_hash_torus(torus),
+		     (P_Void_ptr)torus,gh_same_torus))
+      output_torus_mesh(self,torus->major,torus->minor);
+    set_indent(DECREASE);
+    fprintf(OUTFILE(self),"%s}\n",tab_buf);
   }
 
   METHOD_OUT;
@@ -538,15 +577,8 @@ static void ren_torus(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_torus( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    ger_debug("vrml_ren_mthd: destroy_torus");
-    free( object_data );
-  }
-
-  METHOD_OUT;
+  ger_debug("vrml_ren_mthd: destroy_torus");
+  free( object_data );
 }
 
 static void map_color( P_Renderer *self, float val, 
@@ -645,55 +677,42 @@ static P_Cached_Vlist* cache_vlist( P_Renderer *self, P_Vlist *vlist )
 
   result->info_word= ((result->length) << 8) | (result->type & 255);
 
-  for (i=0; i<result->length; i++) {
-    result->coords[3*i]= (*(vlist->x))(i);
-    result->coords[3*i+1]= (*(vlist->y))(i);
-    result->coords[3*i+2]= (*(vlist->z))(i);
-    switch (vlist->type) {
-    case P3D_CVTX:
-      break;
-    case P3D_CNVTX:
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CCVTX:
-      result->colors[3*i]= (*(vlist->r))(i);
-      result->colors[3*i+1]= (*(vlist->g))(i);
-      result->colors[3*i+2]= (*(vlist->b))(i);
-      result->opacities[i]= (*(vlist->a))(i);
-      break;
-    case P3D_CCNVTX:
-      result->colors[3*i]= (*(vlist->r))(i);
-      result->colors[3*i+1]= (*(vlist->g))(i);
-      result->colors[3*i+2]= (*(vlist->b))(i);
-      result->opacities[i]= (*(vlist->a))(i);
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-    case P3D_CVVTX:
-    case P3D_CVVVTX:
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
-      result->colors[3*i]= r;
-      result->colors[3*i+1]= g;
-      result->colors[3*i+2]= b;
-      result->opacities[i]= a;
-      break;
-    case P3D_CVNVTX:
-      map_color( self, (*(vlist->v))(i), &r, &g, &b, &a );
+  po_vlist_copy(vlist, P3D_VX, 3, result->coords, 3);
+  switch (vlist->type) {
+  case P3D_CVTX:
+    break;
+  case P3D_CNVTX:
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CCVTX:
+    po_vlist_copy(vlist, P3D_VR, 3, result->colors, 3);
+    po_vlist_copy(vlist, P3D_VA, 1, result->opacities, 1);
+    break;
+  case P3D_CCNVTX:
+    po_vlist_copy(vlist, P3D_VR, 3, result->colors, 3);
+    po_vlist_copy(vlist, P3D_VA, 1, result->opacities, 1);
+    po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+  case P3D_CVVTX:
+  case P3D_CVVVTX:
+  case P3D_CVNVTX:
+    /* The values are mapped in place in the opacities */
+    po_vlist_copy(vlist, P3D_VV, 1, result->opacities, 1);
+    for (i=0; i<result->length; i++) {
+      map_color( self, result->opacities[i], &r, &g, &b, &a );
       result->colors[3*i]= r;
       result->colors[3*i+1]= g;
       result->colors[3*i+2]= b;
       result->opacities[i]= a;
-      result->normals[3*i]= (*(vlist->nx))(i);
-      result->normals[3*i+1]= (*(vlist->ny))(i);
-      result->normals[3*i+2]= (*(vlist->nz))(i);
-      break;
-      /* We've already checked that it is a known case */
     }
+    if (vlist->type==P3D_CVNVTX)
+      po_vlist_copy(vlist, P3D_VNX, 3, result->normals, 3);
+    break;
+    /* We've already checked that it is a known case */
   }
 
+  gh_hash_vlist(result);
+
   return( result );
 }
 
@@ -745,16 +764,14 @@ static P_Void_ptr def_bezier(char *name, P_Vlist *vlist)
 }
 
 static void destroy_polything( P_Void_ptr object_data )
+/* This routine frees a cached vertex list.  Like the other destroy
+ * methods it does so even if the renderer is closed, since dp_close_ren
+ * may come before the gobs holding the primitive, or the assist's
+ * cached text, are destroyed.
+ */
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    ger_debug("vrml_ren_mthd: destroy_polything");
-    free_cached_vlist( (P_Cached_Vlist*)object_data );
-  }
-
-  METHOD_OUT;
+  ger_debug("vrml_ren_mthd: destroy_polything");
+  free_cached_vlist( (P_Cached_Vlist*)object_data );
 }
 
 static void ren_polymarker(P_Void_ptr object_data, P_Transform *transform,
@@ -775,20 +792,14 @@ static void ren_polymarker(P_Void_ptr object_data, P_Transform *transform,
     useEmissive=P3D_TRUE;
     output_curr_appear(self);
 
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE PM%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF PM%d PointSet{\n",
-	      tab_buf,geomIndex[depth]);
+    if (def_geometry(self,GEOM_POLYMARKER,vlist->hash,object_data,
+		     gh_same_vlist)) {
+      fprintf(OUTFILE(self),"PointSet{\n");
+      set_indent(INCREASE);
+      output_vlist(self,vlist);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    
-    geomIndex[depth]++;
-    set_indent(INCREASE);
-    output_vlist(self,vlist);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}\n",tab_buf);   
   }
@@ -816,25 +827,19 @@ static void ren_polyline(P_Void_ptr object_data, P_Transform *transform,
     useEmissive=P3D_TRUE;
     output_curr_appear(self);
 
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE PL%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF PL%d IndexedLineSet{\n",
-	      tab_buf,geomIndex[depth]);
-    }
-    
-    geomIndex[depth]++;
-    set_indent(INCREASE);
-    fprintf(OUTFILE(self),"%scoordIndex[",tab_buf);
-    for(i=0;i<vlist->length;i++) {
-      fprintf(OUTFILE(self),"%d,",i);
+    if (def_geometry(self,GEOM_POLYLINE,vlist->hash,object_data,
+		     gh_same_vlist)) {
+      fprintf(OUTFILE(self),"IndexedLineSet{\n");
+      set_indent(INCREASE);
+      fprintf(OUTFILE(self),"%scoordIndex[",tab_buf);
+      for(i=0;i<vlist->length;i++) {
+	fprintf(OUTFILE(self),"%d,",i);
+      }
+      fprintf(OUTFILE(self),"]\n");
+      output_vlist(self,vlist);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    fprintf(OUTFILE(self),"]\n");
-    output_vlist(self,vlist);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}\n",tab_buf);
   }
@@ -861,31 +866,25 @@ static void ren_polygon(P_Void_ptr object_data, P_Transform *transform,
     set_indent(INCREASE);
     fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
 
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE PG%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF PG%d IndexedFaceSet{\n",
-	      tab_buf,geomIndex[depth]);
-    }
-    
-    geomIndex[depth]++;
-    set_indent(INCREASE);
+    if (def_geometry(self,GEOM_POLYGON,vlist->hash,object_data,
+		     gh_same_vlist)) {
+      fprintf(OUTFILE(self),"IndexedFaceSet{\n");
+      set_indent(INCREASE);
 
-    if(backcull[depth]==P3D_FALSE)
-      fprintf(OUTFILE(self),"%ssolid FALSE\n",tab_buf);
+      if(backcull[depth]==P3D_FALSE)
+	fprintf(OUTFILE(self),"%ssolid FALSE\n",tab_buf);
 
-    fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
-    fprintf(OUTFILE(self),"%scoordIndex[",tab_buf);
-    for(i=0;i<vlist->length;i++) {
-      fprintf(OUTFILE(self),"%d,",i);
+      fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
+      fprintf(OUTFILE(self),"%scoordIndex[",tab_buf);
+      for(i=0;i<vlist->length;i++) {
+	fprintf(OUTFILE(self),"%d,",i);
+      }
+      fprintf(OUTFILE(self),"]\n");
+      isFace=P3D_TRUE;
+      output_vlist(self,vlist);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    fprintf(OUTFILE(self),"]\n");
-    isFace=P3D_TRUE;
-    output_vlist(self,vlist);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}\n",tab_buf);
   }
@@ -912,46 +911,40 @@ static void ren_tristrip(P_Void_ptr object_data, P_Transform *transform,
     set_indent(INCREASE);
     fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
 
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE TRI%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF TRI%d IndexedFaceSet{\n",
-	      tab_buf,geomIndex[depth]);
-    }
-    
-    geomIndex[depth]++;
-    set_indent(INCREASE);
+    if (def_geometry(self,GEOM_TRISTRIP,vlist->hash,object_data,
+		     gh_same_vlist)) {
+      fprintf(OUTFILE(self),"IndexedFaceSet{\n");
+      set_indent(INCREASE);
 
-    if(backcull[depth]==P3D_FALSE)
-      fprintf(OUTFILE(self),"%ssolid FALSE\n",tab_buf);
+      if(backcull[depth]==P3D_FALSE)
+	fprintf(OUTFILE(self),"%ssolid FALSE\n",tab_buf);
 
-    fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
-    fprintf(OUTFILE(self),"%scoordIndex[\n",tab_buf);
-    set_indent(INCREASE);
-    for(i=0;i< vlist->length-2;i++) {
-      if(i % 2 == 0) {
-	if(i % 5==0) set_index_string(i);
-	else sprintf(i_string,"");
-
-	fprintf(OUTFILE(self),"%s%d,%d,%d,-1,%s\n",tab_buf,
-		i,i+1,i+2,i_string);
-      } else {
-	if(i % 5==0) set_index_string(i);
-	else sprintf(i_string,"");
+      fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
+      fprintf(OUTFILE(self),"%scoordIndex[\n",tab_buf);
+      set_indent(INCREASE);
+      for(i=0;i< vlist->length-2;i++) {
+	if(i % 2 == 0) {
+	  if(i % 5==0) set_index_string(i);
+	  else sprintf(i_string,"");
+
+	  fprintf(OUTFILE(self),"%s%d,%d,%d,-1,%s\n",tab_buf,
+		  i,i+1,i+2,i_string);
+	} else {
+	  if(i % 5==0) set_index_string(i);
+	  else sprintf(i_string,"");
 	
-	fprintf(OUTFILE(self),"%s%d,%d,%d,-1,%s\n",tab_buf,
-		i,i+2,i+1,i_string);
+	  fprintf(OUTFILE(self),"%s%d,%d,%d,-1,%s\n",tab_buf,
+		  i,i+2,i+1,i_string);
+	}
       }
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s]\n",tab_buf);
+      isFace=P3D_TRUE;
+      output_vlist(self,vlist);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
     set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s]\n",tab_buf);
-    isFace=P3D_TRUE;
-    output_vlist(self,vlist);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
-    set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}\n",tab_buf);
   }
 
@@ -983,6 +976,7 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
     }
 
     result->nfacets= nfacets;
+    result->stripped= 0;
     for (ifacet=0; ifacet<nfacets; ifacet++) {
       index_count += facet_lengths[ifacet];
       result->facet_lengths[ifacet]= facet_lengths[ifacet];
@@ -1000,6 +994,7 @@ static P_Void_ptr def_mesh(char *name, P_Vlist *vlist, int *indices,
 
     METHOD_RDY(vlist)
     result->cached_vlist= cache_vlist(self,vlist);
+    gh_hash_mesh(result);
 
     METHOD_OUT
     return( (P_Void_ptr)result );
@@ -1021,6 +1016,7 @@ static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
 
     P_Cached_Vlist *vlist = data->cached_vlist;
     int i,j,k,m;
+    Nf_Buffer nf;
 
     ger_debug("vrml_ren_mthd: ren_mesh");
      
@@ -1028,44 +1024,42 @@ static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
     set_indent(INCREASE);
     fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
 
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE MESH%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF MESH%d IndexedFaceSet{\n",
-	      tab_buf,geomIndex[depth]);
-    }
-    
-    geomIndex[depth]++;
-    set_indent(INCREASE);
+    if (def_geometry(self,GEOM_MESH,data->hash,object_data,gh_same_mesh)) {
+      fprintf(OUTFILE(self),"IndexedFaceSet{\n");
+      set_indent(INCREASE);
 
-    if(backcull[depth]==P3D_FALSE)
-      fprintf(OUTFILE(self),"%ssolid FALSE\n",tab_buf);
+      if(backcull[depth]==P3D_FALSE)
+	fprintf(OUTFILE(self),"%ssolid FALSE\n",tab_buf);
 
-    fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
-    fprintf(OUTFILE(self),"%scoordIndex[\n",tab_buf);
-    set_indent(INCREASE);
-    k=0; m=0;
-    for(i=0;i < data->nfacets && k < data->nindices;i++) {
-      fprintf(OUTFILE(self),"%s",tab_buf);
-      for(j=0;j < data->facet_lengths[i];j++) {
-	fprintf(OUTFILE(self),"%d, ",data->indices[k]);   
-	k++;
+      fprintf(OUTFILE(self),"%screaseAngle 0.5\n",tab_buf);
+      fprintf(OUTFILE(self),"%scoordIndex[\n",tab_buf);
+      set_indent(INCREASE);
+      k=0; m=0;
+      nf_start(&nf,OUTFILE(self));
+      for(i=0;i < data->nfacets && k < data->nindices;i++) {
+	nf_string(&nf,tab_buf);
+	for(j=0;j < data->facet_lengths[i];j++) {
+	  nf_int(&nf,data->indices[k]);
+	  nf_string(&nf,", ");
+	  k++;
+	}
+	nf_string(&nf,"-1,");
+	if(m % 5==0) {
+	  nf_char(&nf,'#');
+	  nf_int(&nf,m);
+	}
+	nf_char(&nf,'\n');
+	m++;
       }
-      if(m % 5==0) set_index_string(m);
-      else sprintf(i_string,"");
-
-      fprintf(OUTFILE(self),"-1,%s\n",i_string);
-      m++;
+      nf_flush(&nf);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s]\n",tab_buf);
+      isFace=P3D_TRUE;
+      output_vlist(self,vlist);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
     set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s]\n",tab_buf);
-    isFace=P3D_TRUE;
-    output_vlist(self,vlist);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
-    set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}\n",tab_buf);
   }
 
@@ -1074,19 +1068,12 @@ static void ren_mesh(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_mesh( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    P_Cached_Mesh* data= (P_Cached_Mesh*)object_data;
-    ger_debug("vrml_ren_mthd: destroy_mesh");
-    free( (P_Void_ptr)(data->facet_lengths) );
-    free( (P_Void_ptr)(data->indices) );
-    free_cached_vlist( (P_Cached_Vlist*)(data->cached_vlist) );
-    free( (P_Void_ptr)data );
-  }
-
-  METHOD_OUT;
+  P_Cached_Mesh* data= (P_Cached_Mesh*)object_data;
+  ger_debug("vrml_ren_mthd: destroy_mesh");
+  free( (P_Void_ptr)(data->facet_lengths) );
+  free( (P_Void_ptr)(data->indices) );
+  free_cached_vlist( (P_Cached_Vlist*)(data->cached_vlist) );
+  free( (P_Void_ptr)data );
 }
 
 static P_Void_ptr def_text( char *name, char *tstring, P_Point *location, 
@@ -1170,22 +1157,18 @@ static void ren_text(P_Void_ptr object_data, P_Transform *transform,
     set_indent(INCREASE);
     fprintf(OUTFILE(self),"%sappearance USE APP\n",tab_buf);
 
-    if(geomIndex[depth] < geomIndex[depth-1]) {
-      fprintf(OUTFILE(self),"%sgeometry USE TEXT%d\n",tab_buf,
-	      geomIndex[depth]);
-      
-    } else {
-      fprintf(OUTFILE(self),"%sgeometry DEF TEXT%d Text{\n",
-	      tab_buf,geomIndex[depth]);
+    if (def_geometry(self,GEOM_TEXT,
+		     gh_hash_bytes(GH_HASH_SEED,data->tstring,
+				   strlen(data->tstring)),
+		     object_data,same_text)) {
+      fprintf(OUTFILE(self),"Text{\n");
+      set_indent(INCREASE);
+      fprintf(OUTFILE(self),"%sfontStyle FontStyle{size %g}\n",
+	      tab_buf,text_height[depth]);
+      fprintf(OUTFILE(self),"%sstring \"%s\"\n",tab_buf,data->tstring);
+      set_indent(DECREASE);
+      fprintf(OUTFILE(self),"%s}\n",tab_buf);
     }
-    
-    geomIndex[depth]++;
-    set_indent(INCREASE);
-    fprintf(OUTFILE(self),"%sfontStyle FontStyle{size %g}\n",
-	    tab_buf,text_height[depth]);
-    fprintf(OUTFILE(self),"%sstring \"%s\"\n",tab_buf,data->tstring);
-    set_indent(DECREASE);
-    fprintf(OUTFILE(self),"%s}\n",tab_buf);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s}]\n",tab_buf);
     set_indent(DECREASE);
@@ -1197,17 +1180,10 @@ static void ren_text(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_text( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    P_Cached_Text* data= (P_Cached_Text*)object_data;
-    ger_debug("vrml_ren_mthd: destroy_text");
-    free( (P_Void_ptr)(data->tstring) );
-    free( (P_Void_ptr)data );
-  }
-
-  METHOD_OUT;
+  P_Cached_Text* data= (P_Cached_Text*)object_data;
+  ger_debug("vrml_ren_mthd: destroy_text");
+  free( (P_Void_ptr)(data->tstring) );
+  free( (P_Void_ptr)data );
 }
 
 static P_Void_ptr def_light( char *name, P_Point *location, P_Color *color )
@@ -1291,14 +1267,8 @@ static void traverse_light(P_Void_ptr object_data, P_Transform *transform,
 
 static void destroy_light( P_Void_ptr object_data )
 {
-  P_Renderer *self= (P_Renderer*)po_this;
-  METHOD_IN;
-
-  if (RENDATA(self)->open) {
-    ger_debug("vrml_ren_mthd: destroy_light");
-    free( object_data );
-  }
-  METHOD_OUT;
+  ger_debug("vrml_ren_mthd: destroy_light");
+  free( object_data );
 }
 
 static P_Void_ptr def_ambient( char *name, P_Color *color )
@@ -1388,11 +1358,11 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
   METHOD_IN
 
   if (RENDATA(self)->open) {
-    int i,doAPP,len;
+    int i,doAPP;
     P_Gob* thisgob= (P_Gob*)primdata;
     P_Gob_List* kidlist;
     Def_list *gob_def;
-    char remark[P3D_NAMELENGTH+50]="", *command;
+    char remark[P3D_NAMELENGTH+50]="";
 
     ger_debug("vrml_ren_mthd: ren_gob:");
 
@@ -1412,14 +1382,6 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
       backcull[depth] = backcull[depth-1];
       transforms[depth]=0;
 
-      if(newGob==P3D_TRUE) {
-	geomIndex[depth]=geomIndex[depth-1];
-	thisgob->geomIndex=geomIndex[depth];
-
-      } else {
-	geomIndex[depth]=thisgob->geomIndex;
-      }
-
       if(newGob==P3D_TRUE) {
 	if(strcmp(gob_def->use_name,"") == 0) sprintf(remark,"GOB");
 	else sprintf(remark,"GOB %s",gob_def->use_name);
@@ -1487,8 +1449,6 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
       
       set_indent(DECREASE);
       fprintf(OUTFILE(self), "%s}#End of %s\n",tab_buf,remark);
-
-      if(newGob==P3D_TRUE) geomIndex[depth-1]=geomIndex[depth];
       
       depth--;
     }
@@ -1508,8 +1468,10 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
 		  OUTFILE(self) );
 	}
 	
+#ifndef USE_ZLIB
 	if(gzip==P3D_TRUE) {
-	  len= (strlen(fname)*3)+15;
+	  char *command;
+	  int len= (strlen(fname)*3)+15;
 	  command= (char*)malloc((len)*sizeof(char));
 	  sprintf(command,"gzip %s; mv %s.gz %s",fname,fname,fname);
 	  if(system(command) != 0)
@@ -1517,8 +1479,10 @@ static void ren_gob( P_Void_ptr primdata, P_Transform *trans,
 		   command);
 	  free(command);
 	}
+#endif
 	
-	free(fname);
+	if (fname) free(fname);
+	fname= NULL;
 	del_def_list();
       }
       swap_gob_type();
@@ -1589,11 +1553,18 @@ static void ren_destroy( VOIDLIST )
   METHOD_IN
 
   ger_debug("vrml_ren_mthd: ren_destroy");
-  if (RENDATA(self)->open) ren_close();
-  RENDATA(self)->initialized= 0;
 
   METHOD_RDY(ASSIST(self));
   (*(ASSIST(self)->destroy_self))();
+  METHOD_RDY(self);
+
+  if (RENDATA(self)->open) ren_close();
+  bgw_drain();
+  RENDATA(self)->initialized= 0;
+  if (--live_renderers == 0 && geom_table) {
+    gh_destroy(geom_table);
+    geom_table= NULL;
+  }
 
   free( (P_Void_ptr)NAME(self) );
   free( (P_Void_ptr)RENDATA(self) );
@@ -1652,6 +1623,7 @@ P_Renderer *po_create_vrml_renderer( char *device, char *datastr )
   if ( !strcmp(device,"-") ) OUTFILE(self)= stdout;
   else OUTFILE(self)= NULL;
   FILENUM(self) = 0;
+  SYNC(self)= contains(datastr,"fsync");
  
   ASSIST(self)= po_create_assist(self);
 
@@ -1738,10 +1710,10 @@ P_Renderer *po_create_vrml_renderer( char *device, char *datastr )
   text_height[0] = 1;
   backcull[0] = P3D_FALSE;
   transforms[0] = 0;
-  geomIndex[0]=0;
   read_options(datastr);
 
   RENDATA(self)->initialized= 1;
+  live_renderers++;
   
   return( self );
 }
@@ -1770,9 +1742,25 @@ static int contains(char *string, char *substring)
 static void read_options(char *datastr)
      /* Sets gzip and viewer options based on datastr */
 {
+  char *runner;
+
   if(contains(datastr,nogzip) == P3D_TRUE) gzip=P3D_FALSE;
   else gzip=P3D_TRUE;
 
+  /* gzlevel=N sets the compression level, 0 through 9 */
+  gz_level= -1;
+  if ((runner= strstr(datastr,gzlevel)) != NULL) {
+    char *tail;
+    long level;
+    runner += strlen(gzlevel);
+    level= strtol(runner, &tail, 10);
+    if (tail==runner || level<0 || level>9)
+      ger_error("vrml_ren_mthd: bad compression level in <%s>; using default",
+		datastr);
+    else gz_level= (int)level;
+  }
+  gz_thread= contains(datastr,gzthread);
+
   if(contains(datastr,walk) == P3D_TRUE)
     sprintf(viewer,"\"WALK\" \"EXAMINE\" \"FLY\" \"NONE\"");
   else if(contains(datastr,fly) == P3D_TRUE)
@@ -1783,6 +1771,179 @@ static void read_options(char *datastr)
     sprintf(viewer,"\"EXAMINE\" \"WALK\" \"FLY\" \"NONE\"");
 }
 
+#ifdef USE_ZLIB
+static void deflate_chunk(Gz_Stream *gs, char *data, size_t size, int finish)
+{
+  /* This routine deflates a chunk and writes out what deflate produces.
+   * It may run in a worker thread, so it only records any error.
+   */
+  size_t n;
+  int flush= (finish) ? Z_FINISH : Z_NO_FLUSH;
+
+  if (gs->error) return;
+  gs->zs.next_in= (Bytef *)data;
+  gs->zs.avail_in= (uInt)size;
+  do {
+    gs->zs.next_out= gs->out;
+    gs->zs.avail_out= sizeof(gs->out);
+    if (deflate(&(gs->zs),flush) == Z_STREAM_ERROR) {
+      gs->error= EIO;
+      return;
+    }
+    n= sizeof(gs->out) - gs->zs.avail_out;
+    if (n && fwrite(gs->out,1,n,gs->file) != n) {
+      gs->error= errno ? errno : EIO;
+      return;
+    }
+  } while (gs->zs.avail_out == 0);
+}
+
+#ifdef USE_PTHREADS
+static void *deflate_worker(void *arg)
+{
+  Gz_Stream *gs= (Gz_Stream *)arg;
+  deflate_chunk(gs,gs->busy_chunk,gs->busy_size,gs->busy_finish);
+  return NULL;
+}
+#endif
+
+static void gz_wait(Gz_Stream *gs)
+{
+  /* This routine waits for the worker to finish the busy chunk */
+#ifdef USE_PTHREADS
+  if (gs->busy) {
+    pthread_join(gs->worker,NULL);
+    gs->busy= 0;
+  }
+#endif
+}
+
+static void gz_hand_off(Gz_Stream *gs, int finish)
+{
+  /* This routine deflates the chunk just filled, in the worker thread
+   * if there is one, and starts filling the other chunk.
+   */
+  char *tmp;
+
+  gz_wait(gs);
+  tmp= gs->busy_chunk;
+  gs->busy_chunk= gs->chunk;
+  gs->busy_size= gs->fill;
+  gs->busy_finish= finish;
+  gs->chunk= tmp;
+  gs->fill= 0;
+
+#ifdef USE_PTHREADS
+  if (gs->threaded) {
+    if (pthread_create(&(gs->worker),NULL,deflate_worker,gs) == 0) {
+      gs->busy= 1;
+      return;
+    }
+    ger_error("vrml_ren_mthd: gz_hand_off: cannot start worker thread");
+    gs->threaded= 0;
+  }
+#endif
+
+  deflate_chunk(gs,gs->busy_chunk,gs->busy_size,gs->busy_finish);
+}
+
+static ssize_t gz_write(void *cookie, const char *buf, size_t size)
+{
+  /* This is the stdio write hook for compressed files */
+  Gz_Stream *gs= (Gz_Stream *)cookie;
+  size_t left= size, n;
+
+  if (gs->error) {
+    errno= gs->error;
+    return(-1);
+  }
+  while (left) {
+    n= GZ_CHUNK_BYTES - gs->fill;
+    if (n>left) n= left;
+    memcpy(gs->chunk + gs->fill, buf, n);
+    gs->fill += n;
+    buf += n;
+    left -= n;
+    if (gs->fill == GZ_CHUNK_BYTES) gz_hand_off(gs,0);
+  }
+  return( (ssize_t)size );
+}
+
+static int gz_close(void *cookie)
+{
+  /* This is the stdio close hook for compressed files */
+  Gz_Stream *gs= (Gz_Stream *)cookie;
+  int error;
+
+  gz_hand_off(gs,1);
+  gz_wait(gs);
+  deflateEnd(&(gs->zs));
+  error= gs->error;
+  if (fclose(gs->file) == EOF && !error) error= errno ? errno : EIO;
+
+  free(gs->chunk);
+  free(gs->busy_chunk);
+  free(gs->fname);
+  free(gs);
+  if (error) {
+    errno= error;
+    return(EOF);
+  }
+  return(0);
+}
+
+static FILE *gz_fopen(char *path, int sync)
+{
+  /* This routine opens a stream which writes path gzipped */
+  cookie_io_functions_t hooks;
+  Gz_Stream *gs;
+  FILE *fp;
+
+  if ( !(gs= (Gz_Stream *)malloc(sizeof(Gz_Stream)))
+       || !(gs->chunk= (char *)malloc(GZ_CHUNK_BYTES))
+       || !(gs->busy_chunk= (char *)malloc(GZ_CHUNK_BYTES))
+       || !(gs->fname= strdup(path)) )
+    ger_fatal("vrml_ren_mthd: gz_fopen: unable to allocate %d bytes!",
+	      sizeof(Gz_Stream)+2*GZ_CHUNK_BYTES);
+  gs->fill= 0;
+  gs->busy_size= 0;
+  gs->busy_finish= 0;
+  gs->error= 0;
+  gs->threaded= gz_thread;
+#ifdef USE_PTHREADS
+  gs->busy= 0;
+#endif
+
+  gs->zs.zalloc= Z_NULL;
+  gs->zs.zfree= Z_NULL;
+  gs->zs.opaque= Z_NULL;
+  /* 16 more window bits asks for a gzip header and trailer */
+  if (deflateInit2(&(gs->zs),
+		   (gz_level>=0) ? gz_level : Z_DEFAULT_COMPRESSION,
+		   Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    ger_fatal("vrml_ren_mthd: gz_fopen: cannot start compressing <%s>",
+	      path);
+
+  if ( !(gs->file= bgw_fopen(path,"wb",sync)) ) {
+    deflateEnd(&(gs->zs));
+    free(gs->chunk);
+    free(gs->busy_chunk);
+    free(gs->fname);
+    free(gs);
+    return( (FILE *)0 );
+  }
+
+  hooks.read= NULL;
+  hooks.write= gz_write;
+  hooks.seek= NULL;
+  hooks.close= gz_close;
+  if ( !(fp= fopencookie(gs, "w", hooks)) )
+    ger_fatal("vrml_ren_mthd: gz_fopen: unable to create a stream for <%s>",
+	      path);
+  return(fp);
+}
+#endif
+
 static char* generate_fname()
 {
   /* This routine generates numbered fnames */
@@ -1861,7 +2022,17 @@ static void renfile_startup(void)
 
   if(OUTFILE(self) != stdout) {
     fname= generate_fname();
-    if ( !(OUTFILE(self)= fopen(fname,"w")) ) {
+#ifdef USE_ZLIB
+    if (gzip==P3D_TRUE) {
+      if ( !(OUTFILE(self)= gz_fopen(fname,SYNC(self))) ) {
+	perror("set_camera");
+	ger_fatal("set_camera: Error opening file <%s> for writing.",
+		  fname);
+      }
+    }
+    else
+#endif
+    if ( !(OUTFILE(self)= bgw_fopen(fname,"w",SYNC(self))) ) {
       perror("set_camera");
       ger_fatal("set_camera: Error opening file <%s> for writing.",
 		fname);
@@ -1871,7 +2042,8 @@ static void renfile_startup(void)
   
   last_material=P3D_DEFAULT_MATERIAL;
   last_color=&default_clr;
-  geomIndex[0]=0;
+  if (geom_table) gh_clear(geom_table);
+  else geom_table= gh_create(GEOM_TABLE_SIZE);
 
   fprintf(OUTFILE(self),"%s#VRML V2.0 utf8\n\n\n",tab_buf);
   fprintf(OUTFILE(self),"%sGroup{children[\n",tab_buf);
@@ -1975,6 +2147,48 @@ static void del_def_list(void)
     free(d_list);
     d_list = temp_list;
   }
+
+  if (geom_table) gh_clear(geom_table);
+}
+
+static int def_geometry(P_Renderer *self, int kind, unsigned long hash,
+			P_Void_ptr data, int (*same)(void *, void *))
+{
+  /* This routine starts the geometry field of a Shape.  If the same
+   * geometry has already been written to this file, it writes a USE
+   * of that copy and returns P3D_FALSE.  Otherwise it writes a DEF if
+   * there is room in the table to remember it, and returns P3D_TRUE;
+   * the caller must then write the geometry node on the same line. */
+
+  Geom_Key key;
+  int id;
+
+  memset(&key,0,sizeof(key));
+  key.kind= kind;
+  if (kind==GEOM_POLYGON || kind==GEOM_TRISTRIP || kind==GEOM_MESH)
+    key.backcull= backcull[depth];
+  if (kind==GEOM_TEXT) key.text_height= text_height[depth];
+
+  if ((id= gh_find(geom_table,hash,&key,sizeof(key),data,same)) >= 0) {
+    fprintf(OUTFILE(self),"%sgeometry USE %s%d\n",tab_buf,
+	    geom_names[kind],id);
+    return P3D_FALSE;
+  }
+
+  if ((id= gh_add(geom_table,hash,&key,sizeof(key),data)) >= 0)
+    fprintf(OUTFILE(self),"%sgeometry DEF %s%d ",tab_buf,
+	    geom_names[kind],id);
+  else fprintf(OUTFILE(self),"%sgeometry ",tab_buf);
+  return P3D_TRUE;
+}
+
+static int same_text(void *data1, void *data2)
+{
+  /* This routine compares the strings of two cached texts;  the
+   * position is not part of the Text node. */
+
+  return !strcmp(((P_Cached_Text*)data1)->tstring,
+		 ((P_Cached_Text*)data2)->tstring);
 }
 
 static void change_curr_mat(int type)
@@ -2105,20 +2319,13 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
   /* This routine outputs all the information stored in a cached
    * vertex list. */
 
-  int do_color = P3D_FALSE,do_normal = P3D_FALSE,i = 0;
+  int do_color = P3D_FALSE,do_normal = P3D_FALSE;
 
   ger_debug("vrml_ren_mthd: output_vlist");
 
   fprintf(OUTFILE(self),"%scoord Coordinate{point[\n",tab_buf);
   set_indent(INCREASE);
-  for(i=0;i < vlist->length;i++) {
-    if(i % 5==0) set_index_string(i);
-    else sprintf(i_string,"");
-
-    fprintf(OUTFILE(self),"%s%g %g %g,%s\n",tab_buf,
-	    vlist->coords[i*3],vlist->coords[(i*3)+1],
-	    vlist->coords[(i*3)+2],i_string);
-  }
+  output_triples(self,vlist->coords,vlist->length);
   set_indent(DECREASE);
   fprintf(OUTFILE(self),"%s]} \n",tab_buf);
 
@@ -2140,14 +2347,7 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
   if(do_color == P3D_TRUE) {
     fprintf(OUTFILE(self),"%scolor Color{color[\n",tab_buf);
     set_indent(INCREASE);
-    for(i=0;i < vlist->length;i++) {
-      if(i % 5==0) set_index_string(i);
-      else sprintf(i_string,"");
-      
-      fprintf(OUTFILE(self),"%s%g %g %g,%s\n",tab_buf,
-	      vlist->colors[i*3],vlist->colors[(i*3)+1],
-	      vlist->colors[(i*3)+2],i_string);
-    }
+    output_triples(self,vlist->colors,vlist->length);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s]}\n",tab_buf);
   }
@@ -2155,14 +2355,7 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
   if(do_normal == P3D_TRUE && isFace == P3D_TRUE) {
     fprintf(OUTFILE(self),"%snormal Normal{vector[\n",tab_buf);
     set_indent(INCREASE);
-    for(i=0;i < vlist->length;i++) {
-      if(i % 5==0) set_index_string(i);
-      else sprintf(i_string,"");
-      
-      fprintf(OUTFILE(self),"%s%g %g %g,%s\n",tab_buf,
-	      vlist->normals[3*i],vlist->normals[3*i+1],
-	      vlist->normals[3*i+2],i_string);
-    }
+    output_triples(self,vlist->normals,vlist->length);
     set_indent(DECREASE);
     fprintf(OUTFILE(self),"%s]}\n",tab_buf);
   }
@@ -2170,6 +2363,32 @@ static void output_vlist(P_Renderer *self,P_Cached_Vlist *vlist)
   isFace=P3D_FALSE;
 }
 
+static void output_triples(P_Renderer *self,float *vals,int n)
+{
+  /* This routine outputs n triples of floats, one per line, with the
+   * index of every fifth as a comment. */
+
+  Nf_Buffer nf;
+  int i;
+
+  nf_start(&nf,OUTFILE(self));
+  for(i=0;i < n;i++) {
+    nf_string(&nf,tab_buf);
+    nf_float(&nf,vals[3*i]);
+    nf_char(&nf,' ');
+    nf_float(&nf,vals[3*i+1]);
+    nf_char(&nf,' ');
+    nf_float(&nf,vals[3*i+2]);
+    nf_char(&nf,',');
+    if(i % 5==0) {
+      nf_char(&nf,'#');
+      nf_int(&nf,i);
+    }
+    nf_char(&nf,'\n');
+  }
+  nf_flush(&nf);
+}
+
 static void get_oriented(P_Vector *up,P_Vector *view,P_Vector *start)
 {
   /* This routine sets combo to the rotation necessary to go from
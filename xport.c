@@ -0,0 +1,160 @@
+/****************************************************************************
+ * xport.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module selects a message transport by name, and reassembles the
+chunks arriving at the server end of a stream transport into whole
+messages.  The transports themselves are in xport_pvm.c, xport_shm.c
+and xport_sock.c.
+
+A message which arrives as a single chunk is handed to the caller of
+xp_recv where it lies in the transport's buffer;  longer messages are
+copied together into a buffer kept for each client.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ge_error.h"
+#include "xport.h"
+
+typedef struct xp_pending_struct {
+  char *buf[XP_MAX_CLIENTS];    /* partial message from each client */
+  int fill[XP_MAX_CLIENTS];
+  int size[XP_MAX_CLIENTS];
+  int held;                     /* client whose chunk xp_recv returned */
+} Xp_Pending;
+
+Xp_Transport *xp_create( char *kind, char *address, int instance )
+/* This routine creates the client end of the named transport */
+{
+  if (!address) address= "";
+  ger_debug("xp_create: kind= <%s>, address= <%s>, instance %d",
+	    kind, address, instance);
+
+  if (!strcmp(kind,"socket")) return xp_create_socket(address, instance);
+#ifdef USE_PTHREADS
+  if (!strcmp(kind,"shm")) return xp_create_shm(address, instance);
+#endif
+#ifdef INCL_PVM
+  if (!strcmp(kind,"pvm")) return xp_create_pvm(address, instance);
+#endif
+
+  ger_error("xp_create: transport <%s> is not available", kind);
+  return NULL;
+}
+
+Xp_Server *xp_create_server( char *kind, char *address )
+/* This routine creates the server end of the named transport */
+{
+  Xp_Server *result= NULL;
+  Xp_Pending *pending;
+  int i;
+
+  if (!address) address= "";
+  ger_debug("xp_create_server: kind= <%s>, address= <%s>", kind, address);
+
+  if (!strcmp(kind,"socket")) result= xp_create_socket_server(address);
+#ifdef USE_PTHREADS
+  else if (!strcmp(kind,"shm")) result= xp_create_shm_server(address);
+#endif
+  else ger_error("xp_create_server: transport <%s> has no server end", kind);
+
+  if (result) {
+    if ( !(pending= (Xp_Pending *)malloc(sizeof(Xp_Pending))) )
+      ger_fatal("xp_create_server: unable to allocate %d bytes!",
+		sizeof(Xp_Pending));
+    for (i=0; i<XP_MAX_CLIENTS; i++) {
+      pending->buf[i]= NULL;
+      pending->fill[i]= pending->size[i]= 0;
+    }
+    pending->held= -1;
+    result->pending= (void *)pending;
+  }
+  return result;
+}
+
+static void append( Xp_Pending *pending, int client, char *data, int nbytes )
+/* This routine adds a chunk to the partial message from a client */
+{
+  if (pending->fill[client]+nbytes > pending->size[client]) {
+    int newsize= 2*pending->size[client];
+    if (newsize < pending->fill[client]+nbytes)
+      newsize= pending->fill[client]+nbytes;
+    if ( !(pending->buf[client]= (char *)realloc(pending->buf[client],
+						  newsize)) )
+      ger_fatal("xport: append: unable to allocate %d bytes!", newsize);
+    pending->size[client]= newsize;
+  }
+  memcpy(pending->buf[client]+pending->fill[client], data, nbytes);
+  pending->fill[client] += nbytes;
+}
+
+int xp_recv( Xp_Server *server, int *client, int *msgtype,
+	     char **data, int *nbytes )
+/* This routine waits for the next whole message from any client.  The
+ * data remains valid until the next call.  It returns 0 if the
+ * transport fails.
+ */
+{
+  Xp_Pending *pending= (Xp_Pending *)server->pending;
+  Xp_Chunk chunk;
+  char *payload;
+  int status;
+
+  if (pending->held >= 0) {
+    (*(server->release))(server, pending->held);
+    pending->held= -1;
+  }
+
+  while (1) {
+    status= (*(server->next_chunk))(server, client, &chunk, &payload);
+    if (status<0) return 0;
+    if (*client<0 || *client>=XP_MAX_CLIENTS) {
+      ger_error("xp_recv: client %d is out of range", *client);
+      return 0;
+    }
+    if (status==0) {
+      pending->fill[*client]= 0;
+      *msgtype= XP_HANGUP;
+      *data= NULL;
+      *nbytes= 0;
+      return 1;
+    }
+    if ((chunk.flags & XP_CHUNK_LAST) && !pending->fill[*client]) {
+      pending->held= *client;
+      *msgtype= chunk.msgtype;
+      *data= payload;
+      *nbytes= chunk.nbytes;
+      return 1;
+    }
+    append(pending, *client, payload, chunk.nbytes);
+    (*(server->release))(server, *client);
+    if (chunk.flags & XP_CHUNK_LAST) {
+      *msgtype= chunk.msgtype;
+      *data= pending->buf[*client];
+      *nbytes= pending->fill[*client];
+      pending->fill[*client]= 0;
+      return 1;
+    }
+  }
+}
+
+int xp_str_bytes( char *str )
+/* This routine returns the space a packed string takes up */
+{
+  return (strlen(str) + 4) & ~3;
+}
@@ -0,0 +1,115 @@
+/****************************************************************************
+ * xport.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides the message transport used by the PVM renderer
+(pvm_ren_mthd.c) to carry the pvm_geom.h record protocol to a render
+server, and by the reference server (renserver.c) to receive it.
+
+A transport is created by name:  "pvm" uses PVM itself (only if the
+library was built with INCL_PVM), "shm" uses a POSIX shared memory
+ring buffer for a server on the same host (needs USE_PTHREADS), and
+"socket" uses a Unix domain socket.  The address is a PVM group name,
+shared memory object name or socket path respectively;  if it is
+empty the defaults below are used.
+
+The shm and socket transports frame each message as a series of
+chunks, each an Xp_Chunk header followed by nbytes of packed data.
+Ints and floats are packed in native byte order, since both ends are
+on the same host.  A string is packed with its terminating null and
+padded to a multiple of 4 bytes.
+*/
+
+#ifndef INCL_XPORT_H
+#define INCL_XPORT_H
+
+#define XP_DEFAULT_SHM_NAME "/P3D_PVM_RENSERVER"
+#define XP_DEFAULT_SOCKET_PATH "/tmp/P3D_PVM_RENSERVER"
+
+/* Most floats which may be reserved at once */
+#define XP_RESERVE_FLOATS 3072
+
+/* Most clients a server will track at once */
+#define XP_MAX_CLIENTS 64
+
+/* Message type returned by xp_recv when a client goes away without
+ * sending a disconnect message.
+ */
+#define XP_HANGUP -1
+
+/* Chunk header for the stream transports */
+#define XP_CHUNK_LAST 1         /* this chunk ends the message */
+typedef struct xp_chunk_struct {
+  int msgtype;                  /* a pvm3d_msgtype */
+  int nbytes;                   /* bytes of data following the header */
+  int flags;
+} Xp_Chunk;
+
+/* Client end of a transport.  Messages are built between begin and
+ * send.  reserve returns space for up to XP_RESERVE_FLOATS floats
+ * which the caller fills in place;  commit then adds the first n of
+ * them to the message, and must come before any other call.
+ */
+typedef struct xp_transport_struct {
+  char *kind;
+  int tid;                      /* id the server knows this client by */
+  void *data;
+  void (*begin)( struct xp_transport_struct *self, int msgtype );
+  void (*pack_int)( struct xp_transport_struct *self, int *vals, int n );
+  void (*pack_float)( struct xp_transport_struct *self, float *vals, int n );
+  void (*pack_str)( struct xp_transport_struct *self, char *str );
+  float *(*reserve)( struct xp_transport_struct *self, int n );
+  void (*commit)( struct xp_transport_struct *self, int n );
+  void (*send)( struct xp_transport_struct *self );
+  void (*wait_sync)( struct xp_transport_struct *self );
+  void (*resend)( struct xp_transport_struct *self ); /* may be null */
+  void (*destroy)( struct xp_transport_struct *self );
+} Xp_Transport;
+
+/* Server end of a stream transport.  next_chunk waits for data from
+ * any client, returning 1 with the chunk header and a pointer to its
+ * data, 0 if the client has gone away, or -1 if the transport fails.
+ * The data is valid until release is called for that client.  sync
+ * sends the client a frame sync.
+ */
+typedef struct xp_server_struct {
+  char *kind;
+  void *data;
+  void *pending;                /* used by xp_recv */
+  int (*next_chunk)( struct xp_server_struct *self, int *client,
+		     Xp_Chunk *chunk, char **payload );
+  void (*release)( struct xp_server_struct *self, int client );
+  void (*sync)( struct xp_server_struct *self, int client );
+  void (*destroy)( struct xp_server_struct *self );
+} Xp_Server;
+
+extern Xp_Transport *xp_create( char *kind, char *address, int instance );
+extern Xp_Server *xp_create_server( char *kind, char *address );
+extern int xp_recv( Xp_Server *server, int *client, int *msgtype,
+		    char **data, int *nbytes );
+extern int xp_str_bytes( char *str );
+
+extern Xp_Transport *xp_create_socket( char *address, int instance );
+extern Xp_Server *xp_create_socket_server( char *address );
+#ifdef USE_PTHREADS
+extern Xp_Transport *xp_create_shm( char *address, int instance );
+extern Xp_Server *xp_create_shm_server( char *address );
+#endif
+#ifdef INCL_PVM
+extern Xp_Transport *xp_create_pvm( char *address, int instance );
+#endif
+
+#endif /* INCL_XPORT_H */
@@ -0,0 +1,244 @@
+/****************************************************************************
+ * xport_pvm.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module provides the PVM transport, which carries messages exactly
+as the PVM renderer always has.  The server is the first member of
+the group named by the address, SERVER_GROUP_NAME by default, and the
+first instance in each process joins CLIENT_GROUP_NAME so that the
+server can broadcast frame syncs.  Reserved floats are packed from a
+scratch buffer, since PVM copies everything into its own buffers.
+
+We never actually quit PVM, on the assumption that the calling program
+will do so.  This is only compiled if INCL_PVM is defined.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pvm3.h>
+#ifdef CRAY
+#include <time.h>
+#endif
+#include "ge_error.h"
+#include "xport.h"
+#include "pvm_geom.h"
+
+typedef struct pvm_client_struct {
+  int instance;
+  int renserver_tid;
+  int msgtype;
+  int sendbuf;          /* the most recently built message */
+  int oldbuf;
+  float scratch[XP_RESERVE_FLOATS];
+} Pvm_Client;
+
+#define CLIENT( self ) ((Pvm_Client *)((self)->data))
+
+/* Most recent server sent to, for debugging use */
+int pg_pvm_most_recent_renserver_tid= 0;
+#ifdef CRAY
+long pg_pvm_sync_clocks= 0; /* counter for total time spent in sync wait */
+#endif
+
+static void pvmx_begin( Xp_Transport *self, int msgtype )
+{
+  Pvm_Client *client= CLIENT(self);
+
+  if (client->sendbuf && (pvm_freebuf(client->sendbuf) < 0))
+    pvm_perror("xport_pvm: begin: error in pvm_freebuf");
+  if ((client->sendbuf= pvm_mkbuf(PvmDataDefault)) < 0)
+    pvm_perror("xport_pvm: begin: error in pvm_mkbuf");
+  if ((client->oldbuf= pvm_setsbuf(client->sendbuf)) < 0)
+    pvm_perror("xport_pvm: begin: error in pvm_setsbuf");
+  client->msgtype= msgtype;
+}
+
+static void pvmx_pack_int( Xp_Transport *self, int *vals, int n )
+{
+  if (pvm_pkint(vals, n, 1) < 0)
+    pvm_perror("xport_pvm: error in pvm_pkint");
+}
+
+static void pvmx_pack_float( Xp_Transport *self, float *vals, int n )
+{
+  if (pvm_pkfloat(vals, n, 1) < 0)
+    pvm_perror("xport_pvm: error in pvm_pkfloat");
+}
+
+static void pvmx_pack_str( Xp_Transport *self, char *str )
+{
+  if (pvm_pkstr(str) < 0)
+    pvm_perror("xport_pvm: error in pvm_pkstr");
+}
+
+static float *pvmx_reserve( Xp_Transport *self, int n )
+{
+  return CLIENT(self)->scratch;
+}
+
+static void pvmx_commit( Xp_Transport *self, int n )
+{
+  pvmx_pack_float(self, CLIENT(self)->scratch, n);
+}
+
+static void pvmx_send( Xp_Transport *self )
+{
+  Pvm_Client *client= CLIENT(self);
+  int old_route_policy= 0;
+
+  /* Connect using direct routing, then restore the host program's
+   * routing policy.
+   */
+  if (client->msgtype==PVM3D_CONNECT) {
+    if ((old_route_policy= pvm_getopt( PvmRoute )) < 0)
+      pvm_perror("xport_pvm: send: error in pvm_getopt");
+    if ( pvm_setopt(PvmRoute, PvmRouteDirect) < 0 )
+      pvm_perror("xport_pvm: send: error in pvm_setopt");
+  }
+
+  if (pvm_send(client->renserver_tid, client->msgtype) < 0)
+    pvm_perror("xport_pvm: send: error on send");
+  pg_pvm_most_recent_renserver_tid= client->renserver_tid;
+
+  if (client->msgtype==PVM3D_CONNECT
+      && pvm_setopt(PvmRoute, old_route_policy) < 0)
+    pvm_perror("xport_pvm: send: error resetting in pvm_setopt");
+  if (pvm_setsbuf(client->oldbuf) < 0)
+    pvm_perror("xport_pvm: send: error resetting in pvm_setsbuf");
+}
+
+static void pvmx_wait_sync( Xp_Transport *self )
+{
+  int old_rbuf;
+  int sync_rbuf;
+#ifdef CRAY
+  long wc_sync_start;
+#endif
+
+  if ((old_rbuf= pvm_setrbuf(0))<0)
+    pvm_perror("xport_pvm: wait_sync: error in pvm_setrbuf 1");
+#ifdef CRAY
+  wc_sync_start= rtclock();
+#endif
+  if (pvm_recv(-1, CLIENT_SYNC_MSG)<0)
+    pvm_perror("xport_pvm: wait_sync: error in pvm_recv");
+#ifdef CRAY
+  pg_pvm_sync_clocks += (rtclock() - wc_sync_start);
+#endif
+  if ((sync_rbuf= pvm_setrbuf(old_rbuf))<0)
+    pvm_perror("xport_pvm: wait_sync: error in pvm_setrbuf 2");
+  if (pvm_freebuf(sync_rbuf)<0)
+    pvm_perror("xport_pvm: wait_sync: error in pvm_freebuf");
+}
+
+static void pvmx_resend( Xp_Transport *self )
+/* This routine sends the most recent message again */
+{
+  Pvm_Client *client= CLIENT(self);
+  int oldbuf;
+
+  if (!client->sendbuf) {
+    ger_error("xport_pvm: resend: no most recent buffer!");
+    return;
+  }
+  if ((oldbuf= pvm_setsbuf(client->sendbuf)) < 0) {
+    pvm_perror("xport_pvm: resend: error in pvm_setsbuf");
+    return;
+  }
+  if ( pvm_send(client->renserver_tid, client->msgtype) < 0 )
+    pvm_perror("xport_pvm: resend: error on send");
+  if (pvm_setsbuf(oldbuf) < 0)
+    pvm_perror("xport_pvm: resend: error resetting in pvm_setsbuf");
+}
+
+static void pvmx_destroy( Xp_Transport *self )
+{
+  Pvm_Client *client= CLIENT(self);
+
+  if (client->sendbuf && (pvm_freebuf(client->sendbuf) < 0))
+    pvm_perror("xport_pvm: destroy: error in pvm_freebuf");
+
+  /* Leave the client group, if we are the first instance in this process */
+  if (!client->instance) {
+    if (pvm_lvgroup(CLIENT_GROUP_NAME) < 0) {
+      pvm_perror("xport_pvm: destroy: error in pvm_lvgroup");
+      exit(-1);
+    }
+  }
+
+  free( self->data );
+  free( (void *)self );
+}
+
+Xp_Transport *xp_create_pvm( char *address, int instance )
+/* This routine finds the render server, waiting for it to start if
+ * need be.
+ */
+{
+  Xp_Transport *self;
+  Pvm_Client *client;
+  char *group= ( *address ? address : SERVER_GROUP_NAME );
+
+  if ( !(self= (Xp_Transport *)malloc(sizeof(Xp_Transport))) )
+    ger_fatal("xp_create_pvm: unable to allocate %d bytes!",
+	      sizeof(Xp_Transport));
+  if ( !(client= (Pvm_Client *)malloc(sizeof(Pvm_Client))) )
+    ger_fatal("xp_create_pvm: unable to allocate %d bytes!",
+	      sizeof(Pvm_Client));
+  client->instance= instance;
+  client->msgtype= 0;
+  client->sendbuf= 0;
+  client->oldbuf= 0;
+
+  self->tid= pvm_mytid();
+
+  /* get tid of rendering server, looping and sleeping if necessary */
+  while ((client->renserver_tid= pvm_gettid(group,0)) <= 0) {
+    if (client->renserver_tid==PvmNoGroup) {
+      fprintf(stderr,"xp_create_pvm: awaiting server startup.\n");
+      (void)sleep(10);
+    }
+    else {
+      pvm_perror("xp_create_pvm: pvm_gettid error");
+      exit(-1);
+    }
+  }
+
+  /* Join the client group, if we are the first instance in this process */
+  if (!instance) {
+    if (pvm_joingroup(CLIENT_GROUP_NAME) < 0) {
+      pvm_perror("xp_create_pvm: error in pvm_joingroup");
+      exit(-1);
+    }
+  }
+
+  self->kind= "pvm";
+  self->data= (void *)client;
+  self->begin= pvmx_begin;
+  self->pack_int= pvmx_pack_int;
+  self->pack_float= pvmx_pack_float;
+  self->pack_str= pvmx_pack_str;
+  self->reserve= pvmx_reserve;
+  self->commit= pvmx_commit;
+  self->send= pvmx_send;
+  self->wait_sync= pvmx_wait_sync;
+  self->resend= pvmx_resend;
+  self->destroy= pvmx_destroy;
+
+  return self;
+}
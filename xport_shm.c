@@ -0,0 +1,620 @@
+/****************************************************************************
+ * xport_shm.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module provides the POSIX shared memory transport, for a render
+server on the same host as its clients.  The server creates a shared
+memory object holding SHM_SLOTS ring buffers, and each client claims
+one of them when it connects, so every ring has exactly one writer
+and one reader.
+
+A client packs its message straight into its ring, including the
+floats it reserves, so vertex data is written once, by the client,
+and read in place by the server.  Packed data is grouped into chunks,
+each with an Xp_Chunk header, and a chunk becomes visible to the
+server only when it is closed.  A chunk is closed when the message is
+sent, when it would run past the end of the ring, when it reaches
+SHM_CHUNK_BYTES, or when the client must wait for the server to free
+space, so a message may be any size.  A chunk never wraps around the
+end of the ring;  if one will not fit, the writer leaves a padding
+header (or fewer bytes than a header) and starts again at the front.
+
+Ring positions are byte counts which only increase;  the client
+advances head and the server advances tail, under the segment mutex.
+The mutex and condition variables are process-shared, and waits time
+out every SHM_POLL_SECONDS so that either side can notice that the
+other has died.  The mutex is robust, so a process which dies holding
+it cannot hang the others;  the next to take it closes the rings of
+any dead clients, and a client gives up if the server is dead.  This
+needs USE_PTHREADS.
+*/
+
+#ifdef USE_PTHREADS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ge_error.h"
+#include "xport.h"
+
+#define SHM_MAGIC 0x50334452
+#define SHM_SLOTS 8
+#define SHM_RING_BYTES (1024*1024)          /* must be a power of 2 */
+#define SHM_CHUNK_BYTES (SHM_RING_BYTES/4)
+#define SHM_PIECE_BYTES (64*1024)           /* most packed by one copy */
+#define SHM_PAD -2                          /* msgtype of a padding header */
+#define SHM_POLL_SECONDS 1
+
+#define SLOT_FREE 0
+#define SLOT_OPEN 1
+#define SLOT_CLOSED 2
+
+typedef struct shm_slot_struct {
+  int state;
+  int pid;                      /* of the client holding the slot */
+  unsigned int head;            /* bytes published by the client */
+  unsigned int tail;            /* bytes released by the server */
+  unsigned int syncs;           /* frame syncs sent by the server */
+  char ring[SHM_RING_BYTES];
+} Shm_Slot;
+
+typedef struct shm_segment_struct {
+  int magic;                    /* set once the server is ready */
+  int server_pid;
+  pthread_mutex_t lock;
+  pthread_cond_t data_ready;    /* a client has published or closed */
+  pthread_cond_t space_ready;   /* the server has released or synced */
+  Shm_Slot slot[SHM_SLOTS];
+} Shm_Segment;
+
+typedef struct shm_client_struct {
+  Shm_Segment *seg;
+  Shm_Slot *slot;
+  int msgtype;
+  int chunk_open;
+  unsigned int chunk_start;     /* position of the open chunk's header */
+  unsigned int pos;             /* next position to pack at */
+  unsigned int syncs_seen;
+  unsigned int tail_seen;       /* slot's tail when last read, locked */
+} Shm_Client;
+
+typedef struct shm_server_struct {
+  Shm_Segment *seg;
+  char *name;
+  int next;                     /* slot the next scan starts at */
+  unsigned int held[SHM_SLOTS]; /* bytes of each slot's current chunk */
+} Shm_Server;
+
+#define CLIENT( self ) ((Shm_Client *)((self)->data))
+#define SERVER( self ) ((Shm_Server *)((self)->data))
+#define RING_OFFSET( pos ) ((pos) & (SHM_RING_BYTES-1))
+
+static int alive( int pid )
+{
+  return ( kill(pid, 0)==0 || errno!=ESRCH );
+}
+
+static void recover_lock( Shm_Segment *seg )
+/* This routine is called holding the lock when its last holder died
+ * with it.  Dead clients' rings are closed, so the server hangs them
+ * up;  if the server is the one that died, the caller gives up.
+ */
+{
+  int i;
+
+  pthread_mutex_consistent(&(seg->lock));
+  ger_debug("xport_shm: recovering the lock from a dead process");
+  for (i=0; i<SHM_SLOTS; i++)
+    if (seg->slot[i].state==SLOT_OPEN && !alive(seg->slot[i].pid))
+      seg->slot[i].state= SLOT_CLOSED;
+  pthread_cond_broadcast(&(seg->data_ready));
+  if (!alive(seg->server_pid)) {
+    pthread_mutex_unlock(&(seg->lock));
+    ger_fatal("xport_shm: render server has gone away");
+  }
+}
+
+static void lock_segment( Shm_Segment *seg )
+{
+  if (pthread_mutex_lock(&(seg->lock)) == EOWNERDEAD) recover_lock(seg);
+}
+
+static int timed_wait( Shm_Segment *seg, pthread_cond_t *cond )
+/* This routine waits on cond, returning 0 if it timed out */
+{
+  struct timespec until;
+  int result;
+
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_sec += SHM_POLL_SECONDS;
+  result= pthread_cond_timedwait(cond, &(seg->lock), &until);
+  if (result==EOWNERDEAD) recover_lock(seg);
+  return ( result != ETIMEDOUT );
+}
+
+static Shm_Segment *map_segment( int fd )
+{
+  void *addr;
+
+  addr= mmap(NULL, sizeof(Shm_Segment), PROT_READ | PROT_WRITE,
+	     MAP_SHARED, fd, 0);
+  if (addr==MAP_FAILED) {
+    ger_error("xport_shm: mmap failed: %s", strerror(errno));
+    return NULL;
+  }
+  return (Shm_Segment *)addr;
+}
+
+static char *shm_name( char *address )
+{
+  return ( *address ? address : XP_DEFAULT_SHM_NAME );
+}
+
+static void check_server( Shm_Segment *seg )
+{
+  if (!alive(seg->server_pid))
+    ger_fatal("xport_shm: render server has gone away");
+}
+
+static void wait_space( Shm_Client *client, unsigned int end )
+/* This routine waits until the ring can hold everything before end */
+{
+  Shm_Segment *seg= client->seg;
+  Shm_Slot *slot= client->slot;
+
+  lock_segment(seg);
+  while (end - slot->tail > SHM_RING_BYTES) {
+    if (!timed_wait(seg, &(seg->space_ready))) {
+      pthread_mutex_unlock(&(seg->lock));
+      check_server(seg);
+      lock_segment(seg);
+    }
+  }
+  client->tail_seen= slot->tail;
+  pthread_mutex_unlock(&(seg->lock));
+}
+
+static int fits( Shm_Client *client, unsigned int end )
+/* This routine returns non-zero if the ring has room for everything
+ * before end.  The tail only grows, so the copy read last time is
+ * checked first, and the lock taken only if that is not enough.
+ */
+{
+  Shm_Segment *seg= client->seg;
+
+  if (end - client->tail_seen <= SHM_RING_BYTES) return 1;
+  lock_segment(seg);
+  client->tail_seen= client->slot->tail;
+  pthread_mutex_unlock(&(seg->lock));
+  return ( end - client->tail_seen <= SHM_RING_BYTES );
+}
+
+static void close_chunk( Shm_Client *client, int last )
+/* This routine fills in the open chunk's header and publishes it */
+{
+  Shm_Segment *seg= client->seg;
+  Shm_Slot *slot= client->slot;
+  Xp_Chunk *chunk=
+    (Xp_Chunk *)(slot->ring + RING_OFFSET(client->chunk_start));
+
+  chunk->msgtype= client->msgtype;
+  chunk->nbytes= client->pos - client->chunk_start - sizeof(Xp_Chunk);
+  chunk->flags= last ? XP_CHUNK_LAST : 0;
+  client->chunk_open= 0;
+
+  lock_segment(seg);
+  slot->head= client->pos;
+  pthread_cond_signal(&(seg->data_ready));
+  pthread_mutex_unlock(&(seg->lock));
+}
+
+static char *room( Shm_Client *client, int nbytes )
+/* This routine returns a place in the ring to pack nbytes */
+{
+  Shm_Slot *slot= client->slot;
+  unsigned int offset, skip;
+
+  if (client->chunk_open) {
+    /* An offset of 0 means the chunk has filled the ring to its end,
+     * and the server must find each chunk's data in one piece.
+     */
+    offset= RING_OFFSET(client->pos);
+    if (offset != 0
+	&& offset + nbytes <= SHM_RING_BYTES
+	&& client->pos + nbytes - client->chunk_start <= SHM_CHUNK_BYTES
+	&& fits(client, client->pos + nbytes))
+      return slot->ring + offset;
+    /* Let the server have what there is before waiting for space */
+    close_chunk(client, 0);
+  }
+
+  offset= RING_OFFSET(client->pos);
+  skip= (offset + sizeof(Xp_Chunk) + nbytes > SHM_RING_BYTES) ?
+    SHM_RING_BYTES - offset : 0;
+  wait_space(client, client->pos + skip + sizeof(Xp_Chunk) + nbytes);
+  if (skip) {
+    if (skip >= sizeof(Xp_Chunk))
+      ((Xp_Chunk *)(slot->ring + offset))->msgtype= SHM_PAD;
+    client->pos += skip;
+  }
+  client->chunk_start= client->pos;
+  client->pos += sizeof(Xp_Chunk);
+  client->chunk_open= 1;
+  return slot->ring + RING_OFFSET(client->pos);
+}
+
+static void pack_bytes( Shm_Client *client, char *data, int nbytes )
+{
+  int n;
+
+  while (nbytes>0) {
+    n= (nbytes > SHM_PIECE_BYTES) ? SHM_PIECE_BYTES : nbytes;
+    memcpy(room(client, n), data, n);
+    client->pos += n;
+    data += n;
+    nbytes -= n;
+  }
+}
+
+static void shm_begin( Xp_Transport *self, int msgtype )
+{
+  CLIENT(self)->msgtype= msgtype;
+  CLIENT(self)->chunk_open= 0;
+}
+
+static void shm_pack_int( Xp_Transport *self, int *vals, int n )
+{
+  pack_bytes(CLIENT(self), (char *)vals, n*sizeof(int));
+}
+
+static void shm_pack_float( Xp_Transport *self, float *vals, int n )
+{
+  pack_bytes(CLIENT(self), (char *)vals, n*sizeof(float));
+}
+
+static void shm_pack_str( Xp_Transport *self, char *str )
+{
+  int nbytes= xp_str_bytes(str);
+  char *here;
+
+  if (nbytes > SHM_PIECE_BYTES) {
+    ger_error("xport_shm: string of %d bytes is too long", nbytes);
+    nbytes= SHM_PIECE_BYTES;
+  }
+  here= room(CLIENT(self), nbytes);
+  memset(here, 0, nbytes);
+  strncpy(here, str, nbytes-1);
+  CLIENT(self)->pos += nbytes;
+}
+
+static float *shm_reserve( Xp_Transport *self, int n )
+{
+  return (float *)room(CLIENT(self), n*sizeof(float));
+}
+
+static void shm_commit( Xp_Transport *self, int n )
+{
+  CLIENT(self)->pos += n*sizeof(float);
+}
+
+static void shm_send( Xp_Transport *self )
+{
+  if (!CLIENT(self)->chunk_open) (void)room(CLIENT(self), 0);
+  close_chunk(CLIENT(self), 1);
+}
+
+static void shm_wait_sync( Xp_Transport *self )
+{
+  Shm_Client *client= CLIENT(self);
+  Shm_Segment *seg= client->seg;
+
+  lock_segment(seg);
+  while (client->slot->syncs == client->syncs_seen) {
+    if (!timed_wait(seg, &(seg->space_ready))) {
+      pthread_mutex_unlock(&(seg->lock));
+      check_server(seg);
+      lock_segment(seg);
+    }
+  }
+  client->syncs_seen++;
+  pthread_mutex_unlock(&(seg->lock));
+}
+
+static void shm_destroy( Xp_Transport *self )
+{
+  Shm_Segment *seg= CLIENT(self)->seg;
+
+  lock_segment(seg);
+  CLIENT(self)->slot->state= SLOT_CLOSED;
+  pthread_cond_signal(&(seg->data_ready));
+  pthread_mutex_unlock(&(seg->lock));
+
+  (void)munmap((void *)seg, sizeof(Shm_Segment));
+  free( self->data );
+  free( (void *)self );
+}
+
+Xp_Transport *xp_create_shm( char *address, int instance )
+/* This routine claims a ring in the server's shared memory object,
+ * waiting for the server to start if need be.
+ */
+{
+  Xp_Transport *self;
+  Shm_Client *client;
+  Shm_Segment *seg;
+  char *name= shm_name(address);
+  int fd, i;
+
+  while ((fd= shm_open(name, O_RDWR, 0)) < 0) {
+    if (errno!=ENOENT) {
+      ger_error("xp_create_shm: cannot open <%s>: %s", name, strerror(errno));
+      return NULL;
+    }
+    fprintf(stderr,"xp_create_shm: awaiting server startup.\n");
+    (void)sleep(2*SHM_POLL_SECONDS);
+  }
+  seg= map_segment(fd);
+  close(fd);
+  if (!seg) return NULL;
+  while (seg->magic != SHM_MAGIC) (void)sleep(SHM_POLL_SECONDS);
+  check_server(seg);
+
+  lock_segment(seg);
+  for (i=0; i<SHM_SLOTS; i++)
+    if (seg->slot[i].state==SLOT_FREE) break;
+  if (i==SHM_SLOTS) {
+    pthread_mutex_unlock(&(seg->lock));
+    ger_error("xp_create_shm: all %d rings of <%s> are in use",
+	      SHM_SLOTS, name);
+    (void)munmap((void *)seg, sizeof(Shm_Segment));
+    return NULL;
+  }
+  seg->slot[i].state= SLOT_OPEN;
+  seg->slot[i].pid= (int)getpid();
+  seg->slot[i].head= seg->slot[i].tail= 0;
+
+  if ( !(self= (Xp_Transport *)malloc(sizeof(Xp_Transport))) )
+    ger_fatal("xp_create_shm: unable to allocate %d bytes!",
+	      sizeof(Xp_Transport));
+  if ( !(client= (Shm_Client *)malloc(sizeof(Shm_Client))) )
+    ger_fatal("xp_create_shm: unable to allocate %d bytes!",
+	      sizeof(Shm_Client));
+  client->seg= seg;
+  client->slot= seg->slot+i;
+  client->msgtype= 0;
+  client->chunk_open= 0;
+  client->chunk_start= client->pos= 0;
+  client->syncs_seen= seg->slot[i].syncs;
+  client->tail_seen= 0;
+  pthread_mutex_unlock(&(seg->lock));
+
+  self->kind= "shm";
+  self->tid= (int)getpid();
+  self->data= (void *)client;
+  self->begin= shm_begin;
+  self->pack_int= shm_pack_int;
+  self->pack_float= shm_pack_float;
+  self->pack_str= shm_pack_str;
+  self->reserve= shm_reserve;
+  self->commit= shm_commit;
+  self->send= shm_send;
+  self->wait_sync= shm_wait_sync;
+  self->resend= NULL;
+  self->destroy= shm_destroy;
+
+  return self;
+}
+
+static int skip_padding( Shm_Slot *slot )
+/* This routine steps the tail past padding, returning non-zero if it
+ * moved.  The caller holds the lock.
+ */
+{
+  unsigned int offset;
+  int moved= 0;
+
+  while (slot->head != slot->tail) {
+    offset= RING_OFFSET(slot->tail);
+    if (SHM_RING_BYTES - offset >= sizeof(Xp_Chunk)
+	&& ((Xp_Chunk *)(slot->ring + offset))->msgtype != SHM_PAD)
+      break;
+    slot->tail += SHM_RING_BYTES - offset;
+    moved= 1;
+  }
+  return moved;
+}
+
+static int shm_next_chunk( Xp_Server *self, int *client, Xp_Chunk *chunk,
+			   char **payload )
+{
+  Shm_Server *server= SERVER(self);
+  Shm_Segment *seg= server->seg;
+  Shm_Slot *slot;
+  int i, j, timed_out= 0;
+
+  lock_segment(seg);
+  while (1) {
+    for (i=0; i<SHM_SLOTS; i++) {
+      j= (server->next + i) % SHM_SLOTS;
+      slot= seg->slot+j;
+      if (slot->state==SLOT_FREE) continue;
+      if (skip_padding(slot)) pthread_cond_broadcast(&(seg->space_ready));
+      if (slot->head != slot->tail) {
+	Xp_Chunk *here= (Xp_Chunk *)(slot->ring + RING_OFFSET(slot->tail));
+	pthread_mutex_unlock(&(seg->lock));
+	server->next= (j+1) % SHM_SLOTS;
+	server->held[j]= sizeof(Xp_Chunk) + here->nbytes;
+	*client= j;
+	*chunk= *here;
+	*payload= (char *)(here+1);
+	return 1;
+      }
+      if (slot->state==SLOT_CLOSED || (timed_out && !alive(slot->pid))) {
+	slot->state= SLOT_FREE;
+	pthread_mutex_unlock(&(seg->lock));
+	*client= j;
+	return 0;
+      }
+    }
+    timed_out= !timed_wait(seg, &(seg->data_ready));
+  }
+}
+
+static void shm_release( Xp_Server *self, int client )
+{
+  Shm_Segment *seg= SERVER(self)->seg;
+
+  lock_segment(seg);
+  seg->slot[client].tail += SERVER(self)->held[client];
+  pthread_cond_broadcast(&(seg->space_ready));
+  pthread_mutex_unlock(&(seg->lock));
+  SERVER(self)->held[client]= 0;
+}
+
+static void shm_sync( Xp_Server *self, int client )
+{
+  Shm_Segment *seg= SERVER(self)->seg;
+
+  lock_segment(seg);
+  seg->slot[client].syncs++;
+  pthread_cond_broadcast(&(seg->space_ready));
+  pthread_mutex_unlock(&(seg->lock));
+}
+
+static void shm_server_destroy( Xp_Server *self )
+{
+  Shm_Server *server= SERVER(self);
+
+  server->seg->magic= 0;
+  (void)munmap((void *)server->seg, sizeof(Shm_Segment));
+  (void)shm_unlink(server->name);
+  free( (void *)server->name );
+  free( self->data );
+  free( self->pending );
+  free( (void *)self );
+}
+
+static int create_segment( char *name )
+/* This routine creates the shared memory object, replacing one left
+ * by a server which has exited.
+ */
+{
+  Shm_Segment *old;
+  int fd;
+
+  if ((fd= shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)) >= 0
+      || errno!=EEXIST)
+    return fd;
+
+  if ((fd= shm_open(name, O_RDWR, 0)) >= 0) {
+    if ((old= map_segment(fd))) {
+      if (old->magic==SHM_MAGIC && alive(old->server_pid)) {
+	ger_error("xport_shm: a server is already running at <%s>", name);
+	(void)munmap((void *)old, sizeof(Shm_Segment));
+	close(fd);
+	errno= EEXIST;
+	return -1;
+      }
+      (void)munmap((void *)old, sizeof(Shm_Segment));
+    }
+    close(fd);
+  }
+  (void)shm_unlink(name);
+  return shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+}
+
+Xp_Server *xp_create_shm_server( char *address )
+/* This routine creates the shared memory object clients connect to */
+{
+  Xp_Server *self;
+  Shm_Server *server;
+  Shm_Segment *seg;
+  pthread_mutexattr_t mattr;
+  pthread_condattr_t cattr;
+  char *name= shm_name(address);
+  int fd, i;
+
+  if ((fd= create_segment(name)) < 0) {
+    ger_error("xp_create_shm_server: cannot create <%s>: %s",
+	      name, strerror(errno));
+    return NULL;
+  }
+  if (ftruncate(fd, sizeof(Shm_Segment)) < 0) {
+    ger_error("xp_create_shm_server: cannot size <%s>: %s",
+	      name, strerror(errno));
+    close(fd);
+    (void)shm_unlink(name);
+    return NULL;
+  }
+  seg= map_segment(fd);
+  close(fd);
+  if (!seg) {
+    (void)shm_unlink(name);
+    return NULL;
+  }
+
+  pthread_mutexattr_init(&mattr);
+  pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&(seg->lock), &mattr);
+  pthread_mutexattr_destroy(&mattr);
+  pthread_condattr_init(&cattr);
+  pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+  pthread_cond_init(&(seg->data_ready), &cattr);
+  pthread_cond_init(&(seg->space_ready), &cattr);
+  pthread_condattr_destroy(&cattr);
+  for (i=0; i<SHM_SLOTS; i++) {
+    seg->slot[i].state= SLOT_FREE;
+    seg->slot[i].head= seg->slot[i].tail= seg->slot[i].syncs= 0;
+  }
+  seg->server_pid= (int)getpid();
+  seg->magic= SHM_MAGIC;
+
+  if ( !(self= (Xp_Server *)malloc(sizeof(Xp_Server))) )
+    ger_fatal("xp_create_shm_server: unable to allocate %d bytes!",
+	      sizeof(Xp_Server));
+  if ( !(server= (Shm_Server *)malloc(sizeof(Shm_Server))) )
+    ger_fatal("xp_create_shm_server: unable to allocate %d bytes!",
+	      sizeof(Shm_Server));
+  server->seg= seg;
+  if ( !(server->name= (char *)malloc(strlen(name)+1)) )
+    ger_fatal("xp_create_shm_server: unable to allocate %d bytes!",
+	      strlen(name)+1);
+  strcpy(server->name, name);
+  server->next= 0;
+  for (i=0; i<SHM_SLOTS; i++) server->held[i]= 0;
+
+  self->kind= "shm";
+  self->data= (void *)server;
+  self->pending= NULL;
+  self->next_chunk= shm_next_chunk;
+  self->release= shm_release;
+  self->sync= shm_sync;
+  self->destroy= shm_server_destroy;
+
+  return self;
+}
+
+#endif /* USE_PTHREADS */
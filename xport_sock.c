@@ -0,0 +1,497 @@
+/****************************************************************************
+ * xport_sock.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module provides the Unix domain socket transport.  Each client
+has its own connection to the server.  A message is packed into a
+buffer belonging to the client, and written to the socket as a chunk
+whenever the buffer passes SOCK_CHUNK_BYTES and when the message is
+sent.  Reserved floats are filled in directly in that buffer.
+
+The server sends a client a frame sync by writing a single int to its
+connection.  A client which never waits for syncs discards them each
+time it sends a message, so they cannot fill the connection.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "ge_error.h"
+#include "xport.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* A chunk is written once this much has been packed */
+#define SOCK_CHUNK_BYTES (1024*1024)
+
+/* Seconds between attempts to reach a server which is not yet up */
+#define SOCK_RETRY_SECONDS 2
+
+typedef struct sock_client_struct {
+  int fd;
+  int msgtype;
+  char *buf;            /* Xp_Chunk header followed by packed data */
+  int fill;
+  int size;
+  int sync_bytes;       /* bytes of syncs received but not yet used */
+} Sock_Client;
+
+typedef struct sock_conn_struct {
+  int fd;               /* -1 if this slot is free */
+  char *buf;            /* data of the most recent chunk */
+  int size;
+} Sock_Conn;
+
+typedef struct sock_server_struct {
+  int fd;
+  char *path;
+  int next;             /* where the next poll scan starts */
+  Sock_Conn conn[XP_MAX_CLIENTS];
+  struct pollfd poll[XP_MAX_CLIENTS+1];
+} Sock_Server;
+
+#define CLIENT( self ) ((Sock_Client *)((self)->data))
+#define SERVER( self ) ((Sock_Server *)((self)->data))
+
+static int write_all( int fd, char *buf, int nbytes )
+/* This routine writes the whole buffer, returning 0 on failure */
+{
+  int n;
+
+  while (nbytes>0) {
+    if ((n= send(fd, buf, nbytes, MSG_NOSIGNAL)) < 0) {
+      if (errno==EINTR) continue;
+      return 0;
+    }
+    buf += n;
+    nbytes -= n;
+  }
+  return 1;
+}
+
+static int read_all( int fd, char *buf, int nbytes )
+/* This routine reads the whole buffer, returning 0 at end of file
+ * and -1 on failure.
+ */
+{
+  int n;
+
+  while (nbytes>0) {
+    if ((n= read(fd, buf, nbytes)) < 0) {
+      if (errno==EINTR) continue;
+      return -1;
+    }
+    if (n==0) return 0;
+    buf += n;
+    nbytes -= n;
+  }
+  return 1;
+}
+
+static int set_address( struct sockaddr_un *addr, char *path )
+{
+  if (!*path) path= XP_DEFAULT_SOCKET_PATH;
+  if (strlen(path) >= sizeof(addr->sun_path)) {
+    ger_error("xport_sock: socket path <%s> is too long", path);
+    return 0;
+  }
+  memset(addr, 0, sizeof(struct sockaddr_un));
+  addr->sun_family= AF_UNIX;
+  strcpy(addr->sun_path, path);
+  return 1;
+}
+
+static void flush_chunk( Xp_Transport *self, int last )
+/* This routine writes the packed data as a chunk */
+{
+  Sock_Client *client= CLIENT(self);
+  Xp_Chunk *chunk= (Xp_Chunk *)client->buf;
+
+  chunk->msgtype= client->msgtype;
+  chunk->nbytes= client->fill - sizeof(Xp_Chunk);
+  chunk->flags= last ? XP_CHUNK_LAST : 0;
+  if (!write_all(client->fd, client->buf, client->fill))
+    ger_error("xport_sock: write to server failed: %s", strerror(errno));
+  client->fill= sizeof(Xp_Chunk);
+}
+
+static char *room( Xp_Transport *self, int nbytes )
+/* This routine makes room to pack nbytes more */
+{
+  Sock_Client *client= CLIENT(self);
+
+  if (client->fill > sizeof(Xp_Chunk)
+      && client->fill + nbytes > SOCK_CHUNK_BYTES)
+    flush_chunk(self, 0);
+  if (client->fill + nbytes > client->size) {
+    int newsize= 2*client->size;
+    if (newsize < client->fill + nbytes) newsize= client->fill + nbytes;
+    if ( !(client->buf= (char *)realloc(client->buf, newsize)) )
+      ger_fatal("xport_sock: unable to allocate %d bytes!", newsize);
+    client->size= newsize;
+  }
+  return client->buf + client->fill;
+}
+
+static void sock_begin( Xp_Transport *self, int msgtype )
+{
+  CLIENT(self)->msgtype= msgtype;
+  CLIENT(self)->fill= sizeof(Xp_Chunk);
+}
+
+static void sock_pack_int( Xp_Transport *self, int *vals, int n )
+{
+  memcpy(room(self, n*sizeof(int)), vals, n*sizeof(int));
+  CLIENT(self)->fill += n*sizeof(int);
+}
+
+static void sock_pack_float( Xp_Transport *self, float *vals, int n )
+{
+  memcpy(room(self, n*sizeof(float)), vals, n*sizeof(float));
+  CLIENT(self)->fill += n*sizeof(float);
+}
+
+static void sock_pack_str( Xp_Transport *self, char *str )
+{
+  int nbytes= xp_str_bytes(str);
+  char *here= room(self, nbytes);
+
+  memset(here, 0, nbytes);
+  strcpy(here, str);
+  CLIENT(self)->fill += nbytes;
+}
+
+static float *sock_reserve( Xp_Transport *self, int n )
+{
+  return (float *)room(self, n*sizeof(float));
+}
+
+static void sock_commit( Xp_Transport *self, int n )
+{
+  CLIENT(self)->fill += n*sizeof(float);
+}
+
+static void sock_send( Xp_Transport *self )
+{
+  Sock_Client *client= CLIENT(self);
+  char discard[256];
+  int n;
+
+  flush_chunk(self, 1);
+
+  /* Collect any syncs the server has sent */
+  while ((n= recv(client->fd, discard, sizeof(discard), MSG_DONTWAIT)) > 0)
+    client->sync_bytes += n;
+}
+
+static void sock_wait_sync( Xp_Transport *self )
+{
+  Sock_Client *client= CLIENT(self);
+  char discard[sizeof(int)];
+  int n;
+
+  while (client->sync_bytes < sizeof(int)) {
+    if ((n= read(client->fd, discard, sizeof(int)-client->sync_bytes)) <= 0) {
+      if (n<0 && errno==EINTR) continue;
+      ger_error("xport_sock: server has gone away");
+      return;
+    }
+    client->sync_bytes += n;
+  }
+  client->sync_bytes -= sizeof(int);
+}
+
+static void sock_destroy( Xp_Transport *self )
+{
+  close(CLIENT(self)->fd);
+  free( (void *)CLIENT(self)->buf );
+  free( self->data );
+  free( (void *)self );
+}
+
+Xp_Transport *xp_create_socket( char *address, int instance )
+/* This routine connects to the server at the given socket path,
+ * waiting for the server to start if need be.
+ */
+{
+  Xp_Transport *self;
+  Sock_Client *client;
+  struct sockaddr_un addr;
+  int fd;
+
+  if (!set_address(&addr, address)) return NULL;
+
+  while (1) {
+    if ((fd= socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+      ger_error("xp_create_socket: socket failed: %s", strerror(errno));
+      return NULL;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) break;
+    if (errno!=ENOENT && errno!=ECONNREFUSED) {
+      ger_error("xp_create_socket: cannot connect to <%s>: %s",
+		addr.sun_path, strerror(errno));
+      close(fd);
+      return NULL;
+    }
+    close(fd);
+    fprintf(stderr,"xp_create_socket: awaiting server startup.\n");
+    (void)sleep(SOCK_RETRY_SECONDS);
+  }
+
+  if ( !(self= (Xp_Transport *)malloc(sizeof(Xp_Transport))) )
+    ger_fatal("xp_create_socket: unable to allocate %d bytes!",
+	      sizeof(Xp_Transport));
+  if ( !(client= (Sock_Client *)malloc(sizeof(Sock_Client))) )
+    ger_fatal("xp_create_socket: unable to allocate %d bytes!",
+	      sizeof(Sock_Client));
+  client->fd= fd;
+  client->msgtype= 0;
+  client->size= 64*1024;
+  if ( !(client->buf= (char *)malloc(client->size)) )
+    ger_fatal("xp_create_socket: unable to allocate %d bytes!",
+	      client->size);
+  client->fill= sizeof(Xp_Chunk);
+  client->sync_bytes= 0;
+
+  self->kind= "socket";
+  self->tid= (int)getpid();
+  self->data= (void *)client;
+  self->begin= sock_begin;
+  self->pack_int= sock_pack_int;
+  self->pack_float= sock_pack_float;
+  self->pack_str= sock_pack_str;
+  self->reserve= sock_reserve;
+  self->commit= sock_commit;
+  self->send= sock_send;
+  self->wait_sync= sock_wait_sync;
+  self->resend= NULL;
+  self->destroy= sock_destroy;
+
+  return self;
+}
+
+static void hang_up( Sock_Server *server, int i )
+{
+  close(server->conn[i].fd);
+  server->conn[i].fd= -1;
+}
+
+static int accept_client( Sock_Server *server )
+{
+  int fd, i;
+
+  if ((fd= accept(server->fd, NULL, NULL)) < 0) {
+    if (errno!=EINTR && errno!=EAGAIN)
+      ger_error("xport_sock: accept failed: %s", strerror(errno));
+    return 0;
+  }
+  for (i=0; i<XP_MAX_CLIENTS; i++)
+    if (server->conn[i].fd<0) {
+      server->conn[i].fd= fd;
+      return 1;
+    }
+  ger_error("xport_sock: more than %d clients; connection refused",
+	    XP_MAX_CLIENTS);
+  close(fd);
+  return 0;
+}
+
+static int read_chunk( Sock_Server *server, int i, Xp_Chunk *chunk,
+		       char **payload )
+/* This routine reads a chunk from client i */
+{
+  Sock_Conn *conn= server->conn+i;
+  int status;
+
+  if ((status= read_all(conn->fd, (char *)chunk, sizeof(Xp_Chunk))) > 0) {
+    if (chunk->nbytes<0) {
+      ger_error("xport_sock: client %d sent a bad chunk", i);
+      status= -1;
+    }
+    else {
+      if (chunk->nbytes > conn->size) {
+	if ( !(conn->buf= (char *)realloc(conn->buf, chunk->nbytes)) )
+	  ger_fatal("xport_sock: unable to allocate %d bytes!",
+		    chunk->nbytes);
+	conn->size= chunk->nbytes;
+      }
+      status= read_all(conn->fd, conn->buf, chunk->nbytes);
+    }
+  }
+  if (status<=0) {
+    hang_up(server, i);
+    return 0;
+  }
+  *payload= conn->buf;
+  return 1;
+}
+
+static int sock_next_chunk( Xp_Server *self, int *client, Xp_Chunk *chunk,
+			    char **payload )
+{
+  Sock_Server *server= SERVER(self);
+  int npoll, i, j, status;
+
+  while (1) {
+    npoll= 0;
+    server->poll[npoll].fd= server->fd;
+    server->poll[npoll++].events= POLLIN;
+    for (i=0; i<XP_MAX_CLIENTS; i++) {
+      j= (server->next + i) % XP_MAX_CLIENTS;
+      if (server->conn[j].fd>=0) {
+	server->poll[npoll].fd= server->conn[j].fd;
+	server->poll[npoll++].events= POLLIN;
+      }
+    }
+    if ((status= poll(server->poll, npoll, -1)) < 0) {
+      if (errno==EINTR) continue;
+      ger_error("xport_sock: poll failed: %s", strerror(errno));
+      return -1;
+    }
+
+    for (i=1; i<npoll; i++)
+      if (server->poll[i].revents)
+	for (j=0; j<XP_MAX_CLIENTS; j++)
+	  if (server->conn[j].fd==server->poll[i].fd) {
+	    server->next= (j+1) % XP_MAX_CLIENTS;
+	    *client= j;
+	    return read_chunk(server, j, chunk, payload);
+	  }
+
+    if (server->poll[0].revents) accept_client(server);
+  }
+}
+
+static void sock_release( Xp_Server *self, int client )
+{
+  /* The buffer is simply reused for the next chunk */
+}
+
+static void sock_sync( Xp_Server *self, int client )
+{
+  Sock_Conn *conn= SERVER(self)->conn+client;
+  int val= 1;
+
+  /* This may block, but clients drain their syncs as they send, so
+   * they cannot fill the connection;  a sync which was dropped would
+   * leave the client waiting forever.  If the client has gone, the
+   * next read finds the connection closed.
+   */
+  if (conn->fd>=0)
+    (void)write_all(conn->fd, (char *)&val, sizeof(int));
+}
+
+static void sock_server_destroy( Xp_Server *self )
+{
+  Sock_Server *server= SERVER(self);
+  int i;
+
+  for (i=0; i<XP_MAX_CLIENTS; i++) {
+    if (server->conn[i].fd>=0) close(server->conn[i].fd);
+    if (server->conn[i].buf) free( (void *)server->conn[i].buf );
+  }
+  close(server->fd);
+  (void)unlink(server->path);
+  free( (void *)server->path );
+  free( self->data );
+  free( self->pending );
+  free( (void *)self );
+}
+
+static int stale_socket( struct sockaddr_un *addr )
+/* This routine removes the socket at addr if no server is listening
+ * there, returning 1 if it did so.
+ */
+{
+  int fd, live;
+
+  if ((fd= socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return 0;
+  live= (connect(fd, (struct sockaddr *)addr, sizeof(*addr)) == 0);
+  close(fd);
+  if (live) {
+    errno= EADDRINUSE;
+    return 0;
+  }
+  return (unlink(addr->sun_path) == 0);
+}
+
+Xp_Server *xp_create_socket_server( char *address )
+/* This routine listens at the given socket path, replacing any
+ * socket left there by a server which has exited.
+ */
+{
+  Xp_Server *self;
+  Sock_Server *server;
+  struct sockaddr_un addr;
+  int fd, i;
+
+  if (!set_address(&addr, address)) return NULL;
+
+  if ((fd= socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    ger_error("xp_create_socket_server: socket failed: %s", strerror(errno));
+    return NULL;
+  }
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    if (errno!=EADDRINUSE || !stale_socket(&addr)
+	|| bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      ger_error("xp_create_socket_server: cannot bind <%s>: %s",
+		addr.sun_path, strerror(errno));
+      close(fd);
+      return NULL;
+    }
+  }
+  if (listen(fd, 16) < 0) {
+    ger_error("xp_create_socket_server: listen failed: %s", strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  if ( !(self= (Xp_Server *)malloc(sizeof(Xp_Server))) )
+    ger_fatal("xp_create_socket_server: unable to allocate %d bytes!",
+	      sizeof(Xp_Server));
+  if ( !(server= (Sock_Server *)malloc(sizeof(Sock_Server))) )
+    ger_fatal("xp_create_socket_server: unable to allocate %d bytes!",
+	      sizeof(Sock_Server));
+  server->fd= fd;
+  if ( !(server->path= (char *)malloc(strlen(addr.sun_path)+1)) )
+    ger_fatal("xp_create_socket_server: unable to allocate %d bytes!",
+	      strlen(addr.sun_path)+1);
+  strcpy(server->path, addr.sun_path);
+  server->next= 0;
+  for (i=0; i<XP_MAX_CLIENTS; i++) {
+    server->conn[i].fd= -1;
+    server->conn[i].buf= NULL;
+    server->conn[i].size= 0;
+  }
+
+  self->kind= "socket";
+  self->data= (void *)server;
+  self->pending= NULL;
+  self->next_chunk= sock_next_chunk;
+  self->release= sock_release;
+  self->sync= sock_sync;
+  self->destroy= sock_server_destroy;
+
+  return self;
+}
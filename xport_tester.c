@@ -0,0 +1,161 @@
+/****************************************************************************
+ * xport_tester.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This program checks a message transport by sending itself messages
+large enough to lap the shared memory ring several times.  The parent
+runs the server end and a forked child the client end;  the parent
+checks every int and float it receives.  Usage is
+
+    xport_tester [kind [address]]
+
+where kind defaults to "shm".  It exits with status 0 if every message
+arrives intact.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "ge_error.h"
+#include "xport.h"
+
+#define SMALL_INTS 3
+#define BIG_INTS 400000
+#define BIG_FLOATS 1000000
+#define N_ROUNDS 4
+
+static char address[256];
+
+static float float_val( int i )
+{
+  return (float)(i % 1000) + 0.25;
+}
+
+static void run_client( char *kind )
+{
+  Xp_Transport *xp;
+  float *f;
+  int round, i, j, n;
+
+  if (!(xp= xp_create(kind, address, 0))) exit(2);
+
+  for (round=0; round<N_ROUNDS; round++) {
+    /* A short message, to put the big ones off the ring's alignment */
+    (*(xp->begin))(xp, 1);
+    for (i=0; i<SMALL_INTS; i++) (*(xp->pack_int))(xp, &i, 1);
+    (*(xp->send))(xp);
+
+    /* Many small packs in one message */
+    (*(xp->begin))(xp, 2);
+    for (i=0; i<BIG_INTS; i++) (*(xp->pack_int))(xp, &i, 1);
+    (*(xp->send))(xp);
+
+    /* Reserved floats in one message */
+    (*(xp->begin))(xp, 3);
+    for (i=0; i<BIG_FLOATS; i += n) {
+      n= (BIG_FLOATS-i > XP_RESERVE_FLOATS) ? XP_RESERVE_FLOATS : BIG_FLOATS-i;
+      f= (*(xp->reserve))(xp, n);
+      for (j=0; j<n; j++) f[j]= float_val(i+j);
+      (*(xp->commit))(xp, n);
+    }
+    (*(xp->send))(xp);
+  }
+
+  (*(xp->destroy))(xp);
+  exit(0);
+}
+
+static int check_message( int msgtype, char *data, int nbytes )
+/* This routine returns the number of bad values in a message */
+{
+  int *ints= (int *)data;
+  float *floats= (float *)data;
+  int i, count, bad= 0;
+
+  switch (msgtype) {
+  case 1: count= SMALL_INTS; break;
+  case 2: count= BIG_INTS; break;
+  case 3: count= BIG_FLOATS; break;
+  default:
+    fprintf(stderr,"xport_tester: unexpected message type %d\n", msgtype);
+    return 1;
+  }
+  if (nbytes != count*4) {
+    fprintf(stderr,"xport_tester: message %d has %d bytes, not %d\n",
+	    msgtype, nbytes, count*4);
+    return 1;
+  }
+
+  for (i=0; i<count; i++) {
+    if ( (msgtype==3) ? (floats[i] != float_val(i)) : (ints[i] != i) ) {
+      if (!bad)
+	fprintf(stderr,"xport_tester: message %d is bad at value %d\n",
+		msgtype, i);
+      bad++;
+    }
+  }
+  return bad;
+}
+
+int main( int argc, char *argv[] )
+{
+  Xp_Server *server;
+  char *kind= (argc>1) ? argv[1] : "shm";
+  char *data;
+  int client, msgtype, nbytes, status, pid;
+  int nmessages= 0, bad= 0;
+
+  if (argc>2) strncpy(address, argv[2], sizeof(address)-1);
+  else if (!strcmp(kind,"socket"))
+    sprintf(address, "/tmp/xport_tester.%d", (int)getpid());
+  else sprintf(address, "/xport_tester.%d", (int)getpid());
+
+  if (!(server= xp_create_server(kind, address))) {
+    fprintf(stderr,"xport_tester: cannot create a <%s> server\n", kind);
+    return 2;
+  }
+
+  if ((pid= fork()) < 0) {
+    perror("xport_tester: fork");
+    return 2;
+  }
+  if (pid==0) run_client(kind);
+
+  while (xp_recv(server, &client, &msgtype, &data, &nbytes)) {
+    if (msgtype==XP_HANGUP) break;
+    bad += check_message(msgtype, data, nbytes);
+    nmessages++;
+  }
+  (*(server->destroy))(server);
+
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+      || WEXITSTATUS(status)) {
+    fprintf(stderr,"xport_tester: client failed\n");
+    bad++;
+  }
+  if (nmessages != 3*N_ROUNDS) {
+    fprintf(stderr,"xport_tester: got %d messages, not %d\n",
+	    nmessages, 3*N_ROUNDS);
+    bad++;
+  }
+
+  fprintf(stderr,"xport_tester: <%s> transport %s\n", kind,
+	  bad ? "FAILED" : "passed");
+  return( bad ? 1 : 0 );
+}
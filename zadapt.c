@@ -0,0 +1,340 @@
+/****************************************************************************
+ * zadapt.c
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This module meshes zsurfaces adaptively, so that flat or smoothly
+varying regions of a large height field are covered by a few large
+triangles rather than two triangles per grid cell.  The mesh is a
+right triangulated irregular network, the restricted form of quadtree
+triangulation in which right triangles are split in half across their
+longest edge (Evans, Kirkpatrick and Townsend, "Right-Triangulated
+Irregular Networks", Algorithmica 30, 2001).
+
+The grid is covered by a square of power-of-two size, split along a
+diagonal.  Every grid point is the midpoint of the long edge of at
+most two triangles of the hierarchy, and is assigned the error of
+dropping it:  its distance from the midpoint of that edge, scaled by
+the tolerance, or the larger of that and the scaled change in value if
+a value tolerance is set.  The error of a point is raised to cover the
+errors of the points below it in the hierarchy, so a triangle is split
+whenever any descendant must be.  Since both triangles which share a
+long edge split at the same point, the mesh has no cracks.  Points
+outside the grid or rejected by the test function have infinite error,
+so triangles touching them are refined to single grid cells, and those
+cells are dropped.
+
+Only the grid points used by the mesh are kept in its vertex list.
+The mesh is passed on to dec_mesh(), so it can be decimated further.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "p3dgen.h"
+#include "pgen_objects.h"
+#include "ge_error.h"
+#include "decimate.h"
+#include "zadapt.h"
+
+#define X       0
+#define Y       1
+#define Z       2
+#define CMAP    3
+
+/* Error of points which must never be dropped */
+#define HUGE_ERROR 1.0e30
+
+/* Adaptive meshing settings for zsurfaces */
+static double za_tolerance= 0.0;
+static double za_value_tolerance= 0.0;
+
+/* The grid being meshed;  point (i,j) is at index i*gny+j */
+static float *pts;
+static int fpv, gnx, gny, use_value;
+static unsigned char *excluded; /* may be null */
+static float *errors;
+
+/* Triangles found so far, as grid point indices */
+static int *tris= (int *)0;
+static int ntris= 0, max_tris= 0;
+
+#define INDEX( i, j ) ( (i)*gny + (j) )
+#define INSIDE( i, j ) ( (i)<gnx && (j)<gny )
+#define MISSING( i, j ) \
+  ( !INSIDE(i,j) || (excluded && excluded[INDEX(i,j)]) )
+#define ERR_AT( i, j ) ( INSIDE(i,j) ? errors[INDEX(i,j)] : HUGE_ERROR )
+
+static float point_error( int m, int a, int b )
+/* This routine returns the scaled error of replacing point m by the
+ * midpoint of the edge from a to b.
+ */
+{
+  float *pm= pts+m*fpv, *pa= pts+a*fpv, *pb= pts+b*fpv;
+  double dx= pm[X] - 0.5*(pa[X]+pb[X]);
+  double dy= pm[Y] - 0.5*(pa[Y]+pb[Y]);
+  double dz= pm[Z] - 0.5*(pa[Z]+pb[Z]);
+  double err= sqrt( dx*dx + dy*dy + dz*dz )/za_tolerance;
+
+  if (use_value) {
+    double dv= fabs( pm[CMAP] - 0.5*(pa[CMAP]+pb[CMAP]) )/za_value_tolerance;
+    if (dv>err) err= dv;
+  }
+  return( (float)err );
+}
+
+static void edge_error( int i, int j, int h, int size, int along_i )
+/* This routine finds the error of point (i,j), which is the midpoint of
+ * an edge of length 2h of a square of the hierarchy.  The edge runs
+ * along the i direction if along_i is true.  Triangles on either side
+ * of the edge have their right angles at the centers of the squares.
+ */
+{
+  int di= along_i ? h : 0, dj= along_i ? 0 : h;
+  int q= h/2;
+  float err, child;
+
+  if (MISSING(i,j) || MISSING(i-di,j-dj) || MISSING(i+di,j+dj))
+    err= HUGE_ERROR;
+  else err= point_error( INDEX(i,j), INDEX(i-di,j-dj), INDEX(i+di,j+dj) );
+
+  /* The side toward lower coordinates */
+  if (i-dj>=0 && j-di>=0) {
+    if (MISSING(i-dj,j-di)) err= HUGE_ERROR;
+    else if (q) {
+      child= ERR_AT( i-q, j-q );
+      if (child>err) err= child;
+      child= along_i ? ERR_AT( i+q, j-q ) : ERR_AT( i-q, j+q );
+      if (child>err) err= child;
+    }
+  }
+
+  /* The side toward higher coordinates */
+  if (i+dj<=size && j+di<=size) {
+    if (MISSING(i+dj,j+di)) err= HUGE_ERROR;
+    else if (q) {
+      child= ERR_AT( i+q, j+q );
+      if (child>err) err= child;
+      child= along_i ? ERR_AT( i-q, j+q ) : ERR_AT( i+q, j-q );
+      if (child>err) err= child;
+    }
+  }
+
+  if (INSIDE(i,j)) errors[INDEX(i,j)]= err;
+}
+
+static void center_error( int i, int j, int h )
+/* This routine finds the error of point (i,j), which is the center of a
+ * square of the hierarchy with sides 2h.  The square is split along
+ * the diagonal which runs through the center of its parent square.
+ */
+{
+  int s= 2*h;
+  int ai, aj, bi, bj;
+  float err, child;
+
+  if (MISSING(i-h,j-h) || MISSING(i+h,j-h) || MISSING(i-h,j+h)
+      || MISSING(i+h,j+h) || MISSING(i,j)) err= HUGE_ERROR;
+  else {
+    ai= ( ((i-h)/s)%2 ) ? i-h : i+h;
+    aj= ( ((j-h)/s)%2 ) ? j-h : j+h;
+    bi= 2*i-ai;
+    bj= 2*j-aj;
+    err= point_error( INDEX(i,j), INDEX(ai,aj), INDEX(bi,bj) );
+  }
+
+  child= ERR_AT( i, j-h );
+  if (child>err) err= child;
+  child= ERR_AT( i, j+h );
+  if (child>err) err= child;
+  child= ERR_AT( i-h, j );
+  if (child>err) err= child;
+  child= ERR_AT( i+h, j );
+  if (child>err) err= child;
+
+  if (INSIDE(i,j)) errors[INDEX(i,j)]= err;
+}
+
+static void find_errors( int size )
+/* This routine fills in the error of every grid point, working up
+ * the hierarchy from the smallest triangles so that the errors of all
+ * points below a given point are known before it is reached.
+ */
+{
+  int s, h, i, j;
+
+  for (s=2; s<=size; s*=2) {
+    h= s/2;
+    for (i=h; i<gnx; i+=s)
+      for (j=0; j<gny; j+=s) edge_error( i, j, h, size, 1 );
+    for (i=0; i<gnx; i+=s)
+      for (j=h; j<gny; j+=s) edge_error( i, j, h, size, 0 );
+    for (i=h; i<gnx; i+=s)
+      for (j=h; j<gny; j+=s) center_error( i, j, h );
+  }
+}
+
+static void add_triangle( int ai, int aj, int bi, int bj, int ci, int cj )
+/* This routine records a triangle, oriented counterclockwise in the
+ * grid index plane like those of the full zsurface mesh.
+ */
+{
+  if (ntris>=max_tris) {
+    max_tris= (max_tris>0) ? 2*max_tris : 1024;
+    if ( !(tris= (int *)realloc( tris, 3*max_tris*sizeof(int) )) )
+      ger_fatal("za_mesh: unable to allocate %d bytes!",
+		3*max_tris*sizeof(int));
+  }
+  tris[3*ntris]= INDEX(ai,aj);
+  if ( (bi-ai)*(cj-aj) - (bj-aj)*(ci-ai) > 0 ) {
+    tris[3*ntris+1]= INDEX(bi,bj);
+    tris[3*ntris+2]= INDEX(ci,cj);
+  }
+  else {
+    tris[3*ntris+1]= INDEX(ci,cj);
+    tris[3*ntris+2]= INDEX(bi,bj);
+  }
+  ntris++;
+}
+
+static void emit( int ai, int aj, int bi, int bj, int ci, int cj )
+/* This routine emits the triangle with long edge (a,b) and right angle
+ * at c, or its descendants if it must be split.
+ */
+{
+  int mi, mj;
+
+  /* Skip triangles which don't overlap the grid */
+  if (ai>=gnx-1 && bi>=gnx-1 && ci>=gnx-1) return;
+  if (aj>=gny-1 && bj>=gny-1 && cj>=gny-1) return;
+
+  if ( (ai+bi)%2 || (aj+bj)%2 ) {
+    /* A half grid cell */
+    if ( !(MISSING(ai,aj) || MISSING(bi,bj) || MISSING(ci,cj)) )
+      add_triangle( ai, aj, bi, bj, ci, cj );
+    return;
+  }
+
+  mi= (ai+bi)/2;
+  mj= (aj+bj)/2;
+  if (ERR_AT(mi,mj) <= 1.0) add_triangle( ai, aj, bi, bj, ci, cj );
+  else {
+    emit( ci, cj, ai, aj, mi, mj );
+    emit( bi, bj, ci, cj, mi, mj );
+  }
+}
+
+int za_mesh( int vtxtype, float *pt_array, int float_per_vtx,
+	     int nx, int ny, unsigned char *excluded_pts )
+/* This routine meshes the nx by ny grid of points in pt_array, as
+ * arranged by the zsurface routines, within the tolerances set by
+ * pg_zsurf_adaptive().  Grid points flagged in excluded_pts, which
+ * may be null, are left out.  The mesh is added to the currently open
+ * GOB.
+ */
+{
+  P_Vlist *vlist;
+  float *used_pts;
+  int *remap, *lengths;
+  int size, nused, i, retval;
+
+  if (nx<2 || ny<2) {
+    ger_error("za_mesh: grid must be at least 2 by 2");
+    return( P3D_FAILURE );
+  }
+
+  pts= pt_array;
+  fpv= float_per_vtx;
+  gnx= nx;
+  gny= ny;
+  use_value= ( (vtxtype==P3D_CVVTX || vtxtype==P3D_CVNVTX)
+	       && za_value_tolerance>0.0 );
+
+  excluded= excluded_pts;
+  if ( !(errors= (float *)malloc(nx*ny*sizeof(float))) )
+    ger_fatal("za_mesh: unable to allocate %d bytes!", nx*ny*sizeof(float));
+
+  for (size=1; size<nx-1 || size<ny-1; size*=2);
+  find_errors( size );
+
+  ntris= 0;
+  emit( 0, 0, size, size, size, 0 );
+  emit( size, size, 0, 0, 0, size );
+
+  free( (P_Void_ptr)errors );
+
+  ger_debug("za_mesh: %d triangles replace %d", ntris, 2*(nx-1)*(ny-1));
+
+  if (ntris==0) return( P3D_FAILURE );
+
+  /* Keep only the grid points which are used */
+  if ( !(remap= (int *)malloc(nx*ny*sizeof(int))) )
+    ger_fatal("za_mesh: unable to allocate %d bytes!", nx*ny*sizeof(int));
+  for (i=0; i<nx*ny; i++) remap[i]= -1;
+  nused= 0;
+  for (i=0; i<3*ntris; i++) {
+    if (remap[tris[i]]<0) remap[tris[i]]= nused++;
+    tris[i]= remap[tris[i]];
+  }
+  if ( !(used_pts= (float *)malloc(nused*fpv*sizeof(float)))
+       || !(lengths= (int *)malloc(ntris*sizeof(int))) )
+    ger_fatal("za_mesh: unable to allocate %d bytes!",
+	      nused*fpv*sizeof(float) + ntris*sizeof(int));
+  for (i=0; i<nx*ny; i++)
+    if (remap[i]>=0) {
+      int k;
+      for (k=0; k<fpv; k++) used_pts[remap[i]*fpv+k]= pts[i*fpv+k];
+    }
+  for (i=0; i<ntris; i++) lengths[i]= 3;
+  free( (P_Void_ptr)remap );
+
+  vlist= po_create_cvlist( vtxtype, nused, used_pts );
+  retval= dec_mesh( vlist, tris, lengths, ntris );
+
+  free( (P_Void_ptr)used_pts );
+  free( (P_Void_ptr)lengths );
+  free( (P_Void_ptr)tris );
+  tris= (int *)0;
+  max_tris= 0;
+
+  return( retval );
+}
+
+int pg_zsurf_adaptive( double tolerance, double value_tolerance )
+/* This routine sets the tolerances for adaptive meshing of zsurfaces.
+ * Points are left out of the mesh where they lie within the tolerance
+ * of the surface, and, if value_tolerance is positive, their values
+ * lie within value_tolerance of the interpolated value.  A tolerance
+ * of 0.0 turns adaptive meshing off.
+ */
+{
+  ger_debug("pg_zsurf_adaptive: tolerance %f, value tolerance %f",
+	    tolerance, value_tolerance);
+
+  if (tolerance<0.0) {
+    ger_error("pg_zsurf_adaptive: tolerance is negative; call ignored.");
+    return( P3D_FAILURE );
+  }
+
+  za_tolerance= tolerance;
+  za_value_tolerance= value_tolerance;
+  return( P3D_SUCCESS );
+}
+
+int za_enabled( VOIDLIST )
+/* This routine returns true if zsurfaces are to be meshed adaptively */
+{
+  return( za_tolerance>0.0 );
+}
@@ -0,0 +1,29 @@
+/****************************************************************************
+ * zadapt.h
+ * Author Joel Welling
+ * Copyright 2026, Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * Permission use, copy, and modify this software and its documentation
+ * without fee for personal use or use within your organization is hereby
+ * granted, provided that the above copyright notice is preserved in all
+ * copies and that that copyright and this permission notice appear in
+ * supporting documentation.  Permission to redistribute this software to
+ * other organizations or individuals is not granted;  that must be
+ * negotiated with the PSC.  Neither the PSC nor Carnegie Mellon
+ * University make any representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *****************************************************************************/
+/*
+This file provides entry points for the adaptive zsurface meshing
+package zadapt.c, which is used by the zsurface routines.
+*/
+
+#ifndef INCL_ZADAPT_H
+#define INCL_ZADAPT_H
+
+extern int za_enabled( void );
+extern int za_mesh( int vtxtype, float *pt_array, int float_per_vtx,
+		    int nx, int ny, unsigned char *excluded_pts );
+
+#endif /* INCL_ZADAPT_H */
@@ -17,13 +17,25 @@
 /*
 This module creates a "zsurface", which is in effect a rectangular mesh
 with a height and color attribute associated with each point 
+
+Points, normals, and facets are generated a row of the grid at a time,
+with the rows divided among threads.  Within a row the loops have no
+branches, so that the compiler can vectorize them;  the first and last
+points of each row and the first and last rows, where the derivatives
+are one-sided, are handled by separate loops.  Facet index arrays are
+filled in parallel, each row starting at an offset found by first
+counting the facets of every row.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include "p3dgen.h"
 #include "pgen_objects.h"
 #include "ge_error.h"
+#include "decimate.h"
+#include "zadapt.h"
+#include "parallel.h"
 
 #define FACET_VTX_SZ 3
 
@@ -37,9 +49,22 @@ with a height and color attribute associated with each point
 #define CNVTX_SZ   6
 #define CVNVTX_SZ  7
 
+/* Rows are given to threads in groups of at least this many points */
+#define MIN_POINTS_PER_THREAD 16384
 
-#define GETZ( pt_array, i, j, nx, float_vtx_sz ) \
-	   *( (pt_array) + ((nx)*(j) + (i))*(float_vtx_sz) + Z ) 
+/* Everything the row functions need to know about one zsurface */
+typedef struct zsurf_pass_struct {
+  float *pt_array;
+  float *zdata, *valdata;
+  int *mask;
+  unsigned char *excluded;   /* per point, or null if none are */
+  int float_per_vtx;
+  int nx, ny;
+  int cy, fx;                /* strides of zdata in i and j */
+  float x_pos, y_pos, deltax, deltay;
+  int *row_start;            /* first facet of each row of cells */
+  int *facets, *facet_lengths;
+} Zsurf_pass;
 
 
 /*
@@ -73,25 +98,203 @@ static float deriv_centered( float v1, float v2, float step )
 }
 
 
+static void set_normal( float *norm, float gradx, float grady )
+/* This routine stores the unit normal of a surface with the given
+ * gradient.
+ */
+{
+  float norm_len = ( float )
+    sqrt( ( double ) gradx*gradx + grady*grady + 1.0 );
 
-/* 
-Main pg routine.  Creates a zsurface.
-*/
+  norm[0] = -gradx/norm_len;
+  norm[1] = -grady/norm_len;
+  norm[2] = 1.0/norm_len;
+}
 
-int pg_zsurface(int vtxtype, float *zdata, float *valdata, 
-                 int nx, int ny, P_Point *corner1, 
-                 P_Point *corner2, 
-		void (*testfun)( int *, float *, int *, int * ), int fort)
+
+static void point_rows( int start, int end, int worker, P_Void_ptr arg )
+/* This routine fills in the coordinates and values of the points of
+ * rows [start,end).
+ */
+{
+  Zsurf_pass *pass= (Zsurf_pass *)arg;
+  int fpv= pass->float_per_vtx, ny= pass->ny, fx= pass->fx;
+  int i, j;
+
+  for (i=start; i<end; i++) {
+    float *pt= pass->pt_array + i*ny*fpv;
+    float *z= pass->zdata + i*pass->cy;
+    float x= pass->x_pos + i*pass->deltax;
+
+    for (j=0; j<ny; j++) {
+      pt[j*fpv+X] = x;
+      pt[j*fpv+Y] = pass->y_pos + j*pass->deltay;
+      pt[j*fpv+Z] = z[j*fx];
+    }
+    if (pass->valdata && (fpv==CVVTX_SZ || fpv==CVNVTX_SZ)) {
+      float *val= pass->valdata + i*pass->cy;
+      for (j=0; j<ny; j++) pt[j*fpv+CMAP] = val[j*fx];
+    }
+  }
+}
+
+
+static void normal_rows( int start, int end, int worker, P_Void_ptr arg )
+/* This routine calculates the normals of the points of rows
+ * [start,end).  The x derivative is parked in the first normal
+ * component until the y derivative is known.
+ */
+{
+  Zsurf_pass *pass= (Zsurf_pass *)arg;
+  int fpv= pass->float_per_vtx, nx= pass->nx, ny= pass->ny;
+  int stride= ny*fpv, n= fpv-3;
+  float deltax= pass->deltax, deltay= pass->deltay;
+  int i, j;
+
+  for (i=start; i<end; i++) {
+    float *pt= pass->pt_array + i*stride;
+
+    if (i==0)
+      for (j=0; j<ny; j++)
+	pt[j*fpv+n]= deriv_forwards( pt[j*fpv+Z], pt[j*fpv+stride+Z],
+				     pt[j*fpv+2*stride+Z], deltax );
+    else if (i==nx-1)
+      for (j=0; j<ny; j++)
+	pt[j*fpv+n]= deriv_forwards( pt[j*fpv+Z], pt[j*fpv-stride+Z],
+				     pt[j*fpv-2*stride+Z], -deltax );
+    else
+      for (j=0; j<ny; j++)
+	pt[j*fpv+n]= deriv_centered( pt[j*fpv-stride+Z],
+				     pt[j*fpv+stride+Z], deltax );
+
+    set_normal( pt+n, pt[n],
+		deriv_forwards( pt[Z], pt[fpv+Z], pt[2*fpv+Z], deltay ) );
+    for (j=1; j<ny-1; j++)
+      set_normal( pt+j*fpv+n, pt[j*fpv+n],
+		  deriv_centered( pt[(j-1)*fpv+Z], pt[(j+1)*fpv+Z], deltay ) );
+    j= ny-1;
+    set_normal( pt+j*fpv+n, pt[j*fpv+n],
+		deriv_forwards( pt[j*fpv+Z], pt[(j-1)*fpv+Z],
+				pt[(j-2)*fpv+Z], -deltay ) );
+  }
+}
+
+
+static void mask_rows( int start, int end, int worker, P_Void_ptr arg )
+/* This routine copies the mask of rows [start,end) into the excluded
+ * flags of the points.
+ */
+{
+  Zsurf_pass *pass= (Zsurf_pass *)arg;
+  int ny= pass->ny, fx= pass->fx;
+  int i, j;
+
+  for (i=start; i<end; i++) {
+    int *mask= pass->mask + i*pass->cy;
+    unsigned char *excluded= pass->excluded + i*ny;
+    for (j=0; j<ny; j++) excluded[j]= ( mask[j*fx] != 0 );
+  }
+}
+
+
+static int cell_facets( unsigned char *excluded, int a_0, int ny, 
+		        int *facets )
+/* This routine finds the facets of the grid cell with lowest corner
+ * a_0, writing them to facets if it is non-null.  If any vertex of the
+ * usual pair of facets is excluded, it tries to create a facet with an
+ * opposite orientation.  The number of facets is returned.
+ */
+{
+  int a_1= a_0 + 1, a_ny= a_0 + ny, a_ny_1= a_0 + ny + 1;
+  int a_0_exclude= excluded[a_0], a_1_exclude= excluded[a_1];
+  int a_ny_exclude= excluded[a_ny], a_ny_1_exclude= excluded[a_ny_1];
+  int nfacets= 0;
+
+  if (! ( a_0_exclude || a_1_exclude || a_ny_exclude ) ) {
+    if (facets) append_to_fac_arr( facets, a_0, a_ny, a_1, nfacets );
+    nfacets++;
+  }
+  if (! ( a_1_exclude || a_ny_exclude || a_ny_1_exclude )) {
+    if (facets) append_to_fac_arr( facets, a_1, a_ny, a_ny_1, nfacets );
+    nfacets++;
+  }
+  else if ( a_1_exclude && 
+	   ( !( a_0_exclude || a_ny_exclude || a_ny_1_exclude ) ) ) {
+    if (facets) append_to_fac_arr( facets, a_0, a_ny, a_ny_1, nfacets );
+    nfacets++;
+  }
+  else if ( a_ny_exclude && 
+	   ( !( a_0_exclude || a_1_exclude || a_ny_1_exclude ) ) ) {
+    if (facets) append_to_fac_arr( facets, a_0, a_ny_1, a_1, nfacets );
+    nfacets++;
+  }
+  return( nfacets );
+}
+
+
+static void count_rows( int start, int end, int worker, P_Void_ptr arg )
+/* This routine counts the facets of rows [start,end) of grid cells */
+{
+  Zsurf_pass *pass= (Zsurf_pass *)arg;
+  int ny= pass->ny;
+  int i, j, count;
+
+  for (i=start; i<end; i++) {
+    count= 0;
+    for (j=0; j<ny-1; j++)
+      count += cell_facets( pass->excluded, i*ny+j, ny, (int *)0 );
+    pass->row_start[i]= count;
+  }
+}
+
+
+static void facet_rows( int start, int end, int worker, P_Void_ptr arg )
+/* This routine fills in the facets of rows [start,end) of grid cells */
+{
+  Zsurf_pass *pass= (Zsurf_pass *)arg;
+  int ny= pass->ny;
+  int i, j, first, nfacets;
+  int *facets;
+
+  for (i=start; i<end; i++) {
+    if (pass->excluded) {
+      first= pass->row_start[i];
+      facets= pass->facets + FACET_VTX_SZ*first;
+      for (j=0; j<ny-1; j++)
+	facets += FACET_VTX_SZ
+	  * cell_facets( pass->excluded, i*ny+j, ny, facets );
+      nfacets= (facets - pass->facets)/FACET_VTX_SZ - first;
+    }
+    else {
+      first= 2*(ny-1)*i;
+      facets= pass->facets + FACET_VTX_SZ*first;
+      for (j=0; j<ny-1; j++) {
+	int a_0= i*ny+j;
+	facets[6*j]= a_0;
+	facets[6*j+1]= a_0+ny;
+	facets[6*j+2]= a_0+1;
+	facets[6*j+3]= a_0+1;
+	facets[6*j+4]= a_0+ny;
+	facets[6*j+5]= a_0+ny+1;
+      }
+      nfacets= 2*(ny-1);
+    }
+    for (j=0; j<nfacets; j++) pass->facet_lengths[first+j]= FACET_VTX_SZ;
+  }
+}
+
+
+static int zsurface( int vtxtype, float *zdata, float *valdata, 
+		     int nx, int ny, P_Point *corner1, P_Point *corner2, 
+		     void (*testfun)( int *, float *, int *, int * ),
+		     int *mask, int fort )
+/* This routine does the work of pg_zsurface and pg_zsurface_masked */
 {
+  Zsurf_pass pass;
   P_Vlist *vlist;
-  float *pt_array, *dest, offset;
-  float x_pos, y_pos;
-  float deltax, deltay, gradx, grady, norm_len;
-  int *facet_array, *facet_len_array;
-  int nfacets=0, float_per_vtx, i, j;
-  int a_0, a_1, a_ny, a_ny_1;
-  int a_0_exclude, a_1_exclude, a_ny_exclude, a_ny_1_exclude;
-  int cy = 1, fx = 1, zsurf_flag;
+  float *pt_array;
+  int nfacets=0, float_per_vtx, i, j, min_rows;
+  int zsurf_flag= P3D_FAILURE;
 
   if (pg_gob_open() == P3D_SUCCESS) {
    
@@ -143,33 +346,27 @@ int pg_zsurface(int vtxtype, float *zdata, float *valdata,
 
     pt_array = (float *) 
                malloc(float_per_vtx*ny*nx*sizeof(float));
-    facet_array = (int *) 
-               malloc(FACET_VTX_SZ*2*(nx-1)*(ny-1)*sizeof(int));
-    facet_len_array = (int *) 
-               malloc(2*(nx-1)*(ny-1)*sizeof(int));
-
-    for ( i=0; i<2*(nx-1)*(ny-1); i++ )     /*create array of facet lengths*/
-      *(facet_len_array+i) = FACET_VTX_SZ; /* all facets will have 3 vertices*/
-
-    x_pos = corner1->x;    /*starting pos*/
-    y_pos = corner1->y;    /*ending pos*/
-    deltax = ( corner2->x - corner1->x ) / ( nx - 1 );
-    deltay = ( corner2->y - corner1->y ) / ( ny - 1 );
-
-    if (fort)   /* if the data was from fortan, get z in row order*/
-      fx = nx;
-    else 
-      cy = ny;
-
-    for (i=0; i<nx; i++) {          /* get the pts */
-      for (j=0; j<ny; j++) {
-	*(pt_array+X+float_per_vtx*(i*ny+j) ) = x_pos + i*deltax;
-	*(pt_array+Y+float_per_vtx*(i*ny+j) ) = y_pos + j*deltay; 
-	*(pt_array+Z+float_per_vtx*(i*ny+j) ) = *(zdata+i*cy+j*fx);
-	if (valdata)
-	  *(pt_array+CMAP+float_per_vtx*(i*ny+j) ) = *(valdata+i*cy+j*fx);
-      }
-    }
+
+    pass.pt_array= pt_array;
+    pass.zdata= zdata;
+    pass.valdata= valdata;
+    pass.mask= mask;
+    pass.excluded= (unsigned char *)0;
+    pass.float_per_vtx= float_per_vtx;
+    pass.nx= nx;
+    pass.ny= ny;
+    pass.x_pos = corner1->x;    /*starting pos*/
+    pass.y_pos = corner1->y;    /*ending pos*/
+    pass.deltax = ( corner2->x - corner1->x ) / ( nx - 1 );
+    pass.deltay = ( corner2->y - corner1->y ) / ( ny - 1 );
+
+    /* if the data was from fortran, get z in row order*/
+    pass.cy= fort ? 1 : ny;
+    pass.fx= fort ? nx : 1;
+
+    min_rows= 1 + MIN_POINTS_PER_THREAD/ny;
+
+    par_for( nx, min_rows, point_rows, (P_Void_ptr)&pass );
 
 /*
 If we need to calculate normals, this portion does it.  The zsurface is
@@ -177,124 +374,85 @@ made up of right triangles, and this portion calculates a normal to
 each right triangle. 
 */
 
+    if ( ( float_per_vtx == CVNVTX_SZ ) || ( float_per_vtx == CNVTX_SZ ) )
+      par_for( nx, min_rows, normal_rows, (P_Void_ptr)&pass );
 
-    if ( ( float_per_vtx == CVNVTX_SZ ) || ( float_per_vtx == CNVTX_SZ ) )  {
-      for (j=0; j<ny; j++) 
-	for (i=0; i<nx; i++) {
-
-	  if (i==0) gradx= 
-	    deriv_forwards( GETZ( pt_array, 0, j, nx, float_per_vtx ), 
-			   GETZ( pt_array, 1, j, nx, float_per_vtx ), 
-			   GETZ( pt_array, 2, j, nx, float_per_vtx ), deltax );
-	  else if (i==nx-1) gradx=
-	    deriv_forwards( GETZ( pt_array, nx-1, j, nx, float_per_vtx ), 
-			   GETZ( pt_array, nx-2, j, nx, float_per_vtx ), 
-			   GETZ( pt_array, nx-3, j, nx, float_per_vtx ),
-			   -deltax );
-	  else gradx=
-	    deriv_centered( GETZ( pt_array, i-1, j, nx, float_per_vtx ), 
-			   GETZ( pt_array, i+1, j, nx, float_per_vtx ), 
-			   deltax );
-	  if (j==0) grady= 
-	    deriv_forwards( GETZ( pt_array, i, 0, nx, float_per_vtx ), 
-			   GETZ( pt_array, i, 1, nx, float_per_vtx ), 
-			   GETZ( pt_array, i, 2, nx, float_per_vtx ),
-			   deltay );
-	  else if (j==ny-1) grady=
-	    deriv_forwards( GETZ( pt_array, i, ny-1, nx, float_per_vtx ), 
-			   GETZ( pt_array, i, ny-2, nx, float_per_vtx ), 
-			   GETZ( pt_array, i, ny-3, nx, float_per_vtx ),
-			   -deltay );
-	  else grady=
-	    deriv_centered( GETZ( pt_array, i, j-1, nx, float_per_vtx ), 
-			   GETZ( pt_array, i, j+1, nx, float_per_vtx ),
-			   deltay );
-
-	  norm_len = ( float )
-	    sqrt( ( double ) gradx*gradx + grady*grady + 1.0 );
-
-	  *( pt_array + float_per_vtx*(i*ny + j + 1) - 3 ) = -gradx/norm_len;
-	  *( pt_array + float_per_vtx*(i*ny + j + 1) - 2 ) = -grady/norm_len;
-	  *( pt_array + float_per_vtx*(i*ny + j + 1) - 1 ) = 1.0/norm_len;
-	}
+/*
+Points which are to be left out are flagged, either from the mask or by
+calling the test function.  The test function is called from this
+thread only, since it may not be reentrant.
+*/
+    if (mask || testfun) {
+      if ( !(pass.excluded= (unsigned char *)malloc(nx*ny)) )
+	ger_fatal("p3dgen: pg_zsurface: unable to allocate %d bytes!",
+		  nx*ny);
+      if (mask) par_for( nx, min_rows, mask_rows, (P_Void_ptr)&pass );
+      else {
+	int tempi, tempj, exclude;
+	for (i=0; i<nx; i++)
+	  for (j=0; j<ny; j++) {
+	    tempi= fort ? i+1 : i;
+	    tempj= fort ? j+1 : j;
+	    (*testfun)( &exclude, pt_array+(i*ny+j)*float_per_vtx+Z, 
+		       &tempi, &tempj );
+	    pass.excluded[i*ny+j]= ( exclude != 0 );
+	  }
+      }
+    }
+
+/*
+If adaptive meshing is on, only as many triangles as are needed to
+follow the surface are generated.
+*/
+    if (za_enabled()) {
+      pg_open("");
+      zsurf_flag = za_mesh( vtxtype, pt_array, float_per_vtx, nx, ny,
+			    pass.excluded );
+      dp_close();
+      if (pass.excluded) free(pass.excluded);
+      free(pt_array);
+      return( zsurf_flag );
     }
+
 /* 
 This section creates the array that contains the vertices in each
-facet. If the pointer to the test function is non-NULL, then it checks to see 
-if any of the vertices in the facet are equal to the skipval. If so, 
-it tries to create a facet with an opposite orientation.
+facet, first finding where each row of facets starts.
 */
-    if (testfun) {            
-
-      int tempi, tempj, tempi_ny, tempj_1;
-
+    if (pass.excluded) {
+      if ( !(pass.row_start= (int *)malloc((nx-1)*sizeof(int))) )
+	ger_fatal("p3dgen: pg_zsurface: unable to allocate %d bytes!",
+		  (nx-1)*sizeof(int));
+      par_for( nx-1, min_rows, count_rows, (P_Void_ptr)&pass );
       for (i=0; i<nx-1; i++) {
-	for (j=0; j<ny-1; j++) {
-
-	  if ( fort ) {
-	    tempi = i + 1;
-	    tempi_ny= i + 2;
-	    tempj = j + 1;
-	    tempj_1= j + 2;
-	  }
-	  else {
-	    tempi = i;
-	    tempi_ny= i + 1;
-	    tempj = j;
-	    tempj_1= j + 1;
-	  }
-
-	  a_0 = j+i*ny;
-	  a_1 = j+1+i*ny;
-	  a_ny = j+(i+1)*ny;
-	  a_ny_1 = j+(i+1)*ny+1;
-	  
-	  (*testfun)( &a_0_exclude, 
-		     pt_array+a_0*float_per_vtx+Z, &tempi, &tempj );
-	  (*testfun)( &a_1_exclude, 
-		     pt_array+a_1*float_per_vtx+Z, &tempi, &tempj_1 );
-	  (*testfun)( &a_ny_exclude, 
-		     pt_array+a_ny*float_per_vtx+Z, &tempi_ny, &tempj );
-	  (*testfun)( &a_ny_1_exclude, 
-		     pt_array+a_ny_1*float_per_vtx+Z, &tempi_ny, &tempj_1);
-
-	  if (! ( a_0_exclude || a_1_exclude || a_ny_exclude ) )
-	    append_to_fac_arr( facet_array, a_0, a_ny, a_1, nfacets++ );
-	  if (! ( a_1_exclude || a_ny_exclude || a_ny_1_exclude ))
-	    append_to_fac_arr( facet_array, a_1, a_ny, a_ny_1, nfacets++ );
-	  else if ( a_1_exclude && 
-		   ( !( a_0_exclude || a_ny_exclude || a_ny_1_exclude ) ) )
-	    append_to_fac_arr( facet_array, a_0, a_ny, a_ny_1, nfacets++ );
-	  else if ( a_ny_exclude && 
-		   ( !( a_0_exclude || a_1_exclude || a_ny_1_exclude ) ) )
-	    append_to_fac_arr( facet_array, a_0, a_ny_1, a_1, nfacets++ );
-	}
-      }
-    }
-    else {
-      for (i=0; i<ny-1; i++) {
-	for (j=0; j<nx-1; j++) {
-	  a_0 = j+i*nx;
-	  a_1 = j+1+i*nx;
-	  a_ny = j+(i+1)*nx;
-	  a_ny_1 = j+(i+1)*nx+1;
-	  append_to_fac_arr(facet_array, a_0, a_ny, a_1, nfacets++);
-	  append_to_fac_arr(facet_array, a_1, a_ny, a_ny_1, nfacets++);
-	}
+	int count= pass.row_start[i];
+	pass.row_start[i]= nfacets;
+	nfacets += count;
       }
     }
+    else nfacets= 2*(nx-1)*(ny-1);
+
+    pass.facets = (int *) 
+               malloc(FACET_VTX_SZ*nfacets*sizeof(int));
+    pass.facet_lengths = (int *) 
+               malloc(nfacets*sizeof(int));
+    par_for( nx-1, min_rows, facet_rows, (P_Void_ptr)&pass );
 
     pg_open("");
     if (nfacets>0) {
       vlist = po_create_cvlist( vtxtype, nx*ny, pt_array );
-      zsurf_flag = pg_mesh( vlist, facet_array, facet_len_array, nfacets );
+      zsurf_flag = dec_mesh( vlist, pass.facets, pass.facet_lengths, 
+			     nfacets );
     }
     dp_close();
 
 /*done*/
-    free(facet_array);
+    if (pass.excluded) {
+      free(pass.excluded);
+      free(pass.row_start);
+    }
+    free(pass.facets);
     free(pt_array);
-    free(facet_len_array);
+    free(pass.facet_lengths);
     return( zsurf_flag );
   }
   else {
@@ -304,3 +462,30 @@ it tries to create a facet with an opposite orientation.
 }
 
 
+/* 
+Main pg routine.  Creates a zsurface.
+*/
+
+int pg_zsurface(int vtxtype, float *zdata, float *valdata, 
+                 int nx, int ny, P_Point *corner1, 
+                 P_Point *corner2, 
+		void (*testfun)( int *, float *, int *, int * ), int fort)
+{
+  return( zsurface( vtxtype, zdata, valdata, nx, ny, corner1, corner2,
+		    testfun, (int *)0, fort ) );
+}
+
+
+/*
+Creates a zsurface, leaving out the points for which the corresponding
+element of mask is non-zero.  mask has the same layout as zdata, and may
+be null.
+*/
+
+int pg_zsurface_masked(int vtxtype, float *zdata, float *valdata, 
+		       int nx, int ny, P_Point *corner1, 
+		       P_Point *corner2, int *mask, int fort)
+{
+  return( zsurface( vtxtype, zdata, valdata, nx, ny, corner1, corner2,
+		    0, mask, fort ) );
+}